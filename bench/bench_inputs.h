@@ -0,0 +1,92 @@
+/**
+ * @file bench_inputs.h
+ * @brief Recorded inputs for the kernel benchmarks.
+ *
+ * Probe voltages and sensor snapshots were taken from two 24-hour runs of the
+ * native simulator with sensor noise enabled (one starting in range, one with
+ * low level, TDS and pH so the automations fire). The routing set replays the
+ * command topics Home Assistant sent during those runs.
+ */
+#ifndef BENCH_INPUTS_H
+#define BENCH_INPUTS_H
+
+#include "config.h"
+#include "sensors.h"
+
+/// @brief Averaged pH probe voltages, plus one per calibration segment and two out of range.
+static const float BENCH_PH_VOLTAGES[] = {
+  2.633f, 2.630f, 2.629f, 2.625f, 2.623f, 2.620f, 2.617f, 2.614f,
+  2.610f, 2.607f, 2.607f, 2.603f, 2.601f, 2.598f, 2.593f, 2.591f,
+  2.501f, 2.454f, 2.451f, 2.448f, 2.444f, 2.443f, 2.439f, 2.435f,
+  2.433f, 2.430f, 2.425f, 2.422f, 2.419f, 2.416f, 2.413f, 2.409f,
+  3.120f, 2.980f, 1.950f, 0.050f, 3.300f,
+};
+
+/**
+ * @struct BenchTdsInput
+ * @brief A TDS probe voltage and the water temperature read in the same cycle.
+ */
+struct BenchTdsInput {
+  float voltage;
+  float waterTempC;
+};
+
+static const BenchTdsInput BENCH_TDS_INPUTS[] = {
+  {1.42f, 25.06f}, {1.39f, 24.31f}, {1.40f, 24.62f}, {1.42f, 25.62f},
+  {1.45f, 26.88f}, {1.49f, 28.19f}, {1.51f, 29.19f}, {1.52f, 29.81f},
+  {1.52f, 29.94f}, {1.50f, 29.44f}, {1.47f, 28.44f}, {1.43f, 27.12f},
+  {1.38f, 25.56f}, {1.34f, 24.06f}, {1.30f, 22.88f}, {1.28f, 22.25f},
+  {1.20f, 25.06f}, {0.46f, 24.31f}, {0.45f, 24.62f}, {0.45f, 25.62f},
+  {0.45f, 26.81f}, {0.45f, 28.06f}, {0.46f, 29.19f}, {0.45f, 29.81f},
+  {0.44f, 30.00f}, {0.43f, 29.44f}, {0.41f, 28.25f}, {0.40f, 27.06f},
+  {0.37f, 25.50f}, {0.36f, 24.06f}, {0.34f, 22.81f}, {0.32f, 22.38f},
+};
+
+/// @brief Sensor snapshots as published; the last one has the DHT22 disconnected.
+static const SensorValues BENCH_SENSOR_SNAPSHOTS[] = {
+  {59.0f, 41.0f, 25.06f, 24.60f, 84.20f, 899.6f, 220.5f, 0.021f, 2.7f, 0.000f, 50.0f, 0.55f, 6.21f},
+  {60.0f, 40.0f, 24.62f, 27.90f, 74.40f, 897.7f, 218.8f, 0.021f, 2.6f, 0.007f, 50.0f, 0.55f, 6.23f},
+  {59.0f, 41.0f, 26.88f, 31.60f, 66.00f, 887.4f, 219.6f, 0.021f, 2.4f, 0.015f, 50.0f, 0.55f, 6.26f},
+  {59.0f, 41.0f, 29.19f, 32.90f, 62.50f, 882.6f, 219.8f, 0.021f, 2.6f, 0.023f, 50.0f, 0.55f, 6.29f},
+  {59.0f, 41.0f, 29.94f, 31.60f, 65.90f, 878.5f, 219.5f, 0.019f, 2.5f, 0.030f, 50.0f, 0.55f, 6.33f},
+  {58.0f, 42.0f, 28.44f, 28.10f, 74.50f, 872.0f, 220.9f, 0.021f, 2.4f, 0.038f, 50.0f, 0.55f, 6.34f},
+  {58.0f, 42.0f, 25.56f, 24.40f, 83.90f, 868.4f, 218.6f, 0.021f, 2.5f, 0.045f, 50.0f, 0.55f, 6.38f},
+  {57.0f, 43.0f, 22.88f, 23.00f, 88.00f, 864.2f, 218.8f, 0.020f, 2.5f, 0.053f, 50.0f, 0.55f, 6.42f},
+  {21.0f, 79.0f, 25.06f, 24.60f, 84.20f, 759.9f, 220.5f, 0.021f, 2.7f, 0.000f, 50.0f, 0.55f, 6.91f},
+  {81.0f, 19.0f, 24.62f, 28.00f, 74.70f, 286.8f, 221.0f, 0.021f, 2.4f, 0.009f, 50.0f, 0.55f, 7.14f},
+  {80.0f, 20.0f, 26.81f, 31.60f, 66.40f, 277.2f, 220.3f, 0.021f, 2.5f, 0.016f, 50.0f, 0.55f, 7.17f},
+  {80.0f, 20.0f, 29.19f, 33.20f, 62.70f, 266.9f, 219.9f, 0.021f, 2.7f, 0.024f, 50.0f, 0.55f, 7.20f},
+  {79.0f, 21.0f, 30.00f, 31.40f, 65.90f, 256.0f, 220.4f, 0.019f, 2.5f, 0.032f, 50.0f, 0.55f, 7.23f},
+  {79.0f, 21.0f, 28.25f, 27.90f, 75.50f, 246.6f, 219.7f, 0.021f, 2.5f, 0.039f, 50.0f, 0.55f, 7.27f},
+  {79.0f, 21.0f, 25.50f, 24.50f, 83.20f, 235.2f, 219.9f, 0.019f, 2.3f, 0.047f, 50.0f, 0.55f, 7.29f},
+  {77.0f, 23.0f, 22.81f, 23.00f, 88.40f, 226.0f, 219.7f, 0.021f, 2.3f, 0.054f, 50.0f, 0.55f, 7.33f},
+  {61.0f, 39.0f, 24.81f, NAN, NAN, 902.4f, 221.3f, 0.019f, 2.5f, 0.041f, 50.0f, 0.56f, 6.18f},
+};
+
+/**
+ * @struct BenchCommand
+ * @brief One routed MQTT command.
+ */
+struct BenchCommand {
+  const MqttTopic* topic; ///< Refers to the global in config.cpp.
+  const char* payload;
+};
+
+/**
+ * @brief The recorded command mix, each job followed by the command that
+ * cancels it so every pass leaves the queue as it found it.
+ * Nothing here switches a relay: jobs are only queued, and the refill valve
+ * is only ever told OFF.
+ */
+static const BenchCommand BENCH_COMMANDS[] = {
+  {&COMMAND_TOPIC_PUMP_SIRAM, "15"},
+  {&COMMAND_TOPIC_PUMP_SIRAM, "OFF"},
+  {&COMMAND_TOPIC_PUMP_QUEUE, "nutrisi_a:20:60,nutrisi_b:20"},
+  {&COMMAND_TOPIC_PUMP_QUEUE, "CANCEL"},
+  {&COMMAND_TOPIC_PUMP_PH, "10"},
+  {&COMMAND_TOPIC_PUMP_PH, "OFF"},
+  {&COMMAND_TOPIC_PUMP_TANDON, "OFF"},
+  {&COMMAND_TOPIC_SYSTEM_MODE, "NUTRITION"},
+};
+
+#endif // BENCH_INPUTS_H
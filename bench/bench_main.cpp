@@ -0,0 +1,342 @@
+/**
+ * @file bench_main.cpp
+ * @brief Microbenchmarks for the computations the firmware runs every cycle.
+ *
+ * Each kernel is the firmware's own function, fed with the recorded inputs in
+ * bench_inputs.h:
+ *   - `ph_from_voltage`      pH segment interpolation (`sensors_ph_from_voltage()`)
+ *   - `tds_from_voltage`     TDS temperature compensation (`sensors_tds_from_voltage()`)
+ *   - `format_fixed`         one published value (`number_format_fixed()`)
+ *   - `format_snprintf`      the same value through `snprintf("%.<n>f")`, for reference
+ *   - `publish_sensor_data`  float formatting of one full sensor publish; the
+ *                            client is not connected, so nothing is sent
+ *   - `route_command`        topic matching and command parsing (`mqtt_route_command()`)
+ *   - `alert_status`         water level alert evaluation (`actuators_update_alert_status()`)
+ *   - `history_encode`       appending one record of the trace in bench_trace.h
+ *                            to a history block (`history_codec_encode()`)
+ *   - `history_decode`       reading one record back (`history_codec_decode()`)
+ *
+ * Build and run on the host with `pio run -e bench_native && .pio/build/bench_native/program`,
+ * or on a board with `pio run -e bench_esp32 -t upload -t monitor`. The board
+ * needs no sensors and connects to nothing; no relay is switched.
+ *
+ * Results are printed as one JSON object per line: a header with the platform,
+ * then one line per kernel. The time per operation is the median over several
+ * timed rounds. On the ESP32 the CPU cycle counter is read as well. A `codec`
+ * line reports the history trace's compression ratio and whether it decoded
+ * back bit for bit. Compare two result files with `bench/compare_results.py`.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "sensors.h"
+#include "actuators.h"
+#include "mqtt_handler.h"
+#include "storage.h"
+#include "identity.h"
+#include "number_format.h"
+#include "history_codec.h"
+#include "bench_inputs.h"
+#include "bench_trace.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_timer.h>
+#else
+#include <chrono>
+#include "sim_board.h"
+#endif
+
+// --- Module-Private (Static) Constants & Variables ---
+
+/// @brief Bumped whenever a kernel or its inputs change, so old results are not compared.
+static const int BENCH_SUITE_VERSION = 2;
+/// @brief Timed rounds per kernel; the median is reported.
+static const int BENCH_ROUNDS = 15;
+/// @brief Minimum duration of one timed round.
+static const uint32_t BENCH_ROUND_TARGET_US = 20000;
+
+#define BENCH_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+/// @brief Results are written here so the compiler cannot drop the work.
+static volatile float benchSink;
+static volatile char benchTextSink;
+
+/**
+ * @struct BenchNumber
+ * @brief One value of a sensor publish with the decimals it is published with.
+ */
+struct BenchNumber {
+  float value;
+  uint8_t decimals;
+};
+
+/// @brief Every value of the sensor snapshots, in publish order.
+static BenchNumber benchNumbers[BENCH_COUNT(BENCH_SENSOR_SNAPSHOTS) * 13];
+static size_t benchNumberCount = 0;
+
+/// @brief The whole trace as one block; real blocks are a sector, but the codec's cost does not depend on that.
+static uint8_t benchHistoryBlock[BENCH_COUNT(BENCH_HISTORY_TRACE) * (4 + 4 * SENSOR_NUM_FIELDS)];
+static size_t benchHistorySize = 0;
+static HistoryEncoder benchEncoder;
+static HistoryDecoder benchDecoder;
+
+/**
+ * @typedef BenchKernel
+ * @brief Runs a kernel once on the input with the given index.
+ */
+typedef void (*BenchKernel)(size_t index);
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void run_all_benchmarks();
+static void run_benchmark(const char* name, BenchKernel kernel, size_t numInputs);
+static uint64_t bench_now_ns();
+static uint32_t bench_now_cycles();
+static void sort_values(double* values, int count);
+static void collect_published_numbers();
+static void report_history_compression();
+
+// --- Kernels ---
+
+static void kernel_ph_from_voltage(size_t index) {
+  benchSink = sensors_ph_from_voltage(BENCH_PH_VOLTAGES[index]);
+}
+
+static void kernel_tds_from_voltage(size_t index) {
+  const BenchTdsInput& input = BENCH_TDS_INPUTS[index];
+  benchSink = sensors_tds_from_voltage(input.voltage, input.waterTempC);
+}
+
+static void kernel_format_fixed(size_t index) {
+  char text[16];
+  number_format_fixed(text, sizeof(text), benchNumbers[index].value, benchNumbers[index].decimals);
+  benchTextSink = text[0];
+}
+
+static void kernel_format_snprintf(size_t index) {
+  char text[16];
+  snprintf(text, sizeof(text), "%.*f", benchNumbers[index].decimals, benchNumbers[index].value);
+  benchTextSink = text[0];
+}
+
+static void kernel_publish_sensor_data(size_t index) {
+  mqtt_publish_sensor_data(BENCH_SENSOR_SNAPSHOTS[index]);
+}
+
+static void kernel_route_command(size_t index) {
+  mqtt_route_command(BENCH_COMMANDS[index].topic->c_str(), BENCH_COMMANDS[index].payload);
+}
+
+static void kernel_alert_status(size_t index) {
+  actuators_update_alert_status(BENCH_SENSOR_SNAPSHOTS[index]);
+}
+
+static void kernel_history_encode(size_t index) {
+  if (index == 0) history_codec_encoder_init(benchEncoder, benchHistoryBlock, sizeof(benchHistoryBlock), SENSOR_NUM_FIELDS);
+  history_codec_encode(benchEncoder, BENCH_HISTORY_TRACE[index].time, BENCH_HISTORY_TRACE[index].values);
+}
+
+static void kernel_history_decode(size_t index) {
+  if (index == 0) {
+    history_codec_decoder_init(benchDecoder, benchHistoryBlock, benchHistorySize, BENCH_COUNT(BENCH_HISTORY_TRACE),
+                               SENSOR_NUM_FIELDS);
+  }
+  uint32_t time;
+  float values[SENSOR_NUM_FIELDS];
+  history_codec_decode(benchDecoder, time, values);
+  benchSink = values[0];
+}
+
+// --- Entry Points ---
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000); // Give the serial monitor time to attach.
+  run_all_benchmarks();
+}
+
+void loop() {
+  delay(1000);
+}
+
+#else
+
+int main() {
+  sim_board_set_serial_echo(true); // Results go to stdout.
+  run_all_benchmarks();
+  return 0;
+}
+
+#endif
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Prepares the modules the kernels use and runs every benchmark.
+ */
+static void run_all_benchmarks() {
+  // Nothing drains the log buffer here; switch logging off so the kernels time their own work.
+  logger_handle_command("NONE");
+  identity_init(); // The routing kernel matches the resolved command topics.
+  // The routing kernel reaches the actuators, which restore their state from NVS.
+  storage_init();
+  actuators_init();
+  collect_published_numbers();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  Serial.printf("{\"suite\":\"hidroiot\",\"version\":%d,\"platform\":\"esp32\",\"cpu_mhz\":%u}\n",
+                BENCH_SUITE_VERSION, (unsigned)ESP.getCpuFreqMHz());
+#else
+  Serial.printf("{\"suite\":\"hidroiot\",\"version\":%d,\"platform\":\"native\"}\n", BENCH_SUITE_VERSION);
+#endif
+
+  run_benchmark("ph_from_voltage", kernel_ph_from_voltage, BENCH_COUNT(BENCH_PH_VOLTAGES));
+  run_benchmark("tds_from_voltage", kernel_tds_from_voltage, BENCH_COUNT(BENCH_TDS_INPUTS));
+  run_benchmark("format_fixed", kernel_format_fixed, benchNumberCount);
+  run_benchmark("format_snprintf", kernel_format_snprintf, benchNumberCount);
+  run_benchmark("publish_sensor_data", kernel_publish_sensor_data, BENCH_COUNT(BENCH_SENSOR_SNAPSHOTS));
+  run_benchmark("route_command", kernel_route_command, BENCH_COUNT(BENCH_COMMANDS));
+  run_benchmark("alert_status", kernel_alert_status, BENCH_COUNT(BENCH_SENSOR_SNAPSHOTS));
+  run_benchmark("history_encode", kernel_history_encode, BENCH_COUNT(BENCH_HISTORY_TRACE));
+  report_history_compression(); // Also leaves the encoded trace for the decode kernel.
+  run_benchmark("history_decode", kernel_history_decode, BENCH_COUNT(BENCH_HISTORY_TRACE));
+}
+
+/**
+ * @brief Times one kernel over all its inputs and prints the result line.
+ * The number of passes per round is doubled until a round lasts at least
+ * BENCH_ROUND_TARGET_US, which keeps timer resolution out of the result.
+ * @param name The kernel name used in the results.
+ * @param kernel The kernel.
+ * @param numInputs The number of recorded inputs.
+ */
+static void run_benchmark(const char* name, BenchKernel kernel, size_t numInputs) {
+  // Warm up caches and any lazily initialized state.
+  for (size_t i = 0; i < numInputs; i++) kernel(i);
+
+  uint32_t passes = 1;
+  for (;;) {
+    uint64_t start = bench_now_ns();
+    for (uint32_t p = 0; p < passes; p++) {
+      for (size_t i = 0; i < numInputs; i++) kernel(i);
+    }
+    if (bench_now_ns() - start >= (uint64_t)BENCH_ROUND_TARGET_US * 1000 || passes >= (1UL << 24)) break;
+    passes *= 2;
+  }
+
+  double nsPerOp[BENCH_ROUNDS];
+  double cyclesPerOp[BENCH_ROUNDS];
+  const double opsPerRound = (double)passes * numInputs;
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    uint32_t startCycles = bench_now_cycles();
+    uint64_t start = bench_now_ns();
+    for (uint32_t p = 0; p < passes; p++) {
+      for (size_t i = 0; i < numInputs; i++) kernel(i);
+    }
+    uint64_t elapsedNs = bench_now_ns() - start;
+    // Unsigned subtraction handles the 32-bit counter wrapping once; a round is far shorter than a wrap.
+    uint32_t elapsedCycles = bench_now_cycles() - startCycles;
+    nsPerOp[r] = elapsedNs / opsPerRound;
+    cyclesPerOp[r] = elapsedCycles / opsPerRound;
+    delay(1); // Let the idle task run between rounds.
+  }
+  sort_values(nsPerOp, BENCH_ROUNDS);
+  sort_values(cyclesPerOp, BENCH_ROUNDS);
+
+  Serial.printf("{\"bench\":\"%s\",\"inputs\":%u,\"ops_per_round\":%.0f,\"rounds\":%d,"
+                "\"ns_per_op\":%.1f,\"ns_per_op_min\":%.1f",
+                name, (unsigned)numInputs, opsPerRound, BENCH_ROUNDS,
+                nsPerOp[BENCH_ROUNDS / 2], nsPerOp[0]);
+#if defined(ARDUINO_ARCH_ESP32)
+  Serial.printf(",\"cycles_per_op\":%.1f", cyclesPerOp[BENCH_ROUNDS / 2]);
+#endif
+  Serial.printf("}\n");
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static uint64_t bench_now_ns() {
+  return (uint64_t)esp_timer_get_time() * 1000;
+}
+
+static uint32_t bench_now_cycles() {
+  return ESP.getCycleCount();
+}
+
+#else
+
+static uint64_t bench_now_ns() {
+  // The simulator's millis() is virtual time; benchmarks need the real clock.
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t bench_now_cycles() {
+  return 0;
+}
+
+#endif
+
+/**
+ * @brief Flattens the sensor snapshots into the values `mqtt_publish_sensor_data()` formats.
+ */
+static void collect_published_numbers() {
+  for (size_t i = 0; i < BENCH_COUNT(BENCH_SENSOR_SNAPSHOTS); i++) {
+    const SensorValues& v = BENCH_SENSOR_SNAPSHOTS[i];
+    const BenchNumber numbers[] = {
+      {v.waterLevelCm, 1}, {v.waterDistanceCm, 0}, {v.waterTempC, 2}, {v.airTempC, 2},
+      {v.airHumidityPercent, 2}, {v.tdsPpm, 1}, {v.phValue, 2}, {v.pzemVoltage, 1},
+      {v.pzemCurrent, 3}, {v.pzemPower, 1}, {v.pzemEnergy, 3}, {v.pzemFrequency, 1},
+      {v.pzemPowerFactor, 2},
+    };
+    for (size_t n = 0; n < BENCH_COUNT(numbers); n++) {
+      if (!isnan(numbers[n].value)) benchNumbers[benchNumberCount++] = numbers[n];
+    }
+  }
+}
+
+/**
+ * @brief Encodes the whole trace, decodes it again and prints the size and round-trip result.
+ */
+static void report_history_compression() {
+  const size_t count = BENCH_COUNT(BENCH_HISTORY_TRACE);
+  history_codec_encoder_init(benchEncoder, benchHistoryBlock, sizeof(benchHistoryBlock), SENSOR_NUM_FIELDS);
+  for (size_t i = 0; i < count; i++) {
+    history_codec_encode(benchEncoder, BENCH_HISTORY_TRACE[i].time, BENCH_HISTORY_TRACE[i].values);
+  }
+  benchHistorySize = history_codec_encoded_size(benchEncoder);
+
+  // Compared bit for bit, so NAN fields count as well.
+  bool identical = benchEncoder.count == count;
+  history_codec_decoder_init(benchDecoder, benchHistoryBlock, benchHistorySize, count, SENSOR_NUM_FIELDS);
+  for (size_t i = 0; i < count && identical; i++) {
+    uint32_t time;
+    float values[SENSOR_NUM_FIELDS];
+    identical = history_codec_decode(benchDecoder, time, values) && time == BENCH_HISTORY_TRACE[i].time &&
+                memcmp(values, BENCH_HISTORY_TRACE[i].values, sizeof(values)) == 0;
+  }
+
+  const size_t rawBytes = count * sizeof(BenchTraceRecord);
+  Serial.printf("{\"codec\":\"history\",\"records\":%u,\"raw_bytes\":%u,\"encoded_bytes\":%u,"
+                "\"bytes_per_record\":%.2f,\"ratio\":%.2f,\"roundtrip\":\"%s\"}\n",
+                (unsigned)count, (unsigned)rawBytes, (unsigned)benchHistorySize, (double)benchHistorySize / count,
+                (double)rawBytes / benchHistorySize, identical ? "ok" : "mismatch");
+}
+
+/**
+ * @brief Sorts a small array in place (insertion sort).
+ * @param values The values.
+ * @param count The number of values.
+ */
+static void sort_values(double* values, int count) {
+  for (int i = 1; i < count; i++) {
+    double value = values[i];
+    int j = i - 1;
+    while (j >= 0 && values[j] > value) {
+      values[j + 1] = values[j];
+      j--;
+    }
+    values[j + 1] = value;
+  }
+}
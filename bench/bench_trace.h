@@ -0,0 +1,388 @@
+/**
+ * @file bench_trace.h
+ * @brief A recorded sensor history trace for the history codec benchmarks.
+ *
+ * Six hours of the records the firmware appends to its history, one per
+ * minute, as answered to a history query in a native simulator run with the
+ * Home Assistant stand-in (`--hours 6.1 --ha`). Values carry the decimals they
+ * are stored with; fields are in `SENSOR_FIELDS` order.
+ */
+#ifndef BENCH_TRACE_H
+#define BENCH_TRACE_H
+
+#include "sensors.h"
+
+/**
+ * @struct BenchTraceRecord
+ * @brief One history record: Unix seconds and the sensor fields.
+ */
+struct BenchTraceRecord {
+  uint32_t time;
+  float values[SENSOR_NUM_FIELDS];
+};
+
+static const BenchTraceRecord BENCH_HISTORY_TRACE[] = {
+  {1767247200, {59.0f, 41.0f, 25.06f, 24.60f, 84.30f, 899.6f, 220.5f, 0.021f, 2.7f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767247260, {59.0f, 41.0f, 25.06f, 24.50f, 84.10f, 897.0f, 219.6f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247320, {60.0f, 40.0f, 25.00f, 24.40f, 83.50f, 898.1f, 220.4f, 0.021f, 2.8f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247380, {60.0f, 40.0f, 24.94f, 24.40f, 83.40f, 901.3f, 219.1f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247440, {61.0f, 39.0f, 25.06f, 24.60f, 83.60f, 899.6f, 220.8f, 0.021f, 2.7f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767247500, {60.0f, 40.0f, 25.06f, 24.70f, 83.80f, 898.0f, 221.3f, 0.021f, 2.3f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247560, {60.0f, 40.0f, 24.94f, 24.40f, 83.60f, 898.2f, 220.3f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767247625, {60.0f, 40.0f, 24.81f, 24.50f, 83.30f, 901.0f, 221.0f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247685, {60.0f, 40.0f, 24.81f, 24.50f, 83.00f, 897.9f, 219.5f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247745, {60.0f, 40.0f, 24.88f, 24.70f, 83.40f, 900.9f, 220.8f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767247805, {60.0f, 40.0f, 24.81f, 24.60f, 82.80f, 900.0f, 220.5f, 0.021f, 2.7f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247865, {60.0f, 40.0f, 24.88f, 24.60f, 83.80f, 897.8f, 220.2f, 0.019f, 2.5f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247925, {60.0f, 40.0f, 24.88f, 24.70f, 83.20f, 897.8f, 220.6f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767247985, {59.0f, 41.0f, 24.88f, 24.60f, 83.50f, 898.8f, 220.2f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767248045, {60.0f, 40.0f, 24.88f, 24.60f, 83.60f, 896.3f, 221.8f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767248105, {60.0f, 40.0f, 24.81f, 24.60f, 83.00f, 902.0f, 220.5f, 0.021f, 2.4f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248165, {60.0f, 40.0f, 24.75f, 24.80f, 83.10f, 901.6f, 219.5f, 0.021f, 2.4f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248225, {60.0f, 40.0f, 24.75f, 24.80f, 83.20f, 901.6f, 219.4f, 0.020f, 2.5f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248285, {60.0f, 40.0f, 24.75f, 24.80f, 83.60f, 899.0f, 219.5f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248345, {60.0f, 40.0f, 24.75f, 24.80f, 83.40f, 899.0f, 220.1f, 0.021f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767248405, {60.0f, 40.0f, 24.75f, 25.00f, 82.60f, 902.1f, 220.4f, 0.022f, 2.6f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767248465, {60.0f, 40.0f, 24.69f, 24.90f, 82.80f, 900.7f, 220.1f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.20f}},
+  {1767248525, {60.0f, 40.0f, 24.75f, 24.80f, 83.40f, 897.5f, 221.9f, 0.021f, 2.3f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248585, {60.0f, 40.0f, 24.69f, 24.80f, 82.40f, 899.7f, 218.2f, 0.021f, 2.5f, 0.000f, 50.0f, 0.55f, 6.21f}},
+  {1767248645, {60.0f, 40.0f, 24.75f, 25.00f, 82.90f, 899.0f, 220.9f, 0.021f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767248705, {60.0f, 40.0f, 24.75f, 24.80f, 81.90f, 898.0f, 219.8f, 0.020f, 2.4f, 0.001f, 50.0f, 0.55f, 6.20f}},
+  {1767248765, {60.0f, 40.0f, 24.69f, 25.00f, 82.90f, 901.2f, 221.3f, 0.021f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767248825, {60.0f, 40.0f, 24.69f, 24.90f, 83.60f, 899.7f, 219.1f, 0.021f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767248885, {60.0f, 40.0f, 24.63f, 24.80f, 82.60f, 897.2f, 219.7f, 0.020f, 2.6f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767248945, {60.0f, 40.0f, 24.56f, 25.10f, 84.00f, 899.3f, 219.4f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249005, {60.0f, 40.0f, 24.63f, 25.00f, 83.30f, 898.7f, 220.8f, 0.019f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249065, {60.0f, 40.0f, 24.69f, 25.10f, 82.50f, 899.7f, 220.1f, 0.021f, 2.6f, 0.001f, 50.0f, 0.55f, 6.20f}},
+  {1767249125, {60.0f, 40.0f, 24.56f, 25.30f, 82.60f, 901.4f, 220.3f, 0.020f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249185, {60.0f, 40.0f, 24.56f, 24.90f, 82.40f, 899.9f, 220.1f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.20f}},
+  {1767249245, {60.0f, 40.0f, 24.63f, 25.20f, 81.90f, 899.8f, 218.9f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.20f}},
+  {1767249305, {59.0f, 41.0f, 24.50f, 25.10f, 83.00f, 901.0f, 221.0f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249365, {60.0f, 40.0f, 24.63f, 24.90f, 82.40f, 898.7f, 219.7f, 0.021f, 2.6f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249425, {60.0f, 40.0f, 24.50f, 24.90f, 83.00f, 898.4f, 219.1f, 0.020f, 2.6f, 0.001f, 50.0f, 0.55f, 6.20f}},
+  {1767249485, {60.0f, 40.0f, 24.63f, 25.20f, 81.80f, 899.2f, 220.6f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249545, {60.0f, 40.0f, 24.56f, 25.20f, 81.20f, 898.3f, 219.7f, 0.021f, 2.6f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249605, {60.0f, 40.0f, 24.56f, 25.10f, 82.50f, 897.8f, 219.0f, 0.020f, 2.7f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249665, {60.0f, 40.0f, 24.50f, 25.20f, 83.00f, 899.4f, 221.0f, 0.021f, 2.4f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249725, {60.0f, 40.0f, 24.63f, 25.20f, 82.80f, 895.1f, 220.8f, 0.021f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249785, {60.0f, 40.0f, 24.56f, 25.20f, 81.80f, 896.8f, 220.5f, 0.020f, 2.4f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249845, {60.0f, 40.0f, 24.50f, 25.10f, 82.20f, 898.4f, 219.4f, 0.019f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249905, {60.0f, 40.0f, 24.56f, 25.20f, 82.10f, 896.8f, 220.2f, 0.021f, 2.3f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767249965, {60.0f, 40.0f, 24.44f, 25.50f, 82.10f, 902.1f, 220.0f, 0.022f, 2.5f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767250025, {59.0f, 41.0f, 24.50f, 25.30f, 81.90f, 898.4f, 219.3f, 0.021f, 2.6f, 0.001f, 50.0f, 0.55f, 6.21f}},
+  {1767250090, {60.0f, 40.0f, 24.50f, 25.50f, 81.20f, 898.9f, 219.2f, 0.022f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250150, {60.0f, 40.0f, 24.44f, 25.30f, 82.80f, 903.7f, 219.6f, 0.019f, 2.4f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250210, {60.0f, 40.0f, 24.38f, 25.30f, 81.80f, 903.3f, 219.2f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250270, {60.0f, 40.0f, 24.50f, 25.40f, 82.20f, 897.9f, 221.3f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250330, {60.0f, 40.0f, 24.44f, 25.30f, 81.10f, 899.5f, 219.9f, 0.020f, 2.4f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250390, {60.0f, 40.0f, 24.44f, 25.40f, 81.50f, 900.6f, 220.5f, 0.021f, 2.7f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250450, {60.0f, 40.0f, 24.44f, 25.50f, 81.70f, 898.0f, 219.2f, 0.021f, 2.5f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250510, {60.0f, 40.0f, 24.38f, 25.40f, 80.30f, 899.6f, 219.4f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.22f}},
+  {1767250570, {60.0f, 40.0f, 24.50f, 25.50f, 80.90f, 896.9f, 218.9f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250630, {60.0f, 40.0f, 24.50f, 25.40f, 80.40f, 897.9f, 220.7f, 0.020f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250690, {60.0f, 40.0f, 24.44f, 25.60f, 81.00f, 902.1f, 220.4f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250750, {59.0f, 41.0f, 24.44f, 25.50f, 80.70f, 899.5f, 222.0f, 0.021f, 2.4f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250810, {58.0f, 42.0f, 24.44f, 25.50f, 81.20f, 895.9f, 220.7f, 0.147f, 17.5f, 0.002f, 50.0f, 0.55f, 6.22f}},
+  {1767250870, {59.0f, 41.0f, 24.44f, 25.60f, 81.30f, 896.4f, 221.1f, 0.021f, 2.5f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250930, {60.0f, 40.0f, 24.50f, 25.70f, 81.40f, 895.3f, 219.6f, 0.020f, 2.5f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767250990, {60.0f, 40.0f, 24.38f, 25.50f, 80.60f, 897.6f, 220.5f, 0.022f, 2.5f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767251050, {60.0f, 40.0f, 24.44f, 25.70f, 80.30f, 900.1f, 220.3f, 0.021f, 2.4f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767251110, {60.0f, 40.0f, 24.38f, 25.70f, 80.90f, 899.6f, 220.0f, 0.021f, 2.4f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767251170, {60.0f, 40.0f, 24.31f, 25.60f, 81.50f, 901.3f, 218.2f, 0.021f, 2.6f, 0.002f, 50.0f, 0.55f, 6.22f}},
+  {1767251230, {60.0f, 40.0f, 24.31f, 25.70f, 81.40f, 899.7f, 221.1f, 0.021f, 2.3f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767251290, {60.0f, 40.0f, 24.44f, 25.50f, 80.90f, 899.0f, 219.9f, 0.020f, 2.7f, 0.002f, 50.0f, 0.55f, 6.22f}},
+  {1767251355, {60.0f, 40.0f, 24.50f, 25.70f, 80.90f, 894.8f, 219.1f, 0.021f, 2.5f, 0.002f, 50.0f, 0.55f, 6.22f}},
+  {1767251415, {60.0f, 40.0f, 24.31f, 25.70f, 80.90f, 896.6f, 219.6f, 0.020f, 2.5f, 0.002f, 50.0f, 0.55f, 6.21f}},
+  {1767251475, {60.0f, 40.0f, 24.38f, 25.80f, 80.40f, 897.6f, 219.3f, 0.020f, 2.5f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767251535, {59.0f, 41.0f, 24.38f, 25.60f, 81.00f, 900.2f, 220.7f, 0.020f, 2.6f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767251595, {60.0f, 40.0f, 24.31f, 25.70f, 80.30f, 897.1f, 220.6f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767251655, {60.0f, 40.0f, 24.31f, 25.80f, 81.40f, 901.3f, 219.5f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767251715, {60.0f, 40.0f, 24.44f, 25.70f, 81.20f, 895.9f, 220.4f, 0.021f, 2.4f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767251775, {60.0f, 40.0f, 24.44f, 25.90f, 80.30f, 898.0f, 219.9f, 0.021f, 2.4f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767251835, {59.0f, 41.0f, 24.38f, 26.00f, 81.30f, 895.5f, 219.8f, 0.020f, 2.5f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767251895, {60.0f, 40.0f, 24.38f, 25.80f, 79.10f, 897.0f, 218.5f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767251955, {60.0f, 40.0f, 24.44f, 25.90f, 80.50f, 898.0f, 219.5f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252015, {60.0f, 40.0f, 24.31f, 25.80f, 80.50f, 898.2f, 220.6f, 0.022f, 2.6f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252075, {60.0f, 40.0f, 24.38f, 25.80f, 80.70f, 899.6f, 219.2f, 0.020f, 2.3f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252135, {60.0f, 40.0f, 24.38f, 26.00f, 80.10f, 896.0f, 219.6f, 0.021f, 2.6f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252200, {60.0f, 40.0f, 24.31f, 25.80f, 80.80f, 897.1f, 220.6f, 0.020f, 2.7f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252260, {60.0f, 40.0f, 24.31f, 26.00f, 80.40f, 896.1f, 220.8f, 0.020f, 2.5f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252320, {60.0f, 40.0f, 24.38f, 26.10f, 81.10f, 895.5f, 220.0f, 0.020f, 2.3f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252380, {60.0f, 40.0f, 24.44f, 26.00f, 80.10f, 896.4f, 221.4f, 0.021f, 2.7f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252440, {60.0f, 40.0f, 24.38f, 26.00f, 80.40f, 897.6f, 219.9f, 0.021f, 2.6f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252500, {60.0f, 40.0f, 24.31f, 26.00f, 80.10f, 900.8f, 218.9f, 0.021f, 2.4f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252560, {60.0f, 40.0f, 24.31f, 26.00f, 80.60f, 896.6f, 220.4f, 0.022f, 2.4f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252620, {60.0f, 40.0f, 24.25f, 25.90f, 80.50f, 900.9f, 220.7f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252680, {60.0f, 40.0f, 24.31f, 26.00f, 79.60f, 897.1f, 220.4f, 0.020f, 2.4f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252740, {60.0f, 40.0f, 24.25f, 26.10f, 79.40f, 900.4f, 219.0f, 0.021f, 2.6f, 0.003f, 50.0f, 0.55f, 6.21f}},
+  {1767252800, {60.0f, 40.0f, 24.38f, 26.10f, 79.10f, 897.6f, 220.5f, 0.021f, 2.3f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252860, {60.0f, 40.0f, 24.31f, 26.10f, 80.20f, 899.2f, 220.8f, 0.021f, 2.5f, 0.003f, 50.0f, 0.55f, 6.22f}},
+  {1767252920, {59.0f, 41.0f, 24.38f, 26.20f, 79.60f, 895.5f, 219.5f, 0.019f, 2.6f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767252980, {60.0f, 40.0f, 24.31f, 26.20f, 79.10f, 897.1f, 220.2f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253040, {59.0f, 41.0f, 24.38f, 26.30f, 78.80f, 898.6f, 220.2f, 0.020f, 2.4f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253100, {60.0f, 40.0f, 24.38f, 26.20f, 80.40f, 896.5f, 220.7f, 0.020f, 2.6f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767253160, {60.0f, 40.0f, 24.25f, 26.30f, 79.70f, 898.8f, 220.0f, 0.022f, 2.4f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253220, {60.0f, 40.0f, 24.31f, 26.40f, 78.50f, 898.2f, 219.8f, 0.021f, 2.6f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253280, {60.0f, 40.0f, 24.25f, 26.30f, 78.80f, 896.7f, 219.6f, 0.020f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253340, {60.0f, 40.0f, 24.31f, 26.30f, 80.20f, 901.3f, 220.3f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253400, {59.0f, 41.0f, 24.44f, 26.20f, 79.30f, 894.4f, 219.7f, 0.021f, 2.6f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253460, {60.0f, 40.0f, 24.31f, 26.40f, 78.60f, 897.1f, 219.0f, 0.021f, 2.6f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767253520, {60.0f, 40.0f, 24.31f, 26.40f, 79.20f, 897.1f, 219.8f, 0.021f, 2.6f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767253580, {60.0f, 40.0f, 24.38f, 26.40f, 78.60f, 893.9f, 220.1f, 0.019f, 2.5f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767253640, {59.0f, 41.0f, 24.31f, 26.40f, 79.20f, 898.2f, 219.1f, 0.021f, 2.4f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253700, {60.0f, 40.0f, 24.38f, 26.40f, 78.30f, 893.4f, 219.2f, 0.020f, 2.6f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253760, {60.0f, 40.0f, 24.31f, 26.50f, 78.70f, 899.7f, 219.7f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253820, {60.0f, 40.0f, 24.31f, 26.60f, 78.80f, 898.2f, 220.1f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767253880, {60.0f, 40.0f, 24.31f, 26.50f, 78.10f, 897.7f, 220.9f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767253940, {59.0f, 41.0f, 24.25f, 26.50f, 78.70f, 896.2f, 219.7f, 0.018f, 2.5f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767254000, {60.0f, 40.0f, 24.38f, 26.30f, 78.90f, 892.9f, 221.4f, 0.021f, 2.6f, 0.004f, 50.0f, 0.55f, 6.23f}},
+  {1767254060, {59.0f, 41.0f, 24.31f, 26.50f, 78.70f, 896.6f, 218.9f, 0.021f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767254120, {59.0f, 41.0f, 24.31f, 26.60f, 78.50f, 896.1f, 220.3f, 0.020f, 2.5f, 0.004f, 50.0f, 0.55f, 6.21f}},
+  {1767254180, {60.0f, 40.0f, 24.44f, 26.60f, 79.40f, 891.8f, 220.1f, 0.022f, 2.6f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767254240, {59.0f, 41.0f, 24.31f, 26.50f, 79.60f, 895.6f, 220.4f, 0.020f, 2.5f, 0.004f, 50.0f, 0.55f, 6.22f}},
+  {1767254300, {59.0f, 41.0f, 24.38f, 26.70f, 78.00f, 895.5f, 219.5f, 0.020f, 2.4f, 0.004f, 50.0f, 0.55f, 6.23f}},
+  {1767254360, {60.0f, 40.0f, 24.31f, 26.90f, 78.30f, 896.6f, 219.7f, 0.018f, 2.4f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767254420, {56.0f, 44.0f, 24.25f, 26.70f, 77.70f, 899.3f, 219.5f, 0.020f, 2.6f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767254480, {59.0f, 41.0f, 24.31f, 26.90f, 77.70f, 898.2f, 220.7f, 0.021f, 2.6f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254540, {60.0f, 40.0f, 24.50f, 26.80f, 78.30f, 893.7f, 219.7f, 0.021f, 2.5f, 0.005f, 50.0f, 0.55f, 6.21f}},
+  {1767254600, {60.0f, 40.0f, 24.31f, 26.90f, 78.00f, 896.1f, 219.6f, 0.020f, 2.4f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254660, {60.0f, 40.0f, 24.38f, 26.70f, 77.90f, 896.0f, 220.0f, 0.020f, 2.4f, 0.005f, 50.0f, 0.55f, 6.21f}},
+  {1767254720, {59.0f, 41.0f, 24.31f, 26.90f, 78.30f, 900.3f, 220.7f, 0.021f, 2.3f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254780, {60.0f, 40.0f, 24.38f, 27.00f, 78.20f, 893.4f, 220.8f, 0.021f, 2.6f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254840, {60.0f, 40.0f, 24.38f, 26.90f, 77.50f, 895.5f, 220.6f, 0.020f, 2.6f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254900, {60.0f, 40.0f, 24.38f, 26.90f, 77.90f, 895.0f, 220.4f, 0.020f, 2.5f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767254960, {59.0f, 41.0f, 24.31f, 26.80f, 77.40f, 896.6f, 219.4f, 0.020f, 2.6f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255020, {59.0f, 41.0f, 24.31f, 27.00f, 77.40f, 896.1f, 220.1f, 0.019f, 2.4f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255085, {60.0f, 40.0f, 24.25f, 27.00f, 77.20f, 900.9f, 219.9f, 0.021f, 2.4f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255145, {60.0f, 40.0f, 24.38f, 27.00f, 78.10f, 895.0f, 220.7f, 0.021f, 2.6f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255205, {60.0f, 40.0f, 24.44f, 27.00f, 77.70f, 897.0f, 219.8f, 0.021f, 2.6f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255265, {59.0f, 41.0f, 24.56f, 27.10f, 77.40f, 891.1f, 219.0f, 0.021f, 2.6f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767255330, {60.0f, 40.0f, 24.38f, 26.90f, 76.90f, 897.6f, 220.4f, 0.020f, 2.5f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767255390, {59.0f, 41.0f, 24.38f, 27.20f, 77.20f, 895.0f, 219.6f, 0.022f, 2.3f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255450, {60.0f, 40.0f, 24.44f, 27.10f, 77.10f, 897.5f, 219.2f, 0.021f, 2.4f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255510, {60.0f, 40.0f, 24.44f, 27.10f, 77.40f, 897.5f, 219.3f, 0.020f, 2.6f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767255570, {60.0f, 40.0f, 24.38f, 27.00f, 76.50f, 898.1f, 219.6f, 0.021f, 2.5f, 0.005f, 50.0f, 0.55f, 6.23f}},
+  {1767255630, {60.0f, 40.0f, 24.44f, 27.10f, 77.10f, 897.0f, 219.9f, 0.021f, 2.3f, 0.005f, 50.0f, 0.55f, 6.22f}},
+  {1767255690, {60.0f, 40.0f, 24.50f, 27.30f, 77.40f, 895.3f, 218.1f, 0.019f, 2.3f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767255750, {60.0f, 40.0f, 24.44f, 27.20f, 77.10f, 899.0f, 219.0f, 0.020f, 2.5f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767255810, {60.0f, 40.0f, 24.44f, 27.30f, 76.90f, 895.9f, 220.5f, 0.022f, 2.4f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767255870, {59.0f, 41.0f, 24.44f, 27.10f, 77.10f, 894.9f, 219.5f, 0.021f, 2.3f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767255930, {60.0f, 40.0f, 24.44f, 27.40f, 76.10f, 895.4f, 219.4f, 0.021f, 2.4f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767255990, {60.0f, 40.0f, 24.38f, 27.20f, 76.50f, 894.5f, 220.4f, 0.021f, 2.6f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256050, {60.0f, 40.0f, 24.38f, 27.20f, 75.80f, 896.0f, 220.4f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256110, {60.0f, 40.0f, 24.50f, 27.30f, 75.80f, 893.2f, 220.8f, 0.021f, 2.3f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256170, {59.0f, 41.0f, 24.44f, 27.30f, 76.40f, 897.5f, 220.2f, 0.020f, 2.5f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256230, {59.0f, 41.0f, 24.56f, 27.30f, 76.10f, 893.1f, 219.1f, 0.022f, 2.4f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256290, {60.0f, 40.0f, 24.38f, 27.50f, 76.40f, 899.1f, 221.5f, 0.020f, 2.4f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256350, {59.0f, 41.0f, 24.50f, 27.30f, 76.10f, 895.3f, 220.7f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.24f}},
+  {1767256410, {59.0f, 41.0f, 24.38f, 27.40f, 76.60f, 896.0f, 219.4f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256470, {59.0f, 41.0f, 24.50f, 27.40f, 76.00f, 893.2f, 221.1f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256530, {59.0f, 41.0f, 24.50f, 27.50f, 76.70f, 896.9f, 219.0f, 0.021f, 2.6f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256590, {59.0f, 41.0f, 24.44f, 27.40f, 76.70f, 899.0f, 219.2f, 0.020f, 2.5f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256650, {59.0f, 41.0f, 24.56f, 27.60f, 75.40f, 895.2f, 220.2f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.22f}},
+  {1767256710, {60.0f, 40.0f, 24.38f, 27.50f, 76.00f, 898.6f, 219.9f, 0.021f, 2.6f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256770, {59.0f, 41.0f, 24.56f, 27.70f, 75.50f, 894.7f, 220.0f, 0.021f, 2.6f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256830, {60.0f, 40.0f, 24.44f, 27.70f, 76.60f, 895.4f, 221.1f, 0.020f, 2.6f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256895, {60.0f, 40.0f, 24.56f, 27.70f, 75.90f, 895.7f, 221.3f, 0.021f, 2.4f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767256955, {60.0f, 40.0f, 24.44f, 27.60f, 75.90f, 895.9f, 220.0f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767257015, {60.0f, 40.0f, 24.50f, 27.60f, 75.60f, 897.4f, 218.7f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.24f}},
+  {1767257080, {60.0f, 40.0f, 24.50f, 28.00f, 75.90f, 895.8f, 219.4f, 0.021f, 2.5f, 0.006f, 50.0f, 0.55f, 6.23f}},
+  {1767257140, {59.0f, 41.0f, 24.56f, 27.50f, 75.40f, 895.2f, 220.9f, 0.020f, 2.4f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257200, {59.0f, 41.0f, 24.56f, 27.70f, 76.70f, 895.7f, 221.1f, 0.022f, 2.4f, 0.007f, 50.0f, 0.55f, 6.22f}},
+  {1767257260, {59.0f, 41.0f, 24.56f, 27.90f, 75.90f, 895.7f, 220.5f, 0.021f, 2.6f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257320, {60.0f, 40.0f, 24.56f, 27.80f, 76.00f, 894.2f, 220.9f, 0.020f, 2.6f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257380, {60.0f, 40.0f, 24.63f, 27.60f, 76.10f, 896.7f, 220.4f, 0.021f, 2.6f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257445, {60.0f, 40.0f, 24.56f, 27.80f, 75.00f, 893.7f, 220.4f, 0.021f, 2.6f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257505, {59.0f, 41.0f, 24.69f, 27.70f, 75.80f, 892.4f, 219.5f, 0.021f, 2.3f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257565, {59.0f, 41.0f, 24.50f, 27.80f, 75.10f, 894.8f, 220.3f, 0.021f, 2.6f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767257625, {59.0f, 41.0f, 24.56f, 27.80f, 75.60f, 894.7f, 219.7f, 0.022f, 2.6f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767257685, {60.0f, 40.0f, 24.56f, 28.10f, 75.20f, 893.7f, 219.2f, 0.021f, 2.5f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257745, {59.0f, 41.0f, 24.69f, 27.90f, 75.40f, 894.5f, 218.6f, 0.021f, 2.5f, 0.007f, 50.0f, 0.55f, 6.22f}},
+  {1767257805, {59.0f, 41.0f, 24.63f, 27.90f, 74.70f, 894.6f, 219.4f, 0.020f, 2.4f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257865, {59.0f, 41.0f, 24.63f, 27.80f, 74.40f, 896.7f, 220.1f, 0.021f, 2.5f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767257925, {59.0f, 41.0f, 24.56f, 28.10f, 75.20f, 898.8f, 219.3f, 0.021f, 2.4f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767257985, {60.0f, 40.0f, 24.56f, 28.00f, 75.00f, 895.7f, 219.5f, 0.020f, 2.5f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767258045, {57.0f, 43.0f, 24.63f, 28.00f, 75.40f, 895.1f, 221.6f, 0.022f, 2.5f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767258105, {59.0f, 41.0f, 24.63f, 28.00f, 74.70f, 894.1f, 219.5f, 0.020f, 2.7f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767258165, {60.0f, 40.0f, 24.75f, 28.10f, 74.50f, 892.9f, 220.4f, 0.021f, 2.7f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767258225, {59.0f, 41.0f, 24.63f, 28.10f, 74.70f, 895.1f, 220.0f, 0.019f, 2.5f, 0.007f, 50.0f, 0.55f, 6.23f}},
+  {1767258285, {60.0f, 40.0f, 24.69f, 28.00f, 74.70f, 894.0f, 220.6f, 0.020f, 2.5f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767258345, {60.0f, 40.0f, 24.69f, 28.10f, 75.30f, 892.4f, 220.6f, 0.020f, 2.6f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767258405, {59.0f, 41.0f, 24.81f, 28.20f, 74.60f, 892.8f, 220.9f, 0.019f, 2.6f, 0.007f, 50.0f, 0.55f, 6.24f}},
+  {1767258465, {59.0f, 41.0f, 24.75f, 28.10f, 74.70f, 893.9f, 220.9f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258525, {60.0f, 40.0f, 24.69f, 28.20f, 74.20f, 896.0f, 220.7f, 0.019f, 2.4f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258585, {59.0f, 41.0f, 24.75f, 28.30f, 74.00f, 893.4f, 221.0f, 0.020f, 2.6f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258645, {60.0f, 40.0f, 24.75f, 28.20f, 73.60f, 893.9f, 219.3f, 0.019f, 2.4f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258705, {59.0f, 41.0f, 24.69f, 28.30f, 74.10f, 894.0f, 220.4f, 0.018f, 2.6f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258765, {60.0f, 40.0f, 24.69f, 28.30f, 74.90f, 894.5f, 220.5f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258825, {60.0f, 40.0f, 24.69f, 28.40f, 74.20f, 897.1f, 220.1f, 0.020f, 2.7f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767258885, {60.0f, 40.0f, 24.75f, 28.40f, 74.10f, 894.4f, 219.9f, 0.021f, 2.7f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767258945, {60.0f, 40.0f, 24.75f, 28.30f, 73.90f, 892.9f, 219.7f, 0.020f, 2.6f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767259005, {59.0f, 41.0f, 24.81f, 28.40f, 74.90f, 893.3f, 220.1f, 0.020f, 2.6f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259065, {60.0f, 40.0f, 24.69f, 28.20f, 74.40f, 894.5f, 219.9f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259125, {60.0f, 40.0f, 24.81f, 28.40f, 73.90f, 892.3f, 219.0f, 0.019f, 2.7f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767259185, {60.0f, 40.0f, 24.88f, 28.30f, 73.50f, 892.7f, 220.3f, 0.020f, 2.7f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259245, {59.0f, 41.0f, 24.81f, 28.50f, 73.90f, 894.8f, 220.4f, 0.021f, 2.6f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259305, {59.0f, 41.0f, 24.81f, 28.60f, 73.20f, 897.4f, 219.4f, 0.020f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259365, {59.0f, 41.0f, 24.88f, 28.50f, 74.10f, 892.2f, 219.3f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.25f}},
+  {1767259425, {59.0f, 41.0f, 24.88f, 28.60f, 74.20f, 892.7f, 218.6f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259485, {60.0f, 40.0f, 24.88f, 28.50f, 73.20f, 893.7f, 220.2f, 0.021f, 2.7f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259545, {59.0f, 41.0f, 24.81f, 28.50f, 73.70f, 893.3f, 220.2f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259605, {59.0f, 41.0f, 24.88f, 28.50f, 73.20f, 893.7f, 221.0f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767259665, {60.0f, 40.0f, 24.88f, 28.70f, 74.30f, 894.2f, 220.8f, 0.020f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259725, {60.0f, 40.0f, 24.88f, 28.60f, 73.30f, 895.8f, 219.8f, 0.021f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259785, {59.0f, 41.0f, 24.88f, 28.80f, 74.20f, 894.7f, 219.4f, 0.020f, 2.4f, 0.008f, 50.0f, 0.55f, 6.23f}},
+  {1767259845, {60.0f, 40.0f, 24.94f, 28.80f, 74.60f, 892.1f, 220.6f, 0.019f, 2.5f, 0.008f, 50.0f, 0.55f, 6.24f}},
+  {1767259905, {59.0f, 41.0f, 24.88f, 28.80f, 73.50f, 895.2f, 218.6f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767259965, {59.0f, 41.0f, 24.88f, 28.70f, 73.30f, 894.7f, 220.4f, 0.021f, 2.4f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260025, {59.0f, 41.0f, 25.00f, 28.80f, 72.90f, 893.0f, 220.1f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260085, {59.0f, 41.0f, 24.81f, 28.80f, 73.50f, 895.9f, 220.0f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260145, {60.0f, 40.0f, 24.94f, 28.80f, 73.70f, 893.6f, 220.2f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260205, {59.0f, 41.0f, 24.94f, 28.80f, 72.50f, 894.1f, 219.5f, 0.021f, 2.6f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260265, {60.0f, 40.0f, 24.94f, 28.90f, 73.20f, 894.6f, 222.2f, 0.021f, 2.6f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260325, {60.0f, 40.0f, 24.94f, 28.70f, 72.50f, 895.1f, 221.4f, 0.020f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260385, {60.0f, 40.0f, 25.06f, 28.80f, 72.90f, 890.9f, 219.6f, 0.021f, 2.3f, 0.009f, 50.0f, 0.55f, 6.25f}},
+  {1767260445, {59.0f, 41.0f, 25.00f, 28.90f, 73.30f, 894.0f, 220.4f, 0.020f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260505, {60.0f, 40.0f, 25.06f, 29.00f, 73.70f, 892.4f, 221.5f, 0.020f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260565, {59.0f, 41.0f, 25.06f, 28.90f, 72.20f, 892.9f, 218.7f, 0.022f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260625, {60.0f, 40.0f, 24.94f, 28.90f, 72.50f, 894.1f, 220.7f, 0.020f, 2.3f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260685, {59.0f, 41.0f, 25.00f, 28.90f, 71.80f, 892.0f, 219.7f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260745, {59.0f, 41.0f, 25.00f, 29.00f, 72.50f, 895.6f, 219.6f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260805, {60.0f, 40.0f, 25.06f, 29.00f, 72.80f, 895.5f, 220.0f, 0.021f, 2.4f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260865, {59.0f, 41.0f, 25.06f, 29.00f, 72.00f, 895.0f, 221.1f, 0.021f, 2.4f, 0.009f, 50.0f, 0.55f, 6.23f}},
+  {1767260925, {59.0f, 41.0f, 25.06f, 28.90f, 72.50f, 893.4f, 220.7f, 0.020f, 2.9f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767260985, {59.0f, 41.0f, 25.19f, 29.10f, 71.80f, 892.2f, 221.1f, 0.020f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261045, {59.0f, 41.0f, 25.13f, 29.10f, 71.90f, 893.8f, 219.9f, 0.021f, 2.4f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261105, {60.0f, 40.0f, 25.06f, 29.00f, 71.90f, 897.0f, 219.9f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261165, {60.0f, 40.0f, 25.19f, 29.00f, 72.30f, 890.7f, 220.1f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261225, {59.0f, 41.0f, 25.13f, 29.10f, 72.70f, 894.4f, 220.5f, 0.021f, 2.6f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261285, {60.0f, 40.0f, 25.19f, 29.10f, 71.40f, 894.8f, 219.9f, 0.021f, 2.5f, 0.009f, 50.0f, 0.55f, 6.24f}},
+  {1767261345, {59.0f, 41.0f, 25.13f, 29.40f, 72.30f, 894.4f, 219.3f, 0.022f, 2.3f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261405, {59.0f, 41.0f, 25.25f, 29.20f, 72.20f, 889.1f, 219.4f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261465, {59.0f, 41.0f, 25.06f, 29.20f, 72.70f, 896.0f, 220.1f, 0.020f, 2.4f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261525, {59.0f, 41.0f, 25.25f, 29.30f, 72.80f, 894.7f, 220.2f, 0.021f, 2.7f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261585, {60.0f, 40.0f, 25.19f, 29.30f, 71.40f, 893.2f, 219.7f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.25f}},
+  {1767261645, {57.0f, 43.0f, 25.19f, 29.30f, 71.30f, 891.7f, 220.3f, 0.021f, 2.7f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261705, {59.0f, 41.0f, 25.25f, 29.40f, 71.80f, 892.1f, 220.4f, 0.022f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261765, {59.0f, 41.0f, 25.19f, 29.50f, 72.30f, 893.2f, 220.5f, 0.019f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261825, {59.0f, 41.0f, 25.31f, 29.30f, 71.10f, 891.5f, 221.1f, 0.021f, 2.4f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261885, {59.0f, 41.0f, 25.31f, 29.30f, 71.40f, 892.5f, 220.2f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767261945, {60.0f, 40.0f, 25.25f, 29.40f, 71.10f, 893.7f, 220.4f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.25f}},
+  {1767262010, {59.0f, 41.0f, 25.25f, 29.50f, 71.90f, 890.6f, 218.3f, 0.022f, 2.7f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262070, {60.0f, 40.0f, 25.31f, 29.30f, 71.20f, 891.5f, 219.2f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262130, {59.0f, 41.0f, 25.31f, 29.40f, 71.00f, 895.1f, 220.7f, 0.020f, 2.4f, 0.010f, 50.0f, 0.55f, 6.25f}},
+  {1767262190, {60.0f, 40.0f, 25.25f, 29.70f, 71.30f, 895.2f, 219.4f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262250, {59.0f, 41.0f, 25.44f, 29.50f, 70.90f, 889.3f, 217.8f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262310, {60.0f, 40.0f, 25.44f, 29.60f, 71.70f, 889.8f, 219.5f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262370, {60.0f, 40.0f, 25.38f, 29.50f, 71.20f, 895.0f, 220.3f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262430, {59.0f, 41.0f, 25.44f, 29.60f, 70.90f, 890.8f, 219.4f, 0.022f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262490, {60.0f, 40.0f, 25.38f, 29.60f, 70.20f, 892.5f, 219.6f, 0.021f, 2.5f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262550, {60.0f, 40.0f, 25.50f, 29.60f, 70.90f, 892.3f, 220.3f, 0.021f, 2.3f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262610, {60.0f, 40.0f, 25.44f, 29.60f, 70.80f, 892.9f, 218.8f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262670, {59.0f, 41.0f, 25.44f, 29.80f, 71.10f, 889.8f, 220.7f, 0.021f, 2.6f, 0.010f, 50.0f, 0.55f, 6.24f}},
+  {1767262730, {59.0f, 41.0f, 25.50f, 29.60f, 70.20f, 891.8f, 220.6f, 0.020f, 2.5f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767262790, {60.0f, 40.0f, 25.56f, 29.70f, 70.80f, 891.7f, 219.1f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767262850, {59.0f, 41.0f, 25.50f, 29.80f, 70.00f, 892.3f, 220.1f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767262910, {59.0f, 41.0f, 25.56f, 29.80f, 70.60f, 890.7f, 219.0f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767262970, {60.0f, 40.0f, 25.50f, 29.60f, 70.60f, 893.8f, 219.8f, 0.022f, 2.6f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263030, {59.0f, 41.0f, 25.50f, 29.60f, 70.20f, 890.2f, 220.2f, 0.020f, 2.6f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263090, {60.0f, 40.0f, 25.56f, 29.70f, 70.40f, 892.7f, 220.2f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263150, {59.0f, 41.0f, 25.63f, 29.70f, 70.80f, 890.1f, 219.2f, 0.022f, 2.4f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263210, {59.0f, 41.0f, 25.50f, 29.90f, 71.40f, 893.3f, 219.5f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263270, {59.0f, 41.0f, 25.63f, 29.80f, 70.90f, 892.6f, 220.2f, 0.021f, 2.5f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263330, {59.0f, 41.0f, 25.56f, 29.90f, 71.10f, 894.2f, 220.6f, 0.020f, 2.5f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263390, {59.0f, 41.0f, 25.56f, 30.00f, 69.70f, 890.2f, 220.7f, 0.020f, 2.6f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263450, {59.0f, 41.0f, 25.63f, 30.00f, 70.20f, 895.1f, 219.5f, 0.021f, 2.4f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263510, {59.0f, 41.0f, 25.63f, 29.90f, 69.90f, 888.6f, 222.6f, 0.020f, 2.5f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263570, {59.0f, 41.0f, 25.56f, 29.90f, 71.00f, 892.7f, 220.0f, 0.021f, 2.8f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263630, {59.0f, 41.0f, 25.63f, 30.00f, 70.00f, 893.6f, 220.7f, 0.021f, 2.6f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263690, {60.0f, 40.0f, 25.69f, 30.00f, 69.70f, 893.0f, 219.4f, 0.021f, 2.6f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263750, {60.0f, 40.0f, 25.63f, 30.00f, 70.20f, 891.6f, 220.1f, 0.021f, 2.5f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263810, {60.0f, 40.0f, 25.75f, 30.10f, 69.20f, 892.4f, 219.4f, 0.020f, 2.6f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263870, {59.0f, 41.0f, 25.69f, 30.00f, 69.90f, 892.5f, 219.8f, 0.021f, 2.6f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767263930, {59.0f, 41.0f, 25.75f, 30.30f, 70.30f, 889.9f, 220.2f, 0.021f, 2.7f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767263990, {59.0f, 41.0f, 25.69f, 30.00f, 69.40f, 891.5f, 219.9f, 0.020f, 2.5f, 0.011f, 50.0f, 0.55f, 6.24f}},
+  {1767264050, {60.0f, 40.0f, 25.75f, 30.10f, 69.50f, 888.4f, 219.1f, 0.020f, 2.5f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767264110, {60.0f, 40.0f, 25.81f, 30.20f, 69.90f, 892.3f, 222.2f, 0.020f, 2.6f, 0.011f, 50.0f, 0.55f, 6.25f}},
+  {1767264170, {59.0f, 41.0f, 25.69f, 30.20f, 70.20f, 891.0f, 219.8f, 0.020f, 2.6f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264230, {59.0f, 41.0f, 25.88f, 30.00f, 69.40f, 892.2f, 219.4f, 0.020f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264290, {60.0f, 40.0f, 25.75f, 30.20f, 70.20f, 894.4f, 218.3f, 0.021f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264350, {60.0f, 40.0f, 25.75f, 30.10f, 69.90f, 894.4f, 219.4f, 0.021f, 2.6f, 0.012f, 50.0f, 0.55f, 6.24f}},
+  {1767264410, {60.0f, 40.0f, 25.88f, 30.30f, 69.20f, 890.7f, 219.6f, 0.021f, 2.6f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264470, {59.0f, 41.0f, 25.75f, 30.10f, 69.60f, 896.5f, 220.3f, 0.019f, 2.5f, 0.012f, 50.0f, 0.55f, 6.24f}},
+  {1767264530, {59.0f, 41.0f, 25.81f, 30.30f, 69.70f, 892.3f, 219.6f, 0.019f, 2.6f, 0.012f, 50.0f, 0.55f, 6.24f}},
+  {1767264590, {59.0f, 41.0f, 25.88f, 30.40f, 69.60f, 892.2f, 220.9f, 0.021f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264650, {59.0f, 41.0f, 25.81f, 30.20f, 69.20f, 890.8f, 220.9f, 0.021f, 2.6f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264710, {59.0f, 41.0f, 25.88f, 30.40f, 69.70f, 889.7f, 221.5f, 0.020f, 2.4f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264770, {59.0f, 41.0f, 25.81f, 30.20f, 69.70f, 891.3f, 219.0f, 0.020f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264830, {59.0f, 41.0f, 26.00f, 30.30f, 69.70f, 889.0f, 219.4f, 0.020f, 2.4f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264890, {59.0f, 41.0f, 25.94f, 30.40f, 68.90f, 892.2f, 219.8f, 0.021f, 2.7f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767264950, {60.0f, 40.0f, 26.00f, 30.40f, 68.80f, 890.6f, 219.7f, 0.020f, 2.5f, 0.012f, 50.0f, 0.55f, 6.24f}},
+  {1767265010, {60.0f, 40.0f, 25.88f, 30.50f, 69.40f, 891.7f, 219.2f, 0.021f, 2.5f, 0.012f, 50.0f, 0.55f, 6.24f}},
+  {1767265070, {59.0f, 41.0f, 25.88f, 30.50f, 69.30f, 893.2f, 221.9f, 0.019f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265130, {59.0f, 41.0f, 26.00f, 30.40f, 68.90f, 892.1f, 220.3f, 0.019f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265190, {59.0f, 41.0f, 26.06f, 30.30f, 69.30f, 889.0f, 220.2f, 0.021f, 2.3f, 0.012f, 50.0f, 0.55f, 6.26f}},
+  {1767265250, {57.0f, 43.0f, 26.00f, 30.50f, 69.20f, 892.1f, 220.7f, 0.021f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265310, {59.0f, 41.0f, 25.94f, 30.60f, 68.30f, 893.2f, 220.1f, 0.021f, 2.6f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265370, {59.0f, 41.0f, 26.00f, 30.50f, 68.50f, 891.1f, 219.8f, 0.021f, 2.5f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265430, {60.0f, 40.0f, 26.06f, 30.60f, 68.60f, 889.0f, 220.5f, 0.021f, 2.3f, 0.012f, 50.0f, 0.55f, 6.25f}},
+  {1767265490, {59.0f, 41.0f, 26.06f, 30.50f, 68.20f, 893.5f, 220.2f, 0.020f, 2.5f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767265550, {59.0f, 41.0f, 26.13f, 30.60f, 68.70f, 891.9f, 218.1f, 0.020f, 2.3f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767265610, {59.0f, 41.0f, 26.13f, 30.70f, 69.50f, 893.9f, 220.2f, 0.020f, 2.5f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767265670, {59.0f, 41.0f, 26.13f, 30.70f, 68.00f, 890.9f, 220.0f, 0.022f, 2.7f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767265730, {60.0f, 40.0f, 26.19f, 30.80f, 69.10f, 888.3f, 219.3f, 0.020f, 2.5f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767265790, {58.0f, 42.0f, 26.06f, 30.80f, 69.00f, 892.0f, 220.8f, 0.021f, 2.3f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767265850, {59.0f, 41.0f, 26.06f, 30.60f, 68.80f, 891.5f, 218.5f, 0.023f, 2.5f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767265910, {59.0f, 41.0f, 26.13f, 30.80f, 68.70f, 892.9f, 220.5f, 0.020f, 2.5f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767265970, {59.0f, 41.0f, 26.25f, 30.60f, 67.80f, 893.2f, 219.5f, 0.021f, 2.6f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266030, {59.0f, 41.0f, 26.13f, 30.90f, 67.80f, 892.9f, 221.1f, 0.021f, 2.6f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266090, {60.0f, 40.0f, 26.19f, 30.90f, 67.00f, 892.3f, 219.6f, 0.020f, 2.4f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266150, {59.0f, 41.0f, 26.13f, 30.70f, 67.60f, 894.4f, 221.3f, 0.021f, 2.3f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266210, {60.0f, 40.0f, 26.25f, 30.80f, 67.90f, 890.2f, 219.3f, 0.021f, 2.6f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266270, {59.0f, 41.0f, 26.25f, 31.00f, 68.40f, 890.7f, 219.4f, 0.021f, 2.3f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266330, {59.0f, 41.0f, 26.19f, 30.80f, 68.40f, 892.8f, 220.4f, 0.021f, 2.4f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266390, {59.0f, 41.0f, 26.31f, 30.90f, 67.90f, 890.1f, 219.8f, 0.020f, 2.5f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266450, {59.0f, 41.0f, 26.38f, 31.00f, 68.30f, 889.0f, 219.7f, 0.022f, 2.5f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266510, {59.0f, 41.0f, 26.31f, 30.90f, 67.90f, 888.6f, 219.3f, 0.020f, 2.4f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266570, {59.0f, 41.0f, 26.38f, 30.90f, 67.60f, 892.0f, 219.9f, 0.021f, 2.5f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767266630, {59.0f, 41.0f, 26.25f, 31.00f, 68.00f, 891.2f, 221.8f, 0.020f, 2.4f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767266690, {59.0f, 41.0f, 26.31f, 30.80f, 67.50f, 888.1f, 219.1f, 0.020f, 2.4f, 0.013f, 50.0f, 0.55f, 6.25f}},
+  {1767266750, {59.0f, 41.0f, 26.38f, 30.90f, 67.30f, 890.0f, 217.7f, 0.021f, 2.5f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767266810, {59.0f, 41.0f, 26.31f, 30.90f, 66.80f, 890.6f, 219.6f, 0.018f, 2.4f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767266870, {59.0f, 41.0f, 26.31f, 31.00f, 67.70f, 891.1f, 220.6f, 0.022f, 2.3f, 0.013f, 50.0f, 0.55f, 6.26f}},
+  {1767266930, {59.0f, 41.0f, 26.44f, 31.00f, 66.30f, 889.5f, 219.6f, 0.021f, 2.4f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767266990, {59.0f, 41.0f, 26.38f, 30.90f, 67.10f, 891.0f, 221.5f, 0.019f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267050, {59.0f, 41.0f, 26.44f, 31.00f, 66.50f, 891.4f, 220.6f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267110, {59.0f, 41.0f, 26.44f, 31.10f, 67.30f, 890.9f, 219.0f, 0.022f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267170, {59.0f, 41.0f, 26.38f, 31.10f, 67.50f, 892.5f, 218.2f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267230, {59.0f, 41.0f, 26.44f, 31.20f, 68.40f, 889.5f, 221.1f, 0.019f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267290, {59.0f, 41.0f, 26.50f, 31.30f, 66.80f, 890.9f, 220.1f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767267350, {59.0f, 41.0f, 26.38f, 31.10f, 66.70f, 894.0f, 220.1f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267410, {59.0f, 41.0f, 26.50f, 31.20f, 67.40f, 891.9f, 221.2f, 0.020f, 2.5f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767267470, {59.0f, 41.0f, 26.63f, 31.20f, 66.20f, 890.7f, 219.9f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267530, {59.0f, 41.0f, 26.63f, 31.20f, 67.20f, 891.7f, 220.3f, 0.020f, 2.6f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767267590, {59.0f, 41.0f, 26.50f, 31.30f, 66.90f, 893.3f, 221.2f, 0.020f, 2.4f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267650, {59.0f, 41.0f, 26.56f, 31.10f, 67.60f, 891.3f, 219.5f, 0.022f, 2.4f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267710, {59.0f, 41.0f, 26.63f, 31.20f, 66.30f, 891.2f, 219.3f, 0.021f, 2.6f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267770, {59.0f, 41.0f, 26.56f, 31.30f, 67.00f, 890.8f, 219.1f, 0.021f, 2.4f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767267830, {59.0f, 41.0f, 26.56f, 31.30f, 67.00f, 890.8f, 219.5f, 0.020f, 2.6f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767267890, {59.0f, 41.0f, 26.56f, 31.50f, 67.10f, 893.7f, 220.3f, 0.020f, 2.5f, 0.014f, 50.0f, 0.55f, 6.27f}},
+  {1767267950, {60.0f, 40.0f, 26.56f, 31.30f, 67.40f, 891.3f, 219.8f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767268010, {60.0f, 40.0f, 26.69f, 31.30f, 66.50f, 891.6f, 220.5f, 0.019f, 2.6f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767268070, {59.0f, 41.0f, 26.75f, 31.40f, 67.90f, 886.6f, 219.2f, 0.021f, 2.4f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767268130, {59.0f, 41.0f, 26.75f, 31.30f, 66.40f, 888.5f, 219.0f, 0.021f, 2.2f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767268190, {59.0f, 41.0f, 26.69f, 31.40f, 66.80f, 889.1f, 220.5f, 0.021f, 2.5f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767268250, {59.0f, 41.0f, 26.75f, 31.40f, 66.90f, 890.5f, 220.1f, 0.020f, 2.5f, 0.014f, 50.0f, 0.55f, 6.25f}},
+  {1767268310, {59.0f, 41.0f, 26.81f, 31.40f, 66.60f, 889.9f, 221.1f, 0.021f, 2.7f, 0.014f, 50.0f, 0.55f, 6.26f}},
+  {1767268370, {59.0f, 41.0f, 26.69f, 31.40f, 65.90f, 890.6f, 219.5f, 0.021f, 2.3f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268430, {59.0f, 41.0f, 26.75f, 31.50f, 65.90f, 891.5f, 219.7f, 0.019f, 2.4f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268490, {59.0f, 41.0f, 26.69f, 31.50f, 66.10f, 892.1f, 220.1f, 0.021f, 2.3f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268550, {59.0f, 41.0f, 26.75f, 31.30f, 67.00f, 892.0f, 221.5f, 0.021f, 2.6f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268610, {60.0f, 40.0f, 26.81f, 31.50f, 66.20f, 889.9f, 220.1f, 0.021f, 2.6f, 0.015f, 50.0f, 0.55f, 6.27f}},
+  {1767268670, {60.0f, 40.0f, 26.81f, 31.50f, 66.20f, 889.4f, 221.4f, 0.021f, 2.5f, 0.015f, 50.0f, 0.55f, 6.27f}},
+  {1767268730, {59.0f, 41.0f, 26.88f, 31.50f, 66.50f, 890.3f, 219.1f, 0.021f, 2.5f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268790, {59.0f, 41.0f, 26.88f, 31.70f, 65.90f, 888.9f, 218.6f, 0.021f, 2.6f, 0.015f, 50.0f, 0.55f, 6.26f}},
+  {1767268850, {57.0f, 43.0f, 26.94f, 31.60f, 66.10f, 888.3f, 220.2f, 0.021f, 2.5f, 0.015f, 50.0f, 0.55f, 6.26f}},
+};
+
+#endif // BENCH_TRACE_H
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Compares two benchmark result files written by bench_main.cpp.
+
+Usage: compare_results.py BASELINE CURRENT [--threshold PERCENT]
+
+Either file may be a raw serial capture; lines that are not JSON are ignored.
+Kernels are compared by the median cycles per operation when both files have
+it (ESP32). Host results are compared by the fastest round instead, which is
+far less sensitive to other load on the machine than the median, but
+nanosecond kernels still jitter on a shared host; track releases with board
+results and use a wider threshold on the host.
+
+The exit status is 1 if any kernel got slower by more than the threshold
+(default 10%), 2 if the files cannot be compared.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    header, kernels = None, {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            try:
+                record = json.loads(line)
+            except ValueError:
+                continue
+            if "suite" in record:
+                header = record
+            elif "bench" in record:
+                kernels[record["bench"]] = record
+    if header is None:
+        sys.exit("%s: no benchmark header found" % path)
+    return header, kernels
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default 10)")
+    args = parser.parse_args()
+
+    base_header, base = load(args.baseline)
+    cur_header, cur = load(args.current)
+    for key in ("version", "platform"):
+        if base_header.get(key) != cur_header.get(key):
+            print("Cannot compare: %s differs (%s vs %s)" % (key, base_header.get(key), cur_header.get(key)))
+            return 2
+
+    regressions = 0
+    print("%-22s %12s %12s %8s" % ("kernel", "baseline", "current", "change"))
+    for name in sorted(set(base) | set(cur)):
+        if name not in base or name not in cur:
+            print("%-22s %s" % (name, "only in " + ("baseline" if name in base else "current")))
+            continue
+        metric = "cycles_per_op" if "cycles_per_op" in base[name] and "cycles_per_op" in cur[name] else "ns_per_op_min"
+        before, after = base[name][metric], cur[name][metric]
+        change = (after - before) / before * 100 if before else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        unit = "cyc" if metric == "cycles_per_op" else "ns"
+        print("%-22s %9.1f %-2s %9.1f %-2s %+7.1f%%%s" % (name, before, unit, after, unit, change, flag))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
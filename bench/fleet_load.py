@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""Load-tests an MQTT broker with a fleet of simulated greenhouses.
+
+Usage: fleet_load.py --broker HOST[:PORT] [--user U --password P] [--nodes 1,5,10,25,50]
+                     [--modes summary,raw,every] [--duration 120] [--warmup 20] [--probe 10]
+
+Each node is the native simulator (`pio run -e native`) running the firmware
+against its own simulated plant, with its own instance ID, on the wall clock
+and connected to the broker (`--broker`, see lib/hidroiot_sim/src/sim_net.h).
+It publishes exactly what a board would, on the firmware's schedule, and an
+observer connection per node stands in for Home Assistant. For each
+publishing mode the fleet is grown step by step, and each step reports:
+
+- throughput: the messages and payload bytes per second the nodes published;
+- latency: the time from a device's publish until the broker delivered it to
+  the observer (p50, p99, max);
+- command round trip: the time from a probe command (an invalid pump command,
+  so nothing runs) until the device's acknowledgement arrived;
+- loss: published messages and probes that never arrived, and connections the
+  broker dropped.
+
+The publishing modes set `raw_ms` on every node: `summary` publishes window
+summaries only, `raw` adds raw readings every 30 s (the default), and `every`
+publishes each reading (every 5 s). A step saturates the broker when the p99
+latency exceeds `--max-latency-ms`, the median command round trip exceeds
+`--max-command-ms`, more than `--max-loss-pct` of the messages or probes get
+lost, or a connection is dropped; the last step before that is reported per
+mode. The command round trip is judged by its median because its tail belongs
+to the firmware: a command that arrives during the water temperature
+conversion (up to 750 ms, once per sensor cycle) waits for it on any broker.
+
+All nodes run on this machine as one process each. Run the tool on a
+different host than the broker, and check that its own CPU is not the
+bottleneck (a coarser `--tick-ms` helps) before blaming the broker.
+
+The exit status is 1 if any mode saturated, 2 if a node failed to run.
+"""
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+
+MODES = {"summary": 0, "raw": 30000, "every": 5000}
+BUCKETS = 160
+
+
+def percentile_ms(counts, fraction):
+    """Returns the upper bound of the histogram bucket the percentile falls in, as sim_net.cpp does."""
+    total = sum(counts)
+    if total == 0:
+        return float("nan")
+    rank, seen = math.ceil(fraction * total), 0
+    for bucket, count in enumerate(counts):
+        seen += count
+        if seen >= rank:
+            break
+    return 0.1 * 2 ** ((bucket + 1) / 8.0)
+
+
+def merge(histograms):
+    counts = [0] * BUCKETS
+    for histogram in histograms:
+        for bucket, count in enumerate(histogram["counts"]):
+            counts[bucket] += count
+    return {"counts": counts, "max_us": max([h["max_us"] for h in histograms] or [0]),
+            "sum_us": sum(h["sum_us"] for h in histograms)}
+
+
+def run_step(args, mode, nodes):
+    """Runs `nodes` simulators at once and returns their merged results."""
+    hours = (args.warmup + args.duration) / 3600.0
+    procs = []
+    for i in range(nodes):
+        command = [args.program, "--broker", args.broker, "--hours", "%.6f" % hours, "--tick-ms", str(args.tick_ms),
+                   "--warmup", str(args.warmup), "--probe", str(args.probe), "--seed", str(i + 1), "--json",
+                   "--provision", "instance=fleet_%s_%d" % (mode, i + 1), "--provision", "raw_ms=%d" % MODES[mode]]
+        if args.user:
+            command += ["--provision", "mqtt_user=" + args.user, "--provision", "mqtt_pass=" + (args.password or "")]
+        procs.append(subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                                      universal_newlines=True))
+    results, failed = [], 0
+    for proc in procs:
+        output = proc.communicate()[0]
+        lines = [line for line in output.splitlines() if line.startswith("{")]
+        if proc.returncode != 0 or not lines:
+            failed += 1
+            continue
+        results.append(json.loads(lines[-1])["net"])
+
+    step = {"mode": mode, "nodes": nodes, "failed": failed}
+    for key in ("published", "published_bytes", "echoed", "lost", "probes", "probes_answered", "link_drops"):
+        step[key] = sum(r[key] for r in results)
+    step["msgs_per_s"] = sum(r["published"] / r["window_s"] for r in results if r["window_s"] > 0)
+    step["bytes_per_s"] = sum(r["published_bytes"] / r["window_s"] for r in results if r["window_s"] > 0)
+    latency = merge([r["latency"] for r in results])
+    rtt = merge([r["probe_rtt"] for r in results])
+    for name, histogram in (("latency", latency), ("rtt", rtt)):
+        step[name + "_p50_ms"] = percentile_ms(histogram["counts"], 0.5)
+        step[name + "_p99_ms"] = percentile_ms(histogram["counts"], 0.99)
+        step[name + "_max_ms"] = histogram["max_us"] / 1000.0
+    step["loss_pct"] = 100.0 * step["lost"] / step["published"] if step["published"] else 0.0
+    answered = step["probes_answered"]
+    step["probe_loss_pct"] = 100.0 * (step["probes"] - answered) / step["probes"] if step["probes"] else 0.0
+    return step
+
+
+def saturated(args, step):
+    """Returns why a step saturated the broker, or None."""
+    if step["failed"]:
+        return "%d nodes failed" % step["failed"]
+    if step["link_drops"]:
+        return "%d connections dropped" % step["link_drops"]
+    if step["loss_pct"] > args.max_loss_pct or step["probe_loss_pct"] > args.max_loss_pct:
+        return "%.2f%% messages, %.2f%% probes lost" % (step["loss_pct"], step["probe_loss_pct"])
+    if step["latency_p99_ms"] > args.max_latency_ms:
+        return "latency p99 %.1f ms" % step["latency_p99_ms"]
+    if step["rtt_p50_ms"] > args.max_command_ms:
+        return "command p50 %.1f ms" % step["rtt_p50_ms"]
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--broker", required=True, help="HOST[:PORT] of the broker under test")
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--program", default=os.path.join(".pio", "build", "native", "program"),
+                        help="the simulator (default .pio/build/native/program)")
+    parser.add_argument("--nodes", default="1,5,10,25,50", help="fleet sizes to step through (default 1,5,10,25,50)")
+    parser.add_argument("--modes", default="summary,raw,every", help="publishing modes (default summary,raw,every)")
+    parser.add_argument("--duration", type=float, default=120, help="seconds measured per step (default 120)")
+    parser.add_argument("--warmup", type=float, default=20,
+                        help="seconds per step not measured, covering the connection storm (default 20)")
+    parser.add_argument("--probe", type=float, default=10, help="seconds between probe commands per node (default 10)")
+    parser.add_argument("--tick-ms", type=float, default=10,
+                        help="simulator loop period; coarser ticks let more nodes share a core (default 10)")
+    parser.add_argument("--max-latency-ms", type=float, default=100.0,
+                        help="p99 publish latency that counts as saturated (default 100)")
+    parser.add_argument("--max-command-ms", type=float, default=100.0,
+                        help="median command round trip that counts as saturated (default 100)")
+    parser.add_argument("--max-loss-pct", type=float, default=0.1,
+                        help="share of lost messages or probes that counts as saturated (default 0.1)")
+    parser.add_argument("--json", action="store_true", help="print one JSON line per step instead of a table")
+    args = parser.parse_args()
+
+    modes = args.modes.split(",")
+    for mode in modes:
+        if mode not in MODES:
+            sys.exit("unknown mode %s (%s)" % (mode, ", ".join(sorted(MODES))))
+    steps = [int(n) for n in args.nodes.split(",")]
+    if not os.access(args.program, os.X_OK):
+        sys.exit("%s not found; build it with: pio run -e native" % args.program)
+
+    status = 0
+    for mode in modes:
+        if not args.json:
+            print("\nMode %s (raw_ms=%d)" % (mode, MODES[mode]))
+            print("%6s %9s %9s %22s %22s %8s %6s" % (
+                "nodes", "msg/s", "KB/s", "latency p50/p99/max", "command p50/p99/max", "loss%", "drops"))
+        capacity = None
+        for nodes in steps:
+            step = run_step(args, mode, nodes)
+            reason = saturated(args, step)
+            step["saturated"] = reason
+            if args.json:
+                print(json.dumps(step))
+            else:
+                print("%6d %9.1f %9.1f %8.1f/%6.1f/%6.1f %8.1f/%6.1f/%6.1f %8.2f %6d%s" % (
+                    nodes, step["msgs_per_s"], step["bytes_per_s"] / 1000.0, step["latency_p50_ms"],
+                    step["latency_p99_ms"], step["latency_max_ms"], step["rtt_p50_ms"], step["rtt_p99_ms"],
+                    step["rtt_max_ms"], step["loss_pct"], step["link_drops"], "  <- " + reason if reason else ""))
+            if step["failed"]:
+                status = 2
+            if reason:
+                break
+            capacity = step
+        if reason:
+            status = max(status, 1)
+        if not args.json:
+            if capacity is None:
+                print("Saturated with %d nodes" % steps[0])
+            elif reason:
+                print("Saturates between %d and %d nodes (%.0f msg/s sustained)" % (
+                    capacity["nodes"], nodes, capacity["msgs_per_s"]))
+            else:
+                print("Not saturated up to %d nodes (%.0f msg/s)" % (capacity["nodes"], capacity["msgs_per_s"]))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,153 @@
+/**
+ * @file Arduino.h
+ * @brief The subset of the ESP32 Arduino core used by the firmware, for the native simulator.
+ *
+ * Time comes from the virtual clock in sim_time.h, GPIO and ADC go to the plant
+ * model, and `Serial` writes to stdout only when firmware logging is enabled.
+ */
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define ADC_11db 3
+#define SERIAL_8N1 0x800001c
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// --- Time ---
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+/// @brief SNTP setup. The wall clock is set once WiFi is connected; it then runs
+/// on virtual time from 2026-01-01 06:00 UTC at power-on.
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+/// @brief The wall clock on virtual time: seconds since boot until SNTP has set it, like the ESP32.
+int sim_gettimeofday(struct timeval* tv);
+#define gettimeofday(tv, tz) sim_gettimeofday(tv)
+
+// --- GPIO & ADC ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void analogSetWidth(uint8_t bits);
+void analogSetAttenuation(int attenuation);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/**
+ * @class String
+ * @brief Minimal Arduino `String`, enough for `IPAddress::toString()`.
+ */
+class String {
+public:
+  String(const char* s = "") : value(s) {}
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.length(); }
+
+private:
+  std::string value;
+};
+
+/**
+ * @class Print
+ * @brief Arduino's formatted output base class.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+  size_t print(const char* str) { return write(str); }
+  size_t print(const String& str) { return write(str.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value) { return printf("%d", value); }
+  size_t print(unsigned int value) { return printf("%u", value); }
+  size_t print(long value) { return printf("%ld", value); }
+  size_t print(unsigned long value) { return printf("%lu", value); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(const T& value) { return print(value) + println(); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  virtual void flush() {}
+};
+
+/**
+ * @class HardwareSerial
+ * @brief A UART. `Serial` echoes to stdout when enabled; other ports discard output.
+ */
+class HardwareSerial : public Print {
+public:
+  explicit HardwareSerial(int uart) : uart(uart) {}
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {}
+  void end() {}
+  int available() { return 0; }
+  int read() { return -1; }
+  using Print::write;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  operator bool() const { return true; }
+
+private:
+  int uart;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+/**
+ * @class EspClass
+ * @brief Chip information and control, answered from the simulator's state.
+ */
+class EspClass {
+public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+  uint64_t getEfuseMac() { return 0x00A1B2C3D4E5ULL; }
+};
+
+extern EspClass ESP;
+
+// --- FreeRTOS (the firmware runs in a single task) ---
+typedef void* TaskHandle_t;
+typedef unsigned int UBaseType_t;
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+TaskHandle_t xTaskGetHandle(const char* name);
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,21 @@
+/**
+ * @file DHT.h
+ * @brief The DHT22 API for the native simulator, answered by the plant model.
+ */
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type) {}
+  void begin() {}
+  float readTemperature(bool fahrenheit = false);
+  float readHumidity();
+};
+
+#endif // SIM_DHT_H
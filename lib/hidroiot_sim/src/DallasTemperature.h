@@ -0,0 +1,22 @@
+/**
+ * @file DallasTemperature.h
+ * @brief The DS18B20 API for the native simulator, answered by the plant model.
+ */
+#ifndef SIM_DALLAS_TEMPERATURE_H
+#define SIM_DALLAS_TEMPERATURE_H
+
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+class DallasTemperature {
+public:
+  explicit DallasTemperature(OneWire* bus) {}
+  void begin() {}
+  void setResolution(uint8_t bits) {}
+  void setWaitForConversion(bool wait) {}
+  void requestTemperatures();
+  float getTempCByIndex(uint8_t index);
+};
+
+#endif // SIM_DALLAS_TEMPERATURE_H
@@ -0,0 +1,24 @@
+/**
+ * @file IPAddress.h
+ * @brief Minimal Arduino `IPAddress` for the native simulator.
+ */
+#ifndef SIM_IPADDRESS_H
+#define SIM_IPADDRESS_H
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+  IPAddress() : octets{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+  }
+
+private:
+  uint8_t octets[4];
+};
+
+#endif // SIM_IPADDRESS_H
@@ -0,0 +1,22 @@
+/**
+ * @file NewPing.h
+ * @brief The NewPing ultrasonic API for the native simulator, answered by the plant model.
+ */
+#ifndef SIM_NEWPING_H
+#define SIM_NEWPING_H
+
+#include <Arduino.h>
+
+#define NO_ECHO 0
+
+class NewPing {
+public:
+  NewPing(uint8_t triggerPin, uint8_t echoPin, unsigned int maxCmDistance = 500)
+      : maxCmDistance(maxCmDistance) {}
+  unsigned int ping_cm(unsigned int maxCmDistance = 0);
+
+private:
+  unsigned int maxCmDistance;
+};
+
+#endif // SIM_NEWPING_H
@@ -0,0 +1,15 @@
+/**
+ * @file OneWire.h
+ * @brief The OneWire bus for the native simulator. The only device is the DS18B20.
+ */
+#ifndef SIM_ONEWIRE_H
+#define SIM_ONEWIRE_H
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+  explicit OneWire(uint8_t pin) {}
+};
+
+#endif // SIM_ONEWIRE_H
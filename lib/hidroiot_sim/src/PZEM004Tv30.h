@@ -0,0 +1,22 @@
+/**
+ * @file PZEM004Tv30.h
+ * @brief The PZEM-004T v3.0 API for the native simulator, answered by the plant model.
+ */
+#ifndef SIM_PZEM004TV30_H
+#define SIM_PZEM004TV30_H
+
+#include <Arduino.h>
+
+class PZEM004Tv30 {
+public:
+  PZEM004Tv30(HardwareSerial& port, uint8_t rxPin, uint8_t txPin) {}
+  float voltage();
+  float current();
+  float power();
+  float energy();
+  float frequency();
+  float pf();
+  bool resetEnergy();
+};
+
+#endif // SIM_PZEM004TV30_H
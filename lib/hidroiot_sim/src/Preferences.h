@@ -0,0 +1,45 @@
+/**
+ * @file Preferences.h
+ * @brief The ESP32 NVS `Preferences` API for the native simulator.
+ *
+ * Values live in memory and survive simulated restarts. With `--nvs <file>`
+ * they are also loaded from and saved to a file, so a run can resume from
+ * the flash contents of an earlier one.
+ */
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() {}
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t getBytesLength(const char* key);
+  size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return get_scalar(key, defaultValue); }
+  size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+  float getFloat(const char* key, float defaultValue = NAN) { return get_scalar(key, defaultValue); }
+  size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return get_scalar(key, defaultValue); }
+  size_t putBool(const char* key, bool value) { return putUChar(key, value ? 1 : 0); }
+  size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+  /// @brief Copies a string including its terminator; returns 0 if it is missing or longer than `maxLen`.
+  size_t getString(const char* key, char* value, size_t maxLen) { return getBytes(key, value, maxLen); }
+  bool getBool(const char* key, bool defaultValue = false) { return getUChar(key, defaultValue ? 1 : 0) != 0; }
+
+private:
+  template <typename T> T get_scalar(const char* key, T defaultValue) {
+    T value;
+    return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) == sizeof(T) ? value : defaultValue;
+  }
+  std::string space;
+  bool readOnly = false;
+};
+
+#endif // SIM_PREFERENCES_H
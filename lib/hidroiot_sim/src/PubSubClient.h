@@ -0,0 +1,75 @@
+/**
+ * @file PubSubClient.h
+ * @brief The PubSubClient API for the native simulator.
+ *
+ * Connects to the in-process broker in sim_mqtt.h instead of a socket (which
+ * forwards to a real broker at the server set, see sim_net.h). Limits
+ * that matter to the firmware are kept: publishes that do not fit the buffer
+ * fail, and incoming messages are only delivered from `loop()`. The CONNECT
+ * goes out, and the CONNACK and every packet for the device come in, through
+ * the Client, so a client that watches or encrypts the bytes sees them.
+ */
+#ifndef SIM_PUBSUBCLIENT_H
+#define SIM_PUBSUBCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define MQTT_MAX_PACKET_SIZE 256
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+public:
+  explicit PubSubClient(Client& client) : client(&client) {}
+  PubSubClient& setServer(const char* domain, uint16_t port) {
+    this->domain = domain ? domain : "";
+    this->port = port;
+    return *this;
+  }
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+  PubSubClient& setClient(Client& client) { this->client = &client; return *this; }
+  PubSubClient& setKeepAlive(uint16_t keepAlive) { return *this; }
+  PubSubClient& setSocketTimeout(uint16_t timeout) { return *this; }
+  bool setBufferSize(uint16_t size);
+  uint16_t getBufferSize() { return bufferSize; }
+
+  bool connect(const char* id);
+  bool connect(const char* id, const char* user, const char* pass);
+  bool connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos,
+               bool willRetain, const char* willMessage, bool cleanSession = true);
+  void disconnect();
+  bool connected();
+  int state() { return currentState; }
+
+  bool publish(const char* topic, const char* payload);
+  bool publish(const char* topic, const char* payload, bool retained);
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length);
+  bool publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained);
+  bool subscribe(const char* topic, uint8_t qos = 0);
+  bool unsubscribe(const char* topic);
+  bool loop();
+
+private:
+  bool read_packet(uint8_t& header, std::vector<uint8_t>& body);
+
+  Client* client;
+  std::string domain;
+  uint16_t port = 0;
+  std::function<void(char*, uint8_t*, unsigned int)> callback;
+  uint16_t bufferSize = MQTT_MAX_PACKET_SIZE;
+  int currentState = MQTT_DISCONNECTED;
+  int session = -1;
+};
+
+#endif // SIM_PUBSUBCLIENT_H
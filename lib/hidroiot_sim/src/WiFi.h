@@ -0,0 +1,94 @@
+/**
+ * @file WiFi.h
+ * @brief The ESP32 WiFi API for the native simulator.
+ *
+ * The station associates as soon as `begin()` is called. The link can be
+ * dropped from a scenario (see sim_plant.h) to exercise reconnect paths.
+ */
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "sim_mqtt.h"
+#include "sim_tls.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+/**
+ * @class WiFiClient
+ * @brief A TCP client. The simulated `PubSubClient` publishes to the in-process
+ * broker directly; its CONNECT and the packets the broker sends (CONNACK, PUBLISH,
+ * SUBACK) go through this client, as over the socket. When the broker listens with
+ * TLS (see sim_tls.h) they go through its TLS server instead. The connection opens
+ * at once, so the timeout of `connect()` is ignored.
+ */
+class WiFiClient : public Client {
+public:
+  int connect(IPAddress ip, uint16_t port) override { return open_connection(); }
+  int connect(const char* host, uint16_t port) override { return open_connection(); }
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) { return open_connection(); }
+  int connect(const char* host, uint16_t port, int32_t timeoutMs) { return open_connection(); }
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!open) return 0;
+    return sim_tls_enabled() ? sim_tls_client_write(buffer, size) : size;
+  }
+  int available() override { return open ? received() : 0; }
+  int read() override { return open ? next_byte() : -1; }
+  int read(uint8_t* buffer, size_t size) override {
+    size_t n = 0;
+    // Not through the virtual read(), which a subclass may implement with this one.
+    while (open && n < size && received() > 0) buffer[n++] = (uint8_t)next_byte();
+    return open ? (int)n : -1;
+  }
+  int peek() override { return -1; }
+  void flush() override {}
+  void stop() override {
+    if (open && sim_tls_enabled()) sim_tls_close();
+    open = false;
+  }
+  uint8_t connected() override { return open; }
+  operator bool() override { return open; }
+
+private:
+  int open_connection() {
+    if (open) stop();
+    open = sim_mqtt_accept();
+    if (open && sim_tls_enabled()) sim_tls_open();
+    return open;
+  }
+  int received() { return sim_tls_enabled() ? sim_tls_client_available() : sim_mqtt_client_available(); }
+  int next_byte() { return sim_tls_enabled() ? sim_tls_client_read() : sim_mqtt_client_read(); }
+  bool open = false;
+};
+
+class WiFiClass {
+public:
+  wl_status_t status();
+  wifi_mode_t mode(wifi_mode_t mode) { return currentMode = mode; }
+  wl_status_t begin(const char* ssid, const char* password = nullptr);
+  bool disconnect(bool wifiOff = false);
+  bool reconnect();
+  void setAutoReconnect(bool autoReconnect) {}
+  IPAddress localIP() { return IPAddress(10, 0, 0, 2); }
+  String macAddress() { return String("A1:B2:C3:D4:E5:F6"); }
+  int8_t RSSI() { return -60; }
+
+private:
+  wifi_mode_t currentMode = WIFI_OFF;
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
@@ -0,0 +1,15 @@
+/**
+ * @file esp_attr.h
+ * @brief The IDF memory placement attributes for the native simulator.
+ *
+ * Memory that survives a reset is an ordinary variable here: the simulator
+ * ends at a restart, so it is invalid at every start.
+ */
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+#ifndef RTC_NOINIT_ATTR
+  #define RTC_NOINIT_ATTR
+#endif
+
+#endif // SIM_ESP_ATTR_H
@@ -0,0 +1,31 @@
+/**
+ * @file esp_ota_ops.h
+ * @brief The IDF OTA API for the native simulator.
+ *
+ * Updates are written to the app partition the running one is not, and the
+ * boot selection is kept with the rest of the flash in `--nvs` files. The
+ * simulator always runs its own program, whichever partition is selected, and
+ * does not check the image format, so any file can stand in for an image.
+ */
+#ifndef SIM_ESP_OTA_OPS_H
+#define SIM_ESP_OTA_OPS_H
+
+#include <esp_partition.h>
+
+typedef uint32_t esp_ota_handle_t;
+
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+#define OTA_SIZE_UNKNOWN 0xffffffff
+#define OTA_WITH_SEQUENTIAL_WRITES 0xfffffffe
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+const esp_partition_t* esp_ota_get_boot_partition();
+const esp_partition_t* esp_ota_get_running_partition();
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback();
+
+#endif // SIM_ESP_OTA_OPS_H
@@ -0,0 +1,26 @@
+/**
+ * @file esp_system.h
+ * @brief The IDF reset reason API for the native simulator.
+ *
+ * Every simulated run starts from power-on; a firmware restart ends the run.
+ */
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+typedef enum {
+  ESP_RST_UNKNOWN,
+  ESP_RST_POWERON,
+  ESP_RST_EXT,
+  ESP_RST_SW,
+  ESP_RST_PANIC,
+  ESP_RST_INT_WDT,
+  ESP_RST_TASK_WDT,
+  ESP_RST_WDT,
+  ESP_RST_DEEPSLEEP,
+  ESP_RST_BROWNOUT,
+  ESP_RST_SDIO
+} esp_reset_reason_t;
+
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+#endif // SIM_ESP_SYSTEM_H
@@ -0,0 +1,35 @@
+/**
+ * @file sockets.h
+ * @brief The lwIP socket API for the native simulator, on the host's sockets.
+ *
+ * Servers only become reachable when the run asks for it (`--http <port>`):
+ * `lwip_bind()` then binds to that port on the loopback interface, whatever
+ * port the firmware asked for, and otherwise fails with EADDRNOTAVAIL.
+ */
+#ifndef SIM_LWIP_SOCKETS_H
+#define SIM_LWIP_SOCKETS_H
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int sim_socket_bind(int fd, const struct sockaddr* address, socklen_t length);
+
+inline int lwip_socket(int domain, int type, int protocol) { return socket(domain, type, protocol); }
+inline int lwip_bind(int fd, const struct sockaddr* address, socklen_t length) {
+  return sim_socket_bind(fd, address, length);
+}
+inline int lwip_listen(int fd, int backlog) { return listen(fd, backlog); }
+inline int lwip_accept(int fd, struct sockaddr* address, socklen_t* length) { return accept(fd, address, length); }
+inline int lwip_recv(int fd, void* buffer, size_t size, int flags) { return (int)recv(fd, buffer, size, flags); }
+inline int lwip_send(int fd, const void* data, size_t size, int flags) { return (int)send(fd, data, size, flags); }
+inline int lwip_close(int fd) { return close(fd); }
+inline int lwip_fcntl(int fd, int command, int value) { return fcntl(fd, command, value); }
+inline int lwip_setsockopt(int fd, int level, int name, const void* value, socklen_t length) {
+  return setsockopt(fd, level, name, value, length);
+}
+
+#endif // SIM_LWIP_SOCKETS_H
@@ -0,0 +1,18 @@
+/**
+ * @file entropy.h
+ * @brief The mbedTLS 2.x entropy API for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_ENTROPY_H
+#define SIM_MBEDTLS_ENTROPY_H
+
+#include <stddef.h>
+
+typedef struct mbedtls_entropy_context {
+  int unused;
+} mbedtls_entropy_context;
+
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx);
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx);
+int mbedtls_entropy_func(void* data, unsigned char* output, size_t len);
+
+#endif // SIM_MBEDTLS_ENTROPY_H
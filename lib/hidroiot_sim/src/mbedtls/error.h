@@ -0,0 +1,12 @@
+/**
+ * @file error.h
+ * @brief The mbedTLS 2.x error description API for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_ERROR_H
+#define SIM_MBEDTLS_ERROR_H
+
+#include <stddef.h>
+
+void mbedtls_strerror(int errnum, char* buffer, size_t buflen);
+
+#endif // SIM_MBEDTLS_ERROR_H
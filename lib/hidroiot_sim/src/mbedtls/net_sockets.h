@@ -0,0 +1,11 @@
+/**
+ * @file net_sockets.h
+ * @brief The mbedTLS 2.x network error codes for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_NET_SOCKETS_H
+#define SIM_MBEDTLS_NET_SOCKETS_H
+
+#define MBEDTLS_ERR_NET_SEND_FAILED -0x004E
+#define MBEDTLS_ERR_NET_CONN_RESET -0x0050
+
+#endif // SIM_MBEDTLS_NET_SOCKETS_H
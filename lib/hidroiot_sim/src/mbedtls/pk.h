@@ -0,0 +1,21 @@
+/**
+ * @file pk.h
+ * @brief The mbedTLS 2.x public key API for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_PK_H
+#define SIM_MBEDTLS_PK_H
+
+#include <stddef.h>
+
+#define MBEDTLS_ERR_PK_BAD_INPUT_DATA -0x3E80
+#define MBEDTLS_ERR_ASN1_BUF_TOO_SMALL -0x006C
+
+typedef struct mbedtls_pk_context {
+  void* key; ///< The OpenSSL EVP_PKEY, owned by the certificate.
+} mbedtls_pk_context;
+
+/// @brief Writes the SubjectPublicKeyInfo at the end of `buf`.
+/// @return Its length, or a negative error code.
+int mbedtls_pk_write_pubkey_der(mbedtls_pk_context* ctx, unsigned char* buf, size_t size);
+
+#endif // SIM_MBEDTLS_PK_H
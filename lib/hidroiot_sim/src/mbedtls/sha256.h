@@ -0,0 +1,12 @@
+/**
+ * @file sha256.h
+ * @brief The mbedTLS 2.x SHA-256 API for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_SHA256_H
+#define SIM_MBEDTLS_SHA256_H
+
+#include <stddef.h>
+
+int mbedtls_sha256_ret(const unsigned char* input, size_t ilen, unsigned char output[32], int is224);
+
+#endif // SIM_MBEDTLS_SHA256_H
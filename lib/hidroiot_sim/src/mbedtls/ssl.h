@@ -0,0 +1,116 @@
+/**
+ * @file ssl.h
+ * @brief The part of the mbedTLS 2.x TLS API that src/mqtt_tls.cpp uses, for
+ * the native simulator.
+ *
+ * The calls are carried out by OpenSSL (sim_mbedtls.cpp), so the firmware's
+ * handshake loop, record layer, certificate callback and session handling run
+ * unchanged against the simulated broker's TLS listener (see sim_tls.h). The
+ * structures only keep the fields the firmware reads; like mbedTLS 2.28, TLS
+ * 1.2 is negotiated.
+ *
+ * Differences that the firmware cannot see: the certificate callback is called
+ * once the handshake is done instead of during it, and a resumed session
+ * reports no verification flags (the firmware only keeps trusted sessions).
+ */
+#ifndef SIM_MBEDTLS_SSL_H
+#define SIM_MBEDTLS_SSL_H
+
+#include "ctr_drbg.h"
+#include "entropy.h"
+#include "net_sockets.h"
+#include "pk.h"
+#include "x509_crt.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_SSL_SESSION_TICKETS
+
+#define MBEDTLS_ERR_SSL_TIMEOUT -0x6800
+#define MBEDTLS_ERR_SSL_WANT_WRITE -0x6880
+#define MBEDTLS_ERR_SSL_WANT_READ -0x6900
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL -0x6A00
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA -0x7100
+#define MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE -0x7780
+#define MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY -0x7880
+#define MBEDTLS_ERR_SSL_ALLOC_FAILED -0x7F00
+
+#define MBEDTLS_SSL_IS_CLIENT 0
+#define MBEDTLS_SSL_TRANSPORT_STREAM 0
+#define MBEDTLS_SSL_PRESET_DEFAULT 0
+#define MBEDTLS_SSL_VERIFY_NONE 0
+#define MBEDTLS_SSL_VERIFY_OPTIONAL 1
+#define MBEDTLS_SSL_VERIFY_REQUIRED 2
+#define MBEDTLS_SSL_SESSION_TICKETS_DISABLED 0
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED 1
+
+/// @brief Handshake states; the steps in between are not told apart.
+typedef enum {
+  MBEDTLS_SSL_HELLO_REQUEST = 0,
+  MBEDTLS_SSL_CLIENT_HELLO = 1,
+  MBEDTLS_SSL_HANDSHAKE_OVER = 16
+} mbedtls_ssl_states;
+
+typedef int mbedtls_ssl_send_t(void* ctx, const unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_t(void* ctx, unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_timeout_t(void* ctx, unsigned char* buf, size_t len, uint32_t timeout);
+
+/**
+ * @struct mbedtls_ssl_session
+ * @brief An established session, as offered for resumption.
+ */
+typedef struct mbedtls_ssl_session {
+  unsigned char master[48]; ///< The master secret; a resumed handshake keeps it.
+  void* session;            ///< The OpenSSL SSL_SESSION.
+} mbedtls_ssl_session;
+
+typedef struct mbedtls_ssl_config {
+  int authmode;
+  int sessionTickets;
+  mbedtls_x509_crt* caChain;
+  int (*f_vrfy)(void*, mbedtls_x509_crt*, int, uint32_t*);
+  void* p_vrfy;
+} mbedtls_ssl_config;
+
+typedef struct mbedtls_ssl_context {
+  int state; ///< One of mbedtls_ssl_states.
+  const mbedtls_ssl_config* conf;
+  mbedtls_ssl_send_t* f_send;
+  mbedtls_ssl_recv_t* f_recv;
+  void* p_bio;
+  uint32_t verifyResult;
+  void* sim; ///< The OpenSSL connection and its state, see sim_mbedtls.cpp.
+} mbedtls_ssl_context;
+
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf);
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf);
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset);
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode);
+void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config* conf, mbedtls_x509_crt* ca_chain, mbedtls_x509_crl* ca_crl);
+void mbedtls_ssl_conf_verify(mbedtls_ssl_config* conf, int (*f_vrfy)(void*, mbedtls_x509_crt*, int, uint32_t*),
+                             void* p_vrfy);
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng);
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int use_tickets);
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl);
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl);
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf);
+int mbedtls_ssl_session_reset(mbedtls_ssl_context* ssl);
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname);
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* p_bio, mbedtls_ssl_send_t* f_send,
+                         mbedtls_ssl_recv_t* f_recv, mbedtls_ssl_recv_timeout_t* f_recv_timeout);
+int mbedtls_ssl_handshake_step(mbedtls_ssl_context* ssl);
+uint32_t mbedtls_ssl_get_verify_result(const mbedtls_ssl_context* ssl);
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len);
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len);
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl);
+int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl);
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session);
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session);
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session);
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session);
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t buf_len, size_t* olen);
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len);
+
+#endif // SIM_MBEDTLS_SSL_H
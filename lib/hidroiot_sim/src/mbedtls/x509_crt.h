@@ -0,0 +1,40 @@
+/**
+ * @file x509_crt.h
+ * @brief The mbedTLS 2.x certificate API for the native simulator, see ssl.h.
+ */
+#ifndef SIM_MBEDTLS_X509_CRT_H
+#define SIM_MBEDTLS_X509_CRT_H
+
+#include "pk.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_X509_BADCERT_EXPIRED 0x01
+#define MBEDTLS_X509_BADCERT_REVOKED 0x02
+#define MBEDTLS_X509_BADCERT_CN_MISMATCH 0x04
+#define MBEDTLS_X509_BADCERT_NOT_TRUSTED 0x08
+#define MBEDTLS_X509_BADCERT_FUTURE 0x0200
+#define MBEDTLS_X509_BADCERT_OTHER 0x0100
+
+#define MBEDTLS_ERR_X509_INVALID_FORMAT -0x2180
+#define MBEDTLS_ERR_X509_CERT_VERIFY_FAILED -0x2700
+
+/**
+ * @struct mbedtls_x509_crt
+ * @brief A certificate chain. Only the fields the firmware reads are kept.
+ */
+typedef struct mbedtls_x509_crt {
+  mbedtls_pk_context pk;
+  struct mbedtls_x509_crt* next;
+  void* x509; ///< The OpenSSL X509.
+} mbedtls_x509_crt;
+
+typedef struct mbedtls_x509_crl mbedtls_x509_crl;
+
+void mbedtls_x509_crt_init(mbedtls_x509_crt* crt);
+void mbedtls_x509_crt_free(mbedtls_x509_crt* crt);
+/// @brief Appends the PEM certificates in `buf` (NUL counted in `buflen`) to the chain.
+int mbedtls_x509_crt_parse(mbedtls_x509_crt* chain, const unsigned char* buf, size_t buflen);
+int mbedtls_x509_crt_verify_info(char* buf, size_t size, const char* prefix, uint32_t flags);
+
+#endif // SIM_MBEDTLS_X509_CRT_H
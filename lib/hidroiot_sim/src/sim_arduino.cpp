@@ -0,0 +1,594 @@
+/**
+ * @file sim_arduino.cpp
+ * @brief Implements the Arduino core, WiFi, NVS and sensor library stand-ins.
+ *
+ * Blocking library calls advance the virtual clock by roughly what they take
+ * on the device (e.g. the DS18B20's 750 ms conversion), so loop timing in the
+ * simulator resembles the real one.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <esp_ota_ops.h>
+#include <lwip/sockets.h>
+#include <NewPing.h>
+#include <DallasTemperature.h>
+#include <DHT.h>
+#include <PZEM004Tv30.h>
+#include "sim_board.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_time.h"
+#include <algorithm>
+#include <map>
+#include <signal.h>
+#include <vector>
+
+// --- Module-Private (Static) Variables ---
+
+static const int NUM_GPIO = 40;
+static uint8_t gpioLevels[NUM_GPIO];
+static bool serialEcho = false;
+static bool wifiAvailable = true;
+static bool wifiStarted = false;
+static uint32_t randomState = 0x2545F491;
+/// @brief The loopback port firmware servers are bound to; 0 keeps them unreachable.
+static int httpPort = 0;
+/// @brief Set by `configTime()`; the clock is synchronized at the first check with WiFi up.
+static bool sntpStarted = false;
+static bool clockSynced = false;
+/// @brief The wall-clock time at power-on once SNTP has set the clock: 2026-01-01 06:00 UTC.
+static const time_t SIM_WALL_CLOCK_AT_BOOT = 1767247200;
+
+/// @brief NVS contents, keyed by "namespace/key".
+static std::map<std::string, std::vector<uint8_t> > nvs;
+static unsigned long nvsWrites = 0;
+
+/**
+ * @struct SimPartition
+ * @brief One partition of the default partition table and its contents.
+ */
+struct SimPartition {
+  esp_partition_t info;
+  const char* fileKey;        ///< The pseudo key under which `--nvs` files hold the contents.
+  std::vector<uint8_t> data;
+  bool used;                  ///< App partitions are only saved once something was written to them.
+};
+
+static SimPartition partitions[] = {
+    {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000, 0x140000, "app0", false},
+     "partition/app0", std::vector<uint8_t>(0x140000, 0xFF), false},
+    {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x150000, 0x140000, "app1", false},
+     "partition/app1", std::vector<uint8_t>(0x140000, 0xFF), false},
+    {{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x290000, 0x170000, "spiffs", false},
+     "partition/spiffs", std::vector<uint8_t>(0x170000, 0xFF), true}};
+static const int NUM_PARTITIONS = sizeof(partitions) / sizeof(partitions[0]);
+static const int NUM_APP_PARTITIONS = 2;
+static const int DATA_PARTITION = 2;
+static const size_t FLASH_SECTOR_SIZE = 4096;
+static unsigned long partitionErases = 0;
+/// @brief The app partition selected for the next boot, and the one that was booted.
+static int bootPartition = 0;
+static int runningPartition = 0;
+/// @brief The pseudo key under which `--nvs` files hold the boot selection.
+static const char* BOOT_FILE_KEY = "otadata/boot";
+
+/**
+ * @struct SimOtaWrite
+ * @brief The update being written by `esp_ota_write()`.
+ */
+struct SimOtaWrite {
+  esp_ota_handle_t handle; ///< 0 if none is open.
+  int partition;
+  size_t written;
+  size_t erased;           ///< Bytes erased so far; sequential writes erase as they go.
+};
+
+static SimOtaWrite otaWrite = {0, 0, 0, 0};
+static esp_ota_handle_t nextOtaHandle = 1;
+
+// Device timings that block the caller.
+static const uint64_t DS18B20_CONVERSION_US = 750000;
+static const uint64_t DS18B20_READ_US = 15000;
+static const uint64_t DHT_READ_US = 5000;
+static const unsigned long DHT_MIN_INTERVAL_MS = 2000;
+static const uint64_t PZEM_UPDATE_US = 35000;
+static const unsigned long PZEM_MIN_INTERVAL_MS = 200;
+static const uint64_t ADC_READ_US = 10;
+
+// --- Time ---
+
+unsigned long millis() { return (unsigned long)(sim_now_us() / 1000); }
+unsigned long micros() { return (unsigned long)sim_now_us(); }
+void delay(unsigned long ms) { sim_advance_us((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { sim_advance_us(us); }
+void yield() {}
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2,
+                const char* server3) {
+  sntpStarted = true;
+}
+
+int sim_gettimeofday(struct timeval* tv) {
+  if (sntpStarted && !clockSynced) clockSynced = WiFi.status() == WL_CONNECTED;
+  uint64_t now = sim_now_us();
+  tv->tv_sec = (time_t)(now / 1000000) + (clockSynced ? SIM_WALL_CLOCK_AT_BOOT : 0);
+  tv->tv_usec = (suseconds_t)(now % 1000000);
+  return 0;
+}
+
+// --- GPIO & ADC ---
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < NUM_GPIO) gpioLevels[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NUM_GPIO ? gpioLevels[pin] : LOW;
+}
+
+uint16_t analogRead(uint8_t pin) {
+  sim_advance_us(ADC_READ_US);
+  return sim_plant_adc(pin);
+}
+
+void analogReadResolution(uint8_t bits) {}
+void analogSetWidth(uint8_t bits) {}
+void analogSetAttenuation(int attenuation) {}
+
+long random(long max) {
+  return max > 0 ? random(0, max) : 0;
+}
+
+long random(long min, long max) {
+  if (max <= min) return min;
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return min + (long)(randomState % (uint32_t)(max - min));
+}
+
+void randomSeed(unsigned long seed) {
+  randomState = seed ? (uint32_t)seed : 1;
+}
+
+// --- Print & Serial ---
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[512];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  return write((const uint8_t*)buffer, min((size_t)len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (uart == 0 && serialEcho) fputc(c, stdout);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  if (uart == 0 && serialEcho) fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+
+// --- ESP ---
+
+EspClass ESP;
+
+void EspClass::restart() {
+  throw SimRestart();
+}
+
+uint32_t EspClass::getFreeHeap() { return 182000; }
+uint32_t EspClass::getMinFreeHeap() { return 171000; }
+uint32_t EspClass::getMaxAllocHeap() { return 110580; }
+uint32_t EspClass::getCycleCount() { return (uint32_t)(sim_now_us() * getCpuFreqMHz()); }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return 5120;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name) {
+  static int loopTask;
+  return strcmp(name, "loopTask") == 0 ? &loopTask : nullptr;
+}
+
+// --- WiFi ---
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::status() {
+  return wifiStarted && wifiAvailable ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* password) {
+  wifiStarted = true;
+  return status();
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  wifiStarted = false;
+  return true;
+}
+
+bool WiFiClass::reconnect() {
+  wifiStarted = true;
+  return status() == WL_CONNECTED;
+}
+
+// --- Preferences ---
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  space = name;
+  this->readOnly = readOnly;
+  return true;
+}
+
+bool Preferences::clear() {
+  if (readOnly) return false;
+  std::string prefix = space + "/";
+  for (std::map<std::string, std::vector<uint8_t> >::iterator it = nvs.begin(); it != nvs.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) {
+      nvs.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  nvsWrites++;
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (readOnly) return false;
+  nvsWrites++;
+  return nvs.erase(space + "/" + key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  return nvs.count(space + "/" + key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (readOnly || key == nullptr || strlen(key) > 15) return 0;
+  const uint8_t* bytes = (const uint8_t*)value;
+  nvs[space + "/" + key].assign(bytes, bytes + len);
+  nvsWrites++;
+  return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.find(space + "/" + key);
+  if (it == nvs.end() || it->second.size() > maxLen) return 0;
+  if (!it->second.empty()) memcpy(buf, &it->second[0], it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.find(space + "/" + key);
+  return it == nvs.end() ? 0 : it->second.size();
+}
+
+// --- Partitions ---
+
+/**
+ * @brief Returns the simulated partition behind a partition pointer, or nullptr.
+ */
+static SimPartition* find_partition(const esp_partition_t* partition) {
+  for (int i = 0; i < NUM_PARTITIONS; i++) {
+    if (partition == &partitions[i].info) return &partitions[i];
+  }
+  return nullptr;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+  for (int i = 0; i < NUM_PARTITIONS; i++) {
+    const esp_partition_t& info = partitions[i].info;
+    if (info.type != type || (subtype != ESP_PARTITION_SUBTYPE_ANY && info.subtype != subtype)) continue;
+    if (label != nullptr && strcmp(label, info.label) != 0) continue;
+    return &info;
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+  SimPartition* sim = find_partition(partition);
+  if (sim == nullptr || src_offset + size > sim->data.size()) return ESP_ERR_INVALID_SIZE;
+  memcpy(dst, &sim->data[src_offset], size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+  SimPartition* sim = find_partition(partition);
+  if (sim == nullptr || dst_offset + size > sim->data.size()) return ESP_ERR_INVALID_SIZE;
+  const uint8_t* bytes = (const uint8_t*)src;
+  for (size_t i = 0; i < size; i++) sim->data[dst_offset + i] &= bytes[i]; // NOR: bits can only be cleared.
+  sim->used = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  SimPartition* sim = find_partition(partition);
+  if (sim == nullptr || offset % FLASH_SECTOR_SIZE != 0 || size % FLASH_SECTOR_SIZE != 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (offset + size > sim->data.size()) return ESP_ERR_INVALID_SIZE;
+  memset(&sim->data[offset], 0xFF, size);
+  if (sim == &partitions[DATA_PARTITION]) partitionErases += size / FLASH_SECTOR_SIZE;
+  return ESP_OK;
+}
+
+// --- OTA ---
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle) {
+  SimPartition* sim = find_partition(partition);
+  if (sim == nullptr || partition->type != ESP_PARTITION_TYPE_APP) return ESP_ERR_INVALID_ARG;
+  if (sim - partitions == runningPartition || otaWrite.handle != 0) return ESP_ERR_INVALID_STATE;
+  otaWrite.handle = nextOtaHandle++;
+  otaWrite.partition = sim - partitions;
+  otaWrite.written = 0;
+  otaWrite.erased = 0;
+  if (image_size != OTA_WITH_SEQUENTIAL_WRITES) {
+    size_t size = image_size == OTA_SIZE_UNKNOWN ? partition->size : image_size;
+    otaWrite.erased = (size + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+    if (otaWrite.erased > partition->size) return ESP_ERR_INVALID_SIZE;
+    esp_partition_erase_range(partition, 0, otaWrite.erased);
+  }
+  *out_handle = otaWrite.handle;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+  if (handle == 0 || handle != otaWrite.handle) return ESP_ERR_INVALID_ARG;
+  const esp_partition_t* partition = &partitions[otaWrite.partition].info;
+  if (otaWrite.written + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  while (otaWrite.erased < otaWrite.written + size) {
+    esp_partition_erase_range(partition, otaWrite.erased, FLASH_SECTOR_SIZE);
+    otaWrite.erased += FLASH_SECTOR_SIZE;
+  }
+  esp_err_t result = esp_partition_write(partition, otaWrite.written, data, size);
+  if (result == ESP_OK) otaWrite.written += size;
+  return result;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+  if (handle == 0 || handle != otaWrite.handle) return ESP_ERR_INVALID_ARG;
+  otaWrite.handle = 0;
+  return otaWrite.written > 0 ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+  if (handle == 0 || handle != otaWrite.handle) return ESP_ERR_INVALID_ARG;
+  otaWrite.handle = 0;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+  SimPartition* sim = find_partition(partition);
+  if (sim == nullptr || partition->type != ESP_PARTITION_TYPE_APP) return ESP_ERR_INVALID_ARG;
+  bootPartition = sim - partitions;
+  return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+  return &partitions[bootPartition].info;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+  return &partitions[runningPartition].info;
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+  SimPartition* from = find_partition(start_from ? start_from : &partitions[runningPartition].info);
+  if (from == nullptr || from->info.type != ESP_PARTITION_TYPE_APP) return nullptr;
+  return &partitions[((from - partitions) + 1) % NUM_APP_PARTITIONS].info;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+  return ESP_OK;
+}
+
+// --- Sensor libraries ---
+
+unsigned int NewPing::ping_cm(unsigned int maxCm) {
+  unsigned int limit = maxCm ? maxCm : maxCmDistance;
+  unsigned int cm = sim_plant_ping_cm();
+  if (cm == 0 || cm > limit) {
+    sim_advance_us((uint64_t)limit * 58); // Waits out the echo timeout.
+    return NO_ECHO;
+  }
+  sim_advance_us((uint64_t)cm * 58 + 500);
+  return cm;
+}
+
+void DallasTemperature::requestTemperatures() {
+  sim_advance_us(DS18B20_CONVERSION_US);
+}
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+  sim_advance_us(DS18B20_READ_US);
+  return index == 0 ? sim_plant_probe_temp_c() : DEVICE_DISCONNECTED_C;
+}
+
+/// @brief The DHT library reads the sensor at most every 2 s and caches the result.
+static unsigned long dhtLastRead = 0;
+static bool dhtRead = false;
+static float dhtTemp = NAN;
+static float dhtHumidity = NAN;
+
+static void dht_update() {
+  if (dhtRead && millis() - dhtLastRead < DHT_MIN_INTERVAL_MS) return;
+  sim_advance_us(DHT_READ_US);
+  dhtRead = true;
+  dhtLastRead = millis();
+  dhtTemp = sim_plant_air_temp_c();
+  dhtHumidity = sim_plant_humidity();
+}
+
+float DHT::readTemperature(bool fahrenheit) {
+  dht_update();
+  return fahrenheit ? dhtTemp * 1.8f + 32 : dhtTemp;
+}
+
+float DHT::readHumidity() {
+  dht_update();
+  return dhtHumidity;
+}
+
+/// @brief The PZEM library refreshes all registers in one Modbus transaction, at most every 200 ms.
+static unsigned long pzemLastUpdate = 0;
+static bool pzemRead = false;
+static float pzemValues[6];
+
+static void pzem_update() {
+  if (pzemRead && millis() - pzemLastUpdate < PZEM_MIN_INTERVAL_MS) return;
+  sim_advance_us(PZEM_UPDATE_US);
+  pzemRead = true;
+  pzemLastUpdate = millis();
+  pzemValues[0] = sim_plant_mains_v();
+  pzemValues[1] = sim_plant_load_a();
+  pzemValues[2] = sim_plant_load_w();
+  pzemValues[3] = (float)floor(sim_plant_state().energyWh); // The meter counts whole Wh.
+  pzemValues[4] = 50.0f;
+  pzemValues[5] = sim_plant_power_factor();
+}
+
+float PZEM004Tv30::voltage() { pzem_update(); return pzemValues[0]; }
+float PZEM004Tv30::current() { pzem_update(); return pzemValues[1]; }
+float PZEM004Tv30::power() { pzem_update(); return pzemValues[2]; }
+float PZEM004Tv30::energy() { pzem_update(); return pzemValues[3]; }
+float PZEM004Tv30::frequency() { pzem_update(); return pzemValues[4]; }
+float PZEM004Tv30::pf() { pzem_update(); return pzemValues[5]; }
+bool PZEM004Tv30::resetEnergy() { return true; }
+
+// --- Board controls ---
+
+void sim_board_set_serial_echo(bool enabled) {
+  serialEcho = enabled;
+}
+
+void sim_board_set_wifi_available(bool available) {
+  wifiAvailable = available;
+  sim_mqtt_set_available(available);
+}
+
+bool sim_board_load_nvs(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  uint32_t keyLen, valueLen;
+  while (fread(&keyLen, sizeof(keyLen), 1, file) == 1 && keyLen < 64) {
+    std::string key(keyLen, '\0');
+    if (fread(&key[0], 1, keyLen, file) != keyLen || fread(&valueLen, sizeof(valueLen), 1, file) != 1) break;
+    std::vector<uint8_t> value(valueLen);
+    if (valueLen && fread(&value[0], 1, valueLen, file) != valueLen) break;
+    bool isPartition = false;
+    for (int i = 0; i < NUM_PARTITIONS; i++) {
+      if (key != partitions[i].fileKey) continue;
+      isPartition = true;
+      if (value.size() == partitions[i].data.size()) {
+        partitions[i].data = value;
+        partitions[i].used = true;
+      }
+    }
+    if (key == BOOT_FILE_KEY && value.size() == 1 && value[0] < NUM_APP_PARTITIONS) {
+      bootPartition = value[0];
+    } else if (!isPartition) {
+      nvs[key] = value;
+    }
+  }
+  fclose(file);
+  // The bootloader starts whichever image was selected when the board went down.
+  runningPartition = bootPartition;
+  return true;
+}
+
+void sim_board_provision(const char* space, const char* key, const char* value) {
+  nvs[std::string(space) + "/" + key].assign(value, value + strlen(value) + 1);
+}
+
+/**
+ * @brief Writes one key and value in the `--nvs` file format.
+ */
+static void save_record(FILE* file, const std::string& key, const std::vector<uint8_t>& value) {
+  uint32_t keyLen = key.size(), valueLen = value.size();
+  fwrite(&keyLen, sizeof(keyLen), 1, file);
+  fwrite(key.data(), 1, keyLen, file);
+  fwrite(&valueLen, sizeof(valueLen), 1, file);
+  if (valueLen) fwrite(&value[0], 1, valueLen, file);
+}
+
+bool sim_board_save_nvs(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) return false;
+  for (std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.begin(); it != nvs.end(); ++it) {
+    save_record(file, it->first, it->second);
+  }
+  for (int i = 0; i < NUM_PARTITIONS; i++) {
+    if (partitions[i].used) save_record(file, partitions[i].fileKey, partitions[i].data);
+  }
+  if (bootPartition != 0) save_record(file, BOOT_FILE_KEY, std::vector<uint8_t>(1, (uint8_t)bootPartition));
+  return fclose(file) == 0;
+}
+
+bool sim_board_load_firmware(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return false;
+  SimPartition& app = partitions[runningPartition];
+  std::fill(app.data.begin(), app.data.end(), 0xFF);
+  size_t size = fread(&app.data[0], 1, app.data.size(), file);
+  bool fits = fgetc(file) == EOF;
+  fclose(file);
+  app.used = true;
+  return size > 0 && fits;
+}
+
+bool sim_board_save_boot_image(const char* path, size_t size) {
+  const SimPartition& app = partitions[bootPartition];
+  if (size > app.data.size()) return false;
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) return false;
+  fwrite(&app.data[0], 1, size, file);
+  return fclose(file) == 0;
+}
+
+unsigned long sim_board_nvs_writes() {
+  return nvsWrites;
+}
+
+unsigned long sim_board_flash_erases() {
+  return partitionErases;
+}
+
+void sim_board_set_http_port(int port) {
+  httpPort = port;
+  // A scraper that hangs up early must not kill the run.
+  if (port != 0) signal(SIGPIPE, SIG_IGN);
+}
+
+// --- lwIP sockets ---
+
+int sim_socket_bind(int fd, const struct sockaddr* address, socklen_t length) {
+  if (httpPort == 0 || address->sa_family != AF_INET) {
+    errno = EADDRNOTAVAIL;
+    return -1;
+  }
+  struct sockaddr_in local;
+  memcpy(&local, address, sizeof(local));
+  local.sin_port = htons(httpPort);
+  local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return bind(fd, (const struct sockaddr*)&local, sizeof(local));
+}
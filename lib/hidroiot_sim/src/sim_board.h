@@ -0,0 +1,90 @@
+/**
+ * @file sim_board.h
+ * @brief Board-level controls of the native simulator: serial output, network
+ * link, restarts and the contents of flash.
+ */
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include <exception>
+#include <stddef.h>
+
+/**
+ * @class SimRestart
+ * @brief Thrown by `ESP.restart()`. A restart ends the simulation run, because
+ * the firmware's static state cannot be reset within one process.
+ */
+class SimRestart : public std::exception {
+public:
+  const char* what() const noexcept override { return "ESP.restart()"; }
+};
+
+/**
+ * @brief Echoes the firmware's `Serial` output to stdout.
+ * @param enabled true to echo.
+ */
+void sim_board_set_serial_echo(bool enabled);
+
+/**
+ * @brief Brings the WiFi link (and with it the broker) up or down.
+ * @param available true if the access point is reachable.
+ */
+void sim_board_set_wifi_available(bool available);
+
+/**
+ * @brief Loads the simulated NVS, partitions and boot selection from a file written by `sim_board_save_nvs()`.
+ * @param path The file to read.
+ * @return true if the file was read; a missing file leaves the flash empty.
+ */
+bool sim_board_load_nvs(const char* path);
+
+/**
+ * @brief Saves the simulated NVS, partitions and boot selection to a file.
+ * @param path The file to write.
+ * @return true on success.
+ */
+bool sim_board_save_nvs(const char* path);
+
+/**
+ * @brief Writes a string into NVS the way factory provisioning would; not counted as a write.
+ * @param space The NVS namespace.
+ * @param key The key.
+ * @param value The string.
+ */
+void sim_board_provision(const char* space, const char* key, const char* value);
+
+/**
+ * @brief Puts a firmware image into the running app partition, as flashing it over serial would.
+ * Call after `sim_board_load_nvs()`, which decides which partition runs.
+ * @param path The image file.
+ * @return true if the file was read and fits the partition.
+ */
+bool sim_board_load_firmware(const char* path);
+
+/**
+ * @brief Saves the start of the app partition selected for the next boot, e.g. to compare an updated image.
+ * @param path The file to write.
+ * @param size The number of bytes to save.
+ * @return true on success.
+ */
+bool sim_board_save_boot_image(const char* path, size_t size);
+
+/**
+ * @brief Returns the number of NVS writes since the start of the run.
+ * @return The number of `put*()` calls that changed flash.
+ */
+unsigned long sim_board_nvs_writes();
+
+/**
+ * @brief Returns the number of data partition sectors erased since the start of the run.
+ * @return The number of erased 4 KB sectors.
+ */
+unsigned long sim_board_flash_erases();
+
+/**
+ * @brief Makes servers the firmware opens reachable on the host.
+ * @param port The loopback port they are bound to, whatever port they ask for; 0 for none.
+ */
+void sim_board_set_http_port(int port);
+
+#endif // SIM_BOARD_H
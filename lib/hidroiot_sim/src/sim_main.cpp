@@ -0,0 +1,519 @@
+/**
+ * @file sim_main.cpp
+ * @brief Entry point of the native simulator: runs the firmware's `setup()` and
+ * `loop()` against the simulated plant on virtual time.
+ *
+ * Usage: `.pio/build/native/program [options]`
+ *
+ *   --hours <h>         Simulated duration (default 24).
+ *   --tick-ms <ms>      Virtual time added after every loop() (default 1).
+ *   --seed <n>          Sensor noise and `random()` seed (default 1).
+ *   --scenario <file>   Timed commands and plant events, see below.
+ *   --ha                Run a stand-in for the Home Assistant automations.
+ *   --level <cm>, --tds <ppm>, --ph <pH>, --start-hour <h>, --noise <scale>
+ *                       Initial plant conditions.
+ *   --nvs <file>        Load flash contents (NVS and the data partition) from,
+ *                       and save them to, a file.
+ *   --provision <key>=<value>
+ *                       Provision an identity setting (see identity.h), e.g.
+ *                       `instance=greenhouse_b`. May be repeated.
+ *   --topics            Print the client ID, base topic and every MQTT topic the
+ *                       firmware resolves, one per line, and exit.
+ *   --firmware <file>   Put an image into the running app partition (after --nvs).
+ *   --ota <file>        Serve an update file (see ota/make_update.py) the way
+ *                       ota/serve_update.py does, from the first connection on.
+ *   --ota-loss <pct>    Drop or corrupt that share of the update's chunks.
+ *   --ota-out <file>    Save the image selected for the next boot, as long as
+ *                       the update's image, for comparison.
+ *   --http <port>       Serve the firmware's metrics endpoint on localhost:<port>.
+ *   --realtime          Pace virtual time to the wall clock, e.g. for scraping.
+ *   --broker <host>[:<port>]
+ *                       Connect to a real MQTT broker instead of the in-process
+ *                       one (see sim_net.h); implies --realtime. The broker's
+ *                       credentials are provisioned as `mqtt_user`/`mqtt_pass`.
+ *   --probe <s>         With --broker, send a probe command every <s> seconds
+ *                       and time its acknowledgement.
+ *   --warmup <s>        With --broker, do not count the first <s> seconds.
+ *   --tls               The in-process broker listens with TLS (see sim_tls.h)
+ *                       and the device trusts its generated CA.
+ *   --serial            Show the firmware's serial log.
+ *   --mqtt              Show MQTT traffic.
+ *   --json              Print the summary as one JSON object.
+ *
+ * Scenario lines are `<time> <target> <value>`, where time is in seconds or
+ * has an `s`, `m` or `h` suffix. A target starting with `~` is an MQTT topic
+ * below the device's base topic, e.g. `90m ~/pompa/tandon/kontrol ON`.
+ * Plant events are `sim.level_cm`, `sim.tds_ppm`, `sim.ph`,
+ * `sim.ph_probe <pH>|tank` and `sim.tds_probe <ppm>|tank` (the probe goes into
+ * a buffer or standard solution, or back into the reservoir),
+ * `sim.fault <pump> ok|dry|blocked|relay`, `sim.wifi up|down` and
+ * `sim.broker up|down|wipe`, where `wipe` also stops the broker but forgets the
+ * device's session, like a broker without persistence.
+ * `sim.retain <topic> <payload>` publishes a retained command (an empty payload
+ * clears it) and `sim.flood <count> <topic> <payload>` sends the same command
+ * `count` times back to back.
+ *
+ * bench/fleet_load.py runs many of these against one broker at a time.
+ *
+ * Exit status: 0 on success, 1 on bad usage, 2 if the reservoir overflowed,
+ * 3 if the firmware restarted the board.
+ */
+
+#include <Arduino.h>
+#include "config.h"
+#include "identity.h"
+#include "ota_patch.h"
+#include "sim_board.h"
+#include "sim_mqtt.h"
+#include "sim_net.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+#include "sim_tls.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// Builds that bring their own main(), such as the benchmarks, define HIDROIOT_SIM_NO_MAIN;
+// PlatformIO defines PIO_UNIT_TESTING for the tests under test/.
+#if !defined(HIDROIOT_SIM_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+
+void setup();
+void loop();
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct HaState
+ * @brief What the Home Assistant stand-in remembers between evaluations.
+ */
+struct HaState {
+  uint32_t levelCount;  ///< Level updates seen so far.
+  double lastLevel;
+  double lastTds;
+  double lastPh;
+  int lastHour;
+};
+
+/**
+ * @struct OtaServer
+ * @brief The update server stand-in: answers the device's chunk requests from an update file.
+ */
+struct OtaServer {
+  std::vector<uint8_t> file;
+  uint32_t crc;
+  bool begun;          ///< Whether BEGIN was sent.
+  uint32_t requests;   ///< Requests answered so far.
+  uint32_t lost;       ///< Chunks dropped or corrupted on purpose.
+  uint64_t bytesSent;  ///< Chunk payload bytes sent, headers included.
+  double lossPercent;
+  uint32_t random;
+};
+
+static const uint64_t HA_INTERVAL_US = 100000;
+static const size_t OTA_CHUNK_HEADER_SIZE = 8;
+
+static HaState ha = {0, NAN, NAN, NAN, -1};
+static OtaServer ota = {std::vector<uint8_t>(), 0, false, 0, 0, 0, 0, 0x9E3779B9};
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void ha_step(double startHour);
+static double last_value(const std::string& topic);
+static bool load_update(const char* path);
+static void ota_step();
+static void print_ota_summary(bool json);
+static void print_net_summary(bool json);
+static void print_tls_summary(bool json);
+static void print_histogram_json(const char* name, const SimNetHistogram& histogram);
+static void print_summary(bool json, double wallS, unsigned long long loops, const char* outcome);
+
+int main(int argc, char** argv) {
+  SimPlantParams params = sim_plant_default_params();
+  double hours = 24;
+  double tickMs = 1;
+  uint32_t seed = 1;
+  bool runHa = false;
+  bool json = false;
+  bool realtime = false;
+  bool listTopics = false;
+  bool tls = false;
+  const char* nvsPath = nullptr;
+  const char* firmwarePath = nullptr;
+  const char* otaOutPath = nullptr;
+  std::vector<std::string> provisioned;
+  double probeS = 0;
+  double warmupS = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool takesValue = true;
+    if (arg == "--ha") { runHa = true; takesValue = false; }
+    else if (arg == "--serial") { sim_board_set_serial_echo(true); takesValue = false; }
+    else if (arg == "--mqtt") { sim_mqtt_set_echo(true); takesValue = false; }
+    else if (arg == "--json") { json = true; takesValue = false; }
+    else if (arg == "--realtime") { realtime = true; takesValue = false; }
+    else if (arg == "--topics") { listTopics = true; takesValue = false; }
+    else if (arg == "--tls") { tls = true; takesValue = false; }
+    else if (value == nullptr) { fprintf(stderr, "Missing value for %s\n", arg.c_str()); return 1; }
+    else if (arg == "--hours") hours = atof(value);
+    else if (arg == "--tick-ms") tickMs = atof(value);
+    else if (arg == "--seed") seed = (uint32_t)strtoul(value, nullptr, 10);
+    else if (arg == "--level") params.initialLevelCm = atof(value);
+    else if (arg == "--tds") params.initialTdsPpm = atof(value);
+    else if (arg == "--ph") params.initialPh = atof(value);
+    else if (arg == "--start-hour") params.startHour = atof(value);
+    else if (arg == "--noise") params.sensorNoise = atof(value);
+    else if (arg == "--nvs") nvsPath = value;
+    else if (arg == "--provision") {
+      if (strchr(value, '=') == nullptr) { fprintf(stderr, "--provision expects <key>=<value>\n"); return 1; }
+      provisioned.push_back(value);
+    }
+    else if (arg == "--firmware") firmwarePath = value;
+    else if (arg == "--ota") { if (!load_update(value)) return 1; }
+    else if (arg == "--ota-loss") ota.lossPercent = atof(value);
+    else if (arg == "--ota-out") otaOutPath = value;
+    else if (arg == "--http") sim_board_set_http_port(atoi(value));
+    else if (arg == "--scenario") { if (!sim_scenario_load(value)) return 1; }
+    else if (arg == "--broker") {
+      // Provisioned first, so that a later --provision still wins.
+      std::string address = value;
+      size_t colon = address.rfind(':');
+      provisioned.insert(provisioned.begin(), "mqtt_host=" + address.substr(0, colon));
+      if (colon != std::string::npos) {
+        provisioned.insert(provisioned.begin() + 1, "mqtt_port=" + address.substr(colon + 1));
+      }
+      sim_net_enable();
+      realtime = true;
+    }
+    else if (arg == "--probe") probeS = atof(value);
+    else if (arg == "--warmup") warmupS = atof(value);
+    else { fprintf(stderr, "Unknown option %s\n", arg.c_str()); return 1; }
+    if (takesValue) i++;
+  }
+  if (!(hours > 0) || !(tickMs > 0)) {
+    fprintf(stderr, "--hours and --tick-ms must be positive\n");
+    return 1;
+  }
+
+  sim_plant_init(params, seed);
+  // The ESP32's random() is a hardware RNG; here each seed stands for another board.
+  randomSeed(seed);
+  if (nvsPath) sim_board_load_nvs(nvsPath);
+  if (firmwarePath && !sim_board_load_firmware(firmwarePath)) {
+    fprintf(stderr, "Cannot load %s into the app partition\n", firmwarePath);
+    return 1;
+  }
+  for (size_t i = 0; i < provisioned.size(); i++) {
+    size_t split = provisioned[i].find('=');
+    sim_board_provision(IDENTITY_NAMESPACE, provisioned[i].substr(0, split).c_str(),
+                        provisioned[i].substr(split + 1).c_str());
+  }
+  if (tls) {
+    if (sim_net_enabled()) {
+      fprintf(stderr, "--tls only applies to the in-process broker\n");
+      return 1;
+    }
+    // The certificate names the host the device will connect to.
+    std::string host = MQTT_SERVER;
+    for (size_t i = 0; i < provisioned.size(); i++) {
+      if (provisioned[i].compare(0, 10, "mqtt_host=") == 0) host = provisioned[i].substr(10);
+    }
+    if (!sim_tls_enable(host.c_str())) {
+      fprintf(stderr, "Cannot make the broker's TLS certificates\n");
+      return 1;
+    }
+    MQTT_TLS_CA_CERT = sim_tls_ca_pem();
+  }
+  if (listTopics) {
+    identity_init();
+    printf("%s\n%s\n", MQTT_CLIENT_ID, BASE_TOPIC);
+    for (const MqttTopic* topic = MqttTopic::first(); topic != nullptr; topic = topic->next()) {
+      printf("%s\n", topic->c_str());
+    }
+    return 0;
+  }
+
+  const uint64_t endUs = (uint64_t)(hours * 3.6e9);
+  const uint64_t tickUs = (uint64_t)(tickMs * 1000);
+  uint64_t nextHaUs = 0;
+  const uint64_t probeUs = (uint64_t)(probeS * 1e6);
+  uint64_t nextProbeUs = probeUs;
+  unsigned long long loops = 0;
+  const char* outcome = "ok";
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+  try {
+    setup();
+    if (sim_net_enabled()) sim_net_observe(BASE_TOPIC, STATE_TOPIC_PUMP_ACK.c_str(), warmupS);
+    while (sim_now_us() < endUs) {
+      sim_scenario_step();
+      if (runHa && sim_now_us() >= nextHaUs) {
+        nextHaUs = sim_now_us() + HA_INTERVAL_US;
+        ha_step(params.startHour);
+      }
+      if (!ota.file.empty()) ota_step();
+      if (probeUs > 0 && sim_net_enabled() && sim_now_us() >= nextProbeUs) {
+        nextProbeUs = sim_now_us() + probeUs;
+        sim_net_probe(COMMAND_TOPIC_PUMP_A.c_str());
+      }
+      loop();
+      loops++;
+      sim_advance_us(tickUs);
+      std::chrono::steady_clock::time_point due = wallStart + std::chrono::microseconds(sim_now_us());
+      if (sim_net_enabled()) sim_net_wait_until(due);
+      else if (realtime) std::this_thread::sleep_until(due);
+    }
+  } catch (const SimRestart&) {
+    outcome = "restart";
+  }
+
+  double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  if (nvsPath && !sim_board_save_nvs(nvsPath)) fprintf(stderr, "Could not save %s\n", nvsPath);
+  if (otaOutPath && !ota.file.empty()) {
+    OtaHeader header;
+    ota_patch_parse_header(&ota.file[0], header);
+    if (!sim_board_save_boot_image(otaOutPath, header.imageSize)) fprintf(stderr, "Could not save %s\n", otaOutPath);
+  }
+  if (sim_plant_state().overflowL > 0 && strcmp(outcome, "ok") == 0) outcome = "overflow";
+  print_summary(json, wallS, loops, outcome);
+
+  if (strcmp(outcome, "restart") == 0) return 3;
+  if (strcmp(outcome, "overflow") == 0) return 2;
+  return 0;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Evaluates the greenhouse_a Home Assistant automations with their default
+ * settings, on the values the device has published.
+ */
+static void ha_step(double startHour) {
+  // Refill: start whenever a new level below the low target arrives with the valve off;
+  // stop when the level crosses above the high target.
+  uint32_t levelCount = sim_mqtt_count(STATE_TOPIC_LEVEL.c_str());
+  if (levelCount != ha.levelCount) {
+    ha.levelCount = levelCount;
+    double level = last_value(STATE_TOPIC_LEVEL.c_str());
+    const std::string* valve = sim_mqtt_last(STATE_TOPIC_PUMP_TANDON.c_str());
+    bool valveOn = valve && *valve == "ON";
+    if (!valveOn && level < 20) sim_mqtt_inject(COMMAND_TOPIC_PUMP_TANDON.c_str(), "ON");
+    if (valveOn && level > 80 && !(ha.lastLevel > 80)) sim_mqtt_inject(COMMAND_TOPIC_PUMP_TANDON.c_str(), "OFF");
+    ha.lastLevel = level;
+  }
+
+  // Dosing triggers fire when a threshold is crossed.
+  double tds = last_value(STATE_TOPIC_TDS.c_str());
+  if (tds < 800 && !(ha.lastTds < 800)) {
+    sim_mqtt_inject(COMMAND_TOPIC_PUMP_QUEUE.c_str(), "nutrisi_a:20:60,nutrisi_b:20");
+  }
+  if (!isnan(tds)) ha.lastTds = tds;
+  double ph = last_value(STATE_TOPIC_PH.c_str());
+  if (ph > 6.5 && !(ha.lastPh > 6.5)) sim_mqtt_inject(COMMAND_TOPIC_PUMP_PH.c_str(), "10");
+  if (!isnan(ph)) ha.lastPh = ph;
+
+  // Hourly irrigation from 07:00 to 15:00.
+  int hour = (int)fmod(startHour + sim_now_us() / 3.6e9, 24.0);
+  if (hour != ha.lastHour) {
+    if (ha.lastHour >= 0 && hour >= 7 && hour < 15) sim_mqtt_inject(COMMAND_TOPIC_PUMP_SIRAM.c_str(), "15");
+    ha.lastHour = hour;
+  }
+}
+
+/**
+ * @brief The last numeric value published on a topic, or NAN.
+ */
+static double last_value(const std::string& topic) {
+  const std::string* payload = sim_mqtt_last(topic);
+  return payload ? atof(payload->c_str()) : NAN;
+}
+
+/**
+ * @brief Prints the outcome of the run.
+ */
+static void print_summary(bool json, double wallS, unsigned long long loops, const char* outcome) {
+  const SimPlantState& s = sim_plant_state();
+  const SimMqttStats& m = sim_mqtt_stats();
+  double simS = sim_now_us() / 1e6;
+  double speedup = wallS > 0 ? simS / wallS : 0;
+  if (json) {
+    printf("{\"outcome\":\"%s\",\"sim_s\":%.1f,\"wall_s\":%.3f,\"speedup\":%.0f,\"loops\":%llu,"
+           "\"level_cm\":%.2f,\"min_level_cm\":%.2f,\"max_level_cm\":%.2f,\"tds_ppm\":%.1f,\"ph\":%.3f,"
+           "\"refilled_l\":%.2f,\"overflow_l\":%.3f,\"dispensed_ml\":[%.1f,%.1f,%.1f],"
+           "\"pump_on_s\":[%.1f,%.1f,%.1f,%.1f,%.1f],\"energy_wh\":%.2f,"
+           "\"mqtt\":{\"published\":%u,\"oversized\":%u,\"delivered\":%u,\"connects\":%u,"
+           "\"resumed\":%u,\"attempts\":%u},\"nvs_writes\":%lu,"
+           "\"flash_erases\":%lu",
+           outcome, simS, wallS, speedup, loops, sim_plant_level_cm(), s.minLevelCm, s.maxLevelCm,
+           sim_plant_tds_ppm(), s.ph, s.refilledL, s.overflowL, s.dispensedMl[0], s.dispensedMl[1],
+           s.dispensedMl[2], s.pumpOnS[0], s.pumpOnS[1], s.pumpOnS[2], s.pumpOnS[3], s.pumpOnS[4], s.energyWh,
+           m.published, m.oversized, m.delivered, m.connects, m.resumed, m.attempts, sim_board_nvs_writes(),
+           sim_board_flash_erases());
+    print_ota_summary(true);
+    print_net_summary(true);
+    print_tls_summary(true);
+    printf("}\n");
+    return;
+  }
+  printf("\n--- Simulation %s ---\n", outcome);
+  printf("Time:      %.0f s simulated in %.2f s (%.0fx real time), %llu loops\n", simS, wallS, speedup, loops);
+  printf("Reservoir: level %.1f cm (min %.1f, max %.1f), TDS %.0f ppm, pH %.2f\n", sim_plant_level_cm(),
+         s.minLevelCm, s.maxLevelCm, sim_plant_tds_ppm(), s.ph);
+  printf("Water:     %.1f L refilled, %.2f L overflowed\n", s.refilledL, s.overflowL);
+  printf("Dosed:     A %.1f ml, B %.1f ml, pH %.1f ml\n", s.dispensedMl[0], s.dispensedMl[1], s.dispensedMl[2]);
+  printf("Pumps on:  A %.0f s, B %.0f s, pH %.0f s, irrigation %.0f s, refill %.0f s\n", s.pumpOnS[0],
+         s.pumpOnS[1], s.pumpOnS[2], s.pumpOnS[3], s.pumpOnS[4]);
+  printf("Energy:    %.1f Wh\n", s.energyWh);
+  printf("MQTT:      %u published (%u oversized), %u delivered, %u connects (%u resumed) in %u attempts\n",
+         m.published, m.oversized, m.delivered, m.connects, m.resumed, m.attempts);
+  printf("NVS:       %lu writes\n", sim_board_nvs_writes());
+  printf("Flash:     %lu sectors erased\n", sim_board_flash_erases());
+  print_ota_summary(false);
+  print_net_summary(false);
+  print_tls_summary(false);
+}
+
+/**
+ * @brief Reads an update file for `--ota` and checks its header.
+ */
+static bool load_update(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot open update %s\n", path);
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) ota.file.insert(ota.file.end(), buffer, buffer + n);
+  fclose(file);
+  OtaHeader header;
+  const char* error = ota.file.size() < OTA_HEADER_SIZE ? "too short" : ota_patch_parse_header(&ota.file[0], header);
+  if (error != nullptr) {
+    fprintf(stderr, "%s: %s\n", path, error);
+    return false;
+  }
+  ota.crc = ota_patch_crc32(0, &ota.file[0], ota.file.size());
+  return true;
+}
+
+/**
+ * @brief Announces the update once the device is connected, then answers each new chunk request.
+ */
+static void ota_step() {
+  if (!ota.begun) {
+    if (sim_mqtt_stats().connects == 0) return;
+    char command[40];
+    snprintf(command, sizeof(command), "BEGIN %u %08x", (unsigned)ota.file.size(), ota.crc);
+    sim_mqtt_inject(COMMAND_TOPIC_OTA.c_str(), command);
+    ota.begun = true;
+    return;
+  }
+  uint32_t requests = sim_mqtt_count(STATE_TOPIC_OTA_REQUEST.c_str());
+  if (requests == ota.requests) return;
+  ota.requests = requests;
+
+  const std::string* request = sim_mqtt_last(STATE_TOPIC_OTA_REQUEST.c_str());
+  const char* offsetField = strstr(request->c_str(), "\"offset\":");
+  const char* lengthField = strstr(request->c_str(), "\"length\":");
+  if (offsetField == nullptr || lengthField == nullptr) return;
+  uint32_t offset = strtoul(offsetField + 9, nullptr, 10);
+  uint32_t length = strtoul(lengthField + 9, nullptr, 10);
+  if (offset > ota.file.size() || length > ota.file.size() - offset) return;
+
+  std::string payload(OTA_CHUNK_HEADER_SIZE + length, '\0');
+  uint32_t crc = ota_patch_crc32(0, &ota.file[offset], length);
+  for (int i = 0; i < 4; i++) {
+    payload[i] = (char)(offset >> (8 * i));
+    payload[4 + i] = (char)(crc >> (8 * i));
+  }
+  memcpy(&payload[OTA_CHUNK_HEADER_SIZE], &ota.file[offset], length);
+
+  // A weak link: some chunks never arrive, others arrive damaged.
+  ota.random = ota.random * 1664525 + 1013904223;
+  if ((ota.random >> 8) % 10000 < ota.lossPercent * 100) {
+    if (++ota.lost % 2 == 0) return;
+    payload[payload.size() - 1] ^= 0x5A;
+  }
+  ota.bytesSent += payload.size();
+  sim_mqtt_inject(COMMAND_TOPIC_OTA_DATA.c_str(), payload);
+}
+
+/**
+ * @brief Prints the update transfer, if `--ota` was given.
+ */
+static void print_ota_summary(bool json) {
+  if (ota.file.empty()) return;
+  OtaHeader header;
+  ota_patch_parse_header(&ota.file[0], header);
+  static const char* const METHODS[] = {"raw", "lz", "delta"};
+  const std::string* status = sim_mqtt_last(STATE_TOPIC_OTA.c_str());
+  const char* state = status == nullptr ? "none" : strstr(status->c_str(), "\"state\":\"ready\"") ? "installed"
+                    : strstr(status->c_str(), "\"error\":null") ? "incomplete" : "failed";
+  if (json) {
+    printf(",\"ota\":{\"method\":\"%s\",\"image\":%u,\"file\":%u,\"requests\":%u,\"lost\":%u,\"sent\":%llu,"
+           "\"result\":\"%s\"}",
+           METHODS[header.method], header.imageSize, (unsigned)ota.file.size(), ota.requests, ota.lost,
+           (unsigned long long)ota.bytesSent, state);
+    return;
+  }
+  printf("OTA:       %s update, %u bytes for a %u-byte image (%.1f%%); %u requests, %u chunks lost, "
+         "%llu bytes sent; %s\n",
+         METHODS[header.method], (unsigned)ota.file.size(), header.imageSize,
+         100.0 * ota.file.size() / header.imageSize, ota.requests, ota.lost, (unsigned long long)ota.bytesSent,
+         state);
+}
+
+/**
+ * @brief Prints a latency histogram as its sample count, sum, maximum and counts
+ * up to the last non-empty bucket, for bench/fleet_load.py to merge.
+ */
+static void print_histogram_json(const char* name, const SimNetHistogram& histogram) {
+  int used = SIM_NET_HISTOGRAM_BUCKETS;
+  while (used > 0 && histogram.counts[used - 1] == 0) used--;
+  printf("\"%s\":{\"sum_us\":%llu,\"max_us\":%u,\"counts\":[", name, (unsigned long long)histogram.sumUs,
+         histogram.maxUs);
+  for (int i = 0; i < used; i++) printf(i == 0 ? "%u" : ",%u", histogram.counts[i]);
+  printf("]}");
+}
+
+/**
+ * @brief Prints the handshakes the broker saw, if `--tls` was given.
+ */
+static void print_tls_summary(bool json) {
+  if (!sim_tls_enabled()) return;
+  const SimTlsStats& t = sim_tls_stats();
+  if (json) {
+    printf(",\"tls\":{\"full\":%u,\"resumed\":%u,\"failed\":%u}", t.full, t.resumed, t.failed);
+    return;
+  }
+  printf("TLS:       %u full and %u resumed handshakes, %u failed\n", t.full, t.resumed, t.failed);
+}
+
+/**
+ * @brief Prints the traffic and latencies seen on the real broker, if `--broker` was given.
+ */
+static void print_net_summary(bool json) {
+  if (!sim_net_enabled()) return;
+  const SimNetStats& n = sim_net_stats();
+  if (json) {
+    printf(",\"net\":{\"window_s\":%.3f,\"published\":%u,\"published_bytes\":%llu,\"echoed\":%u,\"lost\":%u,"
+           "\"commands\":%u,\"probes\":%u,\"probes_answered\":%u,\"link_drops\":%u,",
+           n.windowS, n.published, (unsigned long long)n.publishedBytes, n.echoed, n.lost, n.commands, n.probes,
+           n.probesAnswered, n.linkDrops);
+    print_histogram_json("latency", n.publishLatency);
+    printf(",");
+    print_histogram_json("probe_rtt", n.probeRoundTrip);
+    printf("}");
+    return;
+  }
+  printf("Broker:    %u published in %.0f s, %u echoed (%u lost), %u received, %u link drops\n", n.published,
+         n.windowS, n.echoed, n.lost, n.commands, n.linkDrops);
+  printf("Latency:   publish p50 %.2f ms, p99 %.2f ms; probe %u of %u answered, p50 %.2f ms, p99 %.2f ms\n",
+         sim_net_percentile_ms(n.publishLatency, 0.5), sim_net_percentile_ms(n.publishLatency, 0.99),
+         n.probesAnswered, n.probes, sim_net_percentile_ms(n.probeRoundTrip, 0.5),
+         sim_net_percentile_ms(n.probeRoundTrip, 0.99));
+}
+
+#endif // !HIDROIOT_SIM_NO_MAIN && !PIO_UNIT_TESTING
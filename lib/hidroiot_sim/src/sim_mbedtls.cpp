@@ -0,0 +1,493 @@
+/**
+ * @file sim_mbedtls.cpp
+ * @brief Implements the mbedTLS 2.x API of mbedtls/ssl.h on OpenSSL.
+ *
+ * Each mbedTLS connection is an OpenSSL client connection whose transport is
+ * a BIO that calls the firmware's send and receive callbacks, so the bytes go
+ * through the firmware's TlsClient just as on the device.
+ */
+
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/error.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ssl.h"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct SimSsl
+ * @brief The OpenSSL side of one mbedtls_ssl_context.
+ */
+struct SimSsl {
+  SSL_CTX* ctx;
+  SSL* ssl;
+  int bioError;                    ///< What the transport callback last failed with, or 0.
+  std::vector<uint32_t> depthFlags; ///< Verification flags of each certificate, by depth.
+};
+
+static BIO_METHOD* bioMethod = nullptr;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static SimSsl* sim_of(const mbedtls_ssl_context* ssl);
+static int bio_write(BIO* bio, const char* data, int length);
+static int bio_read(BIO* bio, char* data, int length);
+static long bio_ctrl(BIO* bio, int cmd, long num, void* ptr);
+static int verify_callback(int ok, X509_STORE_CTX* store);
+static uint32_t flags_for(int error);
+static int finish_verification(mbedtls_ssl_context* ssl);
+static int map_error(mbedtls_ssl_context* ssl, int ret);
+
+// --- Public Function Implementations ---
+
+void mbedtls_entropy_init(mbedtls_entropy_context* ctx) {
+  ctx->unused = 0;
+}
+
+void mbedtls_entropy_free(mbedtls_entropy_context* ctx) {}
+
+int mbedtls_entropy_func(void* data, unsigned char* output, size_t len) {
+  return RAND_bytes(output, (int)len) == 1 ? 0 : -0x003C;
+}
+
+void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context* ctx) {
+  ctx->seeded = 0;
+}
+
+void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context* ctx) {}
+
+int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context* ctx, int (*f_entropy)(void*, unsigned char*, size_t),
+                          void* p_entropy, const unsigned char* custom, size_t len) {
+  unsigned char seed[32];
+  int ret = f_entropy(p_entropy, seed, sizeof(seed));
+  if (ret != 0) return ret;
+  RAND_add(seed, sizeof(seed), sizeof(seed));
+  ctx->seeded = 1;
+  return 0;
+}
+
+int mbedtls_ctr_drbg_random(void* p_rng, unsigned char* output, size_t output_len) {
+  return RAND_bytes(output, (int)output_len) == 1 ? 0 : -0x0034;
+}
+
+void mbedtls_strerror(int errnum, char* buffer, size_t buflen) {
+  const char* text;
+  switch (errnum) {
+    case MBEDTLS_ERR_NET_SEND_FAILED: text = "NET - Sending information through the socket failed"; break;
+    case MBEDTLS_ERR_NET_CONN_RESET: text = "NET - Connection was reset by peer"; break;
+    case MBEDTLS_ERR_SSL_TIMEOUT: text = "SSL - The operation timed out"; break;
+    case MBEDTLS_ERR_SSL_BAD_INPUT_DATA: text = "SSL - Bad input parameters to function"; break;
+    case MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE: text = "SSL - A fatal alert message was received from our peer"; break;
+    case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY: text = "SSL - The peer notified us that the connection is going to be closed"; break;
+    case MBEDTLS_ERR_SSL_ALLOC_FAILED: text = "SSL - Memory allocation failed"; break;
+    case MBEDTLS_ERR_X509_INVALID_FORMAT: text = "X509 - The CRT/CRL/CSR format is invalid"; break;
+    case MBEDTLS_ERR_X509_CERT_VERIFY_FAILED: text = "X509 - Certificate verification failed"; break;
+    default: text = "UNKNOWN ERROR CODE"; break;
+  }
+  snprintf(buffer, buflen, "%s (-0x%04X)", text, (unsigned)-errnum);
+}
+
+int mbedtls_sha256_ret(const unsigned char* input, size_t ilen, unsigned char output[32], int is224) {
+  if (is224) SHA224(input, ilen, output);
+  else SHA256(input, ilen, output);
+  return 0;
+}
+
+int mbedtls_pk_write_pubkey_der(mbedtls_pk_context* ctx, unsigned char* buf, size_t size) {
+  if (ctx->key == nullptr) return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+  int length = i2d_PUBKEY((EVP_PKEY*)ctx->key, nullptr);
+  if (length <= 0) return MBEDTLS_ERR_PK_BAD_INPUT_DATA;
+  if ((size_t)length > size) return MBEDTLS_ERR_ASN1_BUF_TOO_SMALL;
+  unsigned char* at = buf + size - length;
+  i2d_PUBKEY((EVP_PKEY*)ctx->key, &at);
+  return length;
+}
+
+void mbedtls_x509_crt_init(mbedtls_x509_crt* crt) {
+  memset(crt, 0, sizeof(*crt));
+}
+
+void mbedtls_x509_crt_free(mbedtls_x509_crt* crt) {
+  mbedtls_x509_crt* next = crt->next;
+  X509_free((X509*)crt->x509);
+  while (next != nullptr) {
+    mbedtls_x509_crt* following = next->next;
+    X509_free((X509*)next->x509);
+    delete next;
+    next = following;
+  }
+  memset(crt, 0, sizeof(*crt));
+}
+
+int mbedtls_x509_crt_parse(mbedtls_x509_crt* chain, const unsigned char* buf, size_t buflen) {
+  BIO* in = BIO_new_mem_buf(buf, (int)strnlen((const char*)buf, buflen));
+  int parsed = 0;
+  X509* x509;
+  while ((x509 = PEM_read_bio_X509(in, nullptr, nullptr, nullptr)) != nullptr) {
+    mbedtls_x509_crt* crt = chain;
+    while (crt->x509 != nullptr && crt->next != nullptr) crt = crt->next;
+    if (crt->x509 != nullptr) {
+      crt->next = new mbedtls_x509_crt();
+      crt = crt->next;
+    }
+    crt->x509 = x509;
+    crt->pk.key = X509_get0_pubkey(x509);
+    parsed++;
+  }
+  BIO_free(in);
+  ERR_clear_error();
+  return parsed > 0 ? 0 : MBEDTLS_ERR_X509_INVALID_FORMAT;
+}
+
+int mbedtls_x509_crt_verify_info(char* buf, size_t size, const char* prefix, uint32_t flags) {
+  static const struct {
+    uint32_t flag;
+    const char* text;
+  } REASONS[] = {{MBEDTLS_X509_BADCERT_EXPIRED, "The certificate validity has expired"},
+                 {MBEDTLS_X509_BADCERT_REVOKED, "The certificate has been revoked (is on a CRL)"},
+                 {MBEDTLS_X509_BADCERT_CN_MISMATCH, "The certificate Common Name (CN) does not match with the expected CN"},
+                 {MBEDTLS_X509_BADCERT_NOT_TRUSTED, "The certificate is not correctly signed by the trusted CA"},
+                 {MBEDTLS_X509_BADCERT_OTHER, "Other reason (can be used by verify callback)"},
+                 {MBEDTLS_X509_BADCERT_FUTURE, "The certificate validity starts in the future"}};
+  std::string info;
+  for (size_t i = 0; i < sizeof(REASONS) / sizeof(REASONS[0]); i++) {
+    if (flags & REASONS[i].flag) info += std::string(prefix) + REASONS[i].text + "\n";
+  }
+  if (size > 0) snprintf(buf, size, "%s", info.c_str());
+  return (int)info.size();
+}
+
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf) {
+  memset(conf, 0, sizeof(*conf));
+}
+
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf) {
+  memset(conf, 0, sizeof(*conf));
+}
+
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset) {
+  // Only what the firmware uses: a stream client.
+  if (endpoint != MBEDTLS_SSL_IS_CLIENT || transport != MBEDTLS_SSL_TRANSPORT_STREAM) {
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+  conf->authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
+  conf->sessionTickets = MBEDTLS_SSL_SESSION_TICKETS_ENABLED;
+  return 0;
+}
+
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode) {
+  conf->authmode = authmode;
+}
+
+void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config* conf, mbedtls_x509_crt* ca_chain, mbedtls_x509_crl* ca_crl) {
+  conf->caChain = ca_chain;
+}
+
+void mbedtls_ssl_conf_verify(mbedtls_ssl_config* conf, int (*f_vrfy)(void*, mbedtls_x509_crt*, int, uint32_t*),
+                             void* p_vrfy) {
+  conf->f_vrfy = f_vrfy;
+  conf->p_vrfy = p_vrfy;
+}
+
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng) {
+  // OpenSSL draws from its own generator.
+}
+
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int use_tickets) {
+  conf->sessionTickets = use_tickets;
+}
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl) {
+  memset(ssl, 0, sizeof(*ssl));
+}
+
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim != nullptr) {
+    SSL_free(sim->ssl);
+    SSL_CTX_free(sim->ctx);
+    delete sim;
+  }
+  memset(ssl, 0, sizeof(*ssl));
+}
+
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf) {
+  if (bioMethod == nullptr) {
+    bioMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "mbedtls bio");
+    BIO_meth_set_write(bioMethod, bio_write);
+    BIO_meth_set_read(bioMethod, bio_read);
+    BIO_meth_set_ctrl(bioMethod, bio_ctrl);
+  }
+  SimSsl* sim = new SimSsl();
+  sim->ctx = SSL_CTX_new(TLS_client_method());
+  sim->ssl = nullptr;
+  sim->bioError = 0;
+  if (sim->ctx == nullptr) {
+    delete sim;
+    return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+  }
+  // mbedTLS 2.28 speaks TLS 1.2.
+  SSL_CTX_set_min_proto_version(sim->ctx, TLS1_2_VERSION);
+  SSL_CTX_set_max_proto_version(sim->ctx, TLS1_2_VERSION);
+  if (conf->sessionTickets == MBEDTLS_SSL_SESSION_TICKETS_DISABLED) SSL_CTX_set_options(sim->ctx, SSL_OP_NO_TICKET);
+  // Every certificate is checked and its flags kept; the configured authmode decides afterwards.
+  SSL_CTX_set_verify(sim->ctx, SSL_VERIFY_PEER, verify_callback);
+  for (const mbedtls_x509_crt* crt = conf->caChain; crt != nullptr && crt->x509 != nullptr; crt = crt->next) {
+    X509_STORE_add_cert(SSL_CTX_get_cert_store(sim->ctx), (X509*)crt->x509);
+  }
+  ssl->conf = conf;
+  ssl->sim = sim;
+  return mbedtls_ssl_session_reset(ssl);
+}
+
+int mbedtls_ssl_session_reset(mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  SSL_free(sim->ssl);
+  sim->ssl = SSL_new(sim->ctx);
+  if (sim->ssl == nullptr) return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+  BIO* bio = BIO_new(bioMethod);
+  BIO_set_data(bio, ssl);
+  BIO_set_init(bio, 1);
+  SSL_set_bio(sim->ssl, bio, bio);
+  SSL_set_app_data(sim->ssl, ssl);
+  SSL_set_connect_state(sim->ssl);
+  sim->bioError = 0;
+  sim->depthFlags.clear();
+  ssl->state = MBEDTLS_SSL_HELLO_REQUEST;
+  ssl->verifyResult = 0xFFFFFFFF;
+  return 0;
+}
+
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr || hostname == nullptr) return 0;
+  SSL_set_tlsext_host_name(sim->ssl, hostname);
+  X509_VERIFY_PARAM_set1_host(SSL_get0_param(sim->ssl), hostname, 0);
+  return 0;
+}
+
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* p_bio, mbedtls_ssl_send_t* f_send,
+                         mbedtls_ssl_recv_t* f_recv, mbedtls_ssl_recv_timeout_t* f_recv_timeout) {
+  ssl->p_bio = p_bio;
+  ssl->f_send = f_send;
+  ssl->f_recv = f_recv;
+}
+
+int mbedtls_ssl_handshake_step(mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  if (ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER) return 0;
+  ssl->state = MBEDTLS_SSL_CLIENT_HELLO;
+  int ret = SSL_do_handshake(sim->ssl);
+  if (ret != 1) return map_error(ssl, ret);
+  ret = finish_verification(ssl);
+  if (ret != 0) return ret;
+  ssl->state = MBEDTLS_SSL_HANDSHAKE_OVER;
+  return 0;
+}
+
+uint32_t mbedtls_ssl_get_verify_result(const mbedtls_ssl_context* ssl) {
+  return ssl->verifyResult;
+}
+
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr || ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  if (len == 0) {
+    // Decrypts the next record, if any, and leaves its data for the next read.
+    char c;
+    int ret = SSL_peek(sim->ssl, &c, 1);
+    return ret > 0 ? 0 : map_error(ssl, ret);
+  }
+  int ret = SSL_read(sim->ssl, buf, (int)len);
+  return ret > 0 ? ret : map_error(ssl, ret);
+}
+
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr || ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  int ret = SSL_write(sim->ssl, buf, (int)len);
+  return ret > 0 ? ret : map_error(ssl, ret);
+}
+
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  return sim == nullptr ? 0 : (size_t)SSL_pending(sim->ssl);
+}
+
+int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim != nullptr && ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER) SSL_shutdown(sim->ssl);
+  ERR_clear_error();
+  return 0;
+}
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session) {
+  memset(session, 0, sizeof(*session));
+}
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session) {
+  SSL_SESSION_free((SSL_SESSION*)session->session);
+  memset(session, 0, sizeof(*session));
+}
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr || session->session != nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  SSL_SESSION* established = SSL_get1_session(sim->ssl);
+  if (established == nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  session->session = established;
+  SSL_SESSION_get_master_key(established, session->master, sizeof(session->master));
+  return 0;
+}
+
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+  SimSsl* sim = sim_of(ssl);
+  if (sim == nullptr || session->session == nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  return SSL_set_session(sim->ssl, (SSL_SESSION*)session->session) == 1 ? 0 : MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+}
+
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t buf_len, size_t* olen) {
+  if (session->session == nullptr) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  int length = i2d_SSL_SESSION((SSL_SESSION*)session->session, nullptr);
+  if (length <= 0) return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  *olen = (size_t)length;
+  if ((size_t)length > buf_len) return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+  unsigned char* at = buf;
+  i2d_SSL_SESSION((SSL_SESSION*)session->session, &at);
+  return 0;
+}
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len) {
+  const unsigned char* at = buf;
+  SSL_SESSION* loaded = d2i_SSL_SESSION(nullptr, &at, (long)len);
+  if (loaded == nullptr) {
+    ERR_clear_error();
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+  SSL_SESSION_free((SSL_SESSION*)session->session);
+  session->session = loaded;
+  SSL_SESSION_get_master_key(loaded, session->master, sizeof(session->master));
+  return 0;
+}
+
+// --- Static (Private) Function Implementations ---
+
+static SimSsl* sim_of(const mbedtls_ssl_context* ssl) {
+  return (SimSsl*)ssl->sim;
+}
+
+/**
+ * @brief Hands outgoing bytes to the firmware's send callback.
+ */
+static int bio_write(BIO* bio, const char* data, int length) {
+  mbedtls_ssl_context* ssl = (mbedtls_ssl_context*)BIO_get_data(bio);
+  BIO_clear_retry_flags(bio);
+  int ret = ssl->f_send(ssl->p_bio, (const unsigned char*)data, (size_t)length);
+  if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) BIO_set_retry_write(bio);
+  else if (ret < 0) sim_of(ssl)->bioError = ret;
+  return ret < 0 ? -1 : ret;
+}
+
+/**
+ * @brief Fetches incoming bytes from the firmware's receive callback.
+ */
+static int bio_read(BIO* bio, char* data, int length) {
+  mbedtls_ssl_context* ssl = (mbedtls_ssl_context*)BIO_get_data(bio);
+  BIO_clear_retry_flags(bio);
+  int ret = ssl->f_recv(ssl->p_bio, (unsigned char*)data, (size_t)length);
+  if (ret == MBEDTLS_ERR_SSL_WANT_READ) BIO_set_retry_read(bio);
+  else if (ret < 0) sim_of(ssl)->bioError = ret;
+  return ret < 0 ? -1 : ret;
+}
+
+static long bio_ctrl(BIO* bio, int cmd, long num, void* ptr) {
+  return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+/**
+ * @brief Keeps the flags of every certificate OpenSSL checks and lets the
+ * handshake go on, as mbedTLS does before the callback and authmode decide.
+ */
+static int verify_callback(int ok, X509_STORE_CTX* store) {
+  SSL* connection = (SSL*)X509_STORE_CTX_get_ex_data(store, SSL_get_ex_data_X509_STORE_CTX_idx());
+  mbedtls_ssl_context* ssl = (mbedtls_ssl_context*)SSL_get_app_data(connection);
+  SimSsl* sim = sim_of(ssl);
+  size_t depth = (size_t)X509_STORE_CTX_get_error_depth(store);
+  if (sim->depthFlags.size() <= depth) sim->depthFlags.resize(depth + 1, 0);
+  if (!ok) sim->depthFlags[depth] |= flags_for(X509_STORE_CTX_get_error(store));
+  return 1;
+}
+
+/**
+ * @brief Maps an OpenSSL verification error to mbedTLS's flag for it.
+ */
+static uint32_t flags_for(int error) {
+  switch (error) {
+    case X509_V_ERR_CERT_HAS_EXPIRED: return MBEDTLS_X509_BADCERT_EXPIRED;
+    case X509_V_ERR_CERT_NOT_YET_VALID: return MBEDTLS_X509_BADCERT_FUTURE;
+    case X509_V_ERR_CERT_REVOKED: return MBEDTLS_X509_BADCERT_REVOKED;
+    case X509_V_ERR_HOSTNAME_MISMATCH: return MBEDTLS_X509_BADCERT_CN_MISMATCH;
+    default: return MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+  }
+}
+
+/**
+ * @brief Runs the configured certificate callback over the broker's chain,
+ * from the root down to its own certificate as mbedTLS does, and applies the
+ * authmode to the result.
+ */
+static int finish_verification(mbedtls_ssl_context* ssl) {
+  SimSsl* sim = sim_of(ssl);
+  ssl->verifyResult = 0;
+  if (SSL_session_reused(sim->ssl) || ssl->conf->authmode == MBEDTLS_SSL_VERIFY_NONE) return 0;
+
+  STACK_OF(X509)* chain = SSL_get0_verified_chain(sim->ssl);
+  if (chain == nullptr) chain = SSL_get_peer_cert_chain(sim->ssl);
+  int count = chain == nullptr ? 0 : sk_X509_num(chain);
+  if (count == 0) ssl->verifyResult = MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+  for (int depth = count - 1; depth >= 0; depth--) {
+    uint32_t flags = (size_t)depth < sim->depthFlags.size() ? sim->depthFlags[depth] : 0;
+    if (ssl->conf->f_vrfy != nullptr) {
+      mbedtls_x509_crt crt;
+      mbedtls_x509_crt_init(&crt);
+      crt.x509 = sk_X509_value(chain, depth);
+      crt.pk.key = X509_get0_pubkey((X509*)crt.x509);
+      int ret = ssl->conf->f_vrfy(ssl->conf->p_vrfy, &crt, depth, &flags);
+      if (ret != 0) return ret;
+    }
+    ssl->verifyResult |= flags;
+  }
+  if (ssl->verifyResult != 0 && ssl->conf->authmode == MBEDTLS_SSL_VERIFY_REQUIRED) {
+    return MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+  }
+  return 0;
+}
+
+/**
+ * @brief Maps the result of an OpenSSL call to an mbedTLS error code.
+ */
+static int map_error(mbedtls_ssl_context* ssl, int ret) {
+  SimSsl* sim = sim_of(ssl);
+  int error = SSL_get_error(sim->ssl, ret);
+  ERR_clear_error();
+  switch (error) {
+    case SSL_ERROR_WANT_READ: return MBEDTLS_ERR_SSL_WANT_READ;
+    case SSL_ERROR_WANT_WRITE: return MBEDTLS_ERR_SSL_WANT_WRITE;
+    case SSL_ERROR_ZERO_RETURN: return MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY;
+    case SSL_ERROR_SYSCALL: return sim->bioError != 0 ? sim->bioError : MBEDTLS_ERR_NET_CONN_RESET;
+    default: return MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE;
+  }
+}
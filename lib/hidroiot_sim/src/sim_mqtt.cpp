@@ -0,0 +1,535 @@
+/**
+ * @file sim_mqtt.cpp
+ * @brief Implements the simulator's in-process MQTT broker and the PubSubClient stand-in.
+ */
+
+#include "sim_mqtt.h"
+#include "sim_net.h"
+#include "sim_time.h"
+#include "sim_tls.h"
+#include <PubSubClient.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+// --- Module-Private (Static) Variables ---
+
+/**
+ * @struct TopicRecord
+ * @brief What the broker knows about one topic.
+ */
+struct TopicRecord {
+  std::string last;  ///< The last payload published by the device.
+  uint32_t count;    ///< Messages published by the device.
+};
+
+/**
+ * @struct Subscription
+ * @brief One subscription of the device's session.
+ */
+struct Subscription {
+  std::string filter;
+  uint8_t qos;
+};
+
+static std::map<std::string, TopicRecord> topics;
+/// @brief Retained messages for the device, published by other clients.
+static std::map<std::string, std::string> retainedCommands;
+/// @brief The device's session: its subscriptions and the packets queued for it, in order.
+static std::vector<Subscription> subscriptions;
+static std::deque<SimNetDelivery> inbox;
+/// @brief Whether the broker keeps the session while the device is away (cleanSession = false).
+static bool persistentSession = false;
+static bool sessionStored = false;
+static SimMqttStats stats = {0, 0, 0, 0, 0, 0, 0};
+static bool echo = false;
+static bool linkAvailable = true;
+static bool brokerRunning = true;
+/// @brief The current connection's id; 0 while disconnected.
+static int session = 0;
+static int nextSession = 1;
+/// @brief Bytes the broker sent on the connection that the client has not read yet.
+static std::deque<uint8_t> clientRx;
+static std::string willTopic;
+static std::string willMessage;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool topic_matches(const std::string& filter, const std::string& topic);
+static int subscribed_qos(const std::string& topic);
+static void offer(const std::string& topic, const std::string& payload);
+static void send_publish(const SimNetDelivery& message);
+static void end_connection();
+static void record(const std::string& topic, const std::string& payload, const char* direction);
+
+// --- Public Function Implementations ---
+
+void sim_mqtt_inject(const std::string& topic, const std::string& payload) {
+  if (sim_net_enabled()) {
+    sim_net_inject(topic, payload, false);
+    return;
+  }
+  offer(topic, payload);
+}
+
+void sim_mqtt_retain(const std::string& topic, const std::string& payload) {
+  if (sim_net_enabled()) {
+    sim_net_inject(topic, payload, true);
+    return;
+  }
+  if (payload.empty()) {
+    retainedCommands.erase(topic);
+  } else {
+    retainedCommands[topic] = payload;
+  }
+  // A real broker forwards the message itself to current subscribers, empty or not.
+  offer(topic, payload);
+}
+
+const std::string* sim_mqtt_last(const std::string& topic) {
+  std::map<std::string, TopicRecord>::const_iterator it = topics.find(topic);
+  return it == topics.end() ? nullptr : &it->second.last;
+}
+
+uint32_t sim_mqtt_count(const std::string& topic) {
+  std::map<std::string, TopicRecord>::const_iterator it = topics.find(topic);
+  return it == topics.end() ? 0 : it->second.count;
+}
+
+void sim_mqtt_set_echo(bool enabled) {
+  echo = enabled;
+}
+
+void sim_mqtt_set_available(bool available) {
+  linkAvailable = available;
+  if (!available && session != 0) {
+    // The broker publishes the will of a client it loses.
+    if (!willTopic.empty()) record(willTopic, willMessage, "will");
+    if (sim_net_enabled()) sim_net_disconnect(false);
+    end_connection();
+  }
+}
+
+void sim_mqtt_set_broker_running(bool running, bool keepSessions) {
+  brokerRunning = running;
+  // A real broker cannot be stopped from here; its connection is dropped instead.
+  if (!running && session != 0 && sim_net_enabled()) sim_net_disconnect(false);
+  if (!running && session != 0) end_connection();
+  // Its TLS sessions were only kept in memory.
+  if (!running) sim_tls_forget_sessions();
+  if (!keepSessions) {
+    subscriptions.clear();
+    inbox.clear();
+    sessionStored = false;
+  }
+}
+
+const SimMqttStats& sim_mqtt_stats() {
+  return stats;
+}
+
+bool sim_mqtt_accept() {
+  stats.attempts++;
+  if (linkAvailable && brokerRunning) return true;
+  if (echo) printf("[%10.3f] %-6s refused\n", sim_now_us() / 1e6, "conn");
+  return false;
+}
+
+bool sim_mqtt_connect(const std::string& host, uint16_t port, const std::string& clientId, const std::string& user,
+                      const std::string& password, const std::string& topic, const std::string& message,
+                      bool retain, bool cleanSession) {
+  clientRx.clear();
+  // CONNACK: type, remaining length, session present, return code.
+  uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+  bool reached = linkAvailable && brokerRunning;
+  if (reached && sim_net_enabled()) {
+    reached = sim_net_connect(host, port, clientId, user, password, topic, message, retain, cleanSession, connack);
+  }
+  if (!reached || connack[3] != 0) {
+    if (echo) printf("[%10.3f] %-6s refused\n", sim_now_us() / 1e6, "conn");
+    clientRx.insert(clientRx.end(), connack, connack + (reached ? sizeof(connack) : 0));
+    return reached;
+  }
+  session = nextSession++;
+  willTopic = topic;
+  willMessage = message;
+  bool present = sim_net_enabled() ? (connack[2] & 0x01) != 0 : !cleanSession && sessionStored;
+  if (!present) {
+    subscriptions.clear();
+    inbox.clear();
+  }
+  persistentSession = !cleanSession;
+  sessionStored = persistentSession;
+  stats.connects++;
+  if (present) stats.resumed++;
+  if (echo) printf("[%10.3f] %-6s %s\n", sim_now_us() / 1e6, "conn", present ? "resumed" : "new session");
+  connack[2] = present ? 1 : 0;
+  clientRx.insert(clientRx.end(), connack, connack + sizeof(connack));
+  return true;
+}
+
+int sim_mqtt_client_available() {
+  return (int)clientRx.size();
+}
+
+int sim_mqtt_client_read() {
+  if (clientRx.empty()) return -1;
+  uint8_t c = clientRx.front();
+  clientRx.pop_front();
+  return c;
+}
+
+bool sim_mqtt_is_up(int id) {
+  if (session != 0 && sim_net_enabled() && !sim_net_is_up()) end_connection();
+  return id != 0 && id == session;
+}
+
+int sim_mqtt_session() {
+  return session;
+}
+
+void sim_mqtt_disconnect() {
+  if (sim_net_enabled()) sim_net_disconnect(true);
+  end_connection();
+}
+
+void sim_mqtt_publish(const std::string& topic, const uint8_t* payload, unsigned int length, bool retained) {
+  stats.published++;
+  stats.payloadBytes += length;
+  record(topic, std::string((const char*)payload, length), retained ? "pub(r)" : "pub");
+  if (sim_net_enabled()) sim_net_publish(topic, payload, length, retained);
+}
+
+void sim_mqtt_count_oversized() {
+  stats.oversized++;
+}
+
+void sim_mqtt_subscribe(const std::string& filter, uint8_t qos) {
+  // Subscribing again replaces the subscription, and the broker sends the retained messages again.
+  size_t i = 0;
+  while (i < subscriptions.size() && subscriptions[i].filter != filter) i++;
+  if (i == subscriptions.size()) subscriptions.push_back(Subscription());
+  subscriptions[i].filter = filter;
+  subscriptions[i].qos = qos > 1 ? 1 : qos;
+  if (sim_net_enabled()) {
+    sim_net_subscribe(filter, qos);
+    return;
+  }
+  // The SUBACK, then the retained messages with the RETAIN flag; both after anything queued before.
+  inbox.push_back(SimNetDelivery());
+  for (std::map<std::string, std::string>::const_iterator it = retainedCommands.begin();
+       it != retainedCommands.end(); ++it) {
+    SimNetDelivery message = {it->first, it->second, true};
+    if (topic_matches(filter, it->first)) inbox.push_back(message);
+  }
+}
+
+void sim_mqtt_unsubscribe(const std::string& filter) {
+  if (sim_net_enabled()) sim_net_unsubscribe(filter);
+  for (size_t i = 0; i < subscriptions.size(); i++) {
+    if (subscriptions[i].filter == filter) {
+      subscriptions.erase(subscriptions.begin() + i);
+      return;
+    }
+  }
+}
+
+bool sim_mqtt_send_next() {
+  SimNetDelivery received;
+  while (sim_net_enabled() && sim_net_next_delivery(received)) inbox.push_back(received);
+  while (!inbox.empty()) {
+    SimNetDelivery next = inbox.front();
+    inbox.pop_front();
+    if (next.topic.empty()) {
+      // SUBACK: packet identifier, granted QoS. The stand-in does not number its SUBSCRIBEs.
+      static const uint8_t SUBACK[] = {0x90, 0x03, 0x00, 0x01, 0x01};
+      clientRx.insert(clientRx.end(), SUBACK, SUBACK + sizeof(SUBACK));
+      return true;
+    }
+    if (subscribed_qos(next.topic) >= 0) {
+      send_publish(next);
+      return true;
+    }
+    // Nobody subscribed: dropped, as by a real broker.
+  }
+  return false;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Matches a topic against a subscription filter with `+` and `#` wildcards.
+ */
+static bool topic_matches(const std::string& filter, const std::string& topic) {
+  size_t f = 0, t = 0;
+  while (f < filter.size()) {
+    if (filter[f] == '#') return true;
+    if (filter[f] == '+') {
+      while (t < topic.size() && topic[t] != '/') t++;
+      f++;
+      continue;
+    }
+    if (t >= topic.size() || filter[f] != topic[t]) return false;
+    f++;
+    t++;
+  }
+  return t == topic.size();
+}
+
+/**
+ * @brief Returns the highest QoS the session subscribed to a topic with, or -1 if it is not subscribed.
+ */
+static int subscribed_qos(const std::string& topic) {
+  int qos = -1;
+  for (size_t i = 0; i < subscriptions.size(); i++) {
+    if (subscriptions[i].qos > qos && topic_matches(subscriptions[i].filter, topic)) qos = subscriptions[i].qos;
+  }
+  return qos;
+}
+
+/**
+ * @brief Queues a message for the device. While it is away, only a stored
+ * session's QoS 1 subscriptions queue messages; the rest are dropped.
+ */
+static void offer(const std::string& topic, const std::string& payload) {
+  int qos = subscribed_qos(topic);
+  SimNetDelivery message = {topic, payload, false};
+  if (session != 0 ? qos >= 0 : qos >= 1) inbox.push_back(message);
+}
+
+/**
+ * @brief Sends a message to the device as a PUBLISH packet. The stand-in does
+ * not acknowledge, so it goes out as QoS 0, with the RETAIN flag if it was
+ * sent because of a new subscription.
+ */
+static void send_publish(const SimNetDelivery& message) {
+  std::vector<uint8_t> body;
+  body.push_back((uint8_t)(message.topic.size() >> 8));
+  body.push_back((uint8_t)message.topic.size());
+  body.insert(body.end(), message.topic.begin(), message.topic.end());
+  body.insert(body.end(), message.payload.begin(), message.payload.end());
+  clientRx.push_back(message.retained ? 0x31 : 0x30);
+  for (size_t length = body.size(); ; length >>= 7) {
+    clientRx.push_back((uint8_t)((length & 0x7F) | (length > 0x7F ? 0x80 : 0x00)));
+    if (length <= 0x7F) break;
+  }
+  clientRx.insert(clientRx.end(), body.begin(), body.end());
+  stats.delivered++;
+  if (echo) {
+    printf("[%10.3f] %-6s %s %s\n", sim_now_us() / 1e6, message.retained ? "sub(r)" : "sub", message.topic.c_str(),
+           message.payload.c_str());
+  }
+}
+
+/**
+ * @brief Ends the current connection. A clean session ends with it; a stored
+ * one keeps its subscriptions and the QoS 1 messages not yet delivered.
+ */
+static void end_connection() {
+  session = 0;
+  clientRx.clear();
+  if (sim_net_enabled()) {
+    // A real broker keeps the session itself and redelivers what it had not yet handed over.
+    inbox.clear();
+    if (!persistentSession) subscriptions.clear();
+    return;
+  }
+  if (!persistentSession) {
+    subscriptions.clear();
+    inbox.clear();
+    return;
+  }
+  std::deque<SimNetDelivery> kept;
+  for (size_t i = 0; i < inbox.size(); i++) {
+    if (subscribed_qos(inbox[i].topic) >= 1) kept.push_back(inbox[i]);
+  }
+  inbox.swap(kept);
+}
+
+/**
+ * @brief Stores a message as the topic's last value and echoes it if enabled.
+ */
+static void record(const std::string& topic, const std::string& payload, const char* direction) {
+  TopicRecord& entry = topics[topic];
+  entry.last = payload;
+  entry.count++;
+  if (echo) printf("[%10.3f] %-6s %s %s\n", sim_now_us() / 1e6, direction, topic.c_str(), payload.c_str());
+}
+
+// --- PubSubClient ---
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+  this->callback = callback;
+  return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+  if (size == 0) return false;
+  bufferSize = size;
+  return true;
+}
+
+bool PubSubClient::connect(const char* id) {
+  return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr, true);
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+  return connect(id, user, pass, nullptr, 0, false, nullptr, true);
+}
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass, const char* willTopic,
+                           uint8_t willQos, bool willRetain, const char* willMessage, bool cleanSession) {
+  if (connected()) return true;
+  if (!client->connect(domain.c_str(), port)) {
+    currentState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  // Like the real client, send the CONNECT over the connection. The broker takes
+  // its fields from sim_mqtt_connect(); the bytes only exercise the transport.
+  static const uint8_t PROTOCOL[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+  std::vector<uint8_t> body(PROTOCOL, PROTOCOL + sizeof(PROTOCOL));
+  uint8_t flags = cleanSession ? 0x02 : 0x00;
+  if (willTopic) flags |= 0x04 | (willQos << 3) | (willRetain ? 0x20 : 0x00);
+  if (user) flags |= 0x80;
+  if (pass) flags |= 0x40;
+  body.push_back(flags);
+  body.push_back(0);
+  body.push_back(15);  // Keep alive
+  const char* fields[] = {id ? id : "", willTopic, willTopic ? willMessage : nullptr, user, pass};
+  for (const char* field : fields) {
+    if (field == nullptr) continue;
+    size_t length = strlen(field);
+    body.push_back((uint8_t)(length >> 8));
+    body.push_back((uint8_t)length);
+    body.insert(body.end(), field, field + length);
+  }
+  std::vector<uint8_t> packet(1, 0x10);
+  for (size_t length = body.size(); ; length >>= 7) {
+    packet.push_back((uint8_t)((length & 0x7F) | (length > 0x7F ? 0x80 : 0x00)));
+    if (length <= 0x7F) break;
+  }
+  packet.insert(packet.end(), body.begin(), body.end());
+  if (client->write(&packet[0], packet.size()) != packet.size()) {
+    client->stop();
+    currentState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  if (!sim_mqtt_connect(domain, port, id ? id : "", user ? user : "", pass ? pass : "", willTopic ? willTopic : "",
+                        willMessage ? willMessage : "", willRetain, cleanSession)) {
+    client->stop();
+    currentState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  // Like the real client, read the CONNACK from the connection once it has arrived.
+  uint8_t connack[4];
+  for (size_t i = 0; i < sizeof(connack); i++) {
+    int c = client->available() > 0 ? client->read() : -1;
+    if (c < 0) {
+      sim_mqtt_disconnect();
+      client->stop();
+      currentState = MQTT_CONNECTION_TIMEOUT;
+      return false;
+    }
+    connack[i] = (uint8_t)c;
+  }
+  if (connack[3] != 0) {
+    client->stop();
+    currentState = connack[3];
+    return false;
+  }
+  session = sim_mqtt_session();
+  currentState = MQTT_CONNECTED;
+  return true;
+}
+
+void PubSubClient::disconnect() {
+  if (sim_mqtt_is_up(session)) sim_mqtt_disconnect();
+  client->stop();
+  session = -1;
+  currentState = MQTT_DISCONNECTED;
+}
+
+bool PubSubClient::connected() {
+  if (session != -1 && !sim_mqtt_is_up(session)) {
+    client->stop();
+    session = -1;
+    currentState = MQTT_CONNECTION_LOST;
+  }
+  return session != -1;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload) {
+  return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, false);
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload, bool retained) {
+  return publish(topic, (const uint8_t*)payload, payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length) {
+  return publish(topic, payload, length, false);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int length, bool retained) {
+  if (!connected()) return false;
+  // Same limit as the real client: header, topic length prefix, topic and payload.
+  if (MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + length > bufferSize) {
+    sim_mqtt_count_oversized();
+    return false;
+  }
+  sim_mqtt_publish(topic, payload, length, retained);
+  return true;
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t qos) {
+  if (!connected()) return false;
+  sim_mqtt_subscribe(topic, qos);
+  return true;
+}
+
+bool PubSubClient::unsubscribe(const char* topic) {
+  if (!connected()) return false;
+  sim_mqtt_unsubscribe(topic);
+  return true;
+}
+
+bool PubSubClient::loop() {
+  if (!connected()) return false;
+  // The broker sends its next packet once the last one was read. Like the real
+  // client, read at most one packet per call, from the connection.
+  if (client->available() == 0 && !sim_mqtt_send_next()) return true;
+  uint8_t header;
+  std::vector<uint8_t> body;
+  if (!read_packet(header, body) || (header & 0xF0) != 0x30 || !callback || body.size() < 2) return true;
+  size_t topicLength = ((size_t)body[0] << 8) | body[1];
+  size_t offset = 2 + topicLength + ((header & 0x06) ? 2 : 0);
+  if (offset > body.size()) return true;
+  // Messages that don't fit the buffer are dropped by the real client too.
+  if (MQTT_MAX_HEADER_SIZE + body.size() > bufferSize) return true;
+  std::vector<char> topicBuffer(body.begin() + 2, body.begin() + 2 + topicLength);
+  topicBuffer.push_back('\0');
+  std::vector<uint8_t> payloadBuffer(body.begin() + offset, body.end());
+  payloadBuffer.push_back(0);
+  callback(&topicBuffer[0], &payloadBuffer[0], body.size() - offset);
+  return true;
+}
+
+bool PubSubClient::read_packet(uint8_t& header, std::vector<uint8_t>& body) {
+  // Byte by byte, as the real client reads.
+  int c = client->read();
+  if (c < 0) return false;
+  header = (uint8_t)c;
+  size_t length = 0;
+  for (int shift = 0; ; shift += 7) {
+    c = client->read();
+    if (c < 0 || shift > 21) return false;
+    length |= (size_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) break;
+  }
+  body.resize(length);
+  for (size_t i = 0; i < length; i++) {
+    c = client->read();
+    if (c < 0) return false;
+    body[i] = (uint8_t)c;
+  }
+  return true;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file sim_mqtt.h
+ * @brief The simulator's in-process MQTT broker.
+ *
+ * Holds the session of the simulated device (its subscriptions and a queue
+ * of messages for it) and the last value and retained value of every topic.
+ * A session opened with cleanSession = false outlives the connection, as on a
+ * real broker: its QoS 1 subscriptions keep queuing messages while the device
+ * is away.
+ * The Home Assistant stand-in and scenario files talk to the firmware
+ * through it, exactly as they would over the network.
+ *
+ * With a real broker (see sim_net.h) it only routes: the device's traffic and
+ * the injected commands go to that broker, and what the broker delivers is
+ * handed to the firmware. The broker then keeps the sessions.
+ */
+#ifndef SIM_MQTT_H
+#define SIM_MQTT_H
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * @struct SimMqttStats
+ * @brief Traffic counters since the start of the simulation.
+ */
+struct SimMqttStats {
+  uint32_t published;    ///< Messages accepted from the device.
+  uint32_t oversized;    ///< Publishes rejected because they did not fit the client buffer.
+  uint32_t delivered;    ///< Messages delivered to the device.
+  uint64_t payloadBytes; ///< Total payload bytes published by the device.
+  uint32_t connects;     ///< Successful connections.
+  uint32_t resumed;      ///< Connections that resumed a stored session.
+  uint32_t attempts;     ///< Connection attempts, refused ones included.
+};
+
+/**
+ * @brief Queues a message for the device. It is delivered by the next `PubSubClient::loop()`
+ * if the device is subscribed to the topic. While the device is away it is only
+ * kept for a stored session that subscribed to the topic with QoS 1.
+ * @param topic The full topic.
+ * @param payload The payload.
+ */
+void sim_mqtt_inject(const std::string& topic, const std::string& payload);
+
+/**
+ * @brief Stores a retained message for the device, like a client publishing with
+ * the retain flag. It is delivered on every later subscription to the topic, and
+ * at once if the device is subscribed. An empty payload clears it.
+ * @param topic The full topic.
+ * @param payload The payload.
+ */
+void sim_mqtt_retain(const std::string& topic, const std::string& payload);
+
+/**
+ * @brief Returns the last payload the device published on a topic.
+ * @param topic The full topic.
+ * @return The payload, or nullptr if nothing was published on it yet.
+ */
+const std::string* sim_mqtt_last(const std::string& topic);
+
+/**
+ * @brief Returns the number of messages the device has published on a topic.
+ * @param topic The full topic.
+ * @return The message count.
+ */
+uint32_t sim_mqtt_count(const std::string& topic);
+
+/**
+ * @brief Echoes all traffic to stdout, prefixed with the virtual time.
+ * @param enabled true to echo.
+ */
+void sim_mqtt_set_echo(bool enabled);
+
+/**
+ * @brief Makes the broker refuse (false) or accept (true) connections.
+ * Refusing also drops the current connection, as a broker restart would.
+ * @param available true if the broker is reachable.
+ */
+void sim_mqtt_set_available(bool available);
+
+/**
+ * @brief Stops or starts the broker. Stopping drops the connection without
+ * publishing the will.
+ * @param running true if the broker runs.
+ * @param keepSessions false to also forget the stored session, like a broker
+ * restarted without persistence.
+ */
+void sim_mqtt_set_broker_running(bool running, bool keepSessions);
+
+/**
+ * @brief Returns the traffic counters.
+ * @return The counters since the start of the simulation.
+ */
+const SimMqttStats& sim_mqtt_stats();
+
+// --- Used by the PubSubClient and WiFiClient stand-ins ---
+bool sim_mqtt_accept();
+bool sim_mqtt_connect(const std::string& host, uint16_t port, const std::string& clientId, const std::string& user,
+                      const std::string& password, const std::string& willTopic, const std::string& willMessage,
+                      bool willRetain, bool cleanSession);
+int sim_mqtt_client_available();
+int sim_mqtt_client_read();
+bool sim_mqtt_is_up(int session);
+int sim_mqtt_session();
+void sim_mqtt_disconnect();
+void sim_mqtt_publish(const std::string& topic, const uint8_t* payload, unsigned int length, bool retained);
+void sim_mqtt_count_oversized();
+void sim_mqtt_subscribe(const std::string& filter, uint8_t qos);
+void sim_mqtt_unsubscribe(const std::string& filter);
+bool sim_mqtt_send_next();
+
+#endif // SIM_MQTT_H
@@ -0,0 +1,558 @@
+/**
+ * @file sim_net.cpp
+ * @brief Implements the simulator's connections to a real MQTT broker.
+ */
+
+#include "sim_net.h"
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct Link
+ * @brief One MQTT connection.
+ */
+struct Link {
+  int fd;                     ///< -1 while closed.
+  std::vector<uint8_t> rx;    ///< Received bytes not parsed yet.
+  Clock::time_point lastSent; ///< For the keep-alive.
+  uint16_t nextPacketId;
+};
+
+/**
+ * @struct PendingEcho
+ * @brief A message of the device on its way to the observer.
+ */
+struct PendingEcho {
+  Clock::time_point sentAt;
+  size_t payloadHash;
+};
+
+// MQTT control packet types, in the high nibble of the first byte.
+static const uint8_t PACKET_CONNECT = 0x10;
+static const uint8_t PACKET_CONNACK = 0x20;
+static const uint8_t PACKET_PUBLISH = 0x30;
+static const uint8_t PACKET_PUBACK = 0x40;
+static const uint8_t PACKET_SUBACK = 0x90;
+static const uint8_t PACKET_SUBSCRIBE = 0x82;
+static const uint8_t PACKET_UNSUBSCRIBE = 0xA2;
+static const uint8_t PACKET_PINGREQ = 0xC0;
+static const uint8_t PACKET_DISCONNECT = 0xE0;
+
+/// @brief PubSubClient's default keep-alive.
+static const int KEEPALIVE_S = 15;
+static const int CONNECT_TIMEOUT_MS = 5000;
+/// @brief How long the observer is retried after, while the broker cannot be reached.
+static const int OBSERVER_RETRY_MS = 2000;
+/// @brief Messages of one topic awaited at most; older ones count as lost.
+static const size_t MAX_PENDING_PER_TOPIC = 256;
+/// @brief How long a message may be on its way before it counts as lost.
+static const double LOST_AFTER_S = 10;
+
+static bool enabled = false;
+static Link device = {-1, std::vector<uint8_t>(), Clock::time_point(), 1};
+static Link observer = {-1, std::vector<uint8_t>(), Clock::time_point(), 1};
+static std::string brokerHost;
+static uint16_t brokerPort = 0;
+static std::string observerId;
+static Clock::time_point observerRetryAt;
+
+static std::string baseFilter;  ///< "<base topic>/#"; empty until sim_net_observe().
+static std::string basePrefix;  ///< "<base topic>/"
+static std::string ackTopic;
+static Clock::time_point measureFrom;
+static bool observing = false;
+
+/// @brief What the broker sent the device; an empty topic stands for a SUBACK.
+static std::deque<SimNetDelivery> deviceInbox;
+static std::map<std::string, std::deque<PendingEcho> > pending;
+static std::map<uint32_t, Clock::time_point> probesInFlight;
+static uint32_t nextProbe = 1;
+static SimNetStats stats;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool open_link(Link& link, const std::string& clientId, const std::string& user, const std::string& password,
+                      const std::string& willTopic, const std::string& willMessage, bool willRetain,
+                      bool cleanSession, uint8_t connack[4]);
+static void ensure_observer();
+static void close_link(Link& link, bool graceful, bool dropped);
+static bool send_packet(Link& link, uint8_t type, const std::vector<uint8_t>& body);
+static void put_string(std::vector<uint8_t>& out, const std::string& text);
+static void put_u16(std::vector<uint8_t>& out, uint16_t value);
+static void send_publish(Link& link, const std::string& topic, const uint8_t* payload, size_t length, bool retained);
+static bool receive(Link& link);
+static void parse_packets(Link& link, Clock::time_point at);
+static void handle_publish(Link& link, uint8_t flags, const uint8_t* body, size_t length, Clock::time_point at);
+static void observed(const std::string& topic, const std::string& payload, Clock::time_point at);
+static bool measuring(Clock::time_point at);
+static void add_sample(SimNetHistogram& histogram, double us);
+
+// --- Public Function Implementations ---
+
+void sim_net_enable() {
+  enabled = true;
+}
+
+bool sim_net_enabled() {
+  return enabled;
+}
+
+void sim_net_observe(const std::string& baseTopic, const std::string& acknowledgements, double warmupS) {
+  basePrefix = baseTopic + "/";
+  baseFilter = basePrefix + "#";
+  ackTopic = acknowledgements;
+  measureFrom = Clock::now() + std::chrono::microseconds((int64_t)(warmupS * 1e6));
+  observing = true;
+}
+
+void sim_net_probe(const std::string& commandTopic) {
+  if (observer.fd < 0) return;
+  Clock::time_point now = Clock::now();
+  uint32_t id = nextProbe++;
+  char payload[48];
+  snprintf(payload, sizeof(payload), "{\"id\":\"probe-%u\",\"value\":\"0\"}", id);
+  if (measuring(now)) stats.probes++;
+  probesInFlight[id] = now;
+  // An unanswered probe is given up with the oldest.
+  if (probesInFlight.size() > 64) probesInFlight.erase(probesInFlight.begin());
+  send_publish(observer, commandTopic, (const uint8_t*)payload, strlen(payload), false);
+}
+
+void sim_net_wait_until(Clock::time_point until) {
+  // Receives at least once, also when the simulation runs late, so that arrivals are timed when they happen.
+  for (bool first = true;; first = false) {
+    Clock::time_point now = Clock::now();
+    if (observing && observer.fd < 0 && !brokerHost.empty() && now >= observerRetryAt) ensure_observer();
+    Link* links[] = {&device, &observer};
+    for (int i = 0; i < 2; i++) {
+      if (links[i]->fd >= 0 && now - links[i]->lastSent >= std::chrono::seconds(KEEPALIVE_S / 2)) {
+        send_packet(*links[i], PACKET_PINGREQ, std::vector<uint8_t>());
+      }
+    }
+    if (now >= until && !first) return;
+
+    struct pollfd fds[2];
+    Link* polled[2];
+    int count = 0;
+    for (int i = 0; i < 2; i++) {
+      if (links[i]->fd < 0) continue;
+      fds[count].fd = links[i]->fd;
+      fds[count].events = POLLIN;
+      fds[count].revents = 0;
+      polled[count++] = links[i];
+    }
+    int64_t remainingUs = std::chrono::duration_cast<std::chrono::microseconds>(until - now).count();
+    remainingUs = std::max<int64_t>(remainingUs, 0);
+    if (count == 0) {
+      std::this_thread::sleep_until(until);
+      continue;
+    }
+    // poll() counts in whole milliseconds; the last fraction is slept.
+    if (poll(fds, count, (int)(remainingUs / 1000)) == 0) {
+      if (remainingUs < 1000) std::this_thread::sleep_until(until);
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      if (fds[i].revents == 0) continue;
+      if (receive(*polled[i])) parse_packets(*polled[i], Clock::now());
+    }
+  }
+}
+
+const SimNetStats& sim_net_stats() {
+  static SimNetStats snapshot;
+  Clock::time_point now = Clock::now();
+  snapshot = stats;
+  snapshot.windowS = now > measureFrom ? std::chrono::duration<double>(now - measureFrom).count() : 0;
+  // What is still under way is lost only once it is overdue.
+  for (std::map<std::string, std::deque<PendingEcho> >::const_iterator it = pending.begin(); it != pending.end();
+       ++it) {
+    for (size_t i = 0; i < it->second.size(); i++) {
+      const PendingEcho& echo = it->second[i];
+      if (measuring(echo.sentAt) && std::chrono::duration<double>(now - echo.sentAt).count() > LOST_AFTER_S) {
+        snapshot.lost++;
+      }
+    }
+  }
+  return snapshot;
+}
+
+double sim_net_percentile_ms(const SimNetHistogram& histogram, double fraction) {
+  uint64_t total = 0;
+  for (int i = 0; i < SIM_NET_HISTOGRAM_BUCKETS; i++) total += histogram.counts[i];
+  if (total == 0) return NAN;
+  uint64_t rank = (uint64_t)ceil(fraction * total), seen = 0;
+  int bucket = 0;
+  while (bucket < SIM_NET_HISTOGRAM_BUCKETS - 1 && (seen += histogram.counts[bucket]) < rank) bucket++;
+  return 0.1 * pow(2, (bucket + 1) / 8.0);
+}
+
+bool sim_net_connect(const std::string& host, uint16_t port, const std::string& clientId, const std::string& user,
+                     const std::string& password, const std::string& willTopic, const std::string& willMessage,
+                     bool willRetain, bool cleanSession, uint8_t connack[4]) {
+  brokerHost = host;
+  brokerPort = port;
+  observerId = clientId + "-observer";
+  close_link(device, false, false);
+  deviceInbox.clear();
+  // The observer must already listen when the device's first messages arrive.
+  if (observing && observer.fd < 0) ensure_observer();
+  if (!open_link(device, clientId, user, password, willTopic, willMessage, willRetain, cleanSession, connack)) {
+    return false;
+  }
+  if (connack[3] != 0) close_link(device, false, false);
+  return true;
+}
+
+void sim_net_disconnect(bool graceful) {
+  close_link(device, graceful, false);
+  deviceInbox.clear();
+}
+
+bool sim_net_is_up() {
+  return device.fd >= 0;
+}
+
+void sim_net_publish(const std::string& topic, const uint8_t* payload, unsigned int length, bool retained) {
+  if (device.fd < 0) return;
+  Clock::time_point now = Clock::now();
+  if (measuring(now)) {
+    stats.published++;
+    stats.publishedBytes += length;
+  }
+  if (observer.fd >= 0 && topic.compare(0, basePrefix.size(), basePrefix) == 0) {
+    std::deque<PendingEcho>& queue = pending[topic];
+    PendingEcho echo = {now, std::hash<std::string>()(std::string((const char*)payload, length))};
+    queue.push_back(echo);
+    if (queue.size() > MAX_PENDING_PER_TOPIC) {
+      if (measuring(queue.front().sentAt)) stats.lost++;
+      queue.pop_front();
+    }
+  }
+  send_publish(device, topic, payload, length, retained);
+}
+
+void sim_net_inject(const std::string& topic, const std::string& payload, bool retained) {
+  if (observer.fd >= 0) send_publish(observer, topic, (const uint8_t*)payload.data(), payload.size(), retained);
+}
+
+void sim_net_subscribe(const std::string& filter, uint8_t qos) {
+  std::vector<uint8_t> body;
+  put_u16(body, device.nextPacketId++);
+  put_string(body, filter);
+  body.push_back(qos > 1 ? 1 : qos);
+  send_packet(device, PACKET_SUBSCRIBE, body);
+}
+
+void sim_net_unsubscribe(const std::string& filter) {
+  std::vector<uint8_t> body;
+  put_u16(body, device.nextPacketId++);
+  put_string(body, filter);
+  send_packet(device, PACKET_UNSUBSCRIBE, body);
+}
+
+bool sim_net_next_delivery(SimNetDelivery& delivery) {
+  if (deviceInbox.empty()) return false;
+  delivery = deviceInbox.front();
+  deviceInbox.pop_front();
+  return true;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Opens a TCP connection to the broker, sends CONNECT and waits for the CONNACK.
+ * @return false if the broker cannot be reached or does not answer.
+ */
+static bool open_link(Link& link, const std::string& clientId, const std::string& user, const std::string& password,
+                      const std::string& willTopic, const std::string& willMessage, bool willRetain,
+                      bool cleanSession, uint8_t connack[4]) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* addresses = nullptr;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", brokerPort);
+  if (getaddrinfo(brokerHost.c_str(), service, &hints, &addresses) != 0) return false;
+  int fd = -1;
+  for (struct addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (fd < 0) return false;
+  // Every packet is written whole, as PubSubClient does; Nagle would only add delay to the measurements.
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  link.fd = fd;
+  link.rx.clear();
+  link.nextPacketId = 1;
+
+  std::vector<uint8_t> body;
+  put_string(body, "MQTT");
+  body.push_back(4); // MQTT 3.1.1
+  uint8_t flags = cleanSession ? 0x02 : 0x00;
+  if (!willTopic.empty()) flags |= 0x04 | (1 << 3) | (willRetain ? 0x20 : 0x00); // The firmware's will is QoS 1.
+  if (!user.empty()) flags |= 0x80 | (!password.empty() ? 0x40 : 0x00);
+  body.push_back(flags);
+  put_u16(body, KEEPALIVE_S);
+  put_string(body, clientId);
+  if (!willTopic.empty()) {
+    put_string(body, willTopic);
+    put_string(body, willMessage);
+  }
+  if (!user.empty()) put_string(body, user);
+  if (!user.empty() && !password.empty()) put_string(body, password);
+  if (!send_packet(link, PACKET_CONNECT, body)) return false;
+
+  Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+  while (link.rx.size() < 4) {
+    int remainingMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    struct pollfd pfd = {link.fd, POLLIN, 0};
+    if (remainingMs <= 0 || poll(&pfd, 1, remainingMs) <= 0 || !receive(link)) {
+      close_link(link, false, false);
+      return false;
+    }
+  }
+  if ((link.rx[0] & 0xF0) != PACKET_CONNACK || link.rx[1] != 2) {
+    close_link(link, false, false);
+    return false;
+  }
+  memcpy(connack, &link.rx[0], 4);
+  link.rx.erase(link.rx.begin(), link.rx.begin() + 4);
+  return true;
+}
+
+/**
+ * @brief Connects the observer and subscribes it to the device's topics.
+ */
+static void ensure_observer() {
+  observerRetryAt = Clock::now() + std::chrono::milliseconds(OBSERVER_RETRY_MS);
+  uint8_t connack[4];
+  if (!open_link(observer, observerId, "", "", "", "", false, true, connack)) return;
+  if (connack[3] != 0) {
+    fprintf(stderr, "sim_net: the broker refused the observer (code %u)\n", connack[3]);
+    close_link(observer, false, false);
+    return;
+  }
+  std::vector<uint8_t> body;
+  put_u16(body, observer.nextPacketId++);
+  put_string(body, baseFilter);
+  body.push_back(0);
+  send_packet(observer, PACKET_SUBSCRIBE, body);
+}
+
+/**
+ * @brief Closes a connection, with a DISCONNECT first if graceful (then the broker drops the will).
+ * @param dropped true if the broker or the network ended it.
+ */
+static void close_link(Link& link, bool graceful, bool dropped) {
+  if (link.fd < 0) return;
+  if (graceful) send_packet(link, PACKET_DISCONNECT, std::vector<uint8_t>());
+  if (link.fd >= 0) close(link.fd);
+  link.fd = -1;
+  link.rx.clear();
+  if (dropped && measuring(Clock::now())) stats.linkDrops++;
+}
+
+/**
+ * @brief Writes one packet: fixed header, remaining length and body.
+ * @return false if the connection failed; it is then closed.
+ */
+static bool send_packet(Link& link, uint8_t type, const std::vector<uint8_t>& body) {
+  if (link.fd < 0) return false;
+  std::vector<uint8_t> packet;
+  packet.reserve(body.size() + 5);
+  packet.push_back(type);
+  size_t length = body.size();
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    packet.push_back(digit | (length > 0 ? 0x80 : 0x00));
+  } while (length > 0);
+  packet.insert(packet.end(), body.begin(), body.end());
+  size_t sent = 0;
+  // Blocking, as the device's writes are: a congested broker slows the publisher down.
+  while (sent < packet.size()) {
+    ssize_t n = send(link.fd, &packet[sent], packet.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      close_link(link, false, true);
+      return false;
+    }
+    sent += n;
+  }
+  link.lastSent = Clock::now();
+  return true;
+}
+
+static void put_string(std::vector<uint8_t>& out, const std::string& text) {
+  put_u16(out, (uint16_t)text.size());
+  out.insert(out.end(), text.begin(), text.end());
+}
+
+static void put_u16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back(value >> 8);
+  out.push_back(value & 0xFF);
+}
+
+/**
+ * @brief Sends a QoS 0 PUBLISH.
+ */
+static void send_publish(Link& link, const std::string& topic, const uint8_t* payload, size_t length, bool retained) {
+  std::vector<uint8_t> body;
+  body.reserve(2 + topic.size() + length);
+  put_string(body, topic);
+  body.insert(body.end(), payload, payload + length);
+  send_packet(link, PACKET_PUBLISH | (retained ? 0x01 : 0x00), body);
+}
+
+/**
+ * @brief Reads what has arrived on a connection without blocking.
+ * @return false if the connection ended; it is then closed.
+ */
+static bool receive(Link& link) {
+  uint8_t buffer[16384];
+  while (link.fd >= 0) {
+    ssize_t n = recv(link.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (n > 0) {
+      link.rx.insert(link.rx.end(), buffer, buffer + n);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (n < 0 && errno == EINTR) continue;
+    close_link(link, false, true);
+    return false;
+  }
+  return false;
+}
+
+/**
+ * @brief Handles every complete packet received on a connection.
+ * @param at When the bytes arrived.
+ */
+static void parse_packets(Link& link, Clock::time_point at) {
+  size_t pos = 0;
+  while (link.fd >= 0 && link.rx.size() - pos >= 2) {
+    size_t length = 0, header = 1;
+    int shift = 0;
+    bool complete = false;
+    while (pos + header < link.rx.size() && header <= 4) {
+      uint8_t digit = link.rx[pos + header++];
+      length |= (size_t)(digit & 0x7F) << shift;
+      shift += 7;
+      if (!(digit & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete || link.rx.size() - pos - header < length) break;
+    uint8_t type = link.rx[pos] & 0xF0;
+    if (type == PACKET_PUBLISH) handle_publish(link, link.rx[pos] & 0x0F, &link.rx[pos + header], length, at);
+    // The device sees its SUBACKs; CONNACK, UNSUBACK, PUBACK and PINGRESP need no action.
+    if (type == PACKET_SUBACK && &link == &device) deviceInbox.push_back(SimNetDelivery());
+    pos += header + length;
+  }
+  if (link.fd >= 0) link.rx.erase(link.rx.begin(), link.rx.begin() + pos);
+}
+
+/**
+ * @brief Passes a received message to the device or the observer, acknowledging it if QoS 1.
+ */
+static void handle_publish(Link& link, uint8_t flags, const uint8_t* body, size_t length, Clock::time_point at) {
+  if (length < 2) return;
+  size_t topicLength = ((size_t)body[0] << 8) | body[1];
+  size_t offset = 2 + topicLength;
+  uint8_t qos = (flags >> 1) & 0x03;
+  if (qos > 0) offset += 2;
+  if (offset > length) return;
+  std::string topic((const char*)body + 2, topicLength);
+  std::string payload((const char*)body + offset, length - offset);
+  if (qos > 0) {
+    std::vector<uint8_t> ack(body + offset - 2, body + offset);
+    send_packet(link, PACKET_PUBACK, ack);
+  }
+  if (&link == &device) {
+    if (measuring(at)) stats.commands++;
+    SimNetDelivery delivery = {topic, payload, (flags & 0x01) != 0};
+    deviceInbox.push_back(delivery);
+  } else if (!(flags & 0x01)) {
+    // Retained messages replayed on subscribing are old news.
+    observed(topic, payload, at);
+  }
+}
+
+/**
+ * @brief Matches a message that reached the observer with its publish or probe.
+ */
+static void observed(const std::string& topic, const std::string& payload, Clock::time_point at) {
+  std::map<std::string, std::deque<PendingEcho> >::iterator it = pending.find(topic);
+  if (it != pending.end()) {
+    size_t hash = std::hash<std::string>()(payload);
+    std::deque<PendingEcho>& queue = it->second;
+    // Messages that arrive in order; one that is skipped was lost on the way.
+    size_t match = 0;
+    while (match < queue.size() && queue[match].payloadHash != hash) match++;
+    if (match < queue.size()) {
+      for (size_t i = 0; i < match; i++) {
+        if (measuring(queue.front().sentAt)) stats.lost++;
+        queue.pop_front();
+      }
+      if (measuring(queue.front().sentAt)) {
+        stats.echoed++;
+        add_sample(stats.publishLatency, std::chrono::duration<double, std::micro>(at - queue.front().sentAt).count());
+      }
+      queue.pop_front();
+    }
+  }
+  if (topic != ackTopic) return;
+  const char* id = strstr(payload.c_str(), "\"id\":\"probe-");
+  if (id == nullptr) return;
+  std::map<uint32_t, Clock::time_point>::iterator probe = probesInFlight.find(strtoul(id + 12, nullptr, 10));
+  if (probe == probesInFlight.end()) return;
+  if (measuring(probe->second)) {
+    stats.probesAnswered++;
+    add_sample(stats.probeRoundTrip, std::chrono::duration<double, std::micro>(at - probe->second).count());
+  }
+  probesInFlight.erase(probe);
+}
+
+/**
+ * @brief Returns whether something that happened at a time is measured, i.e. after the warm-up.
+ */
+static bool measuring(Clock::time_point at) {
+  return observing && at >= measureFrom;
+}
+
+/**
+ * @brief Counts a latency in its histogram bucket.
+ */
+static void add_sample(SimNetHistogram& histogram, double us) {
+  int bucket = us < 100 ? 0 : (int)floor(8 * log2(us / 100));
+  if (bucket >= SIM_NET_HISTOGRAM_BUCKETS) bucket = SIM_NET_HISTOGRAM_BUCKETS - 1;
+  histogram.counts[bucket]++;
+  histogram.sumUs += (uint64_t)us;
+  if (us > histogram.maxUs) histogram.maxUs = (uint32_t)us;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file sim_net.h
+ * @brief Connects the simulated device to a real MQTT broker instead of the
+ * in-process one, to load-test a broker with many simulated greenhouses.
+ *
+ * Two MQTT 3.1.1 connections are opened per simulated device:
+ * - the device's own, which carries exactly what the firmware's PubSubClient
+ *   would send: its CONNECT (client ID, will, persistent session), its QoS 0
+ *   publishes and its subscriptions;
+ * - an observer standing in for Home Assistant, subscribed to the device's base
+ *   topic. Commands from the Home Assistant stand-in, scenario files and probes
+ *   are published through it.
+ *
+ * The observer measures what a user of the broker sees: each message the
+ * device publishes is timed from the publish until it arrives at the observer
+ * (end-to-end latency), and each probe command from its publish until the
+ * device's acknowledgement arrives (command round trip). Both are recorded in
+ * log-scale histograms with 8 buckets per doubling from 100 µs, which merge
+ * across devices by adding them up.
+ *
+ * Messages are received and time-stamped while the simulator waits for the
+ * wall clock, so the firmware's loop period does not add to the latencies.
+ */
+#ifndef SIM_NET_H
+#define SIM_NET_H
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+
+/// @brief The number of latency histogram buckets; the last one also counts everything slower.
+constexpr int SIM_NET_HISTOGRAM_BUCKETS = 160;
+
+/**
+ * @struct SimNetHistogram
+ * @brief Latency counts. Bucket i holds latencies below 100 µs * 2^((i + 1) / 8).
+ */
+struct SimNetHistogram {
+  uint32_t counts[SIM_NET_HISTOGRAM_BUCKETS];
+  uint64_t sumUs;
+  uint32_t maxUs;
+};
+
+/**
+ * @struct SimNetStats
+ * @brief What the connections carried after the warm-up.
+ */
+struct SimNetStats {
+  double windowS;           ///< Wall-clock seconds measured.
+  uint32_t published;       ///< Messages the device published.
+  uint64_t publishedBytes;  ///< Their payload bytes.
+  uint32_t echoed;          ///< Messages of the device that reached the observer.
+  uint32_t lost;            ///< Messages of the device that never reached it.
+  uint32_t commands;        ///< Messages the device received.
+  uint32_t probes;          ///< Probe commands sent.
+  uint32_t probesAnswered;  ///< Probe commands acknowledged.
+  uint32_t linkDrops;       ///< Connections the broker closed or that failed.
+  SimNetHistogram publishLatency;
+  SimNetHistogram probeRoundTrip;
+};
+
+/**
+ * @brief Switches the simulator to the broker at the address the firmware
+ * connects to (see `mqtt_host`/`mqtt_port`). Requires pacing to the wall clock.
+ */
+void sim_net_enable();
+
+/**
+ * @brief Returns whether a real broker is used.
+ * @return true after `sim_net_enable()`.
+ */
+bool sim_net_enabled();
+
+/**
+ * @brief Opens the observer once the device's base topic is known. Samples of
+ * the first `warmupS` seconds are not counted.
+ * @param baseTopic The device's base topic.
+ * @param ackTopic The topic the device acknowledges commands on.
+ * @param warmupS Seconds before measuring starts, e.g. to skip the connection storm of a fleet.
+ */
+void sim_net_observe(const std::string& baseTopic, const std::string& ackTopic, double warmupS);
+
+/**
+ * @brief Sends a probe command: a structured pump command with an invalid
+ * value, which the device rejects and acknowledges without running anything.
+ * @param commandTopic The pump command topic.
+ */
+void sim_net_probe(const std::string& commandTopic);
+
+/**
+ * @brief Receives from both connections until the given time, and keeps them alive.
+ * @param until When to return.
+ */
+void sim_net_wait_until(std::chrono::steady_clock::time_point until);
+
+/**
+ * @brief Returns the traffic and latency counters.
+ * @return The counters since the warm-up ended.
+ */
+const SimNetStats& sim_net_stats();
+
+/**
+ * @brief Returns a percentile of a latency histogram.
+ * @param histogram The histogram.
+ * @param fraction The percentile as a fraction, e.g. 0.99.
+ * @return The upper bound (ms) of the bucket the percentile falls in, or NAN if it is empty.
+ */
+double sim_net_percentile_ms(const SimNetHistogram& histogram, double fraction);
+
+// --- Used by the in-process broker (sim_mqtt.cpp) ---
+
+/**
+ * @struct SimNetDelivery
+ * @brief A packet the broker sent the device: a message, or a SUBACK if the topic is empty.
+ */
+struct SimNetDelivery {
+  std::string topic;
+  std::string payload;
+  bool retained;  ///< The RETAIN flag: sent because of a new subscription.
+};
+
+bool sim_net_connect(const std::string& host, uint16_t port, const std::string& clientId, const std::string& user,
+                     const std::string& password, const std::string& willTopic, const std::string& willMessage,
+                     bool willRetain, bool cleanSession, uint8_t connack[4]);
+void sim_net_disconnect(bool graceful);
+bool sim_net_is_up();
+void sim_net_publish(const std::string& topic, const uint8_t* payload, unsigned int length, bool retained);
+void sim_net_inject(const std::string& topic, const std::string& payload, bool retained);
+void sim_net_subscribe(const std::string& filter, uint8_t qos);
+void sim_net_unsubscribe(const std::string& filter);
+bool sim_net_next_delivery(SimNetDelivery& delivery);
+
+#endif // SIM_NET_H
@@ -0,0 +1,364 @@
+/**
+ * @file sim_plant.cpp
+ * @brief Implements the simulated hydroponic plant.
+ */
+
+#include "sim_plant.h"
+#include "sim_time.h"
+#include "config.h" // Pin numbers and build-default probe calibration of the firmware under test
+
+// --- Module-Private (Static) Types & Variables ---
+
+/// @brief Pumps in the order used by `SimPlantState::pumpOnS`.
+enum { PUMP_A, PUMP_B, PUMP_PH, PUMP_IRRIGATION, PUMP_REFILL, NUM_SIM_PUMPS };
+
+static const uint8_t PUMP_PINS[NUM_SIM_PUMPS] = {
+  PUMP_NUTRISI_A_PIN, PUMP_NUTRISI_B_PIN, PUMP_PH_PIN, PUMP_SIRAM_PIN, PUMP_TANDON_PIN
+};
+/// @brief Motors draw several times their running load for a moment after switch-on.
+static const double INRUSH_MS = 150;
+static const double INRUSH_FACTOR = 2.5;
+static const double DRY_LOAD_FACTOR = 0.5;
+static const double BLOCKED_LOAD_FACTOR = 1.8;
+/// @brief Water temperature follows the air with this time constant.
+static const double WATER_TEMP_TAU_S = 3 * 3600.0;
+
+static SimPlantParams params;
+static SimPlantState state;
+static SimPumpFault faults[NUM_SIM_PUMPS];
+static bool pumpOn[NUM_SIM_PUMPS];
+static uint64_t pumpOnSinceUs[NUM_SIM_PUMPS];
+/// @brief Dissolved solids out in the channels, in ppm·liters.
+static double holdupMass = 0;
+/// @brief The solution each probe is in; NAN for the reservoir.
+static double phProbeSolution = NAN;
+static double tdsProbeSolution = NAN;
+/// @brief How far each probe still reads from its solution; decays with the probe's time constant.
+static double phProbeLag = 0;
+static double tdsProbeLag = 0;
+static uint32_t rngState = 1;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void step(uint64_t nowUs, uint64_t dtUs);
+static double pump_load_w(int pump, uint64_t nowUs);
+static double noise(double sigma);
+static int pump_for_pin(uint8_t pin);
+static double ph_probe_reading();
+static double tds_probe_reading();
+
+// --- Public Function Implementations ---
+
+SimPlantParams sim_plant_default_params() {
+  SimPlantParams p;
+  p.litersPerCm = TANDON_LITERS_PER_CM;
+  p.tankHeightCm = TANDON_MAX_HEIGHT_CM;
+  p.blindZoneCm = 0;
+  p.refillLps = 0.07;
+  p.refillPpm = 80;
+  p.refillPh = 7.2;
+  // Deliberately off the firmware's default PUMP_MS_PER_ML, like real pumps.
+  p.doseMlPerS[0] = 30.0;
+  p.doseMlPerS[1] = 36.0;
+  p.doseMlPerS[2] = 33.0;
+  p.doseDeadMs = 400;
+  p.ppmLitersPerMl = 60;
+  p.phPerMlPerLiter = 0.8;
+  p.phDriftPerHour = 0.01;
+  p.uptakePpmPerHour = 4;
+  p.transpirationLph = 0.15;
+  p.channelHoldupL = 6;
+  p.irrigationLps = 0.25;
+  p.drainLps = 0.05;
+  p.idleW = 2.5;
+  p.doseW = 3.5;
+  p.irrigationW = 15;
+  p.refillW = 7;
+  p.mainsV = 220;
+  p.powerFactor = 0.55;
+  // Captured before any provisioning, so a provisioned calibration can be wrong.
+  p.phProbeV[0] = PH_CALIBRATION_VOLTAGE_401;
+  p.phProbeV[1] = PH_CALIBRATION_VOLTAGE_686;
+  p.phProbeV[2] = PH_CALIBRATION_VOLTAGE_918;
+  p.tdsProbeK = TDS_K_VALUE;
+  p.phProbeTauS = 20;
+  p.tdsProbeTauS = 2;
+  p.sensorNoise = 1.0;
+  p.startHour = 6;
+  p.initialLevelCm = 60;
+  p.initialTdsPpm = 900;
+  p.initialPh = 6.2;
+  return p;
+}
+
+void sim_plant_init(const SimPlantParams& p, uint32_t seed) {
+  params = p;
+  memset(&state, 0, sizeof(state));
+  state.volumeL = p.initialLevelCm * p.litersPerCm;
+  state.tdsMass = p.initialTdsPpm * state.volumeL;
+  state.ph = p.initialPh;
+  state.airTempC = 28;
+  state.humidity = 75;
+  state.waterTempC = 25;
+  state.minLevelCm = state.maxLevelCm = p.initialLevelCm;
+  for (int i = 0; i < NUM_SIM_PUMPS; i++) {
+    faults[i] = SIM_PUMP_OK;
+    pumpOn[i] = false;
+    pumpOnSinceUs[i] = 0;
+  }
+  holdupMass = 0;
+  phProbeSolution = NAN;
+  tdsProbeSolution = NAN;
+  phProbeLag = 0;
+  tdsProbeLag = 0;
+  rngState = seed ? seed : 1;
+  sim_set_advance_hook(step);
+}
+
+const SimPlantState& sim_plant_state() {
+  return state;
+}
+
+double sim_plant_level_cm() {
+  return state.volumeL / params.litersPerCm;
+}
+
+double sim_plant_tds_ppm() {
+  return state.volumeL > 0 ? state.tdsMass / state.volumeL : 0;
+}
+
+void sim_plant_set_fault(uint8_t pin, SimPumpFault fault) {
+  int pump = pump_for_pin(pin);
+  if (pump >= 0) faults[pump] = fault;
+}
+
+void sim_plant_set_level_cm(double levelCm) {
+  double ppm = sim_plant_tds_ppm();
+  state.volumeL = levelCm * params.litersPerCm;
+  state.tdsMass = ppm * state.volumeL;
+}
+
+void sim_plant_set_tds_ppm(double ppm) {
+  state.tdsMass = ppm * state.volumeL;
+}
+
+void sim_plant_set_ph(double ph) {
+  state.ph = ph;
+}
+
+void sim_plant_dip_ph_probe(double ph) {
+  double reading = ph_probe_reading();
+  phProbeSolution = ph;
+  phProbeLag = reading - (isnan(ph) ? state.ph : ph);
+}
+
+void sim_plant_dip_tds_probe(double ppm) {
+  double reading = tds_probe_reading();
+  tdsProbeSolution = ppm;
+  tdsProbeLag = reading - (isnan(ppm) ? sim_plant_tds_ppm() : ppm);
+}
+
+unsigned int sim_plant_ping_cm() {
+  double distance = params.tankHeightCm - sim_plant_level_cm();
+  // The irrigation return makes the surface choppy.
+  distance += noise(pumpOn[PUMP_IRRIGATION] ? 1.0 : 0.3);
+  if (distance < params.blindZoneCm || distance < 1) return 0;
+  return (unsigned int)(distance + 0.5);
+}
+
+uint16_t sim_plant_adc(uint8_t pin) {
+  double voltage;
+  if (pin == TDS_SENSOR_PIN) {
+    // Inverse of the firmware's temperature-compensated TDS conversion.
+    voltage = tds_probe_reading() * (1.0 + TDS_TEMP_COEFF * (state.waterTempC - 25.0)) / params.tdsProbeK;
+  } else if (pin == PH_SENSOR_PIN) {
+    // Inverse of the firmware's piecewise-linear pH calibration.
+    double ph = ph_probe_reading();
+    if (ph <= 6.86) {
+      double slope = (params.phProbeV[0] - params.phProbeV[1]) / (4.01 - 6.86);
+      voltage = params.phProbeV[1] + (ph - 6.86) * slope;
+    } else {
+      double slope = (params.phProbeV[1] - params.phProbeV[2]) / (6.86 - 9.18);
+      voltage = params.phProbeV[2] + (ph - 9.18) * slope;
+    }
+  } else {
+    return 0;
+  }
+  double counts = voltage / 3.3 * 4095 + noise(3);
+  return (uint16_t)constrain(counts + 0.5, 0.0, 4095.0);
+}
+
+float sim_plant_probe_temp_c() {
+  // DS18B20 at 12-bit resolution.
+  double t = state.waterTempC + noise(0.05);
+  return (float)(floor(t * 16 + 0.5) / 16);
+}
+
+float sim_plant_air_temp_c() {
+  return (float)(floor((state.airTempC + noise(0.1)) * 10 + 0.5) / 10);
+}
+
+float sim_plant_humidity() {
+  return (float)(floor(constrain(state.humidity + noise(0.5), 0.0, 100.0) * 10 + 0.5) / 10);
+}
+
+float sim_plant_mains_v() {
+  return (float)(floor((params.mainsV + noise(0.8)) * 10 + 0.5) / 10);
+}
+
+float sim_plant_load_w() {
+  uint64_t now = sim_now_us();
+  double load = params.idleW;
+  for (int i = 0; i < NUM_SIM_PUMPS; i++) load += pump_load_w(i, now);
+  return (float)(floor(max(0.0, load + noise(0.1)) * 10 + 0.5) / 10);
+}
+
+float sim_plant_load_a() {
+  double amps = sim_plant_load_w() / (params.mainsV * params.powerFactor);
+  return (float)(floor(amps * 1000 + 0.5) / 1000);
+}
+
+float sim_plant_power_factor() {
+  return (float)params.powerFactor;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Integrates the plant over one clock step. Relay states are read back from the GPIO outputs.
+ */
+static void step(uint64_t nowUs, uint64_t dtUs) {
+  double dt = dtUs / 1e6;
+  double hours = dt / 3600.0;
+
+  for (int i = 0; i < NUM_SIM_PUMPS; i++) {
+    // The relay switched before this step began.
+    bool on = digitalRead(PUMP_PINS[i]) == HIGH;
+    if (on && !pumpOn[i]) pumpOnSinceUs[i] = nowUs - dtUs;
+    pumpOn[i] = on;
+    if (on) state.pumpOnS[i] += dt;
+  }
+
+  // Dosing pumps deliver once their tubing is primed. Steps can be long
+  // (blocking sensor reads), so only the primed part of the step counts.
+  for (int i = PUMP_A; i <= PUMP_PH; i++) {
+    if (!pumpOn[i] || faults[i] != SIM_PUMP_OK) continue;
+    double primedS = ((double)nowUs - pumpOnSinceUs[i]) / 1e6 - params.doseDeadMs / 1000;
+    if (primedS <= 0) continue;
+    double ml = params.doseMlPerS[i] * min(dt, primedS);
+    state.dispensedMl[i] += ml;
+    if (i == PUMP_PH) {
+      if (state.volumeL > 1) state.ph -= params.phPerMlPerLiter * ml / state.volumeL;
+    } else {
+      state.tdsMass += params.ppmLitersPerMl * ml;
+    }
+    state.volumeL += ml / 1000.0;
+  }
+
+  // Irrigation fills the channels; anything beyond their hold-up returns at once.
+  if (pumpOn[PUMP_IRRIGATION] && faults[PUMP_IRRIGATION] == SIM_PUMP_OK) {
+    double move = min(params.irrigationLps * dt, min(params.channelHoldupL - state.holdupL, state.volumeL));
+    if (move > 0) {
+      double mass = state.tdsMass * move / state.volumeL;
+      state.volumeL -= move;
+      state.tdsMass -= mass;
+      state.holdupL += move;
+      holdupMass += mass;
+    }
+  } else if (state.holdupL > 0) {
+    double back = min(params.drainLps * dt, state.holdupL);
+    double mass = holdupMass * back / state.holdupL;
+    state.holdupL -= back;
+    holdupMass -= mass;
+    state.volumeL += back;
+    state.tdsMass += mass;
+  }
+
+  if (pumpOn[PUMP_REFILL] && faults[PUMP_REFILL] == SIM_PUMP_OK) {
+    double added = params.refillLps * dt;
+    state.ph = (state.ph * state.volumeL + params.refillPh * added) / (state.volumeL + added);
+    state.tdsMass += params.refillPpm * added;
+    state.volumeL += added;
+    state.refilledL += added;
+  }
+
+  // Plants take up water and nutrients and slowly raise the pH.
+  state.volumeL = max(0.0, state.volumeL - params.transpirationLph * hours);
+  state.tdsMass = max(0.0, state.tdsMass - params.uptakePpmPerHour * state.volumeL * hours);
+  state.ph += params.phDriftPerHour * hours;
+
+  double capacity = params.tankHeightCm * params.litersPerCm;
+  if (state.volumeL > capacity) {
+    double spilled = state.volumeL - capacity;
+    state.tdsMass -= state.tdsMass * spilled / state.volumeL;
+    state.overflowL += spilled;
+    state.volumeL = capacity;
+  }
+  double level = sim_plant_level_cm();
+  state.minLevelCm = min(state.minLevelCm, level);
+  state.maxLevelCm = max(state.maxLevelCm, level);
+
+  // A warm afternoon and a cool night.
+  double hourOfDay = fmod(params.startHour + nowUs / 3.6e9, 24.0);
+  state.airTempC = 28 + 5 * sin(2 * M_PI * (hourOfDay - 9) / 24);
+  state.humidity = constrain(75 - 2.5 * (state.airTempC - 28), 20.0, 100.0);
+  state.waterTempC += (state.airTempC - 2 - state.waterTempC) * min(1.0, dt / WATER_TEMP_TAU_S);
+
+  // Electrodes approach a new solution exponentially.
+  phProbeLag *= exp(-dt / params.phProbeTauS);
+  tdsProbeLag *= exp(-dt / params.tdsProbeTauS);
+
+  double load = params.idleW;
+  for (int i = 0; i < NUM_SIM_PUMPS; i++) load += pump_load_w(i, nowUs);
+  state.energyWh += load * hours;
+}
+
+/**
+ * @brief The electrical load of one pump, including inrush and fault signatures.
+ */
+static double pump_load_w(int pump, uint64_t nowUs) {
+  if (!pumpOn[pump] || faults[pump] == SIM_PUMP_RELAY) return 0;
+  double watts = pump <= PUMP_PH ? params.doseW : pump == PUMP_IRRIGATION ? params.irrigationW : params.refillW;
+  if (faults[pump] == SIM_PUMP_DRY) watts *= DRY_LOAD_FACTOR;
+  if (faults[pump] == SIM_PUMP_BLOCKED) watts *= BLOCKED_LOAD_FACTOR;
+  if (nowUs - pumpOnSinceUs[pump] < INRUSH_MS * 1000) watts *= INRUSH_FACTOR;
+  return watts;
+}
+
+/**
+ * @brief The pH the probe reads: its solution's, until it has settled in it.
+ */
+static double ph_probe_reading() {
+  return (isnan(phProbeSolution) ? state.ph : phProbeSolution) + phProbeLag;
+}
+
+/**
+ * @brief The TDS the probe reads: its solution's, until it has settled in it.
+ */
+static double tds_probe_reading() {
+  return (isnan(tdsProbeSolution) ? sim_plant_tds_ppm() : tdsProbeSolution) + tdsProbeLag;
+}
+
+/**
+ * @brief Gaussian noise (Box-Muller over xorshift32), scaled by `sensorNoise`.
+ */
+static double noise(double sigma) {
+  if (params.sensorNoise <= 0) return 0;
+  double u[2];
+  for (int i = 0; i < 2; i++) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    u[i] = (rngState + 1.0) / 4294967297.0;
+  }
+  return sigma * params.sensorNoise * sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+/**
+ * @brief Maps a relay pin to its index in `PUMP_PINS`, or -1.
+ */
+static int pump_for_pin(uint8_t pin) {
+  for (int i = 0; i < NUM_SIM_PUMPS; i++) {
+    if (PUMP_PINS[i] == pin) return i;
+  }
+  return -1;
+}
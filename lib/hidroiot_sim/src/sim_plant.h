@@ -0,0 +1,146 @@
+/**
+ * @file sim_plant.h
+ * @brief The simulated hydroponic plant behind the native build's sensors and relays.
+ *
+ * Models the reservoir volume and its inflow (refill valve) and outflow
+ * (irrigation channel hold-up, transpiration), the nutrient and pH-down
+ * concentrations including mixing with refill water, the air and water
+ * temperatures over the day, and the electrical load of the pumps.
+ *
+ * The sensor stand-ins read from it through the same transfer functions the
+ * firmware inverts (ultrasonic distance, TDS and pH probe voltages), so the
+ * firmware's conversion math is exercised as well. Pin numbers come from the
+ * firmware's config.h, and the probes' true characteristics from its build
+ * defaults, so a board provisioned with another calibration reads off until
+ * it is calibrated. The probes can be put into a buffer or standard solution,
+ * where they settle like real electrodes.
+ */
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <stdint.h>
+
+/**
+ * @enum SimPumpFault
+ * @brief Hardware faults that can be injected per pump.
+ */
+enum SimPumpFault {
+  SIM_PUMP_OK,      ///< Runs normally.
+  SIM_PUMP_DRY,     ///< Supply empty: runs at reduced load and delivers nothing.
+  SIM_PUMP_BLOCKED, ///< Outlet blocked: runs at elevated load and delivers nothing.
+  SIM_PUMP_RELAY    ///< Relay contact open: no load and no delivery.
+};
+
+/**
+ * @struct SimPlantParams
+ * @brief Physical constants of the simulated installation.
+ */
+struct SimPlantParams {
+  double litersPerCm;         ///< Reservoir volume per cm of water level.
+  double tankHeightCm;        ///< Reservoir height; the ultrasonic sensor sits at the top.
+  double blindZoneCm;         ///< Distances below this return no echo (0 = ideal sensor).
+  double refillLps;           ///< Refill valve flow in liters per second.
+  double refillPpm;           ///< TDS of the refill water.
+  double refillPh;            ///< pH of the refill water.
+  double doseMlPerS[3];       ///< True flow of the nutrient A, nutrient B and pH pumps.
+  double doseDeadMs;          ///< Time from switch-on until a dosing pump delivers.
+  double ppmLitersPerMl;      ///< TDS rise from 1 ml of one nutrient part in 1 liter.
+  double phPerMlPerLiter;     ///< pH drop from 1 ml of pH-down in 1 liter.
+  double phDriftPerHour;      ///< Upward pH drift from plant uptake.
+  double uptakePpmPerHour;    ///< Nutrient uptake by the plants.
+  double transpirationLph;    ///< Water uptake by the plants.
+  double channelHoldupL;      ///< Water held in the grow channels while irrigating.
+  double irrigationLps;       ///< Irrigation pump flow into the channels.
+  double drainLps;            ///< Channel drain-back flow after irrigation stops.
+  double idleW;               ///< Controller and sensor load.
+  double doseW;               ///< Load of one running dosing pump.
+  double irrigationW;         ///< Load of the irrigation pump.
+  double refillW;             ///< Load of the refill valve coil.
+  double mainsV;              ///< Mains voltage.
+  double powerFactor;         ///< Power factor of the supply.
+  double phProbeV[3];         ///< True pH probe output at pH 4.01, 6.86 and 9.18.
+  double tdsProbeK;           ///< True TDS probe cell constant (ppm per volt at 25 °C).
+  double phProbeTauS;         ///< pH electrode response time constant.
+  double tdsProbeTauS;        ///< TDS probe response time constant.
+  double sensorNoise;         ///< Scale of all sensor noise (0 = noiseless).
+  double startHour;           ///< Time of day at power-on.
+  double initialLevelCm;      ///< Initial water level.
+  double initialTdsPpm;       ///< Initial TDS.
+  double initialPh;           ///< Initial pH.
+};
+
+/**
+ * @struct SimPlantState
+ * @brief The true state of the plant, for assertions and the run summary.
+ */
+struct SimPlantState {
+  double volumeL;          ///< Water in the reservoir.
+  double tdsMass;          ///< Dissolved solids in ppm·liters.
+  double ph;               ///< Reservoir pH.
+  double holdupL;          ///< Water currently out in the grow channels.
+  double waterTempC;       ///< Reservoir temperature.
+  double airTempC;         ///< Greenhouse air temperature.
+  double humidity;         ///< Greenhouse relative humidity.
+  double energyWh;         ///< Energy drawn since power-on.
+  double dispensedMl[3];   ///< Volume actually delivered by each dosing pump.
+  double refilledL;        ///< Water added by the refill valve.
+  double overflowL;        ///< Water spilled over the reservoir rim.
+  double minLevelCm;       ///< Lowest level reached.
+  double maxLevelCm;       ///< Highest level reached.
+  double pumpOnS[5];       ///< Relay on-time of nutrient A, B, pH, irrigation and refill.
+};
+
+/**
+ * @brief Returns parameters matching the greenhouse_a installation.
+ * @return The default parameters.
+ */
+SimPlantParams sim_plant_default_params();
+
+/**
+ * @brief Initializes the plant and hooks it to the virtual clock.
+ * @param params The physical constants.
+ * @param seed Seed for the sensor noise; equal seeds give identical runs.
+ */
+void sim_plant_init(const SimPlantParams& params, uint32_t seed);
+
+/**
+ * @brief Returns the true plant state.
+ * @return The state at the current virtual time.
+ */
+const SimPlantState& sim_plant_state();
+
+/// @brief The true water level in cm.
+double sim_plant_level_cm();
+/// @brief The true TDS in ppm.
+double sim_plant_tds_ppm();
+
+/**
+ * @brief Injects (or clears) a fault on the pump driven by a relay pin.
+ * @param pin The relay pin from config.h.
+ * @param fault The fault.
+ */
+void sim_plant_set_fault(uint8_t pin, SimPumpFault fault);
+
+/// @brief Overrides the water level, e.g. to start a scenario near a threshold.
+void sim_plant_set_level_cm(double levelCm);
+/// @brief Overrides the TDS.
+void sim_plant_set_tds_ppm(double ppm);
+/// @brief Overrides the pH.
+void sim_plant_set_ph(double ph);
+/// @brief Puts the pH probe into a buffer of that pH, or back into the reservoir (NAN).
+void sim_plant_dip_ph_probe(double ph);
+/// @brief Puts the TDS probe into a standard of that TDS, or back into the reservoir (NAN).
+void sim_plant_dip_tds_probe(double ppm);
+
+// --- Sensor transfer functions, used by the library stand-ins ---
+unsigned int sim_plant_ping_cm();
+uint16_t sim_plant_adc(uint8_t pin);
+float sim_plant_probe_temp_c();
+float sim_plant_air_temp_c();
+float sim_plant_humidity();
+float sim_plant_mains_v();
+float sim_plant_load_w();
+float sim_plant_load_a();
+float sim_plant_power_factor();
+
+#endif // SIM_PLANT_H
@@ -0,0 +1,169 @@
+/**
+ * @file sim_scenario.cpp
+ * @brief Parses scenario lines and applies them to the plant and the broker at their time.
+ */
+
+#include "sim_scenario.h"
+#include "config.h"
+#include "sim_board.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_time.h"
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct ScenarioEvent
+ * @brief One scenario line.
+ */
+struct ScenarioEvent {
+  uint64_t atUs;
+  std::string target;
+  std::string value;
+};
+
+static std::vector<ScenarioEvent> scenario;
+static size_t nextEvent = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool parse_line(char* line, const char* source, int lineNo);
+static bool parse_duration_us(const std::string& text, uint64_t& us);
+static int pin_for_pump(const std::string& key);
+
+// --- Public Function Implementations ---
+
+bool sim_scenario_load(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot open scenario %s\n", path);
+    return false;
+  }
+  char line[512];
+  int lineNo = 0;
+  bool ok = true;
+  while (fgets(line, sizeof(line), file)) {
+    lineNo++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!parse_line(line, path, lineNo)) ok = false;
+  }
+  fclose(file);
+  return ok;
+}
+
+bool sim_scenario_add(const char* line) {
+  std::string copy = line;
+  return parse_line(&copy[0], "scenario", 1);
+}
+
+void sim_scenario_step() {
+  while (nextEvent < scenario.size() && scenario[nextEvent].atUs <= sim_now_us()) {
+    const ScenarioEvent& event = scenario[nextEvent++];
+    sim_scenario_apply(event.target.c_str(), event.value.c_str());
+  }
+}
+
+bool sim_scenario_apply(const char* targetText, const char* valueText) {
+  std::string target = targetText;
+  std::string value = valueText;
+  if (target.compare(0, 4, "sim.") != 0) {
+    sim_mqtt_inject(sim_scenario_topic(target), value);
+    return true;
+  }
+  if (target == "sim.level_cm") sim_plant_set_level_cm(atof(value.c_str()));
+  else if (target == "sim.tds_ppm") sim_plant_set_tds_ppm(atof(value.c_str()));
+  else if (target == "sim.ph") sim_plant_set_ph(atof(value.c_str()));
+  else if (target == "sim.ph_probe" || target == "sim.tds_probe") {
+    double solution = value == "tank" ? NAN : atof(value.c_str());
+    if (target == "sim.ph_probe") sim_plant_dip_ph_probe(solution);
+    else sim_plant_dip_tds_probe(solution);
+  }
+  else if (target == "sim.wifi") sim_board_set_wifi_available(value == "up");
+  else if (target == "sim.broker") sim_mqtt_set_broker_running(value == "up", value != "wipe");
+  else if (target == "sim.retain" || target == "sim.flood") {
+    // "[<count> ]<topic> <payload>"
+    const char* text = value.c_str();
+    char* end = nullptr;
+    long count = target == "sim.flood" ? strtol(text, &end, 10) : 1;
+    if (end != nullptr) text = end + strspn(end, " ");
+    const char* payload = text + strcspn(text, " ");
+    std::string topic(text, payload - text);
+    if (topic.empty() || count < 1) return false;
+    topic = sim_scenario_topic(topic);
+    payload += strspn(payload, " ");
+    if (target == "sim.retain") sim_mqtt_retain(topic, payload);
+    for (long i = 0; target == "sim.flood" && i < count; i++) sim_mqtt_inject(topic, payload);
+  }
+  else if (target == "sim.fault") {
+    char pump[32], kind[16];
+    if (sscanf(value.c_str(), "%31s %15s", pump, kind) != 2 || pin_for_pump(pump) < 0) return false;
+    SimPumpFault fault = strcmp(kind, "dry") == 0 ? SIM_PUMP_DRY
+                       : strcmp(kind, "blocked") == 0 ? SIM_PUMP_BLOCKED
+                       : strcmp(kind, "relay") == 0 ? SIM_PUMP_RELAY : SIM_PUMP_OK;
+    sim_plant_set_fault(pin_for_pump(pump), fault);
+  } else {
+    fprintf(stderr, "Unknown scenario target %s\n", target.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string sim_scenario_topic(const std::string& topic) {
+  return !topic.empty() && topic[0] == '~' ? std::string(BASE_TOPIC) + topic.substr(1) : topic;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Parses one line into `scenario`, keeping it sorted by time.
+ */
+static bool parse_line(char* line, const char* source, int lineNo) {
+  char* ctx = nullptr;
+  char* time = strtok_r(line, " \t", &ctx);
+  if (time == nullptr || time[0] == '#') return true;
+  char* target = strtok_r(nullptr, " \t", &ctx);
+  char* value = ctx ? ctx + strspn(ctx, " \t") : nullptr;
+
+  ScenarioEvent event;
+  if (target == nullptr || !parse_duration_us(time, event.atUs)) {
+    fprintf(stderr, "%s:%d: expected '<time> <target> <value>'\n", source, lineNo);
+    return false;
+  }
+  event.target = target;
+  event.value = value ? value : "";
+  size_t pos = scenario.size();
+  while (pos > nextEvent && scenario[pos - 1].atUs > event.atUs) pos--;
+  scenario.insert(scenario.begin() + pos, event);
+  return true;
+}
+
+/**
+ * @brief Parses "90", "90s", "15m" or "1.5h" into microseconds.
+ */
+static bool parse_duration_us(const std::string& text, uint64_t& us) {
+  char* end = nullptr;
+  double amount = strtod(text.c_str(), &end);
+  if (end == text.c_str() || amount < 0) return false;
+  double scale = 1;
+  if (*end == 'm') scale = 60;
+  else if (*end == 'h') scale = 3600;
+  else if (*end != 's' && *end != '\0') return false;
+  us = (uint64_t)(amount * scale * 1e6);
+  return true;
+}
+
+/**
+ * @brief Maps a pump key as used in the MQTT topics to its relay pin.
+ */
+static int pin_for_pump(const std::string& key) {
+  if (key == "nutrisi_a") return PUMP_NUTRISI_A_PIN;
+  if (key == "nutrisi_b") return PUMP_NUTRISI_B_PIN;
+  if (key == "ph") return PUMP_PH_PIN;
+  if (key == "penyiraman") return PUMP_SIRAM_PIN;
+  if (key == "tandon") return PUMP_TANDON_PIN;
+  return -1;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file sim_scenario.h
+ * @brief Timed commands and plant events for the native simulator.
+ *
+ * A scenario is a list of `<time> <target> <value>` lines (see sim_main.cpp),
+ * read from a file by the simulator or added line by line by the tests under
+ * test/. Events are applied in time order once virtual time reaches them.
+ */
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * @brief Reads a scenario file and adds its events.
+ * @param path The file to read.
+ * @return true if every line was understood.
+ */
+bool sim_scenario_load(const char* path);
+
+/**
+ * @brief Adds one scenario line, e.g. `"90m ~/pompa/tandon/kontrol ON"`.
+ * Blank lines and comments starting with `#` are ignored.
+ * @param line The line.
+ * @return true if the line was understood.
+ */
+bool sim_scenario_add(const char* line);
+
+/**
+ * @brief Applies every event whose time has come. Call before each `loop()`.
+ */
+void sim_scenario_step();
+
+/**
+ * @brief Applies an event at once, e.g. `sim_scenario_apply("sim.fault", "nutrisi_a dry")`.
+ * A target starting with `~` is a topic below the base topic.
+ * @param target The plant event or MQTT topic.
+ * @param value Its value or payload.
+ * @return true if the event was understood.
+ */
+bool sim_scenario_apply(const char* target, const char* value);
+
+/**
+ * @brief Expands a leading `~` to the base topic, which is only known once `setup()` has run.
+ * @param topic The topic.
+ * @return The full topic.
+ */
+std::string sim_scenario_topic(const std::string& topic);
+
+#endif // SIM_SCENARIO_H
@@ -0,0 +1,23 @@
+/**
+ * @file sim_time.cpp
+ * @brief Implements the simulator's virtual clock.
+ */
+
+#include "sim_time.h"
+
+static uint64_t nowUs = 0;
+static void (*advanceHook)(uint64_t, uint64_t) = nullptr;
+
+uint64_t sim_now_us() {
+  return nowUs;
+}
+
+void sim_advance_us(uint64_t us) {
+  if (us == 0) return;
+  nowUs += us;
+  if (advanceHook) advanceHook(nowUs, us);
+}
+
+void sim_set_advance_hook(void (*hook)(uint64_t nowUs, uint64_t dtUs)) {
+  advanceHook = hook;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file sim_time.h
+ * @brief Virtual time for the native simulator.
+ *
+ * `millis()`, `micros()` and `delay()` run on this clock instead of the host's,
+ * so the firmware's `loop()` runs as fast as the host allows. Advancing the
+ * clock also advances the simulated plant.
+ */
+#ifndef SIM_TIME_H
+#define SIM_TIME_H
+
+#include <stdint.h>
+
+/**
+ * @brief Returns the virtual time since boot.
+ * @return Microseconds since the simulated power-on.
+ */
+uint64_t sim_now_us();
+
+/**
+ * @brief Advances the virtual clock and steps the plant model by the same amount.
+ * @param us The number of microseconds to advance.
+ */
+void sim_advance_us(uint64_t us);
+
+/**
+ * @brief Registers the function that steps the plant whenever time advances.
+ * @param hook Called with the new time and the step length, both in microseconds.
+ */
+void sim_set_advance_hook(void (*hook)(uint64_t nowUs, uint64_t dtUs));
+
+#endif // SIM_TIME_H
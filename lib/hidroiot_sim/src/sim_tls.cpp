@@ -0,0 +1,249 @@
+/**
+ * @file sim_tls.cpp
+ * @brief Implements the in-process broker's TLS listener on OpenSSL.
+ */
+
+#include "sim_tls.h"
+#include "sim_mqtt.h"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+static bool enabled = false;
+static std::string host;
+static EVP_PKEY* caKey = nullptr;
+static X509* caCert = nullptr;
+static std::string caPem;
+static EVP_PKEY* brokerKey = nullptr;
+static X509* brokerCert = nullptr;
+static char pinHex[65] = "";
+static long nextSerial = 1;
+/// @brief Holds the certificate, the session cache and the ticket keys.
+static SSL_CTX* context = nullptr;
+
+/// @brief The device's connection: the device's bytes go into `fromDevice`, the broker's come out of `toDevice`.
+static SSL* connection = nullptr;
+static BIO* fromDevice = nullptr;
+static BIO* toDevice = nullptr;
+/// @brief Whether the connection failed and only waits to be closed.
+static bool broken = false;
+static SimTlsStats stats = {0, 0, 0, 0};
+
+// --- Forward Declarations for Static (Private) Functions ---
+static EVP_PKEY* make_key();
+static X509* make_certificate(EVP_PKEY* key, const std::string& commonName, bool ca);
+static void add_extension(X509* cert, X509* issuer, int nid, const std::string& value);
+static bool make_broker_certificate();
+static void make_context();
+static void pump();
+
+// --- Public Function Implementations ---
+
+bool sim_tls_enable(const char* hostName) {
+  host = hostName;
+  EVP_PKEY_free(caKey);
+  X509_free(caCert);
+  caKey = make_key();
+  caCert = caKey ? make_certificate(caKey, "HidroIoT simulator CA", true) : nullptr;
+  if (caCert == nullptr) return false;
+  BIO* pem = BIO_new(BIO_s_mem());
+  PEM_write_bio_X509(pem, caCert);
+  char* data = nullptr;
+  long length = BIO_get_mem_data(pem, &data);
+  caPem.assign(data, length);
+  BIO_free(pem);
+  enabled = make_broker_certificate();
+  return enabled;
+}
+
+bool sim_tls_enabled() {
+  return enabled;
+}
+
+const char* sim_tls_ca_pem() {
+  return caPem.c_str();
+}
+
+const char* sim_tls_pubkey_sha256() {
+  return pinHex;
+}
+
+bool sim_tls_renew_key() {
+  return enabled && make_broker_certificate();
+}
+
+void sim_tls_forget_sessions() {
+  if (enabled) make_context();
+}
+
+const SimTlsStats& sim_tls_stats() {
+  return stats;
+}
+
+void sim_tls_open() {
+  sim_tls_close();
+  connection = SSL_new(context);
+  fromDevice = BIO_new(BIO_s_mem());
+  toDevice = BIO_new(BIO_s_mem());
+  SSL_set_bio(connection, fromDevice, toDevice);
+  SSL_set_accept_state(connection);
+  broken = false;
+}
+
+void sim_tls_close() {
+  // SSL_free() frees both BIOs.
+  SSL_free(connection);
+  connection = nullptr;
+  fromDevice = nullptr;
+  toDevice = nullptr;
+  ERR_clear_error();
+}
+
+size_t sim_tls_client_write(const uint8_t* buffer, size_t size) {
+  if (connection == nullptr) return 0;
+  BIO_write(fromDevice, buffer, (int)size);
+  pump();
+  return size;
+}
+
+int sim_tls_client_available() {
+  if (connection == nullptr) return 0;
+  pump();
+  return (int)BIO_ctrl_pending(toDevice);
+}
+
+int sim_tls_client_read() {
+  if (sim_tls_client_available() == 0) return -1;
+  uint8_t c;
+  return BIO_read(toDevice, &c, 1) == 1 ? c : -1;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Makes a P-256 key, as brokers commonly use with the ESP32.
+ */
+static EVP_PKEY* make_key() {
+  EVP_PKEY* key = nullptr;
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+  if (ctx != nullptr && EVP_PKEY_keygen_init(ctx) == 1 &&
+      EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1) == 1) {
+    EVP_PKEY_keygen(ctx, &key);
+  }
+  EVP_PKEY_CTX_free(ctx);
+  return key;
+}
+
+/**
+ * @brief Makes the CA's self-signed certificate, or a broker certificate
+ * signed by the CA with `commonName` as its DNS name too.
+ */
+static X509* make_certificate(EVP_PKEY* key, const std::string& commonName, bool ca) {
+  X509* cert = X509_new();
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), nextSerial++);
+  X509_gmtime_adj(X509_getm_notBefore(cert), -24L * 3600);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 10L * 365 * 24 * 3600);
+  X509_set_pubkey(cert, key);
+  X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                             (const unsigned char*)commonName.c_str(), -1, -1, 0);
+  X509* issuer = ca ? cert : caCert;
+  X509_set_issuer_name(cert, X509_get_subject_name(issuer));
+  if (ca) {
+    add_extension(cert, issuer, NID_basic_constraints, "critical,CA:TRUE");
+    add_extension(cert, issuer, NID_key_usage, "critical,keyCertSign,cRLSign");
+  } else {
+    add_extension(cert, issuer, NID_basic_constraints, "CA:FALSE");
+    add_extension(cert, issuer, NID_subject_alt_name, "DNS:" + commonName);
+  }
+  if (X509_sign(cert, caKey, EVP_sha256()) == 0) {
+    X509_free(cert);
+    return nullptr;
+  }
+  return cert;
+}
+
+static void add_extension(X509* cert, X509* issuer, int nid, const std::string& value) {
+  X509V3_CTX v3;
+  X509V3_set_ctx_nodb(&v3);
+  X509V3_set_ctx(&v3, issuer, cert, nullptr, nullptr, 0);
+  X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &v3, nid, value.c_str());
+  if (extension != nullptr) X509_add_ext(cert, extension, -1);
+  X509_EXTENSION_free(extension);
+}
+
+/**
+ * @brief Gives the broker a new key and certificate for `host` and forgets the sessions.
+ */
+static bool make_broker_certificate() {
+  EVP_PKEY* key = make_key();
+  X509* cert = key ? make_certificate(key, host, false) : nullptr;
+  if (cert == nullptr) {
+    EVP_PKEY_free(key);
+    return false;
+  }
+  EVP_PKEY_free(brokerKey);
+  X509_free(brokerCert);
+  brokerKey = key;
+  brokerCert = cert;
+
+  unsigned char* der = nullptr;
+  int length = i2d_PUBKEY(brokerKey, &der);
+  unsigned char hash[SHA256_DIGEST_LENGTH];
+  SHA256(der, length, hash);
+  OPENSSL_free(der);
+  for (size_t i = 0; i < sizeof(hash); i++) snprintf(pinHex + 2 * i, 3, "%02x", hash[i]);
+
+  make_context();
+  return true;
+}
+
+/**
+ * @brief Sets up the listener with the broker's certificate. A new context has
+ * an empty session cache and new ticket keys.
+ */
+static void make_context() {
+  SSL_CTX_free(context);
+  context = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+  SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION);
+  SSL_CTX_use_certificate(context, brokerCert);
+  SSL_CTX_use_PrivateKey(context, brokerKey);
+  static const unsigned char SESSION_CONTEXT[] = "hidroiot-sim";
+  SSL_CTX_set_session_id_context(context, SESSION_CONTEXT, sizeof(SESSION_CONTEXT) - 1);
+}
+
+/**
+ * @brief Advances the handshake with what the device sent, takes in its
+ * records and encrypts what the broker has for it.
+ */
+static void pump() {
+  if (connection == nullptr || broken) return;
+  if (!SSL_is_init_finished(connection)) {
+    int ret = SSL_do_handshake(connection);
+    if (ret != 1) {
+      if (SSL_get_error(connection, ret) != SSL_ERROR_WANT_READ) {
+        stats.failed++;
+        broken = true;
+      }
+      ERR_clear_error();
+      return;
+    }
+    if (SSL_session_reused(connection)) stats.resumed++;
+    else stats.full++;
+  }
+  uint8_t buffer[512];
+  int n;
+  while ((n = SSL_read(connection, buffer, sizeof(buffer))) > 0) stats.bytesIn += n;
+  std::vector<uint8_t> plaintext;
+  while (sim_mqtt_client_available() > 0) plaintext.push_back((uint8_t)sim_mqtt_client_read());
+  if (!plaintext.empty()) SSL_write(connection, &plaintext[0], (int)plaintext.size());
+  ERR_clear_error();
+}
@@ -0,0 +1,82 @@
+/**
+ * @file sim_tls.h
+ * @brief A TLS listener for the simulator's in-process broker.
+ *
+ * Once enabled, the device's connection to the broker carries TLS 1.2 records
+ * instead of plaintext: the WiFiClient stand-in hands the device's bytes to an
+ * OpenSSL server here and reads back what it answers, and the broker's packets
+ * (so far its CONNACK) are encrypted on their way to the device. The firmware's
+ * TLS client (src/mqtt_tls.cpp, on the mbedTLS stand-in in mbedtls/ssl.h) thus
+ * runs its real handshakes, certificate checks and session resumption.
+ *
+ * A CA and a broker certificate for the given host name are generated when
+ * TLS is enabled. Like a broker's, the session cache and ticket keys live in
+ * memory: they are lost whenever the broker stops, so the next handshake is a
+ * full one. Only the in-process broker listens with TLS, not `--broker`.
+ */
+#ifndef SIM_TLS_H
+#define SIM_TLS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @struct SimTlsStats
+ * @brief The handshakes the broker saw.
+ */
+struct SimTlsStats {
+  uint32_t full;     ///< Handshakes with a certificate and a new key exchange.
+  uint32_t resumed;  ///< Handshakes that resumed a session.
+  uint32_t failed;   ///< Handshakes the device or the broker aborted.
+  uint64_t bytesIn;  ///< Application bytes decrypted from the device.
+};
+
+/**
+ * @brief Makes the broker listen with TLS, with a new CA and a broker
+ * certificate for `hostName`. Call before `setup()`.
+ * @param hostName The name the device connects to, e.g. `MQTT_SERVER`.
+ * @return false if the certificates could not be made.
+ */
+bool sim_tls_enable(const char* hostName);
+
+/**
+ * @brief Returns whether the broker listens with TLS.
+ */
+bool sim_tls_enabled();
+
+/**
+ * @brief Returns the CA certificate in PEM, for `MQTT_TLS_CA_CERT`.
+ */
+const char* sim_tls_ca_pem();
+
+/**
+ * @brief Returns the SHA-256 of the broker key's SubjectPublicKeyInfo in hex,
+ * for `MQTT_TLS_PUBKEY_SHA256` (provisioned as `mqtt_pin`).
+ */
+const char* sim_tls_pubkey_sha256();
+
+/**
+ * @brief Gives the broker a new key and certificate from the same CA, as when
+ * its certificate is renewed. Stored sessions are forgotten.
+ * @return false if the certificate could not be made.
+ */
+bool sim_tls_renew_key();
+
+/**
+ * @brief Forgets every session the broker could resume, as a broker restart does.
+ */
+void sim_tls_forget_sessions();
+
+/**
+ * @brief Returns the handshake counters.
+ */
+const SimTlsStats& sim_tls_stats();
+
+// --- Used by the WiFiClient stand-in ---
+void sim_tls_open();
+void sim_tls_close();
+size_t sim_tls_client_write(const uint8_t* buffer, size_t size);
+int sim_tls_client_available();
+int sim_tls_client_read();
+
+#endif // SIM_TLS_H
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""Builds a firmware update file for the device's MQTT updater (src/ota.h).
+
+    ota/make_update.py NEW.bin -o update.bin [--base RUNNING.bin] [--method auto|raw|lz|delta]
+
+NEW.bin is the application image PlatformIO builds (.pio/build/<env>/firmware.bin).
+With --base, the image the devices run now, a delta is tried as well: it copies
+unchanged code from the running partition, so only what changed is sent.
+`auto` (the default) writes the smallest file. The format is described in
+src/ota_patch.h. Every file is decoded again before it is written, exactly as
+the device will, and must rebuild NEW.bin byte for byte.
+
+Prints one JSON line with the size of each method and the savings over a raw
+transfer.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+MAGIC = 0x41544F48  # "HOTA"
+VERSION = 1
+HEADER_SIZE = 32
+METHODS = {"raw": 0, "lz": 1, "delta": 2}
+
+OP_LITERAL, OP_COPY_OUT, OP_COPY_BASE = 0, 1, 2
+KEY_SIZE = 8           # Bytes hashed to find match candidates.
+BASE_INDEX_STEP = 4    # The base image is indexed at every 4th position.
+MAX_CANDIDATES = 8     # Positions kept per key.
+MIN_COPY = 6           # Shorter copies cost about as much as literals.
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def op_header(op, length):
+    if length <= 63:
+        return bytes([(op << 6) | (length - 1)])
+    return bytes([(op << 6) | 63]) + varint(length - 64)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value) << 1) - 1
+
+
+def match_length(a, ai, b, bi, limit):
+    """Number of equal bytes at a[ai:] and b[bi:], at most limit."""
+    n = 0
+    step = 256
+    while n + step <= limit and a[ai + n:ai + n + step] == b[bi + n:bi + n + step]:
+        n += step
+    while n < limit and a[ai + n] == b[bi + n]:
+        n += 1
+    return n
+
+
+def add_candidate(index, key, position):
+    positions = index.get(key)
+    if positions is None:
+        index[key] = [position]
+    else:
+        positions.append(position)
+        if len(positions) > MAX_CANDIDATES:
+            del positions[0]
+
+
+def encode(image, base=None):
+    """Greedy LZ encoding of image, with copies from base if given."""
+    out = bytearray()
+    literal = bytearray()
+    out_index = {}
+    base_index = {}
+    if base is not None:
+        for p in range(0, len(base) - KEY_SIZE + 1, BASE_INDEX_STEP):
+            add_candidate(base_index, base[p:p + KEY_SIZE], p)
+
+    def flush_literal():
+        if literal:
+            out.extend(op_header(OP_LITERAL, len(literal)))
+            out.extend(literal)
+            literal.clear()
+
+    base_end = 0       # Where the last COPY_BASE ended in base.
+    base_shift = 0     # base position minus image position at that point.
+    i = 0
+    size = len(image)
+    while i < size:
+        best_len, best_op, best_from = 0, None, 0
+        limit = size - i
+        if i + KEY_SIZE <= size:
+            key = image[i:i + KEY_SIZE]
+            for p in out_index.get(key, ()):
+                n = match_length(image, i, image, p, min(limit, size))
+                if n > best_len:
+                    best_len, best_op, best_from = n, OP_COPY_OUT, p
+            if base is not None:
+                # Unchanged code usually continues where the last copy left off.
+                expected = i + base_shift
+                if 0 <= expected < len(base):
+                    n = match_length(image, i, base, expected, min(limit, len(base) - expected))
+                    if n > best_len:
+                        best_len, best_op, best_from = n, OP_COPY_BASE, expected
+                for k in range(BASE_INDEX_STEP):
+                    for p in base_index.get(image[i + k:i + k + KEY_SIZE], ()):
+                        start = p - k
+                        if start < 0:
+                            continue
+                        n = match_length(image, i, base, start, min(limit, len(base) - start))
+                        if n > best_len:
+                            best_len, best_op, best_from = n, OP_COPY_BASE, start
+
+        if best_len >= MIN_COPY:
+            flush_literal()
+            out.extend(op_header(best_op, best_len))
+            if best_op == OP_COPY_OUT:
+                out.extend(varint(i - best_from))
+            else:
+                out.extend(varint(zigzag(best_from - base_end)))
+                base_end = best_from + best_len
+                base_shift = best_from - i
+            # Index the copied bytes sparsely; they are mostly found again through the base.
+            for p in range(i, min(i + best_len, size - KEY_SIZE + 1), 16):
+                add_candidate(out_index, image[p:p + KEY_SIZE], p)
+            i += best_len
+        else:
+            if i + KEY_SIZE <= size:
+                add_candidate(out_index, image[i:i + KEY_SIZE], i)
+            literal.append(image[i])
+            i += 1
+    flush_literal()
+    return bytes(out)
+
+
+def read_varint(payload, pos):
+    value, shift = 0, 0
+    while True:
+        if shift > 28:
+            raise ValueError("varint too long")
+        byte = payload[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def apply(method, payload, image_size, base):
+    """Rebuilds the image the way src/ota_patch.cpp does."""
+    if method == METHODS["raw"]:
+        return bytes(payload)
+    out = bytearray()
+    pos, base_end = 0, 0
+    while pos < len(payload):
+        byte = payload[pos]
+        pos += 1
+        op, length = byte >> 6, (byte & 63) + 1
+        if length == 64:
+            extra, pos = read_varint(payload, pos)
+            length = 64 + extra
+        if op > OP_COPY_BASE or (op == OP_COPY_BASE and method != METHODS["delta"]):
+            raise ValueError("invalid operation")
+        if len(out) + length > image_size:
+            raise ValueError("output beyond image size")
+        if op == OP_LITERAL:
+            out.extend(payload[pos:pos + length])
+            pos += length
+        elif op == OP_COPY_OUT:
+            distance, pos = read_varint(payload, pos)
+            if distance == 0 or distance > len(out):
+                raise ValueError("copy before start of output")
+            for _ in range(length):
+                out.append(out[-distance])
+        else:
+            value, pos = read_varint(payload, pos)
+            start = base_end + ((value >> 1) ^ -(value & 1))
+            if start < 0 or start + length > len(base):
+                raise ValueError("copy outside running image")
+            out.extend(base[start:start + length])
+            base_end = start + length
+    return bytes(out)
+
+
+def header(method, image, base, payload_size):
+    fields = struct.pack("<IBBHIIIII", MAGIC, VERSION, method, 0, len(image), zlib.crc32(image),
+                         len(base) if base is not None else 0, zlib.crc32(base) if base is not None else 0,
+                         payload_size)
+    return fields + struct.pack("<I", zlib.crc32(fields))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("image", help="the new application image")
+    parser.add_argument("-o", "--output", required=True, help="the update file to write")
+    parser.add_argument("--base", help="the image the devices run now, for a delta")
+    parser.add_argument("--method", choices=["auto"] + list(METHODS), default="auto")
+    args = parser.parse_args()
+
+    image = open(args.image, "rb").read()
+    base = open(args.base, "rb").read() if args.base else None
+    if not image:
+        sys.exit("%s is empty" % args.image)
+    if args.method == "delta" and base is None:
+        sys.exit("--method delta needs --base")
+
+    payloads = {"raw": image}
+    if args.method in ("auto", "lz"):
+        payloads["lz"] = encode(image)
+    if base is not None and args.method in ("auto", "delta"):
+        payloads["delta"] = encode(image, base)
+    chosen = args.method if args.method != "auto" else min(payloads, key=lambda m: len(payloads[m]))
+
+    method = METHODS[chosen]
+    payload = payloads[chosen]
+    used_base = base if method == METHODS["delta"] else None
+    if apply(method, payload, len(image), used_base) != image:
+        sys.exit("internal error: the %s payload does not rebuild the image" % chosen)
+    data = header(method, image, used_base, len(payload)) + payload
+    with open(args.output, "wb") as out:
+        out.write(data)
+
+    summary = {"method": chosen, "image": len(image), "file": len(data), "file_crc": "%08x" % zlib.crc32(data)}
+    for name in sorted(payloads):
+        summary[name] = HEADER_SIZE + len(payloads[name])
+    summary["saved_pct"] = round(100.0 * (1 - len(data) / float(HEADER_SIZE + len(image))), 1)
+    print(json.dumps(summary))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""Serves a firmware update file to one or more devices through the MQTT broker.
+
+    ota/serve_update.py update.bin --host BROKER [--port 1883] [--user U --password P] [--cafile CA.crt]
+                        hidroponik/greenhouse_a [hidroponik/greenhouse_b ...]
+
+Sends `BEGIN` to every device given by its base topic, then answers each chunk
+request (see src/ota.h) until every device has installed the update or
+failed. Devices request chunks themselves, so a device that drops off the
+network simply continues when it is back; run the server again (same file) to
+resume a device that was offline longer than the server ran.
+
+Needs paho-mqtt (`pip install paho-mqtt`, 1.x or 2.x).
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+import zlib
+
+try:
+    import paho.mqtt.client as mqtt
+except ImportError:
+    sys.exit("serve_update.py needs paho-mqtt: pip install paho-mqtt")
+
+HEADER_SIZE = 32
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("update", help="an update file from make_update.py")
+    parser.add_argument("base_topics", nargs="+", metavar="base_topic", help="e.g. hidroponik/greenhouse_a")
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--cafile", help="connect over TLS, trusting this CA certificate")
+    parser.add_argument("--timeout", type=float, default=3600, help="give up after this many seconds")
+    args = parser.parse_args()
+
+    data = open(args.update, "rb").read()
+    if len(data) <= HEADER_SIZE or struct.unpack_from("<I", data)[0] != 0x41544F48:
+        sys.exit("%s is not an update file" % args.update)
+    crc = "%08x" % zlib.crc32(data)
+    bases = [topic.rstrip("/") for topic in args.base_topics]
+    pending = set(bases)
+    sent = dict((base, 0) for base in bases)
+
+    def on_connect(client, userdata, flags, rc):
+        for base in bases:
+            client.subscribe(base + "/ota/minta")
+            client.subscribe(base + "/ota/status")
+        # Also resumes a transfer after the server reconnects.
+        for base in pending:
+            client.publish(base + "/ota/kontrol", "BEGIN %d %s" % (len(data), crc))
+
+    def on_message(client, userdata, message):
+        base, _, leaf = message.topic.rpartition("/ota/")
+        if base not in sent:
+            return
+        try:
+            payload = json.loads(message.payload.decode())
+        except ValueError:
+            return
+        if leaf == "minta":
+            if payload.get("crc") != crc:
+                return
+            offset, length = int(payload["offset"]), int(payload["length"])
+            chunk = data[offset:offset + length]
+            client.publish(base + "/ota/data", struct.pack("<II", offset, zlib.crc32(chunk)) + chunk)
+            sent[base] += len(chunk)
+            print("%s: %d of %d bytes" % (base, offset + len(chunk), len(data)), end="\r", flush=True)
+        elif leaf == "status" and base in pending and not message.retain:
+            if payload.get("state") == "ready":
+                print("%s: installed, restarts once no pump runs (%d bytes sent)" % (base, sent[base]))
+                pending.discard(base)
+            elif payload.get("error") and payload.get("state") == "idle":
+                print("%s: failed: %s" % (base, payload["error"]))
+                pending.discard(base)
+
+    try:
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION1)
+    except AttributeError:  # paho-mqtt 1.x
+        client = mqtt.Client()
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if args.cafile:
+        client.tls_set(ca_certs=args.cafile)
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.host, args.port)
+    client.loop_start()
+    deadline = time.time() + args.timeout
+    while pending and time.time() < deadline:
+        time.sleep(0.5)
+    client.loop_stop()
+    client.disconnect()
+    if pending:
+        sys.exit("timed out: %s" % ", ".join(sorted(pending)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Fetches the control trace a device recorded to flash, through the MQTT broker.
+
+    replay/fetch_trace.py hidroponik/greenhouse_a --host BROKER [--port 1883] [--user U --password P]
+                          [--cafile CA.crt] -o trace.txt
+
+Sends `DUMP` to the device's `.../jejak/kontrol` topic and saves every `~T`
+line it publishes on `.../jejak/data` until the status reports the dump done
+(see src/trace.h). Replay the file with the replay_native environment (see
+replay/replay_main.cpp). A trace recorded to Serial needs no fetching: the
+saved Serial log is a trace file already.
+
+Needs paho-mqtt (`pip install paho-mqtt`, 1.x or 2.x).
+"""
+
+import argparse
+import json
+import sys
+import time
+
+try:
+    import paho.mqtt.client as mqtt
+except ImportError:
+    sys.exit("fetch_trace.py needs paho-mqtt: pip install paho-mqtt")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("base_topic", help="e.g. hidroponik/greenhouse_a")
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--user")
+    parser.add_argument("--password")
+    parser.add_argument("--cafile", help="connect over TLS, trusting this CA certificate")
+    parser.add_argument("-o", "--output", required=True, help="the trace file to write")
+    parser.add_argument("--timeout", type=float, default=600, help="give up after this many seconds")
+    args = parser.parse_args()
+
+    base = args.base_topic.rstrip("/")
+    output = open(args.output, "w")
+    state = {"started": False, "done": False, "lines": 0}
+
+    def on_connect(client, userdata, flags, rc):
+        client.subscribe(base + "/jejak/data", qos=1)
+        client.subscribe(base + "/jejak/status", qos=1)
+        if not state["started"]:
+            client.publish(base + "/jejak/kontrol", "DUMP", qos=1)
+
+    def on_message(client, userdata, message):
+        if message.topic.endswith("/jejak/data"):
+            output.write(message.payload.decode() + "\n")
+            state["lines"] += 1
+            print("%d lines" % state["lines"], end="\r", flush=True)
+            return
+        if message.retain:
+            return  # The status from before the request.
+        try:
+            dumping = json.loads(message.payload.decode()).get("dump")
+        except ValueError:
+            return
+        if dumping:
+            state["started"] = True
+        else:
+            state["done"] = True
+
+    try:
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION1)
+    except AttributeError:  # paho-mqtt 1.x
+        client = mqtt.Client()
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if args.cafile:
+        client.tls_set(ca_certs=args.cafile)
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.host, args.port)
+    client.loop_start()
+    deadline = time.time() + args.timeout
+    while not state["done"] and time.time() < deadline:
+        time.sleep(0.5)
+    client.loop_stop()
+    client.disconnect()
+    output.close()
+    if not state["done"]:
+        sys.exit("timed out after %d lines" % state["lines"])
+    if state["lines"] == 0:
+        sys.exit("%s has no trace in flash" % base)
+    print("%d lines written to %s" % (state["lines"], args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,537 @@
+/**
+ * @file replay_main.cpp
+ * @brief Replays a recorded control trace (see src/trace.h) through the
+ * firmware's own actuator code on the host, on virtual time.
+ *
+ * Usage: `.pio/build/replay_native/program [options] <trace file>...`
+ *
+ *   --recording <id>    The recording to replay, in hex (default: the longest).
+ *   --tolerance-ms <ms> How far a replayed decision may lie from the recorded
+ *                       one and still match (default 2000).
+ *   --json              Print the summary as one JSON object.
+ *
+ * A trace file is either a saved Serial log or the output of
+ * replay/fetch_trace.py, i.e. any text holding `~T` lines, or a raw read of
+ * the flash (e.g. `esptool.py read_flash`), in which every sector starting
+ * with a segment header is taken. Several files are merged, so the log of a
+ * long run may be split.
+ *
+ * The replay starts at the recording's first checkpoint: the instance ID and
+ * settings are provisioned and the persisted records restored, as if the board
+ * had booted with them. Sensor readings, power meter readings and commands are
+ * then fed to the actuator module at their recorded times, and `actuators_loop()`
+ * runs in between (every millisecond while a pump runs or a job waits).
+ * Commands to the log, history, OTA, trace and probe calibration topics are
+ * skipped; the recorded readings already show a probe under calibration. The
+ * replay ends at the end of the recording or at the first missing or damaged
+ * segment.
+ *
+ * Every change of the actuator state the replay produces is printed to stdout,
+ * one line each, e.g. `3600012 pump nutrisi_a ON`: run the same trace through
+ * two firmware builds and diff the outputs to see what a change would have
+ * decided differently. Each change is also compared, in order, with the
+ * recorded one; a change of another state, or one further apart in time than
+ * the tolerance, is a mismatch. The summary goes to stderr.
+ *
+ * Exit status: 0 if the replay matched the recording, 1 on bad usage or
+ * unreadable input, 2 on any mismatch.
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+#include "sensors.h"
+#include "actuators.h"
+#include "mqtt_handler.h"
+#include "storage.h"
+#include "identity.h"
+#include "logger.h"
+#include "trace.h"
+#include "trace_codec.h"
+#include "sim_board.h"
+#include "sim_time.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct Segment
+ * @brief One segment as read from the input files.
+ */
+struct Segment {
+  std::vector<uint8_t> bytes;
+  bool truncated; ///< A line of it is missing; only the bytes before the gap are kept.
+};
+
+/**
+ * @struct Change
+ * @brief One change of the actuator state.
+ */
+struct Change {
+  uint64_t timeMs;
+  uint32_t state;
+};
+
+/// @brief `actuators_loop()` interval while no pump runs and no job waits.
+static const uint64_t QUIET_STEP_MS = 100;
+static const uint32_t PUMP_MASK = 0xFF;
+static const uint32_t QUEUE_MASK = 0xFFFF0000;
+static const char* const FLAG_NAMES[] = {"buzzer", nullptr, "auto_dosing", "auto_refill", "auto_irrigation"};
+
+/// @brief Every segment read, keyed by recording ID (high word) and sequence number.
+static std::map<uint64_t, Segment> segments;
+static SensorValues values;
+static uint64_t startMs = 0;
+static uint32_t lastState = 0;
+/// @brief Changes not paired with their counterpart yet.
+static std::vector<Change> recordedChanges;
+static std::vector<Change> replayedChanges;
+static uint32_t lastRecordedState = 0;
+static uint64_t toleranceMs = 2000;
+static uint32_t matched = 0;
+static uint32_t mismatches = 0;
+static uint64_t firstMismatchMs = 0;
+static uint32_t replayedTotal = 0;
+static uint32_t recordedTotal = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool load_file(const char* path);
+static void load_text(const std::string& text);
+static void load_binary(const std::string& data);
+static void add_bytes(uint32_t recording, uint32_t sequence, size_t offset, const uint8_t* data, size_t length);
+static size_t decode_base64(const char* text, uint8_t* out, size_t size);
+static uint32_t choose_recording(const char* requested);
+static void restore_checkpoint(const TraceRecord& record);
+static void advance_to(uint64_t timeMs);
+static void apply_record(const TraceRecord& record, uint64_t timeMs);
+static bool skipped_topic(const char* topic);
+static void observe();
+static void record_expected(uint64_t timeMs, uint32_t state);
+static void pair_changes();
+static void report_mismatch(const char* what, const Change& expected, const Change& actual);
+
+int main(int argc, char** argv) {
+  const char* requested = nullptr;
+  bool json = false;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--json") json = true;
+    else if (arg.compare(0, 2, "--") != 0) paths.push_back(argv[i]);
+    else if (value == nullptr) { fprintf(stderr, "Missing value for %s\n", arg.c_str()); return 1; }
+    else if (arg == "--recording") { requested = value; i++; }
+    else if (arg == "--tolerance-ms") { toleranceMs = strtoull(value, nullptr, 10); i++; }
+    else { fprintf(stderr, "Unknown option %s\n", arg.c_str()); return 1; }
+  }
+  if (paths.empty()) {
+    fprintf(stderr, "Usage: %s [--recording <id>] [--tolerance-ms <ms>] [--json] <trace file>...\n", argv[0]);
+    return 1;
+  }
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (!load_file(paths[i])) return 1;
+  }
+  uint32_t recording = choose_recording(requested);
+  if (recording == 0) return 1;
+
+  // The first checkpoint of the recording; segments before it cannot be replayed.
+  std::map<uint64_t, Segment>::iterator it = segments.lower_bound((uint64_t)recording << 32);
+  std::map<uint64_t, Segment>::iterator end = segments.upper_bound(((uint64_t)recording << 32) | 0xFFFFFFFF);
+  TraceDecoder decoder;
+  for (; it != end; ++it) {
+    if (trace_codec_decoder_init(decoder, it->second.bytes.data(), it->second.bytes.size()) &&
+        (decoder.header.flags & TRACE_SEGMENT_CHECKPOINT)) {
+      break;
+    }
+  }
+  if (it == end) {
+    fprintf(stderr, "Recording %08x has no checkpoint to start from\n", (unsigned)recording);
+    return 1;
+  }
+
+  // Nothing drains the log buffer here; the firmware's log stays off.
+  logger_handle_command("NONE");
+  static TraceRecord record; // Large; kept off the stack.
+  if (!trace_codec_decode(decoder, record) || record.type != TRACE_RECORD_START) {
+    fprintf(stderr, "Segment %x does not start with a checkpoint\n", (unsigned)(it->first & 0xFFFFFFFF));
+    return 1;
+  }
+  uint32_t firstSequence = (uint32_t)it->first;
+  startMs = record.time;
+  sim_advance_us(startMs * 1000 - sim_now_us());
+  // The checkpoint's records come first: provision and restore them, then boot the modules.
+  bool pending = true; // Whether `record` holds a record not handled yet.
+  while (pending && (record.type == TRACE_RECORD_START || record.type == TRACE_RECORD_SETTING ||
+                     record.type == TRACE_RECORD_STATE)) {
+    restore_checkpoint(record);
+    pending = trace_codec_decode(decoder, record);
+  }
+  identity_init();
+  storage_init();
+  actuators_init();
+  for (int f = 0; f < SENSOR_NUM_FIELDS; f++) values.*SENSOR_FIELDS[f].value = NAN;
+  lastState = trace_output_state();
+  lastRecordedState = lastState;
+  if (pending && record.type == TRACE_RECORD_OUTPUTS) {
+    // The state the checkpoint was taken in.
+    lastRecordedState = (uint32_t)record.number;
+    Change expected = {startMs, lastRecordedState};
+    Change actual = {startMs, lastState};
+    if (expected.state != actual.state) report_mismatch("start", expected, actual);
+    pending = false;
+  }
+
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+  const char* stop = "end";
+  uint32_t sequence = firstSequence;
+  uint32_t lastTime = (uint32_t)startMs;
+  uint64_t timeMs = startMs;
+  uint32_t records = 0;
+  while (true) {
+    while (pending || trace_codec_decode(decoder, record)) {
+      pending = false;
+      timeMs += (uint32_t)(record.time - lastTime); // Survives millis() wrapping.
+      lastTime = record.time;
+      if (record.type == TRACE_RECORD_BUSY) {
+        // The loop was held up, e.g. by a sensor read: the actuator loop did not run meanwhile.
+        advance_to(timeMs - (record.number < timeMs - startMs ? record.number : timeMs - startMs));
+      } else {
+        // A command arrives early in its pass of the main loop, before the actuator loop runs.
+        advance_to(record.type == TRACE_RECORD_COMMAND ? timeMs - 1 : timeMs);
+      }
+      if (sim_now_us() < timeMs * 1000) sim_advance_us(timeMs * 1000 - sim_now_us());
+      apply_record(record, timeMs);
+      records++;
+    }
+    if (decoder.damaged) {
+      stop = "damaged segment";
+      break;
+    }
+    if (it->second.truncated) {
+      stop = "missing line";
+      break;
+    }
+    ++it;
+    if (it == end) break;
+    if ((uint32_t)it->first != sequence + 1) {
+      stop = "missing segment";
+      break;
+    }
+    sequence++;
+    if (!trace_codec_decoder_init(decoder, it->second.bytes.data(), it->second.bytes.size())) {
+      stop = "damaged segment";
+      break;
+    }
+  }
+  double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  // Whatever is left unpaired has no counterpart.
+  Change none = {timeMs, 0};
+  for (size_t i = 0; i < recordedChanges.size(); i++) report_mismatch("not replayed", recordedChanges[i], none);
+  for (size_t i = 0; i < replayedChanges.size(); i++) report_mismatch("not recorded", none, replayedChanges[i]);
+
+  double spanS = (timeMs - startMs) / 1000.0;
+  if (json) {
+    fprintf(stderr,
+            "{\"recording\":\"%08x\",\"segments\":[%u,%u],\"stop\":\"%s\",\"records\":%u,\"span_s\":%.1f,"
+            "\"wall_s\":%.3f,\"speedup\":%.0f,\"recorded_changes\":%u,\"replayed_changes\":%u,\"matched\":%u,"
+            "\"mismatches\":%u,\"first_mismatch_ms\":%llu}\n",
+            (unsigned)recording, firstSequence, sequence, stop, records, spanS, wallS,
+            wallS > 0 ? spanS / wallS : 0, recordedTotal, replayedTotal, matched, mismatches,
+            (unsigned long long)(mismatches ? firstMismatchMs - startMs : 0));
+  } else {
+    fprintf(stderr, "Recording %08x, segments %x-%x (%s): %u records over %.1f h in %.2f s\n",
+            (unsigned)recording, firstSequence, sequence, stop, records, spanS / 3600, wallS);
+    fprintf(stderr, "%u recorded and %u replayed changes, %u matched, %u mismatches\n", recordedTotal,
+            replayedTotal, matched, mismatches);
+  }
+  return mismatches > 0 ? 2 : 0;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Reads the segments of one input file into `segments`.
+ */
+static bool load_file(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  std::string data;
+  char buffer[65536];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) data.append(buffer, read);
+  fclose(file);
+  size_t before = segments.size();
+  if (data.find("~T ") != std::string::npos) {
+    load_text(data);
+  } else {
+    load_binary(data);
+  }
+  if (segments.size() == before) {
+    fprintf(stderr, "%s holds no trace\n", path);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Takes every `~T` line of a text, wherever it starts in the line.
+ */
+static void load_text(const std::string& text) {
+  static uint8_t bytes[TRACE_SEGMENT_SIZE];
+  size_t pos = 0;
+  while ((pos = text.find("~T ", pos)) != std::string::npos) {
+    size_t lineEnd = text.find('\n', pos);
+    std::string line = text.substr(pos, lineEnd == std::string::npos ? std::string::npos : lineEnd - pos);
+    pos = lineEnd == std::string::npos ? text.size() : lineEnd;
+    unsigned recording, sequence, offset;
+    int consumed = 0;
+    if (sscanf(line.c_str(), "~T %x %x %x %n", &recording, &sequence, &offset, &consumed) < 3 || consumed == 0 ||
+        offset >= TRACE_SEGMENT_SIZE) {
+      continue;
+    }
+    size_t length = decode_base64(line.c_str() + consumed, bytes, TRACE_SEGMENT_SIZE - offset);
+    if (length > 0) add_bytes(recording, sequence, offset, bytes, length);
+  }
+}
+
+/**
+ * @brief Takes every sector of a raw flash read that starts with a segment header.
+ */
+static void load_binary(const std::string& data) {
+  for (size_t pos = 0; pos + TRACE_SEGMENT_HEADER_SIZE <= data.size(); pos += TRACE_SEGMENT_SIZE) {
+    size_t length = data.size() - pos < TRACE_SEGMENT_SIZE ? data.size() - pos : TRACE_SEGMENT_SIZE;
+    const uint8_t* sector = (const uint8_t*)data.data() + pos;
+    TraceDecoder decoder;
+    if (!trace_codec_decoder_init(decoder, sector, length)) continue;
+    add_bytes(decoder.header.recording, decoder.header.sequence, 0, sector, length);
+  }
+}
+
+/**
+ * @brief Adds bytes at an offset of a segment. Bytes already there are ignored,
+ * e.g. from a log and a dump of the same segment; bytes past a gap are dropped.
+ */
+static void add_bytes(uint32_t recording, uint32_t sequence, size_t offset, const uint8_t* data, size_t length) {
+  Segment& segment = segments[((uint64_t)recording << 32) | sequence];
+  size_t size = segment.bytes.size();
+  if (offset > size) {
+    segment.truncated = true;
+  } else if (offset + length > size && !segment.truncated) {
+    segment.bytes.insert(segment.bytes.end(), data + (size - offset), data + length);
+  }
+}
+
+/**
+ * @brief Decodes base64 up to the first character outside the alphabet.
+ * @return The number of bytes written to `out`.
+ */
+static size_t decode_base64(const char* text, uint8_t* out, size_t size) {
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t length = 0;
+  uint32_t group = 0;
+  int bits = 0;
+  for (; *text != '\0' && *text != '='; text++) {
+    const char* digit = strchr(digits, *text);
+    if (digit == nullptr) break;
+    group = (group << 6) | (uint32_t)(digit - digits);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      if (length < size) out[length++] = (uint8_t)(group >> bits);
+    }
+  }
+  return length;
+}
+
+/**
+ * @brief Lists the recordings found on stderr and picks one.
+ * @param requested The recording ID in hex, or nullptr for the one with the most segments.
+ * @return The recording ID, or 0 if there is no such recording.
+ */
+static uint32_t choose_recording(const char* requested) {
+  uint32_t chosen = 0;
+  size_t mostSegments = 0;
+  std::map<uint64_t, Segment>::iterator it = segments.begin();
+  while (it != segments.end()) {
+    uint32_t recording = (uint32_t)(it->first >> 32);
+    uint32_t firstSequence = (uint32_t)it->first;
+    size_t count = 0;
+    size_t checkpoints = 0;
+    for (; it != segments.end() && (uint32_t)(it->first >> 32) == recording; ++it) {
+      TraceDecoder decoder;
+      count++;
+      if (trace_codec_decoder_init(decoder, it->second.bytes.data(), it->second.bytes.size()) &&
+          (decoder.header.flags & TRACE_SEGMENT_CHECKPOINT)) {
+        checkpoints++;
+      }
+    }
+    fprintf(stderr, "Recording %08x: %u segments from %x, %u with a checkpoint\n", (unsigned)recording,
+            (unsigned)count, firstSequence, (unsigned)checkpoints);
+    if (requested != nullptr ? recording == strtoul(requested, nullptr, 16) : count > mostSegments) {
+      chosen = recording;
+      mostSegments = count;
+    }
+  }
+  if (chosen == 0) fprintf(stderr, "No recording %s\n", requested);
+  return chosen;
+}
+
+/**
+ * @brief Provisions a setting or restores a persisted record of the checkpoint.
+ */
+static void restore_checkpoint(const TraceRecord& record) {
+  if (record.type == TRACE_RECORD_START) {
+    sim_board_provision(IDENTITY_NAMESPACE, "instance", record.name);
+  } else if (record.type == TRACE_RECORD_SETTING) {
+    sim_board_provision(IDENTITY_NAMESPACE, record.name, (const char*)record.data);
+  } else {
+    Preferences prefs;
+    prefs.begin(STORAGE_NAMESPACE, false);
+    prefs.putBytes(record.name, record.data, record.dataSize);
+    prefs.end();
+  }
+}
+
+/**
+ * @brief Runs the actuator loop up to a point in time, the way the main loop would.
+ */
+static void advance_to(uint64_t timeMs) {
+  uint64_t nowMs = sim_now_us() / 1000;
+  while (nowMs < timeMs) {
+    // Pumps stop on the millisecond; nothing else needs the resolution.
+    uint64_t step = (lastState & (PUMP_MASK | QUEUE_MASK)) ? 1 : QUIET_STEP_MS;
+    if (step > timeMs - nowMs) step = timeMs - nowMs;
+    sim_advance_us(step * 1000);
+    nowMs += step;
+    actuators_loop(values);
+    observe();
+  }
+}
+
+/**
+ * @brief Feeds one record to the firmware, or collects it for the comparison.
+ */
+static void apply_record(const TraceRecord& record, uint64_t timeMs) {
+  switch (record.type) {
+    case TRACE_RECORD_SENSORS:
+      for (int f = 0; f < SENSOR_NUM_FIELDS; f++) values.*SENSOR_FIELDS[f].value = record.values[f];
+      actuators_handle_power_sample(values);
+      actuators_update_alert_status(values);
+      observe();
+      break;
+    case TRACE_RECORD_POWER:
+      for (int f = 0; f < SENSOR_NUM_FIELDS; f++) values.*SENSOR_FIELDS[f].value = record.values[f];
+      actuators_handle_power_sample(values);
+      observe();
+      break;
+    case TRACE_RECORD_COMMAND: {
+      std::string topic = record.name;
+      if (topic[0] == '~') topic = BASE_TOPIC + topic.substr(1);
+      if (skipped_topic(topic.c_str())) break;
+      mqtt_route_command(topic.c_str(), (const char*)record.data);
+      observe();
+      // Commands arrive early in the main loop; the actuator loop follows in the same pass.
+      actuators_loop(values);
+      observe();
+      break;
+    }
+    case TRACE_RECORD_OUTPUTS:
+      // A later checkpoint repeats the state; only changes count.
+      if ((uint32_t)record.number != lastRecordedState) record_expected(timeMs, (uint32_t)record.number);
+      break;
+    default:
+      break; // Busy time is handled by the caller; later checkpoints and the wall clock change nothing.
+  }
+}
+
+/**
+ * @brief Whether a command goes to a module the replay does not run.
+ */
+static bool skipped_topic(const char* topic) {
+  return COMMAND_TOPIC_LOG == topic || COMMAND_TOPIC_HISTORY == topic || COMMAND_TOPIC_OTA == topic ||
+         COMMAND_TOPIC_TRACE == topic || COMMAND_TOPIC_PROBE_CALIBRATION == topic;
+}
+
+/**
+ * @brief Prints and collects a change of the actuator state, if there is one.
+ */
+static void observe() {
+  uint32_t state = trace_output_state();
+  if (state == lastState) return;
+  uint64_t timeMs = sim_now_us() / 1000;
+  PumpStatus status;
+  for (int i = 0; i < 8 && actuators_get_pump_status(i, status); i++) {
+    if ((state ^ lastState) & (1UL << i)) {
+      printf("%llu pump %s %s\n", (unsigned long long)(timeMs - startMs), status.key, status.isOn ? "ON" : "OFF");
+    }
+  }
+  for (int bit = 0; bit < 5; bit++) {
+    uint32_t mask = 1UL << (8 + bit);
+    if (!((state ^ lastState) & mask)) continue;
+    if (FLAG_NAMES[bit] == nullptr) {
+      printf("%llu mode %s\n", (unsigned long long)(timeMs - startMs), actuators_mode_name());
+    } else {
+      printf("%llu %s %s\n", (unsigned long long)(timeMs - startMs), FLAG_NAMES[bit], (state & mask) ? "ON" : "OFF");
+    }
+  }
+  if ((state ^ lastState) & QUEUE_MASK) {
+    printf("%llu queue %u\n", (unsigned long long)(timeMs - startMs), (unsigned)(state >> 16));
+  }
+  lastState = state;
+  replayedTotal++;
+  Change change = {timeMs, state};
+  replayedChanges.push_back(change);
+  pair_changes();
+}
+
+/**
+ * @brief Collects a recorded change of the actuator state.
+ */
+static void record_expected(uint64_t timeMs, uint32_t state) {
+  lastRecordedState = state;
+  recordedTotal++;
+  Change change = {timeMs, state};
+  recordedChanges.push_back(change);
+  pair_changes();
+}
+
+/**
+ * @brief Compares recorded and replayed changes in order, as far as both are known.
+ */
+static void pair_changes() {
+  size_t count = recordedChanges.size() < replayedChanges.size() ? recordedChanges.size() : replayedChanges.size();
+  for (size_t i = 0; i < count; i++) {
+    const Change& expected = recordedChanges[i];
+    const Change& actual = replayedChanges[i];
+    uint64_t apart = expected.timeMs > actual.timeMs ? expected.timeMs - actual.timeMs : actual.timeMs - expected.timeMs;
+    if (expected.state != actual.state) {
+      report_mismatch("other state", expected, actual);
+    } else if (apart > toleranceMs) {
+      report_mismatch("other time", expected, actual);
+    } else {
+      matched++;
+    }
+  }
+  recordedChanges.erase(recordedChanges.begin(), recordedChanges.begin() + count);
+  replayedChanges.erase(replayedChanges.begin(), replayedChanges.begin() + count);
+}
+
+/**
+ * @brief Counts a mismatch; the first few are printed to stderr.
+ */
+static void report_mismatch(const char* what, const Change& expected, const Change& actual) {
+  if (mismatches == 0) firstMismatchMs = expected.timeMs < actual.timeMs ? expected.timeMs : actual.timeMs;
+  if (mismatches < 10) {
+    fprintf(stderr, "Mismatch (%s): recorded %08x at %llu ms, replayed %08x at %llu ms\n", what,
+            (unsigned)expected.state, (unsigned long long)(expected.timeMs - startMs), (unsigned)actual.state,
+            (unsigned long long)(actual.timeMs - startMs));
+  }
+  mismatches++;
+}
@@ -10,9 +10,14 @@
 #include "actuators.h"
 #include "config.h"
 #include "mqtt_handler.h" // For publishing alerts and state
+#include "pump_monitor.h" // For dry-run, blockage and relay fault detection
+#include "pump_flow.h"    // For per-pump volumetric flow models
+#include "storage.h"      // For persisting flow models, dispensed volumes and learned draws
+#include "number_format.h" // For printf-free float formatting in payloads
+#include "command_ack.h"  // For correlation IDs and command acknowledgements
 #include <stdlib.h>       // For atof()
 #include <strings.h>      // For strcasecmp()
-#include <cstring>        // For strcmp()
+#include <cstring>        // For strcmp(), memset()
 
 // --- Module-Private (Static) Constants & Variables ---
 
@@ -21,6 +26,12 @@ static const char* PAYLOAD_ON = "ON";
 /// @brief MQTT payload for the "OFF" state.
 static const char* PAYLOAD_OFF = "OFF";
 
+/// @brief Exclusion groups. A pump may not start while a running pump belongs to
+/// a group in its `excludes` mask, or while it belongs to a group the running pump excludes.
+static const uint8_t GROUP_DOSING = 1 << 0;     ///< Nutrient A/B and pH dosing pumps.
+static const uint8_t GROUP_IRRIGATION = 1 << 1; ///< The watering pump.
+static const uint8_t GROUP_REFILL = 1 << 2;     ///< The reservoir refill valve/pump.
+
 /**
  * @struct Pump
  * @brief Holds all state and configuration for a single pump.
@@ -28,23 +39,162 @@ static const char* PAYLOAD_OFF = "OFF";
 struct Pump {
   const int pin;              ///< The GPIO pin connected to the pump's relay.
   const char* name;           ///< A human-readable name for logging.
-  const std::string commandTopic; ///< The MQTT topic to receive commands on.
-  const std::string stateTopic;   ///< The MQTT topic to publish state to.
+  const char* key;            ///< The short identifier used in topics and job sequences (e.g. "nutrisi_a").
+  const uint8_t group;        ///< The exclusion group this pump belongs to.
+  const uint8_t excludes;     ///< Groups that may not run at the same time as this pump.
+  const MqttTopic& commandTopic; ///< The MQTT topic to receive commands on. Refers to the global in config.cpp.
+  const MqttTopic& stateTopic;   ///< The MQTT topic to publish state to. Refers to the global in config.cpp.
+  const float ratedW;         ///< Rated power draw (AC side, as the PZEM sees it); learned draws must stay near it.
+  const float ratedA;         ///< Rated current draw, the same way as `ratedW`.
   bool isOn;                  ///< The current state of the pump (true if running).
   unsigned long stopTime;     ///< The time (from millis()) when a timed run should stop. 0 if not in a timed run.
+  float drawW;                ///< Power drawn while running, learned from PZEM deltas against the reading before switch-on.
+  float drawA;                ///< Current drawn while running, learned the same way as `drawW`.
+  bool drawLearned;           ///< true once `drawW`/`drawA` come from a measured run rather than the initial estimate.
+  unsigned long onSince;      ///< millis() when the pump was last switched on.
 };
 
 /// @brief A unified array of all pumps for easy, scalable management.
+/// The draw values start at the rated draw (AC side, measured by the PZEM) until learned;
+/// they size the power budget but are not used to judge dry runs or blockages.
+/// The refill is a 12 V solenoid valve, whose coil draws far less than a pump.
+/// Nutrient A and B are never dosed together so the concentrates cannot precipitate,
+/// and dosing is kept apart from refilling so each dose lands in a known volume.
 static Pump pumps[] = {
-    {PUMP_NUTRISI_A_PIN, "Nutrisi A", COMMAND_TOPIC_PUMP_A, STATE_TOPIC_PUMP_A, false, 0},
-    {PUMP_NUTRISI_B_PIN, "Nutrisi B", COMMAND_TOPIC_PUMP_B, STATE_TOPIC_PUMP_B, false, 0},
-    {PUMP_PH_PIN, "pH", COMMAND_TOPIC_PUMP_PH, STATE_TOPIC_PUMP_PH, false, 0},
-    {PUMP_SIRAM_PIN, "Penyiraman", COMMAND_TOPIC_PUMP_SIRAM, STATE_TOPIC_PUMP_SIRAM, false, 0},
-    {PUMP_TANDON_PIN, "Pengisian Tandon", COMMAND_TOPIC_PUMP_TANDON, STATE_TOPIC_PUMP_TANDON, false, 0}};
+    {PUMP_NUTRISI_A_PIN, "Nutrisi A", "nutrisi_a", GROUP_DOSING, GROUP_DOSING | GROUP_REFILL, COMMAND_TOPIC_PUMP_A, STATE_TOPIC_PUMP_A, 6.0f, 0.05f, false, 0, 6.0f, 0.05f, false, 0},
+    {PUMP_NUTRISI_B_PIN, "Nutrisi B", "nutrisi_b", GROUP_DOSING, GROUP_DOSING | GROUP_REFILL, COMMAND_TOPIC_PUMP_B, STATE_TOPIC_PUMP_B, 6.0f, 0.05f, false, 0, 6.0f, 0.05f, false, 0},
+    {PUMP_PH_PIN, "pH", "ph", GROUP_DOSING, GROUP_DOSING | GROUP_REFILL, COMMAND_TOPIC_PUMP_PH, STATE_TOPIC_PUMP_PH, 6.0f, 0.05f, false, 0, 6.0f, 0.05f, false, 0},
+    {PUMP_SIRAM_PIN, "Penyiraman", "penyiraman", GROUP_IRRIGATION, GROUP_IRRIGATION, COMMAND_TOPIC_PUMP_SIRAM, STATE_TOPIC_PUMP_SIRAM, 25.0f, 0.2f, false, 0, 25.0f, 0.2f, false, 0},
+    {PUMP_TANDON_PIN, "Pengisian Tandon", "tandon", GROUP_REFILL, GROUP_DOSING, COMMAND_TOPIC_PUMP_TANDON, STATE_TOPIC_PUMP_TANDON, 10.0f, 0.08f, false, 0, 10.0f, 0.08f, false, 0}};
 
 /// @brief The total number of pumps, calculated automatically from the array size.
 static const int NUM_PUMPS = sizeof(pumps) / sizeof(pumps[0]);
 
+/**
+ * @struct PumpJob
+ * @brief A single timed pump run waiting in (or taken from) the pump job queue.
+ */
+struct PumpJob {
+  uint32_t id;                ///< Unique, increasing job identifier. 0 marks an empty slot.
+  int pumpIndex;              ///< Index of the pump in `pumps[]`.
+  unsigned long durationMs;   ///< How long the pump should run.
+  unsigned long settleMs;     ///< How long to wait after this job before the next job may start.
+  uint8_t priority;           ///< Higher values run first; equal priorities keep arrival order.
+  unsigned long enqueuedAt;   ///< millis() when the job entered the queue.
+  unsigned long startedAt;    ///< millis() when the pump was switched on for this job.
+  CommandRef command;         ///< The command that created the job; no ID for sequence and calibration steps.
+};
+
+/// @brief Pending jobs, kept sorted by priority (highest first) and arrival order.
+static PumpJob jobQueue[PUMP_JOB_QUEUE_CAPACITY];
+/// @brief The number of jobs currently waiting in `jobQueue`.
+static int jobQueueLength = 0;
+/// @brief The job currently running on each pump, indexed like `pumps[]`. `id == 0` means none.
+static PumpJob activeJobs[NUM_PUMPS];
+/// @brief The command that switched a pump on directly (the Tandon's "ON"), for the ack when it stops.
+static CommandRef directCommands[NUM_PUMPS];
+/// @brief The identifier handed to the next enqueued job.
+static uint32_t nextJobId = 1;
+/// @brief When the settle barrier began, used together with `queueSettleMs` to delay the next start.
+static unsigned long queueSettleStart = 0;
+/// @brief The settle barrier: the latest end of any finished job's settle delay, measured from `queueSettleStart`.
+static unsigned long queueSettleMs = 0;
+/// @brief Lifetime counters for the queue status topic.
+static uint32_t jobsCompleted = 0;
+static uint32_t jobsCancelled = 0;
+static uint32_t jobsRejected = 0;
+/// @brief Number of times the queue head could not start because of the budget or an exclusion group.
+static uint32_t startsRefused = 0;
+/// @brief The job whose refusal was last counted, so a waiting head is only counted once.
+static uint32_t lastRefusedJobId = 0;
+
+// --- Power Budget Scheduling ---
+/// @brief Sum of all pump run times, for throughput reporting.
+static unsigned long totalPumpRunMs = 0;
+/// @brief Total time with at least one pump running; `totalPumpRunMs / busyMs` is the concurrency gain.
+static unsigned long busyMs = 0;
+/// @brief When the pumps last went from all idle to at least one running.
+static unsigned long busySince = 0;
+/// @brief The highest number of pumps that ran at the same time.
+static int peakConcurrentPumps = 0;
+/// @brief The highest PZEM power reading taken while any pump was running.
+static float peakPowerW = 0;
+/// @brief Pump switches since the last power sample; idle power is only learned across quiet intervals.
+static int switchesSinceSample = 0;
+/// @brief The PZEM readings and time of the previous power sample.
+static float lastSamplePowerW = NAN;
+static float lastSampleCurrentA = NAN;
+static unsigned long lastSampleTime = 0;
+/// @brief Smoothed power/current with all pumps off (controller, PSU losses, sensors).
+static float idlePowerW = NAN;
+static float idleCurrentA = NAN;
+
+// --- Pump Run Monitoring ---
+/// @brief The current-signature monitor of each pump's latest run, indexed like `pumps[]`.
+static PumpRunMonitor runMonitors[NUM_PUMPS];
+
+/**
+ * @struct LearnedDraw
+ * @brief A pump's learned draw as persisted in NVS; 0 W means not learned yet.
+ */
+struct LearnedDraw {
+  float w;
+  float a;
+};
+/// @brief The learned draw of each pump, indexed like `pumps[]`, kept across reboots so the
+/// first run after a boot is judged like any other instead of becoming the new baseline.
+static LearnedDraw learnedDraws[NUM_PUMPS];
+static int learnedDrawsHandle = -1;
+/// @brief After the last pump stops, samples are still taken briefly to catch a relay stuck ON.
+static bool releaseCheckActive = false;
+static unsigned long releaseCheckStart = 0;
+/// @brief The learned draw of the pump released last, i.e. what a stuck relay would add.
+static float releaseExpectedW = 0;
+static uint8_t releaseHighCount = 0;
+
+// --- Volumetric Dosing ---
+/// @brief The flow model of each pump, indexed like `pumps[]`; only dosing pumps use theirs.
+static PumpFlowModel flowModels[NUM_PUMPS];
+/// @brief Cumulative volume delivered by each pump, kept across reboots.
+static float dispensedMl[NUM_PUMPS];
+/// @brief Storage handles for the flow models and the dispensed volumes.
+static int flowModelsHandle = -1;
+static int dispensedHandle = -1;
+/// @brief The pump with an outstanding calibration run (-1 if none) and how long it actually ran.
+static int calibrationPumpIndex = -1;
+static unsigned long calibrationRunMs = 0;
+/// @brief The latest TDS and water level seen by `actuators_loop()`, for the TDS response check.
+static float lastKnownTdsPpm = NAN;
+static float lastKnownLevelCm = NAN;
+
+/**
+ * @struct TdsResponseCheck
+ * @brief A single nutrient dose whose TDS rise is compared with the expected rise.
+ */
+struct TdsResponseCheck {
+  bool armed;           ///< A dose started with a valid TDS reading and nothing else running.
+  bool waiting;         ///< The dose finished cleanly; waiting for the solution to mix.
+  int pumpIndex;        ///< The dosing pump.
+  float tdsBefore;      ///< TDS reading when the dose started.
+  float levelCm;        ///< Water level when the dose started.
+  unsigned long runMs;  ///< How long the pump ran.
+  float ml;             ///< The volume the model says was delivered.
+  unsigned long doneAt; ///< millis() when the dose finished.
+};
+/// @brief The pending TDS response check; any other pump run cancels it.
+static TdsResponseCheck tdsCheck = {false, false, -1, NAN, NAN, 0, 0, 0};
+
+// --- Change-Driven State Publishing ---
+/// @brief State topics waiting to be published: bit i for `pumps[i]`, then the flags below.
+/// States are only published when they change, on connect, and in the periodic snapshot.
+static uint16_t dirtyStates = 0;
+static const uint16_t DIRTY_MODE = 1 << NUM_PUMPS;
+static const uint16_t DIRTY_AUTO_DOSING = DIRTY_MODE << 1;
+static const uint16_t DIRTY_AUTO_REFILL = DIRTY_MODE << 2;
+static const uint16_t DIRTY_AUTO_IRRIGATION = DIRTY_MODE << 3;
+static const uint16_t DIRTY_PUMPS = DIRTY_MODE - 1;
+static const uint16_t DIRTY_AUTOMATION = DIRTY_AUTO_DOSING | DIRTY_AUTO_REFILL | DIRTY_AUTO_IRRIGATION;
+
 /// @brief Tracks if the water level alert is currently active to prevent spamming alerts.
 static bool isWaterLevelAlertActive = false;
 
@@ -53,11 +203,15 @@ enum SystemMode {
     NUTRITION, ///< Normal mode, all functions enabled.
     CLEANER    ///< Maintenance mode, potentially disabling auto-dosing (future feature).
 };
-/// @brief The current operational mode of the system.
+/// @brief The current operational mode of the system. Kept across reboots.
 static SystemMode currentSystemMode = NUTRITION;
+/// @brief Storage handles for the system mode and the automation switches.
+static int systemModeHandle = -1;
+static int automationHandle = -1;
 
 // --- Global Automation State ---
-/// @brief Global instance of automation state, initialized to default values
+/// @brief Global instance of automation state, initialized to default values and
+/// restored from NVS in `actuators_init()`.
 AutomationState automation_state = {
     .auto_dosing_enabled = false,
     .auto_refill_enabled = false,  
@@ -65,55 +219,138 @@ AutomationState automation_state = {
 };
 
 // --- Forward Declarations for Static (Private) Functions ---
-static void control_pump_by_volume(Pump& pump, float volume_ml);
+static unsigned long pump_amount_to_duration_ms(const Pump& pump, float amount);
 static void control_pump_by_duration(Pump& pump, unsigned long duration_ms);
-static bool are_any_pumps_running();
+static void set_pump_output(Pump& pump, bool on);
+static void end_pump_run(int pumpIndex);
+static void abort_pump_run(int pumpIndex, PumpFault fault, float shareW);
+static void report_pump_fault(int pumpIndex, PumpFault fault, float shareW);
+static bool draw_is_plausible(const Pump& pump, float watts);
+static PumpMonitorConfig pump_monitor_config();
+static void check_tds_response();
+static uint8_t running_pump_mask();
+static bool can_start_pump(int pumpIndex, const char** reason);
+static uint32_t enqueue_pump_job(int pumpIndex, unsigned long duration_ms, unsigned long settle_ms, uint8_t priority,
+                                 const CommandRef* command);
+static void dispatch_pump_jobs();
+static void finish_pump_job(int pumpIndex, const char* outcome);
+static void cancel_queued_jobs(int pumpIndex, uint32_t jobId);
+static void publish_job_record(const PumpJob& job, unsigned long runMs, const char* outcome);
 static void check_tandon_safety(const SensorValues& currentValues);
+static void publish_dirty_states();
 
 // --- Public Function Implementations ---
 
 void actuators_init() {
-  LOG_PRINTLN("[Actuators] Initializing...");
+  LOG_INFO("[Actuators] Initializing...\n");
   for (int i = 0; i < NUM_PUMPS; i++) {
     pinMode(pumps[i].pin, OUTPUT);
     digitalWrite(pumps[i].pin, LOW); // Ensure all pumps are OFF
   }
   pinMode(BUZZER_PIN, OUTPUT);
   digitalWrite(BUZZER_PIN, LOW); // Ensure buzzer is OFF
+
+  // Restore flow models and dispensed totals. Models change rarely and are saved
+  // promptly; totals change with every dose and are coalesced to spare the flash.
+  for (int i = 0; i < NUM_PUMPS; i++) {
+    pump_flow_reset(flowModels[i], PUMP_MS_PER_ML);
+    dispensedMl[i] = 0;
+  }
+  flowModelsHandle = storage_register("flow_models", flowModels, sizeof(flowModels), FLOW_MODEL_COMMIT_DELAY_MS);
+  dispensedHandle = storage_register("dispensed_ml", dispensedMl, sizeof(dispensedMl), DISPENSED_VOLUME_COMMIT_DELAY_MS);
+
+  // Restore the learned draws; one far from the rated draw (e.g. after a pump
+  // was swapped for another model) is dropped and learned again.
+  memset(learnedDraws, 0, sizeof(learnedDraws));
+  learnedDrawsHandle = storage_register("pump_draws", learnedDraws, sizeof(learnedDraws), PUMP_DRAW_COMMIT_DELAY_MS);
+  for (int i = 0; i < NUM_PUMPS; i++) {
+    if (learnedDraws[i].w == 0) continue;
+    if (!draw_is_plausible(pumps[i], learnedDraws[i].w)) {
+      LOG_WARN("[Monitor] WARN: Stored draw of %s (%.1f W) is implausible; learning it again.\n", pumps[i].name,
+               learnedDraws[i].w);
+      learnedDraws[i].w = 0;
+      learnedDraws[i].a = 0;
+      continue;
+    }
+    pumps[i].drawW = learnedDraws[i].w;
+    pumps[i].drawA = learnedDraws[i].a;
+    pumps[i].drawLearned = true;
+  }
+
+  // Restore the mode and automation switches so control resumes right after a
+  // reset, before WiFi and MQTT are up. Retained commands still override them on connect.
+  systemModeHandle = storage_register("system_mode", &currentSystemMode, sizeof(currentSystemMode),
+                                      CONTROL_STATE_COMMIT_DELAY_MS);
+  if (currentSystemMode != NUTRITION && currentSystemMode != CLEANER) currentSystemMode = NUTRITION;
+  automationHandle = storage_register("automation", &automation_state, sizeof(automation_state),
+                                      CONTROL_STATE_COMMIT_DELAY_MS);
+  LOG_INFO("[Actuators] Mode %s; auto-dosing %s, auto-refill %s, auto-irrigation %s.\n",
+           currentSystemMode == NUTRITION ? "NUTRITION" : "CLEANER",
+           automation_state.auto_dosing_enabled ? "ON" : "OFF",
+           automation_state.auto_refill_enabled ? "ON" : "OFF",
+           automation_state.auto_irrigation_enabled ? "ON" : "OFF");
+}
+
+uint64_t actuators_output_pin_mask() {
+  uint64_t mask = 1ULL << BUZZER_PIN;
+  for (int i = 0; i < NUM_PUMPS; i++) {
+    mask |= 1ULL << pumps[i].pin;
+  }
+  return mask;
 }
 
 void actuators_loop(const SensorValues& currentValues) {
   unsigned long currentTime = millis();
+  lastKnownTdsPpm = currentValues.tdsPpm;
+  lastKnownLevelCm = currentValues.waterLevelCm;
   for (int i = 0; i < NUM_PUMPS; i++) {
     // Check if a timed run for this pump needs to be stopped
     if (pumps[i].isOn && pumps[i].stopTime > 0 && currentTime >= pumps[i].stopTime) {
-      digitalWrite(pumps[i].pin, LOW);
-      pumps[i].isOn = false;
       pumps[i].stopTime = 0;
-      LOG_PRINTF("[Actuator] %s finished timed run.\n", pumps[i].name);
-      mqtt_publish_state(pumps[i].stateTopic, PAYLOAD_OFF, true);
+      LOG_INFO("[Actuator] %s finished timed run.\n", pumps[i].name);
+      set_pump_output(pumps[i], false);
+      // The end of a short run may still reveal a fault (see end_pump_run()).
+      finish_pump_job(i, runMonitors[i].fault != PUMP_FAULT_NONE ? "fault" : "done");
     }
   }
 
+  // Start queued jobs while the power budget and exclusion groups allow it.
+  dispatch_pump_jobs();
+
+  // Trim the flow model once a dose has had time to mix.
+  check_tds_response();
+
   // Continuously check for tandon overflow safety, regardless of automation state.
   check_tandon_safety(currentValues);
+
+  // Publish what changed since the last iteration, including changes made by commands.
+  publish_dirty_states();
 }
 
 void actuators_handle_pump_command(const char* topic, const char* command) {
   // Find the pump that corresponds to the received topic
   for (int i = 0; i < NUM_PUMPS; i++) {
-    // Use strcmp for a robust comparison between the std::string from our config
-    // and the char* from the MQTT library. This is safer than direct `==` comparison.
-    if (strcmp(pumps[i].commandTopic.c_str(), topic) == 0) {
-      LOG_PRINTF("[Actuator] Command '%s' received for pump '%s'\n", command, pumps[i].name);
+    if (pumps[i].commandTopic == topic) {
+      // Structured commands carry a correlation ID and are acknowledged; bare ones are not.
+      CommandRef ref;
+      char value[24];
+      if (!command_ack_parse(command, ref, value, sizeof(value))) {
+        LOG_WARN("[Actuator] WARN: Command for %s has no value: %s\n", pumps[i].name, command);
+        command_ack_publish(ref, pumps[i].key, "rejected", 0, -1, -1, "no value");
+        return;
+      }
+      if (command_ack_is_duplicate(ref)) return;
+      LOG_INFO("[Actuator] Command '%s' received for pump '%s'\n", value, pumps[i].name);
 
       // First, handle the universal "OFF" command for any pump.
-      if (strcasecmp(command, "OFF") == 0) {
-        digitalWrite(pumps[i].pin, LOW);
-        pumps[i].isOn = false;
+      if (strcasecmp(value, "OFF") == 0) {
         pumps[i].stopTime = 0; // Cancel any timed run
-        LOG_PRINTF("  > Action: Turning OFF %s.\n", pumps[i].name);
-        mqtt_publish_state(pumps[i].stateTopic, PAYLOAD_OFF, true);
+        LOG_INFO("  > Action: Turning OFF %s.\n", pumps[i].name);
+        set_pump_output(pumps[i], false);
+        // An explicit OFF also drops this pump's waiting jobs, so it stays off.
+        finish_pump_job(i, "stopped");
+        cancel_queued_jobs(i, 0);
+        command_ack_publish(ref, pumps[i].key, "stopped", 0, -1, -1, nullptr);
         return; // Command handled
       }
 
@@ -122,38 +359,42 @@ void actuators_handle_pump_command(const char* topic, const char* command) {
       switch (pumps[i].pin) {
         case PUMP_TANDON_PIN:
           // The Tandon pump only accepts "ON".
-          if (strcasecmp(command, "ON") == 0) {
-            LOG_PRINTF("  > Action: Turning ON %s.\n", pumps[i].name);
-            digitalWrite(pumps[i].pin, HIGH);
-            pumps[i].isOn = true;
-            mqtt_publish_state(pumps[i].stateTopic, PAYLOAD_ON, true);
-          } else {
-            LOG_PRINTF("  > WARN: Invalid command for Tandon pump. Expected 'ON' or 'OFF'. Got '%s'.\n", command);
-          }
-          break;
-
-        case PUMP_SIRAM_PIN:
-          // The watering pump expects a duration in seconds.
-          { // Use a block to create a local variable
-            float duration_s = atof(command);
-            if (duration_s > 0) {
-              LOG_PRINTF("  > Action: Running %s for %.1f seconds.\n", pumps[i].name, duration_s);
-              control_pump_by_duration(pumps[i], duration_s * 1000);
+          if (strcasecmp(value, "ON") == 0) {
+            const char* reason = nullptr;
+            if (pumps[i].isOn) {
+              LOG_INFO("  > %s is already ON.\n", pumps[i].name);
+              command_ack_publish(ref, pumps[i].key, "running", 0, -1, -1, nullptr);
+            } else if (!can_start_pump(i, &reason)) {
+              // Refused: republish OFF so the Home Assistant switch falls back.
+              LOG_WARN("  > WARN: Cannot turn ON %s now (%s).\n", pumps[i].name, reason);
+              startsRefused++;
+              dirtyStates |= 1 << i;
+              actuators_publish_queue_status();
+              command_ack_publish(ref, pumps[i].key, "rejected", 0, -1, -1, reason);
             } else {
-              LOG_PRINTF("  > WARN: Invalid duration for Siram pump. Expected a positive number. Got '%s'.\n", command);
+              LOG_INFO("  > Action: Turning ON %s.\n", pumps[i].name);
+              set_pump_output(pumps[i], true);
+              directCommands[i] = ref;
+              command_ack_publish(ref, pumps[i].key, "started", 0, 0, -1, nullptr);
             }
+          } else {
+            LOG_WARN("  > WARN: Invalid command for Tandon pump. Expected 'ON' or 'OFF'. Got '%s'.\n", value);
+            command_ack_publish(ref, pumps[i].key, "rejected", 0, -1, -1, "invalid value");
           }
           break;
 
-        default: // Handles PUMP_NUTRISI_A, PUMP_NUTRISI_B, PUMP_PH
-          // Dosing pumps expect a volume in milliliters.
+        default:
+          // Watering (seconds) and dosing (ml) pumps are queued as timed jobs.
           { // Use a block to create a local variable
-            float volume_ml = atof(command);
-            if (volume_ml > 0) {
-              LOG_PRINTF("  > Action: Dosing %.1f ml with %s.\n", volume_ml, pumps[i].name);
-              control_pump_by_volume(pumps[i], volume_ml);
+            unsigned long duration_ms = pump_amount_to_duration_ms(pumps[i], atof(value));
+            if (duration_ms > 0) {
+              LOG_INFO("  > Action: Queueing %s for %lu ms.\n", pumps[i].name, duration_ms);
+              uint32_t jobId = enqueue_pump_job(i, duration_ms, 0, 0, &ref);
+              command_ack_publish(ref, pumps[i].key, jobId ? "queued" : "rejected", jobId, -1, -1,
+                                  jobId ? nullptr : "queue full");
             } else {
-              LOG_PRINTF("  > WARN: Invalid volume for Dosing pump. Expected a positive number. Got '%s'.\n", command);
+              LOG_WARN("  > WARN: Invalid amount for %s. Expected a positive number. Got '%s'.\n", pumps[i].name, value);
+              command_ack_publish(ref, pumps[i].key, "rejected", 0, -1, -1, "invalid value");
             }
           }
           break;
@@ -161,7 +402,7 @@ void actuators_handle_pump_command(const char* topic, const char* command) {
       return; // Command handled
     }
   }
-  LOG_PRINTF("[Actuators] WARN: Received command on unhandled topic: %s\n", topic);
+  LOG_WARN("[Actuators] WARN: Received command on unhandled topic: %s\n", topic);
 }
 
 void actuators_handle_mode_command(const char* command) {
@@ -181,15 +422,16 @@ void actuators_handle_mode_command(const char* command) {
       newModeStr = "CLEANER";
     }
   } else {
-    LOG_PRINTF("[Mode] WARN: Received unknown mode command: %s\n", command);
+    LOG_WARN("[Mode] WARN: Received unknown mode command: %s\n", command);
     return;
   }
 
   if (modeChanged) {
-    LOG_PRINTF("[Mode] System mode changed to %s\n", newModeStr);
-    mqtt_publish_state(STATE_TOPIC_SYSTEM_MODE, newModeStr, true);
+    LOG_INFO("[Mode] System mode changed to %s\n", newModeStr);
+    storage_mark_dirty(systemModeHandle);
+    dirtyStates |= DIRTY_MODE;
   } else {
-    LOG_PRINTF("[Mode] System already in %s mode.\n", command);
+    LOG_INFO("[Mode] System already in %s mode.\n", command);
   }
 }
 
@@ -207,19 +449,21 @@ void actuators_update_alert_status(const SensorValues& values) {
     if (isnan(values.waterLevelCm)) {
       strcpy(alertMessage, "ALERT: Water level sensor reading is invalid!");
     } else {
-      sprintf(alertMessage, "ALERT: Water level is critical! Current: %.1f cm", values.waterLevelCm);
+      char level[16];
+      number_format_fixed(level, sizeof(level), values.waterLevelCm, 1);
+      snprintf(alertMessage, sizeof(alertMessage), "ALERT: Water level is critical! Current: %s cm", level);
     }
-    LOG_PRINTF(">>> ALERT: %s <<<\n", alertMessage);
+    LOG_WARN(">>> ALERT: %s <<<\n", alertMessage);
     mqtt_publish_alert(alertMessage);
   }
   // State change: from alert to normal
   else if ((!shouldAlertBeActive) && isWaterLevelAlertActive) {
     isWaterLevelAlertActive = false;
     if (alarmsEnabled) {
-      LOG_PRINTLN(">>> INFO: Water level has returned to normal. <<<");
+      LOG_INFO(">>> INFO: Water level has returned to normal. <<<\n");
       mqtt_publish_alert("OK: Water level is normal.");
     } else {
-      LOG_PRINTLN(">>> INFO: Alerts suppressed in CLEANER mode. <<<");
+      LOG_INFO(">>> INFO: Alerts suppressed in CLEANER mode. <<<\n");
     }
   }
 
@@ -228,64 +472,782 @@ void actuators_update_alert_status(const SensorValues& values) {
 }
 
 void actuators_publish_states() {
-  LOG_PRINTLN("[Actuators] Syncing current actuator states to MQTT...");
+  LOG_DEBUG("[Actuators] Syncing current actuator states to MQTT...\n");
+  dirtyStates |= DIRTY_PUMPS | DIRTY_MODE;
+  publish_dirty_states();
+}
+
+void actuators_publish_snapshot() {
+  char payload[256];
+  size_t len = snprintf(payload, sizeof(payload), "{\"pumps\":{");
+  for (int i = 0; i < NUM_PUMPS && len < sizeof(payload); i++) {
+    len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":%s", i ? "," : "", pumps[i].key,
+                    pumps[i].isOn ? "true" : "false");
+  }
+  if (len < sizeof(payload)) {
+    snprintf(payload + len, sizeof(payload) - len,
+             "},\"mode\":\"%s\",\"automation\":{\"dosing\":%s,\"refill\":%s,\"irrigation\":%s},\"queue\":%d}",
+             currentSystemMode == NUTRITION ? "NUTRITION" : "CLEANER",
+             automation_state.auto_dosing_enabled ? "true" : "false",
+             automation_state.auto_refill_enabled ? "true" : "false",
+             automation_state.auto_irrigation_enabled ? "true" : "false", jobQueueLength);
+  }
+  mqtt_publish_state(STATE_TOPIC_ACTUATOR_SNAPSHOT, payload, true);
+}
+
+bool actuators_get_pump_status(int index, PumpStatus& status) {
+  if (index < 0 || index >= NUM_PUMPS) return false;
+  status.key = pumps[index].key;
+  status.isOn = pumps[index].isOn;
+  status.dosing = pumps[index].group == GROUP_DOSING;
+  status.dispensedMl = dispensedMl[index];
+  return true;
+}
+
+const char* actuators_mode_name() {
+  return currentSystemMode == NUTRITION ? "NUTRITION" : "CLEANER";
+}
+
+int actuators_queue_length() {
+  return jobQueueLength;
+}
+
+bool actuators_alert_active() {
+  return currentSystemMode == NUTRITION && isWaterLevelAlertActive;
+}
+
+
+void actuators_handle_queue_command(const char* command) {
+  // "CANCEL" clears every waiting job, "CANCEL <id>" a single one.
+  if (strncasecmp(command, "CANCEL", 6) == 0) {
+    const char* id = command + 6;
+    uint32_t jobId = 0;
+    if (*id != '\0') {
+      // Anything else, such as "CANCELLED" or "CANCEL job7", must not fall back to cancelling everything.
+      char* end = nullptr;
+      if (*id == ' ' && id[1] >= '0' && id[1] <= '9') jobId = strtoul(id + 1, &end, 10);
+      if (jobId == 0 || *end != '\0') {
+        LOG_WARN("[Queue] WARN: Invalid cancel command '%s'. Expected 'CANCEL' or 'CANCEL <id>'.\n", command);
+        return;
+      }
+    }
+    LOG_INFO("[Queue] Cancel requested for %s.\n", jobId ? "one job" : "all jobs");
+    cancel_queued_jobs(-1, jobId);
+    return;
+  }
+
+  // Otherwise the payload is a sequence: "[prio:<n>,]<pump>:<amount>[:<settle_s>],..."
+  char buffer[256];
+  strncpy(buffer, command, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  struct { int pumpIndex; unsigned long durationMs; unsigned long settleMs; } steps[PUMP_JOB_QUEUE_CAPACITY];
+  int numSteps = 0;
+  uint8_t priority = 0;
+
+  char* itemCtx = nullptr;
+  for (char* item = strtok_r(buffer, ",", &itemCtx); item != nullptr; item = strtok_r(nullptr, ",", &itemCtx)) {
+    char* fieldCtx = nullptr;
+    char* key = strtok_r(item, ": ", &fieldCtx);
+    char* amount = strtok_r(nullptr, ": ", &fieldCtx);
+    char* settle = strtok_r(nullptr, ": ", &fieldCtx);
+    if (key == nullptr || amount == nullptr) continue;
+
+    if (strcasecmp(key, "prio") == 0) {
+      priority = (uint8_t)constrain(atoi(amount), 0, 255);
+      continue;
+    }
+
+    int pumpIndex = -1;
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (strcasecmp(pumps[i].key, key) == 0) pumpIndex = i;
+    }
+    unsigned long duration_ms = pumpIndex < 0 ? 0 : pump_amount_to_duration_ms(pumps[pumpIndex], atof(amount));
+    if (duration_ms == 0 || numSteps >= PUMP_JOB_QUEUE_CAPACITY) {
+      LOG_WARN("[Queue] WARN: Rejecting sequence, invalid or excess step '%s:%s'.\n", key, amount);
+      jobsRejected++;
+      actuators_publish_queue_status();
+      return;
+    }
+    steps[numSteps].pumpIndex = pumpIndex;
+    steps[numSteps].durationMs = duration_ms;
+    steps[numSteps].settleMs = settle ? (unsigned long)(atof(settle) * 1000) : 0;
+    numSteps++;
+  }
+
+  // A sequence is queued completely or not at all.
+  if (numSteps == 0 || jobQueueLength + numSteps > PUMP_JOB_QUEUE_CAPACITY) {
+    LOG_WARN("[Queue] WARN: Rejecting sequence of %d step(s), depth %d.\n", numSteps, jobQueueLength);
+    jobsRejected++;
+    actuators_publish_queue_status();
+    return;
+  }
+  for (int i = 0; i < numSteps; i++) {
+    enqueue_pump_job(steps[i].pumpIndex, steps[i].durationMs, steps[i].settleMs, priority, nullptr);
+  }
+}
+
+void actuators_handle_calibration_command(const char* command) {
+  // Expected payloads: "<pump>:run:<ms>", "<pump>:ml:<measured ml>" or "<pump>:reset".
+  // Any pump accepts "reset", which also forgets its learned draw, e.g. after it was replaced.
+  char buffer[64];
+  strncpy(buffer, command, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  char* ctx = nullptr;
+  char* key = strtok_r(buffer, ": ", &ctx);
+  char* action = strtok_r(nullptr, ": ", &ctx);
+  char* value = strtok_r(nullptr, ": ", &ctx);
+
+  bool reset = action != nullptr && strcasecmp(action, "reset") == 0;
+  int pumpIndex = -1;
+  for (int i = 0; key != nullptr && i < NUM_PUMPS; i++) {
+    if ((pumps[i].group == GROUP_DOSING || reset) && strcasecmp(pumps[i].key, key) == 0) pumpIndex = i;
+  }
+  if (pumpIndex < 0 || action == nullptr) {
+    LOG_WARN("[Dosing] WARN: Invalid calibration command '%s'.\n", command);
+    return;
+  }
+  PumpFlowModel& model = flowModels[pumpIndex];
+
+  if (strcasecmp(action, "run") == 0 && value != nullptr && atol(value) > 0) {
+    // Run for an exact time; the operator measures the output and replies with "ml".
+    calibrationPumpIndex = pumpIndex;
+    calibrationRunMs = 0;
+    LOG_INFO("[Dosing] Calibration run for %s: %ld ms.\n", pumps[pumpIndex].name, atol(value));
+    enqueue_pump_job(pumpIndex, (unsigned long)atol(value), 0, 0, nullptr);
+  } else if (strcasecmp(action, "ml") == 0 && value != nullptr) {
+    if (pumpIndex != calibrationPumpIndex || calibrationRunMs == 0) {
+      LOG_WARN("[Dosing] WARN: No finished calibration run for %s.\n", pumps[pumpIndex].name);
+      return;
+    }
+    if (pump_flow_add_calibration(model, (float)calibrationRunMs, atof(value))) {
+      LOG_INFO("[Dosing] %s calibrated: %.2f ms/ml, dead time %.0f ms.\n",
+                 pumps[pumpIndex].name, model.msPerMl, model.deadTimeMs);
+      storage_mark_dirty(flowModelsHandle);
+    } else {
+      LOG_WARN("[Dosing] WARN: Implausible calibration for %s ignored.\n", pumps[pumpIndex].name);
+    }
+    calibrationPumpIndex = -1;
+  } else if (reset) {
+    Pump& pump = pumps[pumpIndex];
+    pump.drawW = pump.ratedW;
+    pump.drawA = pump.ratedA;
+    pump.drawLearned = false;
+    learnedDraws[pumpIndex].w = 0;
+    learnedDraws[pumpIndex].a = 0;
+    storage_mark_dirty(learnedDrawsHandle);
+    actuators_publish_power_profile();
+    LOG_INFO("[Monitor] %s draw reset to the rated %.1f W.\n", pump.name, pump.ratedW);
+    if (pump.group != GROUP_DOSING) return;
+    pump_flow_reset(model, PUMP_MS_PER_ML);
+    storage_mark_dirty(flowModelsHandle);
+    LOG_INFO("[Dosing] %s flow model reset to %.2f ms/ml.\n", pump.name, PUMP_MS_PER_ML);
+  } else {
+    LOG_WARN("[Dosing] WARN: Invalid calibration command '%s'.\n", command);
+    return;
+  }
+  actuators_publish_flow_models();
+}
+
+void actuators_publish_flow_models() {
+  char payload[256];
+  size_t len = snprintf(payload, sizeof(payload), "{");
+  for (int i = 0; i < NUM_PUMPS && len < sizeof(payload); i++) {
+    if (pumps[i].group != GROUP_DOSING) continue;
+    char msPerMl[16], deadMs[16], totalMl[16];
+    number_format_fixed(msPerMl, sizeof(msPerMl), flowModels[i].msPerMl, 2);
+    number_format_fixed(deadMs, sizeof(deadMs), flowModels[i].deadTimeMs, 0);
+    number_format_fixed(totalMl, sizeof(totalMl), dispensedMl[i], 1);
+    len += snprintf(payload + len, sizeof(payload) - len,
+                    "%s\"%s\":{\"ms_per_ml\":%s,\"dead_ms\":%s,\"points\":%u,\"total_ml\":%s}",
+                    len > 1 ? "," : "", pumps[i].key, msPerMl, deadMs, flowModels[i].calPoints, totalMl);
+  }
+  if (len < sizeof(payload)) {
+    snprintf(payload + len, sizeof(payload) - len, "}");
+  }
+  mqtt_publish_state(STATE_TOPIC_PUMP_CALIBRATION, payload, true);
+}
+
+void actuators_publish_queue_status() {
+  char running[64] = "";
+  size_t len = 0;
+  for (int i = 0; i < NUM_PUMPS && len < sizeof(running); i++) {
+    if (pumps[i].isOn) {
+      len += snprintf(running + len, sizeof(running) - len, "%s%s", len ? "," : "", pumps[i].key);
+    }
+  }
+  char peakW[16];
+  number_format_fixed(peakW, sizeof(peakW), peakPowerW, 1);
+  char payload[256];
+  snprintf(payload, sizeof(payload),
+           "{\"depth\":%d,\"capacity\":%d,\"running\":\"%s\",\"completed\":%u,\"cancelled\":%u,"
+           "\"rejected\":%u,\"refused_starts\":%u,\"run_s\":%lu,\"busy_s\":%lu,\"peak_pumps\":%d,\"peak_w\":%s}",
+           jobQueueLength, PUMP_JOB_QUEUE_CAPACITY, running, jobsCompleted, jobsCancelled, jobsRejected,
+           startsRefused, totalPumpRunMs / 1000, busyMs / 1000, peakConcurrentPumps, peakW);
+  mqtt_publish_state(STATE_TOPIC_PUMP_QUEUE, payload, true);
+}
+
+void actuators_handle_power_sample(const SensorValues& values) {
+  unsigned long now = millis();
+  float powerW = values.pzemPower;
+  float currentA = values.pzemCurrent;
+  if (isnan(powerW) || isnan(currentA)) return;
+
+  uint8_t mask = running_pump_mask();
+  unsigned long dtMs = lastSampleTime ? min(now - lastSampleTime, (unsigned long)SENSOR_PUBLISH_INTERVAL_MS) : 0;
+  const PumpMonitorConfig cfg = pump_monitor_config();
+
+  if (mask == 0) {
+    if (releaseCheckActive && now - releaseCheckStart >= cfg.inrushMs) {
+      // The meter has had time to settle: a large residual means a relay did not release.
+      bool high = !isnan(idlePowerW) && powerW - idlePowerW > 0.5f * releaseExpectedW;
+      releaseHighCount = high ? releaseHighCount + 1 : 0;
+      if (releaseHighCount >= cfg.confirmSamples) {
+        LOG_WARN("[Monitor] ALERT: %.1f W still drawn with all pumps OFF.\n", powerW);
+        mqtt_publish_alert("ALERT: Power draw persists with all pumps OFF. A relay may be stuck ON!");
+        releaseCheckActive = false;
+      } else if (now - releaseCheckStart >= 3 * cfg.inrushMs) {
+        releaseCheckActive = false;
+      }
+    } else if (!releaseCheckActive && switchesSinceSample == 0) {
+      const float IDLE_ALPHA = 0.2f; // Smoothing factor for the idle reference.
+      idlePowerW = isnan(idlePowerW) ? powerW : idlePowerW + IDLE_ALPHA * (powerW - idlePowerW);
+      idleCurrentA = isnan(idleCurrentA) ? currentA : idleCurrentA + IDLE_ALPHA * (currentA - idleCurrentA);
+    }
+  } else {
+    if (powerW > peakPowerW) peakPowerW = powerW;
+
+    float totalDrawW = 0;
+    float totalDrawA = 0;
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (pumps[i].isOn) {
+        totalDrawW += pumps[i].drawW;
+        totalDrawA += pumps[i].drawA;
+      }
+    }
+    float referenceW = isnan(idlePowerW) ? powerW - totalDrawW : idlePowerW;
+    float excessW = max(0.0f, powerW - referenceW);
+
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (!pumps[i].isOn) continue;
+      PumpRunMonitor& run = runMonitors[i];
+
+      // A pump's share is the rise over the reading taken just before it started,
+      // or, once other pumps have switched since, the residual after removing the
+      // idle draw and the other pumps' learned draw.
+      float shareW, shareA;
+      if (run.exact) {
+        shareW = powerW - run.refPowerW;
+        shareA = currentA - run.refCurrentA;
+      } else {
+        shareW = powerW - referenceW - (totalDrawW - pumps[i].drawW);
+        shareA = isnan(idleCurrentA) ? NAN : currentA - idleCurrentA - (totalDrawA - pumps[i].drawA);
+      }
+
+      // Energy is split by learned draw; faults are only judged while this pump
+      // dominates the expected load, otherwise meter noise from a larger pump
+      // would be blamed on it.
+      pump_monitor_add_energy(run, totalDrawW > 0 ? excessW * pumps[i].drawW / totalDrawW : 0, dtMs);
+      bool dominant = pumps[i].drawW >= 0.6f * totalDrawW;
+      float baselineW = pumps[i].drawLearned ? pumps[i].drawW : NAN;
+      PumpFault fault = pump_monitor_sample(run, cfg, baselineW, shareW, shareA, dominant, now);
+      if (fault != PUMP_FAULT_NONE) {
+        abort_pump_run(i, fault, shareW);
+      }
+    }
+  }
+
+  lastSamplePowerW = powerW;
+  lastSampleCurrentA = currentA;
+  lastSampleTime = now;
+  switchesSinceSample = 0;
+}
+
+bool actuators_power_monitor_active() {
+  return running_pump_mask() != 0 || releaseCheckActive;
+}
+
+bool actuators_timed_run_ends_within(unsigned long spanMs) {
+  unsigned long now = millis();
   for (int i = 0; i < NUM_PUMPS; i++) {
-    mqtt_publish_state(pumps[i].stateTopic, pumps[i].isOn ? PAYLOAD_ON : PAYLOAD_OFF, true);
+    if (pumps[i].isOn && pumps[i].stopTime > 0 && (long)(pumps[i].stopTime - now) <= (long)spanMs) return true;
   }
-  mqtt_publish_state(STATE_TOPIC_SYSTEM_MODE, currentSystemMode == NUTRITION ? "NUTRITION" : "CLEANER", true);
+  return false;
+}
+
+void actuators_publish_power_profile() {
+  char watts[16], amps[16];
+  number_format_fixed(watts, sizeof(watts), PUMP_POWER_BUDGET_W, 1);
+  number_format_fixed(amps, sizeof(amps), PUMP_CURRENT_BUDGET_A, 2);
+  char payload[256];
+  size_t len = snprintf(payload, sizeof(payload), "{\"budget_w\":%s,\"budget_a\":%s", watts, amps);
+  for (int i = 0; i < NUM_PUMPS && len < sizeof(payload); i++) {
+    number_format_fixed(watts, sizeof(watts), pumps[i].drawW, 1);
+    number_format_fixed(amps, sizeof(amps), pumps[i].drawA, 3);
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"%s\":{\"w\":%s,\"a\":%s}",
+                    pumps[i].key, watts, amps);
+  }
+  if (len < sizeof(payload)) {
+    snprintf(payload + len, sizeof(payload) - len, "}");
+  }
+  mqtt_publish_state(STATE_TOPIC_PUMP_POWER, payload, true);
 }
 
 
 // --- Static (Private) Function Implementations ---
 
 /**
- * @brief Checks if any pump is currently running.
- * @return true if a pump is active, false otherwise.
+ * @brief Builds a bit mask of running pumps, bit `i` standing for `pumps[i]`.
+ * @return The mask of running pumps.
  */
-static bool are_any_pumps_running() {
+static uint8_t running_pump_mask() {
+  uint8_t mask = 0;
   for (int i = 0; i < NUM_PUMPS; i++) {
-    if (pumps[i].isOn) return true;
+    if (pumps[i].isOn) mask |= (1 << i);
   }
-  return false;
+  return mask;
 }
 
 /**
- * @brief Starts a pump to run for a duration calculated from a volume.
- * @param pump The pump to control.
- * @param volume_ml The volume in milliliters to dispense.
+ * @brief Decides whether a pump may start next to the pumps already running.
+ * A pump is refused if it is already on, conflicts with a running pump's exclusion
+ * group, or would push the projected draw over the configured budget. A pump is
+ * always allowed when nothing else runs, so a single large pump never starves.
+ * @param pumpIndex Index of the candidate pump in `pumps[]`.
+ * @param reason Receives a short explanation when the start is refused.
+ * @return true if the pump may start now.
  */
-static void control_pump_by_volume(Pump& pump, float volume_ml) {
-  if (volume_ml <= 0) return;
-  
-  // Safety check: Do not start a new pump if one is already running.
-  if (are_any_pumps_running()) {
-    LOG_PRINTF("[Actuator] Cannot start %s, another pump is running.\n", pump.name);
-    return;
+static bool can_start_pump(int pumpIndex, const char** reason) {
+  const Pump& candidate = pumps[pumpIndex];
+  if (candidate.isOn) {
+    *reason = "pump already running";
+    return false;
+  }
+
+  float projectedW = candidate.drawW;
+  float projectedA = candidate.drawA;
+  bool othersRunning = false;
+  for (int i = 0; i < NUM_PUMPS; i++) {
+    if (!pumps[i].isOn) continue;
+    if ((candidate.excludes & pumps[i].group) || (pumps[i].excludes & candidate.group)) {
+      *reason = "exclusion group";
+      return false;
+    }
+    projectedW += pumps[i].drawW;
+    projectedA += pumps[i].drawA;
+    othersRunning = true;
+  }
+
+  if (othersRunning && (projectedW > PUMP_POWER_BUDGET_W || projectedA > PUMP_CURRENT_BUDGET_A)) {
+    *reason = "power budget";
+    return false;
   }
-  
-  unsigned long duration_ms = volume_ml * PUMP_MS_PER_ML;
-  control_pump_by_duration(pump, duration_ms);
+  return true;
+}
+
+/**
+ * @brief Converts a command amount into a run duration for the given pump.
+ * The watering pump takes seconds; the dosing pumps take milliliters.
+ * @param pump The pump the amount refers to.
+ * @param amount The amount from the command payload.
+ * @return The run duration in milliseconds, or 0 if the amount is invalid.
+ */
+static unsigned long pump_amount_to_duration_ms(const Pump& pump, float amount) {
+  if (!(amount > 0) || pump.pin == PUMP_TANDON_PIN) return 0;
+  if (pump.pin == PUMP_SIRAM_PIN) return (unsigned long)(amount * 1000);
+  return pump_flow_duration_ms(flowModels[&pump - pumps], amount);
 }
 
 /**
  * @brief Starts a pump to run for a specific duration. This is the core pump control function.
+ * Callers are responsible for the scheduling rules; queued jobs are only
+ * started by `dispatch_pump_jobs()` once `can_start_pump()` allows it.
  * @param pump The pump to control.
  * @param duration_ms The duration in milliseconds to run the pump.
  */
 static void control_pump_by_duration(Pump& pump, unsigned long duration_ms) {
   if (duration_ms <= 0) return;
 
-  // Safety check: Do not start a new pump if one is already running.
-  if (are_any_pumps_running()) {
-    LOG_PRINTF("[Actuator] Cannot start %s, another pump is running.\n", pump.name);
-    return;
+  LOG_INFO("[Actuator] Running %s for %lu ms.\n", pump.name, duration_ms);
+  pump.stopTime = millis() + duration_ms;
+  set_pump_output(pump, true);
+}
+
+/**
+ * @brief Switches a pump's relay, marks its state for publishing and updates the run-time statistics.
+ * Every pump transition goes through here so power learning sees all switches.
+ * @param pump The pump to switch.
+ * @param on true to energize the relay, false to release it.
+ */
+static void set_pump_output(Pump& pump, bool on) {
+  unsigned long now = millis();
+  if (on != pump.isOn) {
+    int index = &pump - pumps;
+    uint8_t maskBefore = running_pump_mask();
+    digitalWrite(pump.pin, on ? HIGH : LOW);
+    pump.isOn = on;
+    switchesSinceSample++;
+
+    // Any switch makes the other runs' "reading minus reference" share inexact.
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (i != index && pumps[i].isOn) runMonitors[i].exact = false;
+    }
+    if (on) {
+      pump.onSince = now;
+      // A TDS response is only attributable to a dose that runs alone.
+      tdsCheck.waiting = false;
+      tdsCheck.armed = pump.group == GROUP_DOSING && maskBefore == 0 && !isnan(lastKnownTdsPpm) && !isnan(lastKnownLevelCm);
+      if (tdsCheck.armed) {
+        tdsCheck.pumpIndex = index;
+        tdsCheck.tdsBefore = lastKnownTdsPpm;
+        tdsCheck.levelCm = lastKnownLevelCm;
+      }
+      // The reference is only valid if nothing switched since it was taken.
+      bool fresh = switchesSinceSample == 1;
+      pump_monitor_start(runMonitors[index], pump_monitor_config(), now, pump.stopTime ? pump.stopTime - now : 0,
+                         fresh ? lastSamplePowerW : NAN, fresh ? lastSampleCurrentA : NAN);
+    } else {
+      totalPumpRunMs += now - pump.onSince;
+      end_pump_run(index);
+    }
+
+    dirtyStates |= 1 << index;
+
+    uint8_t maskAfter = running_pump_mask();
+    if (maskBefore == 0 && maskAfter != 0) busySince = now;
+    if (maskBefore != 0 && maskAfter == 0) {
+      busyMs += now - busySince;
+      releaseCheckActive = true;
+      releaseCheckStart = now;
+      releaseExpectedW = pump.drawW;
+      releaseHighCount = 0;
+    }
+
+    int running = 0;
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (pumps[i].isOn) running++;
+    }
+    if (running > peakConcurrentPumps) peakConcurrentPumps = running;
   }
+}
 
-  LOG_PRINTF("[Actuator] Running %s for %lu ms.\n", pump.name, duration_ms);
-  pump.stopTime = millis() + duration_ms;
-  digitalWrite(pump.pin, HIGH);
-  pump.isOn = true;
-  mqtt_publish_state(pump.stateTopic, PAYLOAD_ON, true);
+/**
+ * @brief Closes the monitor of a finished run: judges a run too short to be judged
+ * while it ran, learns the pump's draw from a clean, undisturbed run and publishes
+ * the run's energy and outcome.
+ * @param pumpIndex Index of the pump that was just switched off.
+ */
+static void end_pump_run(int pumpIndex) {
+  Pump& pump = pumps[pumpIndex];
+  PumpRunMonitor& run = runMonitors[pumpIndex];
+  unsigned long runMs = millis() - run.startMs;
+  // A fault confirmed while running was reported when the run was aborted.
+  PumpFault endFault = PUMP_FAULT_NONE;
+  if (run.fault == PUMP_FAULT_NONE) {
+    endFault = pump_monitor_finish(run, pump_monitor_config(), pump.drawLearned ? pump.drawW : NAN);
+  }
+
+  if (pump.group == GROUP_DOSING) {
+    float ml = pump_flow_volume_ml(flowModels[pumpIndex], runMs);
+    dispensedMl[pumpIndex] += ml;
+    storage_mark_dirty(dispensedHandle);
+    if (pumpIndex == calibrationPumpIndex) {
+      calibrationRunMs = runMs;
+    }
+    if (tdsCheck.armed && tdsCheck.pumpIndex == pumpIndex && run.exact && run.fault == PUMP_FAULT_NONE) {
+      tdsCheck.waiting = true;
+      tdsCheck.runMs = runMs;
+      tdsCheck.ml = ml;
+      tdsCheck.doneAt = millis();
+    }
+    tdsCheck.armed = false;
+    actuators_publish_flow_models();
+  }
+
+  float meanW, meanA;
+  if (run.fault == PUMP_FAULT_NONE && pump_monitor_steady_mean(run, meanW, meanA)) {
+    if (!draw_is_plausible(pump, meanW)) {
+      // Most likely a first run that was already dry or blocked.
+      LOG_WARN("[Monitor] WARN: %s drew %.1f W, rated %.1f W; not learned.\n", pump.name, meanW, pump.ratedW);
+    } else {
+      // The first measurement replaces the rated draw outright.
+      const float ALPHA = pump.drawLearned ? 0.3f : 1.0f; // Smoothing factor for the learned draw.
+      pump.drawW += ALPHA * (max(0.5f, meanW) - pump.drawW);
+      pump.drawA += ALPHA * (max(0.005f, meanA) - pump.drawA);
+      pump.drawLearned = true;
+      // Run-to-run jitter is not worth a flash write; the stored draw follows once it is 5% off.
+      LearnedDraw& stored = learnedDraws[pumpIndex];
+      if (!(fabsf(pump.drawW - stored.w) <= 0.05f * stored.w)) {
+        stored.w = pump.drawW;
+        stored.a = pump.drawA;
+        storage_mark_dirty(learnedDrawsHandle);
+      }
+      LOG_INFO("[Monitor] Learned draw for %s: %.1f W, %.3f A.\n", pump.name, pump.drawW, pump.drawA);
+      actuators_publish_power_profile();
+    }
+  }
+
+  char energyWh[16];
+  number_format_fixed(energyWh, sizeof(energyWh), (float)run.energyWh, 4);
+  char payload[160];
+  snprintf(payload, sizeof(payload),
+           "{\"pump\":\"%s\",\"run_ms\":%lu,\"energy_wh\":%s,\"samples\":%u,\"fault\":\"%s\"}",
+           pump.key, runMs, energyWh, run.steadySamples, pump_fault_name(run.fault));
+  mqtt_publish_state(STATE_TOPIC_PUMP_MONITOR, payload, false);
+
+  if (endFault != PUMP_FAULT_NONE) {
+    report_pump_fault(pumpIndex, endFault, (float)(run.shareSumW / run.exactSamples));
+  }
+}
+
+/**
+ * @brief Stops a pump whose power signature shows a fault and reports it.
+ * @param pumpIndex Index of the faulty pump.
+ * @param fault The detected fault.
+ * @param shareW The power share measured for the pump at detection.
+ */
+static void abort_pump_run(int pumpIndex, PumpFault fault, float shareW) {
+  Pump& pump = pumps[pumpIndex];
+  pump.stopTime = 0;
+  set_pump_output(pump, false);
+  finish_pump_job(pumpIndex, "fault");
+  report_pump_fault(pumpIndex, fault, shareW);
+}
+
+/**
+ * @brief Raises the alert for a pump fault and drops the pump's waiting jobs:
+ * an empty bottle or a blocked line will not fix itself before the next dose.
+ * @param pumpIndex Index of the faulty pump.
+ * @param fault The detected fault.
+ * @param shareW The power share measured for the pump, at detection or as the run's mean.
+ */
+static void report_pump_fault(int pumpIndex, PumpFault fault, float shareW) {
+  const Pump& pump = pumps[pumpIndex];
+  char measuredW[16], learnedW[16];
+  number_format_fixed(measuredW, sizeof(measuredW), shareW, 1);
+  number_format_fixed(learnedW, sizeof(learnedW), pump.drawW, 1);
+  char alertMessage[100];
+  snprintf(alertMessage, sizeof(alertMessage), "ALERT: %s stopped, %s detected (%s W, learned %s W)",
+           pump.name, pump_fault_name(fault), measuredW, learnedW);
+  LOG_ERROR(">>> %s <<<\n", alertMessage);
+  cancel_queued_jobs(pumpIndex, 0);
+  mqtt_publish_alert(alertMessage);
+}
+
+/**
+ * @brief Checks a measured draw against the pump's rated draw before it may become the baseline.
+ * @param pump The pump.
+ * @param watts The measured draw.
+ * @return true if the draw lies within PUMP_DRAW_MIN_RATIO..PUMP_DRAW_MAX_RATIO of the rated draw.
+ */
+static bool draw_is_plausible(const Pump& pump, float watts) {
+  return watts >= PUMP_DRAW_MIN_RATIO * pump.ratedW && watts <= PUMP_DRAW_MAX_RATIO * pump.ratedW;
+}
+
+/**
+ * @brief Compares the TDS rise after a lone nutrient dose with the rise the
+ * delivered volume should have caused, and trims the pump's rate accordingly.
+ * Disabled while `TDS_RESPONSE_PPM_LITERS_PER_ML` is 0.
+ */
+static void check_tds_response() {
+  if (!tdsCheck.waiting || millis() - tdsCheck.doneAt < TDS_RESPONSE_SETTLE_MS) return;
+  tdsCheck.waiting = false;
+
+  const Pump& pump = pumps[tdsCheck.pumpIndex];
+  if (pump.pin == PUMP_PH_PIN || TDS_RESPONSE_PPM_LITERS_PER_ML <= 0 || isnan(lastKnownTdsPpm)) return;
+
+  float liters = tdsCheck.levelCm * TANDON_LITERS_PER_CM;
+  if (!(liters > 0)) return;
+  float expectedPpm = tdsCheck.ml * TDS_RESPONSE_PPM_LITERS_PER_ML / liters;
+  float observedPpm = lastKnownTdsPpm - tdsCheck.tdsBefore;
+  // Rises within sensor noise say nothing about the delivered volume.
+  const float MIN_RESOLVABLE_PPM = 5.0f;
+  if (expectedPpm < MIN_RESOLVABLE_PPM || observedPpm <= 0) return;
+
+  float ratio = constrain(observedPpm / expectedPpm, 0.5f, 2.0f);
+  pump_flow_apply_response(flowModels[tdsCheck.pumpIndex], tdsCheck.runMs, tdsCheck.ml * ratio, TDS_RESPONSE_GAIN);
+  storage_mark_dirty(flowModelsHandle);
+  LOG_INFO("[Dosing] TDS response for %s: +%.1f ppm (expected %.1f). Rate now %.2f ms/ml.\n",
+             pump.name, observedPpm, expectedPpm, flowModels[tdsCheck.pumpIndex].msPerMl);
+  actuators_publish_flow_models();
+}
+
+/**
+ * @brief Collects the pump monitor thresholds from the configuration.
+ * @return The detection thresholds.
+ */
+static PumpMonitorConfig pump_monitor_config() {
+  PumpMonitorConfig cfg;
+  cfg.inrushMs = PUMP_MONITOR_INRUSH_MS;
+  cfg.sampleIntervalMs = PUMP_MONITOR_SAMPLE_INTERVAL_MS;
+  cfg.dryRunRatio = PUMP_DRY_RUN_RATIO;
+  cfg.blockedRatio = PUMP_BLOCKED_RATIO;
+  cfg.relayMinDeltaW = PUMP_RELAY_MIN_DELTA_W;
+  cfg.confirmSamples = PUMP_FAULT_CONFIRM_SAMPLES;
+  return cfg;
+}
+
+// --- Pump Job Queue ---
+
+/**
+ * @brief Inserts a job into the queue, behind all jobs of equal or higher priority.
+ * @param pumpIndex Index of the pump in `pumps[]`.
+ * @param duration_ms How long the pump should run.
+ * @param settle_ms Delay after this job finishes before the next job may start.
+ * @param priority Higher values run first.
+ * @param command The command that requested the run, acknowledged as the job progresses; nullptr if none.
+ * @return The job's id, or 0 if the queue is full.
+ */
+static uint32_t enqueue_pump_job(int pumpIndex, unsigned long duration_ms, unsigned long settle_ms, uint8_t priority,
+                                 const CommandRef* command) {
+  if (jobQueueLength >= PUMP_JOB_QUEUE_CAPACITY) {
+    LOG_WARN("[Queue] WARN: Queue full, rejecting job for %s.\n", pumps[pumpIndex].name);
+    jobsRejected++;
+    actuators_publish_queue_status();
+    return 0;
+  }
+
+  int pos = jobQueueLength;
+  while (pos > 0 && jobQueue[pos - 1].priority < priority) {
+    jobQueue[pos] = jobQueue[pos - 1];
+    pos--;
+  }
+  PumpJob& job = jobQueue[pos];
+  job.id = nextJobId++;
+  job.pumpIndex = pumpIndex;
+  job.durationMs = duration_ms;
+  job.settleMs = settle_ms;
+  job.priority = priority;
+  job.enqueuedAt = millis();
+  job.startedAt = 0;
+  if (command != nullptr) {
+    job.command = *command;
+  } else {
+    job.command.id[0] = '\0';
+  }
+  jobQueueLength++;
+
+  LOG_INFO("[Queue] Job #%u queued: %s %lu ms (prio %u, settle %lu ms), depth %d.\n",
+             job.id, pumps[pumpIndex].name, duration_ms, priority, settle_ms, jobQueueLength);
+  actuators_publish_queue_status();
+  return job.id;
+}
+
+/**
+ * @brief Starts jobs from the head of the queue for as long as `can_start_pump()`
+ * admits them. Jobs start strictly in queue order: a head that has to wait blocks
+ * the jobs behind it. A running job with a settle delay acts as a barrier too,
+ * so sequence steps never overlap their settle window.
+ */
+static void dispatch_pump_jobs() {
+  while (jobQueueLength > 0) {
+    if (queueSettleMs > 0 && millis() - queueSettleStart < queueSettleMs) return;
+    queueSettleMs = 0;
+    for (int i = 0; i < NUM_PUMPS; i++) {
+      if (activeJobs[i].id != 0 && activeJobs[i].settleMs > 0) return;
+    }
+
+    const char* reason = nullptr;
+    if (!can_start_pump(jobQueue[0].pumpIndex, &reason)) {
+      if (jobQueue[0].id != lastRefusedJobId) {
+        lastRefusedJobId = jobQueue[0].id;
+        startsRefused++;
+        LOG_INFO("[Queue] Job #%u waits: %s.\n", jobQueue[0].id, reason);
+        actuators_publish_queue_status();
+      }
+      return;
+    }
+
+    PumpJob job = jobQueue[0];
+    for (int i = 1; i < jobQueueLength; i++) {
+      jobQueue[i - 1] = jobQueue[i];
+    }
+    jobQueueLength--;
+
+    job.startedAt = millis();
+    activeJobs[job.pumpIndex] = job;
+    LOG_INFO("[Queue] Starting job #%u after waiting %lu ms.\n", job.id, job.startedAt - job.enqueuedAt);
+    control_pump_by_duration(pumps[job.pumpIndex], job.durationMs);
+    command_ack_publish(job.command, pumps[job.pumpIndex].key, "started", job.id,
+                        job.startedAt - job.enqueuedAt, -1, nullptr);
+    actuators_publish_queue_status();
+  }
+}
+
+/**
+ * @brief Closes the active job or direct run of a pump (if any), publishes the
+ * job record and acknowledges the command that started the run.
+ * @param pumpIndex Index of the pump whose run just ended.
+ * @param outcome Why the run ended ("done", "stopped", ...).
+ */
+static void finish_pump_job(int pumpIndex, const char* outcome) {
+  unsigned long now = millis();
+  CommandRef& direct = directCommands[pumpIndex];
+  if (direct.id[0] != '\0') {
+    command_ack_publish(direct, pumps[pumpIndex].key, outcome, 0, -1, now - pumps[pumpIndex].onSince, nullptr);
+    direct.id[0] = '\0';
+  }
+
+  PumpJob& job = activeJobs[pumpIndex];
+  if (job.id == 0) return;
+
+  publish_job_record(job, now - job.startedAt, outcome);
+  command_ack_publish(job.command, pumps[pumpIndex].key, outcome, job.id, -1, now - job.startedAt, nullptr);
+  jobsCompleted++;
+  // Jobs overlap, so a job finishing inside another job's settle window may only
+  // extend the barrier; a run without a settle must not cut a pending one short.
+  unsigned long settleLeftMs = queueSettleMs > 0 && now - queueSettleStart < queueSettleMs
+                                   ? queueSettleMs - (now - queueSettleStart) : 0;
+  if (job.settleMs > settleLeftMs) {
+    queueSettleStart = now;
+    queueSettleMs = job.settleMs;
+  }
+  job.id = 0;
+  actuators_publish_queue_status();
+}
+
+/**
+ * @brief Removes waiting jobs from the queue.
+ * @param pumpIndex Only cancel jobs for this pump; -1 matches every pump.
+ * @param jobId Only cancel the job with this id; 0 matches every job.
+ */
+static void cancel_queued_jobs(int pumpIndex, uint32_t jobId) {
+  int kept = 0;
+  int removed = 0;
+  for (int i = 0; i < jobQueueLength; i++) {
+    bool matches = (pumpIndex < 0 || jobQueue[i].pumpIndex == pumpIndex) &&
+                   (jobId == 0 || jobQueue[i].id == jobId);
+    if (matches) {
+      publish_job_record(jobQueue[i], 0, "cancelled");
+      command_ack_publish(jobQueue[i].command, pumps[jobQueue[i].pumpIndex].key, "cancelled", jobQueue[i].id,
+                          millis() - jobQueue[i].enqueuedAt, -1, nullptr);
+      removed++;
+    } else {
+      jobQueue[kept++] = jobQueue[i];
+    }
+  }
+  jobQueueLength = kept;
+  if (removed > 0) {
+    jobsCancelled += removed;
+    LOG_INFO("[Queue] Cancelled %d job(s), depth %d.\n", removed, jobQueueLength);
+    actuators_publish_queue_status();
+  }
+}
+
+/**
+ * @brief Publishes a single job's wait and run times to the job topic.
+ * @param job The job that ended or was cancelled.
+ * @param runMs How long the pump actually ran (0 if it never started).
+ * @param outcome Why the job ended.
+ */
+static void publish_job_record(const PumpJob& job, unsigned long runMs, const char* outcome) {
+  unsigned long waitMs = (job.startedAt != 0 ? job.startedAt : millis()) - job.enqueuedAt;
+  char payload[128];
+  snprintf(payload, sizeof(payload),
+           "{\"id\":%u,\"pump\":\"%s\",\"priority\":%u,\"wait_ms\":%lu,\"run_ms\":%lu,\"outcome\":\"%s\"}",
+           job.id, pumps[job.pumpIndex].key, job.priority, waitMs, runMs, outcome);
+  mqtt_publish_state(STATE_TOPIC_PUMP_JOB, payload, false);
 }
 
 // --- Automation Functions ---
@@ -307,11 +1269,10 @@ static void check_tandon_safety(const SensorValues& currentValues) {
             // di Home Assistant untuk mencegah tandon meluap jika automasi HA gagal.
             const float FIRMWARE_SAFETY_LEVEL_CM = 95.0;
             if (pumps[i].isOn && !isnan(currentValues.waterLevelCm) && currentValues.waterLevelCm >= FIRMWARE_SAFETY_LEVEL_CM) {
-                LOG_PRINTLN("[Actuator] SAFETY OVERRIDE: Tandon level reached high limit. Forcing pump OFF.");
-                digitalWrite(pumps[i].pin, LOW);
-                pumps[i].isOn = false;
+                LOG_ERROR("[Actuator] SAFETY OVERRIDE: Tandon level reached high limit. Forcing pump OFF.\n");
                 pumps[i].stopTime = 0;
-                mqtt_publish_state(pumps[i].stateTopic, PAYLOAD_OFF, true);
+                set_pump_output(pumps[i], false);
+                finish_pump_job(i, "safety_stop");
             }
             return; // Found the pump, no need to continue loop
         }
@@ -319,41 +1280,63 @@ static void check_tandon_safety(const SensorValues& currentValues) {
 }
 
 void actuators_handle_automation_command(const char* topic, const char* command) {
-    LOG_PRINTF("\n[Automation] Command received on topic: %s\n", topic);
-    LOG_PRINTF("  > Payload: %s\n", command);
+    LOG_INFO("\n[Automation] Command received on topic: %s\n  > Payload: %s\n", topic, command);
 
-    std::string topic_str(topic);
     bool enable_state = (strcasecmp(command, "ON") == 0);
 
-    if (topic_str == COMMAND_TOPIC_AUTO_DOSING) {
+    if (COMMAND_TOPIC_AUTO_DOSING == topic) {
         automation_state.auto_dosing_enabled = enable_state;
-        LOG_PRINTF("[Automation] Auto-dosing pH & TDS: %s\n", enable_state ? "ENABLED" : "DISABLED");
-        mqtt_publish_state(STATE_TOPIC_AUTO_DOSING, enable_state ? PAYLOAD_ON : PAYLOAD_OFF, true);
+        LOG_INFO("[Automation] Auto-dosing pH & TDS: %s\n", enable_state ? "ENABLED" : "DISABLED");
+        dirtyStates |= DIRTY_AUTO_DOSING;
         
-    } else if (topic_str == COMMAND_TOPIC_AUTO_REFILL) {
+    } else if (COMMAND_TOPIC_AUTO_REFILL == topic) {
         automation_state.auto_refill_enabled = enable_state;
-        LOG_PRINTF("[Automation] Auto-refill tandon: %s\n", enable_state ? "ENABLED" : "DISABLED");
-        mqtt_publish_state(STATE_TOPIC_AUTO_REFILL, enable_state ? PAYLOAD_ON : PAYLOAD_OFF, true);
+        LOG_INFO("[Automation] Auto-refill tandon: %s\n", enable_state ? "ENABLED" : "DISABLED");
+        dirtyStates |= DIRTY_AUTO_REFILL;
         
-    } else if (topic_str == COMMAND_TOPIC_AUTO_IRRIGATION) {
+    } else if (COMMAND_TOPIC_AUTO_IRRIGATION == topic) {
         automation_state.auto_irrigation_enabled = enable_state;
-        LOG_PRINTF("[Automation] Auto-irrigation: %s\n", enable_state ? "ENABLED" : "DISABLED");
-        mqtt_publish_state(STATE_TOPIC_AUTO_IRRIGATION, enable_state ? PAYLOAD_ON : PAYLOAD_OFF, true);
+        LOG_INFO("[Automation] Auto-irrigation: %s\n", enable_state ? "ENABLED" : "DISABLED");
+        dirtyStates |= DIRTY_AUTO_IRRIGATION;
         
     } else {
-        LOG_PRINTF("[Automation] Unknown automation topic: %s\n", topic);
+        LOG_INFO("[Automation] Unknown automation topic: %s\n", topic);
+        return;
     }
+    // Coalesced, so flicking a switch back and forth costs at most one flash write.
+    storage_mark_dirty(automationHandle);
 }
 
 void actuators_publish_automation_states() {
-    LOG_PRINTLN("[Actuators] Publishing automation states to MQTT...");
-    
-    mqtt_publish_state(STATE_TOPIC_AUTO_DOSING, 
-                      automation_state.auto_dosing_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
-                      
-    mqtt_publish_state(STATE_TOPIC_AUTO_REFILL, 
-                      automation_state.auto_refill_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
-                      
-    mqtt_publish_state(STATE_TOPIC_AUTO_IRRIGATION, 
-                      automation_state.auto_irrigation_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
+    LOG_DEBUG("[Actuators] Publishing automation states to MQTT...\n");
+    dirtyStates |= DIRTY_AUTOMATION;
+    publish_dirty_states();
+}
+
+/**
+ * @brief Publishes every state marked in `dirtyStates` and clears the marks.
+ * While the broker is unreachable the marks are kept; the full sync on
+ * reconnect covers them anyway.
+ */
+static void publish_dirty_states() {
+    if (dirtyStates == 0 || !mqtt_is_connected()) return;
+    for (int i = 0; i < NUM_PUMPS; i++) {
+        if (dirtyStates & (1 << i)) {
+            mqtt_publish_state(pumps[i].stateTopic, pumps[i].isOn ? PAYLOAD_ON : PAYLOAD_OFF, true);
+        }
+    }
+    if (dirtyStates & DIRTY_MODE) {
+        mqtt_publish_state(STATE_TOPIC_SYSTEM_MODE, currentSystemMode == NUTRITION ? "NUTRITION" : "CLEANER", true);
+    }
+    if (dirtyStates & DIRTY_AUTO_DOSING) {
+        mqtt_publish_state(STATE_TOPIC_AUTO_DOSING, automation_state.auto_dosing_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
+    }
+    if (dirtyStates & DIRTY_AUTO_REFILL) {
+        mqtt_publish_state(STATE_TOPIC_AUTO_REFILL, automation_state.auto_refill_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
+    }
+    if (dirtyStates & DIRTY_AUTO_IRRIGATION) {
+        mqtt_publish_state(STATE_TOPIC_AUTO_IRRIGATION,
+                           automation_state.auto_irrigation_enabled ? PAYLOAD_ON : PAYLOAD_OFF, true);
+    }
+    dirtyStates = 0;
 }
@@ -24,17 +24,32 @@ struct AutomationState {
 /// @brief Global instance of automation state, accessible throughout the system
 extern AutomationState automation_state;
 
-// (Optional) Future: expose a getter for current system mode if needed by other modules
-// enum SystemMode { NUTRITION, CLEANER };
-// SystemMode get_current_mode();
+/**
+ * @struct PumpStatus
+ * @brief A read-only view of one pump, for reporting.
+ */
+struct PumpStatus {
+    const char* key;    ///< The pump's short identifier, e.g. "nutrisi_a".
+    bool isOn;          ///< Whether the relay is energized.
+    bool dosing;        ///< Whether this is a dosing pump, the only kind that counts `dispensedMl`.
+    float dispensedMl;  ///< Total volume dispensed by the pump; only dosing pumps count it.
+};
 
 /**
  * @brief Initializes all actuator pins.
  * Sets the GPIO pins for all pumps and the buzzer to OUTPUT mode and ensures
- * they are in a default OFF state. This should be called once in `setup()`.
+ * they are in a default OFF state, then restores the dosing pumps' flow models
+ * and dispensed volumes. This should be called once in `setup()`, after `storage_init()`.
  */
 void actuators_init();
 
+/**
+ * @brief Returns the GPIOs of every pump relay and the buzzer, for an emergency stop
+ * that cannot go through this module (bit n set for GPIO n).
+ * @return The pin mask.
+ */
+uint64_t actuators_output_pin_mask();
+
 /**
  * @brief Main loop for the actuator module.
  * This function must be called repeatedly in the main `loop()`.
@@ -48,12 +63,84 @@ void actuators_loop(const SensorValues& currentValues);
  * @brief Handles incoming MQTT commands for all pumps.
  * Parses the topic and payload to determine which pump to control and how.
  * Supports volume-based control (ml) for dosing pumps and duration-based
- * control (s) for the watering pump. Also handles the "OFF" command.
+ * control (s) for the watering pump. Timed runs are added to the pump job
+ * queue instead of being rejected while another pump runs. The Tandon "ON"
+ * command is refused while it conflicts with a running pump's exclusion group
+ * or the power budget. Also handles the
+ * "OFF" command, which stops the pump and drops its waiting jobs.
+ * The payload is either the bare value or a JSON object with a correlation ID,
+ * e.g. `{"id":"dose-1","value":50,"ts":1760000000123}`; such commands are
+ * acknowledged on the ack topic as they are queued, started and finished, and
+ * a repeated ID is not executed twice (see command_ack.h).
  * @param topic The MQTT topic the command was received on.
  * @param command The payload of the MQTT command.
  */
 void actuators_handle_pump_command(const char* topic, const char* command);
 
+/**
+ * @brief Handles incoming MQTT commands for the pump job queue.
+ * Accepts a whole dosing sequence in one message, e.g.
+ * `prio:1,nutrisi_a:50:60,nutrisi_b:50:60,ph:5`, where each step is
+ * `<pump>:<amount>[:<settle seconds>]` and the optional `prio:<n>` applies to
+ * every step. Amounts use the same units as the per-pump topics. The payload
+ * `CANCEL` drops all waiting jobs and `CANCEL <id>` drops a single one.
+ * @param command The payload of the queue command.
+ */
+void actuators_handle_queue_command(const char* command);
+
+/**
+ * @brief Publishes the pump job queue status: depth, running pumps, job counters,
+ * refused starts, throughput (total run time vs. busy time) and peak power.
+ */
+void actuators_publish_queue_status();
+
+/**
+ * @brief Feeds a fresh PZEM reading to the pump scheduler and run monitor.
+ * Call this after every sensor read and, while `actuators_power_monitor_active()`
+ * is true, at the high monitoring rate. Each running pump's share of the reading
+ * is compared with its learned draw; a run whose signature shows dry running, a
+ * blockage or a failed relay is stopped and an alert is published. Clean runs
+ * refine the learned draw used by the power budget, and each run's energy is
+ * published when it ends.
+ * @param values The SensorValues struct containing the latest PZEM readings.
+ */
+void actuators_handle_power_sample(const SensorValues& values);
+
+/**
+ * @brief Checks whether the power meter should be sampled at the high monitoring rate.
+ * @return true while any pump relay is energized, and briefly after the last one
+ *         is released so a relay stuck ON can be detected.
+ */
+bool actuators_power_monitor_active();
+
+/**
+ * @brief Checks whether a timed pump run is due to stop within a time span.
+ * Open-ended runs, such as the tandon's "ON", have no stop time and do not count.
+ * @param spanMs The time span in milliseconds.
+ * @return true if a timed run ends within `spanMs` (or is already overdue).
+ */
+bool actuators_timed_run_ends_within(unsigned long spanMs);
+
+/**
+ * @brief Publishes the power budget and each pump's learned power/current draw.
+ */
+void actuators_publish_power_profile();
+
+/**
+ * @brief Handles incoming MQTT commands for dosing pump calibration.
+ * `<pump>:run:<ms>` runs a dosing pump for an exact time. After measuring the
+ * output, `<pump>:ml:<volume>` fits the pump's flow model (rate and, with two
+ * runs of different length, startup dead time). `<pump>:reset` restores the
+ * default rate. Models are saved to NVS.
+ * @param command The payload of the calibration command.
+ */
+void actuators_handle_calibration_command(const char* command);
+
+/**
+ * @brief Publishes each dosing pump's flow model and cumulative dispensed volume.
+ */
+void actuators_publish_flow_models();
+
 /**
  * @brief Handles incoming MQTT commands for changing the system mode (e.g., NUTRITION, CLEANER).
  * @param command The payload of the mode command.
@@ -87,4 +174,36 @@ void actuators_update_alert_status(const SensorValues& values);
  */
 void actuators_publish_states();
 
+/**
+ * @brief Publishes all pump, mode and automation states as one retained JSON
+ * object on the actuator snapshot topic, e.g.
+ * `{"pumps":{"nutrisi_a":false,...},"mode":"NUTRITION","automation":{"dosing":true,...},"queue":0}`.
+ * The individual state topics are only published when a state changes, so this
+ * periodic snapshot lets a consumer that missed a change resynchronize.
+ */
+void actuators_publish_snapshot();
+
+/**
+ * @brief Reads the state of one pump.
+ * @param index The pump's index, from 0.
+ * @param status Receives the state.
+ * @return false if there is no pump with that index.
+ */
+bool actuators_get_pump_status(int index, PumpStatus& status);
+
+/**
+ * @brief Returns the current system mode, "NUTRITION" or "CLEANER".
+ */
+const char* actuators_mode_name();
+
+/**
+ * @brief Returns the number of jobs waiting in the pump queue.
+ */
+int actuators_queue_length();
+
+/**
+ * @brief Returns whether the water level alert sounds the buzzer.
+ */
+bool actuators_alert_active();
+
 #endif // ACTUATORS_H
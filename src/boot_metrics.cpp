@@ -0,0 +1,93 @@
+/**
+ * @file boot_metrics.cpp
+ * @brief Implements the boot metrics module.
+ */
+
+#include "boot_metrics.h"
+#include "config.h"
+#include "mqtt_handler.h"
+#include "identity.h"
+#include <esp_system.h>
+
+// --- Module-Private (Static) Variables ---
+
+/// @brief JSON keys for the milestones, indexed by `BootPhase`.
+static const char* const PHASE_NAMES[BOOT_NUM_PHASES] = {
+  "actuators_safe_ms", "sensors_ready_ms", "setup_ms", "first_reading_ms",
+  "wifi_ms", "mqtt_ms", "first_publish_ms"
+};
+
+/// @brief millis() when each milestone was reached; 0 until then.
+static unsigned long phaseTimes[BOOT_NUM_PHASES];
+/// @brief millis() when `setup()` began, i.e. the time spent in the bootloader and core startup.
+static unsigned long setupStartTime = 0;
+static esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void publish_boot_metrics();
+static const char* reset_reason_name(esp_reset_reason_t reason);
+
+// --- Public Function Implementations ---
+
+void boot_metrics_begin() {
+  setupStartTime = millis();
+  resetReason = esp_reset_reason();
+  LOG_INFO("[Boot] Reset reason: %s.\n", reset_reason_name(resetReason));
+}
+
+void boot_metrics_mark(BootPhase phase) {
+  if (phaseTimes[phase] != 0) return;
+  // 0 means "not reached", so a milestone at millis() == 0 is stored as 1.
+  phaseTimes[phase] = max(millis(), 1UL);
+  if (phase == BOOT_FIRST_PUBLISH) publish_boot_metrics();
+}
+
+const char* boot_metrics_reset_reason() {
+  return reset_reason_name(resetReason);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Logs the milestones and publishes them, retained, on the boot topic.
+ */
+static void publish_boot_metrics() {
+  char payload[320];
+  int length = snprintf(payload, sizeof(payload),
+                        "{\"reset_reason\":\"%s\",\"identity\":\"%s\",\"setup_start_ms\":%lu",
+                        reset_reason_name(resetReason), identity_source(), setupStartTime);
+  for (int i = 0; i < BOOT_NUM_PHASES && length < (int)sizeof(payload); i++) {
+    // Milestones that were skipped (e.g. no valid reading yet) are reported as null.
+    if (phaseTimes[i] != 0) {
+      length += snprintf(payload + length, sizeof(payload) - length, ",\"%s\":%lu", PHASE_NAMES[i], phaseTimes[i]);
+    } else {
+      length += snprintf(payload + length, sizeof(payload) - length, ",\"%s\":null", PHASE_NAMES[i]);
+    }
+  }
+  if (length < (int)sizeof(payload)) snprintf(payload + length, sizeof(payload) - length, "}");
+
+  LOG_INFO("[Boot] First reading after %lu ms, first publish after %lu ms.\n",
+           phaseTimes[BOOT_FIRST_VALID_READING], phaseTimes[BOOT_FIRST_PUBLISH]);
+  mqtt_publish_state(STATE_TOPIC_BOOT, payload, true);
+}
+
+/**
+ * @brief Returns a short name for a reset reason.
+ * @param reason The reason reported by the IDF.
+ * @return The name, e.g. "POWERON" or "BROWNOUT".
+ */
+static const char* reset_reason_name(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON:   return "POWERON";
+    case ESP_RST_EXT:       return "EXTERNAL";
+    case ESP_RST_SW:        return "SOFTWARE";
+    case ESP_RST_PANIC:     return "PANIC";
+    case ESP_RST_INT_WDT:   return "INT_WDT";
+    case ESP_RST_TASK_WDT:  return "TASK_WDT";
+    case ESP_RST_WDT:       return "WDT";
+    case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+    case ESP_RST_BROWNOUT:  return "BROWNOUT";
+    case ESP_RST_SDIO:      return "SDIO";
+    default:                return "UNKNOWN";
+  }
+}
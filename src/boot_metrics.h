@@ -0,0 +1,47 @@
+/**
+ * @file boot_metrics.h
+ * @brief Public interface for the boot metrics module.
+ *
+ * Records why the chip reset and when each boot milestone was reached,
+ * measured with `millis()` from the start of the application. The metrics are
+ * published once, retained, right after the first sensor publish. The most
+ * telling ones are the time to the first valid reading (control and overflow
+ * protection are live from then on) and the time to the first publish.
+ */
+#ifndef BOOT_METRICS_H
+#define BOOT_METRICS_H
+
+/**
+ * @enum BootPhase
+ * @brief The boot milestones, in the order they are normally reached.
+ */
+enum BootPhase {
+  BOOT_ACTUATORS_SAFE,      ///< All relay and buzzer outputs are driven to their safe state.
+  BOOT_SENSORS_READY,       ///< The sensor libraries are initialized.
+  BOOT_SETUP_DONE,          ///< `setup()` returned; the main loop starts.
+  BOOT_FIRST_VALID_READING, ///< The first sensor cycle with a valid water level.
+  BOOT_WIFI_CONNECTED,      ///< The station got an IP address.
+  BOOT_MQTT_CONNECTED,      ///< The broker accepted the connection.
+  BOOT_FIRST_PUBLISH,       ///< Sensor data reached the broker for the first time.
+  BOOT_NUM_PHASES
+};
+
+/**
+ * @brief Records the reset reason and the time `setup()` began. Call first thing in `setup()`.
+ */
+void boot_metrics_begin();
+
+/**
+ * @brief Records when a milestone was reached. Only the first call per phase counts.
+ * Reaching BOOT_FIRST_PUBLISH logs and publishes the metrics.
+ * @param phase The milestone.
+ */
+void boot_metrics_mark(BootPhase phase);
+
+/**
+ * @brief Returns why the chip last reset.
+ * @return A short name such as "POWERON", "TASK_WDT" or "BROWNOUT".
+ */
+const char* boot_metrics_reset_reason();
+
+#endif // BOOT_METRICS_H
@@ -0,0 +1,177 @@
+/**
+ * @file command_ack.cpp
+ * @brief Implements command correlation and acknowledgements.
+ */
+
+#include "command_ack.h"
+#include "mqtt_handler.h"
+#include <sys/time.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/// @brief Times before this (2021-01-01) mean SNTP has not set the clock yet.
+static const time_t CLOCK_VALID_AFTER_S = 1609459200;
+
+/**
+ * @struct AckHistoryEntry
+ * @brief The last acknowledgement sent for a recent command ID.
+ */
+struct AckHistoryEntry {
+  char id[COMMAND_ID_MAX_LENGTH + 1]; ///< Empty for an unused slot.
+  const char* pumpKey;                ///< Points to a pump's static key.
+  const char* outcome;                ///< Points to a string literal.
+  uint32_t jobId;
+};
+
+/// @brief Recent command IDs, overwritten round-robin.
+static AckHistoryEntry history[COMMAND_ACK_HISTORY_SIZE];
+static int nextHistorySlot = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool json_field(const char* json, const char* key, char* out, size_t outSize);
+static AckHistoryEntry* find_history(const char* id);
+static void publish_ack(const CommandRef& ref, const char* pumpKey, const char* outcome, uint32_t jobId,
+                        long waitMs, long runMs, const char* reason, bool duplicate);
+
+// --- Public Function Implementations ---
+
+void command_ack_init() {
+  // UTC only; acks carry Unix time and nothing on the device shows local time.
+  configTime(0, 0, NTP_SERVER);
+}
+
+uint64_t command_ack_clock_ms() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  if (now.tv_sec < CLOCK_VALID_AFTER_S) return 0;
+  return (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+bool command_ack_parse(const char* payload, CommandRef& ref, char* value, size_t valueSize) {
+  ref.id[0] = '\0';
+  ref.sentMs = 0;
+  while (*payload == ' ') payload++;
+  if (*payload != '{') {
+    strncpy(value, payload, valueSize - 1);
+    value[valueSize - 1] = '\0';
+    return true;
+  }
+
+  char ts[24];
+  json_field(payload, "id", ref.id, sizeof(ref.id));
+  if (json_field(payload, "ts", ts, sizeof(ts))) ref.sentMs = strtoull(ts, nullptr, 10);
+  return json_field(payload, "value", value, valueSize);
+}
+
+bool command_ack_is_duplicate(const CommandRef& ref) {
+  if (ref.id[0] == '\0') return false;
+  AckHistoryEntry* entry = find_history(ref.id);
+  if (entry == nullptr) return false;
+  LOG_INFO("[Command] Duplicate command '%s' ignored, last outcome '%s'.\n", ref.id, entry->outcome);
+  publish_ack(ref, entry->pumpKey, entry->outcome, entry->jobId, -1, -1, nullptr, true);
+  return true;
+}
+
+void command_ack_publish(const CommandRef& ref, const char* pumpKey, const char* outcome, uint32_t jobId,
+                         long waitMs, long runMs, const char* reason) {
+  if (ref.id[0] == '\0') return;
+  AckHistoryEntry* entry = find_history(ref.id);
+  if (entry == nullptr) {
+    entry = &history[nextHistorySlot];
+    nextHistorySlot = (nextHistorySlot + 1) % COMMAND_ACK_HISTORY_SIZE;
+    strcpy(entry->id, ref.id);
+    entry->jobId = 0;
+  }
+  entry->pumpKey = pumpKey;
+  entry->outcome = outcome;
+  if (jobId != 0) entry->jobId = jobId;
+  publish_ack(ref, pumpKey, outcome, jobId, waitMs, runMs, reason, false);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Extracts the value of a top-level field from a flat JSON object.
+ * Strings are returned without quotes (escapes are not supported), numbers and
+ * literals as written.
+ * @param json The JSON text.
+ * @param key The field name.
+ * @param out Receives the value.
+ * @param outSize The size of `out` in bytes.
+ * @return true if the field was found.
+ */
+static bool json_field(const char* json, const char* key, char* out, size_t outSize) {
+  size_t keyLength = strlen(key);
+  for (const char* p = strchr(json, '"'); p != nullptr; p = strchr(p + 1, '"')) {
+    if (strncmp(p + 1, key, keyLength) != 0 || p[keyLength + 1] != '"') continue;
+    const char* v = p + keyLength + 2;
+    while (*v == ' ') v++;
+    if (*v != ':') continue;
+    v++;
+    while (*v == ' ') v++;
+
+    const char* end;
+    if (*v == '"') {
+      end = strchr(++v, '"');
+      if (end == nullptr) return false;
+    } else {
+      end = v + strcspn(v, ",} ");
+    }
+    size_t length = min((size_t)(end - v), outSize - 1);
+    memcpy(out, v, length);
+    out[length] = '\0';
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Looks up a command ID in the history of recent acknowledgements.
+ * @param id The correlation ID.
+ * @return The entry, or nullptr if the ID was not seen recently.
+ */
+static AckHistoryEntry* find_history(const char* id) {
+  for (int i = 0; i < COMMAND_ACK_HISTORY_SIZE; i++) {
+    if (history[i].id[0] != '\0' && strcmp(history[i].id, id) == 0) return &history[i];
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Formats and publishes one acknowledgement.
+ * `latency_ms` is the time from the sender's time stamp to this event, so for
+ * "queued" it is the delivery latency and for "started" the command-to-relay latency.
+ */
+static void publish_ack(const CommandRef& ref, const char* pumpKey, const char* outcome, uint32_t jobId,
+                        long waitMs, long runMs, const char* reason, bool duplicate) {
+  uint64_t nowMs = command_ack_clock_ms();
+  char payload[256];
+  size_t len = snprintf(payload, sizeof(payload), "{\"id\":\"%s\",\"pump\":\"%s\",\"outcome\":\"%s\"",
+                        ref.id, pumpKey, outcome);
+  if (jobId != 0 && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"job\":%u", jobId);
+  }
+  if (nowMs != 0 && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"at_ms\":%llu", (unsigned long long)nowMs);
+    if (ref.sentMs != 0 && len < sizeof(payload)) {
+      // Signed: the sender's clock may run ahead of ours.
+      len += snprintf(payload + len, sizeof(payload) - len, ",\"latency_ms\":%lld",
+                      (long long)(nowMs - ref.sentMs));
+    }
+  }
+  if (waitMs >= 0 && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"wait_ms\":%ld", waitMs);
+  }
+  if (runMs >= 0 && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"run_ms\":%ld", runMs);
+  }
+  if (reason != nullptr && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"reason\":\"%s\"", reason);
+  }
+  if (duplicate && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"duplicate\":true");
+  }
+  if (len < sizeof(payload)) snprintf(payload + len, sizeof(payload) - len, "}");
+
+  mqtt_publish_state(STATE_TOPIC_PUMP_ACK, payload, false);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file command_ack.h
+ * @brief Public interface for command correlation and acknowledgements.
+ *
+ * A pump command is either a bare value ("50", "ON", "OFF") or a JSON object
+ * carrying a correlation ID and the sender's wall-clock time:
+ * `{"id":"dose-0412","value":50,"ts":1760000000123}`. Commands with an ID are
+ * acknowledged on the ack topic at every step of their life (queued, started,
+ * done, rejected, ...), so a sender can tell which run its command caused and
+ * how long delivery took. A repeated ID is not executed again; its last
+ * acknowledgement is replayed instead, which makes retries idempotent.
+ *
+ * Time stamps are Unix milliseconds from SNTP. Until the clock is set, acks
+ * carry only the durations measured with `millis()`.
+ */
+#ifndef COMMAND_ACK_H
+#define COMMAND_ACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * @struct CommandRef
+ * @brief The correlation fields of a received command, kept with the run it caused.
+ */
+struct CommandRef {
+  char id[COMMAND_ID_MAX_LENGTH + 1]; ///< The sender's correlation ID. Empty for bare commands.
+  uint64_t sentMs;                    ///< The sender's time stamp (Unix ms), 0 if none was given.
+};
+
+/**
+ * @brief Starts SNTP time synchronization. Call once after WiFi has been started.
+ */
+void command_ack_init();
+
+/**
+ * @brief Returns the wall-clock time.
+ * @return Unix time in milliseconds, or 0 while the clock has not been set by SNTP.
+ */
+uint64_t command_ack_clock_ms();
+
+/**
+ * @brief Splits a command payload into its value and correlation fields.
+ * A bare payload is the value itself and leaves `ref` empty.
+ * @param payload The received payload.
+ * @param ref Receives the correlation ID and sender time stamp.
+ * @param value Receives the command value (e.g. "50" or "ON").
+ * @param valueSize The size of `value` in bytes.
+ * @return false if a JSON payload has no "value" field.
+ */
+bool command_ack_parse(const char* payload, CommandRef& ref, char* value, size_t valueSize);
+
+/**
+ * @brief Checks whether a command with this ID was handled recently. If so, its
+ * last acknowledgement is published again, marked as a duplicate.
+ * @param ref The command's correlation fields.
+ * @return true if the command must not be executed again.
+ */
+bool command_ack_is_duplicate(const CommandRef& ref);
+
+/**
+ * @brief Publishes an acknowledgement for a command and remembers its outcome.
+ * Does nothing for commands without an ID.
+ * @param ref The command's correlation fields.
+ * @param pumpKey The pump the command addressed (e.g. "nutrisi_a").
+ * @param outcome What happened: "queued", "started", "done", "stopped", "rejected", ...
+ * @param jobId The pump job created for the command, 0 if none.
+ * @param waitMs Time spent in the job queue, or -1 to omit.
+ * @param runMs How long the pump ran, or -1 to omit.
+ * @param reason Why a command was rejected, or nullptr.
+ */
+void command_ack_publish(const CommandRef& ref, const char* pumpKey, const char* outcome, uint32_t jobId,
+                         long waitMs, long runMs, const char* reason);
+
+#endif // COMMAND_ACK_H
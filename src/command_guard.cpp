@@ -0,0 +1,216 @@
+/**
+ * @file command_guard.cpp
+ * @brief Implements the command guard.
+ *
+ * The rate limit is a token bucket per topic, kept as "debt": every admitted
+ * command adds `COMMAND_RATE_REFILL_MS` of debt, which is paid off in real
+ * time. A command that would push the debt past `COMMAND_RATE_BURST` refills is
+ * dropped, so a topic allows a burst of that many commands and then one per
+ * refill period. An idle topic has no debt, i.e. a full bucket. A pump's "OFF"
+ * neither needs nor takes a token: stopping a pump is always allowed.
+ */
+
+#include "command_guard.h"
+#include "config.h"
+#include "command_ack.h" // For the "ts" field and the wall clock
+#include "mqtt_handler.h"
+#include <strings.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/// @brief What a command topic controls, which decides how its commands are screened.
+enum GuardKind {
+  GUARD_PUMP,    ///< Runs pumps or a calibration; a replayed retained command would run it again.
+  GUARD_SETTING  ///< Sets a mode or switch; repeating the same value changes nothing.
+};
+
+/**
+ * @struct GuardedTopic
+ * @brief The screening state of one command topic.
+ */
+struct GuardedTopic {
+  const MqttTopic& topic;     ///< Refers to the global in config.cpp.
+  const GuardKind kind;
+  const bool stoppable;       ///< Whether "OFF" stops a pump here, which is never rate limited.
+  unsigned long debtMs;       ///< Outstanding token bucket debt; 0 means the bucket is full.
+  unsigned long lastCommandTime;
+  bool limited;               ///< Whether the last command was rate limited, to warn once per flood.
+};
+
+static GuardedTopic guardedTopics[] = {
+    {COMMAND_TOPIC_PUMP_A, GUARD_PUMP, true, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_B, GUARD_PUMP, true, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_PH, GUARD_PUMP, true, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_SIRAM, GUARD_PUMP, true, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_TANDON, GUARD_PUMP, true, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_QUEUE, GUARD_PUMP, false, 0, 0, false},
+    {COMMAND_TOPIC_PUMP_CALIBRATION, GUARD_PUMP, false, 0, 0, false},
+    {COMMAND_TOPIC_PROBE_CALIBRATION, GUARD_PUMP, false, 0, 0, false},
+    {COMMAND_TOPIC_SYSTEM_MODE, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_LOG, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_HISTORY, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_OTA, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_TRACE, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_AUTO_DOSING, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_AUTO_REFILL, GUARD_SETTING, false, 0, 0, false},
+    {COMMAND_TOPIC_AUTO_IRRIGATION, GUARD_SETTING, false, 0, 0, false}};
+
+static const int NUM_GUARDED_TOPICS = sizeof(guardedTopics) / sizeof(guardedTopics[0]);
+
+/// @brief The last admitted command, for coalescing repeats of it.
+static int lastTopicIndex = -1;
+static char lastPayload[16];
+static unsigned long lastAdmittedTime = 0;
+
+/// @brief Lifetime counters for the status topic.
+static uint32_t commandsAdmitted = 0;
+static uint32_t commandsStale = 0;
+static uint32_t commandsCoalesced = 0;
+static uint32_t commandsRateLimited = 0;
+/// @brief The number of dropped commands at the last status publish.
+static uint32_t publishedDrops = 0;
+static unsigned long lastStatusPublishTime = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static const char* stale_reason(const GuardedTopic& guarded, const char* payload, bool replayed);
+static bool is_repeat(int index, const GuardedTopic& guarded, const char* payload, unsigned long now);
+static bool is_stop(const GuardedTopic& guarded, const char* payload);
+static bool take_token(GuardedTopic& guarded, unsigned long now);
+
+// --- Public Function Implementations ---
+
+bool command_guard_admit(const char* topic, const char* payload, bool replayed) {
+  int index = -1;
+  for (int i = 0; i < NUM_GUARDED_TOPICS; i++) {
+    if (guardedTopics[i].topic == topic) index = i;
+  }
+  // Unknown topics are left to the router, which reports them.
+  if (index < 0) return true;
+  GuardedTopic& guarded = guardedTopics[index];
+  unsigned long now = millis();
+
+  const char* reason = stale_reason(guarded, payload, replayed);
+  if (reason != nullptr) {
+    commandsStale++;
+    LOG_INFO("[Command] Ignoring stale command on %s (%s).\n", topic, reason);
+    return false;
+  }
+  if (is_repeat(index, guarded, payload, now)) {
+    commandsCoalesced++;
+    LOG_DEBUG("[Command] Coalesced repeated '%s' on %s.\n", payload, topic);
+    return false;
+  }
+  // A flood of ON/OFF pairs must not leave a pump running because its last OFF was dropped.
+  if (!is_stop(guarded, payload) && !take_token(guarded, now)) {
+    commandsRateLimited++;
+    if (!guarded.limited) {
+      LOG_WARN("[Command] WARN: Too many commands on %s, dropping until the rate falls.\n", topic);
+    }
+    guarded.limited = true;
+    return false;
+  }
+
+  guarded.limited = false;
+  commandsAdmitted++;
+  lastTopicIndex = index;
+  lastAdmittedTime = now;
+  if (strlen(payload) < sizeof(lastPayload)) {
+    strcpy(lastPayload, payload);
+  } else {
+    lastPayload[0] = '\0'; // Too long to be a repeatable setting.
+  }
+  return true;
+}
+
+void command_guard_loop() {
+  uint32_t drops = commandsStale + commandsCoalesced + commandsRateLimited;
+  if (drops != publishedDrops && millis() - lastStatusPublishTime >= COMMAND_GUARD_STATUS_INTERVAL_MS &&
+      mqtt_is_connected()) {
+    command_guard_publish_status();
+  }
+}
+
+void command_guard_publish_status() {
+  publishedDrops = commandsStale + commandsCoalesced + commandsRateLimited;
+  lastStatusPublishTime = millis();
+  char payload[128];
+  snprintf(payload, sizeof(payload), "{\"admitted\":%u,\"stale\":%u,\"coalesced\":%u,\"rate_limited\":%u}",
+           commandsAdmitted, commandsStale, commandsCoalesced, commandsRateLimited);
+  mqtt_publish_state(STATE_TOPIC_COMMAND_GUARD, payload, true);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Checks whether a command is a leftover rather than a current request.
+ * @param guarded The topic the command arrived on.
+ * @param payload The command payload.
+ * @param replayed Whether the broker replayed the command (see command_guard_admit()).
+ * @return Why the command is stale, or nullptr if it is current.
+ */
+static const char* stale_reason(const GuardedTopic& guarded, const char* payload, bool replayed) {
+  // An empty retained message is how a retained command is cleared; it is not a command.
+  if (payload[0] == '\0') return "empty";
+
+  CommandRef ref;
+  char value[8];
+  command_ack_parse(payload, ref, value, sizeof(value));
+  if (ref.sentMs != 0) {
+    uint64_t nowMs = command_ack_clock_ms();
+    if (nowMs != 0 && nowMs > ref.sentMs + COMMAND_MAX_AGE_MS) return "too old";
+    return nullptr;
+  }
+
+  // A bare pump command cannot say when it was sent, so one the broker
+  // replayed may be any age and is not trusted.
+  if (guarded.kind == GUARD_PUMP && replayed) return "replayed by the broker";
+  return nullptr;
+}
+
+/**
+ * @brief Checks whether a command repeats the last admitted one without effect.
+ * Only settings, and a pump's ON and OFF, are idempotent; a repeated dose is a
+ * second dose. Structured commands are left to the correlation ID check.
+ * @param index The topic's index in `guardedTopics`.
+ * @param guarded The topic the command arrived on.
+ * @param payload The command payload.
+ * @param now The current `millis()`.
+ * @return true if the command can be dropped.
+ */
+static bool is_repeat(int index, const GuardedTopic& guarded, const char* payload, unsigned long now) {
+  // Anything admitted in between (e.g. a queued run of the same pump) could have changed the state.
+  if (index != lastTopicIndex || now - lastAdmittedTime >= COMMAND_COALESCE_WINDOW_MS) return false;
+  if (payload[0] == '{' || strcmp(payload, lastPayload) != 0) return false;
+  return guarded.kind == GUARD_SETTING || strcasecmp(payload, "ON") == 0 || strcasecmp(payload, "OFF") == 0;
+}
+
+/**
+ * @brief Checks whether a command stops a pump, bare ("OFF") or structured
+ * (`{"value":"OFF",...}`).
+ * @param guarded The topic the command arrived on.
+ * @param payload The command payload.
+ * @return true if the command is a stop.
+ */
+static bool is_stop(const GuardedTopic& guarded, const char* payload) {
+  if (!guarded.stoppable) return false;
+  CommandRef ref;
+  char value[8];
+  return command_ack_parse(payload, ref, value, sizeof(value)) && strcasecmp(value, "OFF") == 0;
+}
+
+/**
+ * @brief Takes a token from a topic's bucket.
+ * @param guarded The topic the command arrived on.
+ * @param now The current `millis()`.
+ * @return false if the bucket is empty.
+ */
+static bool take_token(GuardedTopic& guarded, unsigned long now) {
+  unsigned long paid = now - guarded.lastCommandTime;
+  guarded.debtMs = paid >= guarded.debtMs ? 0 : guarded.debtMs - paid;
+  guarded.lastCommandTime = now;
+  if (guarded.debtMs + COMMAND_RATE_REFILL_MS > (unsigned long)(COMMAND_RATE_BURST * COMMAND_RATE_REFILL_MS)) {
+    return false;
+  }
+  guarded.debtMs += COMMAND_RATE_REFILL_MS;
+  return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file command_guard.h
+ * @brief Public interface for the command guard, which screens every received
+ * MQTT command before it is executed.
+ *
+ * Three kinds of commands are dropped:
+ * - stale ones: a bare pump or calibration command the broker replayed rather
+ *   than forwarded (a retained one, or one it kept through an outage longer
+ *   than `COMMAND_MAX_AGE_MS`), an empty payload (how a retained command is
+ *   cleared), or a structured command whose "ts" is older than `COMMAND_MAX_AGE_MS`;
+ * - redundant ones: the same setting sent again on the same topic while
+ *   nothing else ran in between (repeated OFF, repeated mode);
+ * - excess ones: each command topic has a token bucket, so a misbehaving
+ *   automation cannot starve the control loop or flood the log. A pump's "OFF"
+ *   is exempt, so a stop is never dropped.
+ *
+ * The counters are published on the command status topic.
+ */
+#ifndef COMMAND_GUARD_H
+#define COMMAND_GUARD_H
+
+/**
+ * @brief Decides whether a received command may run and counts the ones that may not.
+ * @param topic The topic the command was received on.
+ * @param payload The command payload.
+ * @param replayed Whether the broker replayed the command rather than forwarding
+ * it as it was published: it carried the RETAIN flag, or the broker had queued it
+ * through a long outage (see mqtt_handler.cpp).
+ * @return true to execute the command, false to drop it.
+ */
+bool command_guard_admit(const char* topic, const char* payload, bool replayed);
+
+/**
+ * @brief Publishes the counters when commands were dropped since the last
+ * publish, at most every `COMMAND_GUARD_STATUS_INTERVAL_MS`. Call from the MQTT loop.
+ */
+void command_guard_loop();
+
+/**
+ * @brief Publishes the admitted, stale, coalesced and rate-limited command counts.
+ */
+void command_guard_publish_status();
+
+#endif // COMMAND_GUARD_H
@@ -11,12 +11,21 @@
 // =======================================================================
 // These values are injected by platformio.ini via build_flags from the
 // credentials.ini file. This keeps sensitive data out of the source code.
+// They are the defaults for values not provisioned in NVS (see identity.h).
 const char *WIFI_SSID = ENV_WIFI_SSID;
 const char *WIFI_PASSWORD = ENV_WIFI_PASSWORD;
 const char *MQTT_USERNAME = ENV_MQTT_USER;
 const char *MQTT_PASSWORD = ENV_MQTT_PASS;
 const char *MQTT_SERVER = ENV_MQTT_SERVER;
-const int MQTT_PORT = ENV_MQTT_PORT;
+int MQTT_PORT = ENV_MQTT_PORT;
+// To connect over TLS (usually port 8883), paste the broker's CA certificate here, e.g.
+//   const char *MQTT_TLS_CA_CERT = R"PEM(-----BEGIN CERTIFICATE-----
+//   ...
+//   -----END CERTIFICATE-----
+//   )PEM";
+// and/or pin the broker's public key (also provisionable as "mqtt_pin", see identity.h).
+const char *MQTT_TLS_CA_CERT = nullptr;
+const char *MQTT_TLS_PUBKEY_SHA256 = "";
 
 
 // =======================================================================
@@ -24,37 +33,79 @@ const int MQTT_PORT = ENV_MQTT_PORT;
 // =======================================================================
 
 // --- MQTT Identity ---
-const char *MQTT_CLIENT_ID = "esp32-hydroponic-" STR(HYDROPONIC_INSTANCE_ID);
-const char *BASE_TOPIC = "hidroponik/" STR(HYDROPONIC_INSTANCE_ID);
+// Both are set by config_resolve_topics() at boot.
+static const char *CLIENT_ID_PREFIX = "esp32-hydroponic-";
+static const char *BASE_TOPIC_PREFIX = "hidroponik/";
+const char *MQTT_CLIENT_ID = "";
+const char *BASE_TOPIC = "";
+#ifdef HYDROPONIC_INSTANCE_ID
+const char *DEFAULT_INSTANCE_ID = STR(HYDROPONIC_INSTANCE_ID);
+#else
+const char *DEFAULT_INSTANCE_ID = nullptr;  // Fleet build: derived from the MAC address.
+#endif
+const char *IDENTITY_NAMESPACE = "identity";
 
 // --- Hardware & System Parameters ---
-const int TANDON_MAX_HEIGHT_CM = 100;
+int TANDON_MAX_HEIGHT_CM = 100;
 const int ULTRASONIC_MAX_DISTANCE_CM = 400;
 const int DHT_TYPE = DHT22;
-const float WATER_LEVEL_CRITICAL_CM = 20.0;
+float WATER_LEVEL_CRITICAL_CM = 20.0;
 
 // --- Sensor Calibration ---
-const float TDS_K_VALUE = 635.40;
+float TDS_K_VALUE = 635.40;
 const float TDS_TEMP_COEFF = 0.02;
 
 // ===================================================================
 // == PENTING: KALIBRASI SENSOR pH WAJIB DILAKUKAN ==
 // ===================================================================
-// Nilai di bawah ini diambil dari skrip kalibrasi 4-titik Anda
-// di `calibration/src/main.cpp` untuk akurasi maksimal.
-const float PH_CALIBRATION_VOLTAGE_401 = 3.045; // Tegangan untuk pH 4.01
-const float PH_CALIBRATION_VOLTAGE_686 = 2.510; // Tegangan untuk pH 6.86
-const float PH_CALIBRATION_VOLTAGE_918 = 2.025; // Tegangan untuk pH 9.18
+// Nilai di bawah ini hanya nilai awal. Kalibrasi dilakukan di lapangan
+// lewat `.../sensor/kalibrasi/kontrol` (lihat probe_calibration.h); hasilnya
+// disimpan di NVS dan menggantikan nilai ini tanpa flash ulang.
+float PH_CALIBRATION_VOLTAGE_401 = 3.045; // Tegangan untuk pH 4.01
+float PH_CALIBRATION_VOLTAGE_686 = 2.510; // Tegangan untuk pH 6.86
+float PH_CALIBRATION_VOLTAGE_918 = 2.025; // Tegangan untuk pH 9.18
+
+// --- Probe Calibration ---
+// 20 ms samples in blocks of 25 give one block mean per 0.5 s; the plateau is
+// judged on the last 20 s. An electrode approaching its plateau exponentially
+// is still a few drift thresholds away from it, hence the tight drift limit:
+// 1 mV is about 0.005 pH at the PH-4502C's slope.
+const long PROBE_CAL_SAMPLE_INTERVAL_MS = 20;
+const int PROBE_CAL_BLOCK_SAMPLES = 25;
+const float PROBE_CAL_STABLE_MV = 3.0;
+const float PROBE_CAL_DRIFT_MV = 1.0;
+const long PROBE_CAL_TIMEOUT_MS = 600000;              // 10 minutes
+const long PROBE_CAL_SESSION_TIMEOUT_MS = 1800000;     // 30 minutes
+const long PROBE_CAL_STATUS_INTERVAL_MS = 2000;        // 2 seconds
+const float PROBE_CAL_PH_SLOPE_MIN_MV = 50.0;
+const float PROBE_CAL_PH_SLOPE_MAX_MV = 500.0;
 
 // --- Timing & Network ---
 const IPAddress PRIMARY_DNS(8, 8, 8, 8);
 const long SENSOR_PUBLISH_INTERVAL_MS = 5000;   // 5 seconds
+int SENSOR_RAW_PUBLISH_INTERVAL_MS = 30000;  // 30 seconds
+const long SENSOR_SUMMARY_WINDOWS_MS[SENSOR_SUMMARY_NUM_WINDOWS] = {60000, 900000, 3600000}; // 1 min, 15 min, 1 h
 const long HEARTBEAT_INTERVAL_MS = 10000;  // 10 seconds
-const long ACTUATOR_STATE_PUBLISH_INTERVAL_MS = 5000;  // 5 seconds
-const long AUTOMATION_STATE_PUBLISH_INTERVAL_MS = 5000;  // 5 seconds
-const long WIFI_RECONNECT_DELAY_MS = 5000;
-const long MQTT_RECONNECT_DELAY_MS = 5000; 
-const int MAX_RECONNECT_ATTEMPTS = 60;
+const long ACTUATOR_SNAPSHOT_INTERVAL_MS = 900000;  // 15 minutes
+const long DIAGNOSTICS_PUBLISH_INTERVAL_MS = 300000;    // 5 minutes
+const long WIFI_RESTART_TIMEOUT_MS = 300000;     // 5 minutes
+const long MQTT_RECONNECT_MIN_DELAY_MS = 2000;   // 2 seconds
+const long MQTT_RECONNECT_MAX_DELAY_MS = 60000;  // 1 minute
+const long MQTT_CONNECT_TIMEOUT_MS = 3000;       // 3 seconds
+const uint16_t MQTT_SOCKET_TIMEOUT_S = 5;
+const char *NTP_SERVER = "pool.ntp.org";
+
+// --- Command Guard ---
+// 5 commands in a burst, then one every 2 s per command topic. Home Assistant
+// sends a handful of commands per hour; only a runaway automation comes close.
+const int COMMAND_RATE_BURST = 5;
+const long COMMAND_RATE_REFILL_MS = 2000;
+const long COMMAND_COALESCE_WINDOW_MS = 5000;
+const long COMMAND_MAX_AGE_MS = 60000;                 // 1 minute
+const long COMMAND_GUARD_STATUS_INTERVAL_MS = 10000;   // 10 seconds
+const uint32_t WATCHDOG_TIMEOUT_S = 30;
+const long WATCHDOG_STALL_THRESHOLD_MS = 2000;
+const long WATCHDOG_STATS_PUBLISH_INTERVAL_MS = 3600000; // 1 hour
 
 // --- Calculated Constants & Calibration ---
 // ===================================================================
@@ -64,47 +115,177 @@ const int MAX_RECONNECT_ATTEMPTS = 60;
 // - 100 ml dalam 3 detik = 33.33 ml/detik
 // - 1 liter dalam 30 detik = 33.33 ml/detik (verification)
 // - Kalkulasi: 3000 ms / 100 ml = 30 ms/ml
+// Nilai ini sekarang hanya nilai awal; setiap pompa dosis dikalibrasi sendiri
+// melalui topic pompa/kalibrasi/kontrol dan disimpan di NVS.
 const float PUMP_MS_PER_ML = 30.0;
 
+// --- Volumetric Dosing ---
+const long FLOW_MODEL_COMMIT_DELAY_MS = 5000;          // 5 seconds
+const long DISPENSED_VOLUME_COMMIT_DELAY_MS = 600000;  // 10 minutes
+const long CONTROL_STATE_COMMIT_DELAY_MS = 3000;       // 3 seconds
+float TANDON_LITERS_PER_CM = 1.0;
+// Set from a measured dose (ppm rise x liters / ml) to enable TDS-based trimming.
+const float TDS_RESPONSE_PPM_LITERS_PER_ML = 0.0;
+const long TDS_RESPONSE_SETTLE_MS = 120000;            // 2 minutes
+const float TDS_RESPONSE_GAIN = 0.2;
+const char *STORAGE_NAMESPACE = "hidroiot";
+
+// --- Pump Scheduling ---
+// Budget for pumps running at the same time, measured on the AC side by the PZEM.
+// 55 W keeps the 12V 5A supply (60 W) below its rating with some headroom.
+const float PUMP_POWER_BUDGET_W = 55.0;
+const float PUMP_CURRENT_BUDGET_A = 0.40;
+const int MQTT_BUFFER_SIZE = 768;
+
+// --- Pump Run Monitoring ---
+// While a pump runs the PZEM is polled at its maximum rate and the measured
+// draw is compared with the pump's learned draw. 5 samples at 200 ms means a
+// fault must persist for a full second before a run is aborted. A 600 ms dose
+// gets half its length as inrush window, and is judged on its mean at the end.
+const long PUMP_MONITOR_SAMPLE_INTERVAL_MS = 200;
+const long PUMP_MONITOR_INRUSH_MS = 1000;
+const float PUMP_DRY_RUN_RATIO = 0.6;
+const float PUMP_BLOCKED_RATIO = 1.6;
+const float PUMP_RELAY_MIN_DELTA_W = 1.0;
+const int PUMP_FAULT_CONFIRM_SAMPLES = 5;
+// A pump running dry on its very first run must not become the baseline.
+const float PUMP_DRAW_MIN_RATIO = 0.4;
+const float PUMP_DRAW_MAX_RATIO = 3.0;
+const long PUMP_DRAW_COMMIT_DELAY_MS = 600000;         // 10 minutes
+
+// --- Logging ---
+const uint32_t LOG_TASK_STACK_SIZE = 4096;
+const long LOG_DRAIN_INTERVAL_MS = 20;
+const long LOG_STATUS_INTERVAL_MS = 60000;             // 1 minute
+
+// --- Sensor History ---
+const char *HISTORY_PARTITION_LABEL = "spiffs";
+const long HISTORY_RECORD_INTERVAL_MS = 60000;         // 1 minute
+const long HISTORY_COMMIT_INTERVAL_MS = 600000;        // 10 minutes
+
+// --- Control Trace ---
+const long TRACE_FLUSH_INTERVAL_MS = 10000;            // 10 seconds
+
+// --- Metrics Endpoint ---
+const int METRICS_HTTP_PORT = 9100;                    // 0 disables the endpoint
+const long METRICS_CONNECTION_TIMEOUT_MS = 5000;
+
+// --- Firmware Update ---
+const long OTA_CHUNK_TIMEOUT_MS = 3000;
+const long OTA_STALL_TIMEOUT_MS = 900000;              // 15 minutes
+const long OTA_HEALTHY_CONNECTION_MS = 60000;          // 1 minute
+const long OTA_TRIAL_TIMEOUT_MS = 600000;              // 10 minutes
+const uint8_t OTA_TRIAL_MAX_BOOTS = 3;
+
+// --- MQTT over TLS ---
+const long MQTT_TLS_HANDSHAKE_TIMEOUT_MS = 10000;     // 10 seconds
+const bool MQTT_TLS_SESSION_IN_RTC = true;
+
 
 // =======================================================================
 //                           MQTT TOPIC DEFINITIONS
 // =======================================================================
-// Topics are constructed dynamically from the BASE_TOPIC defined above
-const std::string STATE_TOPIC_LEVEL = std::string(BASE_TOPIC) + "/air/level_cm";
-const std::string STATE_TOPIC_DISTANCE = std::string(BASE_TOPIC) + "/air/distance_cm";
-const std::string STATE_TOPIC_WATER_TEMPERATURE = std::string(BASE_TOPIC) + "/air/water_temp_c";
-const std::string STATE_TOPIC_AIR_TEMPERATURE = std::string(BASE_TOPIC) + "/udara/suhu_c";
-const std::string STATE_TOPIC_HUMIDITY = std::string(BASE_TOPIC) + "/udara/kelembaban_persen";
-const std::string STATE_TOPIC_TDS = std::string(BASE_TOPIC) + "/air/tds_ppm";
-const std::string STATE_TOPIC_PH = std::string(BASE_TOPIC) + "/air/ph";
-const std::string STATE_TOPIC_VOLTAGE = std::string(BASE_TOPIC) + "/listrik/tegangan_v";
-const std::string STATE_TOPIC_CURRENT = std::string(BASE_TOPIC) + "/listrik/arus_a";
-const std::string STATE_TOPIC_POWER = std::string(BASE_TOPIC) + "/listrik/daya_w";
-const std::string STATE_TOPIC_ENERGY = std::string(BASE_TOPIC) + "/listrik/energi_kwh";
-const std::string STATE_TOPIC_FREQUENCY = std::string(BASE_TOPIC) + "/listrik/frekuensi_hz";
-const std::string STATE_TOPIC_PF = std::string(BASE_TOPIC) + "/listrik/power_factor";
-const std::string AVAILABILITY_TOPIC = std::string(BASE_TOPIC) + "/status/LWT";
-const std::string HEARTBEAT_TOPIC = std::string(BASE_TOPIC) + "/status/HEARTBEAT";
-const std::string MQTT_GLOBAL_ALERT_TOPIC = std::string(BASE_TOPIC) + "/peringatan";
-
-const std::string COMMAND_TOPIC_SYSTEM_MODE = std::string(BASE_TOPIC) + "/sistem/mode/kontrol";
-const std::string STATE_TOPIC_SYSTEM_MODE = std::string(BASE_TOPIC) + "/sistem/mode/status";
-const std::string COMMAND_TOPIC_PUMP_A = std::string(BASE_TOPIC) + "/pompa/nutrisi_a/kontrol";
-const std::string STATE_TOPIC_PUMP_A = std::string(BASE_TOPIC) + "/pompa/nutrisi_a/status";
-const std::string COMMAND_TOPIC_PUMP_B = std::string(BASE_TOPIC) + "/pompa/nutrisi_b/kontrol";
-const std::string STATE_TOPIC_PUMP_B = std::string(BASE_TOPIC) + "/pompa/nutrisi_b/status";
-const std::string COMMAND_TOPIC_PUMP_PH = std::string(BASE_TOPIC) + "/pompa/ph/kontrol";
-const std::string STATE_TOPIC_PUMP_PH = std::string(BASE_TOPIC) + "/pompa/ph/status";
-const std::string COMMAND_TOPIC_PUMP_SIRAM = std::string(BASE_TOPIC) + "/pompa/penyiraman/kontrol";
-const std::string STATE_TOPIC_PUMP_SIRAM = std::string(BASE_TOPIC) + "/pompa/penyiraman/status";
-const std::string COMMAND_TOPIC_PUMP_TANDON = std::string(BASE_TOPIC) + "/pompa/tandon/kontrol";
-const std::string STATE_TOPIC_PUMP_TANDON = std::string(BASE_TOPIC) + "/pompa/tandon/status";
+// Each topic is its suffix below the BASE_TOPIC; the full topics are written
+// into this arena once the instance ID is known.
+static char topicArena[MQTT_TOPIC_ARENA_SIZE];
+// Constant-initialized, so the list is valid before the first topic registers.
+static MqttTopic *topicHead = nullptr;
+static MqttTopic **topicTail = &topicHead;
+
+MqttTopic::MqttTopic(const char* suffix) : suffixText(suffix), text(""), nextTopic(nullptr) {
+  *topicTail = this;
+  topicTail = &nextTopic;
+}
+
+const MqttTopic* MqttTopic::first() {
+  return topicHead;
+}
+
+bool config_resolve_topics(const char* instanceId) {
+  size_t baseLength = strlen(BASE_TOPIC_PREFIX) + strlen(instanceId);
+  size_t needed = strlen(CLIENT_ID_PREFIX) + strlen(instanceId) + 1 + baseLength + 1;
+  for (const MqttTopic* topic = topicHead; topic != nullptr; topic = topic->nextTopic) {
+    needed += baseLength + strlen(topic->suffixText) + 1;
+  }
+  if (needed > sizeof(topicArena)) return false;
+
+  char* next = topicArena;
+  MQTT_CLIENT_ID = next;
+  next += sprintf(next, "%s%s", CLIENT_ID_PREFIX, instanceId) + 1;
+  BASE_TOPIC = next;
+  next += sprintf(next, "%s%s", BASE_TOPIC_PREFIX, instanceId) + 1;
+  for (MqttTopic* topic = topicHead; topic != nullptr; topic = topic->nextTopic) {
+    topic->text = next;
+    next += sprintf(next, "%s%s", BASE_TOPIC, topic->suffixText) + 1;
+  }
+  return true;
+}
+
+MqttTopic STATE_TOPIC_LEVEL("/air/level_cm");
+MqttTopic STATE_TOPIC_DISTANCE("/air/distance_cm");
+MqttTopic STATE_TOPIC_WATER_TEMPERATURE("/air/water_temp_c");
+MqttTopic STATE_TOPIC_AIR_TEMPERATURE("/udara/suhu_c");
+MqttTopic STATE_TOPIC_HUMIDITY("/udara/kelembaban_persen");
+MqttTopic STATE_TOPIC_TDS("/air/tds_ppm");
+MqttTopic STATE_TOPIC_PH("/air/ph");
+MqttTopic STATE_TOPIC_VOLTAGE("/listrik/tegangan_v");
+MqttTopic STATE_TOPIC_CURRENT("/listrik/arus_a");
+MqttTopic STATE_TOPIC_POWER("/listrik/daya_w");
+MqttTopic STATE_TOPIC_ENERGY("/listrik/energi_kwh");
+MqttTopic STATE_TOPIC_FREQUENCY("/listrik/frekuensi_hz");
+MqttTopic STATE_TOPIC_PF("/listrik/power_factor");
+MqttTopic STATE_TOPIC_SENSOR_SUMMARY("/statistik");
+MqttTopic AVAILABILITY_TOPIC("/status/LWT");
+MqttTopic HEARTBEAT_TOPIC("/status/HEARTBEAT");
+MqttTopic STATE_TOPIC_BOOT("/status/boot");
+MqttTopic STATE_TOPIC_ACTUATOR_SNAPSHOT("/status/aktuator");
+MqttTopic STATE_TOPIC_CRASH("/status/crash");
+MqttTopic STATE_TOPIC_WATCHDOG("/status/watchdog");
+MqttTopic STATE_TOPIC_TLS("/status/tls");
+MqttTopic MQTT_GLOBAL_ALERT_TOPIC("/peringatan");
+
+MqttTopic COMMAND_TOPIC_SYSTEM_MODE("/sistem/mode/kontrol");
+MqttTopic STATE_TOPIC_SYSTEM_MODE("/sistem/mode/status");
+MqttTopic COMMAND_TOPIC_PUMP_A("/pompa/nutrisi_a/kontrol");
+MqttTopic STATE_TOPIC_PUMP_A("/pompa/nutrisi_a/status");
+MqttTopic COMMAND_TOPIC_PUMP_B("/pompa/nutrisi_b/kontrol");
+MqttTopic STATE_TOPIC_PUMP_B("/pompa/nutrisi_b/status");
+MqttTopic COMMAND_TOPIC_PUMP_PH("/pompa/ph/kontrol");
+MqttTopic STATE_TOPIC_PUMP_PH("/pompa/ph/status");
+MqttTopic COMMAND_TOPIC_PUMP_SIRAM("/pompa/penyiraman/kontrol");
+MqttTopic STATE_TOPIC_PUMP_SIRAM("/pompa/penyiraman/status");
+MqttTopic COMMAND_TOPIC_PUMP_TANDON("/pompa/tandon/kontrol");
+MqttTopic STATE_TOPIC_PUMP_TANDON("/pompa/tandon/status");
+MqttTopic COMMAND_TOPIC_PUMP_QUEUE("/pompa/antrian/kontrol");
+MqttTopic STATE_TOPIC_PUMP_QUEUE("/pompa/antrian/status");
+MqttTopic STATE_TOPIC_PUMP_JOB("/pompa/antrian/job");
+MqttTopic STATE_TOPIC_PUMP_ACK("/pompa/ack");
+MqttTopic STATE_TOPIC_COMMAND_GUARD("/perintah/status");
+MqttTopic STATE_TOPIC_PUMP_POWER("/pompa/daya/status");
+MqttTopic STATE_TOPIC_PUMP_MONITOR("/pompa/monitor");
+MqttTopic COMMAND_TOPIC_PUMP_CALIBRATION("/pompa/kalibrasi/kontrol");
+MqttTopic STATE_TOPIC_PUMP_CALIBRATION("/pompa/kalibrasi/status");
+MqttTopic COMMAND_TOPIC_PROBE_CALIBRATION("/sensor/kalibrasi/kontrol");
+MqttTopic STATE_TOPIC_PROBE_CALIBRATION("/sensor/kalibrasi/status");
+MqttTopic STATE_TOPIC_DIAGNOSTICS("/diagnostik");
+MqttTopic LOG_TOPIC("/log");
+MqttTopic COMMAND_TOPIC_LOG("/log/kontrol");
+MqttTopic STATE_TOPIC_LOG("/log/status");
+MqttTopic COMMAND_TOPIC_HISTORY("/riwayat/kontrol");
+MqttTopic STATE_TOPIC_HISTORY("/riwayat");
+MqttTopic STATE_TOPIC_HISTORY_STATUS("/riwayat/status");
+MqttTopic COMMAND_TOPIC_OTA("/ota/kontrol");
+MqttTopic COMMAND_TOPIC_OTA_DATA("/ota/data");
+MqttTopic STATE_TOPIC_OTA_REQUEST("/ota/minta");
+MqttTopic STATE_TOPIC_OTA("/ota/status");
+MqttTopic COMMAND_TOPIC_TRACE("/jejak/kontrol");
+MqttTopic STATE_TOPIC_TRACE("/jejak/status");
+MqttTopic STATE_TOPIC_TRACE_DATA("/jejak/data");
 
 // Automation Topics
-const std::string COMMAND_TOPIC_AUTO_DOSING = std::string(BASE_TOPIC) + "/automasi/dosing/kontrol";
-const std::string STATE_TOPIC_AUTO_DOSING = std::string(BASE_TOPIC) + "/automasi/dosing/status";
-const std::string COMMAND_TOPIC_AUTO_REFILL = std::string(BASE_TOPIC) + "/automasi/refill/kontrol";
-const std::string STATE_TOPIC_AUTO_REFILL = std::string(BASE_TOPIC) + "/automasi/refill/status";
-const std::string COMMAND_TOPIC_AUTO_IRRIGATION = std::string(BASE_TOPIC) + "/automasi/irrigation/kontrol";
-const std::string STATE_TOPIC_AUTO_IRRIGATION = std::string(BASE_TOPIC) + "/automasi/irrigation/status";
+MqttTopic COMMAND_TOPIC_AUTO_DOSING("/automasi/dosing/kontrol");
+MqttTopic STATE_TOPIC_AUTO_DOSING("/automasi/dosing/status");
+MqttTopic COMMAND_TOPIC_AUTO_REFILL("/automasi/refill/kontrol");
+MqttTopic STATE_TOPIC_AUTO_REFILL("/automasi/refill/status");
+MqttTopic COMMAND_TOPIC_AUTO_IRRIGATION("/automasi/irrigation/kontrol");
+MqttTopic STATE_TOPIC_AUTO_IRRIGATION("/automasi/irrigation/status");
@@ -17,29 +17,35 @@
 #define XSTR(s) #s
 #define STR(s) XSTR(s)
 
-// Pre-processor check to ensure an instance ID is defined during compilation.
-#ifndef HYDROPONIC_INSTANCE_ID
-  #error "HYDROPONIC_INSTANCE_ID is not defined. Please select a build environment in platformio.ini (e.g., 'greenhouse_a')."
-#endif
+// The instance ID is resolved at boot (see identity.h): an ID provisioned into NVS wins,
+// then HYDROPONIC_INSTANCE_ID if the build defines one (e.g. 'greenhouse_a'), then an ID
+// derived from the MAC address. The 'fleet' build defines none, so one image serves every greenhouse.
 
 // =======================================================================
 //                           LOGGING
 // =======================================================================
-// To enable, add '-D DEBUG_MODE' to build_flags in platformio.ini
-#if defined(DEBUG_MODE)
-  #define LOG_PRINT(...)    Serial.print(__VA_ARGS__)
-  #define LOG_PRINTLN(...)  Serial.println(__VA_ARGS__)
-  #define LOG_PRINTF(...)   Serial.printf(__VA_ARGS__)
-#else
-  #define LOG_PRINT(...)    (void)0
-  #define LOG_PRINTLN(...)  (void)0
-  #define LOG_PRINTF(...)   (void)0
-#endif
+// Log with LOG_ERROR, LOG_WARN, LOG_INFO and LOG_DEBUG (see logger.h). Records are
+// buffered and written by a background task, so logging stays on in production.
+// LOG_DEBUG is compiled in with '-D DEBUG_MODE'; override with '-D LOG_COMPILE_LEVEL=<0-4>'.
+#include "logger.h"
+
+/// @brief Size of the log record ring buffer in bytes. Sized for a burst of ~40 records.
+constexpr size_t LOG_BUFFER_SIZE = 4096;
+/// @brief Size of the buffer of lines waiting to be forwarded to MQTT, in bytes.
+constexpr size_t LOG_FORWARD_BUFFER_SIZE = 1024;
+/// @brief Stack size (bytes) of the task that formats and writes log records.
+extern const uint32_t LOG_TASK_STACK_SIZE;
+/// @brief The interval (ms) at which the log task drains the buffer.
+extern const long LOG_DRAIN_INTERVAL_MS;
+/// @brief The minimum interval (ms) between logger status publishes caused by dropped records.
+extern const long LOG_STATUS_INTERVAL_MS;
 
 
 // =======================================================================
 //                           WIFI & MQTT CREDENTIALS
 // =======================================================================
+// Defaults injected from credentials.ini; `identity_init()` replaces each one
+// that is provisioned in the device's NVS.
 /// @brief Your WiFi network's SSID. Injected from credentials.ini.
 extern const char *WIFI_SSID;
 /// @brief Your WiFi network's password. Injected from credentials.ini.
@@ -47,40 +53,177 @@ extern const char *WIFI_PASSWORD;
 /// @brief The address of your MQTT broker. Injected from credentials.ini.
 extern const char *MQTT_SERVER;
 /// @brief The port for your MQTT broker. Injected from credentials.ini.
-extern const int MQTT_PORT;
+extern int MQTT_PORT;
 /// @brief The username for your MQTT broker. Injected from credentials.ini.
 extern const char *MQTT_USERNAME;
 /// @brief The password for your MQTT broker. Injected from credentials.ini.
 extern const char *MQTT_PASSWORD;
-/// @brief The unique client ID for this ESP32 device.
+/// @brief The CA certificate (PEM) the broker's certificate must chain to; nullptr for none.
+/// With this or `MQTT_TLS_PUBKEY_SHA256` set, the broker connection uses TLS (see mqtt_tls.h).
+extern const char *MQTT_TLS_CA_CERT;
+/// @brief The SHA-256 (64 hex digits) of the broker's public key to pin, or "" for none.
+/// Without a CA certificate the pin alone decides whether the broker is trusted.
+extern const char *MQTT_TLS_PUBKEY_SHA256;
+/// @brief The unique client ID for this ESP32 device, "esp32-hydroponic-<instance>". Set at boot.
 extern const char *MQTT_CLIENT_ID;
-/// @brief The base topic for all MQTT messages from this device.
+/// @brief The base topic for all MQTT messages from this device, "hidroponik/<instance>". Set at boot.
 extern const char *BASE_TOPIC;
+/// @brief The instance ID compiled in with HYDROPONIC_INSTANCE_ID, or nullptr in a fleet build.
+extern const char *DEFAULT_INSTANCE_ID;
+/// @brief The NVS namespace holding the provisioned identity (see identity.h).
+extern const char *IDENTITY_NAMESPACE;
+/// @brief The longest instance ID accepted, in characters.
+/// Declared `constexpr` because it sizes the identity's static storage.
+constexpr size_t INSTANCE_ID_MAX_LENGTH = 32;
+/// @brief The size in bytes of the arena holding the client ID, the base topic and every MQTT topic.
+/// Fits all topics with an instance ID of `INSTANCE_ID_MAX_LENGTH` characters.
+/// Declared `constexpr` because it sizes the arena's static storage.
+constexpr size_t MQTT_TOPIC_ARENA_SIZE = 4096;
 
 
 // =======================================================================
 //                       COMMON SYSTEM CONFIGURATION
 // =======================================================================
 /// @brief The maximum height of the water reservoir in centimeters. Used to calculate water level from distance.
-extern const int TANDON_MAX_HEIGHT_CM;
+extern int TANDON_MAX_HEIGHT_CM;
 /// @brief Primary DNS server to use for network lookups.
 extern const IPAddress PRIMARY_DNS;
-/// @brief The interval (in milliseconds) at which sensor data is read and published.
+/// @brief The interval (in milliseconds) at which sensors are read and fed to control and the statistics.
 extern const long SENSOR_PUBLISH_INTERVAL_MS;
+/// @brief The interval (in milliseconds) at which raw sensor readings are published; 0 publishes summaries only.
+/// Provisionable per board as "raw_ms", e.g. to lighten a busy broker.
+extern int SENSOR_RAW_PUBLISH_INTERVAL_MS;
+/// @brief The number of sensor summary windows.
+/// Declared `constexpr` because it sizes the statistics' static storage.
+constexpr int SENSOR_SUMMARY_NUM_WINDOWS = 3;
+/// @brief The lengths (in milliseconds) of the windows over which sensor readings are summarized.
+extern const long SENSOR_SUMMARY_WINDOWS_MS[SENSOR_SUMMARY_NUM_WINDOWS];
 /// @brief The interval (in milliseconds) at which a heartbeat message is sent to MQTT.
 extern const long HEARTBEAT_INTERVAL_MS;
-/// @brief The interval (in milliseconds) at which pump states are published to MQTT.
-extern const long ACTUATOR_STATE_PUBLISH_INTERVAL_MS;
-/// @brief The interval (in milliseconds) at which automation states are published to MQTT.
-extern const long AUTOMATION_STATE_PUBLISH_INTERVAL_MS;
-/// @brief The delay (in milliseconds) before attempting to reconnect to WiFi.
-extern const long WIFI_RECONNECT_DELAY_MS;
-/// @brief The delay (in milliseconds) before attempting to reconnect to the MQTT broker.
-extern const long MQTT_RECONNECT_DELAY_MS;
-/// @brief The maximum number of times to attempt reconnection before pausing.
-extern const int MAX_RECONNECT_ATTEMPTS;
-/// @brief Pump calibration factor: milliseconds required to pump one milliliter of liquid.
+/// @brief The interval (in milliseconds) at which the combined actuator and automation snapshot is published.
+/// The individual state topics are only published when they change.
+extern const long ACTUATOR_SNAPSHOT_INTERVAL_MS;
+/// @brief The interval (in milliseconds) at which timing diagnostics are published (builds with DIAGNOSTICS_ENABLED only).
+extern const long DIAGNOSTICS_PUBLISH_INTERVAL_MS;
+/// @brief How long (ms) WiFi may stay disconnected before the ESP32 restarts to recover.
+extern const long WIFI_RESTART_TIMEOUT_MS;
+/// @brief The backoff ceiling (ms) after the first failed MQTT connection attempt; it doubles with every
+/// further failure. The actual delay is drawn at random below the ceiling, so a fleet spreads out.
+extern const long MQTT_RECONNECT_MIN_DELAY_MS;
+/// @brief The highest backoff ceiling (ms) between MQTT connection attempts.
+extern const long MQTT_RECONNECT_MAX_DELAY_MS;
+/// @brief The longest time (ms) opening the TCP connection to the broker may take. The connection
+/// attempt blocks the main loop, so this is short.
+extern const long MQTT_CONNECT_TIMEOUT_MS;
+/// @brief The longest time (s) to wait for the broker's CONNACK, or for the rest of a packet it started.
+extern const uint16_t MQTT_SOCKET_TIMEOUT_S;
+/// @brief The SNTP server that sets the clock for command acknowledgement time stamps.
+extern const char *NTP_SERVER;
+/// @brief How many commands a command topic accepts in a burst before it is rate limited.
+extern const int COMMAND_RATE_BURST;
+/// @brief The time (ms) after which a rate-limited command topic accepts one more command.
+extern const long COMMAND_RATE_REFILL_MS;
+/// @brief How long (ms) a repeat of the last ON, OFF or setting command is dropped as redundant.
+extern const long COMMAND_COALESCE_WINDOW_MS;
+/// @brief Structured commands whose "ts" is older than this (ms) are dropped as stale.
+extern const long COMMAND_MAX_AGE_MS;
+/// @brief The minimum interval (ms) between command guard status publishes caused by dropped commands.
+extern const long COMMAND_GUARD_STATUS_INTERVAL_MS;
+/// @brief The longest a main loop phase may block (s) before the task watchdog stops the pumps and resets.
+/// Must exceed a whole MQTT connection attempt (TCP, TLS handshake and CONNACK timeouts) plus a full sensor cycle.
+extern const uint32_t WATCHDOG_TIMEOUT_S;
+/// @brief A loop phase taking at least this long (ms) is logged and counted as a stall.
+extern const long WATCHDOG_STALL_THRESHOLD_MS;
+/// @brief The interval (ms) at which the loop stall statistics are published.
+extern const long WATCHDOG_STATS_PUBLISH_INTERVAL_MS;
+/// @brief Default pump calibration factor: milliseconds required to pump one milliliter of liquid.
+/// Used until a dosing pump has its own calibrated flow model.
 extern const float PUMP_MS_PER_ML;
+/// @brief Delay (ms) before a changed flow model is written to NVS.
+extern const long FLOW_MODEL_COMMIT_DELAY_MS;
+/// @brief Delay (ms) over which dispensed-volume updates are coalesced into one NVS write.
+extern const long DISPENSED_VOLUME_COMMIT_DELAY_MS;
+/// @brief Delay (ms) over which system mode and automation switch changes are coalesced into one NVS write.
+extern const long CONTROL_STATE_COMMIT_DELAY_MS;
+/// @brief Reservoir volume per centimeter of water level, in liters.
+extern float TANDON_LITERS_PER_CM;
+/// @brief TDS rise (ppm) caused by 1 ml of nutrient concentrate in 1 liter of water. 0 disables TDS-based trimming.
+extern const float TDS_RESPONSE_PPM_LITERS_PER_ML;
+/// @brief Time (ms) after a dose before the TDS response is measured.
+extern const long TDS_RESPONSE_SETTLE_MS;
+/// @brief How far a single TDS response moves a pump's rate towards the implied rate (0-1).
+extern const float TDS_RESPONSE_GAIN;
+/// @brief The NVS namespace for all persisted settings.
+extern const char *STORAGE_NAMESPACE;
+/// @brief The maximum number of pump jobs that can wait in the pump job queue.
+/// Declared `constexpr` because it sizes the queue's static storage.
+constexpr int PUMP_JOB_QUEUE_CAPACITY = 8;
+/// @brief The longest correlation ID accepted in a structured pump command; longer IDs are truncated.
+constexpr size_t COMMAND_ID_MAX_LENGTH = 31;
+/// @brief How many recent command IDs are remembered to recognize retried commands.
+constexpr int COMMAND_ACK_HISTORY_SIZE = 8;
+/// @brief The maximum combined power (W, as seen by the PZEM) that concurrently running pumps may draw.
+extern const float PUMP_POWER_BUDGET_W;
+/// @brief The maximum combined current (A, as seen by the PZEM) that concurrently running pumps may draw.
+extern const float PUMP_CURRENT_BUDGET_A;
+/// @brief The PZEM sampling interval (ms) while a pump runs; the meter library refreshes at most every 200 ms.
+extern const long PUMP_MONITOR_SAMPLE_INTERVAL_MS;
+/// @brief Time (ms) after switch-on during which inrush and priming are not judged; shorter for short runs.
+extern const long PUMP_MONITOR_INRUSH_MS;
+/// @brief A pump drawing less than this fraction of its learned power is running dry.
+extern const float PUMP_DRY_RUN_RATIO;
+/// @brief A pump drawing more than this multiple of its learned power is blocked.
+extern const float PUMP_BLOCKED_RATIO;
+/// @brief A pump adding less than this (W) to the reading is not drawing at all (failed relay).
+extern const float PUMP_RELAY_MIN_DELTA_W;
+/// @brief Consecutive abnormal samples required before a pump run is aborted; fewer for short runs.
+extern const int PUMP_FAULT_CONFIRM_SAMPLES;
+/// @brief A run's mean draw is only learned within these multiples of the pump's rated draw.
+extern const float PUMP_DRAW_MIN_RATIO;
+extern const float PUMP_DRAW_MAX_RATIO;
+/// @brief Delay (ms) before learned pump draws are written to NVS; they move a little with every run.
+extern const long PUMP_DRAW_COMMIT_DELAY_MS;
+/// @brief The MQTT client buffer size in bytes; must fit the largest topic plus JSON payload.
+extern const int MQTT_BUFFER_SIZE;
+/// @brief The label of the data partition that holds the sensor history (the default table's unused "spiffs").
+extern const char *HISTORY_PARTITION_LABEL;
+/// @brief The interval (in milliseconds) at which a sensor reading is appended to the on-flash history.
+extern const long HISTORY_RECORD_INTERVAL_MS;
+/// @brief The longest time (in milliseconds) appended history records stay in RAM before they are written to flash.
+extern const long HISTORY_COMMIT_INTERVAL_MS;
+/// @brief The most flash sectors the history uses, one block each.
+/// Declared `constexpr` because it sizes the block index's static storage.
+constexpr int HISTORY_MAX_BLOCKS = 368;
+/// @brief The flash sectors at the end of the history partition that hold the control trace
+/// (see trace.h); the history uses the sectors before them.
+constexpr int TRACE_FLASH_SECTORS = 64;
+/// @brief The longest time (in milliseconds) recorded trace bytes stay in RAM before they are written out.
+extern const long TRACE_FLUSH_INTERVAL_MS;
+/// @brief The TCP port of the Prometheus `/metrics` endpoint; 0 disables it.
+extern const int METRICS_HTTP_PORT;
+/// @brief The longest time (in milliseconds) a metrics connection may take from accept to the end of the response.
+extern const long METRICS_CONNECTION_TIMEOUT_MS;
+/// @brief The most metrics connections served at once; further ones get a 503 and are closed.
+/// Declared `constexpr` because it sizes the connection table's static storage.
+constexpr int METRICS_MAX_CONNECTIONS = 2;
+/// @brief The most update bytes requested per firmware update chunk; the chunk plus its
+/// 8-byte header and topic must fit `MQTT_BUFFER_SIZE`.
+/// Declared `constexpr` because it sizes the update's static storage.
+constexpr size_t OTA_CHUNK_SIZE = 512;
+/// @brief How long (ms) the update waits for a requested chunk before requesting it again.
+extern const long OTA_CHUNK_TIMEOUT_MS;
+/// @brief An update that makes no progress for this long (ms) is abandoned.
+extern const long OTA_STALL_TIMEOUT_MS;
+/// @brief How long (ms) a new image must stay connected to the broker before it is kept.
+extern const long OTA_HEALTHY_CONNECTION_MS;
+/// @brief How long (ms) a new image may take to become healthy before the previous one is restored.
+extern const long OTA_TRIAL_TIMEOUT_MS;
+/// @brief How many times a new image may boot without becoming healthy before the previous one is restored.
+extern const uint8_t OTA_TRIAL_MAX_BOOTS;
+/// @brief The longest time (ms) a TLS handshake with the broker may take.
+extern const long MQTT_TLS_HANDSHAKE_TIMEOUT_MS;
+/// @brief Whether the TLS session is also kept in RTC memory, so it can be resumed after a reset.
+extern const bool MQTT_TLS_SESSION_IN_RTC;
 
 
 // =======================================================================
@@ -115,95 +258,213 @@ extern const int ULTRASONIC_MAX_DISTANCE_CM;
 /// @brief The type of DHT sensor being used (e.g., DHT22).
 extern const int DHT_TYPE;
 /// @brief The water level (in cm) below which a critical alert is triggered.
-extern const float WATER_LEVEL_CRITICAL_CM;
+extern float WATER_LEVEL_CRITICAL_CM;
 /// @brief The K-value for TDS sensor calibration. This may need adjustment.
-extern const float TDS_K_VALUE;
+extern float TDS_K_VALUE;
 /// @brief The temperature coefficient for TDS compensation.
 extern const float TDS_TEMP_COEFF;
-// pH Sensor 4-Point Calibration Constants (from your calibration script).
+// pH Sensor Calibration Constants. Measured in the field with the probe calibration mode (see probe_calibration.h).
 /// @brief The voltage reading from the pH sensor in pH 4.01 buffer solution.
-extern const float PH_CALIBRATION_VOLTAGE_401;
+extern float PH_CALIBRATION_VOLTAGE_401;
 /// @brief The voltage reading from the pH sensor in pH 6.86 buffer solution.
-extern const float PH_CALIBRATION_VOLTAGE_686;
+extern float PH_CALIBRATION_VOLTAGE_686;
 /// @brief The voltage reading from the pH sensor in pH 9.18 buffer solution.
-extern const float PH_CALIBRATION_VOLTAGE_918;
+extern float PH_CALIBRATION_VOLTAGE_918;
+/// @brief The interval (ms) between ADC samples of the probe under calibration.
+extern const long PROBE_CAL_SAMPLE_INTERVAL_MS;
+/// @brief ADC samples averaged into one block mean while calibrating.
+extern const int PROBE_CAL_BLOCK_SAMPLES;
+/// @brief Block means in the rolling window the plateau is judged on.
+/// Declared `constexpr` because it sizes the window's static storage.
+constexpr int PROBE_CAL_WINDOW_BLOCKS = 40;
+/// @brief The probe has settled when the standard deviation of the window's block means is below this (mV)...
+extern const float PROBE_CAL_STABLE_MV;
+/// @brief ...and the newer half of the window differs from the older half by less than this (mV).
+extern const float PROBE_CAL_DRIFT_MV;
+/// @brief The longest time (ms) a calibration point may take to settle before it is given up.
+extern const long PROBE_CAL_TIMEOUT_MS;
+/// @brief A calibration without a command for this long (ms) is cancelled, so the probes return to service.
+extern const long PROBE_CAL_SESSION_TIMEOUT_MS;
+/// @brief The interval (ms) at which the progress of a calibration point is published.
+extern const long PROBE_CAL_STATUS_INTERVAL_MS;
+/// @brief The plausible range of a pH calibration segment's slope (mV per pH), for a healthy probe and amplifier.
+extern const float PROBE_CAL_PH_SLOPE_MIN_MV;
+extern const float PROBE_CAL_PH_SLOPE_MAX_MV;
 
 
 // =======================================================================
 //                           MQTT TOPICS
 // =======================================================================
-// These are constructed in config.cpp from the BASE_TOPIC
+// These are defined in config.cpp by their suffix below the BASE_TOPIC and
+// resolved into the topic arena by `config_resolve_topics()` at boot.
+
+/**
+ * @class MqttTopic
+ * @brief An MQTT topic below the base topic. Behaves like a C string once resolved;
+ * until then it is empty. Every topic registers itself at static initialization,
+ * so the topics can be resolved and listed in definition order.
+ */
+class MqttTopic {
+public:
+  explicit MqttTopic(const char* suffix);
+  const char* c_str() const { return text; }
+  operator const char*() const { return text; }
+  bool operator==(const char* topic) const { return strcmp(text, topic) == 0; }
+  /// @brief The part after the base topic, e.g. "/air/ph".
+  const char* suffix() const { return suffixText; }
+  /// @brief The next topic in definition order, or nullptr after the last one.
+  const MqttTopic* next() const { return nextTopic; }
+  /// @brief The first topic defined.
+  static const MqttTopic* first();
+
+private:
+  friend bool config_resolve_topics(const char* instanceId);
+  const char* suffixText;
+  const char* text;
+  MqttTopic* nextTopic;
+};
+
+/**
+ * @brief Sets MQTT_CLIENT_ID, BASE_TOPIC and every topic for an instance ID,
+ * writing them into the topic arena. Called by `identity_init()`.
+ * @param instanceId The instance ID.
+ * @return false, leaving everything unchanged, if the topics do not fit the arena.
+ */
+bool config_resolve_topics(const char* instanceId);
+
 /// @brief MQTT topic for publishing the calculated water level.
-extern const std::string STATE_TOPIC_LEVEL;
+extern MqttTopic STATE_TOPIC_LEVEL;
 /// @brief MQTT topic for publishing the raw distance from the ultrasonic sensor.
-extern const std::string STATE_TOPIC_DISTANCE;
+extern MqttTopic STATE_TOPIC_DISTANCE;
 /// @brief MQTT topic for publishing the water temperature.
-extern const std::string STATE_TOPIC_WATER_TEMPERATURE;
+extern MqttTopic STATE_TOPIC_WATER_TEMPERATURE;
 /// @brief MQTT topic for publishing the air temperature.
-extern const std::string STATE_TOPIC_AIR_TEMPERATURE;
+extern MqttTopic STATE_TOPIC_AIR_TEMPERATURE;
 /// @brief MQTT topic for publishing the air humidity.
-extern const std::string STATE_TOPIC_HUMIDITY;
+extern MqttTopic STATE_TOPIC_HUMIDITY;
 /// @brief MQTT topic for publishing the TDS (nutrient concentration).
-extern const std::string STATE_TOPIC_TDS;
+extern MqttTopic STATE_TOPIC_TDS;
 /// @brief MQTT topic for publishing the water's pH value.
-extern const std::string STATE_TOPIC_PH;
+extern MqttTopic STATE_TOPIC_PH;
 /// @brief MQTT topic for publishing the electrical voltage.
-extern const std::string STATE_TOPIC_VOLTAGE;
+extern MqttTopic STATE_TOPIC_VOLTAGE;
 /// @brief MQTT topic for publishing the electrical current.
-extern const std::string STATE_TOPIC_CURRENT;
+extern MqttTopic STATE_TOPIC_CURRENT;
 /// @brief MQTT topic for publishing the electrical power.
-extern const std::string STATE_TOPIC_POWER;
+extern MqttTopic STATE_TOPIC_POWER;
 /// @brief MQTT topic for publishing the total energy consumption.
-extern const std::string STATE_TOPIC_ENERGY;
+extern MqttTopic STATE_TOPIC_ENERGY;
 /// @brief MQTT topic for publishing the electrical frequency.
-extern const std::string STATE_TOPIC_FREQUENCY;
+extern MqttTopic STATE_TOPIC_FREQUENCY;
 /// @brief MQTT topic for publishing the power factor.
-extern const std::string STATE_TOPIC_PF;
+extern MqttTopic STATE_TOPIC_PF;
+/// @brief Base MQTT topic for the windowed sensor summaries; the window length is appended (e.g. "/15m").
+extern MqttTopic STATE_TOPIC_SENSOR_SUMMARY;
 /// @brief MQTT topic for publishing the device's online/offline status (LWT).
-extern const std::string AVAILABILITY_TOPIC;
+extern MqttTopic AVAILABILITY_TOPIC;
 /// @brief MQTT topic for publishing periodic heartbeat messages.
-extern const std::string HEARTBEAT_TOPIC;
+extern MqttTopic HEARTBEAT_TOPIC;
+/// @brief MQTT topic for publishing the reset reason and boot milestone timings.
+extern MqttTopic STATE_TOPIC_BOOT;
+/// @brief MQTT topic for the periodic retained snapshot of all actuator and automation states.
+extern MqttTopic STATE_TOPIC_ACTUATOR_SNAPSHOT;
+/// @brief MQTT topic for publishing the previous run's crash record after a crash or watchdog reset.
+extern MqttTopic STATE_TOPIC_CRASH;
+/// @brief MQTT topic for publishing the per-phase loop stall statistics.
+extern MqttTopic STATE_TOPIC_WATCHDOG;
+/// @brief MQTT topic for the TLS handshake counters (retained; TLS connections only).
+extern MqttTopic STATE_TOPIC_TLS;
 /// @brief MQTT topic for publishing system-wide alerts.
-extern const std::string MQTT_GLOBAL_ALERT_TOPIC;
+extern MqttTopic MQTT_GLOBAL_ALERT_TOPIC;
 
 // Command & State Topics
 /// @brief MQTT topic for receiving system mode commands (e.g., NUTRITION, CLEANER).
-extern const std::string COMMAND_TOPIC_SYSTEM_MODE;
+extern MqttTopic COMMAND_TOPIC_SYSTEM_MODE;
 /// @brief MQTT topic for publishing the current system mode.
-extern const std::string STATE_TOPIC_SYSTEM_MODE;
+extern MqttTopic STATE_TOPIC_SYSTEM_MODE;
 /// @brief MQTT topic for receiving commands for Nutrient Pump A.
-extern const std::string COMMAND_TOPIC_PUMP_A;
+extern MqttTopic COMMAND_TOPIC_PUMP_A;
 /// @brief MQTT topic for publishing the state of Nutrient Pump A.
-extern const std::string STATE_TOPIC_PUMP_A;
+extern MqttTopic STATE_TOPIC_PUMP_A;
 /// @brief MQTT topic for receiving commands for Nutrient Pump B.
-extern const std::string COMMAND_TOPIC_PUMP_B;
+extern MqttTopic COMMAND_TOPIC_PUMP_B;
 /// @brief MQTT topic for publishing the state of Nutrient Pump B.
-extern const std::string STATE_TOPIC_PUMP_B;
+extern MqttTopic STATE_TOPIC_PUMP_B;
 /// @brief MQTT topic for receiving commands for the pH dosing pump.
-extern const std::string COMMAND_TOPIC_PUMP_PH;
+extern MqttTopic COMMAND_TOPIC_PUMP_PH;
 /// @brief MQTT topic for publishing the state of the pH dosing pump.
-extern const std::string STATE_TOPIC_PUMP_PH;
+extern MqttTopic STATE_TOPIC_PUMP_PH;
 /// @brief MQTT topic for receiving commands for the watering pump.
-extern const std::string COMMAND_TOPIC_PUMP_SIRAM;
+extern MqttTopic COMMAND_TOPIC_PUMP_SIRAM;
 /// @brief MQTT topic for publishing the state of the watering pump.
-extern const std::string STATE_TOPIC_PUMP_SIRAM;
+extern MqttTopic STATE_TOPIC_PUMP_SIRAM;
 /// @brief MQTT topic for receiving commands for the reservoir refill valve/pump.
-extern const std::string COMMAND_TOPIC_PUMP_TANDON;
+extern MqttTopic COMMAND_TOPIC_PUMP_TANDON;
 /// @brief MQTT topic for publishing the state of the reservoir refill valve/pump.
-extern const std::string STATE_TOPIC_PUMP_TANDON;
+extern MqttTopic STATE_TOPIC_PUMP_TANDON;
+/// @brief MQTT topic for receiving pump job sequences and queue cancellations.
+extern MqttTopic COMMAND_TOPIC_PUMP_QUEUE;
+/// @brief MQTT topic for publishing the pump job queue status (depth, active jobs, counters).
+extern MqttTopic STATE_TOPIC_PUMP_QUEUE;
+/// @brief MQTT topic for publishing a record for every finished pump job (wait & run times).
+extern MqttTopic STATE_TOPIC_PUMP_JOB;
+/// @brief MQTT topic for acknowledging pump commands that carry a correlation ID.
+extern MqttTopic STATE_TOPIC_PUMP_ACK;
+/// @brief MQTT topic for publishing the admitted and dropped (stale, coalesced, rate-limited) command counts.
+extern MqttTopic STATE_TOPIC_COMMAND_GUARD;
+/// @brief MQTT topic for publishing the power budget and each pump's learned draw.
+extern MqttTopic STATE_TOPIC_PUMP_POWER;
+/// @brief MQTT topic for publishing each pump run's energy and detected fault.
+extern MqttTopic STATE_TOPIC_PUMP_MONITOR;
+/// @brief MQTT topic for receiving dosing pump calibration commands.
+extern MqttTopic COMMAND_TOPIC_PUMP_CALIBRATION;
+/// @brief MQTT topic for publishing the dosing pumps' flow models and dispensed volumes.
+extern MqttTopic STATE_TOPIC_PUMP_CALIBRATION;
+/// @brief MQTT topic for probe calibration commands (`PH <buffer>`, `TDS <ppm>`, `SAVE`, `CANCEL`, `STATUS`).
+extern MqttTopic COMMAND_TOPIC_PROBE_CALIBRATION;
+/// @brief MQTT topic for the probe calibration status (retained).
+extern MqttTopic STATE_TOPIC_PROBE_CALIBRATION;
+/// @brief MQTT topic for publishing loop timing, heap and stack diagnostics.
+extern MqttTopic STATE_TOPIC_DIAGNOSTICS;
+/// @brief MQTT topic for forwarded log lines (off until a level is set on COMMAND_TOPIC_LOG).
+extern MqttTopic LOG_TOPIC;
+/// @brief MQTT topic for receiving logger level commands.
+extern MqttTopic COMMAND_TOPIC_LOG;
+/// @brief MQTT topic for publishing the logger levels and dropped-record counts.
+extern MqttTopic STATE_TOPIC_LOG;
+/// @brief MQTT topic for receiving sensor history queries.
+extern MqttTopic COMMAND_TOPIC_HISTORY;
+/// @brief MQTT topic for publishing the records that answer a history query.
+extern MqttTopic STATE_TOPIC_HISTORY;
+/// @brief MQTT topic for publishing the history's extent and flash usage.
+extern MqttTopic STATE_TOPIC_HISTORY_STATUS;
+/// @brief MQTT topic for firmware update commands (`BEGIN <size> <crc32>`, `ABORT`, `STATUS`).
+extern MqttTopic COMMAND_TOPIC_OTA;
+/// @brief MQTT topic on which firmware update chunks arrive, in binary.
+extern MqttTopic COMMAND_TOPIC_OTA_DATA;
+/// @brief MQTT topic on which the device requests the next firmware update chunk.
+extern MqttTopic STATE_TOPIC_OTA_REQUEST;
+/// @brief MQTT topic for the firmware update status (retained).
+extern MqttTopic STATE_TOPIC_OTA;
+/// @brief MQTT topic for control trace commands (`SERIAL`, `FLASH`, `OFF`, `STATUS`, `DUMP`).
+extern MqttTopic COMMAND_TOPIC_TRACE;
+/// @brief MQTT topic for the control trace status (retained).
+extern MqttTopic STATE_TOPIC_TRACE;
+/// @brief MQTT topic on which a dump of the flash trace is published, one line per message.
+extern MqttTopic STATE_TOPIC_TRACE_DATA;
 
 // Automation Topics
 /// @brief MQTT topic for receiving auto-dosing pH & TDS enable/disable commands.
-extern const std::string COMMAND_TOPIC_AUTO_DOSING;
+extern MqttTopic COMMAND_TOPIC_AUTO_DOSING;
 /// @brief MQTT topic for publishing the current auto-dosing pH & TDS status.
-extern const std::string STATE_TOPIC_AUTO_DOSING;
+extern MqttTopic STATE_TOPIC_AUTO_DOSING;
 /// @brief MQTT topic for receiving auto-refill tandon enable/disable commands.
-extern const std::string COMMAND_TOPIC_AUTO_REFILL;
+extern MqttTopic COMMAND_TOPIC_AUTO_REFILL;
 /// @brief MQTT topic for publishing the current auto-refill tandon status.
-extern const std::string STATE_TOPIC_AUTO_REFILL;
+extern MqttTopic STATE_TOPIC_AUTO_REFILL;
 /// @brief MQTT topic for receiving penyiraman otomatis enable/disable commands.
-extern const std::string COMMAND_TOPIC_AUTO_IRRIGATION;
+extern MqttTopic COMMAND_TOPIC_AUTO_IRRIGATION;
 /// @brief MQTT topic for publishing the current penyiraman otomatis status.
-extern const std::string STATE_TOPIC_AUTO_IRRIGATION;
+extern MqttTopic STATE_TOPIC_AUTO_IRRIGATION;
 
 #endif // CONFIG_H
@@ -0,0 +1,144 @@
+/**
+ * @file diagnostics.cpp
+ * @brief Implements the runtime timing diagnostics module.
+ *
+ * Recording only updates a few integers per event, so the instrumentation
+ * can stay on in the field. All formatting happens once per reporting interval.
+ */
+
+#include "diagnostics.h"
+
+#if defined(DIAGNOSTICS_ENABLED)
+
+#include "config.h"
+#include "mqtt_handler.h"
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct SectionStats
+ * @brief Aggregated durations of one timed section within a reporting interval.
+ */
+struct SectionStats {
+  uint32_t count;     ///< Number of executions.
+  uint64_t sumCycles; ///< Total duration in CPU cycles.
+  uint32_t maxCycles; ///< Longest single execution in CPU cycles.
+};
+
+/// @brief Short names for the JSON payload, indexed by `DiagSection`.
+static const char* const SECTION_NAMES[DIAG_NUM_SECTIONS] = {
+  "ultrasonic", "water_temp", "tds", "dht", "pzem", "ph", "publish"
+};
+
+/// @brief Upper bounds (µs) of the loop-period histogram buckets; the last bucket is open-ended.
+static const uint32_t LOOP_BUCKET_LIMITS_US[] = {100, 1000, 10000, 100000, 1000000};
+static const int NUM_LOOP_BUCKETS = sizeof(LOOP_BUCKET_LIMITS_US) / sizeof(LOOP_BUCKET_LIMITS_US[0]) + 1;
+
+/// @brief Tasks whose stack headroom is reported, when present.
+static const char* const WATCHED_TASKS[] = {"loopTask", "tiT", "wifi", "sys_evt"};
+
+static SectionStats sections[DIAG_NUM_SECTIONS];
+static uint32_t loopBuckets[NUM_LOOP_BUCKETS];
+static uint32_t loopCount = 0;
+static uint64_t loopSumUs = 0;
+static uint32_t loopMaxUs = 0;
+/// @brief micros() at the start of the previous loop iteration (0 before the first).
+static unsigned long lastLoopStartUs = 0;
+/// @brief millis() when the current reporting interval began.
+static unsigned long intervalStart = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void publish_diagnostics(unsigned long intervalMs);
+static void reset_stats();
+
+// --- Public Function Implementations ---
+
+void diagnostics_record(DiagSection section, uint32_t cycles) {
+  SectionStats& stats = sections[section];
+  stats.count++;
+  stats.sumCycles += cycles;
+  if (cycles > stats.maxCycles) stats.maxCycles = cycles;
+}
+
+void diagnostics_loop() {
+  // The loop period uses micros() rather than the cycle counter, which wraps
+  // every ~18 s at 240 MHz and so cannot measure a long stall.
+  unsigned long nowUs = micros();
+  if (lastLoopStartUs != 0) {
+    uint32_t periodUs = nowUs - lastLoopStartUs;
+    int bucket = 0;
+    while (bucket < NUM_LOOP_BUCKETS - 1 && periodUs >= LOOP_BUCKET_LIMITS_US[bucket]) bucket++;
+    loopBuckets[bucket]++;
+    loopCount++;
+    loopSumUs += periodUs;
+    if (periodUs > loopMaxUs) loopMaxUs = periodUs;
+  }
+  lastLoopStartUs = nowUs;
+
+  unsigned long now = millis();
+  if (now - intervalStart >= DIAGNOSTICS_PUBLISH_INTERVAL_MS) {
+    publish_diagnostics(now - intervalStart);
+    reset_stats();
+    intervalStart = now;
+    // Don't charge the report itself to the next loop period.
+    lastLoopStartUs = micros();
+  }
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Formats and publishes the aggregates of the current interval.
+ * Section durations are reported as `[count, mean µs, max µs]`.
+ * @param intervalMs The length of the interval being reported.
+ */
+static void publish_diagnostics(unsigned long intervalMs) {
+  char payload[640];
+  size_t len = 0;
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+
+  len += snprintf(payload + len, sizeof(payload) - len,
+                  "{\"interval_s\":%lu,\"loop\":{\"n\":%u,\"avg_us\":%u,\"max_us\":%u,\"hist\":[",
+                  intervalMs / 1000, loopCount, loopCount ? (uint32_t)(loopSumUs / loopCount) : 0, loopMaxUs);
+  for (int i = 0; i < NUM_LOOP_BUCKETS && len < sizeof(payload); i++) {
+    len += snprintf(payload + len, sizeof(payload) - len, "%s%u", i ? "," : "", loopBuckets[i]);
+  }
+
+  if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "]},\"sect\":{");
+  for (int i = 0; i < DIAG_NUM_SECTIONS && len < sizeof(payload); i++) {
+    const SectionStats& stats = sections[i];
+    len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":[%u,%u,%u]", i ? "," : "", SECTION_NAMES[i],
+                    stats.count, stats.count ? (uint32_t)(stats.sumCycles / stats.count / cyclesPerUs) : 0,
+                    stats.maxCycles / cyclesPerUs);
+  }
+
+  if (len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len,
+                    "},\"heap\":{\"free\":%u,\"min\":%u,\"block\":%u},\"stack\":{",
+                    ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+  }
+  bool first = true;
+  for (size_t i = 0; i < sizeof(WATCHED_TASKS) / sizeof(WATCHED_TASKS[0]) && len < sizeof(payload); i++) {
+    TaskHandle_t task = xTaskGetHandle(WATCHED_TASKS[i]);
+    if (task == nullptr) continue;
+    len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":%u", first ? "" : ",", WATCHED_TASKS[i],
+                    (unsigned)uxTaskGetStackHighWaterMark(task));
+    first = false;
+  }
+  if (len < sizeof(payload)) snprintf(payload + len, sizeof(payload) - len, "}}");
+
+  mqtt_publish_state(STATE_TOPIC_DIAGNOSTICS, payload, false);
+}
+
+/**
+ * @brief Clears the aggregates at the start of a new reporting interval.
+ */
+static void reset_stats() {
+  memset(sections, 0, sizeof(sections));
+  memset(loopBuckets, 0, sizeof(loopBuckets));
+  loopCount = 0;
+  loopSumUs = 0;
+  loopMaxUs = 0;
+}
+
+#endif // DIAGNOSTICS_ENABLED
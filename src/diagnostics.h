@@ -0,0 +1,81 @@
+/**
+ * @file diagnostics.h
+ * @brief Public interface for the runtime timing diagnostics module.
+ *
+ * Measures where the main loop spends its time: the loop period (as a
+ * histogram and worst-case stall), the duration of each sensor read and of
+ * each MQTT publish, plus heap and stack headroom. Aggregates are published
+ * periodically on the diagnostics topic and then reset.
+ *
+ * Instrumentation is only compiled in when `DIAGNOSTICS_ENABLED` is defined;
+ * otherwise every `DIAG_*` macro expands to nothing (or to the bare statement)
+ * and the module costs neither flash nor cycles.
+ */
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdint.h>
+
+/**
+ * @enum DiagSection
+ * @brief The timed sections of the firmware.
+ */
+enum DiagSection {
+  DIAG_SENSOR_ULTRASONIC,
+  DIAG_SENSOR_WATER_TEMP,
+  DIAG_SENSOR_TDS,
+  DIAG_SENSOR_DHT,
+  DIAG_SENSOR_PZEM,
+  DIAG_SENSOR_PH,
+  DIAG_MQTT_PUBLISH,
+  DIAG_NUM_SECTIONS
+};
+
+// To enable, add '-D DIAGNOSTICS_ENABLED' to build_flags in platformio.ini
+#if defined(DIAGNOSTICS_ENABLED)
+
+#include <Arduino.h>
+
+/**
+ * @brief Records one execution of a timed section.
+ * @param section The section that ran.
+ * @param cycles Its duration in CPU cycles.
+ */
+void diagnostics_record(DiagSection section, uint32_t cycles);
+
+/**
+ * @brief Marks the start of a main loop iteration and publishes the aggregates
+ * when the reporting interval has elapsed. Call first thing in `loop()`.
+ */
+void diagnostics_loop();
+
+/**
+ * @class DiagScope
+ * @brief Times the enclosing scope with the CPU cycle counter.
+ */
+class DiagScope {
+public:
+  explicit DiagScope(DiagSection section) : section(section), start(ESP.getCycleCount()) {}
+  ~DiagScope() { diagnostics_record(section, ESP.getCycleCount() - start); }
+
+private:
+  DiagSection section;
+  uint32_t start;
+};
+
+/// @brief Times the rest of the enclosing scope as `section`.
+#define DIAG_SCOPE(section)    DiagScope diagScope_(section)
+/// @brief Runs a statement and times it as `section`.
+#define DIAG_TIME(section, ...) do { DiagScope diagScope_(section); __VA_ARGS__; } while (0)
+/// @brief Marks a loop iteration and publishes diagnostics when due.
+#define DIAG_LOOP()            diagnostics_loop()
+
+#else
+
+#define DIAG_SCOPE(section)     (void)0
+#define DIAG_TIME(section, ...) do { __VA_ARGS__; } while (0)
+#define DIAG_LOOP()             (void)0
+
+#endif // DIAGNOSTICS_ENABLED
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,447 @@
+/**
+ * @file history.cpp
+ * @brief Implements the on-flash sensor history.
+ */
+
+#include "history.h"
+#include "config.h"
+#include "history_codec.h"
+#include "command_ack.h"   // For the wall clock
+#include "mqtt_handler.h"
+#include "number_format.h" // For printf-free float formatting in payloads
+#include <esp_partition.h>
+#include <math.h>
+
+// --- Module-Private (Static) Types & Constants ---
+
+/**
+ * @struct BlockHeader
+ * @brief Written at the start of a sector when its block is opened.
+ */
+struct BlockHeader {
+  uint32_t magic;
+  uint32_t sequence;  ///< Increases by one per block, so the ring order survives a reboot.
+  uint32_t firstTime; ///< Unix seconds of the first record.
+  uint8_t version;
+  uint8_t channels;
+  uint16_t reserved;
+};
+
+/**
+ * @struct CommitSlot
+ * @brief One commit of a block, written once into erased flash at the end of the sector.
+ */
+struct CommitSlot {
+  uint16_t count; ///< Records in the block; 0xFFFF for an unused slot.
+  uint16_t size;  ///< Bytes of bit stream they occupy.
+  uint32_t lastTime;
+};
+
+/**
+ * @struct BlockInfo
+ * @brief The RAM index entry of one sector.
+ */
+struct BlockInfo {
+  uint32_t sequence; ///< 0 if the sector holds no block.
+  uint32_t firstTime;
+  uint32_t lastTime;
+  uint16_t count;    ///< Committed records.
+  uint16_t size;     ///< Committed bytes.
+};
+
+static const size_t SECTOR_SIZE = 4096;
+static const uint32_t BLOCK_MAGIC = 0x54534948; // "HIST"
+static const uint8_t BLOCK_VERSION = 1;
+static const int COMMIT_SLOTS = 32;
+static const size_t SLOTS_OFFSET = SECTOR_SIZE - COMMIT_SLOTS * sizeof(CommitSlot);
+static const size_t PAYLOAD_OFFSET = sizeof(BlockHeader);
+static const size_t PAYLOAD_CAPACITY = SLOTS_OFFSET - PAYLOAD_OFFSET;
+/// @brief Query answer messages sent per loop iteration, to keep the loop responsive.
+static const int QUERY_MESSAGES_PER_LOOP = 2;
+/// @brief The longest row: a time stamp and every field with its decimals, plus separators.
+static const size_t MAX_ROW_LENGTH = 12 + SENSOR_NUM_FIELDS * 13;
+static const float DECIMAL_SCALES[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f};
+
+// --- Module-Private (Static) Variables ---
+
+static const esp_partition_t* partition = nullptr;
+static int numBlocks = 0;
+static BlockInfo blocks[HISTORY_MAX_BLOCKS];
+/// @brief The sector of the newest block, -1 if there is none.
+static int headBlock = -1;
+static uint32_t headSequence = 0;
+
+/// @brief The block being appended to, kept in RAM in full.
+static bool blockOpen = false;
+static uint8_t writeBuffer[PAYLOAD_CAPACITY];
+static HistoryEncoder encoder;
+static size_t committedSize = 0;
+static uint16_t committedCount = 0;
+static int usedSlots = 0;
+
+static bool recording = false;
+static unsigned long lastRecordTime = 0;
+static unsigned long lastCommitTime = 0;
+static uint32_t flashErrors = 0;
+
+/**
+ * @struct HistoryQuery
+ * @brief The state of the query whose answer is being streamed.
+ */
+struct HistoryQuery {
+  bool active;
+  uint32_t id;
+  uint32_t from;
+  uint32_t to;
+  uint32_t nextSequence; ///< The block to load when the decoder runs out.
+  uint32_t rows;
+  HistoryDecoder decoder;
+};
+
+static HistoryQuery query;
+static uint32_t queryCounter = 0;
+/// @brief The block being streamed, copied out of flash (or the write buffer) and un-inverted.
+static uint8_t queryBuffer[PAYLOAD_CAPACITY];
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void scan_block(int index);
+static bool open_block(uint32_t time);
+static void commit_block();
+static bool program(size_t offset, const void* data, size_t size);
+static int block_of(uint32_t sequence);
+static uint32_t oldest_sequence();
+static bool load_next_block();
+static void stream_query();
+static size_t format_row(char* out, size_t size, uint32_t time, const float* values);
+
+// --- Public Function Implementations ---
+
+void history_init() {
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HISTORY_PARTITION_LABEL);
+  if (partition == nullptr) {
+    LOG_WARN("[History] WARN: No '%s' partition, sensor history disabled.\n", HISTORY_PARTITION_LABEL);
+    return;
+  }
+  // The control trace keeps the last sectors (see trace.h).
+  numBlocks = min((int)(partition->size / SECTOR_SIZE) - TRACE_FLASH_SECTORS, HISTORY_MAX_BLOCKS);
+  uint32_t records = 0;
+  for (int i = 0; i < numBlocks; i++) {
+    scan_block(i);
+    records += blocks[i].count;
+    if (blocks[i].sequence > headSequence) {
+      headSequence = blocks[i].sequence;
+      headBlock = i;
+    }
+  }
+  LOG_INFO("[History] %d blocks of %u bytes, %u records stored.\n", numBlocks, (unsigned)PAYLOAD_CAPACITY,
+           records);
+}
+
+void history_add(const SensorValues& values) {
+  if (partition == nullptr) return;
+  unsigned long now = millis();
+  if (recording && now - lastRecordTime < (unsigned long)HISTORY_RECORD_INTERVAL_MS) return;
+  uint64_t clockMs = command_ack_clock_ms();
+  if (clockMs == 0) return; // No wall clock yet.
+  uint32_t time = clockMs / 1000;
+  if (blockOpen && time <= encoder.lastTime) return; // The clock was set back.
+  recording = true;
+  lastRecordTime = now;
+
+  // Stored with the published precision: the noise below it costs bits and means nothing.
+  float record[SENSOR_NUM_FIELDS];
+  for (int f = 0; f < SENSOR_NUM_FIELDS; f++) {
+    float x = values.*SENSOR_FIELDS[f].value;
+    float scale = DECIMAL_SCALES[SENSOR_FIELDS[f].decimals];
+    record[f] = isnan(x) ? NAN : roundf(x * scale) / scale;
+  }
+
+  if (blockOpen && !history_codec_encode(encoder, time, record)) {
+    commit_block(); // The block is full.
+    blockOpen = false;
+  }
+  if (!blockOpen) {
+    if (!open_block(time)) return;
+    history_codec_encode(encoder, time, record);
+  }
+  blocks[headBlock].lastTime = time;
+}
+
+void history_loop() {
+  if (blockOpen && encoder.count > committedCount &&
+      millis() - lastCommitTime >= (unsigned long)HISTORY_COMMIT_INTERVAL_MS) {
+    commit_block();
+    history_publish_status();
+  }
+  if (query.active && mqtt_is_connected()) stream_query();
+}
+
+void history_flush() {
+  commit_block();
+}
+
+void history_handle_command(const char* command) {
+  if (strcasecmp(command, "STATUS") == 0) {
+    history_publish_status();
+    return;
+  }
+  unsigned long from = 0, to = 0xFFFFFFFFUL;
+  if (partition == nullptr || sscanf(command, "%lu %lu", &from, &to) < 1 || to < from) {
+    LOG_WARN("[History] WARN: Invalid query '%s', expected '<from> [<to>]' in Unix seconds.\n", command);
+    return;
+  }
+  if (query.active) LOG_INFO("[History] Query %u replaced after %u rows.\n", query.id, query.rows);
+  query.active = true;
+  query.id = ++queryCounter;
+  query.from = from;
+  query.to = to;
+  query.nextSequence = oldest_sequence();
+  query.rows = 0;
+  query.decoder.remaining = 0;
+  LOG_INFO("[History] Query %u: %lu to %lu.\n", query.id, from, to);
+}
+
+void history_publish_status() {
+  if (partition == nullptr) return;
+  uint32_t records = 0, bytes = 0, oldest = 0, newest = 0;
+  int used = 0;
+  for (int i = 0; i < numBlocks; i++) {
+    if (blocks[i].sequence == 0) continue;
+    uint32_t count = blocks[i].count;
+    uint32_t size = blocks[i].size;
+    if (i == headBlock && blockOpen) {
+      count = encoder.count;
+      size = history_codec_encoded_size(encoder);
+    }
+    if (count == 0) continue;
+    used++;
+    records += count;
+    bytes += size;
+    if (oldest == 0 || blocks[i].firstTime < oldest) oldest = blocks[i].firstTime;
+    if (blocks[i].lastTime > newest) newest = blocks[i].lastTime;
+  }
+  char bytesPerRecord[16];
+  number_format_fixed(bytesPerRecord, sizeof(bytesPerRecord), records ? (float)bytes / records : 0, 1);
+  char payload[256];
+  snprintf(payload, sizeof(payload),
+           "{\"blocks\":%d,\"used\":%d,\"records\":%u,\"oldest\":%u,\"newest\":%u,\"bytes_per_record\":%s,"
+           "\"passes\":%u,\"flash_errors\":%u}",
+           numBlocks, used, records, oldest, newest, bytesPerRecord, numBlocks ? headSequence / numBlocks : 0,
+           flashErrors);
+  mqtt_publish_state(STATE_TOPIC_HISTORY_STATUS, payload, true);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Rebuilds the index entry of one sector from its header and commit slots.
+ * A block that was opened but never committed keeps its sequence with no records.
+ * @param index The sector.
+ */
+static void scan_block(int index) {
+  BlockInfo& info = blocks[index];
+  memset(&info, 0, sizeof(info));
+  BlockHeader header;
+  if (esp_partition_read(partition, index * SECTOR_SIZE, &header, sizeof(header)) != ESP_OK) return;
+  if (header.magic != BLOCK_MAGIC || header.version != BLOCK_VERSION || header.channels != SENSOR_NUM_FIELDS) {
+    return;
+  }
+  CommitSlot slots[COMMIT_SLOTS];
+  if (esp_partition_read(partition, index * SECTOR_SIZE + SLOTS_OFFSET, slots, sizeof(slots)) != ESP_OK) return;
+  info.sequence = header.sequence;
+  info.firstTime = header.firstTime;
+  info.lastTime = header.firstTime;
+  for (int s = 0; s < COMMIT_SLOTS && slots[s].count != 0xFFFF; s++) {
+    if (slots[s].size > PAYLOAD_CAPACITY) break; // Torn write.
+    info.count = slots[s].count;
+    info.size = slots[s].size;
+    info.lastTime = slots[s].lastTime;
+  }
+}
+
+/**
+ * @brief Erases the next sector of the ring and starts a new block in it.
+ * @param time The time stamp of the block's first record.
+ * @return false if the flash could not be written.
+ */
+static bool open_block(uint32_t time) {
+  int next = headBlock < 0 ? 0 : (headBlock + 1) % numBlocks;
+  if (esp_partition_erase_range(partition, next * SECTOR_SIZE, SECTOR_SIZE) != ESP_OK) {
+    if (flashErrors++ == 0) LOG_ERROR("[History] ERROR: Erasing sector %d failed.\n", next);
+    return false;
+  }
+  BlockHeader header = {BLOCK_MAGIC, headSequence + 1, time, BLOCK_VERSION, SENSOR_NUM_FIELDS, 0xFFFF};
+  headBlock = next;
+  headSequence++;
+  BlockInfo& info = blocks[next];
+  info.sequence = headSequence;
+  info.firstTime = time;
+  info.lastTime = time;
+  info.count = 0;
+  info.size = 0;
+  if (!program(0, &header, sizeof(header))) return false;
+
+  history_codec_encoder_init(encoder, writeBuffer, PAYLOAD_CAPACITY, SENSOR_NUM_FIELDS);
+  committedSize = 0;
+  committedCount = 0;
+  usedSlots = 0;
+  lastCommitTime = millis();
+  blockOpen = true;
+  return true;
+}
+
+/**
+ * @brief Writes the records appended since the last commit and records the
+ * commit in the next slot. A block whose slots are used up is closed.
+ */
+static void commit_block() {
+  if (!blockOpen || encoder.count == committedCount) return;
+  lastCommitTime = millis();
+  size_t size = history_codec_encoded_size(encoder);
+  // The last committed byte may have been partly filled; programming it again only clears more bits.
+  size_t start = committedSize > 0 ? committedSize - 1 : 0;
+  uint8_t chunk[64];
+  for (size_t offset = start; offset < size; offset += sizeof(chunk)) {
+    size_t length = min(sizeof(chunk), size - offset);
+    for (size_t i = 0; i < length; i++) chunk[i] = ~writeBuffer[offset + i];
+    if (!program(PAYLOAD_OFFSET + offset, chunk, length)) return;
+  }
+  CommitSlot slot = {encoder.count, (uint16_t)size, encoder.lastTime};
+  if (!program(SLOTS_OFFSET + usedSlots * sizeof(CommitSlot), &slot, sizeof(slot))) return;
+
+  usedSlots++;
+  committedSize = size;
+  committedCount = encoder.count;
+  blocks[headBlock].count = encoder.count;
+  blocks[headBlock].size = size;
+  LOG_DEBUG("[History] Committed %u records (%u bytes) in block %u.\n", encoder.count, (unsigned)size,
+            headSequence);
+  if (usedSlots == COMMIT_SLOTS) blockOpen = false;
+}
+
+/**
+ * @brief Writes bytes into the head block's sector.
+ * @param offset The offset within the sector.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ * @return false on a flash error, which also closes the block.
+ */
+static bool program(size_t offset, const void* data, size_t size) {
+  if (esp_partition_write(partition, headBlock * SECTOR_SIZE + offset, data, size) == ESP_OK) return true;
+  if (flashErrors++ == 0) LOG_ERROR("[History] ERROR: Writing sector %d failed.\n", headBlock);
+  blockOpen = false;
+  return false;
+}
+
+/**
+ * @brief Finds the sector that holds a block.
+ * @param sequence The block's sequence number.
+ * @return The sector, or -1 if the block has been overwritten or never existed.
+ */
+static int block_of(uint32_t sequence) {
+  if (headBlock < 0 || sequence == 0 || sequence > headSequence || headSequence - sequence >= (uint32_t)numBlocks) {
+    return -1;
+  }
+  int index = ((headBlock - (int)(headSequence - sequence)) % numBlocks + numBlocks) % numBlocks;
+  return blocks[index].sequence == sequence ? index : -1;
+}
+
+/**
+ * @brief Returns the sequence number of the oldest block still in the ring.
+ */
+static uint32_t oldest_sequence() {
+  uint32_t oldest = headSequence;
+  while (oldest > 1 && block_of(oldest - 1) >= 0) oldest--;
+  return oldest;
+}
+
+/**
+ * @brief Loads the next block that may hold records in the query's range.
+ * @return false when no block is left.
+ */
+static bool load_next_block() {
+  while (query.nextSequence != 0 && query.nextSequence <= headSequence) {
+    int index = block_of(query.nextSequence++);
+    if (index < 0) continue;
+    const BlockInfo& info = blocks[index];
+    if (info.firstTime > query.to) return false;
+    bool open = index == headBlock && blockOpen;
+    uint16_t count = open ? encoder.count : info.count;
+    if (count == 0 || info.lastTime < query.from) continue;
+
+    size_t size;
+    if (open) {
+      size = history_codec_encoded_size(encoder);
+      memcpy(queryBuffer, writeBuffer, size);
+    } else {
+      size = info.size;
+      if (esp_partition_read(partition, index * SECTOR_SIZE + PAYLOAD_OFFSET, queryBuffer, size) != ESP_OK) {
+        continue;
+      }
+      for (size_t i = 0; i < size; i++) queryBuffer[i] = ~queryBuffer[i];
+    }
+    history_codec_decoder_init(query.decoder, queryBuffer, size, count, SENSOR_NUM_FIELDS);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Publishes the next few messages of the running query's answer.
+ */
+static void stream_query() {
+  char payload[640];
+  for (int m = 0; m < QUERY_MESSAGES_PER_LOOP && query.active; m++) {
+    size_t len = snprintf(payload, sizeof(payload), "{\"q\":%u,\"rows\":[", query.id);
+    int rowsInMessage = 0;
+    bool finished = false;
+    while (len + MAX_ROW_LENGTH + 3 < sizeof(payload)) {
+      uint32_t time;
+      float values[SENSOR_NUM_FIELDS];
+      if (!history_codec_decode(query.decoder, time, values)) {
+        if (load_next_block()) continue;
+        finished = true;
+        break;
+      }
+      if (time < query.from) continue;
+      if (time > query.to) {
+        finished = true;
+        break;
+      }
+      if (rowsInMessage++ > 0) payload[len++] = ',';
+      len += format_row(payload + len, sizeof(payload) - len, time, values);
+      query.rows++;
+    }
+    if (rowsInMessage > 0) {
+      snprintf(payload + len, sizeof(payload) - len, "]}");
+      mqtt_publish_state(STATE_TOPIC_HISTORY, payload, false);
+    }
+    if (finished) {
+      snprintf(payload, sizeof(payload), "{\"q\":%u,\"done\":true,\"rows\":%u}", query.id, query.rows);
+      mqtt_publish_state(STATE_TOPIC_HISTORY, payload, false);
+      LOG_INFO("[History] Query %u done, %u rows.\n", query.id, query.rows);
+      query.active = false;
+    }
+  }
+}
+
+/**
+ * @brief Formats a record as a JSON array: the time stamp, then every field.
+ * @param out The destination.
+ * @param size The size of `out`; at least MAX_ROW_LENGTH.
+ * @param time The record's time stamp.
+ * @param values The record's fields.
+ * @return The length of the text.
+ */
+static size_t format_row(char* out, size_t size, uint32_t time, const float* values) {
+  size_t len = snprintf(out, size, "[%u", time);
+  for (int f = 0; f < SENSOR_NUM_FIELDS && len < size; f++) {
+    char number[16];
+    if (isnan(values[f]) || number_format_fixed(number, sizeof(number), values[f], SENSOR_FIELDS[f].decimals) == 0) {
+      strcpy(number, "null");
+    }
+    len += snprintf(out + len, size - len, ",%s", number);
+  }
+  if (len < size) len += snprintf(out + len, size - len, "]");
+  return min(len, size - 1);
+}
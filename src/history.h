@@ -0,0 +1,68 @@
+/**
+ * @file history.h
+ * @brief Public interface for the on-flash sensor history.
+ *
+ * Every `HISTORY_RECORD_INTERVAL_MS` a reading, rounded to its published
+ * decimals, is appended to a compressed log in the data partition, so a
+ * greenhouse that is offline keeps its history. The partition is a ring of
+ * 4 KB sectors, each holding one block encoded with history_codec.h:
+ *
+ *   [header: magic, sequence, first time][bit stream ...][32 commit slots]
+ *
+ * The bit stream is stored inverted, so the erased state reads as zero bits
+ * and a block can be written piecewise without erasing it again: every commit
+ * programs the new bytes (re-programming the partly filled last byte only
+ * clears bits) and fills the next commit slot with the record count and size.
+ * A power cut loses at most the records since the last commit. Blocks are
+ * used strictly in turn, so every sector is erased once per pass over the
+ * ring, and after a reboot writing continues in the next sector.
+ *
+ * A RAM index of each block's time range answers queries without reading the
+ * flash. Records need the wall clock (SNTP, kept across software resets), so
+ * nothing is recorded after a power-on until the clock has been set once.
+ */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "sensors.h"
+
+/**
+ * @brief Finds the history partition and rebuilds the block index from flash.
+ * Call once in `setup()`.
+ */
+void history_init();
+
+/**
+ * @brief Appends a reading when `HISTORY_RECORD_INTERVAL_MS` has passed since the last one.
+ * Call after each full sensor read.
+ * @param values The latest sensor readings.
+ */
+void history_add(const SensorValues& values);
+
+/**
+ * @brief Main loop for the history. Commits records that have waited
+ * `HISTORY_COMMIT_INTERVAL_MS` and streams the answer to a running query.
+ */
+void history_loop();
+
+/**
+ * @brief Commits all appended records to flash now. Call before a deliberate restart.
+ */
+void history_flush();
+
+/**
+ * @brief Handles a command from the history topic.
+ * `<from> [<to>]` (Unix seconds) streams the records in that range to the
+ * history topic as `{"q":<n>,"rows":[[<time>,<level>,...],...]}` messages,
+ * fields in `SENSOR_FIELDS` order, followed by `{"q":<n>,"done":true,"rows":<count>}`.
+ * A new query replaces a running one. `STATUS` publishes the status.
+ * @param command The payload received.
+ */
+void history_handle_command(const char* command);
+
+/**
+ * @brief Publishes the history's extent, record count and flash usage, retained.
+ */
+void history_publish_status();
+
+#endif // HISTORY_H
@@ -0,0 +1,261 @@
+/**
+ * @file history_codec.cpp
+ * @brief Implements the sensor history compression codec.
+ */
+
+#include "history_codec.h"
+#include <string.h>
+
+// --- Module-Private (Static) Constants ---
+
+/// @brief Bits a record may take at most: the time stamp, then per channel the
+/// control bits, a new window (5 + 5 bits) and 32 meaningful bits.
+static const size_t MAX_TIME_BITS = 4 + 32;
+static const size_t MAX_VALUE_BITS = 2 + 5 + 5 + 32;
+/// @brief Marks a channel whose XOR window has not been set yet.
+static const uint8_t NO_WINDOW = 0xFF;
+
+/**
+ * @struct DodRange
+ * @brief A delta-of-delta bucket: its prefix and how many bits hold the biased value.
+ */
+struct DodRange {
+  uint8_t prefix;
+  uint8_t prefixBits;
+  uint8_t valueBits;
+  int32_t bias; ///< Added to the delta of delta so it is stored unsigned.
+};
+
+/// @brief The buckets after the single '0' bit of an unchanged interval.
+static const DodRange DOD_RANGES[] = {
+  {0x2, 2, 7, 63},    // '10'   -63 .. 64
+  {0x6, 3, 9, 255},   // '110'  -255 .. 256
+  {0xE, 4, 12, 2047}, // '1110' -2047 .. 2048
+};
+static const int NUM_DOD_RANGES = sizeof(DOD_RANGES) / sizeof(DOD_RANGES[0]);
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void write_bits(HistoryEncoder& encoder, uint32_t value, uint8_t numBits);
+static bool read_bits(HistoryDecoder& decoder, uint8_t numBits, uint32_t& value);
+static void reset_channels(HistoryChannelState* channels, uint8_t numChannels);
+static uint32_t float_bits(float value);
+static float bits_float(uint32_t bits);
+
+// --- Public Function Implementations ---
+
+void history_codec_encoder_init(HistoryEncoder& encoder, uint8_t* buffer, size_t capacity, uint8_t numChannels) {
+  encoder.buffer = buffer;
+  encoder.capacity = capacity;
+  encoder.bitLength = 0;
+  encoder.count = 0;
+  encoder.numChannels = numChannels;
+  encoder.firstTime = 0;
+  encoder.lastTime = 0;
+  encoder.lastDelta = 0;
+  reset_channels(encoder.channels, numChannels);
+  memset(buffer, 0, capacity);
+}
+
+bool history_codec_encode(HistoryEncoder& encoder, uint32_t time, const float* values) {
+  size_t worstBits = encoder.count == 0 ? 32 + 32 * (size_t)encoder.numChannels
+                                        : MAX_TIME_BITS + MAX_VALUE_BITS * encoder.numChannels;
+  if (encoder.count == 0xFFFF || encoder.bitLength + worstBits > encoder.capacity * 8) return false;
+
+  if (encoder.count == 0) {
+    write_bits(encoder, time, 32);
+    for (uint8_t c = 0; c < encoder.numChannels; c++) {
+      encoder.channels[c].lastBits = float_bits(values[c]);
+      write_bits(encoder, encoder.channels[c].lastBits, 32);
+    }
+    encoder.firstTime = time;
+    encoder.lastTime = time;
+    encoder.count = 1;
+    return true;
+  }
+
+  int32_t delta = (int32_t)(time - encoder.lastTime);
+  int32_t dod = delta - encoder.lastDelta;
+  if (dod == 0) {
+    write_bits(encoder, 0, 1);
+  } else {
+    int r = 0;
+    while (r < NUM_DOD_RANGES && (dod < -DOD_RANGES[r].bias || dod > DOD_RANGES[r].bias + 1)) r++;
+    if (r < NUM_DOD_RANGES) {
+      write_bits(encoder, DOD_RANGES[r].prefix, DOD_RANGES[r].prefixBits);
+      write_bits(encoder, (uint32_t)(dod + DOD_RANGES[r].bias), DOD_RANGES[r].valueBits);
+    } else {
+      write_bits(encoder, 0xF, 4);
+      write_bits(encoder, (uint32_t)dod, 32);
+    }
+  }
+  encoder.lastDelta = delta;
+  encoder.lastTime = time;
+
+  for (uint8_t c = 0; c < encoder.numChannels; c++) {
+    HistoryChannelState& channel = encoder.channels[c];
+    uint32_t bits = float_bits(values[c]);
+    uint32_t x = bits ^ channel.lastBits;
+    channel.lastBits = bits;
+    if (x == 0) {
+      write_bits(encoder, 0, 1);
+      continue;
+    }
+    uint8_t leading = __builtin_clz(x);
+    uint8_t trailing = __builtin_ctz(x);
+    if (channel.leading != NO_WINDOW && leading >= channel.leading && trailing >= channel.trailing) {
+      // '10': the meaningful bits fit the previous window.
+      write_bits(encoder, 0x2, 2);
+      write_bits(encoder, x >> channel.trailing, 32 - channel.leading - channel.trailing);
+    } else {
+      // '11': a new window, as its leading zeros and length (1-32, stored minus one).
+      uint8_t length = 32 - leading - trailing;
+      write_bits(encoder, 0x3, 2);
+      write_bits(encoder, leading, 5);
+      write_bits(encoder, length - 1, 5);
+      write_bits(encoder, x >> trailing, length);
+      channel.leading = leading;
+      channel.trailing = trailing;
+    }
+  }
+  encoder.count++;
+  return true;
+}
+
+size_t history_codec_encoded_size(const HistoryEncoder& encoder) {
+  return (encoder.bitLength + 7) / 8;
+}
+
+void history_codec_decoder_init(HistoryDecoder& decoder, const uint8_t* buffer, size_t size, uint16_t count,
+                                uint8_t numChannels) {
+  decoder.buffer = buffer;
+  decoder.size = size;
+  decoder.bitPos = 0;
+  decoder.remaining = count;
+  decoder.index = 0;
+  decoder.numChannels = numChannels;
+  decoder.lastTime = 0;
+  decoder.lastDelta = 0;
+  reset_channels(decoder.channels, numChannels);
+}
+
+bool history_codec_decode(HistoryDecoder& decoder, uint32_t& time, float* values) {
+  if (decoder.remaining == 0) return false;
+  uint32_t bits;
+
+  if (decoder.index == 0) {
+    if (!read_bits(decoder, 32, bits)) return false;
+    decoder.lastTime = bits;
+    for (uint8_t c = 0; c < decoder.numChannels; c++) {
+      if (!read_bits(decoder, 32, decoder.channels[c].lastBits)) return false;
+    }
+  } else {
+    // Count the prefix's one bits: 0 is an unchanged interval, 4 a full 32-bit value.
+    int ones = 0;
+    while (ones < 4) {
+      if (!read_bits(decoder, 1, bits)) return false;
+      if (bits == 0) break;
+      ones++;
+    }
+    int32_t dod = 0;
+    if (ones == 4) {
+      if (!read_bits(decoder, 32, bits)) return false;
+      dod = (int32_t)bits;
+    } else if (ones > 0) {
+      const DodRange& range = DOD_RANGES[ones - 1];
+      if (!read_bits(decoder, range.valueBits, bits)) return false;
+      dod = (int32_t)bits - range.bias;
+    }
+    decoder.lastDelta += dod;
+    decoder.lastTime += decoder.lastDelta;
+
+    for (uint8_t c = 0; c < decoder.numChannels; c++) {
+      HistoryChannelState& channel = decoder.channels[c];
+      if (!read_bits(decoder, 1, bits)) return false;
+      if (bits == 0) continue;
+      uint32_t control;
+      if (!read_bits(decoder, 1, control)) return false;
+      if (control == 1) {
+        uint32_t leading, length;
+        if (!read_bits(decoder, 5, leading) || !read_bits(decoder, 5, length)) return false;
+        if (leading + length + 1 > 32) return false; // Corrupt window.
+        channel.leading = leading;
+        channel.trailing = 32 - leading - (length + 1);
+      }
+      if (channel.leading == NO_WINDOW) return false; // Corrupt: reuse before any window.
+      uint32_t meaningful;
+      if (!read_bits(decoder, 32 - channel.leading - channel.trailing, meaningful)) return false;
+      channel.lastBits ^= meaningful << channel.trailing;
+    }
+  }
+
+  time = decoder.lastTime;
+  for (uint8_t c = 0; c < decoder.numChannels; c++) values[c] = bits_float(decoder.channels[c].lastBits);
+  decoder.index++;
+  decoder.remaining--;
+  return true;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Appends the low bits of a value, most significant first.
+ * @param encoder The encoder; its buffer must have room.
+ * @param value The bits to write.
+ * @param numBits How many low bits of `value` to write (1-32).
+ */
+static void write_bits(HistoryEncoder& encoder, uint32_t value, uint8_t numBits) {
+  while (numBits > 0) {
+    uint8_t room = 8 - (encoder.bitLength & 7);
+    uint8_t take = numBits < room ? numBits : room;
+    uint8_t chunk = (value >> (numBits - take)) & ((1u << take) - 1);
+    encoder.buffer[encoder.bitLength >> 3] |= chunk << (room - take);
+    encoder.bitLength += take;
+    numBits -= take;
+  }
+}
+
+/**
+ * @brief Reads bits, most significant first.
+ * @param decoder The decoder.
+ * @param numBits How many bits to read (1-32).
+ * @param value Receives the bits.
+ * @return false if the buffer ends first.
+ */
+static bool read_bits(HistoryDecoder& decoder, uint8_t numBits, uint32_t& value) {
+  if (decoder.bitPos + numBits > decoder.size * 8) return false;
+  value = 0;
+  while (numBits > 0) {
+    uint8_t room = 8 - (decoder.bitPos & 7);
+    uint8_t take = numBits < room ? numBits : room;
+    uint8_t chunk = (decoder.buffer[decoder.bitPos >> 3] >> (room - take)) & ((1u << take) - 1);
+    value = (value << take) | chunk;
+    decoder.bitPos += take;
+    numBits -= take;
+  }
+  return true;
+}
+
+/**
+ * @brief Clears the previous values and XOR windows of all channels.
+ * @param channels The channel states.
+ * @param numChannels The number of channels.
+ */
+static void reset_channels(HistoryChannelState* channels, uint8_t numChannels) {
+  for (uint8_t c = 0; c < numChannels; c++) {
+    channels[c].lastBits = 0;
+    channels[c].leading = NO_WINDOW;
+    channels[c].trailing = 0;
+  }
+}
+
+static uint32_t float_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float bits_float(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
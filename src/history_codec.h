@@ -0,0 +1,112 @@
+/**
+ * @file history_codec.h
+ * @brief Public interface for the sensor history compression codec.
+ *
+ * Encodes a block of time-stamped records, each a fixed number of float
+ * channels, into a bit stream in the style of Facebook's Gorilla:
+ * - time stamps (Unix seconds) are stored as the change of the interval
+ *   between records ("delta of delta"), which is 0 for a steady sampling
+ *   rate and then costs a single bit;
+ * - each channel is XORed with its previous value; an unchanged value costs
+ *   one bit, and otherwise only the bits between the leading and trailing
+ *   zeros of the XOR are stored, reusing the previous window when it fits.
+ * The first record of a block is stored in full, so every block decodes on its
+ * own. Like the pump models, this module is free of hardware dependencies.
+ */
+#ifndef HISTORY_CODEC_H
+#define HISTORY_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief The largest supported number of channels per record.
+const uint8_t HISTORY_CODEC_MAX_CHANNELS = 16;
+
+/**
+ * @struct HistoryChannelState
+ * @brief The per-channel state shared by the encoder and the decoder.
+ */
+struct HistoryChannelState {
+  uint32_t lastBits; ///< The previous value's IEEE 754 bits.
+  uint8_t leading;   ///< Leading zeros of the current XOR window; 0xFF before the first window.
+  uint8_t trailing;  ///< Trailing zeros of the current XOR window.
+};
+
+/**
+ * @struct HistoryEncoder
+ * @brief Appends records to a block buffer.
+ */
+struct HistoryEncoder {
+  uint8_t* buffer;
+  size_t capacity;   ///< The size of `buffer` in bytes.
+  size_t bitLength;  ///< Bits written so far.
+  uint16_t count;    ///< Records written so far.
+  uint8_t numChannels;
+  uint32_t firstTime;
+  uint32_t lastTime;
+  int32_t lastDelta;
+  HistoryChannelState channels[HISTORY_CODEC_MAX_CHANNELS];
+};
+
+/**
+ * @struct HistoryDecoder
+ * @brief Reads records back from a block buffer.
+ */
+struct HistoryDecoder {
+  const uint8_t* buffer;
+  size_t size;       ///< The size of `buffer` in bytes.
+  size_t bitPos;
+  uint16_t remaining;
+  uint16_t index;    ///< Records decoded so far.
+  uint8_t numChannels;
+  uint32_t lastTime;
+  int32_t lastDelta;
+  HistoryChannelState channels[HISTORY_CODEC_MAX_CHANNELS];
+};
+
+/**
+ * @brief Starts an empty block.
+ * @param encoder The encoder.
+ * @param buffer The block buffer; cleared by this call.
+ * @param capacity The size of `buffer` in bytes.
+ * @param numChannels The number of channels per record, at most HISTORY_CODEC_MAX_CHANNELS.
+ */
+void history_codec_encoder_init(HistoryEncoder& encoder, uint8_t* buffer, size_t capacity, uint8_t numChannels);
+
+/**
+ * @brief Appends a record to the block.
+ * @param encoder The encoder.
+ * @param time The record's time stamp; must not be older than the previous one.
+ * @param values The channel values (`numChannels` of them); NAN is stored as is.
+ * @return false if the block may not have room for the record; it is then unchanged.
+ */
+bool history_codec_encode(HistoryEncoder& encoder, uint32_t time, const float* values);
+
+/**
+ * @brief Returns the number of bytes the block occupies so far.
+ * @param encoder The encoder.
+ * @return The used size of the buffer, including a partly written last byte.
+ */
+size_t history_codec_encoded_size(const HistoryEncoder& encoder);
+
+/**
+ * @brief Starts reading a block.
+ * @param decoder The decoder.
+ * @param buffer The encoded block.
+ * @param size The number of valid bytes in `buffer`.
+ * @param count The number of records in the block.
+ * @param numChannels The number of channels per record.
+ */
+void history_codec_decoder_init(HistoryDecoder& decoder, const uint8_t* buffer, size_t size, uint16_t count,
+                                uint8_t numChannels);
+
+/**
+ * @brief Reads the next record.
+ * @param decoder The decoder.
+ * @param time Receives the record's time stamp.
+ * @param values Receives the channel values (`numChannels` of them).
+ * @return false if there are no more records or the block is truncated.
+ */
+bool history_codec_decode(HistoryDecoder& decoder, uint32_t& time, float* values);
+
+#endif // HISTORY_CODEC_H
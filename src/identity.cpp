@@ -0,0 +1,255 @@
+/**
+ * @file identity.cpp
+ * @brief Implements the device identity.
+ */
+
+#include "identity.h"
+#include "config.h"
+#include "number_format.h" // For printf-free float settings
+#include <Preferences.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct IdentityText
+ * @brief A provisionable text setting.
+ */
+struct IdentityText {
+  const char* key;
+  const char** value; ///< Refers to the global in config.cpp.
+  char* buffer;       ///< Holds the provisioned value.
+  size_t size;
+};
+
+/**
+ * @struct IdentityNumber
+ * @brief A provisionable numeric setting. Exactly one of `floatValue` and `intValue` is set.
+ */
+struct IdentityNumber {
+  const char* key;
+  float* floatValue; ///< Refers to the global in config.cpp.
+  int* intValue;     ///< Refers to the global in config.cpp.
+  float minValue;
+  float maxValue;
+};
+
+static char instanceId[INSTANCE_ID_MAX_LENGTH + 1];
+static const char* instanceSource = "build";
+
+static char wifiSsid[33];
+static char wifiPassword[65];
+static char mqttServer[65];
+static char mqttUsername[65];
+static char mqttPassword[65];
+static char mqttPin[65];
+
+static const IdentityText IDENTITY_TEXTS[] = {
+    {"wifi_ssid", &WIFI_SSID, wifiSsid, sizeof(wifiSsid)},
+    {"wifi_pass", &WIFI_PASSWORD, wifiPassword, sizeof(wifiPassword)},
+    {"mqtt_host", &MQTT_SERVER, mqttServer, sizeof(mqttServer)},
+    {"mqtt_user", &MQTT_USERNAME, mqttUsername, sizeof(mqttUsername)},
+    {"mqtt_pass", &MQTT_PASSWORD, mqttPassword, sizeof(mqttPassword)},
+    {"mqtt_pin", &MQTT_TLS_PUBKEY_SHA256, mqttPin, sizeof(mqttPin)}};
+
+static const IdentityNumber IDENTITY_NUMBERS[] = {
+    {"mqtt_port", nullptr, &MQTT_PORT, 1, 65535},
+    {"level_crit", &WATER_LEVEL_CRITICAL_CM, nullptr, 0, 400},
+    {"tank_height", nullptr, &TANDON_MAX_HEIGHT_CM, 1, 400},
+    {"raw_ms", nullptr, &SENSOR_RAW_PUBLISH_INTERVAL_MS, 0, 86400000},
+    {"liters_cm", &TANDON_LITERS_PER_CM, nullptr, 0.01f, 1000},
+    {"tds_k", &TDS_K_VALUE, nullptr, 1, 5000},
+    {"ph_v401", &PH_CALIBRATION_VOLTAGE_401, nullptr, 0, 3.3f},
+    {"ph_v686", &PH_CALIBRATION_VOLTAGE_686, nullptr, 0, 3.3f},
+    {"ph_v918", &PH_CALIBRATION_VOLTAGE_918, nullptr, 0, 3.3f}};
+
+static const int NUM_IDENTITY_TEXTS = sizeof(IDENTITY_TEXTS) / sizeof(IDENTITY_TEXTS[0]);
+static const int NUM_IDENTITY_NUMBERS = sizeof(IDENTITY_NUMBERS) / sizeof(IDENTITY_NUMBERS[0]);
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool read_instance_id(Preferences& prefs);
+static bool read_text(Preferences& prefs, const IdentityText& text);
+static bool read_number(Preferences& prefs, const IdentityNumber& number);
+static bool is_valid_instance_id(const char* id);
+static void derive_instance_id();
+static void format_float(char* buffer, size_t size, float value);
+
+// --- Public Function Implementations ---
+
+void identity_init() {
+  Preferences prefs;
+  int provisioned = 0;
+  bool haveId = false;
+  // Opening read-only fails if the board was never provisioned.
+  if (prefs.begin(IDENTITY_NAMESPACE, true)) {
+    haveId = read_instance_id(prefs);
+    for (int i = 0; i < NUM_IDENTITY_TEXTS; i++) provisioned += read_text(prefs, IDENTITY_TEXTS[i]);
+    for (int i = 0; i < NUM_IDENTITY_NUMBERS; i++) provisioned += read_number(prefs, IDENTITY_NUMBERS[i]);
+    prefs.end();
+  }
+
+  if (haveId) {
+    instanceSource = "nvs";
+  } else if (DEFAULT_INSTANCE_ID != nullptr && is_valid_instance_id(DEFAULT_INSTANCE_ID)) {
+    strcpy(instanceId, DEFAULT_INSTANCE_ID);
+    instanceSource = "build";
+  } else {
+    derive_instance_id();
+    instanceSource = "mac";
+    LOG_WARN("[Identity] WARN: No instance ID provisioned, using %s.\n", instanceId);
+  }
+
+  // The arena fits every valid ID; the short MAC-derived ID is the last resort.
+  if (!config_resolve_topics(instanceId)) {
+    LOG_ERROR("[Identity] ERROR: Topics for %s do not fit the topic arena.\n", instanceId);
+    derive_instance_id();
+    instanceSource = "mac";
+    config_resolve_topics(instanceId);
+  }
+  LOG_INFO("[Identity] Instance %s (from %s), %d provisioned setting(s), broker %s:%d.\n", instanceId, instanceSource,
+           provisioned, MQTT_SERVER, MQTT_PORT);
+}
+
+const char* identity_instance_id() {
+  return instanceId;
+}
+
+const char* identity_source() {
+  return instanceSource;
+}
+
+bool identity_get_number(int index, const char*& key, char* value, size_t size) {
+  if (index < 0 || index >= NUM_IDENTITY_NUMBERS) return false;
+  const IdentityNumber& number = IDENTITY_NUMBERS[index];
+  key = number.key;
+  if (number.intValue != nullptr) {
+    snprintf(value, size, "%d", *number.intValue);
+  } else {
+    format_float(value, size, *number.floatValue);
+  }
+  return true;
+}
+
+bool identity_set_number(const char* key, float value) {
+  const IdentityNumber* number = nullptr;
+  for (int i = 0; i < NUM_IDENTITY_NUMBERS && number == nullptr; i++) {
+    if (strcmp(IDENTITY_NUMBERS[i].key, key) == 0) number = &IDENTITY_NUMBERS[i];
+  }
+  if (number == nullptr || !(value >= number->minValue && value <= number->maxValue) ||
+      (number->intValue != nullptr && value != (int)value)) {
+    LOG_ERROR("[Identity] ERROR: %s cannot be set to %.4f.\n", key, value);
+    return false;
+  }
+  char text[16];
+  if (number->intValue != nullptr) {
+    snprintf(text, sizeof(text), "%d", (int)value);
+  } else {
+    // The setting takes the value read back from the stored text, so it is the same after a reboot.
+    format_float(text, sizeof(text), value);
+    value = strtof(text, nullptr);
+  }
+  Preferences prefs;
+  bool stored = prefs.begin(IDENTITY_NAMESPACE, false) && prefs.putString(key, text) > 0;
+  prefs.end();
+  if (!stored) {
+    LOG_ERROR("[Identity] ERROR: Could not store %s.\n", key);
+    return false;
+  }
+  if (number->intValue != nullptr) {
+    *number->intValue = (int)value;
+  } else {
+    *number->floatValue = value;
+  }
+  LOG_INFO("[Identity] %s set to %s.\n", key, text);
+  return true;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Reads and validates the provisioned instance ID into `instanceId`.
+ * @return true if a valid ID is provisioned.
+ */
+static bool read_instance_id(Preferences& prefs) {
+  if (!prefs.isKey("instance")) return false;
+  char id[INSTANCE_ID_MAX_LENGTH + 1];
+  if (prefs.getString("instance", id, sizeof(id)) == 0 || !is_valid_instance_id(id)) {
+    LOG_ERROR("[Identity] ERROR: Provisioned instance ID is invalid or longer than %u characters, ignored.\n",
+              (unsigned)INSTANCE_ID_MAX_LENGTH);
+    return false;
+  }
+  strcpy(instanceId, id);
+  return true;
+}
+
+/**
+ * @brief Replaces a text setting's default with its provisioned value, if any.
+ * @return true if the setting was provisioned.
+ */
+static bool read_text(Preferences& prefs, const IdentityText& text) {
+  if (!prefs.isKey(text.key)) return false;
+  if (prefs.getString(text.key, text.buffer, text.size) == 0) {
+    LOG_ERROR("[Identity] ERROR: Provisioned %s is longer than %u characters, ignored.\n", text.key,
+              (unsigned)text.size - 1);
+    return false;
+  }
+  *text.value = text.buffer;
+  return true;
+}
+
+/**
+ * @brief Replaces a numeric setting's default with its provisioned value, if any.
+ * The value is stored as a string and must parse completely and lie within the setting's range.
+ * @return true if the setting was provisioned.
+ */
+static bool read_number(Preferences& prefs, const IdentityNumber& number) {
+  if (!prefs.isKey(number.key)) return false;
+  char text[16];
+  char* end = nullptr;
+  float value = NAN;
+  if (prefs.getString(number.key, text, sizeof(text)) > 0) value = strtof(text, &end);
+  bool valid = end != nullptr && end != text && *end == '\0' && value >= number.minValue && value <= number.maxValue &&
+               (number.intValue == nullptr || value == (int)value);
+  if (!valid) {
+    LOG_ERROR("[Identity] ERROR: Provisioned %s is not a number in [%.2f, %.2f], ignored.\n", number.key,
+              number.minValue, number.maxValue);
+    return false;
+  }
+  if (number.intValue != nullptr) {
+    *number.intValue = (int)value;
+  } else {
+    *number.floatValue = value;
+  }
+  return true;
+}
+
+/**
+ * @brief Checks that an instance ID is non-empty, fits, and is safe as an MQTT topic level.
+ */
+static bool is_valid_instance_id(const char* id) {
+  size_t length = strlen(id);
+  if (length == 0 || length > INSTANCE_ID_MAX_LENGTH) return false;
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)id[i]) && id[i] != '_' && id[i] != '-') return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Sets `instanceId` to "hidroiot-" and the last three bytes of the MAC address.
+ */
+static void derive_instance_id() {
+  // The eFuse MAC is stored with its first byte in the lowest bits.
+  uint64_t mac = ESP.getEfuseMac();
+  snprintf(instanceId, sizeof(instanceId), "hidroiot-%02x%02x%02x", (unsigned)(mac >> 24) & 0xFF,
+           (unsigned)(mac >> 32) & 0xFF, (unsigned)(mac >> 40) & 0xFF);
+}
+
+/**
+ * @brief Writes a float setting as text that `read_number()` parses back, with
+ * `NUMBER_FORMAT_MAX_DECIMALS` decimals and no trailing zeros (e.g. "635.4").
+ */
+static void format_float(char* buffer, size_t size, float value) {
+  size_t length = number_format_fixed(buffer, size, value, NUMBER_FORMAT_MAX_DECIMALS);
+  while (length > 0 && buffer[length - 1] == '0') buffer[--length] = '\0';
+  if (length > 0 && buffer[length - 1] == '.') buffer[--length] = '\0';
+}
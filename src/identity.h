@@ -0,0 +1,73 @@
+/**
+ * @file identity.h
+ * @brief Public interface for the device identity.
+ *
+ * Resolves which greenhouse this board is, once at boot, so one firmware image
+ * can serve the whole fleet. The instance ID, network credentials and the
+ * per-greenhouse thresholds are read from the `IDENTITY_NAMESPACE` NVS
+ * namespace, which is written once per board when it is provisioned (e.g.
+ * with the IDF's NVS partition generator). Every value is a string; anything
+ * not provisioned keeps its build default from config.cpp:
+ *
+ *   instance      the instance ID, e.g. "greenhouse_b" (letters, digits, '_', '-')
+ *   wifi_ssid, wifi_pass, mqtt_host, mqtt_port, mqtt_user, mqtt_pass
+ *   mqtt_pin      MQTT_TLS_PUBKEY_SHA256 (the broker's pinned key, see mqtt_tls.h)
+ *   level_crit    WATER_LEVEL_CRITICAL_CM      tank_height  TANDON_MAX_HEIGHT_CM
+ *   liters_cm     TANDON_LITERS_PER_CM         tds_k        TDS_K_VALUE
+ *   raw_ms        SENSOR_RAW_PUBLISH_INTERVAL_MS
+ *   ph_v401, ph_v686, ph_v918                  PH_CALIBRATION_VOLTAGE_401/686/918
+ *
+ * The probe calibration (ph_v*, tds_k) can also be written at run time, see
+ * `identity_set_number()` and probe_calibration.h.
+ *
+ * Without a provisioned ID the build's HYDROPONIC_INSTANCE_ID is used, and
+ * without that an ID derived from the MAC address ("hidroiot-<last 3 bytes>").
+ * The client ID and every MQTT topic are then written once into a fixed
+ * arena (see `config_resolve_topics()`); nothing is allocated afterwards.
+ */
+#ifndef IDENTITY_H
+#define IDENTITY_H
+
+#include <stddef.h>
+
+/**
+ * @brief Reads the provisioned identity and resolves the client ID and topics.
+ * Call first thing in `setup()`, before any module uses a topic or threshold.
+ */
+void identity_init();
+
+/**
+ * @brief Returns the instance ID in use.
+ * @return The ID, e.g. "greenhouse_a".
+ */
+const char* identity_instance_id();
+
+/**
+ * @brief Returns where the instance ID came from.
+ * @return "nvs", "build" or "mac".
+ */
+const char* identity_source();
+
+/**
+ * @brief Reads one numeric setting in use, provisioned or the build default, as
+ * the text it would be provisioned with, e.g. to record the thresholds a trace
+ * was made with. Credentials are not numeric settings and are never returned.
+ * @param index The setting's index, from 0.
+ * @param key Receives the setting's key, e.g. "level_crit".
+ * @param value Receives the value, e.g. "10" or "635.4" (at most 4 decimals); 16 bytes always suffice.
+ * @param size The size of `value`.
+ * @return false if there is no setting with that index.
+ */
+bool identity_get_number(int index, const char*& key, char* value, size_t size);
+
+/**
+ * @brief Changes one numeric setting and provisions it, so it survives a reboot,
+ * e.g. a probe calibration measured in the field. The value is checked against
+ * the setting's range and written as the text it is read back from.
+ * @param key The setting's key, e.g. "ph_v686".
+ * @param value The new value.
+ * @return false if there is no such setting, the value is out of range or could not be stored.
+ */
+bool identity_set_number(const char* key, float value);
+
+#endif // IDENTITY_H
@@ -0,0 +1,467 @@
+/**
+ * @file logger.cpp
+ * @brief Implements the asynchronous, levelled logger.
+ *
+ * The record ring buffer has a single producer (the loop task) and a single
+ * consumer (the drain task), so head and tail are plain atomics and no lock is
+ * taken. Formatting happens in the drain task: the format string is walked
+ * and each conversion is handed to `snprintf` with its captured argument,
+ * except floats, which go through `number_format_fixed()` as `%f` with at most
+ * `NUMBER_FORMAT_MAX_DECIMALS` decimals.
+ * Lines to forward over MQTT go through a second ring in the opposite
+ * direction, because only the loop task may use the MQTT client.
+ */
+
+#include "logger.h"
+#include "config.h"
+#include "mqtt_handler.h"
+#include "number_format.h" // For printf-free float arguments
+#include <atomic>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct ByteRing
+ * @brief A single-producer, single-consumer ring of entries, each stored with
+ * a 16-bit length prefix. `head` and `tail` run freely and are only reduced
+ * modulo the size on access.
+ */
+struct ByteRing {
+  uint8_t* data;
+  uint32_t size;
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+};
+
+/**
+ * @struct LogRecordHeader
+ * @brief The fixed part at the start of every record.
+ */
+struct LogRecordHeader {
+  uint8_t level;      ///< Message level.
+  uint8_t forward;    ///< Whether the line may be forwarded to MQTT.
+  uint32_t timeMs;    ///< `millis()` when the message was logged.
+  const char* format; ///< The format string literal.
+};
+
+static uint8_t recordStorage[LOG_BUFFER_SIZE];
+static uint8_t forwardStorage[LOG_FORWARD_BUFFER_SIZE];
+static ByteRing records = {recordStorage, LOG_BUFFER_SIZE, {0}, {0}};
+static ByteRing forwarded = {forwardStorage, LOG_FORWARD_BUFFER_SIZE, {0}, {0}};
+
+uint8_t loggerRecordLevel = LOG_COMPILE_LEVEL;
+/// @brief The most verbose level written to Serial.
+static uint8_t serialLevel = LOG_COMPILE_LEVEL;
+/// @brief The most verbose level forwarded to MQTT; forwarding is off by default.
+static uint8_t mqttLevel = LOG_LEVEL_NONE;
+
+/// @brief Records lost because the ring was full or the caller was not the loop task.
+static std::atomic<uint32_t> droppedRecords(0);
+/// @brief Forwarded lines lost because MQTT was not keeping up.
+static std::atomic<uint32_t> droppedForwards(0);
+/// @brief The most bytes the record ring has held.
+static uint32_t peakUsedBytes = 0;
+
+/// @brief Set while a forwarded line is being published, so that the publish's own logging is not forwarded again.
+static bool forwardingLine = false;
+static uint32_t reportedDrops = 0;
+static uint32_t publishedDrops = 0;
+static unsigned long lastStatusPublishTime = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+/// @brief The only task allowed to write records.
+static TaskHandle_t producerTask = nullptr;
+#endif
+
+static const char* const LEVEL_NAMES[] = {"NONE", "ERROR", "WARN", "INFO", "DEBUG"};
+/// @brief The longest formatted line; longer ones are cut.
+static const size_t LOG_LINE_SIZE = 256;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool ring_write(ByteRing& ring, const void* entry, size_t size);
+static size_t ring_read(ByteRing& ring, uint8_t* out, size_t outSize);
+static void ring_copy_in(ByteRing& ring, uint32_t to, const uint8_t* in, size_t length);
+static void ring_copy_out(const ByteRing& ring, uint32_t from, uint8_t* out, size_t length);
+static void drain_records();
+static size_t format_record(const uint8_t* record, size_t size, char* line, size_t lineSize);
+static void update_record_level();
+static int parse_level(const char* name);
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void drain_task(void* parameter);
+#endif
+
+// --- Public Function Implementations ---
+
+void logger_begin(LogRecord& record, uint8_t level, const char* format) {
+  LogRecordHeader header;
+  header.level = level;
+  header.forward = !forwardingLine;
+  header.timeMs = millis();
+  header.format = format;
+  memcpy(record.data, &header, sizeof(header));
+  record.size = sizeof(header);
+}
+
+void logger_commit(LogRecord& record) {
+#if defined(ARDUINO_ARCH_ESP32)
+  if (producerTask != nullptr && xTaskGetCurrentTaskHandle() != producerTask) {
+    droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+#endif
+  if (!ring_write(records, record.data, record.size)) {
+    droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint32_t used = records.head.load(std::memory_order_relaxed) - records.tail.load(std::memory_order_relaxed);
+  if (used > peakUsedBytes) peakUsedBytes = used;
+}
+
+void logger_write_data(const char* line) {
+  LogRecord record;
+  logger_begin(record, LOG_LEVEL_NONE, "%s");
+  LogRecordHeader header;
+  memcpy(&header, record.data, sizeof(header));
+  header.forward = 0;
+  memcpy(record.data, &header, sizeof(header));
+  record.add_string(line);
+  logger_commit(record);
+}
+
+void logger_init() {
+#if defined(ARDUINO_ARCH_ESP32)
+  producerTask = xTaskGetCurrentTaskHandle();
+  // The loop task runs on core 1; draining on core 0 at low priority never delays it.
+  xTaskCreatePinnedToCore(drain_task, "logger", LOG_TASK_STACK_SIZE, nullptr, 1, nullptr, 0);
+#endif
+}
+
+void logger_loop() {
+#if !defined(ARDUINO_ARCH_ESP32)
+  drain_records();
+#endif
+
+  // Publish forwarded lines. Only the loop task may use the MQTT client.
+  uint8_t line[LOG_LINE_SIZE];
+  while (mqtt_is_connected()) {
+    size_t length = ring_read(forwarded, line, sizeof(line) - 1);
+    if (length == 0) break;
+    line[length] = '\0';
+    forwardingLine = true;
+    mqtt_publish_state(LOG_TOPIC, (const char*)line, false);
+    forwardingLine = false;
+  }
+
+  // Report new drops, at most once per interval.
+  uint32_t drops = droppedRecords.load(std::memory_order_relaxed) + droppedForwards.load(std::memory_order_relaxed);
+  unsigned long now = millis();
+  if (drops != publishedDrops && now - lastStatusPublishTime >= LOG_STATUS_INTERVAL_MS && mqtt_is_connected()) {
+    logger_publish_status();
+  }
+}
+
+void logger_flush(unsigned long timeoutMs) {
+  unsigned long start = millis();
+#if defined(ARDUINO_ARCH_ESP32)
+  while (records.tail.load(std::memory_order_acquire) != records.head.load(std::memory_order_acquire) &&
+         millis() - start < timeoutMs) {
+    delay(5);
+  }
+#else
+  (void)start;
+  drain_records();
+#endif
+  Serial.flush();
+}
+
+void logger_handle_command(const char* command) {
+  bool forMqtt = strncasecmp(command, "MQTT", 4) == 0;
+  int level = parse_level(forMqtt ? command + 4 : command);
+  if (level < 0) {
+    LOG_WARN("[Log] WARN: Invalid logger command '%s'.\n", command);
+    return;
+  }
+  if (forMqtt) {
+    mqttLevel = (uint8_t)level;
+  } else {
+    serialLevel = (uint8_t)level;
+  }
+  update_record_level();
+  LOG_INFO("[Log] %s level set to %s.\n", forMqtt ? "MQTT" : "Serial", LEVEL_NAMES[level]);
+  logger_publish_status();
+}
+
+void logger_publish_status() {
+  uint32_t drops = droppedRecords.load(std::memory_order_relaxed);
+  uint32_t forwardDrops = droppedForwards.load(std::memory_order_relaxed);
+  char payload[160];
+  snprintf(payload, sizeof(payload),
+           "{\"level\":\"%s\",\"mqtt_level\":\"%s\",\"compiled_level\":\"%s\",\"dropped\":%lu,"
+           "\"forward_dropped\":%lu,\"peak_bytes\":%lu,\"buffer_bytes\":%lu}",
+           LEVEL_NAMES[serialLevel], LEVEL_NAMES[mqttLevel], LEVEL_NAMES[LOG_COMPILE_LEVEL],
+           (unsigned long)drops, (unsigned long)forwardDrops, (unsigned long)peakUsedBytes,
+           (unsigned long)LOG_BUFFER_SIZE);
+  forwardingLine = true;
+  mqtt_publish_state(STATE_TOPIC_LOG, payload, true);
+  forwardingLine = false;
+  publishedDrops = drops + forwardDrops;
+  lastStatusPublishTime = millis();
+}
+
+// --- Static (Private) Function Implementations ---
+
+#if defined(ARDUINO_ARCH_ESP32)
+/**
+ * @brief The drain task: formats and writes records until the end of time.
+ * @param parameter Unused.
+ */
+static void drain_task(void* parameter) {
+  for (;;) {
+    drain_records();
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+  }
+}
+#endif
+
+/**
+ * @brief Formats every waiting record, writes it to Serial and queues it for MQTT if requested.
+ */
+static void drain_records() {
+  uint8_t record[LOG_MAX_RECORD_SIZE];
+  char line[LOG_LINE_SIZE];
+  for (;;) {
+    uint32_t drops = droppedRecords.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+      int length = snprintf(line, sizeof(line), "[Log] WARN: %lu messages dropped (buffer full).\n",
+                            (unsigned long)(drops - reportedDrops));
+      reportedDrops = drops;
+      Serial.write((const uint8_t*)line, length);
+    }
+
+    size_t size = ring_read(records, record, sizeof(record));
+    if (size == 0) return;
+
+    LogRecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    size_t length = format_record(record, size, line, sizeof(line));
+    if (header.level <= serialLevel) {
+      Serial.write((const uint8_t*)line, length);
+    }
+    if (header.forward && header.level <= mqttLevel) {
+      // Drop the trailing newline and leading blank lines; MQTT messages are lines already.
+      const char* text = line;
+      while (*text == '\n') text++;
+      size_t textLength = length - (text - line);
+      while (textLength > 0 && text[textLength - 1] == '\n') textLength--;
+      if (textLength > 0 && !ring_write(forwarded, text, textLength)) {
+        droppedForwards.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Rebuilds the text of a record from its format string and captured arguments.
+ * @param record The record, header included.
+ * @param size The record size.
+ * @param line The destination.
+ * @param lineSize The size of `line`.
+ * @return The length of the text in `line`.
+ */
+static size_t format_record(const uint8_t* record, size_t size, char* line, size_t lineSize) {
+  LogRecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  const uint8_t* arg = record + sizeof(header);
+  const uint8_t* end = record + size;
+
+  size_t length = 0;
+  const char* f = header.format;
+  while (*f && length + 1 < lineSize) {
+    if (*f != '%') {
+      line[length++] = *f++;
+      continue;
+    }
+    if (f[1] == '%') {
+      line[length++] = '%';
+      f += 2;
+      continue;
+    }
+
+    // Copy the conversion specification, e.g. "%-8.2f", without length modifiers.
+    char spec[16];
+    size_t specLength = 0;
+    spec[specLength++] = *f++;
+    int starValues[2];
+    int stars = 0;
+    while (*f && strchr("-+ #0123456789.*", *f)) {
+      if (*f == '*' && stars < 2) {
+        int64_t value = 0;
+        if (arg < end && (*arg == 'i' || *arg == 'u')) memcpy(&value, arg + 1, sizeof(value));
+        if (arg < end) arg += 1 + sizeof(int64_t);
+        starValues[stars++] = (int)value;
+      }
+      if (specLength < sizeof(spec) - 4) spec[specLength++] = *f;
+      f++;
+    }
+    while (*f && strchr("hljztL", *f)) f++;
+    char conversion = *f ? *f++ : 's';
+
+    // Fetch the captured argument; a missing one formats as zero or an empty string.
+    uint8_t tag = arg < end ? *arg : 0;
+    int64_t integer = 0;
+    uint64_t unsignedInteger = 0;
+    double real = 0;
+    const char* text = "";
+    char textBuffer[256];
+    if (tag == 'i' || tag == 'u' || tag == 'd' || tag == 'p') {
+      if (tag == 'i') memcpy(&integer, arg + 1, sizeof(integer));
+      if (tag == 'u' || tag == 'p') memcpy(&unsignedInteger, arg + 1, sizeof(unsignedInteger));
+      if (tag == 'd') memcpy(&real, arg + 1, sizeof(real));
+      if (tag == 'i') { unsignedInteger = (uint64_t)integer; real = (double)integer; }
+      if (tag == 'u' || tag == 'p') { integer = (int64_t)unsignedInteger; real = (double)unsignedInteger; }
+      if (tag == 'd') { integer = (int64_t)real; unsignedInteger = (uint64_t)integer; }
+      arg += 1 + 8;
+    } else if (tag == 's') {
+      size_t textLength = arg[1];
+      memcpy(textBuffer, arg + 2, textLength);
+      textBuffer[textLength] = '\0';
+      text = textBuffer;
+      arg += 2 + textLength;
+    } else if (tag == 'n') {
+      text = "(null)";
+      arg += 1;
+    }
+
+    char* out = line + length;
+    size_t room = lineSize - length;
+    int written = 0;
+    switch (conversion) {
+      case 'd': case 'i':
+        spec[specLength++] = 'l'; spec[specLength++] = 'l'; spec[specLength++] = conversion; spec[specLength] = '\0';
+        written = stars == 2 ? snprintf(out, room, spec, starValues[0], starValues[1], (long long)integer)
+                : stars == 1 ? snprintf(out, room, spec, starValues[0], (long long)integer)
+                             : snprintf(out, room, spec, (long long)integer);
+        break;
+      case 'u': case 'x': case 'X': case 'o':
+        spec[specLength++] = 'l'; spec[specLength++] = 'l'; spec[specLength++] = conversion; spec[specLength] = '\0';
+        written = stars == 2 ? snprintf(out, room, spec, starValues[0], starValues[1], (unsigned long long)unsignedInteger)
+                : stars == 1 ? snprintf(out, room, spec, starValues[0], (unsigned long long)unsignedInteger)
+                             : snprintf(out, room, spec, (unsigned long long)unsignedInteger);
+        break;
+      case 'c':
+        spec[specLength++] = 'c'; spec[specLength] = '\0';
+        written = snprintf(out, room, spec, (int)integer);
+        break;
+      case 'p':
+        written = snprintf(out, room, "0x%llx", (unsigned long long)unsignedInteger);
+        break;
+      case 's':
+        spec[specLength++] = 's'; spec[specLength] = '\0';
+        written = stars == 2 ? snprintf(out, room, spec, starValues[0], starValues[1], text)
+                : stars == 1 ? snprintf(out, room, spec, starValues[0], text)
+                             : snprintf(out, room, spec, text);
+        break;
+      default: { // f, e, g, a and their upper-case forms, all written as f
+        // By number_format_fixed(), so that no log line needs newlib's float printf.
+        // The precision (6 if none) is cut to the most it supports.
+        const char* dot = (const char*)memchr(spec, '.', specLength);
+        int decimals = dot == nullptr ? 6 : dot[1] == '*' ? starValues[stars - 1] : atoi(dot + 1);
+        if (decimals < 0) decimals = 6;
+        char number[24];
+        if (number_format_fixed(number, sizeof(number), (float)real,
+                                (uint8_t)min(decimals, (int)NUMBER_FORMAT_MAX_DECIMALS)) == 0) {
+          // Beyond its range, where the integer part is enough.
+          snprintf(number, sizeof(number), "%lld", (long long)constrain(real, -9e18, 9e18));
+        }
+        // The flags and width apply to the number as text.
+        int widthStars = stars - (dot != nullptr && dot[1] == '*');
+        if (dot != nullptr) specLength = dot - spec;
+        spec[specLength++] = 's'; spec[specLength] = '\0';
+        written = widthStars == 1 ? snprintf(out, room, spec, starValues[0], number) : snprintf(out, room, spec, number);
+        break;
+      }
+    }
+    if (written > 0) length += min((size_t)written, room - 1);
+  }
+  line[length] = '\0';
+  return length;
+}
+
+/**
+ * @brief Appends an entry, or nothing if it does not fit.
+ * Producer side: only ever called by one task per ring.
+ * @return true if the entry was written.
+ */
+static bool ring_write(ByteRing& ring, const void* entry, size_t size) {
+  uint32_t head = ring.head.load(std::memory_order_relaxed);
+  uint32_t tail = ring.tail.load(std::memory_order_acquire);
+  uint16_t prefix = (uint16_t)size;
+  if (ring.size - (head - tail) < sizeof(prefix) + size) return false;
+
+  ring_copy_in(ring, head, (const uint8_t*)&prefix, sizeof(prefix));
+  ring_copy_in(ring, head + sizeof(prefix), (const uint8_t*)entry, size);
+  ring.head.store(head + sizeof(prefix) + size, std::memory_order_release);
+  return true;
+}
+
+/**
+ * @brief Removes the oldest entry.
+ * Consumer side: only ever called by one task per ring.
+ * @return The number of bytes copied to `out` (longer entries are cut), or 0 if the ring is empty.
+ */
+static size_t ring_read(ByteRing& ring, uint8_t* out, size_t outSize) {
+  uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+  uint32_t head = ring.head.load(std::memory_order_acquire);
+  if (head == tail) return 0;
+
+  uint16_t prefix;
+  ring_copy_out(ring, tail, (uint8_t*)&prefix, sizeof(prefix));
+  size_t copied = min((size_t)prefix, outSize);
+  ring_copy_out(ring, tail + sizeof(prefix), out, copied);
+  ring.tail.store(tail + sizeof(prefix) + prefix, std::memory_order_release);
+  return copied;
+}
+
+/**
+ * @brief Copies bytes into a ring, handling the wrap-around.
+ */
+static void ring_copy_in(ByteRing& ring, uint32_t to, const uint8_t* in, size_t length) {
+  for (size_t done = 0; done < length;) {
+    uint32_t offset = (to + done) % ring.size;
+    size_t chunk = min(length - done, (size_t)(ring.size - offset));
+    memcpy(ring.data + offset, in + done, chunk);
+    done += chunk;
+  }
+}
+
+/**
+ * @brief Copies bytes out of a ring, handling the wrap-around.
+ */
+static void ring_copy_out(const ByteRing& ring, uint32_t from, uint8_t* out, size_t length) {
+  for (size_t done = 0; done < length;) {
+    uint32_t offset = (from + done) % ring.size;
+    size_t chunk = min(length - done, (size_t)(ring.size - offset));
+    memcpy(out + done, ring.data + offset, chunk);
+    done += chunk;
+  }
+}
+
+/**
+ * @brief Records the most verbose level any output needs.
+ */
+static void update_record_level() {
+  loggerRecordLevel = max(serialLevel, mqttLevel);
+}
+
+/**
+ * @brief Parses a level name, ignoring leading spaces and case.
+ * @return The level, or -1 if the name is unknown.
+ */
+static int parse_level(const char* name) {
+  while (*name == ' ') name++;
+  for (int level = LOG_LEVEL_NONE; level <= LOG_LEVEL_DEBUG; level++) {
+    if (strcasecmp(name, LEVEL_NAMES[level]) == 0) return level;
+  }
+  return -1;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file logger.h
+ * @brief Public interface for the asynchronous, levelled logger.
+ *
+ * A log call does not format anything. It copies the format string pointer,
+ * a timestamp and its arguments in binary form into a lock-free ring buffer,
+ * which costs a few microseconds. A low-priority task on the other core formats
+ * the records and writes them to Serial at whatever pace the UART allows. It
+ * can also forward them to an MQTT debug topic. When the buffer is full,
+ * records are dropped and counted; nothing ever blocks the control loop.
+ *
+ * Levels are filtered twice:
+ *   - at compile time by `LOG_COMPILE_LEVEL` (DEBUG with `DEBUG_MODE`,
+ *     otherwise INFO), which removes the call entirely;
+ *   - at run time by the Serial and MQTT levels, which can be changed over
+ *     MQTT.
+ *
+ * Only the loop task may log. Records from any other task are dropped and
+ * counted, because the ring has a single producer.
+ *
+ * Float arguments are written with `number_format_fixed()`, never with float
+ * printf: `%e`, `%g` and `%a` print as `%f`, with at most four decimals.
+ */
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Numeric so that they can be compared in `#if`.
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_COMPILE_LEVEL
+  #if defined(DEBUG_MODE)
+    #define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+  #else
+    #define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+  #endif
+#endif
+
+/// @brief The most verbose level recorded at run time (the larger of the Serial and MQTT levels).
+extern uint8_t loggerRecordLevel;
+
+/// @brief Logs at `level` if it passes the run-time filter. Arguments are not evaluated otherwise.
+#define LOG_AT(level, ...) \
+  do { if ((level) <= loggerRecordLevel) logger_write((level), __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+  #define LOG_ERROR(...) (void)0
+#endif
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+  #define LOG_WARN(...) (void)0
+#endif
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+  #define LOG_INFO(...) (void)0
+#endif
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+  #define LOG_DEBUG(...) (void)0
+#endif
+
+/// @brief The largest record, header included. Longer string arguments are truncated.
+const size_t LOG_MAX_RECORD_SIZE = 200;
+
+/**
+ * @struct LogRecord
+ * @brief A log record being assembled on the caller's stack.
+ */
+struct LogRecord {
+  uint8_t data[LOG_MAX_RECORD_SIZE];
+  size_t size;
+
+  void add_integer(int64_t value) { add_tagged('i', &value, sizeof(value)); }
+  void add_unsigned(uint64_t value) { add_tagged('u', &value, sizeof(value)); }
+  void add_double(double value) { add_tagged('d', &value, sizeof(value)); }
+  void add_pointer(const void* value) {
+    uint64_t address = (uintptr_t)value;
+    add_tagged('p', &address, sizeof(address));
+  }
+  void add_string(const char* value) {
+    if (value == nullptr) {
+      add_tagged('n', nullptr, 0);
+      return;
+    }
+    if (size + 2 > sizeof(data)) return;
+    size_t length = strlen(value);
+    size_t room = sizeof(data) - size - 2;
+    if (length > room) length = room;
+    if (length > 255) length = 255;
+    data[size++] = 's';
+    data[size++] = (uint8_t)length;
+    memcpy(data + size, value, length);
+    size += length;
+  }
+
+private:
+  void add_tagged(uint8_t tag, const void* value, size_t length) {
+    if (size + 1 + length > sizeof(data)) return;
+    data[size++] = tag;
+    if (length) memcpy(data + size, value, length);
+    size += length;
+  }
+};
+
+// Argument capture: every printf argument type maps to one of the record's tags.
+inline void logger_add(LogRecord& r, bool v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, char v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, signed char v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, unsigned char v) { r.add_unsigned(v); }
+inline void logger_add(LogRecord& r, short v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, unsigned short v) { r.add_unsigned(v); }
+inline void logger_add(LogRecord& r, int v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, unsigned int v) { r.add_unsigned(v); }
+inline void logger_add(LogRecord& r, long v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, unsigned long v) { r.add_unsigned(v); }
+inline void logger_add(LogRecord& r, long long v) { r.add_integer(v); }
+inline void logger_add(LogRecord& r, unsigned long long v) { r.add_unsigned(v); }
+inline void logger_add(LogRecord& r, float v) { r.add_double(v); }
+inline void logger_add(LogRecord& r, double v) { r.add_double(v); }
+inline void logger_add(LogRecord& r, const char* v) { r.add_string(v); }
+inline void logger_add(LogRecord& r, const void* v) { r.add_pointer(v); }
+
+inline void logger_add_all(LogRecord& r) {}
+
+template <typename T, typename... Rest>
+inline void logger_add_all(LogRecord& r, T first, Rest... rest) {
+  logger_add(r, first);
+  logger_add_all(r, rest...);
+}
+
+/**
+ * @brief Starts a record: writes the header for a message at `level`.
+ * @param record The record to start.
+ * @param level The message level.
+ * @param format The printf format string. Must be a string literal: only the pointer is kept.
+ */
+void logger_begin(LogRecord& record, uint8_t level, const char* format);
+
+/**
+ * @brief Appends a finished record to the ring buffer, or counts it as dropped.
+ * @param record The record.
+ */
+void logger_commit(LogRecord& record);
+
+/**
+ * @brief Records a printf-style message. Use the `LOG_*` macros instead of calling this.
+ * @param level The message level.
+ * @param format The format string literal.
+ * @param args The arguments, captured by value; strings are copied.
+ */
+template <typename... Args>
+void logger_write(uint8_t level, const char* format, Args... args) {
+  LogRecord record;
+  logger_begin(record, level, format);
+  logger_add_all(record, args...);
+  logger_commit(record);
+}
+
+/**
+ * @brief Writes a line of data for a machine, such as a trace (see trace.h), to
+ * Serial in order with the log. It is written whatever the Serial level and
+ * never forwarded to MQTT.
+ * @param line The line, newline included; cut to fit a record.
+ */
+void logger_write_data(const char* line);
+
+/**
+ * @brief Starts the drain task. Call once, early in `setup()`, from the loop task.
+ * Messages logged before this are kept and written once the task runs.
+ */
+void logger_init();
+
+/**
+ * @brief Publishes forwarded lines to MQTT and the logger status when it changed.
+ * Call from the main loop. In the native simulator, which has no tasks, it also
+ * drains the ring buffer.
+ */
+void logger_loop();
+
+/**
+ * @brief Waits until every recorded message has been written to Serial.
+ * Call before a deliberate restart so its reason is not lost.
+ * @param timeoutMs The longest time to wait.
+ */
+void logger_flush(unsigned long timeoutMs);
+
+/**
+ * @brief Handles a command from the logger control topic.
+ * "<LEVEL>" sets the Serial level and "MQTT <LEVEL>" the forwarding level, where
+ * LEVEL is NONE, ERROR, WARN, INFO or DEBUG. Levels above `LOG_COMPILE_LEVEL`
+ * have no effect beyond it.
+ * @param command The command payload.
+ */
+void logger_handle_command(const char* command);
+
+/**
+ * @brief Publishes the logger's levels, drop count and buffer high-water mark.
+ */
+void logger_publish_status();
+
+#endif // LOGGER_H
@@ -9,43 +9,81 @@
 
 #include "config.h"
 #include <WiFi.h>
+#include "identity.h"
 #include "sensors.h"
 #include "mqtt_handler.h"
 #include "actuators.h"
+#include "storage.h"
+#include "diagnostics.h"
+#include "boot_metrics.h"
+#include "watchdog.h"
+#include "command_ack.h"
+#include "sensor_stats.h"
+#include "history.h"
+#include "metrics_server.h"
+#include "ota.h"
+#include "mqtt_tls.h"
+#include "trace.h"
+#include "probe_calibration.h"
 
 // --- Global Variables ---
 
 /// @brief A global struct to hold the most recent sensor readings.
 static SensorValues currentSensorValues;
-/// @brief Tracks the last time sensor data was published to MQTT to manage timing.
+/// @brief Tracks the last time the sensors were read to manage timing.
 static unsigned long lastSensorPublishTime = 0;
+/// @brief Tracks the last time raw sensor readings were queued for publishing.
+static unsigned long lastRawPublishTime = 0;
 /// @brief Tracks the last time a heartbeat was sent to MQTT.
 static unsigned long lastHeartbeatTime = 0;
-/// @brief Tracks the last time actuator states were published to MQTT.
-static unsigned long lastActuatorStatePublishTime = 0;
-/// @brief Tracks the last time automation states were published to MQTT.
-static unsigned long lastAutomationStatePublishTime = 0;
+/// @brief Tracks the last time the actuator snapshot was published to MQTT.
+static unsigned long lastActuatorSnapshotTime = 0;
+/// @brief Tracks the last high-rate power sample taken while a pump runs.
+static unsigned long lastPowerSampleTime = 0;
+/// @brief Set when raw sensor readings are due but not yet published (e.g. because MQTT was down).
+static bool sensorDataPending = false;
+/// @brief Whether WiFi was connected at the last check.
+static bool wifiConnected = false;
+/// @brief When the current WiFi outage began (or WiFi was started).
+static unsigned long wifiDownSince = 0;
 
 // --- Forward Declarations ---
-static void connectToWifi();
+static void startWifi();
+static void superviseWifi(unsigned long currentTime);
 
 /**
  * @brief The main setup function, run once on boot.
- * Initializes the serial monitor, all hardware modules (sensors, actuators),
- * connects to WiFi, and initializes the MQTT client.
+ * Drives the actuators to their safe state and starts the sensors first, then
+ * starts WiFi without waiting for it, so that sensing, alerts and overflow
+ * protection run from the first loop iteration while the network comes up.
  */
 void setup() {
   Serial.begin(115200);
-  // A small delay to allow the serial monitor to connect.
-  delay(1000); 
-  LOG_PRINTLN("\n--- ESP32 Hydroponic System Initializing ---");
-
+  logger_init(); // Buffered: nothing is lost while the serial monitor attaches.
+  LOG_INFO("\n--- ESP32 Hydroponic System Initializing ---\n");
+  boot_metrics_begin();
+  identity_init(); // Instance ID, credentials and thresholds; sets every MQTT topic.
+
+  storage_init();
+  ota_init(); // Counts the boot of an updated image on trial.
+  history_init();
+  actuators_init(); // Relays OFF, persisted mode and automation switches restored.
+  boot_metrics_mark(BOOT_ACTUATORS_SAFE);
+  trace_init(); // Resumes recording the control trace if it was on.
+  watchdog_init(actuators_output_pin_mask());
   sensors_init();
-  actuators_init();
-  connectToWifi();
+  sensor_stats_init();
+  boot_metrics_mark(BOOT_SENSORS_READY);
+  startWifi();
+  command_ack_init(); // SNTP; keeps retrying in the background until the network is up.
+  mqtt_tls_init(); // Trust anchors parsed once, not on every reconnect.
   mqtt_init();
 
-  LOG_PRINTLN("\n--- System Initialization Complete. Starting main loop. ---\n");
+  // Read the sensors in the first loop iteration instead of one interval from now.
+  lastSensorPublishTime = millis() - SENSOR_PUBLISH_INTERVAL_MS;
+  lastRawPublishTime = millis() - SENSOR_RAW_PUBLISH_INTERVAL_MS;
+  boot_metrics_mark(BOOT_SETUP_DONE);
+  LOG_INFO("\n--- System Initialization Complete. Starting main loop. ---\n\n");
 }
 
 /**
@@ -54,26 +92,66 @@ void setup() {
  * and MQTT, and triggers timed actions like reading sensors and sending heartbeats.
  */
 void loop() {
+  DIAG_LOOP();
+  watchdog_loop(); // Feeds the watchdog; the network phase starts here.
   unsigned long currentTime = millis();
 
-  // Ensure WiFi is connected before proceeding.
-  if (WiFi.status() != WL_CONNECTED) {
-    connectToWifi();
-  }
+  // The network may come and go; control below never waits for it.
+  superviseWifi(currentTime);
 
   // Run the loop functions for each module. These are non-blocking.
   mqtt_loop();
+  metrics_server_loop(currentSensorValues);
+  watchdog_enter(LOOP_PHASE_CONTROL);
   actuators_loop(currentSensorValues);
+  trace_outputs();
+  storage_loop();
+  history_loop();
+  trace_loop();
+  logger_loop();
+  ota_loop();
+  probe_calibration_loop(currentSensorValues);
 
   // --- Timed Actions using a non-blocking approach ---
 
-  // Periodically read sensors and publish the data.
+  // While a pump relay is energized, poll the power meter at its maximum rate so
+  // dry runs, blockages and failed relays are caught within a second.
+  if (actuators_power_monitor_active() && currentTime - lastPowerSampleTime >= PUMP_MONITOR_SAMPLE_INTERVAL_MS) {
+    lastPowerSampleTime = currentTime;
+    watchdog_enter(LOOP_PHASE_POWER_SAMPLE);
+    sensors_read_power(currentSensorValues);
+    trace_power(currentSensorValues);
+    actuators_handle_power_sample(currentSensorValues);
+    trace_outputs();
+  }
+
+  // Periodically read sensors; summaries are published as their windows close, raw readings at a lower rate.
   if (currentTime - lastSensorPublishTime >= SENSOR_PUBLISH_INTERVAL_MS) {
     lastSensorPublishTime = currentTime;
+    watchdog_enter(LOOP_PHASE_SENSORS);
 
     sensors_read_all(currentSensorValues);
-    mqtt_publish_sensor_data(currentSensorValues);
+    probe_calibration_mask(currentSensorValues); // A probe in a calibration buffer is not reading the reservoir.
+    if (!isnan(currentSensorValues.waterLevelCm)) boot_metrics_mark(BOOT_FIRST_VALID_READING);
+    trace_sensors(currentSensorValues);
+    actuators_handle_power_sample(currentSensorValues);
     actuators_update_alert_status(currentSensorValues);
+    trace_outputs();
+    if (sensor_stats_add(currentSensorValues)) boot_metrics_mark(BOOT_FIRST_PUBLISH);
+    history_add(currentSensorValues);
+    if (SENSOR_RAW_PUBLISH_INTERVAL_MS > 0 && currentTime - lastRawPublishTime >= SENSOR_RAW_PUBLISH_INTERVAL_MS) {
+      lastRawPublishTime = currentTime;
+      sensorDataPending = true;
+    }
+  }
+
+  watchdog_enter(LOOP_PHASE_PUBLISH);
+
+  // Publish new readings, including those taken while offline as soon as the broker is back.
+  if (sensorDataPending && mqtt_is_connected()) {
+    sensorDataPending = false;
+    mqtt_publish_sensor_data(currentSensorValues);
+    boot_metrics_mark(BOOT_FIRST_PUBLISH);
   }
 
   // Periodically send a heartbeat to show the device is alive.
@@ -82,48 +160,51 @@ void loop() {
     mqtt_publish_heartbeat();
   }
 
-  // Periodically publish actuator states to keep Home Assistant synchronized.
-  if (currentTime - lastActuatorStatePublishTime >= ACTUATOR_STATE_PUBLISH_INTERVAL_MS) {
-    lastActuatorStatePublishTime = currentTime;
-    actuators_publish_states();
-  }
-
-  // Periodically publish automation states to keep Home Assistant synchronized.
-  if (currentTime - lastAutomationStatePublishTime >= AUTOMATION_STATE_PUBLISH_INTERVAL_MS) {
-    lastAutomationStatePublishTime = currentTime;
-    actuators_publish_automation_states();
+  // State changes are published as they happen; the snapshot is a periodic consistency anchor.
+  if (currentTime - lastActuatorSnapshotTime >= ACTUATOR_SNAPSHOT_INTERVAL_MS) {
+    lastActuatorSnapshotTime = currentTime;
+    actuators_publish_snapshot();
   }
 }
 
 /**
- * @brief Connects to the configured WiFi network.
- * This is a blocking function that will attempt to connect for a configured
- * number of retries. If it fails to connect, it will restart the ESP32
- * to attempt a full re-initialization.
+ * @brief Starts connecting to the configured WiFi network and returns at once.
+ * Association and DHCP run in the WiFi driver's own task while the main loop
+ * already controls the plant; the driver also retries after a lost link.
  */
-static void connectToWifi() {
-  if (WiFi.status() == WL_CONNECTED) {
-    return;
-  }
-
-  LOG_PRINTF("\n[WiFi] Connecting to SSID: %s\n", WIFI_SSID);
+static void startWifi() {
+  LOG_INFO("[WiFi] Connecting to SSID: %s\n", WIFI_SSID);
   WiFi.mode(WIFI_STA); // Set WiFi to station mode
+  WiFi.setAutoReconnect(true);
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  wifiDownSince = millis();
+}
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < MAX_RECONNECT_ATTEMPTS) {
-    LOG_PRINT(".");
-    // This delay is acceptable here as it only occurs during connection setup.
-    delay(WIFI_RECONNECT_DELAY_MS);
-    attempts++;
+/**
+ * @brief Logs WiFi connects and disconnects, and restarts the ESP32 as a last
+ * resort when the network has been unreachable for a long time.
+ * @param currentTime The current `millis()`.
+ */
+static void superviseWifi(unsigned long currentTime) {
+  bool connected = (WiFi.status() == WL_CONNECTED);
+  if (connected != wifiConnected) {
+    wifiConnected = connected;
+    if (connected) {
+      LOG_INFO("[WiFi] Connected! IP Address: %s\n", WiFi.localIP().toString().c_str());
+      boot_metrics_mark(BOOT_WIFI_CONNECTED);
+    } else {
+      LOG_WARN("[WiFi] WARN: Connection lost. Control continues offline.\n");
+      wifiDownSince = currentTime;
+    }
   }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    LOG_PRINTLN("\n[WiFi] Connected!");
-    LOG_PRINTF("[WiFi] IP Address: %s\n", WiFi.localIP().toString().c_str());
-  } else {
-    LOG_PRINTLN("\n[WiFi] Failed to connect after multiple attempts. Restarting...");
-    delay(1000); // Short delay to allow the log message to be sent.
+  // A WiFi stack that never recovers is reset with the whole chip, but never
+  // in the middle of a pump run. Mode and automation switches survive the restart.
+  if (!connected && currentTime - wifiDownSince >= WIFI_RESTART_TIMEOUT_MS && !actuators_power_monitor_active()) {
+    LOG_ERROR("[WiFi] Failed to connect for %ld s. Restarting...\n", WIFI_RESTART_TIMEOUT_MS / 1000);
+    storage_flush_all();
+    history_flush();
+    logger_flush(1000); // Let the log message reach Serial before the restart.
     ESP.restart();
   }
 }
@@ -0,0 +1,467 @@
+/**
+ * @file metrics_server.cpp
+ * @brief Implements the Prometheus metrics endpoint.
+ */
+
+#include "metrics_server.h"
+#include "config.h"
+#include "actuators.h"
+#include "mqtt_handler.h"
+#include "storage.h"
+#include "boot_metrics.h"
+#include "mqtt_tls.h"
+#include "number_format.h" // For printf-free float formatting of sensor values
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <errno.h>
+
+// --- Module-Private (Static) Types & Constants ---
+
+/**
+ * @struct MetricFamily
+ * @brief One metric and how to produce its samples.
+ */
+struct MetricFamily {
+  const char* name;
+  const char* type; ///< "gauge" or "counter".
+  const char* help;
+  /// Writes sample `index` as `{labels} value` or ` value`; returns false past the last sample.
+  bool (*sample)(int index, char* out, size_t size);
+};
+
+/**
+ * @enum ConnectionState
+ * @brief The life cycle of a connection slot.
+ */
+enum ConnectionState { CONN_FREE, CONN_REQUEST, CONN_RESPONSE };
+
+/// @brief Bytes sent per connection and loop iteration; one TCP segment.
+static const size_t CHUNK_SIZE = 536;
+/// @brief How long to wait before trying to listen again after a failure.
+static const unsigned long LISTEN_RETRY_MS = 30000;
+
+/**
+ * @struct MetricsConnection
+ * @brief A connection slot: the socket, the request read so far and the response cursor.
+ */
+struct MetricsConnection {
+  int fd;
+  ConnectionState state;
+  unsigned long acceptedAt;
+  char requestLine[32];  ///< The start of the request line; enough to recognize `GET /metrics`.
+  uint8_t requestLength;
+  bool requestLineDone;
+  uint8_t newlines;      ///< Consecutive line ends seen; two end the request headers.
+  bool found;            ///< Whether the request was for `/metrics`.
+  int family;            ///< The metric family the next line belongs to; -1 for the HTTP header.
+  int item;              ///< The next line of that family; 0 is its HELP and TYPE comments.
+  char out[CHUNK_SIZE];
+  uint16_t outLength;
+  uint16_t outSent;
+};
+
+static const char RESPONSE_HEADER[] =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nConnection: close\r\n\r\n";
+static const char RESPONSE_NOT_FOUND[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\nSee /metrics\n";
+static const char RESPONSE_BUSY[] =
+    "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\nConnection: close\r\n\r\n";
+
+// --- Module-Private (Static) Variables ---
+
+static int listenFd = -1;
+static bool listenAttempted = false;
+static unsigned long lastListenAttempt = 0;
+static MetricsConnection connections[METRICS_MAX_CONNECTIONS];
+/// @brief The readings the sensor samples are taken from; set on every loop call.
+static const SensorValues* latestValues = nullptr;
+static uint32_t scrapesServed = 0;
+static uint32_t requestsNotFound = 0;
+static uint32_t connectionsRejected = 0;
+static uint32_t connectionsTimedOut = 0;
+/// @brief The `kind` label of each TlsHandshakeKind. The TLS families are empty without TLS.
+static const char* const TLS_KINDS[] = {"full", "resumed"};
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void start_listening();
+static void accept_connection();
+static void read_request(MetricsConnection& conn);
+static void write_response(MetricsConnection& conn);
+static void fill_chunk(MetricsConnection& conn);
+static size_t format_line(int family, int item, char* out, size_t size);
+static void close_connection(MetricsConnection& conn);
+static bool would_block();
+static bool sample_sensor(int index, char* out, size_t size);
+static bool sample_pump_on(int index, char* out, size_t size);
+static bool sample_pump_dispensed(int index, char* out, size_t size);
+static bool sample_mode(int index, char* out, size_t size);
+static bool sample_automation(int index, char* out, size_t size);
+static bool sample_queue_length(int index, char* out, size_t size);
+static bool sample_uptime(int index, char* out, size_t size);
+static bool sample_heap_free(int index, char* out, size_t size);
+static bool sample_heap_min_free(int index, char* out, size_t size);
+static bool sample_wifi_rssi(int index, char* out, size_t size);
+static bool sample_mqtt_connected(int index, char* out, size_t size);
+static bool sample_tls_handshakes(int index, char* out, size_t size);
+static bool sample_tls_handshake_time(int index, char* out, size_t size);
+static bool sample_tls_handshake_heap(int index, char* out, size_t size);
+static bool sample_nvs_commits(int index, char* out, size_t size);
+static bool sample_boot_info(int index, char* out, size_t size);
+static bool sample_http_requests(int index, char* out, size_t size);
+
+/// @brief Everything `/metrics` reports, in response order.
+static const MetricFamily METRIC_FAMILIES[] = {
+    {"hidroiot_sensor", "gauge", "Latest sensor reading, in the unit and precision it is published with.",
+     sample_sensor},
+    {"hidroiot_pump_on", "gauge", "Whether the pump relay is energized.", sample_pump_on},
+    {"hidroiot_pump_dispensed_ml_total", "counter", "Volume dispensed by a dosing pump.",
+     sample_pump_dispensed},
+    {"hidroiot_mode", "gauge", "The system mode; the active one is 1.", sample_mode},
+    {"hidroiot_automation_enabled", "gauge", "Whether an automation is switched on.", sample_automation},
+    {"hidroiot_pump_queue_length", "gauge", "Jobs waiting in the pump queue.", sample_queue_length},
+    {"hidroiot_uptime_seconds", "gauge", "Time since boot.", sample_uptime},
+    {"hidroiot_heap_free_bytes", "gauge", "Free heap.", sample_heap_free},
+    {"hidroiot_heap_min_free_bytes", "gauge", "Lowest free heap since boot.", sample_heap_min_free},
+    {"hidroiot_wifi_rssi_dbm", "gauge", "Wi-Fi signal strength.", sample_wifi_rssi},
+    {"hidroiot_mqtt_connected", "gauge", "Whether the MQTT client is connected.", sample_mqtt_connected},
+    {"hidroiot_mqtt_tls_handshakes_total", "counter", "TLS handshakes with the broker, by outcome.",
+     sample_tls_handshakes},
+    {"hidroiot_mqtt_tls_handshake_last_seconds", "gauge", "Duration of the latest TLS handshake of each kind.",
+     sample_tls_handshake_time},
+    {"hidroiot_mqtt_tls_handshake_heap_bytes", "gauge", "Heap the latest TLS handshake of each kind took at its peak.",
+     sample_tls_handshake_heap},
+    {"hidroiot_nvs_commits_total", "counter", "Writes of persisted settings to NVS.", sample_nvs_commits},
+    {"hidroiot_boot_info", "gauge", "Why the chip last reset.", sample_boot_info},
+    {"hidroiot_metrics_requests_total", "counter", "Connections to this endpoint, by outcome.", sample_http_requests},
+};
+static const int NUM_METRIC_FAMILIES = sizeof(METRIC_FAMILIES) / sizeof(METRIC_FAMILIES[0]);
+
+// --- Public Function Implementations ---
+
+void metrics_server_loop(const SensorValues& values) {
+  if (METRICS_HTTP_PORT == 0) return;
+  latestValues = &values;
+  unsigned long now = millis();
+
+  if (listenFd < 0) {
+    if (WiFi.status() == WL_CONNECTED && (!listenAttempted || now - lastListenAttempt >= LISTEN_RETRY_MS)) {
+      start_listening();
+    }
+    return;
+  }
+
+  accept_connection();
+  for (int i = 0; i < METRICS_MAX_CONNECTIONS; i++) {
+    MetricsConnection& conn = connections[i];
+    if (conn.state == CONN_FREE) continue;
+    if (now - conn.acceptedAt >= (unsigned long)METRICS_CONNECTION_TIMEOUT_MS) {
+      connectionsTimedOut++;
+      close_connection(conn);
+    } else if (conn.state == CONN_REQUEST) {
+      read_request(conn);
+    } else {
+      write_response(conn);
+    }
+  }
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Opens the non-blocking listening socket.
+ */
+static void start_listening() {
+  bool firstAttempt = !listenAttempted;
+  listenAttempted = true;
+  lastListenAttempt = millis();
+
+  int fd = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0) return;
+  int reuse = 1;
+  lwip_setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(METRICS_HTTP_PORT);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (lwip_bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      lwip_listen(fd, METRICS_MAX_CONNECTIONS) != 0) {
+    if (firstAttempt) LOG_WARN("[Metrics] WARN: Cannot listen on port %d (errno %d).\n", METRICS_HTTP_PORT, errno);
+    lwip_close(fd);
+    return;
+  }
+  lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  listenFd = fd;
+  LOG_INFO("[Metrics] Serving http://%s:%d/metrics\n", WiFi.localIP().toString().c_str(), METRICS_HTTP_PORT);
+}
+
+/**
+ * @brief Accepts at most one waiting connection, or turns it away when every slot is busy.
+ */
+static void accept_connection() {
+  int fd = lwip_accept(listenFd, nullptr, nullptr);
+  if (fd < 0) return;
+  lwip_fcntl(fd, F_SETFL, lwip_fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  for (int i = 0; i < METRICS_MAX_CONNECTIONS; i++) {
+    MetricsConnection& conn = connections[i];
+    if (conn.state != CONN_FREE) continue;
+    conn.fd = fd;
+    conn.state = CONN_REQUEST;
+    conn.acceptedAt = millis();
+    conn.requestLength = 0;
+    conn.requestLineDone = false;
+    conn.newlines = 0;
+    return;
+  }
+  // Best effort: if the send buffer cannot take it, the client just sees the connection close.
+  lwip_send(fd, RESPONSE_BUSY, sizeof(RESPONSE_BUSY) - 1, MSG_DONTWAIT);
+  lwip_close(fd);
+  connectionsRejected++;
+}
+
+/**
+ * @brief Reads what has arrived of the request. Everything up to the blank line
+ * that ends the headers is consumed, so closing the socket later does not reset it.
+ * @param conn The connection.
+ */
+static void read_request(MetricsConnection& conn) {
+  char buffer[64];
+  int received = lwip_recv(conn.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+  if (received == 0 || (received < 0 && !would_block())) {
+    close_connection(conn); // The client went away.
+    return;
+  }
+  for (int i = 0; i < received; i++) {
+    char c = buffer[i];
+    if (c == '\n') {
+      conn.requestLineDone = true;
+      if (++conn.newlines == 2) break;
+    } else if (c != '\r') {
+      conn.newlines = 0;
+      if (!conn.requestLineDone && conn.requestLength < sizeof(conn.requestLine) - 1) {
+        conn.requestLine[conn.requestLength++] = c;
+      }
+    }
+  }
+  if (conn.newlines < 2) return;
+
+  conn.requestLine[conn.requestLength] = '\0';
+  const char* target = "GET /metrics";
+  size_t targetLength = strlen(target);
+  conn.found = strncmp(conn.requestLine, target, targetLength) == 0 &&
+               (conn.requestLine[targetLength] == ' ' || conn.requestLine[targetLength] == '?');
+  conn.state = CONN_RESPONSE;
+  conn.family = -1;
+  conn.item = 0;
+  conn.outLength = 0;
+  conn.outSent = 0;
+}
+
+/**
+ * @brief Sends the rest of the current chunk, generating the next one when it is gone.
+ * Closes the connection after the last chunk.
+ * @param conn The connection.
+ */
+static void write_response(MetricsConnection& conn) {
+  if (conn.outSent == conn.outLength) {
+    if (conn.family >= NUM_METRIC_FAMILIES) {
+      if (conn.found) scrapesServed++;
+      else requestsNotFound++;
+      close_connection(conn);
+      return;
+    }
+    fill_chunk(conn);
+  }
+  int sent = lwip_send(conn.fd, conn.out + conn.outSent, conn.outLength - conn.outSent, MSG_DONTWAIT);
+  if (sent < 0) {
+    if (!would_block()) close_connection(conn);
+    return;
+  }
+  conn.outSent += sent;
+}
+
+/**
+ * @brief Generates as many whole lines of the response as fit the connection's buffer.
+ * @param conn The connection.
+ */
+static void fill_chunk(MetricsConnection& conn) {
+  conn.outLength = 0;
+  conn.outSent = 0;
+  if (conn.family < 0) {
+    const char* header = conn.found ? RESPONSE_HEADER : RESPONSE_NOT_FOUND;
+    conn.outLength = strlen(header);
+    memcpy(conn.out, header, conn.outLength);
+    conn.family = conn.found ? 0 : NUM_METRIC_FAMILIES;
+  }
+  char line[192];
+  while (conn.family < NUM_METRIC_FAMILIES) {
+    size_t length = format_line(conn.family, conn.item, line, sizeof(line));
+    if (length == 0) {
+      conn.family++;
+      conn.item = 0;
+      continue;
+    }
+    if (conn.outLength + length > sizeof(conn.out)) break;
+    memcpy(conn.out + conn.outLength, line, length);
+    conn.outLength += length;
+    conn.item++;
+  }
+}
+
+/**
+ * @brief Formats one line of a metric family.
+ * @param family The family's index in METRIC_FAMILIES.
+ * @param item 0 for the HELP and TYPE comments, then one per sample.
+ * @param out The destination.
+ * @param size The size of `out`.
+ * @return The length of the line, or 0 past the family's last sample.
+ */
+static size_t format_line(int family, int item, char* out, size_t size) {
+  const MetricFamily& metric = METRIC_FAMILIES[family];
+  int length;
+  if (item == 0) {
+    length = snprintf(out, size, "# HELP %s %s\n# TYPE %s %s\n", metric.name, metric.help, metric.name, metric.type);
+  } else {
+    char sample[96];
+    if (!metric.sample(item - 1, sample, sizeof(sample))) return 0;
+    length = snprintf(out, size, "%s%s\n", metric.name, sample);
+  }
+  return length < 0 ? 0 : min((size_t)length, size - 1);
+}
+
+static void close_connection(MetricsConnection& conn) {
+  lwip_close(conn.fd);
+  conn.fd = -1;
+  conn.state = CONN_FREE;
+}
+
+static bool would_block() {
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+static bool sample_sensor(int index, char* out, size_t size) {
+  if (index >= SENSOR_NUM_FIELDS) return false;
+  const SensorField& field = SENSOR_FIELDS[index];
+  char value[16];
+  if (isnan(latestValues->*field.value) ||
+      number_format_fixed(value, sizeof(value), latestValues->*field.value, field.decimals) == 0) {
+    strcpy(value, "NaN");
+  }
+  snprintf(out, size, "{sensor=\"%s\"} %s", field.key, value);
+  return true;
+}
+
+static bool sample_pump_on(int index, char* out, size_t size) {
+  PumpStatus pump;
+  if (!actuators_get_pump_status(index, pump)) return false;
+  snprintf(out, size, "{pump=\"%s\"} %d", pump.key, pump.isOn ? 1 : 0);
+  return true;
+}
+
+static bool sample_pump_dispensed(int index, char* out, size_t size) {
+  // The other pumps would only report a constant 0; `index` counts the dosing pumps.
+  PumpStatus pump;
+  for (int i = 0; actuators_get_pump_status(i, pump); i++) {
+    if (!pump.dosing || index-- > 0) continue;
+    char value[16];
+    number_format_fixed(value, sizeof(value), pump.dispensedMl, 1);
+    snprintf(out, size, "{pump=\"%s\"} %s", pump.key, value);
+    return true;
+  }
+  return false;
+}
+
+static bool sample_mode(int index, char* out, size_t size) {
+  static const char* const MODES[] = {"NUTRITION", "CLEANER"};
+  if (index >= 2) return false;
+  snprintf(out, size, "{mode=\"%s\"} %d", MODES[index], strcmp(actuators_mode_name(), MODES[index]) == 0 ? 1 : 0);
+  return true;
+}
+
+static bool sample_automation(int index, char* out, size_t size) {
+  static const char* const NAMES[] = {"dosing", "refill", "irrigation"};
+  const bool enabled[] = {automation_state.auto_dosing_enabled, automation_state.auto_refill_enabled,
+                          automation_state.auto_irrigation_enabled};
+  if (index >= 3) return false;
+  snprintf(out, size, "{automation=\"%s\"} %d", NAMES[index], enabled[index] ? 1 : 0);
+  return true;
+}
+
+static bool sample_queue_length(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %d", actuators_queue_length());
+  return true;
+}
+
+static bool sample_uptime(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %lu", millis() / 1000);
+  return true;
+}
+
+static bool sample_heap_free(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %u", (unsigned)ESP.getFreeHeap());
+  return true;
+}
+
+static bool sample_heap_min_free(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %u", (unsigned)ESP.getMinFreeHeap());
+  return true;
+}
+
+static bool sample_wifi_rssi(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %d", (int)WiFi.RSSI());
+  return true;
+}
+
+static bool sample_mqtt_connected(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %d", mqtt_is_connected() ? 1 : 0);
+  return true;
+}
+
+static bool sample_tls_handshakes(int index, char* out, size_t size) {
+  if (!mqtt_tls_enabled() || index > TLS_HANDSHAKE_NUM_KINDS) return false;
+  uint32_t count = index < TLS_HANDSHAKE_NUM_KINDS ? mqtt_tls_stats((TlsHandshakeKind)index).count
+                                                   : mqtt_tls_failures();
+  snprintf(out, size, "{kind=\"%s\"} %u", index < TLS_HANDSHAKE_NUM_KINDS ? TLS_KINDS[index] : "failed",
+           (unsigned)count);
+  return true;
+}
+
+static bool sample_tls_handshake_time(int index, char* out, size_t size) {
+  if (!mqtt_tls_enabled() || index >= TLS_HANDSHAKE_NUM_KINDS) return false;
+  uint32_t ms = mqtt_tls_stats((TlsHandshakeKind)index).lastMs;
+  snprintf(out, size, "{kind=\"%s\"} %u.%03u", TLS_KINDS[index], (unsigned)(ms / 1000), (unsigned)(ms % 1000));
+  return true;
+}
+
+static bool sample_tls_handshake_heap(int index, char* out, size_t size) {
+  if (!mqtt_tls_enabled() || index >= TLS_HANDSHAKE_NUM_KINDS) return false;
+  snprintf(out, size, "{kind=\"%s\"} %u", TLS_KINDS[index],
+           (unsigned)mqtt_tls_stats((TlsHandshakeKind)index).lastHeapBytes);
+  return true;
+}
+
+static bool sample_nvs_commits(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, " %u", (unsigned)storage_commit_count());
+  return true;
+}
+
+static bool sample_boot_info(int index, char* out, size_t size) {
+  if (index > 0) return false;
+  snprintf(out, size, "{reset_reason=\"%s\"} 1", boot_metrics_reset_reason());
+  return true;
+}
+
+static bool sample_http_requests(int index, char* out, size_t size) {
+  static const char* const OUTCOMES[] = {"ok", "not_found", "rejected", "timeout"};
+  const uint32_t counts[] = {scrapesServed, requestsNotFound, connectionsRejected, connectionsTimedOut};
+  if (index >= 4) return false;
+  snprintf(out, size, "{outcome=\"%s\"} %u", OUTCOMES[index], (unsigned)counts[index]);
+  return true;
+}
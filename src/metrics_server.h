@@ -0,0 +1,27 @@
+/**
+ * @file metrics_server.h
+ * @brief Public interface for the Prometheus metrics endpoint.
+ *
+ * Serves `GET /metrics` over plain HTTP on `METRICS_HTTP_PORT` in the
+ * Prometheus text exposition format: the latest sensor readings, pump,
+ * mode and automation states, and runtime figures such as uptime, free heap
+ * and Wi-Fi signal. Requests are handled from the main loop on non-blocking
+ * lwIP sockets. Each response is generated line by line into a fixed
+ * per-connection buffer, and at most one buffer per connection is sent per
+ * loop iteration, so nothing is allocated per scrape and a slow or hostile
+ * client cannot hold up control. At most `METRICS_MAX_CONNECTIONS` are served
+ * at once; further connections are answered with 503 and closed.
+ */
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "sensors.h"
+
+/**
+ * @brief Serves the metrics endpoint. Starts listening once Wi-Fi is up, then
+ * accepts, reads and answers connections a step at a time. Call every loop iteration.
+ * @param values The latest sensor readings.
+ */
+void metrics_server_loop(const SensorValues& values);
+
+#endif // METRICS_SERVER_H
@@ -9,54 +9,220 @@
 #include "mqtt_handler.h"
 #include "config.h"
 #include "actuators.h" // To call actuator functions from MQTT callbacks
+#include "diagnostics.h" // For publish timing
+#include "number_format.h"
+#include "boot_metrics.h"
+#include "command_guard.h"
+#include "history.h"
+#include "ota.h"
+#include "mqtt_tls.h"
+#include "trace.h"
+#include "probe_calibration.h"
 #include <WiFi.h>
 #include <PubSubClient.h>
 
-// --- Module-Private (Static) Variables ---
+// --- Module-Private (Static) Types & Variables ---
 
-/// @brief The underlying WiFi client for the MQTT connection.
-static WiFiClient espClient;
+/**
+ * @class PacketWatchClient
+ * @brief A WiFiClient that follows the MQTT packets PubSubClient reads, for what
+ * PubSubClient does not expose: the session-present flag of the CONNACK, the
+ * RETAIN flag of each PUBLISH, and when the broker acknowledges a subscription.
+ *
+ * Each packet starts with its type and flags, then its remaining length in 1 to
+ * 4 bytes of 7 bits. PubSubClient reads a whole packet before it handles it, so
+ * the flags of a PUBLISH are known when its message reaches the callback. The
+ * bytes are watched after decryption when the connection uses TLS.
+ */
+class PacketWatchClient : public TlsClient {
+public:
+    int connect(IPAddress ip, uint16_t port) override {
+        reset();
+        return TlsClient::connect(ip, port);
+    }
+    int connect(const char* host, uint16_t port) override {
+        reset();
+        return TlsClient::connect(host, port);
+    }
+    int read() override {
+        // The core's read() may itself call read(buffer, 1); count the byte once.
+        reading = true;
+        int c = TlsClient::read();
+        reading = false;
+        if (c >= 0) watch((uint8_t)c);
+        return c;
+    }
+    int read(uint8_t* buffer, size_t size) override {
+        int n = TlsClient::read(buffer, size);
+        for (int i = 0; !reading && i < n; i++) watch(buffer[i]);
+        return n;
+    }
+    /// @brief Whether the broker resumed a stored session on the last connection.
+    bool sessionPresent() const { return connackFlags & 0x01; }
+    /// @brief Whether the broker replayed the message read last instead of forwarding it.
+    bool replayed() const { return publishRetained || awaitingSuback; }
+    /// @brief Counts every message as replayed until the broker acknowledges a subscription.
+    void replayUntilSuback() { awaitingSuback = true; }
+
+private:
+    static const uint8_t TYPE_CONNACK = 0x20;
+    static const uint8_t TYPE_PUBLISH = 0x30;
+    static const uint8_t TYPE_SUBACK = 0x90;
+    enum Stage { STAGE_TYPE, STAGE_LENGTH, STAGE_BODY };
+
+    void reset() {
+        stage = STAGE_TYPE;
+        connackFlags = 0;
+        publishRetained = false;
+        awaitingSuback = false;
+    }
+    void watch(uint8_t c) {
+        switch (stage) {
+        case STAGE_TYPE:
+            header = c;
+            remaining = 0;
+            shift = 0;
+            stage = STAGE_LENGTH;
+            break;
+        case STAGE_LENGTH:
+            remaining |= (uint32_t)(c & 0x7F) << shift;
+            shift += 7;
+            if (c & 0x80) break;
+            if ((header & 0xF0) == TYPE_PUBLISH) publishRetained = header & 0x01;
+            if ((header & 0xF0) == TYPE_SUBACK) awaitingSuback = false;
+            firstBodyByte = true;
+            stage = remaining > 0 ? STAGE_BODY : STAGE_TYPE;
+            break;
+        case STAGE_BODY:
+            // CONNACK: acknowledge flags, return code.
+            if (firstBodyByte && (header & 0xF0) == TYPE_CONNACK) connackFlags = c;
+            firstBodyByte = false;
+            if (--remaining == 0) stage = STAGE_TYPE;
+            break;
+        }
+    }
+    Stage stage = STAGE_TYPE;
+    uint8_t header = 0;
+    uint32_t remaining = 0;
+    uint8_t shift = 0;
+    bool firstBodyByte = false;
+    uint8_t connackFlags = 0;
+    bool publishRetained = false;
+    bool awaitingSuback = false;
+    bool reading = false;
+};
+
+/// @brief The underlying WiFi (and, if configured, TLS) client for the MQTT connection.
+static PacketWatchClient espClient;
 /// @brief The main PubSubClient object for handling MQTT communication.
 static PubSubClient mqttClient(espClient);
-/// @brief Tracks the last time a reconnection attempt was made to prevent spamming.
+/// @brief When the last connection attempt was made, and the backoff delay drawn after it.
 static unsigned long lastMqttReconnectAttempt = 0;
+static unsigned long mqttReconnectDelayMs = 0;
+/// @brief Connection attempts that failed in a row, which sets the backoff ceiling.
+static uint8_t mqttFailedAttempts = 0;
+/// @brief Whether a connection has been attempted since boot.
+static bool mqttReconnectAttempted = false;
+/// @brief Whether the client was connected at the last loop, and when the connection was lost.
+static bool mqttWasConnected = false;
+static unsigned long mqttDisconnectedAt = 0;
+/// @brief Whether this image has subscribed since boot. A session stored by an
+/// earlier image may lack topics this one added, so it is only trusted after that.
+static bool mqttSubscribedSinceBoot = false;
 
 // --- Forward Declarations for Static (Private) Functions ---
 static void mqtt_callback(char* topic, byte* payload, unsigned int length);
 static void mqtt_reconnect();
+static unsigned long mqtt_backoff_delay(uint8_t failures);
 static void subscribe_to_topics();
 
 // --- Public Function Implementations ---
 
 void mqtt_init() {
     mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
+    // The default 256-byte buffer is too small for the JSON status payloads.
+    mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
     mqttClient.setCallback(mqtt_callback);
+    // PubSubClient waits for the CONNACK without returning; its 15 s default would stall the loop that long.
+    mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
 }
 
 void mqtt_loop() {
+    bool connected = mqttClient.connected();
+    if (mqttWasConnected && !connected) {
+        // Every greenhouse loses a restarting broker at the same moment, so even
+        // the first attempt is drawn at random.
+        LOG_WARN("[MQTT] Connection lost, rc=%d.\n", mqttClient.state());
+        mqttDisconnectedAt = millis();
+        lastMqttReconnectAttempt = mqttDisconnectedAt;
+        mqttFailedAttempts = 0;
+        mqttReconnectDelayMs = mqtt_backoff_delay(0);
+    }
+    mqttWasConnected = connected;
+
     // If not connected, and it's time for a new attempt, try to reconnect.
-    if (!mqttClient.connected()) {
+    // Without WiFi there is nothing to try, so the first attempt follows the link at once.
+    // An attempt blocks the loop for up to the TCP, TLS and CONNACK timeouts, so it
+    // waits for a timed run that would end meanwhile, lest the block overrun it. An
+    // open-ended refill is not waited for: it needs the broker for its "OFF".
+    unsigned long blockMs = MQTT_CONNECT_TIMEOUT_MS + MQTT_SOCKET_TIMEOUT_S * 1000UL +
+                            (mqtt_tls_enabled() ? MQTT_TLS_HANDSHAKE_TIMEOUT_MS : 0);
+    if (!connected && WiFi.status() == WL_CONNECTED && !actuators_timed_run_ends_within(blockMs)) {
         unsigned long now = millis();
-        if (now - lastMqttReconnectAttempt >= MQTT_RECONNECT_DELAY_MS) {
+        if (!mqttReconnectAttempted || now - lastMqttReconnectAttempt >= mqttReconnectDelayMs) {
+            mqttReconnectAttempted = true;
             lastMqttReconnectAttempt = now;
             mqtt_reconnect();
+            mqttWasConnected = mqttClient.connected();
         }
     }
     // This is the core of the PubSubClient library, must be called regularly.
     mqttClient.loop();
+    command_guard_loop();
 }
 
 bool mqtt_is_connected() {
     return mqttClient.connected();
 }
 
-void mqtt_publish_state(const std::string& topic, const char* payload, bool retain) {
+void mqtt_route_command(const char* topic, const char* payload) {
+    // Route the command to the correct handler in the actuators module.
+    if (COMMAND_TOPIC_SYSTEM_MODE == topic) {
+        actuators_handle_mode_command(payload);
+    } else if (COMMAND_TOPIC_PUMP_QUEUE == topic) {
+        actuators_handle_queue_command(payload);
+    } else if (COMMAND_TOPIC_PUMP_CALIBRATION == topic) {
+        actuators_handle_calibration_command(payload);
+    } else if (COMMAND_TOPIC_LOG == topic) {
+        logger_handle_command(payload);
+    } else if (COMMAND_TOPIC_HISTORY == topic) {
+        history_handle_command(payload);
+    } else if (COMMAND_TOPIC_OTA == topic) {
+        ota_handle_command(payload);
+    } else if (COMMAND_TOPIC_TRACE == topic) {
+        trace_handle_command(payload);
+    } else if (COMMAND_TOPIC_PROBE_CALIBRATION == topic) {
+        probe_calibration_handle_command(payload);
+    } else if (COMMAND_TOPIC_AUTO_DOSING == topic || 
+               COMMAND_TOPIC_AUTO_REFILL == topic || 
+               COMMAND_TOPIC_AUTO_IRRIGATION == topic) {
+        // Handle automation commands
+        actuators_handle_automation_command(topic, payload);
+    } else {
+        // Assume any other subscribed topic is a pump command.
+        // The actuator module will find the correct pump based on the topic.
+        actuators_handle_pump_command(topic, payload);
+    }
+}
+
+void mqtt_publish_state(const char* topic, const char* payload, bool retain) {
+    DIAG_SCOPE(DIAG_MQTT_PUBLISH);
     if (!mqttClient.connected()) {
-        LOG_PRINTF("[MQTT] WARN: Cannot publish to %s, client not connected.\n", topic.c_str());
+        LOG_DEBUG("[MQTT] Cannot publish to %s, client not connected.\n", topic);
         return;
     }
-    LOG_PRINTF("  [MQTT] Publishing to %s: %s\n", topic.c_str(), payload);
-    mqttClient.publish(topic.c_str(), payload, retain);
+    LOG_DEBUG("  [MQTT] Publishing to %s: %s\n", topic, payload);
+    mqttClient.publish(topic, payload, retain);
 }
 
 void mqtt_publish_heartbeat() {
@@ -69,32 +235,32 @@ void mqtt_publish_sensor_data(const SensorValues &values) {
 
     // Helper lambda to publish a float value or "unavailable" if it's NAN.
     // This avoids code duplication and makes the logic cleaner.
-    auto publish_float = [&](const std::string& topic, float value, const char* format) {
+    auto publish_float = [&](const char* topic, float value, uint8_t decimals) {
         // IMPORTANT: Only publish if the value is a valid number.
         // If the value is NAN (Not-a-Number), we simply do not publish anything.
         // This prevents sending non-numeric strings to topics expecting numbers,
         // which resolves the ValueError in Home Assistant.
-        if (!isnan(value)) {
-            snprintf(payloadBuffer, sizeof(payloadBuffer), format, value);
+        // Same text as "%.<decimals>f", without newlib's slow float printf.
+        if (!isnan(value) && number_format_fixed(payloadBuffer, sizeof(payloadBuffer), value, decimals) > 0) {
             mqtt_publish_state(topic, payloadBuffer, false);
         }
     };
 
-    publish_float(STATE_TOPIC_LEVEL, values.waterLevelCm, "%.1f");
-    publish_float(STATE_TOPIC_DISTANCE, values.waterDistanceCm, "%.0f");
-    publish_float(STATE_TOPIC_WATER_TEMPERATURE, values.waterTempC, "%.2f");
-    publish_float(STATE_TOPIC_AIR_TEMPERATURE, values.airTempC, "%.2f");
-    publish_float(STATE_TOPIC_HUMIDITY, values.airHumidityPercent, "%.2f");
-    publish_float(STATE_TOPIC_TDS, values.tdsPpm, "%.1f");
-    publish_float(STATE_TOPIC_PH, values.phValue, "%.2f");
+    publish_float(STATE_TOPIC_LEVEL, values.waterLevelCm, 1);
+    publish_float(STATE_TOPIC_DISTANCE, values.waterDistanceCm, 0);
+    publish_float(STATE_TOPIC_WATER_TEMPERATURE, values.waterTempC, 2);
+    publish_float(STATE_TOPIC_AIR_TEMPERATURE, values.airTempC, 2);
+    publish_float(STATE_TOPIC_HUMIDITY, values.airHumidityPercent, 2);
+    publish_float(STATE_TOPIC_TDS, values.tdsPpm, 1);
+    publish_float(STATE_TOPIC_PH, values.phValue, 2);
 
     // Publish PZEM-004T data
-    publish_float(STATE_TOPIC_VOLTAGE, values.pzemVoltage, "%.1f");
-    publish_float(STATE_TOPIC_CURRENT, values.pzemCurrent, "%.3f");
-    publish_float(STATE_TOPIC_POWER, values.pzemPower, "%.1f");
-    publish_float(STATE_TOPIC_ENERGY, values.pzemEnergy, "%.3f");
-    publish_float(STATE_TOPIC_FREQUENCY, values.pzemFrequency, "%.1f");
-    publish_float(STATE_TOPIC_PF, values.pzemPowerFactor, "%.2f");
+    publish_float(STATE_TOPIC_VOLTAGE, values.pzemVoltage, 1);
+    publish_float(STATE_TOPIC_CURRENT, values.pzemCurrent, 3);
+    publish_float(STATE_TOPIC_POWER, values.pzemPower, 1);
+    publish_float(STATE_TOPIC_ENERGY, values.pzemEnergy, 3);
+    publish_float(STATE_TOPIC_FREQUENCY, values.pzemFrequency, 1);
+    publish_float(STATE_TOPIC_PF, values.pzemPowerFactor, 2);
 }
 
 void mqtt_publish_alert(const char* alertMessage) {
@@ -111,49 +277,105 @@ void mqtt_publish_alert(const char* alertMessage) {
  */
 static void mqtt_reconnect() {
     if (WiFi.status() != WL_CONNECTED) {
-        LOG_PRINTLN("[MQTT] Cannot reconnect, WiFi is not connected.");
+        LOG_DEBUG("[MQTT] Cannot reconnect, WiFi is not connected.\n");
         return;
     }
 
-    LOG_PRINTF("[MQTT] Attempting to connect to broker at %s:%d...\n", MQTT_SERVER, MQTT_PORT);
+    LOG_INFO("[MQTT] Attempting to connect to broker at %s:%d%s...\n", MQTT_SERVER, MQTT_PORT,
+             mqtt_tls_enabled() ? " over TLS" : "");
     
     // Attempt to connect with Last Will and Testament (LWT).
     // If the device disconnects ungracefully, the broker will automatically
     // publish "Offline" to the availability topic.
+    // The session is persistent (cleanSession = false): the broker keeps the
+    // subscriptions and queues QoS 1 commands while the device is away.
     if (mqttClient.connect(MQTT_CLIENT_ID, MQTT_USERNAME, MQTT_PASSWORD,
-                           AVAILABILITY_TOPIC.c_str(), 1, true, "Offline")) {
-        LOG_PRINTLN("[MQTT] Connection successful!");
+                           AVAILABILITY_TOPIC.c_str(), 1, true, "Offline", false)) {
+        bool resumed = espClient.sessionPresent() && mqttSubscribedSinceBoot;
+        LOG_INFO("[MQTT] Connection successful%s!\n", resumed ? ", session resumed" : "");
+        boot_metrics_mark(BOOT_MQTT_CONNECTED);
+        mqttFailedAttempts = 0;
         
         // Publish "Online" to the LWT topic to show we are connected.
         mqtt_publish_state(AVAILABILITY_TOPIC, "Online", true);
         
-        // Subscribe to all necessary command topics.
-        subscribe_to_topics();
+        // Subscribe to all necessary command topics, unless the broker kept them.
+        // Bare pump commands cannot say when they were sent. The broker sends the
+        // ones it queued through the outage before it acknowledges a subscription,
+        // so after an outage longer than a structured command may live, the device
+        // subscribes again and counts everything before the first SUBACK as replayed.
+        // A broker sends at most its in-flight limit (mosquitto: 20) of a backlog
+        // before that; the rest arrive as live commands, within the rate limit.
+        if (resumed && millis() - mqttDisconnectedAt > (unsigned long)COMMAND_MAX_AGE_MS) {
+            espClient.replayUntilSuback();
+            resumed = false;
+        }
+        if (!resumed) subscribe_to_topics();
 
         // Publish the current state of all actuators to sync with Home Assistant.
         actuators_publish_states();
+        actuators_publish_automation_states();
+        actuators_publish_snapshot();
+        actuators_publish_queue_status();
+        actuators_publish_power_profile();
+        actuators_publish_flow_models();
+        logger_publish_status();
+        command_guard_publish_status();
+        history_publish_status();
+        ota_publish_status();
+        mqtt_tls_publish_status();
+        trace_publish_status();
+        probe_calibration_publish_status();
 
     } else {
-        LOG_PRINTF("[MQTT] Connection failed, rc=%d. Will try again later.\n", mqttClient.state());
+        if (mqttFailedAttempts < UINT8_MAX) mqttFailedAttempts++;
+        mqttReconnectDelayMs = mqtt_backoff_delay(mqttFailedAttempts);
+        LOG_WARN("[MQTT] Connection failed, rc=%d. Will try again in %lu ms.\n", mqttClient.state(),
+                 mqttReconnectDelayMs);
     }
 }
 
+/**
+ * @brief Draws the delay before the next connection attempt ("full jitter"):
+ * uniformly below a ceiling that doubles with every failure, up to
+ * `MQTT_RECONNECT_MAX_DELAY_MS`. Devices that failed together retry apart.
+ * @param failures Connection attempts that failed in a row.
+ * @return The delay in milliseconds.
+ */
+static unsigned long mqtt_backoff_delay(uint8_t failures) {
+    unsigned long ceiling = MQTT_RECONNECT_MIN_DELAY_MS;
+    for (uint8_t i = 1; i < failures && ceiling < (unsigned long)MQTT_RECONNECT_MAX_DELAY_MS; i++) ceiling *= 2;
+    if (ceiling > (unsigned long)MQTT_RECONNECT_MAX_DELAY_MS) ceiling = MQTT_RECONNECT_MAX_DELAY_MS;
+    return (unsigned long)random((long)ceiling + 1);
+}
+
 /**
  * @brief Subscribes to all command topics after a successful connection.
  */
 static void subscribe_to_topics() {
-    LOG_PRINTLN("[MQTT] Subscribing to all command topics...");
-    mqttClient.subscribe(COMMAND_TOPIC_PUMP_A.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_PUMP_B.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_PUMP_PH.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_PUMP_SIRAM.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_PUMP_TANDON.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_SYSTEM_MODE.c_str());
+    LOG_INFO("[MQTT] Subscribing to all command topics...\n");
+    // QoS 1, so the broker queues commands for the session while the device is away.
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_A.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_B.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_PH.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_SIRAM.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_TANDON.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_QUEUE.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PUMP_CALIBRATION.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_SYSTEM_MODE.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_LOG.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_HISTORY.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_OTA.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_TRACE.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_PROBE_CALIBRATION.c_str(), 1);
+    // Chunks are requested again when lost; queued ones would only arrive out of date.
+    mqttClient.subscribe(COMMAND_TOPIC_OTA_DATA.c_str(), 0);
     
     // Subscribe to automation topics
-    mqttClient.subscribe(COMMAND_TOPIC_AUTO_DOSING.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_AUTO_REFILL.c_str());
-    mqttClient.subscribe(COMMAND_TOPIC_AUTO_IRRIGATION.c_str());
+    mqttClient.subscribe(COMMAND_TOPIC_AUTO_DOSING.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_AUTO_REFILL.c_str(), 1);
+    mqttClient.subscribe(COMMAND_TOPIC_AUTO_IRRIGATION.c_str(), 1);
+    mqttSubscribedSinceBoot = true;
 }
 
 /**
@@ -164,27 +386,24 @@ static void subscribe_to_topics() {
  * @param length The length of the payload.
  */
 static void mqtt_callback(char* topic, byte* payload, unsigned int length) {
+    // Firmware update chunks are binary and far too frequent to log.
+    if (COMMAND_TOPIC_OTA_DATA == topic) {
+        ota_handle_data(payload, length);
+        return;
+    }
+
     // Convert payload to a null-terminated string for safe handling.
     char messageBuffer[length + 1];
     memcpy(messageBuffer, payload, length);
     messageBuffer[length] = '\0';
 
-    LOG_PRINTF("\n[MQTT] Command received on topic: %s\n", topic);
-    LOG_PRINTF("  > Payload: %s\n", messageBuffer);
+    // Stale, redundant and excess commands are dropped before they are logged or run.
+    if (!command_guard_admit(topic, messageBuffer, espClient.replayed())) return;
 
-    std::string topic_str(topic);
+    LOG_INFO("\n[MQTT] Command received on topic: %s\n  > Payload: %s\n", topic, messageBuffer);
 
-    // Route the command to the correct handler in the actuators module.
-    if (topic_str == COMMAND_TOPIC_SYSTEM_MODE) {
-        actuators_handle_mode_command(messageBuffer);
-    } else if (topic_str == COMMAND_TOPIC_AUTO_DOSING || 
-               topic_str == COMMAND_TOPIC_AUTO_REFILL || 
-               topic_str == COMMAND_TOPIC_AUTO_IRRIGATION) {
-        // Handle automation commands
-        actuators_handle_automation_command(topic, messageBuffer);
-    } else {
-        // Assume any other subscribed topic is a pump command.
-        // The actuator module will find the correct pump based on the topic.
-        actuators_handle_pump_command(topic, messageBuffer);
-    }
+    // Recorded as admitted, with what it switched, for an offline replay.
+    trace_command(topic, messageBuffer);
+    mqtt_route_command(topic, messageBuffer);
+    trace_outputs();
 }
@@ -31,13 +31,22 @@ void mqtt_loop();
  */
 bool mqtt_is_connected();
 
+/**
+ * @brief Routes a command to its handler in the actuators module.
+ * This is what the MQTT callback runs for every received message; it does not
+ * need a broker connection.
+ * @param topic The topic the command was received on.
+ * @param payload The null-terminated command payload.
+ */
+void mqtt_route_command(const char* topic, const char* payload);
+
 /**
  * @brief Publishes a generic state message to a specific topic.
- * @param topic The destination MQTT topic as a std::string.
+ * @param topic The destination MQTT topic.
  * @param payload The message payload to send as a C-style string.
  * @param retain True to make the message a retained message, false otherwise.
  */
-void mqtt_publish_state(const std::string& topic, const char* payload, bool retain);
+void mqtt_publish_state(const char* topic, const char* payload, bool retain);
 
 /**
  * @brief Publishes a heartbeat message to the designated heartbeat topic.
@@ -0,0 +1,517 @@
+/**
+ * @file mqtt_tls.cpp
+ * @brief Implements the TLS transport of the broker connection on mbedTLS.
+ *
+ * The handshake is driven step by step rather than with
+ * `mbedtls_ssl_handshake()`, so its heap use can be sampled between steps and
+ * the steps can yield to the other tasks while waiting for the broker.
+ *
+ * The pinned key is the SHA-256 of the certificate's SubjectPublicKeyInfo in
+ * DER, the same value as
+ * `openssl x509 -in broker.crt -pubkey -noout | openssl pkey -pubin -outform der | sha256sum`.
+ */
+
+#include "mqtt_tls.h"
+#include "config.h"
+#include "command_ack.h"  // Certificate dates cannot be judged before the clock is set
+#include "mqtt_handler.h"
+#include "ota_patch.h"    // CRC-32 for the RTC session record
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #define MQTT_TLS_AVAILABLE 1
+#elif defined(__has_include)
+  // Native builds run on the simulator's mbedTLS stand-in (lib/hidroiot_sim/src/mbedtls).
+  #if __has_include(<mbedtls/ssl.h>)
+    #define MQTT_TLS_AVAILABLE 1
+  #endif
+#endif
+
+#ifdef MQTT_TLS_AVAILABLE
+  // Only the public mbedTLS 2.x API: the platform is pinned to it in platformio.ini.
+  #include <esp_attr.h>
+  #include <mbedtls/ctr_drbg.h>
+  #include <mbedtls/entropy.h>
+  #include <mbedtls/error.h>
+  #include <mbedtls/net_sockets.h>
+  #include <mbedtls/pk.h>
+  #include <mbedtls/sha256.h>
+  #include <mbedtls/ssl.h>
+#endif
+
+// --- Module-Private (Static) Types & Variables ---
+
+static bool tlsConfigured = false;
+/// @brief The connection the handshake and record layer run over.
+static TlsClient* activeClient = nullptr;
+
+static TlsHandshakeStats handshakeStats[TLS_HANDSHAKE_NUM_KINDS];
+static uint32_t handshakeFailures = 0;
+/// @brief Where the session offered at the next handshake came from: "none", "rtc" or "ram".
+static const char* sessionSource = "none";
+
+#ifdef MQTT_TLS_AVAILABLE
+/**
+ * @struct TlsRtcSession
+ * @brief The last TLS session, serialized, kept across resets in RTC memory.
+ */
+struct TlsRtcSession {
+  uint32_t magic;     ///< TLS_RTC_MAGIC once written.
+  uint32_t trustCrc;  ///< `trust_crc()` when written; another broker or trust anchor invalidates the session.
+  uint32_t length;    ///< Bytes used in `data`.
+  uint32_t dataCrc;
+  uint8_t data[2048]; ///< Fits a ticket and a typical broker certificate, which the session includes.
+};
+
+static const uint32_t TLS_RTC_MAGIC = 0x534C5448; // "HTLS"
+
+static RTC_NOINIT_ATTR TlsRtcSession rtcSession;
+
+/// @brief Whether the trust anchors parsed and the context is set up.
+static bool tlsReady = false;
+/// @brief Whether the current connection completed its handshake.
+static bool tlsOpen = false;
+static mbedtls_entropy_context entropy;
+static mbedtls_ctr_drbg_context drbg;
+static mbedtls_x509_crt caChain;
+static mbedtls_ssl_config sslConfig;
+static mbedtls_ssl_context ssl;
+static mbedtls_ssl_session savedSession;
+static bool haveSavedSession = false;
+static bool haveCa = false;
+static bool havePin = false;
+static uint8_t pinnedKeyHash[32];
+#endif
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool tls_handshake(const char* host);
+#ifdef MQTT_TLS_AVAILABLE
+static void record_handshake(TlsHandshakeKind kind, uint32_t ms, uint32_t heapBytes);
+static uint32_t trust_crc();
+static bool tls_setup();
+static bool parse_pin(const char* hex);
+static int verify_certificate(void* context, mbedtls_x509_crt* crt, int depth, uint32_t* flags);
+static int bio_send(void* context, const unsigned char* buffer, size_t length);
+static int bio_recv(void* context, unsigned char* buffer, size_t length);
+static void save_session();
+static void restore_rtc_session();
+static void log_mbedtls_error(const char* what, int ret);
+#endif
+
+// --- Public Function Implementations ---
+
+void mqtt_tls_init() {
+  tlsConfigured = (MQTT_TLS_CA_CERT != nullptr && MQTT_TLS_CA_CERT[0] != '\0') || MQTT_TLS_PUBKEY_SHA256[0] != '\0';
+  if (!tlsConfigured) return;
+#ifdef MQTT_TLS_AVAILABLE
+  tlsReady = tls_setup();
+  if (tlsReady && MQTT_TLS_SESSION_IN_RTC) restore_rtc_session();
+#else
+  LOG_ERROR("[TLS] ERROR: TLS is configured but not available in this build; the broker cannot be reached.\n");
+#endif
+}
+
+bool mqtt_tls_enabled() {
+  return tlsConfigured;
+}
+
+const TlsHandshakeStats& mqtt_tls_stats(TlsHandshakeKind kind) {
+  return handshakeStats[kind];
+}
+
+uint32_t mqtt_tls_failures() {
+  return handshakeFailures;
+}
+
+void mqtt_tls_publish_status() {
+  if (!tlsConfigured) return;
+  const TlsHandshakeStats& full = handshakeStats[TLS_HANDSHAKE_FULL];
+  const TlsHandshakeStats& resumed = handshakeStats[TLS_HANDSHAKE_RESUMED];
+  char payload[320];
+  snprintf(payload, sizeof(payload),
+           "{\"full\":{\"count\":%u,\"last_ms\":%u,\"max_ms\":%u,\"last_heap\":%u,\"max_heap\":%u},"
+           "\"resumed\":{\"count\":%u,\"last_ms\":%u,\"max_ms\":%u,\"last_heap\":%u,\"max_heap\":%u},"
+           "\"failed\":%u,\"session\":\"%s\"}",
+           full.count, full.lastMs, full.maxMs, full.lastHeapBytes, full.maxHeapBytes, resumed.count, resumed.lastMs,
+           resumed.maxMs, resumed.lastHeapBytes, resumed.maxHeapBytes, handshakeFailures, sessionSource);
+  mqtt_publish_state(STATE_TOPIC_TLS, payload, true);
+}
+
+// --- TlsClient ---
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+  if (!WiFiClient::connect(ip, port, MQTT_CONNECT_TIMEOUT_MS)) return 0;
+  if (!tlsConfigured) return 1;
+  activeClient = this;
+  // Without a host name only the chain (or the pin) is checked, not the name.
+  if (tls_handshake(nullptr)) return 1;
+  WiFiClient::stop();
+  return 0;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+  if (!WiFiClient::connect(host, port, MQTT_CONNECT_TIMEOUT_MS)) return 0;
+  if (!tlsConfigured) return 1;
+  activeClient = this;
+  if (tls_handshake(host)) return 1;
+  WiFiClient::stop();
+  return 0;
+}
+
+size_t TlsClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buffer, size_t size) {
+  if (!tlsConfigured) return WiFiClient::write(buffer, size);
+#ifdef MQTT_TLS_AVAILABLE
+  size_t written = 0;
+  while (tlsOpen && written < size) {
+    int ret = mbedtls_ssl_write(&ssl, buffer + written, size - written);
+    if (ret > 0) {
+      written += ret;
+    } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      log_mbedtls_error("write", ret);
+      stop();
+    }
+  }
+  return written;
+#else
+  return 0;
+#endif
+}
+
+int TlsClient::available() {
+  if (!tlsConfigured) return WiFiClient::available();
+#ifdef MQTT_TLS_AVAILABLE
+  if (!tlsOpen) return 0;
+  // A zero-length read decrypts a pending record, if any, without consuming it.
+  if (mbedtls_ssl_get_bytes_avail(&ssl) == 0 && WiFiClient::available() > 0) {
+    int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) log_mbedtls_error("read", ret);
+      stop();
+      return 0;
+    }
+  }
+  return (int)mbedtls_ssl_get_bytes_avail(&ssl);
+#else
+  return 0;
+#endif
+}
+
+int TlsClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::read(uint8_t* buffer, size_t size) {
+  if (!tlsConfigured) return WiFiClient::read(buffer, size);
+#ifdef MQTT_TLS_AVAILABLE
+  if (!tlsOpen) return -1;
+  int ret = mbedtls_ssl_read(&ssl, buffer, size);
+  if (ret > 0) return ret;
+  if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    if (ret != 0 && ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) log_mbedtls_error("read", ret);
+    stop();
+  }
+#endif
+  return -1;
+}
+
+int TlsClient::peek() {
+  // PubSubClient never peeks; decrypted data cannot be peeked without buffering it.
+  return tlsConfigured ? -1 : WiFiClient::peek();
+}
+
+void TlsClient::stop() {
+#ifdef MQTT_TLS_AVAILABLE
+  if (tlsOpen) {
+    tlsOpen = false;
+    if (WiFiClient::connected()) mbedtls_ssl_close_notify(&ssl);
+  }
+#endif
+  WiFiClient::stop();
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Runs the handshake on `activeClient`'s fresh connection, offering the
+ * saved session, and records its cost.
+ * @param host The broker's host name to verify, or nullptr.
+ * @return true if the connection is secured and the broker trusted.
+ */
+static bool tls_handshake(const char* host) {
+#ifdef MQTT_TLS_AVAILABLE
+  if (!tlsReady) {
+    handshakeFailures++;
+    LOG_ERROR("[TLS] ERROR: Not connecting, the TLS configuration is unusable.\n");
+    return false;
+  }
+  mbedtls_ssl_session_reset(&ssl);
+  mbedtls_ssl_set_hostname(&ssl, host);
+  mbedtls_ssl_set_bio(&ssl, nullptr, bio_send, bio_recv, nullptr);
+  bool offered = haveSavedSession && mbedtls_ssl_set_session(&ssl, &savedSession) == 0;
+  // mbedTLS 2.x does not tell whether the broker resumed the session; a resumed
+  // one keeps its master secret, a full handshake derives a new one.
+  unsigned char offeredMaster[sizeof(savedSession.master)];
+  if (offered) memcpy(offeredMaster, savedSession.master, sizeof(offeredMaster));
+
+  uint32_t heapBefore = ESP.getFreeHeap();
+  uint32_t heapLowest = heapBefore;
+  unsigned long start = millis();
+  int ret = 0;
+  while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    ret = mbedtls_ssl_handshake_step(&ssl);
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap < heapLowest) heapLowest = heap;
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+      if (millis() - start >= (unsigned long)MQTT_TLS_HANDSHAKE_TIMEOUT_MS) {
+        ret = MBEDTLS_ERR_SSL_TIMEOUT;
+        break;
+      }
+      delay(1);
+    } else if (ret != 0) {
+      break;
+    }
+  }
+  uint32_t elapsedMs = millis() - start;
+
+  uint32_t flags = ret == 0 ? mbedtls_ssl_get_verify_result(&ssl) : 0;
+  if (ret != 0 || flags != 0) {
+    handshakeFailures++;
+    if (ret != 0) {
+      log_mbedtls_error("handshake", ret);
+    } else {
+      char reason[128];
+      mbedtls_x509_crt_verify_info(reason, sizeof(reason), "", flags);
+      reason[strcspn(reason, "\n")] = '\0';
+      LOG_ERROR("[TLS] ERROR: The broker is not trusted: %s.\n", reason);
+    }
+    // Start over with a full handshake next time, in case the session was the problem.
+    if (offered) {
+      haveSavedSession = false;
+      sessionSource = "none";
+    }
+    return false;
+  }
+
+  tlsOpen = true;
+  save_session();
+  bool resumed = offered && haveSavedSession &&
+                 memcmp(savedSession.master, offeredMaster, sizeof(offeredMaster)) == 0;
+  TlsHandshakeKind kind = resumed ? TLS_HANDSHAKE_RESUMED : TLS_HANDSHAKE_FULL;
+  record_handshake(kind, elapsedMs, heapBefore - heapLowest);
+  LOG_INFO("[TLS] %s handshake in %u ms, %u bytes of heap at its peak.\n", resumed ? "Resumed" : "Full",
+           elapsedMs, heapBefore - heapLowest);
+  if (offered && !resumed) LOG_DEBUG("[TLS] The broker did not resume the session offered.\n");
+  return true;
+#else
+  handshakeFailures++;
+  return false;
+#endif
+}
+
+#ifdef MQTT_TLS_AVAILABLE
+
+/**
+ * @brief Adds a successful handshake to its kind's counters.
+ */
+static void record_handshake(TlsHandshakeKind kind, uint32_t ms, uint32_t heapBytes) {
+  TlsHandshakeStats& stats = handshakeStats[kind];
+  stats.count++;
+  stats.lastMs = ms;
+  if (ms > stats.maxMs) stats.maxMs = ms;
+  stats.lastHeapBytes = heapBytes;
+  if (heapBytes > stats.maxHeapBytes) stats.maxHeapBytes = heapBytes;
+}
+
+/**
+ * @brief Returns a CRC of everything a stored session was trusted under: the
+ * broker's address and the trust anchors.
+ */
+static uint32_t trust_crc() {
+  uint32_t crc = ota_patch_crc32(0, (const uint8_t*)MQTT_SERVER, strlen(MQTT_SERVER));
+  crc = ota_patch_crc32(crc, (const uint8_t*)&MQTT_PORT, sizeof(MQTT_PORT));
+  if (MQTT_TLS_CA_CERT != nullptr) {
+    crc = ota_patch_crc32(crc, (const uint8_t*)MQTT_TLS_CA_CERT, strlen(MQTT_TLS_CA_CERT));
+  }
+  return ota_patch_crc32(crc, (const uint8_t*)MQTT_TLS_PUBKEY_SHA256, strlen(MQTT_TLS_PUBKEY_SHA256));
+}
+
+/**
+ * @brief Seeds the random generator, parses the trust anchors and sets up the
+ * configuration and context that every connection reuses.
+ * @return false if TLS cannot be used.
+ */
+static bool tls_setup() {
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&drbg);
+  mbedtls_x509_crt_init(&caChain);
+  mbedtls_ssl_config_init(&sslConfig);
+  mbedtls_ssl_init(&ssl);
+  mbedtls_ssl_session_init(&savedSession);
+
+  unsigned long start = millis();
+  static const char PERSONALIZATION[] = "hidroiot-mqtt";
+  int ret = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)PERSONALIZATION,
+                                  sizeof(PERSONALIZATION) - 1);
+  if (ret != 0) {
+    log_mbedtls_error("seeding the random generator", ret);
+    return false;
+  }
+  if (MQTT_TLS_PUBKEY_SHA256[0] != '\0') {
+    havePin = parse_pin(MQTT_TLS_PUBKEY_SHA256);
+    if (!havePin) {
+      LOG_ERROR("[TLS] ERROR: The pinned key hash is not 64 hex digits.\n");
+      return false;
+    }
+  }
+  if (MQTT_TLS_CA_CERT != nullptr && MQTT_TLS_CA_CERT[0] != '\0') {
+    // The PEM parser needs the terminating NUL counted.
+    ret = mbedtls_x509_crt_parse(&caChain, (const unsigned char*)MQTT_TLS_CA_CERT, strlen(MQTT_TLS_CA_CERT) + 1);
+    if (ret != 0) {
+      log_mbedtls_error("parsing the CA certificate", ret);
+      return false;
+    }
+    haveCa = true;
+  }
+
+  ret = mbedtls_ssl_config_defaults(&sslConfig, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT);
+  if (ret != 0) {
+    log_mbedtls_error("configuring", ret);
+    return false;
+  }
+  // Trust is decided after the handshake from the verification result, which
+  // verify_certificate() has adjusted for the pin.
+  mbedtls_ssl_conf_authmode(&sslConfig, MBEDTLS_SSL_VERIFY_OPTIONAL);
+  if (haveCa) mbedtls_ssl_conf_ca_chain(&sslConfig, &caChain, nullptr);
+  mbedtls_ssl_conf_verify(&sslConfig, verify_certificate, nullptr);
+  mbedtls_ssl_conf_rng(&sslConfig, mbedtls_ctr_drbg_random, &drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&sslConfig, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+  ret = mbedtls_ssl_setup(&ssl, &sslConfig);
+  if (ret != 0) {
+    log_mbedtls_error("setting up the context", ret);
+    return false;
+  }
+  LOG_INFO("[TLS] Ready in %lu ms (%s%s%s).\n", millis() - start, haveCa ? "CA certificate" : "",
+           haveCa && havePin ? " and " : "", havePin ? "pinned key" : "");
+  return true;
+}
+
+/**
+ * @brief Parses the pinned key hash into `pinnedKeyHash`.
+ * @return false unless it is exactly 64 hex digits.
+ */
+static bool parse_pin(const char* hex) {
+  if (strlen(hex) != 2 * sizeof(pinnedKeyHash)) return false;
+  for (size_t i = 0; i < sizeof(pinnedKeyHash); i++) {
+    char byte[3] = {hex[2 * i], hex[2 * i + 1], '\0'};
+    char* end = nullptr;
+    pinnedKeyHash[i] = (uint8_t)strtoul(byte, &end, 16);
+    if (end != byte + 2) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Adjusts the verification of each certificate in the broker's chain:
+ * dates are not judged before the clock is set, and a pinned key must match
+ * the broker's own certificate. Without a CA certificate the pin alone decides.
+ */
+static int verify_certificate(void* context, mbedtls_x509_crt* crt, int depth, uint32_t* flags) {
+  if (command_ack_clock_ms() == 0) *flags &= ~(MBEDTLS_X509_BADCERT_EXPIRED | MBEDTLS_X509_BADCERT_FUTURE);
+  if (!havePin) return 0;
+  if (!haveCa) *flags = 0;
+  if (depth != 0) return 0;
+
+  // mbedtls_pk_write_pubkey_der() writes at the end of the buffer.
+  unsigned char der[600];
+  int length = mbedtls_pk_write_pubkey_der(&crt->pk, der, sizeof(der));
+  uint8_t hash[32];
+  if (length <= 0 || mbedtls_sha256_ret(der + sizeof(der) - length, length, hash, 0) != 0 ||
+      memcmp(hash, pinnedKeyHash, sizeof(hash)) != 0) {
+    *flags |= MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+  }
+  return 0;
+}
+
+/**
+ * @brief Sends handshake and record bytes over the TCP connection.
+ */
+static int bio_send(void* context, const unsigned char* buffer, size_t length) {
+  if (activeClient == nullptr || !activeClient->WiFiClient::connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+  size_t sent = activeClient->WiFiClient::write(buffer, length);
+  return sent > 0 ? (int)sent : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+/**
+ * @brief Receives bytes from the TCP connection without blocking.
+ */
+static int bio_recv(void* context, unsigned char* buffer, size_t length) {
+  if (activeClient == nullptr) return MBEDTLS_ERR_NET_CONN_RESET;
+  int received = activeClient->WiFiClient::read(buffer, length);
+  if (received > 0) return received;
+  return activeClient->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+}
+
+/**
+ * @brief Keeps the session just established for the next handshake, and in
+ * RTC memory if enabled.
+ */
+static void save_session() {
+  mbedtls_ssl_session_free(&savedSession);
+  mbedtls_ssl_session_init(&savedSession);
+  haveSavedSession = mbedtls_ssl_get_session(&ssl, &savedSession) == 0;
+  sessionSource = haveSavedSession ? "ram" : "none";
+  if (!haveSavedSession || !MQTT_TLS_SESSION_IN_RTC) return;
+
+  size_t length = 0;
+  rtcSession.magic = 0;
+  int ret = mbedtls_ssl_session_save(&savedSession, rtcSession.data, sizeof(rtcSession.data), &length);
+  if (ret != 0) {
+    LOG_DEBUG("[TLS] The session does not fit RTC memory (%u bytes); it is kept until the next reset only.\n",
+              (unsigned)length);
+    return;
+  }
+  rtcSession.length = length;
+  rtcSession.dataCrc = ota_patch_crc32(0, rtcSession.data, length);
+  rtcSession.trustCrc = trust_crc();
+  rtcSession.magic = TLS_RTC_MAGIC;
+}
+
+/**
+ * @brief Restores the session kept in RTC memory before the reset, if it is
+ * intact and was made with this broker and these trust anchors.
+ */
+static void restore_rtc_session() {
+  if (rtcSession.magic != TLS_RTC_MAGIC || rtcSession.length > sizeof(rtcSession.data) ||
+      rtcSession.trustCrc != trust_crc() || rtcSession.dataCrc != ota_patch_crc32(0, rtcSession.data,
+                                                                                 rtcSession.length)) {
+    rtcSession.magic = 0;
+    return;
+  }
+  haveSavedSession = mbedtls_ssl_session_load(&savedSession, rtcSession.data, rtcSession.length) == 0;
+  if (haveSavedSession) {
+    sessionSource = "rtc";
+    LOG_INFO("[TLS] Restored the session kept in RTC memory.\n");
+  } else {
+    mbedtls_ssl_session_free(&savedSession);
+    mbedtls_ssl_session_init(&savedSession);
+    rtcSession.magic = 0;
+  }
+}
+
+/**
+ * @brief Logs an mbedTLS error with its description.
+ */
+static void log_mbedtls_error(const char* what, int ret) {
+  char description[96];
+  mbedtls_strerror(ret, description, sizeof(description));
+  LOG_ERROR("[TLS] ERROR: %s failed: -0x%04x %s\n", what, (unsigned)-ret, description);
+}
+
+#endif // MQTT_TLS_AVAILABLE
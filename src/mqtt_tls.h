@@ -0,0 +1,101 @@
+/**
+ * @file mqtt_tls.h
+ * @brief Public interface for the TLS transport of the broker connection.
+ *
+ * TLS is used when a CA certificate (`MQTT_TLS_CA_CERT`) or a pinned public
+ * key (`MQTT_TLS_PUBKEY_SHA256`) is configured; otherwise the connection stays
+ * plaintext. The trust anchors are parsed once at boot and the TLS context is
+ * set up once, so a reconnect only costs the handshake itself.
+ *
+ * A full handshake (certificate verification and key exchange) takes seconds
+ * of CPU on the ESP32. The session of the last handshake is therefore kept and
+ * offered on the next one; a broker that still knows it (session ID cache or
+ * session ticket) resumes it with an abbreviated handshake that needs neither.
+ * With `MQTT_TLS_SESSION_IN_RTC` the session also survives software, panic
+ * and watchdog resets in RTC memory, so a restarted board resumes too.
+ *
+ * The time and heap use of every handshake are counted separately for full
+ * and resumed ones, published retained on STATE_TOPIC_TLS and served on /metrics.
+ */
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <WiFi.h>
+#include <stdint.h>
+
+/**
+ * @enum TlsHandshakeKind
+ * @brief How a handshake established the connection's keys.
+ */
+enum TlsHandshakeKind {
+  TLS_HANDSHAKE_FULL,    ///< Certificate verification and a new key exchange.
+  TLS_HANDSHAKE_RESUMED, ///< The broker resumed the session offered.
+  TLS_HANDSHAKE_NUM_KINDS
+};
+
+/**
+ * @struct TlsHandshakeStats
+ * @brief What the successful handshakes of one kind cost since boot.
+ */
+struct TlsHandshakeStats {
+  uint32_t count;
+  uint32_t lastMs;        ///< Duration of the latest one.
+  uint32_t maxMs;         ///< Duration of the slowest one.
+  uint32_t lastHeapBytes; ///< Heap the latest one took at its peak.
+  uint32_t maxHeapBytes;  ///< The most heap any of them took at its peak.
+};
+
+/**
+ * @class TlsClient
+ * @brief A WiFiClient that runs TLS over its connection when TLS is configured,
+ * and passes everything through unchanged when it is not.
+ *
+ * The TLS state is module-wide, so only one instance may exist: the broker
+ * connection's.
+ */
+class TlsClient : public WiFiClient {
+public:
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t* buffer, size_t size) override;
+  int peek() override;
+  void stop() override;
+};
+
+/**
+ * @brief Parses the trust anchors, sets up the TLS context and restores a
+ * session kept in RTC memory. Call once in `setup()`, before `mqtt_init()`.
+ * A TLS configuration that cannot be used is logged, and connections then fail
+ * rather than fall back to plaintext.
+ */
+void mqtt_tls_init();
+
+/**
+ * @brief Returns whether the broker connection uses TLS.
+ * @return true if a CA certificate or a pinned key is configured.
+ */
+bool mqtt_tls_enabled();
+
+/**
+ * @brief Returns what the successful handshakes of one kind cost.
+ * @param kind The kind of handshake.
+ * @return The counters since boot.
+ */
+const TlsHandshakeStats& mqtt_tls_stats(TlsHandshakeKind kind);
+
+/**
+ * @brief Returns the number of failed handshakes since boot.
+ * @return The failure count.
+ */
+uint32_t mqtt_tls_failures();
+
+/**
+ * @brief Publishes the handshake counters (retained). Does nothing without TLS.
+ */
+void mqtt_tls_publish_status();
+
+#endif // MQTT_TLS_H
@@ -0,0 +1,130 @@
+/**
+ * @file number_format.cpp
+ * @brief Implements fixed-point number formatting without printf.
+ *
+ * A float is `mantissa * 2^exponent` with a 24-bit mantissa. Scaling the
+ * mantissa by 10^decimals and shifting by the exponent in 64-bit integers
+ * gives the exact value times 10^decimals, so rounding it to an integer is
+ * exact as well. The digits are then written two at a time from a table.
+ */
+
+#include "number_format.h"
+#include <string.h>
+
+// --- Module-Private (Static) Constants ---
+
+static const uint32_t POWERS_OF_TEN[NUMBER_FORMAT_MAX_DECIMALS + 1] = {1, 10, 100, 1000, 10000};
+
+/// @brief "00" to "99", for writing two digits per division.
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/// @brief Shifts beyond this leave nothing: mantissa * 10^4 < 2^38 is below half the unit.
+static const int MAX_RIGHT_SHIFT = 38;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static char* write_digits(char* end, uint32_t value, int minDigits);
+
+// --- Public Function Implementations ---
+
+size_t number_format_fixed(char* buffer, size_t size, float value, uint8_t decimals) {
+  if (size == 0) return 0;
+  buffer[0] = '\0';
+  if (decimals > NUMBER_FORMAT_MAX_DECIMALS) return 0;
+
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bool negative = (bits >> 31) != 0;
+  uint32_t biasedExponent = (bits >> 23) & 0xFF;
+  uint32_t fraction = bits & 0x7FFFFF;
+
+  // Room for a sign, 10 integer digits, the point and the decimals.
+  char text[20];
+  char* end = text + sizeof(text);
+  char* start;
+
+  if (biasedExponent == 0xFF) {
+    const char* special = fraction ? "nan" : "inf";
+    start = end - strlen(special);
+    memcpy(start, special, end - start);
+    // printf keeps the sign of a NAN as well.
+    if (negative) *--start = '-';
+  } else {
+    if (biasedExponent >= 127 + 32) return 0; // |value| >= 2^32
+
+    // value = mantissa * 2^exponent; subnormals have no implicit leading bit.
+    uint64_t mantissa = biasedExponent ? (fraction | 0x800000) : fraction;
+    int exponent = biasedExponent ? (int)biasedExponent - 150 : -149;
+    uint32_t scale = POWERS_OF_TEN[decimals];
+    uint64_t scaled = mantissa * scale;
+
+    uint64_t rounded;
+    if (exponent >= 0) {
+      rounded = scaled << exponent;
+    } else if (-exponent > MAX_RIGHT_SHIFT) {
+      rounded = 0;
+    } else {
+      int shift = -exponent;
+      rounded = scaled >> shift;
+      uint64_t remainder = scaled & ((1ULL << shift) - 1);
+      uint64_t half = 1ULL << (shift - 1);
+      // Round half to even, as printf does.
+      if (remainder > half || (remainder == half && (rounded & 1))) rounded++;
+    }
+
+    uint32_t integerPart;
+    uint32_t fractionPart;
+    if ((rounded >> 32) == 0) {
+      // Avoid the 64-bit division for the values we actually publish.
+      integerPart = (uint32_t)rounded / scale;
+      fractionPart = (uint32_t)rounded - integerPart * scale;
+    } else {
+      integerPart = (uint32_t)(rounded / scale);
+      fractionPart = (uint32_t)(rounded - (uint64_t)integerPart * scale);
+    }
+
+    start = end;
+    if (decimals > 0) {
+      start = write_digits(start, fractionPart, decimals);
+      *--start = '.';
+    }
+    start = write_digits(start, integerPart, 1);
+    // printf keeps the sign of negative values that round to zero.
+    if (negative) *--start = '-';
+  }
+
+  size_t length = end - start;
+  if (length + 1 > size) return 0;
+  memcpy(buffer, start, length);
+  buffer[length] = '\0';
+  return length;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Writes the decimal digits of a value backwards, ending at `end`.
+ * @param end One past the position of the last digit.
+ * @param value The value.
+ * @param minDigits Pads with leading zeros to at least this many digits.
+ * @return The position of the first digit written.
+ */
+static char* write_digits(char* end, uint32_t value, int minDigits) {
+  char* p = end;
+  while (value >= 100) {
+    uint32_t pair = value % 100;
+    value /= 100;
+    p -= 2;
+    memcpy(p, &DIGIT_PAIRS[pair * 2], 2);
+  }
+  if (value >= 10) {
+    p -= 2;
+    memcpy(p, &DIGIT_PAIRS[value * 2], 2);
+  } else {
+    *--p = (char)('0' + value);
+  }
+  while (end - p < minDigits) *--p = '0';
+  return p;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file number_format.h
+ * @brief Public interface for fixed-point number formatting without printf.
+ *
+ * Formats a float with a fixed number of decimals, producing exactly what
+ * `snprintf("%.<n>f")` produces (round half to even on the exact binary
+ * value, "-0.00" for small negatives), but with integer arithmetic only.
+ * Newlib's float printf is slow on the Xtensa core, and this is on the path
+ * of every sensor publish. Like the pump models, this module is free of
+ * hardware dependencies.
+ */
+#ifndef NUMBER_FORMAT_H
+#define NUMBER_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief The largest supported number of decimals.
+const uint8_t NUMBER_FORMAT_MAX_DECIMALS = 4;
+
+/**
+ * @brief Formats a value with a fixed number of decimals, like `"%.<decimals>f"`.
+ * NAN and infinities are written as "nan", "inf" and "-inf" ("-nan" if the sign bit is set).
+ * @param buffer The destination; always null-terminated if `size` > 0.
+ * @param size The size of `buffer` in bytes.
+ * @param value The value to format. Magnitudes of 2^32 and above are not supported.
+ * @param decimals The number of decimals, 0 to NUMBER_FORMAT_MAX_DECIMALS.
+ * @return The length of the text, or 0 if the value is out of range, `decimals`
+ *         is too large or the text does not fit (the buffer is then empty).
+ */
+size_t number_format_fixed(char* buffer, size_t size, float value, uint8_t decimals);
+
+#endif // NUMBER_FORMAT_H
@@ -0,0 +1,543 @@
+/**
+ * @file ota.cpp
+ * @brief Implements firmware updates over MQTT.
+ *
+ * Received chunks are decoded into a one-sector window, which is written to
+ * the update partition when full. A delta chunk can expand to many sectors,
+ * so a chunk is decoded over several loop iterations, one flash write per
+ * iteration, and the next chunk is only requested once it is used up.
+ */
+
+#include "ota.h"
+#include "config.h"
+#include "ota_patch.h"
+#include "actuators.h"    // Restarts wait for the pumps
+#include "history.h"
+#include "mqtt_handler.h"
+#include "storage.h"
+#include <esp_ota_ops.h>
+#include <strings.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/// @brief Where an update is.
+enum OtaPhase : uint8_t {
+  OTA_IDLE,
+  OTA_CHECKING_BASE, ///< Checking the running image against a delta's base CRC.
+  OTA_RECEIVING,
+  OTA_READY          ///< Written and verified; restarts once no pump runs.
+};
+
+/// @brief How the last trial of a new image ended.
+enum OtaResult : uint8_t {
+  RESULT_NONE,
+  RESULT_CONFIRMED,
+  RESULT_ROLLED_BACK
+};
+
+/**
+ * @struct OtaTrial
+ * @brief The persisted record of the last installed image.
+ */
+struct OtaTrial {
+  uint8_t active;      ///< 1 while the new image has not yet proven healthy.
+  uint8_t boots;       ///< Boots of the new image during its trial.
+  uint8_t result;      ///< OtaResult of the last finished trial.
+  uint8_t reserved;
+  uint32_t fileCrc;    ///< The update file the image was built from.
+  uint32_t newAddress; ///< Flash address of the new image's partition.
+  uint32_t oldAddress; ///< Flash address of the partition to return to.
+};
+
+/**
+ * @struct OtaTransfer
+ * @brief The update file being received.
+ */
+struct OtaTransfer {
+  uint32_t fileSize;
+  uint32_t fileCrc;      ///< As announced by `BEGIN`.
+  uint32_t received;     ///< File bytes received, i.e. the offset of the next chunk.
+  uint32_t receivedCrc;  ///< CRC-32 of those bytes.
+  uint32_t imageCrc;     ///< CRC-32 of the image bytes written so far.
+  uint32_t chunks;
+  uint32_t retries;      ///< Chunks requested again after a timeout or a bad CRC.
+  uint32_t baseChecked;  ///< Running image bytes checked against a delta's base CRC.
+  uint32_t baseCrc;
+  size_t headerFill;
+  bool headerValid;
+  bool requestDue;       ///< Request the next chunk without waiting for the timeout.
+  bool decoding;         ///< The last chunk may still produce output.
+  unsigned long lastRequestTime;
+  unsigned long lastProgressTime;
+  uint8_t lastReportedTenth;
+};
+
+static const char* const PHASE_NAMES[] = {"idle", "checking", "receiving", "ready"};
+static const char* const RESULT_NAMES[] = {"none", "confirmed", "rolled_back"};
+static const char* const METHOD_NAMES[] = {"raw", "lz", "delta"};
+/// @brief Offset and CRC-32 in front of every chunk's data.
+static const size_t CHUNK_HEADER_SIZE = 8;
+/// @brief One flash sector, so every window write programs whole sectors.
+static const size_t WINDOW_SIZE = 4096;
+
+static OtaPhase phase = OTA_IDLE;
+static OtaTransfer transfer;
+static uint8_t headerBytes[OTA_HEADER_SIZE];
+static OtaHeader header;
+static OtaPatcher patcher;
+static uint8_t window[WINDOW_SIZE];
+static uint8_t chunk[OTA_CHUNK_SIZE];
+static size_t chunkLength = 0;
+static size_t chunkUsed = 0;
+
+static const esp_partition_t* runningPartition = nullptr;
+static const esp_partition_t* targetPartition = nullptr;
+static esp_ota_handle_t otaHandle = 0;
+static bool otaHandleOpen = false;
+static const char* lastError = nullptr;
+
+static OtaTrial trial;
+static int trialHandle = -1;
+/// @brief When the current broker connection started, for the trial's health check.
+static bool wasConnected = false;
+static unsigned long connectedSince = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void begin_update(uint32_t size, uint32_t crc);
+static void receive_step(unsigned long now);
+static void decode_step();
+static bool start_image();
+static bool open_target();
+static void check_base_step();
+static void flush_window();
+static void finish_update();
+static void request_chunk(unsigned long now);
+static void fail(const char* reason);
+static void close_transfer();
+static void trial_loop(unsigned long now);
+static void revert_image();
+static void save_trial();
+static void restart();
+static bool read_base(uint32_t offset, uint8_t* out, size_t length);
+static bool read_output(uint32_t offset, uint8_t* out, size_t length);
+static uint32_t read_u32(const uint8_t* bytes);
+
+// --- Public Function Implementations ---
+
+void ota_init() {
+  runningPartition = esp_ota_get_running_partition();
+  trialHandle = storage_register("ota_trial", &trial, sizeof(trial), 0);
+  if (!trial.active) return;
+
+  if (runningPartition == nullptr || runningPartition->address != trial.newAddress) {
+    // The new image never took over, e.g. the bootloader rejected it.
+    trial.active = 0;
+    trial.result = RESULT_ROLLED_BACK;
+    save_trial();
+    LOG_WARN("[OTA] WARN: The updated image is not running; the update was rolled back.\n");
+    return;
+  }
+  trial.boots++;
+  save_trial();
+  LOG_INFO("[OTA] Updated image on trial, boot %u (%u allowed).\n", trial.boots, OTA_TRIAL_MAX_BOOTS);
+}
+
+void ota_loop() {
+  unsigned long now = millis();
+  trial_loop(now);
+  if (phase == OTA_CHECKING_BASE) {
+    check_base_step();
+  } else if (phase == OTA_RECEIVING) {
+    receive_step(now);
+  } else if (phase == OTA_READY && !actuators_power_monitor_active() && actuators_queue_length() == 0) {
+    LOG_INFO("[OTA] Restarting into the updated image.\n");
+    restart();
+  }
+}
+
+void ota_handle_command(const char* command) {
+  if (strcasecmp(command, "STATUS") == 0) {
+    ota_publish_status();
+    return;
+  }
+  if (strcasecmp(command, "ABORT") == 0) {
+    if (phase == OTA_CHECKING_BASE || phase == OTA_RECEIVING) {
+      LOG_INFO("[OTA] Update aborted at %u of %u bytes.\n", transfer.received, transfer.fileSize);
+      close_transfer();
+      lastError = "aborted";
+      ota_publish_status();
+    }
+    return;
+  }
+  unsigned long size = 0, crc = 0;
+  if (strncasecmp(command, "BEGIN", 5) != 0 || sscanf(command + 5, "%lu %lx", &size, &crc) != 2 ||
+      size <= OTA_HEADER_SIZE) {
+    LOG_WARN("[OTA] WARN: Invalid command '%s', expected 'BEGIN <size> <crc32>', 'ABORT' or 'STATUS'.\n", command);
+    return;
+  }
+  begin_update((uint32_t)size, (uint32_t)crc);
+}
+
+void ota_handle_data(const uint8_t* payload, size_t length) {
+  // Only the requested chunk is taken; duplicates and leftovers of an earlier transfer are ignored.
+  if (phase != OTA_RECEIVING || transfer.decoding || length <= CHUNK_HEADER_SIZE) return;
+  size_t size = length - CHUNK_HEADER_SIZE;
+  if (read_u32(payload) != transfer.received || size > OTA_CHUNK_SIZE ||
+      size > transfer.fileSize - transfer.received) {
+    return;
+  }
+  const uint8_t* data = payload + CHUNK_HEADER_SIZE;
+  if (ota_patch_crc32(0, data, size) != read_u32(payload + 4)) {
+    LOG_WARN("[OTA] WARN: Chunk at %u failed its CRC, requesting it again.\n", transfer.received);
+    transfer.retries++;
+    transfer.requestDue = true;
+    return;
+  }
+  memcpy(chunk, data, size);
+  chunkLength = size;
+  chunkUsed = 0;
+  transfer.decoding = true;
+  transfer.received += size;
+  transfer.receivedCrc = ota_patch_crc32(transfer.receivedCrc, data, size);
+  transfer.chunks++;
+  transfer.lastProgressTime = millis();
+
+  uint8_t tenth = (uint8_t)((uint64_t)transfer.received * 10 / transfer.fileSize);
+  if (tenth != transfer.lastReportedTenth) {
+    transfer.lastReportedTenth = tenth;
+    ota_publish_status();
+  }
+}
+
+void ota_publish_status() {
+  char method[12] = "null";
+  if (transfer.headerValid) snprintf(method, sizeof(method), "\"%s\"", METHOD_NAMES[header.method]);
+  char error[48] = "null";
+  if (lastError != nullptr) snprintf(error, sizeof(error), "\"%s\"", lastError);
+  const char* trialState = "running";
+  if (!trial.active) trialState = RESULT_NAMES[trial.result <= RESULT_ROLLED_BACK ? trial.result : 0];
+
+  char payload[320];
+  snprintf(payload, sizeof(payload),
+           "{\"state\":\"%s\",\"running\":\"%s\",\"received\":%u,\"size\":%u,\"method\":%s,\"image\":%u,"
+           "\"chunks\":%u,\"retries\":%u,\"trial\":\"%s\",\"boots\":%u,\"error\":%s}",
+           PHASE_NAMES[phase], runningPartition ? runningPartition->label : "", transfer.received,
+           transfer.fileSize, method, transfer.headerValid ? header.imageSize : 0,
+           transfer.chunks, transfer.retries, trialState, trial.boots, error);
+  mqtt_publish_state(STATE_TOPIC_OTA, payload, true);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Starts receiving an update file, or resumes it if it is the one being received.
+ */
+static void begin_update(uint32_t size, uint32_t crc) {
+  if (phase == OTA_READY) {
+    LOG_INFO("[OTA] An update is installed and waits for the pumps to stop.\n");
+    ota_publish_status();
+    return;
+  }
+  if (trial.active || (trial.fileCrc == crc && trial.result == RESULT_CONFIRMED)) {
+    // The partition to return to must not be overwritten before the running image is trusted.
+    lastError = trial.active ? "running image on trial" : "already installed";
+    LOG_WARN("[OTA] WARN: Update %08x refused: %s.\n", crc, lastError);
+    ota_publish_status();
+    return;
+  }
+  if ((phase == OTA_CHECKING_BASE || phase == OTA_RECEIVING) && transfer.fileSize == size &&
+      transfer.fileCrc == crc) {
+    LOG_INFO("[OTA] Resuming update %08x at %u of %u bytes.\n", crc, transfer.received, size);
+    transfer.requestDue = true;
+    return;
+  }
+  if (phase != OTA_IDLE) {
+    LOG_INFO("[OTA] Update %08x replaced by %08x.\n", transfer.fileCrc, crc);
+    close_transfer();
+  }
+  if (runningPartition == nullptr || esp_ota_get_next_update_partition(nullptr) == nullptr) {
+    fail("no update partition");
+    return;
+  }
+
+  memset(&transfer, 0, sizeof(transfer));
+  transfer.fileSize = size;
+  transfer.fileCrc = crc;
+  transfer.requestDue = true;
+  transfer.lastProgressTime = millis();
+  lastError = nullptr;
+  phase = OTA_RECEIVING;
+  LOG_INFO("[OTA] Receiving update %08x, %u bytes.\n", crc, size);
+  ota_publish_status();
+}
+
+/**
+ * @brief Decodes received data, or requests the next chunk when the last one is used up.
+ */
+static void receive_step(unsigned long now) {
+  if (transfer.decoding) {
+    decode_step();
+    return;
+  }
+  if (now - transfer.lastProgressTime >= (unsigned long)OTA_STALL_TIMEOUT_MS) {
+    fail("stalled");
+    return;
+  }
+  // Requests made while the broker is away are lost, so the timeout also resumes after a reconnect.
+  if (!mqtt_is_connected()) return;
+  if (transfer.requestDue) {
+    request_chunk(now);
+  } else if (now - transfer.lastRequestTime >= (unsigned long)OTA_CHUNK_TIMEOUT_MS) {
+    transfer.retries++;
+    request_chunk(now);
+  }
+}
+
+/**
+ * @brief Takes the next step on the received chunk: the header, one window
+ * write, or decoding until the window is full or the chunk is used up.
+ */
+static void decode_step() {
+  if (transfer.headerFill < OTA_HEADER_SIZE) {
+    size_t n = min(OTA_HEADER_SIZE - transfer.headerFill, chunkLength - chunkUsed);
+    memcpy(headerBytes + transfer.headerFill, chunk + chunkUsed, n);
+    transfer.headerFill += n;
+    chunkUsed += n;
+    if (transfer.headerFill == OTA_HEADER_SIZE) start_image();
+    return;
+  }
+  // At most one flash write per loop iteration.
+  if (patcher.windowFill == WINDOW_SIZE) {
+    flush_window();
+    return;
+  }
+  chunkUsed += ota_patch_run(patcher, chunk + chunkUsed, chunkLength - chunkUsed);
+  if (patcher.error != nullptr) {
+    fail(patcher.error);
+    return;
+  }
+  if (patcher.windowFill == WINDOW_SIZE) return; // More output may follow once it is written.
+
+  transfer.decoding = false;
+  if (transfer.received == transfer.fileSize) {
+    finish_update();
+  } else {
+    transfer.requestDue = true;
+  }
+}
+
+/**
+ * @brief Checks the received header and prepares the update partition.
+ * @return false if the update was rejected.
+ */
+static bool start_image() {
+  const char* error = ota_patch_parse_header(headerBytes, header);
+  if (error == nullptr && header.payloadSize != transfer.fileSize - OTA_HEADER_SIZE) error = "size mismatch";
+  targetPartition = esp_ota_get_next_update_partition(nullptr);
+  if (error == nullptr && header.imageSize > targetPartition->size) error = "image too large";
+  if (error == nullptr && header.method == OTA_METHOD_DELTA && header.baseSize > runningPartition->size) {
+    error = "made for another image";
+  }
+  if (error != nullptr) {
+    fail(error);
+    return false;
+  }
+  transfer.headerValid = true;
+  LOG_INFO("[OTA] %s update to a %u-byte image in %u bytes.\n", METHOD_NAMES[header.method], header.imageSize,
+           header.payloadSize);
+  if (header.method == OTA_METHOD_DELTA) {
+    phase = OTA_CHECKING_BASE;
+    ota_publish_status();
+    return true;
+  }
+  return open_target();
+}
+
+/**
+ * @brief Opens the update partition and starts the decoder.
+ */
+static bool open_target() {
+  // Sequential writes erase sector by sector as the image grows, instead of the whole partition up front.
+  if (esp_ota_begin(targetPartition, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle) != ESP_OK) {
+    fail("cannot open update partition");
+    return false;
+  }
+  otaHandleOpen = true;
+  ota_patch_init(patcher, header, window, sizeof(window), read_base, read_output);
+  phase = OTA_RECEIVING;
+  return true;
+}
+
+/**
+ * @brief Checks one sector of the running image against a delta's base CRC.
+ */
+static void check_base_step() {
+  size_t n = min((size_t)(header.baseSize - transfer.baseChecked), WINDOW_SIZE);
+  if (!read_base(transfer.baseChecked, window, n)) {
+    fail("cannot read running image");
+    return;
+  }
+  transfer.baseCrc = ota_patch_crc32(transfer.baseCrc, window, n);
+  transfer.baseChecked += n;
+  if (transfer.baseChecked < header.baseSize) return;
+
+  if (transfer.baseCrc != header.baseCrc) {
+    fail("made for another image");
+    return;
+  }
+  transfer.lastProgressTime = millis();
+  if (open_target()) ota_publish_status();
+}
+
+/**
+ * @brief Writes the window to the update partition.
+ */
+static void flush_window() {
+  if (esp_ota_write(otaHandle, window, patcher.windowFill) != ESP_OK) {
+    fail("flash write failed");
+    return;
+  }
+  transfer.imageCrc = ota_patch_crc32(transfer.imageCrc, window, patcher.windowFill);
+  ota_patch_window_emptied(patcher);
+}
+
+/**
+ * @brief Verifies the complete image and selects it for the next boot.
+ */
+static void finish_update() {
+  if (!ota_patch_done(patcher)) {
+    fail("update file ends early");
+    return;
+  }
+  if (patcher.windowFill > 0) flush_window();
+  if (phase != OTA_RECEIVING) return;
+  if (transfer.receivedCrc != transfer.fileCrc || transfer.imageCrc != header.imageCrc) {
+    fail("CRC mismatch");
+    return;
+  }
+  otaHandleOpen = false;
+  if (esp_ota_end(otaHandle) != ESP_OK) {
+    fail("image rejected");
+    return;
+  }
+  if (esp_ota_set_boot_partition(targetPartition) != ESP_OK) {
+    fail("cannot select the new image");
+    return;
+  }
+
+  trial.active = 1;
+  trial.boots = 0;
+  trial.result = RESULT_NONE;
+  trial.fileCrc = transfer.fileCrc;
+  trial.newAddress = targetPartition->address;
+  trial.oldAddress = runningPartition->address;
+  save_trial();
+  phase = OTA_READY;
+  LOG_INFO("[OTA] Update %08x verified: %u bytes received for a %u-byte image, %u chunks, %u retries.\n",
+           transfer.fileCrc, transfer.fileSize, header.imageSize, transfer.chunks, transfer.retries);
+  ota_publish_status();
+}
+
+/**
+ * @brief Asks the update server for the chunk at the current offset.
+ */
+static void request_chunk(unsigned long now) {
+  uint32_t length = min((uint32_t)OTA_CHUNK_SIZE, transfer.fileSize - transfer.received);
+  char payload[80];
+  snprintf(payload, sizeof(payload), "{\"crc\":\"%08x\",\"offset\":%u,\"length\":%u}", transfer.fileCrc,
+           transfer.received, length);
+  mqtt_publish_state(STATE_TOPIC_OTA_REQUEST, payload, false);
+  transfer.requestDue = false;
+  transfer.lastRequestTime = now;
+}
+
+/**
+ * @brief Abandons the update and reports why. The running image is untouched.
+ */
+static void fail(const char* reason) {
+  LOG_ERROR("[OTA] ERROR: Update failed: %s.\n", reason);
+  close_transfer();
+  lastError = reason;
+  ota_publish_status();
+}
+
+/**
+ * @brief Closes the update partition and forgets the transfer's progress.
+ */
+static void close_transfer() {
+  if (otaHandleOpen) esp_ota_abort(otaHandle);
+  otaHandleOpen = false;
+  transfer.decoding = false;
+  phase = OTA_IDLE;
+}
+
+/**
+ * @brief Confirms a new image once it has held a broker connection long enough,
+ * and restores the previous one if it does not in time.
+ */
+static void trial_loop(unsigned long now) {
+  // Until the restart, an installed image's trial record belongs to the next boot.
+  if (!trial.active || runningPartition == nullptr || runningPartition->address != trial.newAddress) return;
+  bool connected = mqtt_is_connected();
+  if (connected && !wasConnected) connectedSince = now;
+  wasConnected = connected;
+
+  if (connected && now - connectedSince >= (unsigned long)OTA_HEALTHY_CONNECTION_MS) {
+    trial.active = 0;
+    trial.result = RESULT_CONFIRMED;
+    save_trial();
+    // Also ends the bootloader's own rollback check, where it is enabled.
+    esp_ota_mark_app_valid_cancel_rollback();
+    LOG_INFO("[OTA] Updated image confirmed after %u boot(s).\n", trial.boots);
+    ota_publish_status();
+    return;
+  }
+  bool expired = trial.boots > OTA_TRIAL_MAX_BOOTS || now >= (unsigned long)OTA_TRIAL_TIMEOUT_MS;
+  if (expired && !actuators_power_monitor_active()) revert_image();
+}
+
+/**
+ * @brief Boots the previous image again after a failed trial.
+ */
+static void revert_image() {
+  const esp_partition_t* previous = esp_ota_get_next_update_partition(nullptr);
+  trial.active = 0;
+  trial.result = RESULT_ROLLED_BACK;
+  save_trial();
+  if (previous == nullptr || previous->address != trial.oldAddress ||
+      esp_ota_set_boot_partition(previous) != ESP_OK) {
+    LOG_ERROR("[OTA] ERROR: The previous image cannot be restored; keeping the updated one.\n");
+    ota_publish_status();
+    return;
+  }
+  LOG_ERROR("[OTA] ERROR: Updated image did not become healthy after %u boot(s), restoring the previous one.\n",
+            trial.boots);
+  restart();
+}
+
+/**
+ * @brief Writes the trial record at once; it has to survive the restart that follows.
+ */
+static void save_trial() {
+  storage_mark_dirty(trialHandle);
+  storage_flush(trialHandle);
+}
+
+static void restart() {
+  storage_flush_all();
+  history_flush();
+  logger_flush(1000); // Let the log message reach Serial before the restart.
+  ESP.restart();
+}
+
+static bool read_base(uint32_t offset, uint8_t* out, size_t length) {
+  return esp_partition_read(runningPartition, offset, out, length) == ESP_OK;
+}
+
+static bool read_output(uint32_t offset, uint8_t* out, size_t length) {
+  return esp_partition_read(targetPartition, offset, out, length) == ESP_OK;
+}
+
+static uint32_t read_u32(const uint8_t* bytes) {
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
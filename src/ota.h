@@ -0,0 +1,66 @@
+/**
+ * @file ota.h
+ * @brief Public interface for firmware updates over MQTT.
+ *
+ * The device pulls an update file (see ota_patch.h) from an update server
+ * through the broker, one chunk at a time, so a weak link only ever loses the
+ * chunk in flight:
+ *
+ *   server -> COMMAND_TOPIC_OTA        `BEGIN <file size> <file CRC-32, hex>`
+ *   device -> STATE_TOPIC_OTA_REQUEST  `{"crc":"<file CRC>","offset":<n>,"length":<n>}`
+ *   server -> COMMAND_TOPIC_OTA_DATA   `[offset u32 LE][CRC-32 of data u32 LE][data]`
+ *
+ * A chunk with the wrong offset or CRC is requested again, as is one that
+ * does not arrive within `OTA_CHUNK_TIMEOUT_MS`, so a transfer resumes where
+ * it stopped after the connection comes back. `BEGIN` for the file being
+ * received resumes it too; a different file restarts. Compressed and delta
+ * payloads are decoded as they arrive and written to the next app partition.
+ * A delta is only applied after the running image has been checked against
+ * the CRC it was made for.
+ *
+ * The new image is booted only after its CRC checked out, and only while no
+ * pump runs. It then runs on trial: unless it holds a broker connection for
+ * `OTA_HEALTHY_CONNECTION_MS` within `OTA_TRIAL_TIMEOUT_MS` of booting, and
+ * within `OTA_TRIAL_MAX_BOOTS` boots, the previous image is booted again.
+ * The outcome is published retained on STATE_TOPIC_OTA.
+ */
+#ifndef OTA_H
+#define OTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Restores the trial record and counts a trial boot. Call once in
+ * `setup()`, right after `storage_init()`, so a crashing image is counted early.
+ */
+void ota_init();
+
+/**
+ * @brief Main loop for updates: decodes and writes received data, requests
+ * chunks, and runs the trial of a new image.
+ */
+void ota_loop();
+
+/**
+ * @brief Handles a command from the update command topic.
+ * `BEGIN <size> <crc32>` starts or resumes an update, `ABORT` cancels it and
+ * `STATUS` publishes the status.
+ * @param command The payload received.
+ */
+void ota_handle_command(const char* command);
+
+/**
+ * @brief Handles a chunk from the update data topic. Called with the raw
+ * payload, before it is treated as text.
+ * @param payload The chunk, header included.
+ * @param length The payload length in bytes.
+ */
+void ota_handle_data(const uint8_t* payload, size_t length);
+
+/**
+ * @brief Publishes the update status (retained). Call after connecting to the broker.
+ */
+void ota_publish_status();
+
+#endif // OTA_H
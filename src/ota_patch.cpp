@@ -0,0 +1,228 @@
+/**
+ * @file ota_patch.cpp
+ * @brief Implements the firmware update format and its streaming decoder.
+ */
+
+#include "ota_patch.h"
+#include <string.h>
+
+// --- Module-Private (Static) Constants ---
+
+/// @brief Operation types, from the op byte's top two bits.
+static const uint8_t OP_LITERAL = 0;
+static const uint8_t OP_COPY_OUT = 1;
+static const uint8_t OP_COPY_BASE = 2;
+
+/// @brief The op byte's length field value that announces a varint length.
+static const uint8_t LENGTH_EXTENDED = 0x3F;
+static const uint32_t EXTENDED_LENGTH_BASE = 64;
+
+/// @brief Decoder states.
+enum PatchState : uint8_t {
+  STATE_OP,       ///< Expecting an op byte.
+  STATE_LENGTH,   ///< Reading an extended length.
+  STATE_ARGUMENT, ///< Reading a copy's distance or base offset.
+  STATE_LITERAL,  ///< Copying literal bytes from the input.
+  STATE_COPY      ///< Copying from earlier output or the running image.
+};
+
+/// @brief CRC-32 (reflected 0xEDB88320) of every nibble value.
+static const uint32_t CRC32_NIBBLE_TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+// --- Forward Declarations for Static (Private) Functions ---
+static uint32_t read_u32(const uint8_t* bytes);
+static void start_operation(OtaPatcher& patcher);
+static void finish_argument(OtaPatcher& patcher);
+static void copy_step(OtaPatcher& patcher);
+
+// --- Public Function Implementations ---
+
+const char* ota_patch_parse_header(const uint8_t* bytes, OtaHeader& header) {
+  header.magic = read_u32(bytes);
+  header.version = bytes[4];
+  header.method = bytes[5];
+  header.reserved = (uint16_t)(bytes[6] | (bytes[7] << 8));
+  header.imageSize = read_u32(bytes + 8);
+  header.imageCrc = read_u32(bytes + 12);
+  header.baseSize = read_u32(bytes + 16);
+  header.baseCrc = read_u32(bytes + 20);
+  header.payloadSize = read_u32(bytes + 24);
+  header.headerCrc = read_u32(bytes + 28);
+
+  if (header.magic != OTA_UPDATE_MAGIC) return "not an update file";
+  if (header.version != OTA_UPDATE_VERSION) return "unsupported version";
+  if (ota_patch_crc32(0, bytes, OTA_HEADER_SIZE - 4) != header.headerCrc) return "header CRC mismatch";
+  if (header.method > OTA_METHOD_DELTA) return "unknown method";
+  if (header.imageSize == 0) return "empty image";
+  if (header.method == OTA_METHOD_RAW && header.payloadSize != header.imageSize) return "raw size mismatch";
+  return nullptr;
+}
+
+void ota_patch_init(OtaPatcher& patcher, const OtaHeader& header, uint8_t* window, size_t windowSize,
+                    OtaReadFn readBase, OtaReadFn readOutput) {
+  memset(&patcher, 0, sizeof(patcher));
+  patcher.method = header.method;
+  patcher.imageSize = header.imageSize;
+  patcher.baseSize = header.method == OTA_METHOD_DELTA ? header.baseSize : 0;
+  patcher.window = window;
+  patcher.windowSize = windowSize;
+  patcher.readBase = readBase;
+  patcher.readOutput = readOutput;
+  patcher.state = STATE_OP;
+  if (header.method == OTA_METHOD_RAW) {
+    // The whole payload is one literal.
+    patcher.op = OP_LITERAL;
+    patcher.remaining = header.imageSize;
+    patcher.state = STATE_LITERAL;
+  }
+}
+
+size_t ota_patch_run(OtaPatcher& patcher, const uint8_t* input, size_t length) {
+  size_t used = 0;
+  while (patcher.error == nullptr && patcher.windowFill < patcher.windowSize) {
+    if (patcher.state == STATE_COPY) {
+      copy_step(patcher);
+      continue;
+    }
+    if (used == length) break;
+
+    if (patcher.state == STATE_OP) {
+      uint8_t byte = input[used++];
+      patcher.op = byte >> 6;
+      if (patcher.op > OP_COPY_BASE || (patcher.op == OP_COPY_BASE && patcher.method != OTA_METHOD_DELTA)) {
+        patcher.error = "invalid operation";
+      } else if ((byte & LENGTH_EXTENDED) == LENGTH_EXTENDED) {
+        patcher.state = STATE_LENGTH;
+        patcher.varint = 0;
+        patcher.varintShift = 0;
+      } else {
+        patcher.remaining = (byte & LENGTH_EXTENDED) + 1;
+        start_operation(patcher);
+      }
+    } else if (patcher.state == STATE_LENGTH || patcher.state == STATE_ARGUMENT) {
+      uint8_t byte = input[used++];
+      if (patcher.varintShift > 28) {
+        patcher.error = "varint too long";
+        break;
+      }
+      patcher.varint |= (uint32_t)(byte & 0x7F) << patcher.varintShift;
+      patcher.varintShift += 7;
+      if (byte & 0x80) continue;
+      if (patcher.state == STATE_LENGTH) {
+        patcher.remaining = EXTENDED_LENGTH_BASE + patcher.varint;
+        if (patcher.remaining < EXTENDED_LENGTH_BASE) patcher.error = "length too long";
+        else start_operation(patcher);
+      } else {
+        finish_argument(patcher);
+      }
+    } else { // STATE_LITERAL
+      size_t n = patcher.remaining;
+      if (n > length - used) n = length - used;
+      if (n > patcher.windowSize - patcher.windowFill) n = patcher.windowSize - patcher.windowFill;
+      memcpy(patcher.window + patcher.windowFill, input + used, n);
+      used += n;
+      patcher.windowFill += n;
+      patcher.outPos += n;
+      patcher.remaining -= n;
+      if (patcher.remaining == 0) patcher.state = STATE_OP;
+    }
+  }
+  return used;
+}
+
+void ota_patch_window_emptied(OtaPatcher& patcher) {
+  patcher.windowFill = 0;
+}
+
+bool ota_patch_done(const OtaPatcher& patcher) {
+  return patcher.error == nullptr && patcher.state == STATE_OP && patcher.outPos == patcher.imageSize;
+}
+
+uint32_t ota_patch_crc32(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+// --- Static (Private) Function Implementations ---
+
+static uint32_t read_u32(const uint8_t* bytes) {
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+/**
+ * @brief Continues an operation once its length is known.
+ */
+static void start_operation(OtaPatcher& patcher) {
+  if (patcher.remaining > patcher.imageSize - patcher.outPos) {
+    patcher.error = "output beyond image size";
+    return;
+  }
+  if (patcher.op == OP_LITERAL) {
+    patcher.state = STATE_LITERAL;
+  } else {
+    patcher.state = STATE_ARGUMENT;
+    patcher.varint = 0;
+    patcher.varintShift = 0;
+  }
+}
+
+/**
+ * @brief Checks a copy's source once its argument is read.
+ */
+static void finish_argument(OtaPatcher& patcher) {
+  if (patcher.op == OP_COPY_OUT) {
+    if (patcher.varint == 0 || patcher.varint > patcher.outPos) {
+      patcher.error = "copy before start of output";
+      return;
+    }
+    patcher.distance = patcher.varint;
+  } else {
+    // Zigzag: 0, -1, 1, -2, ... are stored as 0, 1, 2, 3, ...
+    int64_t delta = (int64_t)(patcher.varint >> 1) ^ -(int64_t)(patcher.varint & 1);
+    int64_t start = (int64_t)patcher.basePos + delta;
+    if (start < 0 || start + patcher.remaining > patcher.baseSize) {
+      patcher.error = "copy outside running image";
+      return;
+    }
+    patcher.basePos = (uint32_t)start;
+  }
+  patcher.state = STATE_COPY;
+}
+
+/**
+ * @brief Copies as much of the current copy operation as fits the window in one piece.
+ */
+static void copy_step(OtaPatcher& patcher) {
+  size_t n = patcher.remaining;
+  if (n > patcher.windowSize - patcher.windowFill) n = patcher.windowSize - patcher.windowFill;
+  uint8_t* dest = patcher.window + patcher.windowFill;
+
+  if (patcher.op == OP_COPY_OUT) {
+    // At most `distance` bytes at a time, so the source never overlaps what this step writes.
+    if (n > patcher.distance) n = patcher.distance;
+    uint32_t from = patcher.outPos - patcher.distance;
+    uint32_t windowStart = patcher.outPos - (uint32_t)patcher.windowFill;
+    if (from >= windowStart) {
+      memcpy(dest, patcher.window + (from - windowStart), n);
+    } else {
+      if (n > windowStart - from) n = windowStart - from;
+      if (!patcher.readOutput(from, dest, n)) patcher.error = "cannot read back output";
+    }
+  } else {
+    if (!patcher.readBase(patcher.basePos, dest, n)) patcher.error = "cannot read running image";
+    patcher.basePos += n;
+  }
+  if (patcher.error != nullptr) return;
+
+  patcher.windowFill += n;
+  patcher.outPos += n;
+  patcher.remaining -= n;
+  if (patcher.remaining == 0) patcher.state = STATE_OP;
+}
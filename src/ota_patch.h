@@ -0,0 +1,137 @@
+/**
+ * @file ota_patch.h
+ * @brief Public interface for the firmware update format and its streaming decoder.
+ *
+ * An update file (written by `ota/make_update.py`) is a 32-byte header
+ * followed by a payload that rebuilds the new image. The payload is either
+ * the image itself (`OTA_METHOD_RAW`) or a sequence of operations:
+ *
+ *   op byte   bits 7-6: 0 LITERAL, 1 COPY_OUT, 2 COPY_BASE
+ *             bits 5-0: length - 1, or 63 for "64 + varint" follows
+ *   LITERAL   <length> bytes that are copied to the output
+ *   COPY_OUT  varint distance; copies <length> bytes from that far back in the output
+ *   COPY_BASE zigzag varint; copies <length> bytes of the running image, starting
+ *             that far from where the previous COPY_BASE ended
+ *
+ * `OTA_METHOD_LZ` only uses the first two, so it compresses a full image;
+ * `OTA_METHOD_DELTA` also copies from the running image, so an update only
+ * carries what changed. Varints are little-endian base 128.
+ *
+ * The decoder takes the payload in pieces of any size and writes the output
+ * into a window buffer that the caller empties to flash whenever it is full,
+ * so a whole image is rebuilt in a few kilobytes of RAM. Output older than
+ * the window and the running image are read back through callbacks. Like the
+ * history codec, this module is free of hardware dependencies.
+ */
+#ifndef OTA_PATCH_H
+#define OTA_PATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief "HOTA", little-endian.
+const uint32_t OTA_UPDATE_MAGIC = 0x41544F48;
+const uint8_t OTA_UPDATE_VERSION = 1;
+/// @brief The size of the update header in bytes.
+const size_t OTA_HEADER_SIZE = 32;
+
+/**
+ * @enum OtaMethod
+ * @brief How the payload rebuilds the image.
+ */
+enum OtaMethod : uint8_t {
+  OTA_METHOD_RAW = 0,   ///< The payload is the image.
+  OTA_METHOD_LZ = 1,    ///< Literals and copies from earlier output.
+  OTA_METHOD_DELTA = 2  ///< As LZ, plus copies from the running image.
+};
+
+/**
+ * @struct OtaHeader
+ * @brief The update header. Stored little-endian, fields in this order.
+ */
+struct OtaHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t method;
+  uint16_t reserved;
+  uint32_t imageSize;   ///< The size of the rebuilt image in bytes.
+  uint32_t imageCrc;    ///< CRC-32 of the rebuilt image.
+  uint32_t baseSize;    ///< Delta only: the size of the image the delta was made against.
+  uint32_t baseCrc;     ///< Delta only: CRC-32 of that image.
+  uint32_t payloadSize; ///< The size of the payload that follows the header.
+  uint32_t headerCrc;   ///< CRC-32 of the 28 bytes before it.
+};
+
+/// @brief Reads `length` bytes at `offset` into `out`; returns false on a read error.
+typedef bool (*OtaReadFn)(uint32_t offset, uint8_t* out, size_t length);
+
+/**
+ * @struct OtaPatcher
+ * @brief The decoder's state between pieces of payload.
+ */
+struct OtaPatcher {
+  uint8_t method;
+  uint8_t state;         ///< Where in an operation the decoder is.
+  uint8_t op;            ///< The current operation's type.
+  uint8_t varintShift;
+  uint32_t varint;       ///< The varint being read.
+  uint32_t remaining;    ///< Bytes left in the current operation.
+  uint32_t distance;     ///< COPY_OUT distance.
+  uint32_t basePos;      ///< The next running-image byte COPY_BASE reads.
+  uint32_t outPos;       ///< Output bytes produced so far.
+  uint32_t imageSize;
+  uint32_t baseSize;
+  uint8_t* window;       ///< Holds output bytes `[outPos - windowFill, outPos)`.
+  size_t windowSize;
+  size_t windowFill;
+  OtaReadFn readBase;    ///< Reads the running image.
+  OtaReadFn readOutput;  ///< Reads output that has already left the window.
+  const char* error;     ///< Set when the payload is invalid; nullptr otherwise.
+};
+
+/**
+ * @brief Parses and checks an update header.
+ * @param bytes The first `OTA_HEADER_SIZE` bytes of the update.
+ * @param header Receives the fields.
+ * @return nullptr if the header is valid, otherwise what is wrong with it.
+ */
+const char* ota_patch_parse_header(const uint8_t* bytes, OtaHeader& header);
+
+/**
+ * @brief Starts decoding a payload.
+ * @param patcher The decoder.
+ * @param header The update's header.
+ * @param window The output window buffer.
+ * @param windowSize The size of `window` in bytes.
+ * @param readBase Reads the running image (delta updates only; may be nullptr otherwise).
+ * @param readOutput Reads output that has already been emptied from the window.
+ */
+void ota_patch_init(OtaPatcher& patcher, const OtaHeader& header, uint8_t* window, size_t windowSize,
+                    OtaReadFn readBase, OtaReadFn readOutput);
+
+/**
+ * @brief Decodes payload bytes until they are used up or the window is full.
+ * @param patcher The decoder.
+ * @param input The next payload bytes.
+ * @param length The number of bytes in `input`.
+ * @return The number of input bytes consumed. Fewer than `length` means the
+ * window is full (empty it and call again) or `error` is set.
+ */
+size_t ota_patch_run(OtaPatcher& patcher, const uint8_t* input, size_t length);
+
+/**
+ * @brief Marks the window as emptied after its `windowFill` bytes were written out.
+ */
+void ota_patch_window_emptied(OtaPatcher& patcher);
+
+/**
+ * @brief Whether the whole image has been produced and no operation is left open.
+ */
+bool ota_patch_done(const OtaPatcher& patcher);
+
+/**
+ * @brief Continues a CRC-32 (IEEE, as zlib's `crc32()`); start with 0.
+ */
+uint32_t ota_patch_crc32(uint32_t crc, const uint8_t* data, size_t length);
+
+#endif // OTA_PATCH_H
@@ -0,0 +1,433 @@
+/**
+ * @file probe_calibration.cpp
+ * @brief Implements the field calibration of the pH and TDS probes.
+ */
+
+#include "probe_calibration.h"
+#include "config.h"
+#include "identity.h"
+#include "mqtt_handler.h"
+#include "number_format.h" // For printf-free float formatting in payloads
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct ProbeCalPoint
+ * @brief A measured calibration point.
+ */
+struct ProbeCalPoint {
+  float voltage;     ///< The settled probe voltage; NAN until measured.
+  float reference;   ///< The buffer's pH or the standard's ppm.
+  float waterTempC;  ///< TDS only: the water temperature when it settled.
+  uint32_t settleMs; ///< Time from the start of the point until it settled.
+};
+
+/**
+ * @struct ProbeCalMeasurement
+ * @brief The point being measured.
+ */
+struct ProbeCalMeasurement {
+  bool active;
+  bool ph;                               ///< The pH probe; the TDS probe otherwise.
+  int buffer;                            ///< pH only: the index into PH_BUFFERS.
+  float reference;
+  unsigned long startedAt;
+  unsigned long lastSampleAt;
+  unsigned long lastStatusAt;
+  uint32_t samples;
+  float blockSum;
+  int blockCount;
+  float blocks[PROBE_CAL_WINDOW_BLOCKS]; ///< Ring of block means in volts.
+  int numBlocks;
+  int nextBlock;                         ///< The oldest block once the ring is full.
+  float latestV;                         ///< The latest block mean, e.g. to trim the probe's offset by; NAN before.
+  float meanV;                           ///< The window's mean, standard deviation and drift; NAN until it is full.
+  float sdMv;
+  float driftMv;
+};
+
+/// @brief The pH buffers, in the order of the calibration voltages and their settings.
+static const int NUM_PH_BUFFERS = 3;
+static const float PH_BUFFERS[NUM_PH_BUFFERS] = {4.01f, 6.86f, 9.18f};
+static const char* const PH_KEYS[NUM_PH_BUFFERS] = {"ph_v401", "ph_v686", "ph_v918"};
+static float* const PH_VOLTAGES[NUM_PH_BUFFERS] = {&PH_CALIBRATION_VOLTAGE_401, &PH_CALIBRATION_VOLTAGE_686,
+                                                   &PH_CALIBRATION_VOLTAGE_918};
+/// @brief The strongest TDS standard accepted, in ppm.
+static const float TDS_STANDARD_MAX_PPM = 5000;
+
+static ProbeCalMeasurement measurement;
+static ProbeCalPoint phPoints[NUM_PH_BUFFERS] = {{NAN, 4.01f, NAN, 0}, {NAN, 6.86f, NAN, 0}, {NAN, 9.18f, NAN, 0}};
+static ProbeCalPoint tdsPoint = {NAN, NAN, NAN, 0};
+/// @brief Set while the probe is being calibrated, i.e. out of the reservoir.
+static bool phOpen = false;
+static bool tdsOpen = false;
+/// @brief The last command or finished point; the calibration expires this long after it.
+static unsigned long lastActivityAt = 0;
+/// @brief How the last point or save ended, e.g. "settled", and why a save was rejected.
+static const char* outcome = "idle";
+static char outcomeDetail[64] = "";
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void start_point(bool ph, int buffer, float reference);
+static void add_sample(float voltage, float waterTempC, unsigned long now);
+static void evaluate_window();
+static void save();
+static void clear_points();
+static void close_calibration(const char* result, bool keepPoints);
+static float ph_slope_mv(int lower, int upper);
+static const char* format_number(char* buffer, size_t size, float value, uint8_t decimals);
+
+// --- Public Function Implementations ---
+
+void probe_calibration_loop(const SensorValues& values) {
+  if (!phOpen && !tdsOpen) return;
+  unsigned long now = millis();
+
+  if (!measurement.active) {
+    if (now - lastActivityAt >= (unsigned long)PROBE_CAL_SESSION_TIMEOUT_MS) {
+      LOG_WARN("[ProbeCal] WARN: No command for %ld min, calibration cancelled.\n",
+               PROBE_CAL_SESSION_TIMEOUT_MS / 60000);
+      close_calibration("expired", false);
+      probe_calibration_publish_status();
+    }
+    return;
+  }
+
+  if (now - measurement.startedAt >= (unsigned long)PROBE_CAL_TIMEOUT_MS) {
+    LOG_WARN("[ProbeCal] WARN: Probe did not settle within %ld s (%.1f mV spread, %.1f mV drift).\n",
+             PROBE_CAL_TIMEOUT_MS / 1000, measurement.sdMv, measurement.driftMv);
+    measurement.active = false;
+    lastActivityAt = now;
+    outcome = "timeout";
+    probe_calibration_publish_status();
+    return;
+  }
+
+  if (now - measurement.lastSampleAt >= (unsigned long)PROBE_CAL_SAMPLE_INTERVAL_MS) {
+    measurement.lastSampleAt = now;
+    add_sample(measurement.ph ? sensors_read_ph_voltage() : sensors_read_tds_voltage(), values.waterTempC, now);
+  }
+  if (measurement.active && now - measurement.lastStatusAt >= (unsigned long)PROBE_CAL_STATUS_INTERVAL_MS) {
+    measurement.lastStatusAt = now;
+    probe_calibration_publish_status();
+  }
+}
+
+void probe_calibration_mask(SensorValues& values) {
+  if (phOpen) values.phValue = NAN;
+  if (tdsOpen) values.tdsPpm = NAN;
+}
+
+void probe_calibration_handle_command(const char* command) {
+  lastActivityAt = millis();
+  if (strcasecmp(command, "STATUS") == 0) {
+    probe_calibration_publish_status();
+    return;
+  } else if (strcasecmp(command, "CANCEL") == 0) {
+    LOG_INFO("[ProbeCal] Calibration cancelled.\n");
+    close_calibration("cancelled", false);
+    probe_calibration_publish_status();
+    return;
+  } else if (strcasecmp(command, "SAVE") == 0) {
+    save();
+    probe_calibration_publish_status();
+    return;
+  }
+
+  bool ph = strncasecmp(command, "PH ", 3) == 0;
+  if (!ph && strncasecmp(command, "TDS ", 4) != 0) {
+    LOG_WARN("[ProbeCal] WARN: Unknown command '%s', expected PH <buffer>, TDS <ppm>, SAVE, CANCEL or STATUS.\n",
+             command);
+    return;
+  }
+  const char* text = command + (ph ? 3 : 4);
+  char* end = nullptr;
+  float reference = strtof(text, &end);
+  bool valid = end != text && *end == '\0';
+  int buffer = -1;
+  if (ph) {
+    for (int i = 0; i < NUM_PH_BUFFERS; i++) {
+      if (fabsf(reference - PH_BUFFERS[i]) < 0.005f) buffer = i;
+    }
+    valid = valid && buffer >= 0;
+  } else {
+    valid = valid && reference > 0 && reference <= TDS_STANDARD_MAX_PPM;
+  }
+  if (!valid) {
+    LOG_WARN("[ProbeCal] WARN: '%s' is neither a pH buffer (4.01, 6.86, 9.18) nor a TDS standard up to %.0f ppm.\n",
+             command, TDS_STANDARD_MAX_PPM);
+    return;
+  }
+  start_point(ph, buffer, reference);
+  probe_calibration_publish_status();
+}
+
+void probe_calibration_publish_status() {
+  char a[16], b[16], c[16], d[16], e[16], f[16];
+  char payload[640];
+  int length = snprintf(payload, sizeof(payload),
+                        "{\"result\":\"%s\",\"detail\":\"%s\",\"ph_open\":%s,\"tds_open\":%s", outcome,
+                        outcomeDetail, phOpen ? "true" : "false", tdsOpen ? "true" : "false");
+  if (measurement.active) {
+    length += snprintf(payload + length, sizeof(payload) - length,
+                       ",\"measuring\":{\"probe\":\"%s\",\"reference\":%s,\"elapsed_s\":%s,\"samples\":%u,"
+                       "\"voltage\":%s,\"sd_mv\":%s,\"drift_mv\":%s}",
+                       measurement.ph ? "ph" : "tds", format_number(a, sizeof(a), measurement.reference, 2),
+                       format_number(b, sizeof(b), (millis() - measurement.startedAt) / 1000.0f, 1),
+                       (unsigned)measurement.samples, format_number(c, sizeof(c), measurement.latestV, 4),
+                       format_number(d, sizeof(d), measurement.sdMv, 1),
+                       format_number(e, sizeof(e), measurement.driftMv, 1));
+  }
+  length += snprintf(payload + length, sizeof(payload) - length, ",\"points\":[");
+  for (int i = 0; i < NUM_PH_BUFFERS; i++) {
+    const ProbeCalPoint& point = phPoints[i];
+    length += snprintf(payload + length, sizeof(payload) - length, "%s{\"ph\":%s,\"voltage\":%s,\"settle_s\":%s}",
+                       i > 0 ? "," : "", format_number(a, sizeof(a), point.reference, 2),
+                       format_number(b, sizeof(b), point.voltage, 4),
+                       format_number(c, sizeof(c), isnan(point.voltage) ? NAN : point.settleMs / 1000.0f, 1));
+  }
+  if (!isnan(tdsPoint.voltage)) {
+    length += snprintf(payload + length, sizeof(payload) - length,
+                       ",{\"ppm\":%s,\"voltage\":%s,\"water_temp\":%s,\"settle_s\":%s}",
+                       format_number(a, sizeof(a), tdsPoint.reference, 1),
+                       format_number(b, sizeof(b), tdsPoint.voltage, 4),
+                       format_number(c, sizeof(c), tdsPoint.waterTempC, 2),
+                       format_number(d, sizeof(d), tdsPoint.settleMs / 1000.0f, 1));
+  }
+  // The calibration in use, with the slopes of its two segments.
+  snprintf(payload + length, sizeof(payload) - length,
+           "],\"ph\":{\"v401\":%s,\"v686\":%s,\"v918\":%s,\"slope_acid_mv\":%s,\"slope_alkaline_mv\":%s},"
+           "\"tds_k\":%s}",
+           format_number(a, sizeof(a), PH_CALIBRATION_VOLTAGE_401, 4),
+           format_number(b, sizeof(b), PH_CALIBRATION_VOLTAGE_686, 4),
+           format_number(c, sizeof(c), PH_CALIBRATION_VOLTAGE_918, 4),
+           format_number(d, sizeof(d), (PH_CALIBRATION_VOLTAGE_401 - PH_CALIBRATION_VOLTAGE_686) * 1000 /
+                                           (PH_BUFFERS[1] - PH_BUFFERS[0]), 1),
+           format_number(e, sizeof(e), (PH_CALIBRATION_VOLTAGE_686 - PH_CALIBRATION_VOLTAGE_918) * 1000 /
+                                           (PH_BUFFERS[2] - PH_BUFFERS[1]), 1),
+           format_number(f, sizeof(f), TDS_K_VALUE, 2));
+  mqtt_publish_state(STATE_TOPIC_PROBE_CALIBRATION, payload, true);
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Starts measuring a point; a point still being measured is abandoned.
+ * @param ph The pH probe; the TDS probe otherwise.
+ * @param buffer pH only: the index into PH_BUFFERS.
+ * @param reference The buffer's pH or the standard's ppm.
+ */
+static void start_point(bool ph, int buffer, float reference) {
+  if (measurement.active) LOG_INFO("[ProbeCal] The point being measured is abandoned.\n");
+  // A new calibration starts without the points of the last one.
+  if (!phOpen && !tdsOpen) clear_points();
+  memset(&measurement, 0, sizeof(measurement));
+  measurement.active = true;
+  measurement.ph = ph;
+  measurement.buffer = buffer;
+  measurement.reference = reference;
+  measurement.startedAt = millis();
+  measurement.lastSampleAt = measurement.startedAt;
+  measurement.lastStatusAt = measurement.startedAt;
+  measurement.latestV = NAN;
+  measurement.meanV = NAN;
+  measurement.sdMv = NAN;
+  measurement.driftMv = NAN;
+  if (ph) {
+    phOpen = true;
+  } else {
+    tdsOpen = true;
+  }
+  outcome = "measuring";
+  outcomeDetail[0] = '\0';
+  LOG_INFO("[ProbeCal] Measuring the %s probe in %.*f %s.\n", ph ? "pH" : "TDS", ph ? 2 : 0, reference,
+           ph ? "pH buffer" : "ppm standard");
+}
+
+/**
+ * @brief Adds one ADC sample. Every completed block updates the window; once
+ * the window has settled, the point is taken.
+ * @param voltage The sample in Volts.
+ * @param waterTempC The latest water temperature.
+ * @param now The current `millis()`.
+ */
+static void add_sample(float voltage, float waterTempC, unsigned long now) {
+  measurement.samples++;
+  measurement.blockSum += voltage;
+  if (++measurement.blockCount < PROBE_CAL_BLOCK_SAMPLES) return;
+
+  measurement.latestV = measurement.blockSum / measurement.blockCount;
+  measurement.blocks[measurement.nextBlock] = measurement.latestV;
+  measurement.nextBlock = (measurement.nextBlock + 1) % PROBE_CAL_WINDOW_BLOCKS;
+  if (measurement.numBlocks < PROBE_CAL_WINDOW_BLOCKS) measurement.numBlocks++;
+  measurement.blockSum = 0;
+  measurement.blockCount = 0;
+  if (measurement.numBlocks < PROBE_CAL_WINDOW_BLOCKS) return;
+
+  evaluate_window();
+  if (measurement.sdMv > PROBE_CAL_STABLE_MV || fabsf(measurement.driftMv) > PROBE_CAL_DRIFT_MV) return;
+
+  ProbeCalPoint& point = measurement.ph ? phPoints[measurement.buffer] : tdsPoint;
+  point.voltage = measurement.meanV;
+  point.reference = measurement.reference;
+  point.waterTempC = waterTempC;
+  point.settleMs = now - measurement.startedAt;
+  measurement.active = false;
+  lastActivityAt = now;
+  outcome = "settled";
+  LOG_INFO("[ProbeCal] %s %.*f settled at %.4f V after %.1f s (%.1f mV spread, %.1f mV drift).\n",
+           measurement.ph ? "pH" : "TDS", measurement.ph ? 2 : 0, measurement.reference, point.voltage, point.settleMs / 1000.0f,
+           measurement.sdMv, measurement.driftMv);
+  probe_calibration_publish_status();
+}
+
+/**
+ * @brief Computes the mean and standard deviation of the full window's block
+ * means, and the drift: the mean of the newer half minus that of the older half.
+ * A probe still approaching its plateau drifts even when it no longer scatters.
+ */
+static void evaluate_window() {
+  const int half = PROBE_CAL_WINDOW_BLOCKS / 2;
+  float sum = 0;
+  float older = 0;
+  for (int i = 0; i < PROBE_CAL_WINDOW_BLOCKS; i++) {
+    float block = measurement.blocks[(measurement.nextBlock + i) % PROBE_CAL_WINDOW_BLOCKS];
+    sum += block;
+    if (i < half) older += block;
+  }
+  float mean = sum / PROBE_CAL_WINDOW_BLOCKS;
+  float squares = 0;
+  for (int i = 0; i < PROBE_CAL_WINDOW_BLOCKS; i++) {
+    float deviation = measurement.blocks[i] - mean;
+    squares += deviation * deviation;
+  }
+  measurement.meanV = mean;
+  measurement.sdMv = sqrtf(squares / PROBE_CAL_WINDOW_BLOCKS) * 1000;
+  measurement.driftMv = ((sum - older) / (PROBE_CAL_WINDOW_BLOCKS - half) - older / half) * 1000;
+}
+
+/**
+ * @brief Checks the measured points, fits the calibration and stores it.
+ * pH buffers not measured keep their current voltage; the three voltages must
+ * fall with rising pH, and both segment slopes must be plausible. The TDS cell
+ * constant is the inverse of the firmware's compensated conversion.
+ */
+static void save() {
+  outcome = "rejected";
+  if (!phOpen && !tdsOpen) {
+    snprintf(outcomeDetail, sizeof(outcomeDetail), "no calibration is open");
+    LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+    return;
+  }
+  if (measurement.active) {
+    snprintf(outcomeDetail, sizeof(outcomeDetail), "a point is still being measured");
+    LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+    return;
+  }
+  int phMeasured = 0;
+  for (int i = 0; i < NUM_PH_BUFFERS; i++) phMeasured += !isnan(phPoints[i].voltage);
+  bool tdsMeasured = !isnan(tdsPoint.voltage);
+  if (phMeasured == 0 && !tdsMeasured) {
+    snprintf(outcomeDetail, sizeof(outcomeDetail), "no point was measured");
+    LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+    return;
+  }
+
+  if (phMeasured > 0) {
+    for (int i = 0; i < NUM_PH_BUFFERS; i++) {
+      float voltage = isnan(phPoints[i].voltage) ? *PH_VOLTAGES[i] : phPoints[i].voltage;
+      if (isnan(sensors_ph_from_voltage(voltage))) {
+        char buffer[16], volts[16];
+        number_format_fixed(buffer, sizeof(buffer), PH_BUFFERS[i], 2);
+        number_format_fixed(volts, sizeof(volts), voltage, 3);
+        snprintf(outcomeDetail, sizeof(outcomeDetail), "pH %s at %s V is out of range", buffer, volts);
+        LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+        return;
+      }
+    }
+    float slopeAcid = ph_slope_mv(0, 1);
+    float slopeAlkaline = ph_slope_mv(1, 2);
+    if (!(slopeAcid >= PROBE_CAL_PH_SLOPE_MIN_MV && slopeAcid <= PROBE_CAL_PH_SLOPE_MAX_MV &&
+          slopeAlkaline >= PROBE_CAL_PH_SLOPE_MIN_MV && slopeAlkaline <= PROBE_CAL_PH_SLOPE_MAX_MV)) {
+      char acid[16], alkaline[16];
+      number_format_fixed(acid, sizeof(acid), slopeAcid, 0);
+      number_format_fixed(alkaline, sizeof(alkaline), slopeAlkaline, 0);
+      snprintf(outcomeDetail, sizeof(outcomeDetail), "pH slopes %s and %s mV/pH are implausible", acid, alkaline);
+      LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+      return;
+    }
+  }
+
+  // The cell constant is range-checked when it is stored, so it goes first:
+  // a rejected constant leaves the pH calibration untouched as well.
+  if (tdsMeasured) {
+    if (isnan(tdsPoint.waterTempC) || isnan(sensors_tds_from_voltage(tdsPoint.voltage, tdsPoint.waterTempC))) {
+      char volts[16];
+      number_format_fixed(volts, sizeof(volts), tdsPoint.voltage, 3);
+      snprintf(outcomeDetail, sizeof(outcomeDetail), "TDS at %s V or its water temperature is invalid", volts);
+      LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+      return;
+    }
+    float k = tdsPoint.reference * (1.0f + TDS_TEMP_COEFF * (tdsPoint.waterTempC - 25.0f)) / tdsPoint.voltage;
+    if (!identity_set_number("tds_k", k)) {
+      char constant[16];
+      number_format_fixed(constant, sizeof(constant), k, 1);
+      snprintf(outcomeDetail, sizeof(outcomeDetail), "TDS cell constant %s is out of range", constant);
+      LOG_WARN("[ProbeCal] WARN: Not saved, %s.\n", outcomeDetail);
+      return;
+    }
+  }
+  for (int i = 0; i < NUM_PH_BUFFERS; i++) {
+    if (!isnan(phPoints[i].voltage) && !identity_set_number(PH_KEYS[i], phPoints[i].voltage)) {
+      snprintf(outcomeDetail, sizeof(outcomeDetail), "%s could not be stored", PH_KEYS[i]);
+      LOG_WARN("[ProbeCal] WARN: Not fully saved, %s.\n", outcomeDetail);
+      return;
+    }
+  }
+  LOG_INFO("[ProbeCal] Calibration saved: %d pH point(s)%s.\n", phMeasured, tdsMeasured ? " and TDS" : "");
+  close_calibration("saved", true);
+}
+
+/**
+ * @brief Ends the calibration: the probes return to service.
+ * @param result The outcome to report.
+ * @param keepPoints Whether the measured points stay in the status until the next calibration.
+ */
+static void close_calibration(const char* result, bool keepPoints) {
+  measurement.active = false;
+  phOpen = false;
+  tdsOpen = false;
+  if (!keepPoints) clear_points();
+  outcome = result;
+  outcomeDetail[0] = '\0';
+}
+
+/**
+ * @brief Drops the measured points.
+ */
+static void clear_points() {
+  for (int i = 0; i < NUM_PH_BUFFERS; i++) phPoints[i].voltage = NAN;
+  tdsPoint.voltage = NAN;
+}
+
+/**
+ * @brief The slope of a pH segment in mV per pH, from the measured voltages
+ * where there are any and the current calibration otherwise. Positive when the
+ * voltage falls with rising pH, as it should.
+ * @param lower The index of the segment's lower buffer.
+ * @param upper The index of the segment's upper buffer.
+ */
+static float ph_slope_mv(int lower, int upper) {
+  float lowerV = isnan(phPoints[lower].voltage) ? *PH_VOLTAGES[lower] : phPoints[lower].voltage;
+  float upperV = isnan(phPoints[upper].voltage) ? *PH_VOLTAGES[upper] : phPoints[upper].voltage;
+  return (lowerV - upperV) * 1000 / (PH_BUFFERS[upper] - PH_BUFFERS[lower]);
+}
+
+/**
+ * @brief Formats a value for a JSON payload: "null" when it is NAN.
+ * @return `buffer`.
+ */
+static const char* format_number(char* buffer, size_t size, float value, uint8_t decimals) {
+  if (isnan(value) || number_format_fixed(buffer, size, value, decimals) == 0) snprintf(buffer, size, "null");
+  return buffer;
+}
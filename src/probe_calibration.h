@@ -0,0 +1,60 @@
+/**
+ * @file probe_calibration.h
+ * @brief Public interface for calibrating the pH and TDS probes in the field.
+ *
+ * The probe is put into a buffer or standard solution and a command on
+ * `.../sensor/kalibrasi/kontrol` starts a calibration point. The probe's ADC is
+ * then sampled every PROBE_CAL_SAMPLE_INTERVAL_MS, the samples are averaged in
+ * blocks of PROBE_CAL_BLOCK_SAMPLES, and the point is taken as soon as the last
+ * PROBE_CAL_WINDOW_BLOCKS block means have settled: their standard deviation
+ * is below PROBE_CAL_STABLE_MV, and the drift between the older and newer
+ * half of the window is below PROBE_CAL_DRIFT_MV. The time this took is
+ * reported with the point; an ageing pH electrode settles ever more slowly.
+ *
+ * Commands:
+ *   - `PH 4.01`, `PH 6.86` or `PH 9.18` measures the pH probe in that buffer;
+ *   - `TDS <ppm>` measures the TDS probe in a standard of that TDS. The water
+ *     temperature probe must be in the standard as well, for the compensation;
+ *   - `SAVE` checks the measured points, fits the calibration and stores it
+ *     with `identity_set_number()`, where it replaces the build's values at
+ *     once and after every reboot. A pH buffer not measured keeps its voltage.
+ *     The points stay in the status until the next calibration starts;
+ *   - `CANCEL` drops the measured points, `STATUS` publishes the status.
+ *
+ * While a calibration is open the probe being calibrated is out of the
+ * reservoir, so its readings are replaced by NAN (see `probe_calibration_mask()`)
+ * and neither the automations nor the history see a buffer. A calibration
+ * without a command for PROBE_CAL_SESSION_TIMEOUT_MS is cancelled.
+ */
+#ifndef PROBE_CALIBRATION_H
+#define PROBE_CALIBRATION_H
+
+#include "sensors.h" // For SensorValues struct
+
+/**
+ * @brief Main loop for the probe calibration. Samples the probe while a point
+ * is measured and publishes its progress.
+ * @param values The latest sensor readings, for the water temperature.
+ */
+void probe_calibration_loop(const SensorValues& values);
+
+/**
+ * @brief Replaces the readings of the probes under calibration with NAN.
+ * Call right after the sensors were read, before the readings are used.
+ * @param values The sensor readings.
+ */
+void probe_calibration_mask(SensorValues& values);
+
+/**
+ * @brief Handles a command from the probe calibration topic (see above).
+ * @param command The command payload.
+ */
+void probe_calibration_handle_command(const char* command);
+
+/**
+ * @brief Publishes the calibration in use, the measured points and the
+ * progress of the point being measured (retained).
+ */
+void probe_calibration_publish_status();
+
+#endif // PROBE_CALIBRATION_H
@@ -0,0 +1,75 @@
+/**
+ * @file pump_flow.cpp
+ * @brief Implements the per-pump volumetric flow model.
+ */
+
+#include "pump_flow.h"
+#include <math.h>
+
+/// @brief Rates outside this range (ms/ml) indicate a measuring mistake, not a pump.
+static const float MIN_MS_PER_ML = 1.0f;
+static const float MAX_MS_PER_ML = 1000.0f;
+/// @brief Two calibration runs must differ by this factor in length to solve for dead time.
+static const float MIN_RUN_RATIO_FOR_FIT = 1.5f;
+
+void pump_flow_reset(PumpFlowModel& model, float msPerMl) {
+  model.msPerMl = msPerMl;
+  model.deadTimeMs = 0;
+  model.calRunMs[0] = model.calRunMs[1] = 0;
+  model.calMl[0] = model.calMl[1] = 0;
+  model.calPoints = 0;
+}
+
+unsigned long pump_flow_duration_ms(const PumpFlowModel& model, float ml) {
+  if (!(ml > 0)) return 0;
+  return (unsigned long)(model.deadTimeMs + ml * model.msPerMl + 0.5f);
+}
+
+float pump_flow_volume_ml(const PumpFlowModel& model, unsigned long runMs) {
+  float deliveringMs = (float)runMs - model.deadTimeMs;
+  return deliveringMs > 0 ? deliveringMs / model.msPerMl : 0;
+}
+
+bool pump_flow_add_calibration(PumpFlowModel& model, float runMs, float measuredMl) {
+  if (!(runMs > 0) || !(measuredMl > 0)) return false;
+
+  // Keep the two most recent points.
+  if (model.calPoints == 2) {
+    model.calRunMs[0] = model.calRunMs[1];
+    model.calMl[0] = model.calMl[1];
+    model.calPoints = 1;
+  }
+  model.calRunMs[model.calPoints] = runMs;
+  model.calMl[model.calPoints] = measuredMl;
+  model.calPoints++;
+
+  float msPerMl = model.msPerMl;
+  float deadTimeMs = model.deadTimeMs;
+  float longer = fmaxf(model.calRunMs[0], model.calRunMs[1]);
+  float shorter = fminf(model.calRunMs[0], model.calRunMs[1]);
+
+  if (model.calPoints == 2 && shorter > 0 && longer / shorter >= MIN_RUN_RATIO_FOR_FIT &&
+      model.calMl[1] != model.calMl[0]) {
+    // Two-point fit: slope is the rate, intercept the dead time.
+    msPerMl = (model.calRunMs[1] - model.calRunMs[0]) / (model.calMl[1] - model.calMl[0]);
+    deadTimeMs = fmaxf(0.0f, model.calRunMs[1] - model.calMl[1] * msPerMl);
+  } else {
+    msPerMl = (runMs - deadTimeMs) / measuredMl;
+  }
+
+  if (!(msPerMl >= MIN_MS_PER_ML && msPerMl <= MAX_MS_PER_ML)) {
+    model.calPoints--; // Discard the implausible point.
+    return false;
+  }
+  model.msPerMl = msPerMl;
+  model.deadTimeMs = deadTimeMs;
+  return true;
+}
+
+void pump_flow_apply_response(PumpFlowModel& model, unsigned long runMs, float deliveredMl, float gain) {
+  float deliveringMs = (float)runMs - model.deadTimeMs;
+  if (!(deliveredMl > 0) || deliveringMs <= 0) return;
+  float impliedMsPerMl = deliveringMs / deliveredMl;
+  if (!(impliedMsPerMl >= MIN_MS_PER_ML && impliedMsPerMl <= MAX_MS_PER_ML)) return;
+  model.msPerMl += gain * (impliedMsPerMl - model.msPerMl);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file pump_flow.h
+ * @brief Public interface for the per-pump volumetric flow model.
+ *
+ * A dosing pump is modelled as a startup dead time (tube priming, motor
+ * spin-up) followed by a constant flow: `run_ms = dead_ms + ml * ms_per_ml`.
+ * The model is refitted from calibration runs and trimmed from the measured
+ * TDS response. Like the pump monitor, this module is free of hardware
+ * dependencies.
+ */
+#ifndef PUMP_FLOW_H
+#define PUMP_FLOW_H
+
+#include <stdint.h>
+
+/**
+ * @struct PumpFlowModel
+ * @brief The calibrated flow model of a single dosing pump. Persisted as-is in NVS.
+ */
+struct PumpFlowModel {
+    float msPerMl;      ///< Run time per milliliter once the pump is delivering.
+    float deadTimeMs;   ///< Run time before the first milliliter arrives.
+    float calRunMs[2];  ///< Run times of the two most recent calibration runs.
+    float calMl[2];     ///< Volumes measured for the two most recent calibration runs.
+    uint8_t calPoints;  ///< The number of valid calibration points (0-2).
+};
+
+/**
+ * @brief Resets a model to a pure rate with no dead time and no calibration history.
+ * @param model The model to reset.
+ * @param msPerMl The default run time per milliliter.
+ */
+void pump_flow_reset(PumpFlowModel& model, float msPerMl);
+
+/**
+ * @brief Computes how long to run the pump to deliver a volume.
+ * @param model The pump's flow model.
+ * @param ml The volume to deliver.
+ * @return The run time in milliseconds, or 0 if `ml` is not positive.
+ */
+unsigned long pump_flow_duration_ms(const PumpFlowModel& model, float ml);
+
+/**
+ * @brief Estimates the volume delivered by a run of the given length.
+ * @param model The pump's flow model.
+ * @param runMs How long the pump actually ran.
+ * @return The delivered volume in milliliters.
+ */
+float pump_flow_volume_ml(const PumpFlowModel& model, unsigned long runMs);
+
+/**
+ * @brief Adds a calibration point and refits the model.
+ * With two points of sufficiently different run time, both rate and dead time
+ * are solved for; otherwise only the rate is updated, keeping the dead time.
+ * @param model The pump's flow model.
+ * @param runMs The calibration run time.
+ * @param measuredMl The volume measured in a graduated cylinder.
+ * @return true if the model was updated, false if the point was implausible.
+ */
+bool pump_flow_add_calibration(PumpFlowModel& model, float runMs, float measuredMl);
+
+/**
+ * @brief Trims the rate from an independent estimate of a run's delivered volume.
+ * @param model The pump's flow model.
+ * @param runMs How long the pump ran.
+ * @param deliveredMl The volume inferred from the measured TDS response.
+ * @param gain How far to move towards the implied rate (0-1).
+ */
+void pump_flow_apply_response(PumpFlowModel& model, unsigned long runMs, float deliveredMl, float gain);
+
+#endif // PUMP_FLOW_H
@@ -0,0 +1,132 @@
+/**
+ * @file pump_monitor.cpp
+ * @brief Implements the pump current-signature monitor.
+ */
+
+#include "pump_monitor.h"
+#include <math.h>
+
+// --- Module-Private (Static) Constants ---
+
+/// @brief Minimum number of exact steady samples before a run's mean is trusted for learning.
+/// A 300 ms dose has room for a single one; the caller checks the mean against the rated draw.
+static const uint32_t MIN_LEARNING_SAMPLES = 1;
+/// @brief A short run spends at most this fraction of its planned length in the inrush window.
+static const unsigned long INRUSH_SHARE_DIVISOR = 2;
+/// @brief Fewest consecutive abnormal samples that stop a running pump; shorter runs are judged at their end.
+static const uint8_t MIN_CONFIRM_SAMPLES = 2;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static PumpFault classify_sample(const PumpMonitorConfig& cfg, float baselineW, float shareW);
+
+// --- Public Function Implementations ---
+
+void pump_monitor_start(PumpRunMonitor& run, const PumpMonitorConfig& cfg, unsigned long nowMs,
+                        unsigned long plannedMs, float refPowerW, float refCurrentA) {
+  run.startMs = nowMs;
+  run.inrushMs = cfg.inrushMs;
+  run.confirmSamples = cfg.confirmSamples;
+  if (plannedMs > 0) {
+    // Leave room for samples after the inrush, and confirm with as many as the run can still take.
+    if (run.inrushMs > plannedMs / INRUSH_SHARE_DIVISOR) run.inrushMs = plannedMs / INRUSH_SHARE_DIVISOR;
+    unsigned long steadySamples = cfg.sampleIntervalMs > 0 ? (plannedMs - run.inrushMs) / cfg.sampleIntervalMs : 0;
+    if (steadySamples < run.confirmSamples) {
+      run.confirmSamples = steadySamples > MIN_CONFIRM_SAMPLES ? (uint8_t)steadySamples : MIN_CONFIRM_SAMPLES;
+    }
+  }
+  run.disturbed = false;
+  run.refPowerW = refPowerW;
+  run.refCurrentA = refCurrentA;
+  run.exact = !isnan(refPowerW) && !isnan(refCurrentA);
+  run.steadySamples = 0;
+  run.shareSumW = 0;
+  run.shareSumA = 0;
+  run.exactSamples = 0;
+  run.energyWh = 0;
+  run.lowCount = 0;
+  run.highCount = 0;
+  run.deadCount = 0;
+  run.fault = PUMP_FAULT_NONE;
+}
+
+PumpFault pump_monitor_sample(PumpRunMonitor& run, const PumpMonitorConfig& cfg, float baselineW,
+                              float shareW, float shareA, bool evaluate, unsigned long nowMs) {
+  // Inrush current and priming make the first moments of a run unrepresentative.
+  if (nowMs - run.startMs < run.inrushMs || isnan(shareW)) {
+    return run.fault;
+  }
+
+  run.steadySamples++;
+  if (run.exact && !isnan(shareA)) {
+    run.shareSumW += shareW;
+    run.shareSumA += shareA;
+    run.exactSamples++;
+  }
+
+  if (!evaluate) run.disturbed = true;
+  if (!evaluate || run.fault != PUMP_FAULT_NONE) {
+    return run.fault;
+  }
+
+  // Each condition must hold for several consecutive samples, so a single
+  // noisy reading never stops a pump.
+  PumpFault sample = classify_sample(cfg, baselineW, shareW);
+  run.deadCount = sample == PUMP_FAULT_RELAY ? run.deadCount + 1 : 0;
+  run.lowCount = sample == PUMP_FAULT_DRY_RUN ? run.lowCount + 1 : 0;
+  run.highCount = sample == PUMP_FAULT_BLOCKED ? run.highCount + 1 : 0;
+
+  if (run.deadCount >= run.confirmSamples) {
+    run.fault = PUMP_FAULT_RELAY;
+  } else if (run.lowCount >= run.confirmSamples) {
+    run.fault = PUMP_FAULT_DRY_RUN;
+  } else if (run.highCount >= run.confirmSamples) {
+    run.fault = PUMP_FAULT_BLOCKED;
+  }
+  return run.fault;
+}
+
+PumpFault pump_monitor_finish(PumpRunMonitor& run, const PumpMonitorConfig& cfg, float baselineW) {
+  // Runs long enough to confirm a fault have been judged sample by sample already.
+  if (run.fault != PUMP_FAULT_NONE || run.steadySamples >= run.confirmSamples) return run.fault;
+  if (!run.exact || run.disturbed || run.exactSamples == 0) return run.fault;
+  run.fault = classify_sample(cfg, baselineW, (float)(run.shareSumW / run.exactSamples));
+  return run.fault;
+}
+
+void pump_monitor_add_energy(PumpRunMonitor& run, float watts, unsigned long dtMs) {
+  if (isnan(watts) || watts <= 0) return;
+  run.energyWh += (double)watts * dtMs / 3600000.0;
+}
+
+bool pump_monitor_steady_mean(const PumpRunMonitor& run, float& meanW, float& meanA) {
+  if (!run.exact || run.exactSamples < MIN_LEARNING_SAMPLES) return false;
+  meanW = (float)(run.shareSumW / run.exactSamples);
+  meanA = (float)(run.shareSumA / run.exactSamples);
+  return true;
+}
+
+const char* pump_fault_name(PumpFault fault) {
+  switch (fault) {
+    case PUMP_FAULT_DRY_RUN: return "dry_run";
+    case PUMP_FAULT_BLOCKED: return "blocked";
+    case PUMP_FAULT_RELAY: return "relay";
+    default: return "none";
+  }
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Classifies one power share, or the mean share of a run, against the baseline.
+ * Without a learned draw there is nothing to compare against, so only the
+ * absence of any draw is judged.
+ * @return The fault the share shows, or PUMP_FAULT_NONE.
+ */
+static PumpFault classify_sample(const PumpMonitorConfig& cfg, float baselineW, float shareW) {
+  if (shareW < cfg.relayMinDeltaW) return PUMP_FAULT_RELAY;
+  if (!(baselineW > 0)) return PUMP_FAULT_NONE;
+  float ratio = shareW / baselineW;
+  if (ratio < cfg.dryRunRatio) return PUMP_FAULT_DRY_RUN;
+  if (ratio > cfg.blockedRatio) return PUMP_FAULT_BLOCKED;
+  return PUMP_FAULT_NONE;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file pump_monitor.h
+ * @brief Public interface for the pump current-signature monitor.
+ *
+ * The monitor follows a single pump run sample by sample and compares the
+ * power attributed to the pump against its learned baseline to detect dry
+ * running, blockages and failed relays. It also integrates the energy the run
+ * consumed. The module has no hardware or Arduino dependencies, so recorded
+ * PZEM traces can be replayed through it on the host (see test/test_pump_monitor).
+ *
+ * A dose is often shorter than the inrush window and the confirmation samples
+ * together, so both are scaled down to the planned run length. A run that
+ * still ended before a fault could be confirmed sample by sample is judged
+ * once more when it ends, on the mean of its steady samples.
+ */
+#ifndef PUMP_MONITOR_H
+#define PUMP_MONITOR_H
+
+#include <stdint.h>
+
+/// @brief The faults the monitor can recognise in a pump's power signature.
+enum PumpFault {
+    PUMP_FAULT_NONE,    ///< The signature matches the learned baseline.
+    PUMP_FAULT_DRY_RUN, ///< Clearly less power than learned: the pump is running without liquid.
+    PUMP_FAULT_BLOCKED, ///< Clearly more power than learned: the line is blocked or the pump is stalling.
+    PUMP_FAULT_RELAY    ///< No measurable draw at all: the relay did not switch or the pump is disconnected.
+};
+
+/**
+ * @struct PumpMonitorConfig
+ * @brief Detection thresholds shared by all pumps.
+ */
+struct PumpMonitorConfig {
+    unsigned long inrushMs; ///< Samples this soon after switch-on are ignored (inrush and priming).
+    unsigned long sampleIntervalMs; ///< The interval between power samples while a pump runs.
+    float dryRunRatio;      ///< Share/baseline below this counts as a dry-run sample.
+    float blockedRatio;     ///< Share/baseline above this counts as a blockage sample.
+    float relayMinDeltaW;   ///< A share below this many watts counts as "no draw".
+    uint8_t confirmSamples; ///< Consecutive abnormal samples needed before a fault is reported.
+};
+
+/**
+ * @struct PumpRunMonitor
+ * @brief The state of one monitored pump run.
+ */
+struct PumpRunMonitor {
+    unsigned long startMs;  ///< Time of switch-on.
+    unsigned long inrushMs; ///< The inrush window of this run, scaled to its planned length.
+    uint8_t confirmSamples; ///< Abnormal samples needed to confirm a fault during this run, scaled likewise.
+    bool disturbed;         ///< A sample was taken while another pump dominated the reading.
+    float refPowerW;        ///< Total power reading just before switch-on (NAN if unknown).
+    float refCurrentA;      ///< Total current reading just before switch-on (NAN if unknown).
+    bool exact;             ///< true while no other pump switched during this run, so share = reading - reference.
+    uint32_t steadySamples; ///< Samples taken after the inrush window.
+    double shareSumW;       ///< Sum of the pump's power share over exact steady samples.
+    double shareSumA;       ///< Sum of the pump's current share over exact steady samples.
+    uint32_t exactSamples;  ///< Number of samples included in the share sums.
+    double energyWh;        ///< Energy attributed to this pump during the run.
+    uint8_t lowCount;       ///< Consecutive dry-run samples.
+    uint8_t highCount;      ///< Consecutive blockage samples.
+    uint8_t deadCount;      ///< Consecutive no-draw samples.
+    PumpFault fault;        ///< The first confirmed fault of this run (sticky).
+};
+
+/**
+ * @brief Starts monitoring a new run.
+ * @param run The monitor to reset.
+ * @param cfg The detection thresholds.
+ * @param nowMs The switch-on time in milliseconds.
+ * @param plannedMs The planned run length, or 0 for a run without a planned end.
+ * @param refPowerW The total power reading just before switch-on, or NAN.
+ * @param refCurrentA The total current reading just before switch-on, or NAN.
+ */
+void pump_monitor_start(PumpRunMonitor& run, const PumpMonitorConfig& cfg, unsigned long nowMs,
+                        unsigned long plannedMs, float refPowerW, float refCurrentA);
+
+/**
+ * @brief Feeds one power sample to a running monitor.
+ * @param run The monitor of the run.
+ * @param cfg The detection thresholds.
+ * @param baselineW The pump's learned power draw, or NAN if not learned yet; dry-run and
+ * blockage are only judged against a learned draw, a dead relay always.
+ * @param shareW The part of the measured power attributed to this pump.
+ * @param shareA The part of the measured current attributed to this pump.
+ * @param evaluate false to only record the sample, e.g. when another pump dominates the reading.
+ * @param nowMs The sample time in milliseconds.
+ * @return The run's fault, which stays set once confirmed.
+ */
+PumpFault pump_monitor_sample(PumpRunMonitor& run, const PumpMonitorConfig& cfg, float baselineW,
+                              float shareW, float shareA, bool evaluate, unsigned long nowMs);
+
+/**
+ * @brief Judges a run that ended before a fault could be confirmed sample by
+ * sample, on the mean of its exact steady samples. Call when the pump stops.
+ * A run disturbed by another pump, or without a steady sample, is not judged.
+ * @param run The monitor of the finished run.
+ * @param cfg The detection thresholds.
+ * @param baselineW The pump's learned power draw, or NAN (see `pump_monitor_sample()`).
+ * @return The run's fault, which stays set.
+ */
+PumpFault pump_monitor_finish(PumpRunMonitor& run, const PumpMonitorConfig& cfg, float baselineW);
+
+/**
+ * @brief Adds energy to the run.
+ * @param run The monitor of the run.
+ * @param watts The power attributed to this pump over the interval.
+ * @param dtMs The length of the interval in milliseconds.
+ */
+void pump_monitor_add_energy(PumpRunMonitor& run, float watts, unsigned long dtMs);
+
+/**
+ * @brief Returns the mean steady-state share of the run, for baseline learning.
+ * @param run The monitor of the finished run.
+ * @param meanW Receives the mean power share.
+ * @param meanA Receives the mean current share.
+ * @return true if the run had enough exact steady samples to be trusted.
+ */
+bool pump_monitor_steady_mean(const PumpRunMonitor& run, float& meanW, float& meanA);
+
+/**
+ * @brief Returns a short, topic-friendly name for a fault ("none", "dry_run", ...).
+ * @param fault The fault to name.
+ * @return A static string.
+ */
+const char* pump_fault_name(PumpFault fault);
+
+#endif // PUMP_MONITOR_H
@@ -0,0 +1,159 @@
+/**
+ * @file sensor_stats.cpp
+ * @brief Implements the sensor statistics module.
+ */
+
+#include "sensor_stats.h"
+#include "config.h"
+#include "mqtt_handler.h"
+#include "number_format.h" // For printf-free float formatting in payloads
+#include <math.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct RunningStats
+ * @brief Welford's running mean and sum of squared deviations, plus the extremes.
+ */
+struct RunningStats {
+  uint32_t count;
+  float mean;
+  float m2;   ///< Sum of squared deviations from the running mean.
+  float min;
+  float max;
+};
+
+/**
+ * @struct SummaryWindow
+ * @brief The statistics of one window length since its last summary.
+ */
+struct SummaryWindow {
+  /// "<base topic>/statistik/<label>": at most 53 characters before the label, which has at most 12.
+  char topic[72];
+  unsigned long startTime;
+  uint32_t readings; ///< Readings added, valid or not; 0 means the window has not started.
+  RunningStats fields[SENSOR_NUM_FIELDS];
+};
+
+static SummaryWindow windows[SENSOR_SUMMARY_NUM_WINDOWS];
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void add_sample(RunningStats& stats, float x);
+static bool publish_window(const SummaryWindow& window, unsigned long now);
+static size_t append_number(char* payload, size_t size, size_t len, float value, uint8_t decimals);
+
+// --- Public Function Implementations ---
+
+void sensor_stats_init() {
+  for (int i = 0; i < SENSOR_SUMMARY_NUM_WINDOWS; i++) {
+    // Named after the window length: "1m", "15m", "1h", ...
+    long seconds = SENSOR_SUMMARY_WINDOWS_MS[i] / 1000;
+    char label[16];
+    if (seconds % 3600 == 0) {
+      snprintf(label, sizeof(label), "%ldh", seconds / 3600);
+    } else if (seconds % 60 == 0) {
+      snprintf(label, sizeof(label), "%ldm", seconds / 60);
+    } else {
+      snprintf(label, sizeof(label), "%lds", seconds);
+    }
+    snprintf(windows[i].topic, sizeof(windows[i].topic), "%s/%s", STATE_TOPIC_SENSOR_SUMMARY.c_str(), label);
+    windows[i].readings = 0;
+  }
+}
+
+bool sensor_stats_add(const SensorValues& values) {
+  unsigned long now = millis();
+  bool published = false;
+  for (int i = 0; i < SENSOR_SUMMARY_NUM_WINDOWS; i++) {
+    SummaryWindow& window = windows[i];
+    // An ended window is kept open while the broker is unreachable.
+    if (window.readings > 0 && now - window.startTime >= (unsigned long)SENSOR_SUMMARY_WINDOWS_MS[i] &&
+        mqtt_is_connected()) {
+      published |= publish_window(window, now);
+      window.readings = 0;
+    }
+    if (window.readings == 0) {
+      window.startTime = now;
+      memset(window.fields, 0, sizeof(window.fields));
+    }
+    window.readings++;
+    for (int f = 0; f < SENSOR_NUM_FIELDS; f++) {
+      float x = values.*SENSOR_FIELDS[f].value;
+      if (!isnan(x)) add_sample(window.fields[f], x);
+    }
+  }
+  return published;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Adds one valid sample to a field's running statistics (Welford's update).
+ * @param stats The field's statistics.
+ * @param x The sample.
+ */
+static void add_sample(RunningStats& stats, float x) {
+  if (stats.count == 0) {
+    stats.min = x;
+    stats.max = x;
+  } else {
+    if (x < stats.min) stats.min = x;
+    if (x > stats.max) stats.max = x;
+  }
+  stats.count++;
+  float delta = x - stats.mean;
+  stats.mean += delta / stats.count;
+  stats.m2 += delta * (x - stats.mean);
+}
+
+/**
+ * @brief Formats and publishes a window's summary.
+ * @param window The window that has ended.
+ * @param now The current `millis()`, the end of the window.
+ * @return true if the summary was published, false if it did not fit the buffer.
+ */
+static bool publish_window(const SummaryWindow& window, unsigned long now) {
+  char payload[640];
+  size_t len = snprintf(payload, sizeof(payload), "{\"s\":%lu,\"n\":%u", (now - window.startTime) / 1000,
+                        window.readings);
+  for (int f = 0; f < SENSOR_NUM_FIELDS && len < sizeof(payload); f++) {
+    const RunningStats& stats = window.fields[f];
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"%s\":", SENSOR_FIELDS[f].key);
+    if (stats.count == 0) {
+      if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "null");
+      continue;
+    }
+    // Sample standard deviation; a single reading has none.
+    float stddev = stats.count > 1 ? sqrtf(stats.m2 / (stats.count - 1)) : 0;
+    uint8_t decimals = SENSOR_FIELDS[f].decimals;
+    if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "[");
+    len = append_number(payload, sizeof(payload), len, stats.min, decimals);
+    len = append_number(payload, sizeof(payload), len, stats.mean, decimals);
+    len = append_number(payload, sizeof(payload), len, stats.max, decimals);
+    len = append_number(payload, sizeof(payload), len, stddev, decimals);
+    if (len < sizeof(payload)) payload[len - 1] = ']'; // Replaces the trailing comma.
+  }
+  if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "}");
+  if (len >= sizeof(payload)) {
+    LOG_WARN("[Stats] WARN: Summary for %s does not fit, dropped.\n", window.topic);
+    return false;
+  }
+  mqtt_publish_state(window.topic, payload, false);
+  return true;
+}
+
+/**
+ * @brief Appends a number and a comma to a payload.
+ * @param payload The payload buffer.
+ * @param size The size of `payload` in bytes.
+ * @param len The current length of the payload.
+ * @param value The value to append.
+ * @param decimals The number of decimals.
+ * @return The new length; `size` or more if the payload was truncated.
+ */
+static size_t append_number(char* payload, size_t size, size_t len, float value, uint8_t decimals) {
+  char number[16];
+  if (number_format_fixed(number, sizeof(number), value, decimals) == 0) strcpy(number, "null");
+  if (len < size) len += snprintf(payload + len, size - len, "%s,", number);
+  return len;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file sensor_stats.h
+ * @brief Public interface for the sensor statistics module.
+ *
+ * Aggregates the periodic sensor readings over fixed windows (by default
+ * 1 min, 15 min and 1 h, see `SENSOR_SUMMARY_WINDOWS_MS`) and publishes one
+ * compact summary per window when it closes, on `<base>/statistik/<window>`:
+ *
+ *   {"s":900,"n":180,"level":[41.2,43.0,44.9,0.85],"tds":[812.4,820.1,829.0,4.12],...}
+ *
+ * `s` is the window length in seconds and `n` the number of readings. Each
+ * field is `[min, mean, max, stddev]` over its valid readings, or null if there
+ * were none. The variance uses Welford's algorithm, so every field costs a
+ * fixed few bytes per window regardless of its length. A window that ends while
+ * MQTT is down is extended until the broker is back, so no readings are lost;
+ * `s` then reports the actual length.
+ */
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include "sensors.h"
+
+/**
+ * @brief Builds the summary topics. Call once in `setup()`.
+ */
+void sensor_stats_init();
+
+/**
+ * @brief Adds a reading to every window, first publishing the windows that have ended.
+ * Call after each full sensor read; the fast power samples taken during pump
+ * runs are not added, so every reading carries the same weight.
+ * @param values The latest sensor readings; NAN fields are skipped.
+ * @return true if at least one summary was published.
+ */
+bool sensor_stats_add(const SensorValues& values);
+
+#endif // SENSOR_STATS_H
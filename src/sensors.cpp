@@ -5,6 +5,7 @@
 
 #include "sensors.h"
 #include "config.h" // For pin definitions and sensor configurations
+#include "diagnostics.h" // For per-sensor read timing
 
 // Include all necessary sensor libraries
 #include <NewPing.h>
@@ -26,12 +27,32 @@ static DHT dht(DHT_PIN, DHT_TYPE);
 /// @brief PZEM004Tv30 object for the power meter, using hardware serial port 2.
 static PZEM004Tv30 pzem(Serial2, PZEM_RX_PIN, PZEM_TX_PIN);
 
-// --- Voltage validation constants for analog sensors ---
+// --- ADC scaling and voltage validation constants for analog sensors ---
+static const float ADC_VREF = 3.3f;
+static const int ADC_MAX_COUNT = 4095;
 static const float TDS_MAX_VOLTAGE = 2.4f;
 static const float TDS_MIN_VOLTAGE = 0.1f;
 static const float PH_MAX_VOLTAGE = 3.2f;
 static const float PH_MIN_VOLTAGE = 0.1f;
 
+// --- Public Constants ---
+
+const SensorField SENSOR_FIELDS[SENSOR_NUM_FIELDS] = {
+  {"level", &SensorValues::waterLevelCm, 1},
+  {"distance", &SensorValues::waterDistanceCm, 0},
+  {"water_temp", &SensorValues::waterTempC, 2},
+  {"air_temp", &SensorValues::airTempC, 2},
+  {"humidity", &SensorValues::airHumidityPercent, 2},
+  {"tds", &SensorValues::tdsPpm, 1},
+  {"voltage", &SensorValues::pzemVoltage, 1},
+  {"current", &SensorValues::pzemCurrent, 3},
+  {"power", &SensorValues::pzemPower, 1},
+  {"energy", &SensorValues::pzemEnergy, 3},
+  {"frequency", &SensorValues::pzemFrequency, 1},
+  {"pf", &SensorValues::pzemPowerFactor, 2},
+  {"ph", &SensorValues::phValue, 2},
+};
+
 
 // --- Forward Declarations for Static (Private) Functions ---
 static float read_water_temperature();
@@ -45,7 +66,7 @@ static float read_ph();
 // --- Public Function Implementations ---
 
 void sensors_init() {
-  LOG_PRINTLN("[Sensors] Initializing...");
+  LOG_INFO("[Sensors] Initializing...\n");
   ds18b20.begin();
   dht.begin();
   
@@ -58,17 +79,88 @@ void sensors_init() {
 }
 
 void sensors_read_all(SensorValues &values) {
-  LOG_PRINTLN("\n--- Reading All Sensors ---");
-  read_ultrasonic(values.waterDistanceCm, values.waterLevelCm);
-  values.waterTempC = read_water_temperature();
+  LOG_DEBUG("\n--- Reading All Sensors ---\n");
+  DIAG_TIME(DIAG_SENSOR_ULTRASONIC, read_ultrasonic(values.waterDistanceCm, values.waterLevelCm));
+  DIAG_TIME(DIAG_SENSOR_WATER_TEMP, values.waterTempC = read_water_temperature());
   // Only read TDS if water temperature is valid, as it's needed for compensation.
-  values.tdsPpm = isnan(values.waterTempC) ? NAN : read_tds(values.waterTempC);
-  read_dht(values.airTempC, values.airHumidityPercent);
-  read_pzem(values);
-  values.phValue = read_ph();
-  LOG_PRINTLN("--- Finished Sensor Readings ---\n");
+  DIAG_TIME(DIAG_SENSOR_TDS, values.tdsPpm = isnan(values.waterTempC) ? NAN : read_tds(values.waterTempC));
+  DIAG_TIME(DIAG_SENSOR_DHT, read_dht(values.airTempC, values.airHumidityPercent));
+  DIAG_TIME(DIAG_SENSOR_PZEM, read_pzem(values));
+  DIAG_TIME(DIAG_SENSOR_PH, values.phValue = read_ph());
+  LOG_DEBUG("--- Finished Sensor Readings ---\n\n");
+}
+
+
+bool sensors_read_power(SensorValues &values) {
+  // Read voltage first. The library returns NAN on failure.
+  float voltage = pzem.voltage();
+
+  if (!isnan(voltage)) {
+    // If voltage is valid, read the rest of the values.
+    values.pzemVoltage = voltage;
+    values.pzemCurrent = pzem.current();
+    values.pzemPower = pzem.power();
+    values.pzemEnergy = pzem.energy() / 1000.0f; // Convert Wh to kWh for Home Assistant
+    values.pzemFrequency = pzem.frequency();
+    values.pzemPowerFactor = pzem.pf();
+    return true;
+  }
+
+  // Set all related values to Not-a-Number to indicate failure.
+  values.pzemVoltage = NAN;
+  values.pzemCurrent = NAN;
+  values.pzemPower = NAN;
+  values.pzemEnergy = NAN;
+  values.pzemFrequency = NAN;
+  values.pzemPowerFactor = NAN;
+  return false;
+}
+
+float sensors_read_tds_voltage() {
+  return analogRead(TDS_SENSOR_PIN) * ADC_VREF / ADC_MAX_COUNT;
+}
+
+float sensors_read_ph_voltage() {
+  return analogRead(PH_SENSOR_PIN) * ADC_VREF / ADC_MAX_COUNT;
+}
+
+float sensors_tds_from_voltage(float voltage, float waterTemp) {
+  // Validate that the voltage is within a plausible range for the sensor.
+  if (voltage > TDS_MAX_VOLTAGE || voltage < TDS_MIN_VOLTAGE) {
+    return NAN;
+  }
+
+  // Temperature compensation formula
+  float rawTds = voltage * TDS_K_VALUE;
+  return rawTds / (1.0 + TDS_TEMP_COEFF * (waterTemp - 25.0));
 }
 
+float sensors_ph_from_voltage(float voltage) {
+  // Validate that the voltage is within a plausible range for the sensor.
+  if (voltage < PH_MIN_VOLTAGE || voltage > PH_MAX_VOLTAGE) {
+    return NAN;
+  }
+
+  // 4-Point Calibration using segmental linear interpolation, matching calibration script.
+  float ph_value = 0.0;
+
+  if (voltage >= PH_CALIBRATION_VOLTAGE_401) { // Extrapolation for very acidic range (pH < 4.01)
+    float slope_acid = (4.01 - 6.86) / (PH_CALIBRATION_VOLTAGE_401 - PH_CALIBRATION_VOLTAGE_686);
+    ph_value = 6.86 + (voltage - PH_CALIBRATION_VOLTAGE_686) * slope_acid;
+  } else if (voltage >= PH_CALIBRATION_VOLTAGE_686) { // Acidic to neutral range (pH 4.01 to 6.86)
+    float slope_acid = (4.01 - 6.86) / (PH_CALIBRATION_VOLTAGE_401 - PH_CALIBRATION_VOLTAGE_686);
+    ph_value = 6.86 + (voltage - PH_CALIBRATION_VOLTAGE_686) * slope_acid;
+  } else if (voltage >= PH_CALIBRATION_VOLTAGE_918) { // Neutral to alkaline range (pH 6.86 to 9.18)
+    float slope_alkaline = (6.86 - 9.18) / (PH_CALIBRATION_VOLTAGE_686 - PH_CALIBRATION_VOLTAGE_918);
+    ph_value = 9.18 + (voltage - PH_CALIBRATION_VOLTAGE_918) * slope_alkaline;
+  } else { // Extrapolation for very alkaline range (pH > 9.18)
+    float slope_alkaline = (6.86 - 9.18) / (PH_CALIBRATION_VOLTAGE_686 - PH_CALIBRATION_VOLTAGE_918);
+    ph_value = 9.18 + (voltage - PH_CALIBRATION_VOLTAGE_918) * slope_alkaline;
+  }
+
+  // Clamp the result to a reasonable range (e.g., 0 to 14) to avoid extreme values from extrapolation.
+  return max(0.0f, min(14.0f, ph_value));
+}
 
 // --- Static (Private) Function Implementations ---
 
@@ -80,12 +172,11 @@ static float read_water_temperature() {
   ds18b20.requestTemperatures();
   float tempC = ds18b20.getTempCByIndex(0);
 
-  LOG_PRINT("  [Sensor] Water Temp: ");
   if (tempC == DEVICE_DISCONNECTED_C || tempC < -50 || tempC > 120) {
-    LOG_PRINTLN("ERROR (disconnected or invalid reading)");
+    LOG_WARN("  [Sensor] Water Temp: ERROR (disconnected or invalid reading)\n");
     return NAN;
   }
-  LOG_PRINTF("%.2f C\n", tempC);
+  LOG_DEBUG("  [Sensor] Water Temp: %.2f C\n", tempC);
   return tempC;
 }
 
@@ -98,13 +189,12 @@ static void read_dht(float &temp, float &humidity) {
   humidity = dht.readHumidity();
   temp = dht.readTemperature();
 
-  LOG_PRINT("  [Sensor] Air T/H: ");
   if (isnan(humidity) || isnan(temp)) {
-    LOG_PRINTLN("ERROR (failed to read)");
+    LOG_WARN("  [Sensor] Air T/H: ERROR (failed to read)\n");
     temp = NAN;
     humidity = NAN;
   } else {
-    LOG_PRINTF("%.2f C, %.2f %%\n", temp, humidity);
+    LOG_DEBUG("  [Sensor] Air T/H: %.2f C, %.2f %%\n", temp, humidity);
   }
 }
 
@@ -115,10 +205,9 @@ static void read_dht(float &temp, float &humidity) {
  */
 static void read_ultrasonic(float &distance, float &level) {
   unsigned int usDistance = sonar.ping_cm();
-  LOG_PRINT("  [Sensor] Ultrasonic: ");
 
   if (usDistance == 0 || usDistance >= ULTRASONIC_MAX_DISTANCE_CM) {
-    LOG_PRINTLN("ERROR (out of range)");
+    LOG_WARN("  [Sensor] Ultrasonic: ERROR (out of range)\n");
     distance = NAN;
     level = NAN;
   } else {
@@ -126,7 +215,7 @@ static void read_ultrasonic(float &distance, float &level) {
     level = TANDON_MAX_HEIGHT_CM - distance;
     // Clamp level to a valid range [0, TANDON_MAX_HEIGHT_CM] to prevent negative values.
     level = max(0.0f, min((float)TANDON_MAX_HEIGHT_CM, level));
-    LOG_PRINTF("Dist: %.0f cm, Level: %.1f cm\n", distance, level);
+    LOG_DEBUG("  [Sensor] Ultrasonic: Dist: %.0f cm, Level: %.1f cm\n", distance, level);
   }
 }
 
@@ -136,22 +225,15 @@ static void read_ultrasonic(float &distance, float &level) {
  * @return The compensated TDS value in ppm, or NAN on failure.
  */
 static float read_tds(float waterTemp) {
-  const float VREF = 3.3;
-  const int ADC_RESOLUTION = 4095;
-  float voltage = analogRead(TDS_SENSOR_PIN) * VREF / ADC_RESOLUTION;
+  float voltage = sensors_read_tds_voltage();
 
-  LOG_PRINT("  [Sensor] TDS: ");
-  // Validate that the voltage is within a plausible range for the sensor.
-  if (voltage > TDS_MAX_VOLTAGE || voltage < TDS_MIN_VOLTAGE) {
-    LOG_PRINTF("ERROR (invalid voltage: %.2fV)\n", voltage);
+  float compensatedTds = sensors_tds_from_voltage(voltage, waterTemp);
+  if (isnan(compensatedTds)) {
+    LOG_WARN("  [Sensor] TDS: ERROR (invalid voltage: %.2fV)\n", voltage);
     return NAN;
   }
 
-  // Temperature compensation formula
-  float rawTds = voltage * TDS_K_VALUE;
-  float compensatedTds = rawTds / (1.0 + TDS_TEMP_COEFF * (waterTemp - 25.0));
-
-  LOG_PRINTF("Voltage: %.2fV, Comp. TDS: %.1f ppm\n", voltage, compensatedTds);
+  LOG_DEBUG("  [Sensor] TDS: Voltage: %.2fV, Comp. TDS: %.1f ppm\n", voltage, compensatedTds);
   return compensatedTds;
 }
 
@@ -160,30 +242,10 @@ static float read_tds(float waterTemp) {
  * @param values Reference to the main SensorValues struct to populate.
  */
 static void read_pzem(SensorValues &values) {
-  LOG_PRINT("  [Sensor] PZEM-004T: ");
-
-  // Read voltage first. The library returns NAN on failure.
-  float voltage = pzem.voltage();
-
-  if (!isnan(voltage)) {
-    // If voltage is valid, read the rest of the values.
-    values.pzemVoltage = voltage;
-    values.pzemCurrent = pzem.current();
-    values.pzemPower = pzem.power();
-    values.pzemEnergy = pzem.energy() / 1000.0f; // Convert Wh to kWh for Home Assistant
-    values.pzemFrequency = pzem.frequency();
-    values.pzemPowerFactor = pzem.pf();
-
-    LOG_PRINTF("V:%.1f, A:%.3f, W:%.1f\n", values.pzemVoltage, values.pzemCurrent, values.pzemPower);
+  if (sensors_read_power(values)) {
+    LOG_DEBUG("  [Sensor] PZEM-004T: V:%.1f, A:%.3f, W:%.1f\n", values.pzemVoltage, values.pzemCurrent, values.pzemPower);
   } else {
-    LOG_PRINTLN("ERROR (failed to read)");
-    // Set all related values to Not-a-Number to indicate failure.
-    values.pzemVoltage = NAN;
-    values.pzemCurrent = NAN;
-    values.pzemPower = NAN;
-    values.pzemEnergy = NAN;
-    values.pzemFrequency = NAN;
-    values.pzemPowerFactor = NAN;
+    LOG_WARN("  [Sensor] PZEM-004T: ERROR (failed to read)\n");
   }
 }
 
@@ -194,9 +256,6 @@ static void read_pzem(SensorValues &values) {
  * @return The calculated pH value, or NAN on failure.
  */
 static float read_ph() {
-  const float VREF = 3.3;
-  const int ADC_RESOLUTION = 4095;
-  
   // Read ADC multiple times and take the average to reduce noise.
   int totalADC = 0;
   const int samples = 10;
@@ -205,36 +264,14 @@ static float read_ph() {
     delay(10);
   }
   int adcValue = totalADC / samples;
-  float voltage = adcValue * VREF / ADC_RESOLUTION;
-
-  LOG_PRINT("  [Sensor] pH: ");
+  float voltage = adcValue * ADC_VREF / ADC_MAX_COUNT;
 
-  // Validate that the voltage is within a plausible range for the sensor.
-  if (voltage < PH_MIN_VOLTAGE || voltage > PH_MAX_VOLTAGE) {
-    LOG_PRINTF("ERROR (invalid voltage: %.2fV). Ensure sensor is powered by 3.3V.\n", voltage);
+  float ph_value = sensors_ph_from_voltage(voltage);
+  if (isnan(ph_value)) {
+    LOG_WARN("  [Sensor] pH: ERROR (invalid voltage: %.2fV). Ensure sensor is powered by 3.3V.\n", voltage);
     return NAN;
   }
 
-  // 4-Point Calibration using segmental linear interpolation, matching calibration script.
-  float ph_value = 0.0;
-
-  if (voltage >= PH_CALIBRATION_VOLTAGE_401) { // Extrapolation for very acidic range (pH < 4.01)
-    float slope_acid = (4.01 - 6.86) / (PH_CALIBRATION_VOLTAGE_401 - PH_CALIBRATION_VOLTAGE_686);
-    ph_value = 6.86 + (voltage - PH_CALIBRATION_VOLTAGE_686) * slope_acid;
-  } else if (voltage >= PH_CALIBRATION_VOLTAGE_686) { // Acidic to neutral range (pH 4.01 to 6.86)
-    float slope_acid = (4.01 - 6.86) / (PH_CALIBRATION_VOLTAGE_401 - PH_CALIBRATION_VOLTAGE_686);
-    ph_value = 6.86 + (voltage - PH_CALIBRATION_VOLTAGE_686) * slope_acid;
-  } else if (voltage >= PH_CALIBRATION_VOLTAGE_918) { // Neutral to alkaline range (pH 6.86 to 9.18)
-    float slope_alkaline = (6.86 - 9.18) / (PH_CALIBRATION_VOLTAGE_686 - PH_CALIBRATION_VOLTAGE_918);
-    ph_value = 9.18 + (voltage - PH_CALIBRATION_VOLTAGE_918) * slope_alkaline;
-  } else { // Extrapolation for very alkaline range (pH > 9.18)
-    float slope_alkaline = (6.86 - 9.18) / (PH_CALIBRATION_VOLTAGE_686 - PH_CALIBRATION_VOLTAGE_918);
-    ph_value = 9.18 + (voltage - PH_CALIBRATION_VOLTAGE_918) * slope_alkaline;
-  }
-
-  // Clamp the result to a reasonable range (e.g., 0 to 14) to avoid extreme values from extrapolation.
-  ph_value = max(0.0f, min(14.0f, ph_value));
-
-  LOG_PRINTF("Voltage: %.3fV, pH: %.2f (4-point calibration)\n", voltage, ph_value);
+  LOG_DEBUG("  [Sensor] pH: Voltage: %.3fV, pH: %.2f (4-point calibration)\n", voltage, ph_value);
   return ph_value;
 }
@@ -44,6 +44,25 @@ struct SensorValues {
     float phValue;
 };
 
+/**
+ * @struct SensorField
+ * @brief Describes one field of `SensorValues`, for code that treats all readings alike.
+ */
+struct SensorField {
+    /// @brief The short JSON key, e.g. "tds".
+    const char* key;
+    /// @brief The field within `SensorValues`.
+    float SensorValues::*value;
+    /// @brief The number of decimals the reading is published with.
+    uint8_t decimals;
+};
+
+/// @brief The number of readings in `SensorValues`.
+constexpr int SENSOR_NUM_FIELDS = 13;
+
+/// @brief Every field of `SensorValues`, in declaration order.
+extern const SensorField SENSOR_FIELDS[SENSOR_NUM_FIELDS];
+
 /**
  * @brief Initializes all connected sensors.
  * This function should be called once in the `setup()` function. It prepares
@@ -60,4 +79,44 @@ void sensors_init();
  */
 void sensors_read_all(SensorValues &values);
 
+/**
+ * @brief Reads only the PZEM-004T power meter, without logging.
+ * This is the fast path used to monitor pump runs at the meter's maximum rate.
+ * The library caches a full register read for 200 ms, so one call costs a
+ * single Modbus transaction at most.
+ * @param values Reference to the SensorValues struct whose PZEM fields are updated.
+ * @return true if the meter answered, false if the PZEM fields were set to NAN.
+ */
+bool sensors_read_power(SensorValues &values);
+
+/**
+ * @brief Reads the TDS probe's output voltage once, without logging or averaging.
+ * This is the fast path used while the probe is calibrated (see probe_calibration.h).
+ * @return The voltage in Volts.
+ */
+float sensors_read_tds_voltage();
+
+/**
+ * @brief Reads the pH probe's output voltage once, without logging or averaging.
+ * @return The voltage in Volts.
+ */
+float sensors_read_ph_voltage();
+
+/**
+ * @brief Converts a TDS probe voltage into a temperature-compensated TDS value.
+ * This is the pure math behind the TDS reading, without the ADC access.
+ * @param voltage The probe output voltage in Volts.
+ * @param waterTemp The water temperature in degrees Celsius.
+ * @return The compensated TDS value in ppm, or NAN if the voltage is implausible.
+ */
+float sensors_tds_from_voltage(float voltage, float waterTemp);
+
+/**
+ * @brief Converts a pH probe voltage into a pH value using the 4-point calibration.
+ * This is the pure math behind the pH reading, without the ADC access.
+ * @param voltage The averaged probe output voltage in Volts.
+ * @return The pH value clamped to 0-14, or NAN if the voltage is implausible.
+ */
+float sensors_ph_from_voltage(float voltage);
+
 #endif // SENSORS_H
@@ -0,0 +1,140 @@
+/**
+ * @file storage.cpp
+ * @brief Implements coalesced persistence of module state in NVS.
+ */
+
+#include "storage.h"
+#include "config.h"
+#include <Preferences.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct StorageRecord
+ * @brief A block of module state mirrored to an NVS key.
+ */
+struct StorageRecord {
+  const char* key;             ///< The NVS key.
+  void* data;                  ///< The live state owned by the registering module.
+  size_t size;                 ///< The size of `data` in bytes.
+  unsigned long commitDelayMs; ///< How long changes are coalesced before writing.
+  bool dirty;                  ///< true if `data` changed since the last commit.
+  unsigned long dirtySince;    ///< millis() of the first change since the last commit.
+};
+
+/// @brief The maximum number of records; enough for every persisting module.
+static const int STORAGE_MAX_RECORDS = 8;
+/// @brief The largest record that can be compared against flash before writing.
+static const size_t STORAGE_MAX_RECORD_SIZE = 256;
+
+/// @brief The NVS handle for the firmware's namespace.
+static Preferences prefs;
+/// @brief true if the NVS namespace was opened successfully.
+static bool storageReady = false;
+/// @brief The registered records.
+static StorageRecord records[STORAGE_MAX_RECORDS];
+/// @brief The number of registered records.
+static int numRecords = 0;
+/// @brief The number of NVS writes since boot.
+static uint32_t commitCount = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void commit_record(StorageRecord& record);
+
+// --- Public Function Implementations ---
+
+void storage_init() {
+  storageReady = prefs.begin(STORAGE_NAMESPACE, false);
+  if (!storageReady) {
+    LOG_ERROR("[Storage] ERROR: Could not open NVS. Settings will not persist.\n");
+  }
+}
+
+int storage_register(const char* key, void* data, size_t size, unsigned long commitDelayMs, bool* loaded) {
+  if (loaded) *loaded = false;
+  if (numRecords >= STORAGE_MAX_RECORDS || size > STORAGE_MAX_RECORD_SIZE) {
+    LOG_ERROR("[Storage] ERROR: Cannot register '%s'.\n", key);
+    return -1;
+  }
+
+  StorageRecord& record = records[numRecords];
+  record.key = key;
+  record.data = data;
+  record.size = size;
+  record.commitDelayMs = commitDelayMs;
+  record.dirty = false;
+  record.dirtySince = 0;
+
+  if (storageReady && prefs.getBytesLength(key) == size) {
+    prefs.getBytes(key, data, size);
+    if (loaded) *loaded = true;
+    LOG_INFO("[Storage] Restored '%s' (%u bytes).\n", key, (unsigned)size);
+  }
+  return numRecords++;
+}
+
+void storage_mark_dirty(int handle) {
+  if (handle < 0 || handle >= numRecords) return;
+  StorageRecord& record = records[handle];
+  if (!record.dirty) {
+    record.dirty = true;
+    record.dirtySince = millis();
+  }
+}
+
+void storage_flush(int handle) {
+  if (handle < 0 || handle >= numRecords) return;
+  if (records[handle].dirty) commit_record(records[handle]);
+}
+
+void storage_flush_all() {
+  for (int i = 0; i < numRecords; i++) {
+    if (records[i].dirty) commit_record(records[i]);
+  }
+}
+
+void storage_loop() {
+  unsigned long now = millis();
+  for (int i = 0; i < numRecords; i++) {
+    if (records[i].dirty && now - records[i].dirtySince >= records[i].commitDelayMs) {
+      commit_record(records[i]);
+    }
+  }
+}
+
+bool storage_get_record(int index, StorageRecordView& view) {
+  if (index < 0 || index >= numRecords) return false;
+  view.key = records[index].key;
+  view.data = records[index].data;
+  view.size = records[index].size;
+  return true;
+}
+
+uint32_t storage_commit_count() {
+  return commitCount;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Writes a record to NVS unless flash already holds the same bytes.
+ * @param record The record to commit.
+ */
+static void commit_record(StorageRecord& record) {
+  record.dirty = false;
+  if (!storageReady) return;
+
+  uint8_t stored[STORAGE_MAX_RECORD_SIZE];
+  if (prefs.getBytesLength(record.key) == record.size &&
+      prefs.getBytes(record.key, stored, record.size) == record.size &&
+      memcmp(stored, record.data, record.size) == 0) {
+    return; // Unchanged, e.g. a toggle that was reverted within the delay.
+  }
+
+  if (prefs.putBytes(record.key, record.data, record.size) == record.size) {
+    commitCount++;
+    LOG_INFO("[Storage] Saved '%s'.\n", record.key);
+  } else {
+    LOG_ERROR("[Storage] ERROR: Failed to save '%s'.\n", record.key);
+  }
+}
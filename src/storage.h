@@ -0,0 +1,80 @@
+/**
+ * @file storage.h
+ * @brief Public interface for the persistent storage module.
+ *
+ * Modules register a piece of static state under an NVS key. The stored bytes
+ * are loaded into it at registration, and later changes are written back after
+ * a per-record coalescing delay, so bursts of changes cost a single flash write.
+ */
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Opens the NVS namespace. Call once in `setup()` before any module registers records.
+ */
+void storage_init();
+
+/**
+ * @brief Registers a block of state for persistence and restores it from NVS.
+ * If the stored blob has a different size (e.g. after a struct layout change),
+ * it is ignored and `data` keeps its defaults.
+ * @param key The NVS key (at most 15 characters).
+ * @param data The state to persist. Must stay valid for the program's lifetime.
+ * @param size The size of `data` in bytes.
+ * @param commitDelayMs How long changes are coalesced before they are written.
+ * @param loaded Optional; set to true if `data` was restored from NVS.
+ * @return A handle for `storage_mark_dirty()`, or -1 if the record table is full.
+ */
+int storage_register(const char* key, void* data, size_t size, unsigned long commitDelayMs, bool* loaded = nullptr);
+
+/**
+ * @brief Notes that a registered record changed. The write happens in `storage_loop()`
+ * once the record has been dirty for its commit delay.
+ * @param handle The handle returned by `storage_register()`.
+ */
+void storage_mark_dirty(int handle);
+
+/**
+ * @brief Writes a dirty record immediately, bypassing its commit delay.
+ * @param handle The handle returned by `storage_register()`.
+ */
+void storage_flush(int handle);
+
+/**
+ * @brief Writes every dirty record immediately. Call before a deliberate restart.
+ */
+void storage_flush_all();
+
+/**
+ * @brief Main loop for the storage module. Commits records whose coalescing delay has elapsed.
+ */
+void storage_loop();
+
+/**
+ * @struct StorageRecordView
+ * @brief A read-only view of one registered record, e.g. to snapshot the persisted state.
+ */
+struct StorageRecordView {
+  const char* key;  ///< The NVS key.
+  const void* data; ///< The live state, which may be newer than flash.
+  size_t size;      ///< The size of `data` in bytes.
+};
+
+/**
+ * @brief Reads one registered record.
+ * @param index The record's index, from 0, in registration order.
+ * @param view Receives the record.
+ * @return false if there is no record with that index.
+ */
+bool storage_get_record(int index, StorageRecordView& view);
+
+/**
+ * @brief Returns the number of NVS writes performed since boot.
+ * @return The commit count; unchanged records are skipped and not counted.
+ */
+uint32_t storage_commit_count();
+
+#endif // STORAGE_H
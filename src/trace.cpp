@@ -0,0 +1,531 @@
+/**
+ * @file trace.cpp
+ * @brief Implements the control trace recorder.
+ */
+
+#include "trace.h"
+#include "config.h"
+#include "trace_codec.h"
+#include "actuators.h"
+#include "storage.h"
+#include "identity.h"
+#include "command_ack.h"   // For the wall clock
+#include "mqtt_handler.h"
+#include <esp_partition.h>
+
+// --- Module-Private (Static) Types & Constants ---
+
+/**
+ * @enum TraceSink
+ * @brief Where the trace is written. Persisted, so the values must not change.
+ */
+enum TraceSink : uint8_t {
+  TRACE_SINK_OFF = 0,
+  TRACE_SINK_SERIAL = 1,
+  TRACE_SINK_FLASH = 2,
+};
+
+static const char* const SINK_NAMES[] = {"off", "serial", "flash"};
+static const size_t SECTOR_SIZE = 4096;
+/// @brief Segment bytes per Serial line: 128 base64 characters, well within a log record.
+static const size_t SERIAL_LINE_BYTES = 96;
+/// @brief Serial lines written per loop iteration, so a checkpoint does not flood the log buffer.
+static const int SERIAL_LINES_PER_LOOP = 4;
+/// @brief Segment bytes per dump message: 512 base64 characters, which fit the MQTT buffer.
+static const size_t DUMP_LINE_BYTES = 384;
+/// @brief Dump messages sent per loop iteration, to keep the loop responsive.
+static const int DUMP_MESSAGES_PER_LOOP = 2;
+/// @brief The state word's fields (see `trace_output_state()`).
+static const uint32_t OUTPUT_PUMP_MASK = 0xFF;
+static const uint32_t OUTPUT_BUZZER = 1UL << 8;
+static const uint32_t OUTPUT_CLEANER_MODE = 1UL << 9;
+static const uint32_t OUTPUT_AUTO_DOSING = 1UL << 10;
+static const uint32_t OUTPUT_AUTO_REFILL = 1UL << 11;
+static const uint32_t OUTPUT_AUTO_IRRIGATION = 1UL << 12;
+static const int OUTPUT_QUEUE_SHIFT = 16;
+static const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// --- Module-Private (Static) Variables ---
+
+/// @brief The chosen output; persisted.
+static uint8_t sink = TRACE_SINK_OFF;
+static int storageHandle = -1;
+
+/// @brief Whether a recording runs; one waits for a quiet moment to start.
+static bool recording = false;
+static uint32_t recordingId = 0;
+/// @brief The sequence number of the next segment; continues across recordings and reboots.
+static uint32_t nextSequence = 1;
+
+/// @brief The segment being recorded, kept in RAM in full.
+static bool segmentOpen = false;
+static uint8_t segment[TRACE_SEGMENT_SIZE];
+static TraceEncoder encoder;
+static TraceSegmentHeader segmentHeader;
+/// @brief Bytes of the segment already written to Serial or flash.
+static size_t writtenSize = 0;
+static unsigned long lastWriteTime = 0;
+static uint32_t lastOutputs = 0;
+/// @brief When `trace_outputs()` last ran, i.e. about when the actuator loop last ran.
+static unsigned long lastLoopTime = 0;
+
+static uint32_t segmentsWritten = 0;
+static uint32_t bytesWritten = 0;
+static uint32_t droppedRecords = 0;
+static uint32_t flashErrors = 0;
+
+/// @brief The flash ring: the last TRACE_FLASH_SECTORS sectors of the history partition.
+static const esp_partition_t* partition = nullptr;
+static size_t ringOffset = 0;
+/// @brief The sequence number of each ring sector's segment; 0 if it holds none.
+static uint32_t sectorSequences[TRACE_FLASH_SECTORS];
+/// @brief The sector of the newest segment, -1 if there is none.
+static int headSector = -1;
+
+/**
+ * @struct TraceDump
+ * @brief The state of the flash dump being streamed.
+ */
+struct TraceDump {
+  bool active;
+  uint32_t sequence; ///< The segment being sent.
+  size_t offset;     ///< The next byte of it.
+  uint32_t lines;
+};
+
+static TraceDump dump;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool begin_record(unsigned long now);
+static void add_readings(TraceRecordType type, const SensorValues& values);
+static void add_named(TraceRecordType type, const char* name, const void* data, size_t size);
+static void add_number(TraceRecordType type, uint32_t value);
+static void record_outputs(unsigned long now);
+static void open_segment(unsigned long now);
+static void close_segment();
+static void write_checkpoint(unsigned long now);
+static void write_out(bool all, int maxLines);
+static void stop_recording();
+static void scan_ring();
+static int sector_of(uint32_t sequence);
+static uint32_t next_in_ring(uint32_t after);
+static void stream_dump();
+static void format_line(char* line, size_t size, uint32_t recording, uint32_t sequence, size_t offset,
+                        const uint8_t* data, size_t length);
+
+// --- Public Function Implementations ---
+
+void trace_init() {
+  storageHandle = storage_register("trace", &sink, sizeof(sink), CONTROL_STATE_COMMIT_DELAY_MS);
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HISTORY_PARTITION_LABEL);
+  if (partition != nullptr && partition->size >= TRACE_FLASH_SECTORS * SECTOR_SIZE) {
+    ringOffset = partition->size - TRACE_FLASH_SECTORS * SECTOR_SIZE;
+    scan_ring();
+  } else {
+    partition = nullptr;
+  }
+  if (sink > TRACE_SINK_FLASH || (sink == TRACE_SINK_FLASH && partition == nullptr)) sink = TRACE_SINK_OFF;
+  if (sink != TRACE_SINK_OFF) LOG_INFO("[Trace] Recording to %s.\n", SINK_NAMES[sink]);
+}
+
+void trace_sensors(const SensorValues& values) {
+  add_readings(TRACE_RECORD_SENSORS, values);
+}
+
+void trace_power(const SensorValues& values) {
+  add_readings(TRACE_RECORD_POWER, values);
+}
+
+void trace_command(const char* topic, const char* payload) {
+  if (sink == TRACE_SINK_OFF) return;
+  // Stored below the base topic, so a replay may run under any instance ID.
+  char name[TRACE_CODEC_MAX_NAME + 1];
+  size_t baseLength = strlen(BASE_TOPIC);
+  if (strncmp(topic, BASE_TOPIC, baseLength) == 0 && topic[baseLength] == '/') {
+    snprintf(name, sizeof(name), "~%s", topic + baseLength);
+  } else {
+    snprintf(name, sizeof(name), "%s", topic);
+  }
+  add_named(TRACE_RECORD_COMMAND, name, payload, strlen(payload));
+}
+
+void trace_outputs() {
+  unsigned long now = millis();
+  lastLoopTime = now;
+  if (sink == TRACE_SINK_OFF) return;
+  if (begin_record(now)) record_outputs(now);
+}
+
+void trace_loop() {
+  if (sink != TRACE_SINK_OFF && !recording) begin_record(millis());
+  if (segmentOpen) {
+    bool due = millis() - lastWriteTime >= (unsigned long)TRACE_FLUSH_INTERVAL_MS;
+    if (sink == TRACE_SINK_SERIAL) {
+      // Full lines go out at once; the rest of the segment waits for the interval.
+      write_out(due, SERIAL_LINES_PER_LOOP);
+    } else if (due) {
+      write_out(true, 0);
+    }
+  }
+  if (dump.active && mqtt_is_connected()) stream_dump();
+}
+
+void trace_handle_command(const char* command) {
+  uint8_t requested;
+  if (strcasecmp(command, "STATUS") == 0) {
+    trace_publish_status();
+    return;
+  } else if (strcasecmp(command, "DUMP") == 0) {
+    if (partition == nullptr || headSector < 0) {
+      LOG_WARN("[Trace] WARN: No trace in flash to dump.\n");
+      trace_publish_status(); // Still "dump":false, so a waiting client stops.
+      return;
+    }
+    if (sink == TRACE_SINK_FLASH && segmentOpen) write_out(true, 0);
+    dump.sequence = next_in_ring(0); // Oldest first.
+    dump.offset = 0;
+    dump.lines = 0;
+    dump.active = true;
+    LOG_INFO("[Trace] Dumping the flash trace from segment %u.\n", dump.sequence);
+    trace_publish_status();
+    return;
+  } else if (strcasecmp(command, "SERIAL") == 0) {
+    requested = TRACE_SINK_SERIAL;
+  } else if (strcasecmp(command, "FLASH") == 0) {
+    if (partition == nullptr) {
+      LOG_WARN("[Trace] WARN: No '%s' partition, cannot record to flash.\n", HISTORY_PARTITION_LABEL);
+      return;
+    }
+    requested = TRACE_SINK_FLASH;
+  } else if (strcasecmp(command, "OFF") == 0) {
+    requested = TRACE_SINK_OFF;
+  } else {
+    LOG_WARN("[Trace] WARN: Unknown command '%s', expected SERIAL, FLASH, OFF, STATUS or DUMP.\n", command);
+    return;
+  }
+
+  if (requested != sink) {
+    stop_recording();
+    sink = requested;
+    storage_mark_dirty(storageHandle);
+    LOG_INFO("[Trace] Recording to %s.\n", SINK_NAMES[sink]);
+  }
+  trace_publish_status();
+}
+
+void trace_publish_status() {
+  char recordingText[12];
+  if (recording) {
+    snprintf(recordingText, sizeof(recordingText), "\"%08x\"", (unsigned)recordingId);
+  } else {
+    strcpy(recordingText, "null");
+  }
+  int stored = 0;
+  for (int i = 0; i < TRACE_FLASH_SECTORS; i++) stored += sectorSequences[i] != 0;
+  char payload[256];
+  snprintf(payload, sizeof(payload),
+           "{\"sink\":\"%s\",\"recording\":%s,\"segments\":%u,\"bytes\":%u,\"dropped\":%u,\"flash_segments\":%d,"
+           "\"flash_capacity\":%d,\"flash_errors\":%u,\"dump\":%s}",
+           SINK_NAMES[sink], recordingText, segmentsWritten, bytesWritten, droppedRecords, stored,
+           partition != nullptr ? TRACE_FLASH_SECTORS : 0, flashErrors, dump.active ? "true" : "false");
+  mqtt_publish_state(STATE_TOPIC_TRACE, payload, true);
+}
+
+uint32_t trace_output_state() {
+  uint32_t state = 0;
+  PumpStatus status;
+  for (int i = 0; i < 8 && actuators_get_pump_status(i, status); i++) {
+    if (status.isOn) state |= 1UL << i;
+  }
+  if (actuators_alert_active()) state |= OUTPUT_BUZZER;
+  if (strcmp(actuators_mode_name(), "CLEANER") == 0) state |= OUTPUT_CLEANER_MODE;
+  if (automation_state.auto_dosing_enabled) state |= OUTPUT_AUTO_DOSING;
+  if (automation_state.auto_refill_enabled) state |= OUTPUT_AUTO_REFILL;
+  if (automation_state.auto_irrigation_enabled) state |= OUTPUT_AUTO_IRRIGATION;
+  state |= (uint32_t)actuators_queue_length() << OUTPUT_QUEUE_SHIFT;
+  return state;
+}
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Makes sure a segment is open for the next record, starting the
+ * recording first if it is waiting and the moment is quiet.
+ * @param now The current `millis()`.
+ * @return false if nothing is being recorded.
+ */
+static bool begin_record(unsigned long now) {
+  if (sink == TRACE_SINK_OFF) return false;
+  if (!recording) {
+    // A replay starts with every pump off and an empty queue, so the recording does too.
+    if (trace_output_state() & (OUTPUT_PUMP_MASK | (0xFFFFUL << OUTPUT_QUEUE_SHIFT))) return false;
+    recording = true;
+    recordingId = (uint32_t)random(1, 0x7FFFFFFF);
+    LOG_INFO("[Trace] Recording %08x started.\n", (unsigned)recordingId);
+  }
+  if (!segmentOpen) open_segment(now);
+  return true;
+}
+
+/**
+ * @brief Appends a reading, moving on to a new segment when the current one is full.
+ */
+static void add_readings(TraceRecordType type, const SensorValues& values) {
+  unsigned long now = millis();
+  if (!begin_record(now)) return;
+  record_outputs(now);
+  // A blocking read holds the actuator loop up and a running pump runs on meanwhile; a replay waits as long.
+  if (now != lastLoopTime && (lastOutputs & (OUTPUT_PUMP_MASK | (0xFFFFUL << OUTPUT_QUEUE_SHIFT)))) {
+    add_number(TRACE_RECORD_BUSY, now - lastLoopTime);
+  }
+  float channels[SENSOR_NUM_FIELDS];
+  for (int f = 0; f < SENSOR_NUM_FIELDS; f++) channels[f] = values.*SENSOR_FIELDS[f].value;
+  if (trace_codec_add_readings(encoder, type, now, channels)) return;
+  close_segment();
+  open_segment(now);
+  if (!trace_codec_add_readings(encoder, type, now, channels)) droppedRecords++;
+}
+
+/**
+ * @brief Appends a named record, moving on to a new segment when the current one is full.
+ */
+static void add_named(TraceRecordType type, const char* name, const void* data, size_t size) {
+  unsigned long now = millis();
+  if (!begin_record(now)) return;
+  record_outputs(now);
+  if (trace_codec_add_named(encoder, type, now, name, data, size)) return;
+  close_segment();
+  open_segment(now);
+  if (!trace_codec_add_named(encoder, type, now, name, data, size)) droppedRecords++;
+}
+
+/**
+ * @brief Appends a number record, moving on to a new segment when the current one is full.
+ */
+static void add_number(TraceRecordType type, uint32_t value) {
+  unsigned long now = millis();
+  if (trace_codec_add_number(encoder, type, now, value)) return;
+  close_segment();
+  open_segment(now);
+  if (!trace_codec_add_number(encoder, type, now, value)) droppedRecords++;
+}
+
+/**
+ * @brief Appends the actuator state if it differs from the last one recorded.
+ */
+static void record_outputs(unsigned long now) {
+  uint32_t outputs = trace_output_state();
+  if (outputs == lastOutputs) return;
+  lastOutputs = outputs;
+  add_number(TRACE_RECORD_OUTPUTS, outputs);
+}
+
+/**
+ * @brief Starts the next segment, in the next ring sector when recording to flash.
+ * It begins with a checkpoint if no pump runs and no job waits, and with the wall clock.
+ * @param now The current `millis()`.
+ */
+static void open_segment(unsigned long now) {
+  bool quiet = !(trace_output_state() & (OUTPUT_PUMP_MASK | (0xFFFFUL << OUTPUT_QUEUE_SHIFT)));
+  segmentHeader.recording = recordingId;
+  segmentHeader.sequence = nextSequence++;
+  segmentHeader.startTime = now;
+  segmentHeader.channels = SENSOR_NUM_FIELDS;
+  segmentHeader.flags = quiet ? TRACE_SEGMENT_CHECKPOINT : 0;
+  trace_codec_encoder_init(encoder, segment, sizeof(segment), segmentHeader);
+  writtenSize = 0;
+  lastWriteTime = now;
+  segmentOpen = true;
+
+  if (sink == TRACE_SINK_FLASH) {
+    int next = (headSector + 1) % TRACE_FLASH_SECTORS;
+    sectorSequences[next] = 0;
+    if (esp_partition_erase_range(partition, ringOffset + next * SECTOR_SIZE, SECTOR_SIZE) != ESP_OK) {
+      if (flashErrors++ == 0) LOG_ERROR("[Trace] ERROR: Erasing sector %d failed.\n", next);
+    }
+    headSector = next;
+    sectorSequences[next] = segmentHeader.sequence;
+  }
+
+  if (quiet) write_checkpoint(now);
+  uint64_t clockMs = command_ack_clock_ms();
+  if (clockMs != 0) trace_codec_add_number(encoder, TRACE_RECORD_CLOCK, now, clockMs);
+}
+
+/**
+ * @brief Writes the rest of the open segment out and closes it.
+ */
+static void close_segment() {
+  if (!segmentOpen) return;
+  write_out(true, 0);
+  segmentOpen = false;
+  segmentsWritten++;
+}
+
+/**
+ * @brief Appends what a replay needs to start here: the instance ID, every
+ * numeric setting, every persisted record and the actuator state.
+ * @param now The current `millis()`.
+ */
+static void write_checkpoint(unsigned long now) {
+  trace_codec_add_named(encoder, TRACE_RECORD_START, now, identity_instance_id(), nullptr, 0);
+  const char* key;
+  char value[16];
+  for (int i = 0; identity_get_number(i, key, value, sizeof(value)); i++) {
+    trace_codec_add_named(encoder, TRACE_RECORD_SETTING, now, key, value, strlen(value));
+  }
+  StorageRecordView record;
+  for (int i = 0; storage_get_record(i, record); i++) {
+    trace_codec_add_named(encoder, TRACE_RECORD_STATE, now, record.key, record.data, record.size);
+  }
+  lastOutputs = trace_output_state();
+  trace_codec_add_number(encoder, TRACE_RECORD_OUTPUTS, now, lastOutputs);
+}
+
+/**
+ * @brief Writes recorded bytes of the open segment that were not written yet.
+ * @param all Whether to write a last partial Serial line as well.
+ * @param maxLines The most Serial lines to write; 0 for no limit. Flash takes everything at once.
+ */
+static void write_out(bool all, int maxLines) {
+  if (!segmentOpen || encoder.size == writtenSize) return;
+  if (sink == TRACE_SINK_FLASH) {
+    size_t offset = ringOffset + headSector * SECTOR_SIZE + writtenSize;
+    if (esp_partition_write(partition, offset, segment + writtenSize, encoder.size - writtenSize) != ESP_OK) {
+      if (flashErrors++ == 0) LOG_ERROR("[Trace] ERROR: Writing sector %d failed.\n", headSector);
+    }
+    bytesWritten += encoder.size - writtenSize;
+    writtenSize = encoder.size;
+  } else if (sink == TRACE_SINK_SERIAL) {
+    char line[200];
+    for (int lines = 0; maxLines == 0 || lines < maxLines; lines++) {
+      size_t length = min(encoder.size - writtenSize, SERIAL_LINE_BYTES);
+      if (length == 0 || (length < SERIAL_LINE_BYTES && !all)) break;
+      format_line(line, sizeof(line), segmentHeader.recording, segmentHeader.sequence, writtenSize,
+                  segment + writtenSize, length);
+      logger_write_data(line);
+      writtenSize += length;
+      bytesWritten += length;
+    }
+  }
+  if (all) lastWriteTime = millis();
+}
+
+/**
+ * @brief Ends the current recording; the next one starts with a new ID.
+ */
+static void stop_recording() {
+  close_segment();
+  if (recording) LOG_INFO("[Trace] Recording %08x stopped.\n", (unsigned)recordingId);
+  recording = false;
+}
+
+/**
+ * @brief Reads the header of every ring sector, to continue after the newest segment.
+ */
+static void scan_ring() {
+  uint32_t newest = 0;
+  for (int i = 0; i < TRACE_FLASH_SECTORS; i++) {
+    uint8_t header[TRACE_SEGMENT_HEADER_SIZE];
+    TraceDecoder decoder;
+    sectorSequences[i] = 0;
+    if (esp_partition_read(partition, ringOffset + i * SECTOR_SIZE, header, sizeof(header)) != ESP_OK ||
+        !trace_codec_decoder_init(decoder, header, sizeof(header))) {
+      continue;
+    }
+    sectorSequences[i] = decoder.header.sequence;
+    if (decoder.header.sequence > newest) {
+      newest = decoder.header.sequence;
+      headSector = i;
+    }
+  }
+  nextSequence = newest + 1;
+}
+
+/**
+ * @brief Returns the ring sector holding a segment, or -1.
+ */
+static int sector_of(uint32_t sequence) {
+  for (int i = 0; i < TRACE_FLASH_SECTORS; i++) {
+    if (sequence != 0 && sectorSequences[i] == sequence) return i;
+  }
+  return -1;
+}
+
+/**
+ * @brief Returns the oldest segment in the ring after a given one. Segments
+ * recorded to Serial leave gaps in the ring's sequence numbers.
+ * @param after The sequence number to start after; 0 for the oldest segment.
+ * @return The segment's sequence number, or 0 if there is none.
+ */
+static uint32_t next_in_ring(uint32_t after) {
+  uint32_t next = 0;
+  for (int i = 0; i < TRACE_FLASH_SECTORS; i++) {
+    if (sectorSequences[i] > after && (next == 0 || sectorSequences[i] < next)) next = sectorSequences[i];
+  }
+  return next;
+}
+
+/**
+ * @brief Publishes the next few lines of the flash dump. A segment ends at its
+ * first chunk of erased flash; the open one at what was written of it.
+ */
+static void stream_dump() {
+  uint8_t chunk[DUMP_LINE_BYTES];
+  char line[DUMP_LINE_BYTES * 4 / 3 + 48];
+  for (int m = 0; m < DUMP_MESSAGES_PER_LOOP && dump.active; m++) {
+    int sector = sector_of(dump.sequence);
+    if (sector < 0 && dump.sequence != 0) {
+      dump.sequence = next_in_ring(dump.sequence); // Overwritten meanwhile.
+      sector = sector_of(dump.sequence);
+    }
+    if (sector < 0) {
+      dump.active = false;
+      LOG_INFO("[Trace] Dump done, %u lines.\n", dump.lines);
+      trace_publish_status();
+      return;
+    }
+    size_t end = (sector == headSector && segmentOpen && sink == TRACE_SINK_FLASH) ? writtenSize : SECTOR_SIZE;
+    size_t length = min(end - min(dump.offset, end), DUMP_LINE_BYTES);
+    bool erased = true;
+    if (length > 0 &&
+        esp_partition_read(partition, ringOffset + sector * SECTOR_SIZE + dump.offset, chunk, length) == ESP_OK) {
+      for (size_t i = 0; i < length && erased; i++) erased = chunk[i] == 0xFF;
+    }
+    if (erased) {
+      dump.sequence = next_in_ring(dump.sequence);
+      dump.offset = 0;
+      m--; // Moving on to the next segment sends nothing.
+      continue;
+    }
+    TraceDecoder decoder;
+    uint8_t header[TRACE_SEGMENT_HEADER_SIZE];
+    esp_partition_read(partition, ringOffset + sector * SECTOR_SIZE, header, sizeof(header));
+    uint32_t recordingOfSegment = trace_codec_decoder_init(decoder, header, sizeof(header)) ? decoder.header.recording
+                                                                                            : 0;
+    format_line(line, sizeof(line), recordingOfSegment, dump.sequence, dump.offset, chunk, length);
+    line[strlen(line) - 1] = '\0'; // MQTT messages are lines already.
+    mqtt_publish_state(STATE_TOPIC_TRACE_DATA, line, false);
+    dump.offset += length;
+    dump.lines++;
+  }
+}
+
+/**
+ * @brief Formats segment bytes as a `~T` line (see trace.h), newline included.
+ */
+static void format_line(char* line, size_t size, uint32_t recording, uint32_t sequence, size_t offset,
+                        const uint8_t* data, size_t length) {
+  size_t len = snprintf(line, size, "~T %08x %x %x ", (unsigned)recording, (unsigned)sequence, (unsigned)offset);
+  for (size_t i = 0; i < length && len + 5 < size; i += 3) {
+    uint32_t group = (uint32_t)data[i] << 16;
+    if (i + 1 < length) group |= (uint32_t)data[i + 1] << 8;
+    if (i + 2 < length) group |= data[i + 2];
+    line[len++] = BASE64_DIGITS[(group >> 18) & 0x3F];
+    line[len++] = BASE64_DIGITS[(group >> 12) & 0x3F];
+    line[len++] = i + 1 < length ? BASE64_DIGITS[(group >> 6) & 0x3F] : '=';
+    line[len++] = i + 2 < length ? BASE64_DIGITS[group & 0x3F] : '=';
+  }
+  line[len++] = '\n';
+  line[len] = '\0';
+}
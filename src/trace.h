@@ -0,0 +1,96 @@
+/**
+ * @file trace.h
+ * @brief Public interface for the control trace recorder.
+ *
+ * Records what the control logic was given and what it decided, so that days
+ * or weeks of a greenhouse can be replayed on a PC through the firmware's own
+ * actuator code (see replay/replay_main.cpp), e.g. to check whether a change
+ * to the dosing logic would have decided differently. The trace holds:
+ *   - every sensor reading, and every power meter reading taken while a pump runs;
+ *   - every command the command guard admitted;
+ *   - the actuator state (`trace_output_state()`) whenever it changes.
+ * Records are compressed (see trace_codec.h) into segments of one flash sector.
+ *
+ * Publish to `.../jejak/kontrol`:
+ *   - `SERIAL` writes the trace to Serial, as `~T` lines between the log lines;
+ *   - `FLASH` writes it to a ring of `TRACE_FLASH_SECTORS` sectors at the end
+ *     of the history partition, which keeps the most recent segments;
+ *   - `OFF` stops recording (the default);
+ *   - `STATUS` publishes the status on `.../jejak/status`;
+ *   - `DUMP` publishes the flash ring on `.../jejak/data`, oldest first, one
+ *     `~T` line per message (replay/fetch_trace.py saves it to a file).
+ * The choice is persisted, so a reboot starts a new recording at once.
+ *
+ * A `~T` line is `~T <recording> <segment> <offset> <base64 bytes>`, numbers in
+ * hex: bytes of a segment starting at an offset. A lost line shows as a gap.
+ *
+ * A recording starts with a checkpoint: the instance ID, the numeric settings,
+ * every persisted record (see storage.h) and the actuator state. Every later
+ * segment that starts while no pump runs and no job waits begins with one as
+ * well, so a replay can start there, e.g. when the flash ring has overwritten
+ * the beginning. A recording itself waits for such a moment. State that lives
+ * only in RAM, like the idle power reference of the pump monitor, is not part
+ * of a checkpoint: a replay from boot is exact, and one from a later
+ * checkpoint becomes exact once that state has formed again.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "sensors.h" // For SensorValues struct
+
+/**
+ * @brief Restores the persisted choice of output and finds the flash ring.
+ * Call once in `setup()`, after `actuators_init()`.
+ */
+void trace_init();
+
+/**
+ * @brief Records a full sensor reading. Call right after the sensors were read.
+ * @param values The reading.
+ */
+void trace_sensors(const SensorValues& values);
+
+/**
+ * @brief Records a power meter reading taken while a pump runs. Call right after it was read.
+ * @param values The sensor values, with the new power meter fields.
+ */
+void trace_power(const SensorValues& values);
+
+/**
+ * @brief Records an admitted command. Call before it is routed.
+ * @param topic The command topic.
+ * @param payload The payload.
+ */
+void trace_command(const char* topic, const char* payload);
+
+/**
+ * @brief Records the actuator state if it changed. Call after every call into
+ * the actuator module that may switch something.
+ */
+void trace_outputs();
+
+/**
+ * @brief Main loop for the trace. Writes recorded bytes out and streams a dump.
+ */
+void trace_loop();
+
+/**
+ * @brief Handles a command from the trace control topic (see above).
+ * @param command The command payload.
+ */
+void trace_handle_command(const char* command);
+
+/**
+ * @brief Publishes the output in use, the recording and what was written (retained).
+ */
+void trace_publish_status();
+
+/**
+ * @brief Returns the actuator state as one word: bit i is pump i running, bit 8
+ * the buzzer, bit 9 CLEANER mode, bits 10-12 auto dosing, refill and
+ * irrigation, and bits 16 and up the number of queued jobs.
+ * @return The state word.
+ */
+uint32_t trace_output_state();
+
+#endif // TRACE_H
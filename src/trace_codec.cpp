@@ -0,0 +1,385 @@
+/**
+ * @file trace_codec.cpp
+ * @brief Implements the control trace codec.
+ */
+
+#include "trace_codec.h"
+#include <math.h>
+#include <string.h>
+
+// --- Module-Private (Static) Types & Constants ---
+
+/**
+ * @struct ByteWriter
+ * @brief Appends to a segment; a record that does not fit only sets `overflow`.
+ */
+struct ByteWriter {
+  uint8_t* buffer;
+  size_t capacity;
+  size_t pos;
+  bool overflow;
+};
+
+static const uint32_t SEGMENT_MAGIC = 0x43525448; // "HTRC"
+static const uint8_t SEGMENT_VERSION = 1;
+static const float DECIMAL_SCALES[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f};
+static const uint8_t NUM_DECIMAL_CODES = sizeof(DECIMAL_SCALES) / sizeof(DECIMAL_SCALES[0]);
+/// @brief Value codes after the decimal scales: ordered bit pattern, and NAN.
+static const uint8_t CODE_RAW = 5;
+static const uint8_t CODE_NAN = 6;
+static const uint8_t CODE_BITS = 3;
+/// @brief The NAN the sensors report; other NaN patterns are stored as raw bits.
+static const uint32_t NAN_BITS = 0x7FC00000;
+/// @brief Scaled values beyond this are not exact integers in a float anyway.
+static const float SCALED_LIMIT = 1073741824.0f;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static void put_byte(ByteWriter& writer, uint8_t value);
+static void put_varint(ByteWriter& writer, uint64_t value);
+static void put_bytes(ByteWriter& writer, const void* data, size_t size);
+static void put_u32(ByteWriter& writer, uint32_t value);
+static bool get_byte(TraceDecoder& decoder, uint8_t& value);
+static bool get_varint(TraceDecoder& decoder, uint64_t& value);
+static bool get_u32(TraceDecoder& decoder, uint32_t& value);
+static bool get_named(TraceDecoder& decoder, TraceRecord& record);
+static void put_header(ByteWriter& writer, TraceEncoder& encoder, TraceRecordType type, uint32_t time);
+static uint64_t encode_value(uint32_t previousBits, uint32_t bits);
+static bool decode_value(uint32_t previousBits, uint64_t word, uint32_t& bits);
+static bool scaled(float value, uint8_t code, int64_t& n);
+static int64_t scaled_base(uint32_t previousBits, uint8_t code);
+static uint32_t ordered(uint32_t bits);
+static uint32_t unordered(uint32_t key);
+static uint64_t zigzag(int64_t value);
+static int64_t unzigzag(uint64_t value);
+static uint32_t float_bits(float value);
+static float bits_float(uint32_t bits);
+
+// --- Public Function Implementations ---
+
+void trace_codec_encoder_init(TraceEncoder& encoder, uint8_t* buffer, size_t capacity,
+                              const TraceSegmentHeader& header) {
+  encoder.buffer = buffer;
+  encoder.capacity = capacity;
+  encoder.numChannels = header.channels;
+  encoder.lastTime = header.startTime;
+  encoder.known = 0;
+  for (uint8_t c = 0; c < TRACE_CODEC_MAX_CHANNELS; c++) encoder.lastBits[c] = NAN_BITS;
+
+  ByteWriter writer = {buffer, capacity, 0, false};
+  put_u32(writer, SEGMENT_MAGIC);
+  put_u32(writer, header.recording);
+  put_u32(writer, header.sequence);
+  put_u32(writer, header.startTime);
+  put_byte(writer, SEGMENT_VERSION);
+  put_byte(writer, header.channels);
+  put_byte(writer, header.flags);
+  put_byte(writer, 0);
+  encoder.size = writer.pos;
+}
+
+bool trace_codec_add_readings(TraceEncoder& encoder, TraceRecordType type, uint32_t time, const float* values) {
+  uint32_t bits[TRACE_CODEC_MAX_CHANNELS];
+  uint32_t changed = 0;
+  for (uint8_t c = 0; c < encoder.numChannels; c++) {
+    bits[c] = float_bits(values[c]);
+    if (!(encoder.known & (1UL << c)) || bits[c] != encoder.lastBits[c]) changed |= 1UL << c;
+  }
+
+  ByteWriter writer = {encoder.buffer, encoder.capacity, encoder.size, false};
+  put_header(writer, encoder, type, time);
+  put_varint(writer, changed);
+  for (uint8_t c = 0; c < encoder.numChannels; c++) {
+    if (!(changed & (1UL << c))) continue;
+    put_varint(writer, encode_value(encoder.lastBits[c], bits[c]));
+  }
+  if (writer.overflow) return false;
+
+  encoder.size = writer.pos;
+  encoder.lastTime = time;
+  for (uint8_t c = 0; c < encoder.numChannels; c++) encoder.lastBits[c] = bits[c];
+  encoder.known = (1UL << encoder.numChannels) - 1;
+  return true;
+}
+
+bool trace_codec_add_named(TraceEncoder& encoder, TraceRecordType type, uint32_t time, const char* name,
+                           const void* data, size_t size) {
+  size_t nameLength = strlen(name);
+  if (nameLength > TRACE_CODEC_MAX_NAME || size > TRACE_CODEC_MAX_DATA) return false;
+
+  ByteWriter writer = {encoder.buffer, encoder.capacity, encoder.size, false};
+  put_header(writer, encoder, type, time);
+  put_varint(writer, nameLength);
+  put_bytes(writer, name, nameLength);
+  put_varint(writer, size);
+  put_bytes(writer, data, size);
+  if (writer.overflow) return false;
+
+  encoder.size = writer.pos;
+  encoder.lastTime = time;
+  return true;
+}
+
+bool trace_codec_add_number(TraceEncoder& encoder, TraceRecordType type, uint32_t time, uint64_t value) {
+  ByteWriter writer = {encoder.buffer, encoder.capacity, encoder.size, false};
+  put_header(writer, encoder, type, time);
+  put_varint(writer, value);
+  if (writer.overflow) return false;
+
+  encoder.size = writer.pos;
+  encoder.lastTime = time;
+  return true;
+}
+
+bool trace_codec_decoder_init(TraceDecoder& decoder, const uint8_t* buffer, size_t size) {
+  decoder.buffer = buffer;
+  decoder.size = size;
+  decoder.pos = 0;
+  decoder.damaged = false;
+  for (uint8_t c = 0; c < TRACE_CODEC_MAX_CHANNELS; c++) decoder.lastBits[c] = NAN_BITS;
+
+  uint32_t magic;
+  uint8_t version, reserved;
+  TraceSegmentHeader& header = decoder.header;
+  if (!get_u32(decoder, magic) || magic != SEGMENT_MAGIC || !get_u32(decoder, header.recording) ||
+      !get_u32(decoder, header.sequence) || !get_u32(decoder, header.startTime) || !get_byte(decoder, version) ||
+      !get_byte(decoder, header.channels) || !get_byte(decoder, header.flags) || !get_byte(decoder, reserved)) {
+    return false;
+  }
+  if (version != SEGMENT_VERSION || header.channels > TRACE_CODEC_MAX_CHANNELS) return false;
+  decoder.lastTime = header.startTime;
+  return true;
+}
+
+bool trace_codec_decode(TraceDecoder& decoder, TraceRecord& record) {
+  if (decoder.damaged || decoder.pos >= decoder.size) return false;
+  uint8_t type = decoder.buffer[decoder.pos];
+  if (type == 0x00 || type == 0xFF) return false; // Padding or erased flash: the end of the segment.
+  decoder.pos++;
+
+  uint64_t delta;
+  if (!get_varint(decoder, delta)) return false;
+  record.type = (TraceRecordType)type;
+  record.time = decoder.lastTime + (uint32_t)delta;
+
+  uint8_t channels = decoder.header.channels;
+  switch (type) {
+    case TRACE_RECORD_SENSORS:
+    case TRACE_RECORD_POWER: {
+      uint64_t changed;
+      if (!get_varint(decoder, changed) || changed >= (1ULL << channels)) break;
+      uint32_t bits[TRACE_CODEC_MAX_CHANNELS];
+      bool valid = true;
+      for (uint8_t c = 0; c < channels && valid; c++) {
+        bits[c] = decoder.lastBits[c];
+        if (!(changed & (1ULL << c))) continue;
+        uint64_t word;
+        valid = get_varint(decoder, word) && decode_value(decoder.lastBits[c], word, bits[c]);
+      }
+      if (!valid) break;
+      for (uint8_t c = 0; c < channels; c++) {
+        decoder.lastBits[c] = bits[c];
+        record.values[c] = bits_float(bits[c]);
+      }
+      record.changed = (uint32_t)changed;
+      decoder.lastTime = record.time;
+      return true;
+    }
+    case TRACE_RECORD_START:
+    case TRACE_RECORD_SETTING:
+    case TRACE_RECORD_STATE:
+    case TRACE_RECORD_COMMAND:
+      if (!get_named(decoder, record)) break;
+      decoder.lastTime = record.time;
+      return true;
+    case TRACE_RECORD_OUTPUTS:
+    case TRACE_RECORD_CLOCK:
+    case TRACE_RECORD_BUSY:
+      if (!get_varint(decoder, record.number)) break;
+      decoder.lastTime = record.time;
+      return true;
+    default:
+      break;
+  }
+  decoder.damaged = true;
+  return false;
+}
+
+// --- Static (Private) Function Implementations ---
+
+static void put_byte(ByteWriter& writer, uint8_t value) {
+  if (writer.pos < writer.capacity) {
+    writer.buffer[writer.pos++] = value;
+  } else {
+    writer.overflow = true;
+  }
+}
+
+/**
+ * @brief Writes an unsigned LEB128 varint: 7 bits per byte, low bits first.
+ */
+static void put_varint(ByteWriter& writer, uint64_t value) {
+  while (value >= 0x80) {
+    put_byte(writer, (uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  put_byte(writer, (uint8_t)value);
+}
+
+static void put_bytes(ByteWriter& writer, const void* data, size_t size) {
+  if (writer.pos + size > writer.capacity) {
+    writer.overflow = true;
+    return;
+  }
+  if (size > 0) memcpy(writer.buffer + writer.pos, data, size);
+  writer.pos += size;
+}
+
+static void put_u32(ByteWriter& writer, uint32_t value) {
+  for (int i = 0; i < 4; i++) put_byte(writer, (uint8_t)(value >> (8 * i)));
+}
+
+static bool get_byte(TraceDecoder& decoder, uint8_t& value) {
+  if (decoder.pos >= decoder.size) return false;
+  value = decoder.buffer[decoder.pos++];
+  return true;
+}
+
+static bool get_varint(TraceDecoder& decoder, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte;
+    if (!get_byte(decoder, byte)) return false;
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+static bool get_u32(TraceDecoder& decoder, uint32_t& value) {
+  value = 0;
+  for (int i = 0; i < 4; i++) {
+    uint8_t byte;
+    if (!get_byte(decoder, byte)) return false;
+    value |= (uint32_t)byte << (8 * i);
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the name and blob of a named record into `record`.
+ * @return false if they run past the segment or exceed the limits.
+ */
+static bool get_named(TraceDecoder& decoder, TraceRecord& record) {
+  uint64_t nameLength, size;
+  if (!get_varint(decoder, nameLength) || nameLength > TRACE_CODEC_MAX_NAME ||
+      decoder.pos + nameLength > decoder.size) {
+    return false;
+  }
+  memcpy(record.name, decoder.buffer + decoder.pos, nameLength);
+  record.name[nameLength] = '\0';
+  decoder.pos += nameLength;
+
+  if (!get_varint(decoder, size) || size > TRACE_CODEC_MAX_DATA || decoder.pos + size > decoder.size) return false;
+  memcpy(record.data, decoder.buffer + decoder.pos, size);
+  record.data[size] = '\0';
+  record.dataSize = size;
+  decoder.pos += size;
+  return true;
+}
+
+/**
+ * @brief Writes a record's type and its time relative to the previous record.
+ */
+static void put_header(ByteWriter& writer, TraceEncoder& encoder, TraceRecordType type, uint32_t time) {
+  put_byte(writer, type);
+  put_varint(writer, (uint32_t)(time - encoder.lastTime));
+}
+
+/**
+ * @brief Codes a value as the shortest difference to the previous one: in the
+ * smallest decimal scale that reproduces it exactly, or in ordered bits.
+ * @param previousBits The previous value's bits (NAN_BITS for none).
+ * @param bits The value's bits.
+ * @return The zigzag-coded difference, shifted left by CODE_BITS, ORed with the code.
+ */
+static uint64_t encode_value(uint32_t previousBits, uint32_t bits) {
+  if (bits == NAN_BITS) return CODE_NAN;
+  uint64_t best = (zigzag((int64_t)ordered(bits) - (int64_t)ordered(previousBits)) << CODE_BITS) | CODE_RAW;
+  float value = bits_float(bits);
+  for (uint8_t code = 0; code < NUM_DECIMAL_CODES; code++) {
+    int64_t n;
+    if (!scaled(value, code, n) || float_bits((float)n / DECIMAL_SCALES[code]) != bits) continue;
+    uint64_t word = (zigzag(n - scaled_base(previousBits, code)) << CODE_BITS) | code;
+    if (word < best) best = word;
+  }
+  return best;
+}
+
+/**
+ * @brief Reverses `encode_value()`.
+ * @return false for an unknown code.
+ */
+static bool decode_value(uint32_t previousBits, uint64_t word, uint32_t& bits) {
+  uint8_t code = word & ((1 << CODE_BITS) - 1);
+  int64_t delta = unzigzag(word >> CODE_BITS);
+  if (code == CODE_NAN) {
+    bits = NAN_BITS;
+  } else if (code == CODE_RAW) {
+    bits = unordered((uint32_t)((int64_t)ordered(previousBits) + delta));
+  } else if (code < NUM_DECIMAL_CODES) {
+    bits = float_bits((float)(scaled_base(previousBits, code) + delta) / DECIMAL_SCALES[code]);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Scales a value by a power of ten and rounds it to an integer.
+ * @return false if the value is not finite or too large.
+ */
+static bool scaled(float value, uint8_t code, int64_t& n) {
+  float x = value * DECIMAL_SCALES[code];
+  if (!(fabsf(x) <= SCALED_LIMIT)) return false;
+  n = (int64_t)roundf(x);
+  return true;
+}
+
+/**
+ * @brief Returns the previous value in a decimal scale, the base its successor's difference is taken against.
+ */
+static int64_t scaled_base(uint32_t previousBits, uint8_t code) {
+  int64_t n;
+  return scaled(bits_float(previousBits), code, n) ? n : 0;
+}
+
+/**
+ * @brief Maps float bits to an unsigned key that sorts like the floats, so near values have near keys.
+ */
+static uint32_t ordered(uint32_t bits) {
+  return (bits & 0x80000000UL) ? ~bits : (bits | 0x80000000UL);
+}
+
+static uint32_t unordered(uint32_t key) {
+  return (key & 0x80000000UL) ? (key & 0x7FFFFFFFUL) : ~key;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint32_t float_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float bits_float(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file trace_codec.h
+ * @brief Public interface for the control trace codec.
+ *
+ * A control trace is everything the control logic was given and everything it
+ * decided, in order: sensor readings, accepted commands and the resulting
+ * actuator states (see trace.h). It is written in segments of at most
+ * TRACE_SEGMENT_SIZE bytes (one flash sector), each starting with a header,
+ * so every segment decodes on its own. A record is a type byte, the
+ * milliseconds since the previous record as a varint, and its payload:
+ * - readings: a varint mask of the channels that changed (every channel in
+ *   the first readings of a segment), then one varint per changed channel
+ *   holding the zigzag-coded difference to the previous value, in the
+ *   smallest decimal scale (1 to 10^4) that reproduces the float exactly, or
+ *   otherwise between the floats' ordered bit patterns. Values decode bit for
+ *   bit, so a replay sees exactly what the board saw;
+ * - named records (commands, settings, persisted state): a name and a blob;
+ * - numbers (actuator state word, wall clock, busy time): one varint.
+ * Erased flash (0xFF) ends a segment. Like the history codec, this module is
+ * free of hardware dependencies.
+ */
+#ifndef TRACE_CODEC_H
+#define TRACE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief The largest segment, header included: one flash sector.
+const size_t TRACE_SEGMENT_SIZE = 4096;
+/// @brief The size of the header at the start of every segment.
+const size_t TRACE_SEGMENT_HEADER_SIZE = 20;
+/// @brief The largest supported number of channels per reading.
+const uint8_t TRACE_CODEC_MAX_CHANNELS = 16;
+/// @brief The longest name of a named record (e.g. a topic).
+const size_t TRACE_CODEC_MAX_NAME = 127;
+/// @brief The largest blob of a named record (e.g. a command payload).
+const size_t TRACE_CODEC_MAX_DATA = 1023;
+/// @brief Set in a segment header when the segment starts with a checkpoint a replay can start from.
+const uint8_t TRACE_SEGMENT_CHECKPOINT = 0x01;
+
+/**
+ * @enum TraceRecordType
+ * @brief What a record holds.
+ */
+enum TraceRecordType : uint8_t {
+  TRACE_RECORD_START = 1,   ///< A checkpoint begins; the name is the instance ID.
+  TRACE_RECORD_SETTING = 2, ///< A setting in use: its key and its text, as provisioned.
+  TRACE_RECORD_STATE = 3,   ///< A persisted record: its key and its bytes.
+  TRACE_RECORD_OUTPUTS = 4, ///< The actuator state word, recorded whenever it changes.
+  TRACE_RECORD_CLOCK = 5,   ///< The wall clock, in Unix milliseconds.
+  TRACE_RECORD_SENSORS = 6, ///< A full sensor reading.
+  TRACE_RECORD_POWER = 7,   ///< A power meter reading taken while a pump runs.
+  TRACE_RECORD_COMMAND = 8, ///< An accepted command: its topic and payload.
+  TRACE_RECORD_BUSY = 9,    ///< Before a reading: the milliseconds since the actuator loop last ran.
+};
+
+/**
+ * @struct TraceSegmentHeader
+ * @brief The fields of a segment header, stored little-endian.
+ */
+struct TraceSegmentHeader {
+  uint32_t recording; ///< Random per recording, so recordings from several boots can be told apart.
+  uint32_t sequence;  ///< Increases by one per segment; 0 for the first segment of a recording.
+  uint32_t startTime; ///< `millis()` the first record's time is relative to.
+  uint8_t channels;   ///< Channels per reading.
+  uint8_t flags;      ///< TRACE_SEGMENT_CHECKPOINT.
+};
+
+/**
+ * @struct TraceEncoder
+ * @brief Appends records to a segment buffer.
+ */
+struct TraceEncoder {
+  uint8_t* buffer;
+  size_t capacity;   ///< The size of `buffer` in bytes.
+  size_t size;       ///< Bytes written so far, header included.
+  uint8_t numChannels;
+  uint32_t lastTime;
+  uint32_t known;    ///< Channels already stored in the segment; the first reading stores every channel.
+  uint32_t lastBits[TRACE_CODEC_MAX_CHANNELS];
+};
+
+/**
+ * @struct TraceRecord
+ * @brief One decoded record.
+ */
+struct TraceRecord {
+  TraceRecordType type;
+  uint32_t time;                          ///< `millis()` when it was recorded.
+  float values[TRACE_CODEC_MAX_CHANNELS]; ///< Readings: every channel, the unchanged ones included.
+  uint32_t changed;                       ///< Readings: the channels this record changed.
+  uint64_t number;                        ///< Outputs and clock records.
+  char name[TRACE_CODEC_MAX_NAME + 1];    ///< Named records; NUL-terminated.
+  uint8_t data[TRACE_CODEC_MAX_DATA + 1]; ///< Named records; NUL-terminated as well.
+  size_t dataSize;
+};
+
+/**
+ * @struct TraceDecoder
+ * @brief Reads records back from a segment.
+ */
+struct TraceDecoder {
+  const uint8_t* buffer;
+  size_t size;       ///< The size of `buffer` in bytes.
+  size_t pos;
+  bool damaged;      ///< Set when a record ran past the end of the segment or had an unknown type.
+  TraceSegmentHeader header;
+  uint32_t lastTime;
+  uint32_t lastBits[TRACE_CODEC_MAX_CHANNELS];
+};
+
+/**
+ * @brief Starts a segment: writes its header into the buffer.
+ * @param encoder The encoder.
+ * @param buffer The segment buffer.
+ * @param capacity The size of `buffer` in bytes, at most TRACE_SEGMENT_SIZE.
+ * @param header The segment's header; `channels` is at most TRACE_CODEC_MAX_CHANNELS.
+ */
+void trace_codec_encoder_init(TraceEncoder& encoder, uint8_t* buffer, size_t capacity,
+                              const TraceSegmentHeader& header);
+
+/**
+ * @brief Appends a sensor or power meter reading.
+ * @param encoder The encoder.
+ * @param type TRACE_RECORD_SENSORS or TRACE_RECORD_POWER.
+ * @param time The record's `millis()`.
+ * @param values Every channel (`numChannels` of them); NAN is stored as is.
+ * @return false if the record does not fit the segment; nothing was written.
+ */
+bool trace_codec_add_readings(TraceEncoder& encoder, TraceRecordType type, uint32_t time, const float* values);
+
+/**
+ * @brief Appends a named record.
+ * @param encoder The encoder.
+ * @param type TRACE_RECORD_START, TRACE_RECORD_SETTING, TRACE_RECORD_STATE or TRACE_RECORD_COMMAND.
+ * @param time The record's `millis()`.
+ * @param name The name, at most TRACE_CODEC_MAX_NAME characters.
+ * @param data The blob; may be nullptr if `size` is 0.
+ * @param size The size of the blob, at most TRACE_CODEC_MAX_DATA.
+ * @return false if the record does not fit the segment or the limits; nothing was written.
+ */
+bool trace_codec_add_named(TraceEncoder& encoder, TraceRecordType type, uint32_t time, const char* name,
+                           const void* data, size_t size);
+
+/**
+ * @brief Appends a number record.
+ * @param encoder The encoder.
+ * @param type TRACE_RECORD_OUTPUTS, TRACE_RECORD_CLOCK or TRACE_RECORD_BUSY.
+ * @param time The record's `millis()`.
+ * @param value The number.
+ * @return false if the record does not fit the segment; nothing was written.
+ */
+bool trace_codec_add_number(TraceEncoder& encoder, TraceRecordType type, uint32_t time, uint64_t value);
+
+/**
+ * @brief Starts reading a segment.
+ * @param decoder The decoder.
+ * @param buffer The segment, header included.
+ * @param size The number of valid bytes in `buffer`.
+ * @return false if the buffer does not start with a segment header.
+ */
+bool trace_codec_decoder_init(TraceDecoder& decoder, const uint8_t* buffer, size_t size);
+
+/**
+ * @brief Reads the next record.
+ * @param decoder The decoder.
+ * @param record Receives the record.
+ * @return false at the end of the segment, or if the rest is damaged (`decoder.damaged` is set).
+ */
+bool trace_codec_decode(TraceDecoder& decoder, TraceRecord& record);
+
+#endif // TRACE_CODEC_H
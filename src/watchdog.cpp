@@ -0,0 +1,217 @@
+/**
+ * @file watchdog.cpp
+ * @brief Implements the loop watchdog, stall statistics and crash record.
+ *
+ * The crash record lives in RTC memory that the startup code does not
+ * initialize, so it survives panics, watchdog and software resets. After a
+ * power-on its contents are random, which the magic number detects. It is
+ * updated in place on every phase change; a few stores per loop iteration.
+ */
+
+#include "watchdog.h"
+#include "config.h"
+#include "boot_metrics.h"
+#include "mqtt_handler.h"
+#include <esp_system.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_task_wdt.h>
+  #include <soc/gpio_reg.h>
+  #if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH && CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+    #include <esp_core_dump.h>
+    #define WATCHDOG_HAS_CORE_DUMP 1
+  #endif
+#endif
+
+#ifndef RTC_NOINIT_ATTR
+  #define RTC_NOINIT_ATTR // Native builds: an ordinary variable, invalid at every start.
+#endif
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct CrashRecord
+ * @brief What the previous run was doing, kept across resets in RTC memory.
+ */
+struct CrashRecord {
+  uint32_t magic;     ///< CRASH_RECORD_MAGIC once initialized.
+  uint32_t resets;    ///< Resets other than power-on since the last power-on.
+  uint32_t uptimeMs;  ///< `millis()` at the last phase change.
+  uint32_t phase;     ///< The loop phase at the last phase change.
+};
+
+static const uint32_t CRASH_RECORD_MAGIC = 0x48494452; // "HIDR"
+/// @brief The deepest backtrace reported.
+static const int MAX_BACKTRACE_DEPTH = 8;
+
+/// @brief JSON names for the loop phases, indexed by `LoopPhase`.
+static const char* const PHASE_NAMES[LOOP_NUM_PHASES] = {
+  "setup", "network", "control", "power_sample", "sensors", "publish"
+};
+
+static RTC_NOINIT_ATTR CrashRecord crashRecord;
+
+/// @brief The previous run's record and whether it ended in a crash worth reporting.
+static CrashRecord previousRun;
+static bool crashReportPending = false;
+
+/// @brief The GPIOs driven LOW by the watchdog interrupt.
+static uint64_t safeOutputMask = 0;
+
+static LoopPhase currentPhase = LOOP_PHASE_SETUP;
+static unsigned long phaseStartTime = 0;
+/// @brief The longest single stay in each phase since boot, in ms.
+static uint32_t phaseMaxMs[LOOP_NUM_PHASES];
+/// @brief How often each phase took at least WATCHDOG_STALL_THRESHOLD_MS.
+static uint32_t phaseStalls[LOOP_NUM_PHASES];
+static bool statsPublished = false;
+static unsigned long lastStatsPublishTime = 0;
+
+// --- Forward Declarations for Static (Private) Functions ---
+static bool is_crash_reset(esp_reset_reason_t reason);
+static void publish_crash_report();
+static void publish_stall_stats();
+
+// --- Public Function Implementations ---
+
+void watchdog_init(uint64_t outputPinMask) {
+  safeOutputMask = outputPinMask;
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  if (reason == ESP_RST_POWERON || crashRecord.magic != CRASH_RECORD_MAGIC || crashRecord.phase >= LOOP_NUM_PHASES) {
+    crashRecord.magic = CRASH_RECORD_MAGIC;
+    crashRecord.resets = 0;
+  } else {
+    crashRecord.resets++;
+    previousRun = crashRecord;
+    crashReportPending = is_crash_reset(reason);
+    if (crashReportPending) {
+      LOG_ERROR("[Watchdog] Previous run crashed (%s) in phase '%s' after %lu ms.\n", boot_metrics_reset_reason(),
+                PHASE_NAMES[previousRun.phase], (unsigned long)previousRun.uptimeMs);
+    }
+  }
+  crashRecord.uptimeMs = millis();
+  crashRecord.phase = LOOP_PHASE_SETUP;
+  phaseStartTime = millis();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  // The core already runs the task watchdog for the idle tasks; this sets our
+  // timeout, makes it reset the chip, and adds the loop task.
+  esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+  esp_task_wdt_add(nullptr);
+#endif
+  LOG_INFO("[Watchdog] Armed, timeout %lu s.\n", (unsigned long)WATCHDOG_TIMEOUT_S);
+}
+
+void watchdog_loop() {
+#if defined(ARDUINO_ARCH_ESP32)
+  esp_task_wdt_reset();
+#endif
+  watchdog_enter(LOOP_PHASE_NETWORK);
+
+  if (!mqtt_is_connected()) return;
+  if (crashReportPending) {
+    crashReportPending = false;
+    publish_crash_report();
+  }
+  if (!statsPublished || millis() - lastStatsPublishTime >= WATCHDOG_STATS_PUBLISH_INTERVAL_MS) {
+    statsPublished = true;
+    lastStatsPublishTime = millis();
+    publish_stall_stats();
+  }
+}
+
+void watchdog_enter(LoopPhase phase) {
+  unsigned long now = millis();
+  uint32_t elapsed = now - phaseStartTime;
+  if (elapsed > phaseMaxMs[currentPhase]) phaseMaxMs[currentPhase] = elapsed;
+  if (elapsed >= (uint32_t)WATCHDOG_STALL_THRESHOLD_MS) {
+    phaseStalls[currentPhase]++;
+    LOG_WARN("[Watchdog] WARN: Phase '%s' took %lu ms.\n", PHASE_NAMES[currentPhase], (unsigned long)elapsed);
+  }
+
+  currentPhase = phase;
+  phaseStartTime = now;
+  crashRecord.phase = phase;
+  crashRecord.uptimeMs = now;
+}
+
+// --- Static (Private) Function Implementations ---
+
+#if defined(ARDUINO_ARCH_ESP32)
+/**
+ * @brief Called by the IDF from the task watchdog interrupt, before it panics.
+ * Runs in interrupt context with the loop task stuck, so it writes the GPIO
+ * clear registers directly: every pump relay and the buzzer go LOW before the reset.
+ */
+extern "C" void IRAM_ATTR esp_task_wdt_isr_user_handler(void) {
+  REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)safeOutputMask);
+  REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(safeOutputMask >> 32));
+}
+#endif
+
+/**
+ * @brief Whether a reset reason means the previous run ended abnormally.
+ * @param reason The reset reason.
+ * @return true for panics, watchdog resets and brownouts.
+ */
+static bool is_crash_reset(esp_reset_reason_t reason) {
+  return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+         reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT;
+}
+
+/**
+ * @brief Publishes the previous run's crash record, retained, with the core dump summary if there is one.
+ */
+static void publish_crash_report() {
+  char payload[384];
+  size_t len = 0;
+  len += snprintf(payload + len, sizeof(payload) - len,
+                  "{\"reset_reason\":\"%s\",\"phase\":\"%s\",\"uptime_ms\":%lu,\"resets\":%lu",
+                  boot_metrics_reset_reason(), PHASE_NAMES[previousRun.phase],
+                  (unsigned long)previousRun.uptimeMs, (unsigned long)previousRun.resets + 1);
+
+#if defined(WATCHDOG_HAS_CORE_DUMP)
+  // The core dump holds the PC and backtrace of the task that crashed. After a
+  // task watchdog reset that is the interrupted task, not the stalled loop;
+  // the phase above says where the loop was.
+  esp_core_dump_summary_t summary;
+  if (esp_core_dump_get_summary(&summary) == ESP_OK && len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, ",\"task\":\"%s\",\"pc\":\"0x%08lx\",\"backtrace\":[",
+                    summary.exc_task, (unsigned long)summary.exc_pc);
+    int depth = min((int)summary.exc_bt_info.depth, MAX_BACKTRACE_DEPTH);
+    for (int i = 0; i < depth && len < sizeof(payload); i++) {
+      len += snprintf(payload + len, sizeof(payload) - len, "%s\"0x%08lx\"", i ? "," : "",
+                      (unsigned long)summary.exc_bt_info.bt[i]);
+    }
+    if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "]");
+    // Erase it so that a later reset without a dump cannot report this one again.
+    esp_core_dump_image_erase();
+  }
+#endif
+  if (len < sizeof(payload)) snprintf(payload + len, sizeof(payload) - len, "}");
+
+  mqtt_publish_state(STATE_TOPIC_CRASH, payload, true);
+}
+
+/**
+ * @brief Publishes the longest stay and the stall count of each loop phase since boot.
+ */
+static void publish_stall_stats() {
+  char payload[320];
+  size_t len = 0;
+  len += snprintf(payload + len, sizeof(payload) - len, "{\"timeout_s\":%lu,\"stall_ms\":%ld,\"max_ms\":{",
+                  (unsigned long)WATCHDOG_TIMEOUT_S, WATCHDOG_STALL_THRESHOLD_MS);
+  for (int i = 0; i < LOOP_NUM_PHASES && len < sizeof(payload); i++) {
+    len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":%lu", i ? "," : "", PHASE_NAMES[i],
+                    (unsigned long)phaseMaxMs[i]);
+  }
+  if (len < sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "},\"stalls\":{");
+  for (int i = 0; i < LOOP_NUM_PHASES && len < sizeof(payload); i++) {
+    len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":%lu", i ? "," : "", PHASE_NAMES[i],
+                    (unsigned long)phaseStalls[i]);
+  }
+  if (len < sizeof(payload)) snprintf(payload + len, sizeof(payload) - len, "}}");
+
+  mqtt_publish_state(STATE_TOPIC_WATCHDOG, payload, true);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file watchdog.h
+ * @brief Public interface for the loop watchdog, stall statistics and crash record.
+ *
+ * The main loop does both control and sensor acquisition, so it is the task
+ * the ESP32 task watchdog guards. If one iteration blocks for longer than
+ * `WATCHDOG_TIMEOUT_S` (a hung WiFi call, a locked-up Modbus or OneWire bus),
+ * the watchdog first drives every actuator output LOW from its interrupt and
+ * then resets the chip.
+ *
+ * The loop marks which phase it is in. The phase and the uptime are kept in
+ * RTC memory, which survives the reset. On the next boot they are published
+ * with the reset reason, and with the crashed task's PC and backtrace when a
+ * core dump is available. The longest time spent in each phase is published as
+ * well, so the timeout can be tuned from data.
+ */
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stdint.h>
+
+/**
+ * @enum LoopPhase
+ * @brief The parts of the main loop that stalls are attributed to.
+ */
+enum LoopPhase {
+  LOOP_PHASE_SETUP,        ///< `setup()`, before the first loop iteration.
+  LOOP_PHASE_NETWORK,      ///< WiFi supervision, the MQTT client and the commands it delivers.
+  LOOP_PHASE_CONTROL,      ///< Actuator, storage and logger loops.
+  LOOP_PHASE_POWER_SAMPLE, ///< High-rate PZEM sampling while a pump runs.
+  LOOP_PHASE_SENSORS,      ///< A full sensor cycle.
+  LOOP_PHASE_PUBLISH,      ///< Periodic MQTT publishes.
+  LOOP_NUM_PHASES
+};
+
+/**
+ * @brief Loads the previous run's crash record and arms the task watchdog on the calling task.
+ * Call from `setup()` once the actuator outputs are configured.
+ * @param outputPinMask The GPIOs (bit n for GPIO n) to drive LOW when the watchdog fires.
+ */
+void watchdog_init(uint64_t outputPinMask);
+
+/**
+ * @brief Feeds the watchdog and starts a loop iteration in LOOP_PHASE_NETWORK.
+ * Publishes the crash record and the stall statistics when they are due. Call
+ * first thing in `loop()`.
+ */
+void watchdog_loop();
+
+/**
+ * @brief Marks the start of a loop phase. The time since the previous mark is
+ * attributed to the previous phase.
+ * @param phase The phase that starts now.
+ */
+void watchdog_enter(LoopPhase phase);
+
+#endif // WATCHDOG_H
@@ -0,0 +1,159 @@
+/**
+ * @file test_main.cpp
+ * @brief Command guard tests: commands reach the firmware through the
+ * simulated broker, and the tests check which of them ran.
+ *
+ * Messages arrive as PUBLISH packets through the firmware's client, which
+ * tells retained replays by their RETAIN flag. The tests share one boot and
+ * run in order on one timeline.
+ *   pio test -e native -f test_command_guard
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+#include <string>
+
+void setup();
+void loop();
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Runs the firmware until a virtual time, one loop() per millisecond.
+ */
+static void run_until(double seconds) {
+  while (sim_now_us() < (uint64_t)(seconds * 1e6)) {
+    sim_scenario_step();
+    loop();
+    sim_advance_us(1000);
+  }
+}
+
+/**
+ * @brief Whether the last payload the device published on a topic contains `text`.
+ */
+static bool last_contains(const MqttTopic& topic, const char* text) {
+  const std::string* payload = sim_mqtt_last(topic.c_str());
+  return payload != nullptr && payload->find(text) != std::string::npos;
+}
+
+static double pump_on_s(int pump) {
+  return sim_plant_state().pumpOnS[pump];
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_retained_commands_are_not_replayed_but_live_ones_run() {
+  // Left retained by a dashboard while the device was away; they must not run again at every connect.
+  sim_scenario_add("0.3s sim.retain ~/sensor/kalibrasi/kontrol PH 4.01");
+  sim_scenario_add("0.3s sim.retain ~/pompa/nutrisi_b/kontrol 20");
+  sim_scenario_add("0.5s sim.broker up");
+  // Until the device has connected and subscribed.
+  while (sim_mqtt_stats().connects == 0 && sim_now_us() < 15000000) run_until(sim_now_us() / 1e6 + 0.001);
+  TEST_ASSERT_EQUAL(1, sim_mqtt_stats().connects);
+  // Sent just after the device subscribed, behind the retained ones.
+  sim_scenario_apply("~/pompa/nutrisi_a/kontrol", "20");
+  run_until(15);
+  TEST_ASSERT_GREATER_THAN(0, (long)(pump_on_s(0) * 1000));
+  TEST_ASSERT_EQUAL_FLOAT(0, pump_on_s(1));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_PROBE_CALIBRATION, "\"ph_open\":false"));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"stale\":2,"));
+}
+
+void test_live_calibration_command_runs() {
+  sim_scenario_add("20.3s ~/sensor/kalibrasi/kontrol PH 4.01");
+  run_until(22);
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_PROBE_CALIBRATION, "\"ph_open\":true"));
+  sim_scenario_add("25.3s ~/sensor/kalibrasi/kontrol CANCEL");
+  run_until(27);
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_PROBE_CALIBRATION, "\"ph_open\":false"));
+}
+
+void test_new_session_does_not_replay_retained_commands() {
+  // The broker forgets the session, so the device subscribes again and gets the retained commands again.
+  sim_scenario_add("30.3s sim.broker wipe");
+  sim_scenario_add("35.3s sim.broker up");
+  run_until(120);
+  TEST_ASSERT_EQUAL(2, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL_FLOAT(0, pump_on_s(1));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_PROBE_CALIBRATION, "\"ph_open\":false"));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"stale\":4,"));
+}
+
+void test_command_queued_through_a_short_outage_runs() {
+  double onBefore = pump_on_s(0);
+  sim_scenario_add("130.3s sim.wifi down");
+  sim_scenario_add("135.3s ~/pompa/nutrisi_a/kontrol 20");
+  sim_scenario_add("140.3s sim.wifi up");
+  run_until(200);
+  TEST_ASSERT_EQUAL(3, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(1, sim_mqtt_stats().resumed);
+  TEST_ASSERT_GREATER_THAN(0, (long)((pump_on_s(0) - onBefore) * 1000));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"stale\":4,"));
+}
+
+void test_command_queued_through_a_long_outage_is_dropped() {
+  sim_scenario_add("210.3s sim.wifi down");
+  sim_scenario_add("215.3s ~/pompa/nutrisi_b/kontrol 20");
+  sim_scenario_add("290.3s sim.wifi up");
+  run_until(400);
+  TEST_ASSERT_EQUAL(4, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(2, sim_mqtt_stats().resumed);
+  TEST_ASSERT_EQUAL_FLOAT(0, pump_on_s(1));
+  // The queued dose, then the retained commands of the new subscription.
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"stale\":7,"));
+
+  // The broker acknowledged the subscription, so commands are live again.
+  sim_scenario_add("400.3s ~/pompa/nutrisi_b/kontrol 20");
+  run_until(420);
+  TEST_ASSERT_GREATER_THAN(0, (long)(pump_on_s(1) * 1000));
+}
+
+void test_flood_is_rate_limited() {
+  sim_scenario_add("430.3s sim.flood 20 ~/pompa/nutrisi_a/kontrol 1");
+  run_until(460);
+  // A burst of COMMAND_RATE_BURST (5) runs; the rest arrive in the same instant and are dropped.
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"rate_limited\":15}"));
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"stale\":7,"));
+
+  // Six ON/OFF pairs at once: the sixth ON exceeds the burst, but every OFF is a stop and gets through.
+  for (int i = 0; i < 6; i++) {
+    sim_scenario_add("470.3s ~/pompa/tandon/kontrol ON");
+    sim_scenario_add("470.3s ~/pompa/tandon/kontrol OFF");
+  }
+  run_until(470.3);
+  bool opened = false;
+  while (sim_now_us() < 471000000) {
+    run_until(sim_now_us() / 1e6 + 0.001);
+    if (digitalRead(PUMP_TANDON_PIN) == HIGH) opened = true;
+  }
+  TEST_ASSERT_TRUE(opened);
+  TEST_ASSERT_EQUAL(LOW, digitalRead(PUMP_TANDON_PIN));
+  run_until(490);
+  TEST_ASSERT_TRUE(last_contains(STATE_TOPIC_COMMAND_GUARD, "\"rate_limited\":16}"));
+}
+
+int main(int argc, char** argv) {
+  sim_plant_init(sim_plant_default_params(), 1);
+  randomSeed(1);
+  // Boots with the broker down, so the device first connects after the retained commands were left.
+  sim_mqtt_set_broker_running(false, true);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_retained_commands_are_not_replayed_but_live_ones_run);
+  RUN_TEST(test_live_calibration_command_runs);
+  RUN_TEST(test_new_session_does_not_replay_retained_commands);
+  RUN_TEST(test_command_queued_through_a_short_outage_runs);
+  RUN_TEST(test_command_queued_through_a_long_outage_is_dropped);
+  RUN_TEST(test_flood_is_rate_limited);
+  return UNITY_END();
+}
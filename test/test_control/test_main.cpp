@@ -0,0 +1,133 @@
+/**
+ * @file test_main.cpp
+ * @brief Control-logic regression tests: the firmware's `setup()` and `loop()`
+ * run against the simulated plant, and the tests check what reached the relays
+ * and the plant.
+ *
+ * The firmware's static state cannot be reset within one process, so the tests
+ * share one boot and run in order on one timeline.
+ *   pio test -e native -f test_control
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+
+void setup();
+void loop();
+
+/**
+ * @brief Runs the firmware for a span of virtual time, one loop() per millisecond.
+ */
+static void run_for(double seconds) {
+  uint64_t endUs = sim_now_us() + (uint64_t)(seconds * 1e6);
+  while (sim_now_us() < endUs) {
+    sim_scenario_step();
+    loop();
+    sim_advance_us(1000);
+  }
+}
+
+/**
+ * @brief The last number the device published on a topic, or NAN.
+ */
+static double last_value(const MqttTopic& topic) {
+  const std::string* payload = sim_mqtt_last(topic.c_str());
+  return payload ? atof(payload->c_str()) : NAN;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sensor_readings_track_the_plant() {
+  run_for(2 * SENSOR_PUBLISH_INTERVAL_MS / 1000.0);
+  TEST_ASSERT_FLOAT_WITHIN(1.0, sim_plant_level_cm(), last_value(STATE_TOPIC_LEVEL));
+  TEST_ASSERT_FLOAT_WITHIN(0.05 * sim_plant_tds_ppm(), sim_plant_tds_ppm(), last_value(STATE_TOPIC_TDS));
+  TEST_ASSERT_FLOAT_WITHIN(0.1, sim_plant_state().ph, last_value(STATE_TOPIC_PH));
+}
+
+void test_timed_dose_runs_for_its_volume() {
+  double onBefore = sim_plant_state().pumpOnS[0];
+  sim_scenario_apply("~/pompa/nutrisi_a/kontrol", "20");
+  run_for(5);
+  // Never short; a blocking sensor read (the DS18B20 conversion alone takes 750 ms)
+  // that falls into the run delays the stop by up to its own duration.
+  long onMs = (long)((sim_plant_state().pumpOnS[0] - onBefore) * 1000);
+  TEST_ASSERT_GREATER_OR_EQUAL((long)(20 * PUMP_MS_PER_ML), onMs);
+  TEST_ASSERT_LESS_OR_EQUAL((long)(20 * PUMP_MS_PER_ML) + 1000, onMs);
+  TEST_ASSERT_EQUAL_STRING("OFF", sim_mqtt_last(STATE_TOPIC_PUMP_A.c_str())->c_str());
+}
+
+void test_irrigation_runs_for_its_seconds() {
+  double onBefore = sim_plant_state().pumpOnS[3];
+  sim_scenario_apply("~/pompa/penyiraman/kontrol", "15");
+  run_for(20);
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 15.0, sim_plant_state().pumpOnS[3] - onBefore);
+}
+
+void test_refill_reconnects_through_a_broker_outage() {
+  // Home Assistant ends a refill with "OFF" at its target level, so the device
+  // must get back to the broker while the valve is still open.
+  sim_plant_set_level_cm(85);
+  run_for(2 * SENSOR_PUBLISH_INTERVAL_MS / 1000.0);
+  sim_scenario_apply("~/pompa/tandon/kontrol", "ON");
+  run_for(2);
+  uint32_t connects = sim_mqtt_stats().connects;
+  sim_mqtt_set_broker_running(false, true);
+  run_for(5);
+  sim_mqtt_set_broker_running(true, true);
+  run_for(15);
+  TEST_ASSERT_EQUAL(connects + 1, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(HIGH, digitalRead(PUMP_TANDON_PIN));
+
+  sim_scenario_apply("~/pompa/tandon/kontrol", "OFF");
+  run_for(2);
+  TEST_ASSERT_EQUAL(LOW, digitalRead(PUMP_TANDON_PIN));
+  TEST_ASSERT_LESS_THAN(90, (long)sim_plant_state().maxLevelCm);
+}
+
+void test_tandon_safety_stops_the_refill() {
+  // An "ON" without the matching "OFF", as when the automation dies mid-refill.
+  sim_plant_set_level_cm(92);
+  run_for(2 * SENSOR_PUBLISH_INTERVAL_MS / 1000.0);
+  sim_scenario_apply("~/pompa/tandon/kontrol", "ON");
+  run_for(5);
+  TEST_ASSERT_EQUAL_STRING("ON", sim_mqtt_last(STATE_TOPIC_PUMP_TANDON.c_str())->c_str());
+
+  run_for(120);
+  TEST_ASSERT_EQUAL_STRING("OFF", sim_mqtt_last(STATE_TOPIC_PUMP_TANDON.c_str())->c_str());
+  // The ultrasonic sensor resolves whole centimeters.
+  TEST_ASSERT_FLOAT_WITHIN(1.0, 95.0, sim_plant_state().maxLevelCm);
+  TEST_ASSERT_EQUAL_FLOAT(0.0, sim_plant_state().overflowL);
+}
+
+void test_refill_stays_off_at_the_high_limit() {
+  // A new "ON" above the safety level is switched off again at once.
+  sim_plant_set_level_cm(97);
+  run_for(2 * SENSOR_PUBLISH_INTERVAL_MS / 1000.0);
+  double onBefore = sim_plant_state().pumpOnS[4];
+  sim_scenario_apply("~/pompa/tandon/kontrol", "ON");
+  run_for(10);
+  TEST_ASSERT_EQUAL_STRING("OFF", sim_mqtt_last(STATE_TOPIC_PUMP_TANDON.c_str())->c_str());
+  TEST_ASSERT_LESS_THAN(1000, (long)((sim_plant_state().pumpOnS[4] - onBefore) * 1000));
+}
+
+int main(int argc, char** argv) {
+  sim_plant_init(sim_plant_default_params(), 1);
+  randomSeed(1);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sensor_readings_track_the_plant);
+  RUN_TEST(test_timed_dose_runs_for_its_volume);
+  // Before the irrigation: the water draining back from the channels would raise the level after the stop.
+  RUN_TEST(test_refill_reconnects_through_a_broker_outage);
+  RUN_TEST(test_tandon_safety_stops_the_refill);
+  RUN_TEST(test_refill_stays_off_at_the_high_limit);
+  RUN_TEST(test_irrigation_runs_for_its_seconds);
+  return UNITY_END();
+}
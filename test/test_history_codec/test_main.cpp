@@ -0,0 +1,218 @@
+/**
+ * @file test_main.cpp
+ * @brief history_codec tests: every block must decode to exactly the records
+ * that were encoded, bit for bit, whatever the values and time stamps.
+ *   pio test -e native -f test_history_codec
+ */
+
+#include <unity.h>
+#include "history_codec.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+/// @brief As many channels as the firmware's history records.
+static const uint8_t NUM_CHANNELS = 6;
+/// @brief About the payload of one history sector.
+static const size_t BLOCK_CAPACITY = 4000;
+
+/**
+ * @struct Record
+ * @brief One time-stamped record.
+ */
+struct Record {
+  uint32_t time;
+  float values[HISTORY_CODEC_MAX_CHANNELS];
+};
+
+static uint32_t rngState = 12345;
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief xorshift32, so the streams are the same on every host.
+ */
+static uint32_t next_random() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static float noise(float amplitude) {
+  return amplitude * ((float)(next_random() % 2001) / 1000.0f - 1.0f);
+}
+
+static uint32_t float_bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+/**
+ * @brief Encodes records until the block is full, then decodes it and compares every bit.
+ * @return The number of records the block took.
+ */
+static size_t round_trip(const std::vector<Record>& records, uint8_t numChannels, size_t capacity) {
+  std::vector<uint8_t> buffer(capacity);
+  HistoryEncoder encoder;
+  history_codec_encoder_init(encoder, buffer.data(), buffer.size(), numChannels);
+  size_t encoded = 0;
+  while (encoded < records.size() && history_codec_encode(encoder, records[encoded].time, records[encoded].values)) {
+    encoded++;
+  }
+  TEST_ASSERT_EQUAL(encoded, encoder.count);
+  TEST_ASSERT_LESS_OR_EQUAL(capacity, history_codec_encoded_size(encoder));
+
+  HistoryDecoder decoder;
+  history_codec_decoder_init(decoder, buffer.data(), history_codec_encoded_size(encoder), encoder.count,
+                             numChannels);
+  Record decoded;
+  for (size_t i = 0; i < encoded; i++) {
+    TEST_ASSERT_TRUE(history_codec_decode(decoder, decoded.time, decoded.values));
+    TEST_ASSERT_EQUAL_UINT32(records[i].time, decoded.time);
+    for (uint8_t c = 0; c < numChannels; c++) {
+      TEST_ASSERT_EQUAL_UINT32(float_bits(records[i].values[c]), float_bits(decoded.values[c]));
+    }
+  }
+  TEST_ASSERT_FALSE(history_codec_decode(decoder, decoded.time, decoded.values));
+  return encoded;
+}
+
+/**
+ * @brief A day of sensor-like records: slow drifts with noise, a stuck
+ * reading, a missing one and a jittering sampling interval with gaps.
+ */
+static std::vector<Record> sensor_records(size_t count) {
+  std::vector<Record> records(count);
+  uint32_t time = 1760000000;
+  for (size_t i = 0; i < count; i++) {
+    Record& record = records[i];
+    time += 60 + (next_random() % 5 == 0 ? (int)(next_random() % 7) - 3 : 0);
+    if (i % 500 == 499) time += 3600; // An outage.
+    record.time = time;
+    record.values[0] = 24.0f + 3.0f * sinf(i / 200.0f) + noise(0.06f); // Water temperature
+    record.values[1] = 6.2f + noise(0.05f);                                // pH
+    record.values[2] = roundf(850.0f + noise(20.0f));                    // TDS, whole ppm
+    record.values[3] = 60.0f;                                             // Level, unchanged
+    record.values[4] = i % 97 == 0 ? NAN : 28.0f + noise(0.5f);           // Air temperature
+    record.values[5] = roundf(65.0f + noise(5.0f));                       // Humidity
+  }
+  return records;
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_sensor_records_round_trip() {
+  std::vector<Record> records = sensor_records(2000);
+  size_t offset = 0;
+  while (offset < records.size()) {
+    std::vector<Record> rest(records.begin() + offset, records.end());
+    size_t taken = round_trip(rest, NUM_CHANNELS, BLOCK_CAPACITY);
+    TEST_ASSERT_GREATER_THAN(100, taken); // Several times better than 28 raw bytes per record.
+    offset += taken;
+  }
+}
+
+void test_arbitrary_bit_patterns_round_trip() {
+  // NAN payloads, infinities, -0, subnormals and sign flips: the XOR windows take every shape.
+  std::vector<Record> records(3000);
+  for (size_t i = 0; i < records.size(); i++) {
+    records[i].time = (uint32_t)i;
+    for (uint8_t c = 0; c < HISTORY_CODEC_MAX_CHANNELS; c++) {
+      uint32_t bits = next_random();
+      if (c % 4 == 1) bits &= 0x807FFFFF;          // Subnormals and zeros
+      if (c % 4 == 2) bits |= 0x7F800000;          // NAN and infinities
+      if (c % 4 == 3 && i % 2) bits = 0x80000000; // -0
+      memcpy(&records[i].values[c], &bits, sizeof(bits));
+    }
+  }
+  size_t offset = 0;
+  while (offset < records.size()) {
+    std::vector<Record> rest(records.begin() + offset, records.end());
+    offset += round_trip(rest, HISTORY_CODEC_MAX_CHANNELS, BLOCK_CAPACITY);
+  }
+}
+
+void test_interval_changes_at_every_bucket_edge() {
+  // Deltas of delta at and beyond the edges of each bucket, in both directions.
+  const int32_t dods[] = {0, 1, -1, 64, -63, 65, -64, 256, -255, 257, -256, 2048, -2047, 2049, -2048, 86400, 0};
+  std::vector<Record> records;
+  Record record = {};
+  uint32_t time = 1000000;
+  int32_t delta = 100000;
+  records.push_back(record);
+  records.back().time = time;
+  for (int32_t dod : dods) {
+    delta += dod;
+    time += delta;
+    record.time = time;
+    record.values[0] = (float)dod;
+    records.push_back(record);
+  }
+  TEST_ASSERT_EQUAL(records.size(), round_trip(records, 1, 256));
+}
+
+void test_equal_time_stamps_and_large_gaps() {
+  std::vector<Record> records;
+  Record record = {};
+  const uint32_t times[] = {0, 0, 0, 1, 0x7FFFFFFF, 0x7FFFFFFF, 0xFFFFFFFE, 0xFFFFFFFF};
+  for (uint32_t time : times) {
+    record.time = time;
+    records.push_back(record);
+  }
+  TEST_ASSERT_EQUAL(records.size(), round_trip(records, 2, 256));
+}
+
+void test_full_block_leaves_the_encoder_unchanged() {
+  uint8_t buffer[64];
+  HistoryEncoder encoder;
+  history_codec_encoder_init(encoder, buffer, sizeof(buffer), NUM_CHANNELS);
+  std::vector<Record> records = sensor_records(100);
+  size_t i = 0;
+  while (history_codec_encode(encoder, records[i].time, records[i].values)) i++;
+  size_t bits = encoder.bitLength;
+  uint16_t count = encoder.count;
+  TEST_ASSERT_FALSE(history_codec_encode(encoder, records[i].time, records[i].values));
+  TEST_ASSERT_EQUAL(bits, encoder.bitLength);
+  TEST_ASSERT_EQUAL(count, encoder.count);
+}
+
+void test_truncated_block_stops_decoding() {
+  std::vector<Record> records = sensor_records(200);
+  uint8_t buffer[BLOCK_CAPACITY];
+  HistoryEncoder encoder;
+  history_codec_encoder_init(encoder, buffer, sizeof(buffer), NUM_CHANNELS);
+  for (const Record& record : records) TEST_ASSERT_TRUE(history_codec_encode(encoder, record.time, record.values));
+
+  // A block cut short, e.g. by a power loss before its commit: every record
+  // that still decodes is one that was written.
+  size_t size = history_codec_encoded_size(encoder);
+  for (size_t cut = 0; cut < size; cut += 7) {
+    HistoryDecoder decoder;
+    history_codec_decoder_init(decoder, buffer, cut, encoder.count, NUM_CHANNELS);
+    Record decoded;
+    size_t i = 0;
+    while (history_codec_decode(decoder, decoded.time, decoded.values)) {
+      TEST_ASSERT_EQUAL_UINT32(records[i].time, decoded.time);
+      i++;
+    }
+    TEST_ASSERT_LESS_THAN(records.size(), i);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sensor_records_round_trip);
+  RUN_TEST(test_arbitrary_bit_patterns_round_trip);
+  RUN_TEST(test_interval_changes_at_every_bucket_edge);
+  RUN_TEST(test_equal_time_stamps_and_large_gaps);
+  RUN_TEST(test_full_block_leaves_the_encoder_unchanged);
+  RUN_TEST(test_truncated_block_stops_decoding);
+  return UNITY_END();
+}
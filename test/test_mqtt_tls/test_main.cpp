@@ -0,0 +1,113 @@
+/**
+ * @file test_main.cpp
+ * @brief Broker connection tests over TLS: the firmware's TlsClient and
+ * PacketWatchClient against the simulated broker's TLS listener (sim_tls.h).
+ *
+ * The device trusts the broker's CA and pins its key. The tests share one
+ * boot and run in order on one timeline: a full handshake, a resumed one after
+ * the link drops, a full one after the broker restarts, and a refused one
+ * once the broker's key changes.
+ *   pio test -e native -f test_mqtt_tls
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "mqtt_tls.h"
+#include "sim_board.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+#include "sim_tls.h"
+#include <string>
+
+void setup();
+void loop();
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief Runs the firmware until a virtual time, one loop() per millisecond.
+ */
+static void run_until(double seconds) {
+  while (sim_now_us() < (uint64_t)(seconds * 1e6)) {
+    sim_scenario_step();
+    loop();
+    sim_advance_us(1000);
+  }
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_first_connection_is_a_full_handshake() {
+  // A retained command is delivered on every subscription, which shows when the device resubscribes.
+  sim_scenario_add("1.3s sim.retain ~/automasi/refill/kontrol OFF");
+  run_until(5);
+  TEST_ASSERT_EQUAL(1, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(1, sim_tls_stats().full);
+  TEST_ASSERT_EQUAL(1, mqtt_tls_stats(TLS_HANDSHAKE_FULL).count);
+  TEST_ASSERT_EQUAL(0, mqtt_tls_failures());
+  // The CONNECT went out through TlsClient::write() and decrypted at the broker.
+  TEST_ASSERT_GREATER_THAN(0, (long)sim_tls_stats().bytesIn);
+  const std::string* status = sim_mqtt_last(STATE_TOPIC_TLS.c_str());
+  TEST_ASSERT_NOT_NULL(status);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, status->find("\"full\":{\"count\":1,"));
+}
+
+void test_link_drop_resumes_the_tls_and_mqtt_sessions() {
+  uint32_t delivered = sim_mqtt_stats().delivered;
+  sim_scenario_add("10.3s sim.wifi down");
+  sim_scenario_add("20.3s sim.wifi up");
+  run_until(60);
+  TEST_ASSERT_EQUAL(2, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(1, sim_tls_stats().resumed);
+  TEST_ASSERT_EQUAL(1, mqtt_tls_stats(TLS_HANDSHAKE_RESUMED).count);
+  TEST_ASSERT_EQUAL(1, mqtt_tls_stats(TLS_HANDSHAKE_FULL).count);
+  // PacketWatchClient read the session-present flag through TLS, so the device did not resubscribe.
+  TEST_ASSERT_EQUAL(1, sim_mqtt_stats().resumed);
+  TEST_ASSERT_EQUAL(delivered, sim_mqtt_stats().delivered);
+}
+
+void test_broker_restart_needs_a_full_handshake() {
+  uint32_t delivered = sim_mqtt_stats().delivered;
+  sim_scenario_add("70.3s sim.broker wipe");
+  sim_scenario_add("75.3s sim.broker up");
+  run_until(150);
+  TEST_ASSERT_EQUAL(3, sim_mqtt_stats().connects);
+  TEST_ASSERT_EQUAL(2, sim_tls_stats().full);
+  TEST_ASSERT_EQUAL(2, mqtt_tls_stats(TLS_HANDSHAKE_FULL).count);
+  TEST_ASSERT_EQUAL(1, mqtt_tls_stats(TLS_HANDSHAKE_RESUMED).count);
+  // A new MQTT session: the device subscribed again and got the retained command again.
+  TEST_ASSERT_EQUAL(delivered + 1, sim_mqtt_stats().delivered);
+}
+
+void test_renewed_broker_key_fails_the_pin() {
+  // Still signed by the trusted CA, but no longer the pinned key.
+  TEST_ASSERT_TRUE(sim_tls_renew_key());
+  sim_scenario_add("160.3s sim.broker down");
+  sim_scenario_add("165.3s sim.broker up");
+  run_until(260);
+  TEST_ASSERT_EQUAL(3, sim_mqtt_stats().connects);
+  TEST_ASSERT_GREATER_THAN(0, mqtt_tls_failures());
+  TEST_ASSERT_EQUAL(2, mqtt_tls_stats(TLS_HANDSHAKE_FULL).count);
+}
+
+int main(int argc, char** argv) {
+  sim_plant_init(sim_plant_default_params(), 1);
+  randomSeed(1);
+  sim_tls_enable(MQTT_SERVER);
+  MQTT_TLS_CA_CERT = sim_tls_ca_pem();
+  sim_board_provision(IDENTITY_NAMESPACE, "mqtt_pin", sim_tls_pubkey_sha256());
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_first_connection_is_a_full_handshake);
+  RUN_TEST(test_link_drop_resumes_the_tls_and_mqtt_sessions);
+  RUN_TEST(test_broker_restart_needs_a_full_handshake);
+  RUN_TEST(test_renewed_broker_key_fails_the_pin);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file test_main.cpp
+ * @brief number_format tests: the output must be byte for byte what
+ * `snprintf("%.<n>f")` writes, for every float the module accepts.
+ *
+ * By default every 4099th bit pattern is checked, which covers every exponent
+ * and both signs, and every float in the ranges the firmware publishes most.
+ * Defining NUMBER_FORMAT_TEST_EXHAUSTIVE checks all 2^32 bit patterns at every
+ * number of decimals, which takes about half an hour:
+ *   pio test -e native -f test_number_format
+ *   PLATFORMIO_BUILD_FLAGS=-DNUMBER_FORMAT_TEST_EXHAUSTIVE pio test -e native -f test_number_format
+ */
+
+#include <unity.h>
+#include "number_format.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// --- Module-Private (Static) Types & Variables ---
+
+#ifdef NUMBER_FORMAT_TEST_EXHAUSTIVE
+static const uint32_t BIT_PATTERN_STRIDE = 1;
+#else
+static const uint32_t BIT_PATTERN_STRIDE = 4099; // Prime, so the low mantissa bits vary as well.
+#endif
+
+// --- Static (Private) Function Implementations ---
+
+static float float_from_bits(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Formats a value both ways at every number of decimals.
+ * @return false (after failing the test) on the first difference.
+ */
+static bool matches_printf(float value) {
+  char expected[64];
+  char actual[32];
+  for (uint8_t decimals = 0; decimals <= NUMBER_FORMAT_MAX_DECIMALS; decimals++) {
+    int expectedLength = snprintf(expected, sizeof(expected), "%.*f", decimals, (double)value);
+    size_t length = number_format_fixed(actual, sizeof(actual), value, decimals);
+    if (length != (size_t)expectedLength || strcmp(actual, expected) != 0) {
+      char message[160];
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      snprintf(message, sizeof(message), "0x%08X at %u decimals: \"%s\" instead of \"%s\"", (unsigned)bits,
+               (unsigned)decimals, actual, expected);
+      TEST_FAIL_MESSAGE(message);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Checks every float from `from` (inclusive) to `to` (exclusive).
+ * A negative `from` checks the same range with both signs.
+ */
+static void check_every_float(float from, float to) {
+  uint32_t first, last;
+  float magnitude = fabsf(from);
+  memcpy(&first, &magnitude, sizeof(first));
+  memcpy(&last, &to, sizeof(last));
+  for (uint32_t bits = first; bits < last; bits++) {
+    if (!matches_printf(float_from_bits(bits))) return;
+    if (from < 0 && !matches_printf(float_from_bits(bits | 0x80000000u))) return;
+  }
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_bit_patterns_match_printf() {
+  uint32_t bits = 0;
+  do {
+    float value = float_from_bits(bits);
+    if (isnan(value) || fabsf(value) < 4294967296.0f) {
+      if (!matches_printf(value)) return;
+    }
+    bits += BIT_PATTERN_STRIDE;
+  } while (bits >= BIT_PATTERN_STRIDE);
+}
+
+void test_small_values_match_printf() {
+  // Around half of the last decimal: ties, and "-0.00" for small negatives.
+  check_every_float(-0.000045f, 0.000055f);
+  check_every_float(-0.0045f, 0.0055f);
+}
+
+void test_sensor_ranges_match_printf() {
+  check_every_float(6.0f, 8.0f);     // pH
+  check_every_float(800.0f, 1000.0f); // TDS
+}
+
+void test_special_values() {
+  char buffer[16];
+  TEST_ASSERT_EQUAL(3, number_format_fixed(buffer, sizeof(buffer), NAN, 2));
+  TEST_ASSERT_EQUAL_STRING("nan", buffer);
+  number_format_fixed(buffer, sizeof(buffer), -NAN, 2);
+  TEST_ASSERT_EQUAL_STRING("-nan", buffer);
+  number_format_fixed(buffer, sizeof(buffer), -INFINITY, 1);
+  TEST_ASSERT_EQUAL_STRING("-inf", buffer);
+  TEST_ASSERT_EQUAL(0, number_format_fixed(buffer, sizeof(buffer), 4294967296.0f, 0));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+}
+
+void test_out_of_range_arguments_leave_an_empty_buffer() {
+  char buffer[8];
+  TEST_ASSERT_EQUAL(0, number_format_fixed(buffer, sizeof(buffer), 1.5f, NUMBER_FORMAT_MAX_DECIMALS + 1));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  TEST_ASSERT_EQUAL(0, number_format_fixed(buffer, 6, -12.25f, 2)); // "-12.25" needs 7 bytes
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  TEST_ASSERT_EQUAL(6, number_format_fixed(buffer, 7, -12.25f, 2));
+  TEST_ASSERT_EQUAL_STRING("-12.25", buffer);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bit_patterns_match_printf);
+  RUN_TEST(test_small_values_match_printf);
+  RUN_TEST(test_sensor_ranges_match_printf);
+  RUN_TEST(test_special_values);
+  RUN_TEST(test_out_of_range_arguments_leave_an_empty_buffer);
+  return UNITY_END();
+}
@@ -0,0 +1,257 @@
+/**
+ * @file test_main.cpp
+ * @brief Firmware update round-trip tests: update files written by
+ * ota/make_update.py must rebuild the new image through ota_patch.cpp, fed in
+ * pieces of any size and emptied from a small window, as the device does.
+ *
+ * The images are synthetic but shaped like an application image: repeated
+ * code patterns, then a new build with an insertion that shifts everything
+ * after it, scattered changed words and a longer tail. The generator needs
+ * `python3` on the PATH; the tests are skipped without it.
+ *   pio test -e native -f test_ota_patch
+ */
+
+#include <unity.h>
+#include "ota_patch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// --- Module-Private (Static) Types & Variables ---
+
+typedef std::vector<uint8_t> Bytes;
+
+static Bytes baseImage;
+static Bytes newImage;
+static Bytes output; ///< What has been emptied from the window so far.
+static std::string workDir;
+static uint32_t rngState = 2024;
+
+// --- Static (Private) Function Implementations ---
+
+/**
+ * @brief xorshift32, so the images are the same on every host.
+ */
+static uint32_t next_random() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+/**
+ * @brief Builds a base image and a changed build of it.
+ */
+static void make_images() {
+  Bytes patterns;
+  for (int i = 0; i < 2048; i++) patterns.push_back((uint8_t)next_random());
+  while (baseImage.size() < 48 * 1024) {
+    // Mostly reused instruction sequences, with a fresh constant now and then.
+    size_t from = next_random() % (patterns.size() - 64);
+    baseImage.insert(baseImage.end(), patterns.begin() + from, patterns.begin() + from + 8 + next_random() % 56);
+    for (int i = next_random() % 8; i > 0; i--) baseImage.push_back((uint8_t)next_random());
+  }
+
+  newImage = baseImage;
+  Bytes inserted(700);
+  for (uint8_t& byte : inserted) byte = (uint8_t)next_random();
+  newImage.insert(newImage.begin() + 10000, inserted.begin(), inserted.end());
+  for (int i = 0; i < 150; i++) {
+    // A moved function changes the addresses that refer to it.
+    size_t at = next_random() % (newImage.size() - 4);
+    uint32_t word = next_random();
+    memcpy(&newImage[at], &word, sizeof(word));
+  }
+  for (int i = 0; i < 3000; i++) newImage.push_back((uint8_t)next_random());
+}
+
+static std::string repo_path(const char* relative) {
+  // This file is test/test_ota_patch/test_main.cpp below the project directory.
+  std::string file = __FILE__;
+  size_t at = file.rfind("test/test_ota_patch/");
+  return file.substr(0, at == std::string::npos ? 0 : at) + relative;
+}
+
+static bool write_file(const std::string& path, const Bytes& bytes) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  return fclose(file) == 0 && ok;
+}
+
+static Bytes read_file(const std::string& path) {
+  Bytes bytes;
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return bytes;
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+  fclose(file);
+  return bytes;
+}
+
+/**
+ * @brief Runs ota/make_update.py with one method.
+ * @return The update file, or an empty one if the generator failed.
+ */
+static Bytes make_update(const char* method) {
+  std::string out = workDir + "/update_" + method + ".bin";
+  std::string command = "python3 \"" + repo_path("ota/make_update.py") + "\" \"" + workDir + "/new.bin\" -o \"" +
+                        out + "\" --base \"" + workDir + "/base.bin\" --method " + method + " > /dev/null";
+  if (system(command.c_str()) != 0) return Bytes();
+  return read_file(out);
+}
+
+static bool read_base(uint32_t offset, uint8_t* out, size_t length) {
+  if (offset + length > baseImage.size()) return false;
+  memcpy(out, &baseImage[offset], length);
+  return true;
+}
+
+static bool read_output(uint32_t offset, uint8_t* out, size_t length) {
+  if (offset + length > output.size()) return false;
+  memcpy(out, &output[offset], length);
+  return true;
+}
+
+/**
+ * @brief Applies an update file, fed in random pieces of at most `maxPiece` bytes.
+ * @return nullptr on success, otherwise the decoder's error.
+ */
+static const char* apply(const Bytes& update, size_t windowSize, size_t maxPiece) {
+  OtaHeader header;
+  TEST_ASSERT_GREATER_OR_EQUAL(OTA_HEADER_SIZE, update.size());
+  const char* error = ota_patch_parse_header(update.data(), header);
+  if (error != nullptr) return error;
+  TEST_ASSERT_EQUAL(update.size() - OTA_HEADER_SIZE, header.payloadSize);
+
+  Bytes window(windowSize);
+  OtaPatcher patcher;
+  ota_patch_init(patcher, header, window.data(), window.size(), read_base, read_output);
+  output.clear();
+  size_t pos = OTA_HEADER_SIZE;
+  while (pos < update.size()) {
+    size_t piece = 1 + next_random() % maxPiece;
+    if (piece > update.size() - pos) piece = update.size() - pos;
+    size_t used = 0;
+    while (used < piece) {
+      used += ota_patch_run(patcher, &update[pos + used], piece - used);
+      if (patcher.error != nullptr) return patcher.error;
+      if (patcher.windowFill == windowSize) {
+        output.insert(output.end(), window.begin(), window.begin() + patcher.windowFill);
+        ota_patch_window_emptied(patcher);
+      } else {
+        TEST_ASSERT_EQUAL(piece, used);
+      }
+    }
+    pos += piece;
+  }
+  if (!ota_patch_done(patcher)) return "update file ends early";
+  output.insert(output.end(), window.begin(), window.begin() + patcher.windowFill);
+  TEST_ASSERT_EQUAL(header.imageCrc, ota_patch_crc32(0, output.data(), output.size()));
+  return nullptr;
+}
+
+static void check_round_trip(const char* method, uint8_t expectedMethod) {
+  Bytes update = make_update(method);
+  if (update.empty()) TEST_IGNORE_MESSAGE("ota/make_update.py could not be run (python3 missing?)");
+  TEST_ASSERT_EQUAL(expectedMethod, update[5]);
+  const size_t windows[] = {4096, 256};
+  const size_t pieces[] = {512, 7, 1};
+  for (size_t windowSize : windows) {
+    for (size_t maxPiece : pieces) {
+      TEST_ASSERT_NULL(apply(update, windowSize, maxPiece));
+      TEST_ASSERT_EQUAL(newImage.size(), output.size());
+      TEST_ASSERT_EQUAL_MEMORY(newImage.data(), output.data(), newImage.size());
+    }
+  }
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_raw_update_round_trips() {
+  check_round_trip("raw", OTA_METHOD_RAW);
+}
+
+void test_lz_update_round_trips() {
+  check_round_trip("lz", OTA_METHOD_LZ);
+}
+
+void test_delta_update_round_trips() {
+  check_round_trip("delta", OTA_METHOD_DELTA);
+  // Only what changed is sent.
+  TEST_ASSERT_LESS_THAN(newImage.size() / 4, make_update("delta").size());
+}
+
+void test_delta_against_another_base_is_rejected() {
+  Bytes update = make_update("delta");
+  if (update.empty()) TEST_IGNORE_MESSAGE("ota/make_update.py could not be run (python3 missing?)");
+  // The device checks the base CRC first; without it, wrong bytes must still not decode cleanly.
+  Bytes realBase = baseImage;
+  baseImage.resize(baseImage.size() / 2);
+  const char* error = apply(update, 4096, 512);
+  baseImage = realBase;
+  TEST_ASSERT_NOT_NULL(error);
+}
+
+void test_corrupt_payloads_fail_without_overrun() {
+  Bytes update = make_update("delta");
+  if (update.empty()) TEST_IGNORE_MESSAGE("ota/make_update.py could not be run (python3 missing?)");
+  // Flipped payload bytes either fail or build a wrong image, never write past the image.
+  for (int i = 0; i < 200; i++) {
+    Bytes corrupt = update;
+    corrupt[OTA_HEADER_SIZE + next_random() % (corrupt.size() - OTA_HEADER_SIZE)] ^= (uint8_t)(1 + next_random() % 255);
+    OtaHeader header;
+    TEST_ASSERT_NULL(ota_patch_parse_header(corrupt.data(), header));
+    Bytes window(256);
+    OtaPatcher patcher;
+    ota_patch_init(patcher, header, window.data(), window.size(), read_base, read_output);
+    output.clear();
+    size_t pos = OTA_HEADER_SIZE;
+    while (pos < corrupt.size() && patcher.error == nullptr) {
+      pos += ota_patch_run(patcher, &corrupt[pos], corrupt.size() - pos);
+      if (patcher.windowFill == window.size()) {
+        output.insert(output.end(), window.begin(), window.end());
+        ota_patch_window_emptied(patcher);
+      }
+      TEST_ASSERT_LESS_OR_EQUAL(header.imageSize, output.size() + patcher.windowFill);
+    }
+  }
+}
+
+void test_corrupt_header_is_rejected() {
+  Bytes update = make_update("lz");
+  if (update.empty()) TEST_IGNORE_MESSAGE("ota/make_update.py could not be run (python3 missing?)");
+  OtaHeader header;
+  for (size_t i = 0; i < OTA_HEADER_SIZE; i++) {
+    Bytes corrupt = update;
+    corrupt[i] ^= 0x10;
+    TEST_ASSERT_NOT_NULL(ota_patch_parse_header(corrupt.data(), header));
+  }
+}
+
+int main(int argc, char** argv) {
+  make_images();
+  char dir[] = "/tmp/hidroiot_ota_XXXXXX";
+  if (mkdtemp(dir) != nullptr) workDir = dir;
+  write_file(workDir + "/base.bin", baseImage);
+  write_file(workDir + "/new.bin", newImage);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_raw_update_round_trips);
+  RUN_TEST(test_lz_update_round_trips);
+  RUN_TEST(test_delta_update_round_trips);
+  RUN_TEST(test_delta_against_another_base_is_rejected);
+  RUN_TEST(test_corrupt_payloads_fail_without_overrun);
+  RUN_TEST(test_corrupt_header_is_rejected);
+  int failures = UNITY_END();
+
+  system(("rm -rf \"" + workDir + "\"").c_str());
+  return failures;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file pump_traces.h
+ * @brief Recorded PZEM traces of pump runs, for validating the pump monitor on the host.
+ *
+ * Each trace holds the samples the firmware took during one run, as
+ * `actuators_handle_power_sample()` saw them: the time since switch-on, the
+ * meter's total power and current, and the reading just before switch-on.
+ * They were taken from a native simulator run with sensor noise, with faults
+ * injected through `sim.fault` (20 ml and 100 ml nutrient doses, 10 ml pH
+ * doses, 15 s of irrigation). A run the firmware aborted ends at the abort.
+ * The expected fault is the injected one, not what the monitor reported.
+ */
+#ifndef PUMP_TRACES_H
+#define PUMP_TRACES_H
+
+#include "pump_monitor.h"
+
+/**
+ * @struct TraceSample
+ * @brief One PZEM reading during a run.
+ */
+struct TraceSample {
+  unsigned long atMs; ///< Time since switch-on.
+  float powerW;       ///< Total power reading.
+  float currentA;     ///< Total current reading.
+};
+
+/**
+ * @struct PumpTrace
+ * @brief One recorded pump run.
+ */
+struct PumpTrace {
+  const char* name;
+  unsigned long plannedMs;  ///< The planned run length.
+  float refPowerW;          ///< The reading just before switch-on.
+  float refCurrentA;
+  float baselineW;          ///< The pump's learned draw on the recording board.
+  PumpFault expected;       ///< The injected fault.
+  const TraceSample* samples;
+  int count;
+};
+
+static const TraceSample TRACE_DOSE_OK[] = {
+  {0, 2.6f, 0.021f}, {235, 6.1f, 0.049f}, {400, 6.1f, 0.049f}
+};
+static const TraceSample TRACE_LONG_DOSE_OK[] = {
+  {0, 2.6f, 0.021f}, {235, 6.1f, 0.050f}, {400, 6.1f, 0.050f}, {635, 6.0f, 0.048f}, {800, 6.0f, 0.048f},
+  {1035, 6.0f, 0.050f}, {1200, 6.0f, 0.050f}, {1435, 6.1f, 0.049f}, {1600, 6.1f, 0.049f}, {1835, 6.1f, 0.048f},
+  {2000, 6.1f, 0.048f}, {2235, 5.8f, 0.050f}, {2400, 5.8f, 0.050f}, {2635, 5.9f, 0.050f}, {2800, 5.9f, 0.050f}
+};
+static const TraceSample TRACE_DOSE_DRY[] = {
+  {0, 2.6f, 0.021f}, {235, 4.3f, 0.034f}, {400, 4.3f, 0.034f}
+};
+static const TraceSample TRACE_LONG_DOSE_DRY[] = {
+  {0, 2.5f, 0.021f}, {235, 4.3f, 0.036f}, {400, 4.3f, 0.036f}, {635, 4.3f, 0.035f}, {800, 4.3f, 0.035f},
+  {1035, 4.2f, 0.035f}, {1200, 4.2f, 0.035f}, {1435, 4.5f, 0.035f}, {1600, 4.5f, 0.035f}, {1835, 4.2f, 0.034f}
+};
+static const TraceSample TRACE_DOSE_BLOCKED[] = {
+  {0, 2.4f, 0.019f}, {235, 8.8f, 0.072f}, {400, 8.8f, 0.072f}
+};
+static const TraceSample TRACE_LONG_DOSE_BLOCKED[] = {
+  {0, 2.5f, 0.020f}, {235, 8.7f, 0.074f}, {400, 8.7f, 0.074f}, {635, 9.0f, 0.073f}, {800, 9.0f, 0.073f},
+  {1035, 8.9f, 0.074f}, {1200, 8.9f, 0.074f}, {1435, 8.8f, 0.073f}, {1600, 8.8f, 0.073f}, {1835, 8.6f, 0.073f}
+};
+static const TraceSample TRACE_DOSE_RELAY[] = {
+  {0, 2.6f, 0.020f}, {235, 2.4f, 0.021f}, {400, 2.4f, 0.021f}
+};
+static const TraceSample TRACE_PH_DOSE_OK[] = {
+  {0, 2.6f, 0.021f}, {235, 6.0f, 0.050f}
+};
+static const TraceSample TRACE_PH_DOSE_DRY[] = {
+  {0, 2.5f, 0.022f}, {235, 4.2f, 0.036f}
+};
+static const TraceSample TRACE_IRRIGATION_OK[] = {
+  {0, 2.4f, 0.021f}, {235, 17.3f, 0.145f}, {400, 17.3f, 0.145f}, {635, 17.6f, 0.145f}, {800, 17.6f, 0.145f},
+  {1035, 17.7f, 0.145f}, {1200, 17.7f, 0.145f}, {1435, 17.5f, 0.145f}, {1600, 17.5f, 0.145f}, {1835, 17.4f, 0.145f},
+  {2000, 17.4f, 0.145f}, {2235, 17.5f, 0.145f}, {2400, 17.5f, 0.145f}, {2635, 17.6f, 0.145f}, {2800, 17.6f, 0.145f},
+  {3035, 17.3f, 0.145f}, {3200, 17.3f, 0.145f}, {3435, 17.5f, 0.144f}, {3600, 17.5f, 0.144f}, {3835, 17.5f, 0.145f},
+  {4000, 17.5f, 0.145f}, {4999, 17.6f, 0.145f}, {5000, 17.6f, 0.145f}, {5235, 17.6f, 0.145f}, {5400, 17.6f, 0.145f},
+  {5635, 17.6f, 0.143f}, {5800, 17.6f, 0.143f}, {6035, 17.4f, 0.145f}, {6200, 17.4f, 0.145f}, {6435, 17.6f, 0.143f},
+  {6600, 17.6f, 0.143f}, {6835, 17.5f, 0.145f}, {7000, 17.5f, 0.145f}, {7235, 17.6f, 0.144f}, {7400, 17.6f, 0.144f},
+  {7635, 17.6f, 0.144f}, {7800, 17.6f, 0.144f}, {8035, 17.4f, 0.145f}, {8200, 17.4f, 0.145f}, {8435, 17.5f, 0.143f},
+  {8600, 17.5f, 0.143f}, {8835, 17.7f, 0.144f}, {9000, 17.7f, 0.144f}, {9999, 17.7f, 0.144f}, {10000, 17.7f, 0.144f},
+  {10235, 17.5f, 0.145f}, {10400, 17.5f, 0.145f}, {10635, 17.6f, 0.145f}, {10800, 17.6f, 0.145f},
+  {11035, 17.5f, 0.145f}, {11200, 17.5f, 0.145f}, {11435, 17.5f, 0.145f}, {11600, 17.5f, 0.145f},
+  {11835, 17.6f, 0.146f}, {12000, 17.6f, 0.146f}, {12235, 17.4f, 0.145f}, {12400, 17.4f, 0.145f},
+  {12635, 17.4f, 0.145f}, {12800, 17.4f, 0.145f}, {13035, 17.5f, 0.146f}, {13200, 17.5f, 0.146f},
+  {13435, 17.3f, 0.145f}, {13600, 17.3f, 0.145f}, {13835, 17.5f, 0.145f}, {14000, 17.5f, 0.145f},
+  {14999, 17.5f, 0.145f}
+};
+static const TraceSample TRACE_IRRIGATION_BLOCKED[] = {
+  {0, 2.5f, 0.020f}, {235, 29.5f, 0.243f}, {400, 29.5f, 0.243f}, {635, 29.6f, 0.244f}, {800, 29.6f, 0.244f},
+  {1035, 29.3f, 0.245f}, {1200, 29.3f, 0.245f}, {1435, 29.6f, 0.245f}, {1600, 29.6f, 0.245f}, {1835, 29.5f, 0.244f}
+};
+static const TraceSample TRACE_IRRIGATION_DRY[] = {
+  {0, 2.3f, 0.020f}, {235, 10.0f, 0.083f}, {400, 10.0f, 0.083f}, {635, 10.0f, 0.082f}, {800, 10.0f, 0.082f},
+  {1035, 10.1f, 0.082f}, {1200, 10.1f, 0.082f}, {1435, 10.0f, 0.081f}, {1600, 10.0f, 0.081f}, {1835, 9.9f, 0.083f}
+};
+
+#define TRACE_ENTRY(samples) samples, (int)(sizeof(samples) / sizeof(samples[0]))
+
+static const PumpTrace PUMP_TRACES[] = {
+  {"dose_ok", 600, 2.6f, 0.021f, 3.5f, PUMP_FAULT_NONE, TRACE_ENTRY(TRACE_DOSE_OK)},
+  {"long_dose_ok", 3000, 2.6f, 0.021f, 3.5f, PUMP_FAULT_NONE, TRACE_ENTRY(TRACE_LONG_DOSE_OK)},
+  {"dose_dry", 600, 2.6f, 0.021f, 3.5f, PUMP_FAULT_DRY_RUN, TRACE_ENTRY(TRACE_DOSE_DRY)},
+  {"long_dose_dry", 3000, 2.5f, 0.021f, 3.5f, PUMP_FAULT_DRY_RUN, TRACE_ENTRY(TRACE_LONG_DOSE_DRY)},
+  {"dose_blocked", 600, 2.4f, 0.019f, 3.5f, PUMP_FAULT_BLOCKED, TRACE_ENTRY(TRACE_DOSE_BLOCKED)},
+  {"long_dose_blocked", 3000, 2.5f, 0.020f, 3.5f, PUMP_FAULT_BLOCKED, TRACE_ENTRY(TRACE_LONG_DOSE_BLOCKED)},
+  {"dose_relay", 600, 2.6f, 0.020f, 3.5f, PUMP_FAULT_RELAY, TRACE_ENTRY(TRACE_DOSE_RELAY)},
+  {"ph_dose_ok", 300, 2.6f, 0.021f, 3.5f, PUMP_FAULT_NONE, TRACE_ENTRY(TRACE_PH_DOSE_OK)},
+  {"ph_dose_dry", 300, 2.5f, 0.022f, 3.5f, PUMP_FAULT_DRY_RUN, TRACE_ENTRY(TRACE_PH_DOSE_DRY)},
+  {"irrigation_ok", 15000, 2.4f, 0.021f, 15.0f, PUMP_FAULT_NONE, TRACE_ENTRY(TRACE_IRRIGATION_OK)},
+  {"irrigation_blocked", 15000, 2.5f, 0.020f, 15.0f, PUMP_FAULT_BLOCKED, TRACE_ENTRY(TRACE_IRRIGATION_BLOCKED)},
+  {"irrigation_dry", 15000, 2.3f, 0.020f, 15.0f, PUMP_FAULT_DRY_RUN, TRACE_ENTRY(TRACE_IRRIGATION_DRY)},
+};
+
+#endif // PUMP_TRACES_H
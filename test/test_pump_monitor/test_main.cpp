@@ -0,0 +1,186 @@
+/**
+ * @file test_main.cpp
+ * @brief Pump monitor tests: recorded PZEM traces replayed through the
+ * detector, and baseline learning in the firmware.
+ *
+ * The trace tests drive pump_monitor.cpp directly, the way
+ * `actuators_handle_power_sample()` does for a lone pump. The learning tests
+ * share one boot of the firmware and run in order on one timeline.
+ *   pio test -e native -f test_pump_monitor
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "pump_monitor.h"
+#include "pump_traces.h"
+#include "sim_mqtt.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+#include <string>
+
+void setup();
+void loop();
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct ReplayResult
+ * @brief How the monitor judged a replayed trace.
+ */
+struct ReplayResult {
+  PumpFault fault;       ///< The run's fault after `pump_monitor_finish()`.
+  long detectedAtMs;     ///< Time since switch-on at which the fault was confirmed, or -1.
+  bool atEnd;            ///< The fault was only found by `pump_monitor_finish()`.
+  bool hasMean;          ///< The run had a steady mean to learn.
+  float meanW;
+};
+
+static const unsigned long SWITCH_ON_MS = 5000;
+
+// --- Static (Private) Function Implementations ---
+
+static PumpMonitorConfig monitor_config() {
+  PumpMonitorConfig cfg;
+  cfg.inrushMs = PUMP_MONITOR_INRUSH_MS;
+  cfg.sampleIntervalMs = PUMP_MONITOR_SAMPLE_INTERVAL_MS;
+  cfg.dryRunRatio = PUMP_DRY_RUN_RATIO;
+  cfg.blockedRatio = PUMP_BLOCKED_RATIO;
+  cfg.relayMinDeltaW = PUMP_RELAY_MIN_DELTA_W;
+  cfg.confirmSamples = PUMP_FAULT_CONFIRM_SAMPLES;
+  return cfg;
+}
+
+/**
+ * @brief Replays a trace through the monitor; the pump ran alone, so its share is reading minus reference.
+ */
+static ReplayResult replay(const PumpTrace& trace, float baselineW) {
+  const PumpMonitorConfig cfg = monitor_config();
+  PumpRunMonitor run;
+  pump_monitor_start(run, cfg, SWITCH_ON_MS, trace.plannedMs, trace.refPowerW, trace.refCurrentA);
+  ReplayResult result = {PUMP_FAULT_NONE, -1, false, false, NAN};
+  for (int i = 0; i < trace.count && result.fault == PUMP_FAULT_NONE; i++) {
+    const TraceSample& sample = trace.samples[i];
+    result.fault = pump_monitor_sample(run, cfg, baselineW, sample.powerW - trace.refPowerW,
+                                       sample.currentA - trace.refCurrentA, true, SWITCH_ON_MS + sample.atMs);
+    if (result.fault != PUMP_FAULT_NONE) result.detectedAtMs = sample.atMs;
+  }
+  if (result.fault == PUMP_FAULT_NONE) {
+    result.fault = pump_monitor_finish(run, cfg, baselineW);
+    result.atEnd = result.fault != PUMP_FAULT_NONE;
+  }
+  float meanA;
+  result.hasMean = pump_monitor_steady_mean(run, result.meanW, meanA);
+  return result;
+}
+
+/**
+ * @brief Runs the firmware until a virtual time, one loop() per millisecond.
+ */
+static void run_until(double seconds) {
+  while (sim_now_us() < (uint64_t)(seconds * 1e6)) {
+    sim_scenario_step();
+    loop();
+    sim_advance_us(1000);
+  }
+}
+
+/**
+ * @brief Returns the retained power profile, or an empty string.
+ */
+static std::string power_profile() {
+  const std::string* payload = sim_mqtt_last(STATE_TOPIC_PUMP_POWER.c_str());
+  return payload ? *payload : std::string();
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_traces_are_classified_as_recorded() {
+  for (const PumpTrace& trace : PUMP_TRACES) {
+    ReplayResult result = replay(trace, trace.baselineW);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(pump_fault_name(trace.expected), pump_fault_name(result.fault), trace.name);
+  }
+}
+
+void test_long_runs_are_stopped_before_their_end() {
+  for (const PumpTrace& trace : PUMP_TRACES) {
+    if (trace.expected == PUMP_FAULT_NONE || trace.plannedMs < 2 * PUMP_MONITOR_INRUSH_MS) continue;
+    ReplayResult result = replay(trace, trace.baselineW);
+    TEST_ASSERT_FALSE_MESSAGE(result.atEnd, trace.name);
+    TEST_ASSERT_LESS_THAN_MESSAGE((long)trace.plannedMs, result.detectedAtMs, trace.name);
+  }
+}
+
+void test_short_doses_are_judged_at_their_end() {
+  for (const PumpTrace& trace : PUMP_TRACES) {
+    if (trace.expected == PUMP_FAULT_NONE || trace.plannedMs >= 2 * PUMP_MONITOR_INRUSH_MS) continue;
+    ReplayResult result = replay(trace, trace.baselineW);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(pump_fault_name(trace.expected), pump_fault_name(result.fault), trace.name);
+  }
+}
+
+void test_unlearned_pump_only_reports_a_dead_relay() {
+  for (const PumpTrace& trace : PUMP_TRACES) {
+    ReplayResult result = replay(trace, NAN);
+    PumpFault expected = trace.expected == PUMP_FAULT_RELAY ? PUMP_FAULT_RELAY : PUMP_FAULT_NONE;
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(pump_fault_name(expected), pump_fault_name(result.fault), trace.name);
+  }
+}
+
+void test_normal_runs_learn_their_baseline() {
+  for (const PumpTrace& trace : PUMP_TRACES) {
+    if (trace.expected != PUMP_FAULT_NONE) continue;
+    ReplayResult result = replay(trace, trace.baselineW);
+    TEST_ASSERT_TRUE_MESSAGE(result.hasMean, trace.name);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.2f * trace.baselineW, trace.baselineW, result.meanW, trace.name);
+  }
+}
+
+void test_dry_first_run_is_not_learned() {
+  // Nutrient A's rated 6 W stays the baseline; a dry pump's ~2 W is below PUMP_DRAW_MIN_RATIO of it.
+  sim_scenario_add("1.3s ~/automasi/dosing/kontrol OFF");
+  sim_scenario_add("10.3s sim.fault nutrisi_a dry");
+  sim_scenario_add("10.3s ~/pompa/antrian/kontrol nutrisi_a:100ml");
+  run_until(20);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, power_profile().find("\"nutrisi_a\":{\"w\":6.0,"));
+}
+
+void test_normal_run_replaces_the_rated_draw() {
+  sim_scenario_add("20.3s sim.fault nutrisi_a ok");
+  sim_scenario_add("25.3s ~/pompa/antrian/kontrol nutrisi_a:100ml");
+  run_until(35);
+  TEST_ASSERT_EQUAL(std::string::npos, power_profile().find("\"nutrisi_a\":{\"w\":6.0,"));
+}
+
+void test_dry_short_dose_is_reported_when_it_ends() {
+  sim_scenario_add("40.3s sim.fault nutrisi_a dry");
+  sim_scenario_add("45.3s ~/pompa/antrian/kontrol nutrisi_a:20ml:5,nutrisi_a:20ml");
+  uint32_t runsBefore = sim_mqtt_count(STATE_TOPIC_PUMP_MONITOR.c_str());
+  run_until(70);
+  const std::string* alert = sim_mqtt_last(MQTT_GLOBAL_ALERT_TOPIC.c_str());
+  TEST_ASSERT_NOT_NULL(alert);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, alert->find("dry_run"));
+  // The second dose of the sequence was dropped with the fault.
+  TEST_ASSERT_EQUAL(runsBefore + 1, sim_mqtt_count(STATE_TOPIC_PUMP_MONITOR.c_str()));
+}
+
+int main(int argc, char** argv) {
+  sim_plant_init(sim_plant_default_params(), 1);
+  randomSeed(1);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_traces_are_classified_as_recorded);
+  RUN_TEST(test_long_runs_are_stopped_before_their_end);
+  RUN_TEST(test_short_doses_are_judged_at_their_end);
+  RUN_TEST(test_unlearned_pump_only_reports_a_dead_relay);
+  RUN_TEST(test_normal_runs_learn_their_baseline);
+  RUN_TEST(test_dry_first_run_is_not_learned);
+  RUN_TEST(test_normal_run_replaces_the_rated_draw);
+  RUN_TEST(test_dry_short_dose_is_reported_when_it_ends);
+  return UNITY_END();
+}
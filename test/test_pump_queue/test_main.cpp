@@ -0,0 +1,109 @@
+/**
+ * @file test_main.cpp
+ * @brief Pump job queue regression tests: settle delays between sequence steps,
+ * also while other pumps run and finish in between, and cancelling waiting jobs.
+ *
+ * The firmware's static state cannot be reset within one process, so the tests
+ * share one boot and run in order on one timeline.
+ *   pio test -e native -f test_pump_queue
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "config.h"
+#include "sim_plant.h"
+#include "sim_scenario.h"
+#include "sim_time.h"
+
+void setup();
+void loop();
+
+// --- Module-Private (Static) Types & Variables ---
+
+/**
+ * @struct RelayTimes
+ * @brief When a relay was last switched on and off, in virtual milliseconds.
+ */
+struct RelayTimes {
+  uint8_t pin;
+  bool on;
+  uint64_t onMs;
+  uint64_t offMs;
+};
+
+static RelayTimes relayA = {PUMP_NUTRISI_A_PIN, false, 0, 0};
+static RelayTimes relayB = {PUMP_NUTRISI_B_PIN, false, 0, 0};
+
+/**
+ * @brief Notes the switching times of a relay.
+ */
+static void watch(RelayTimes& relay) {
+  bool on = digitalRead(relay.pin) == HIGH;
+  if (on && !relay.on) relay.onMs = sim_now_us() / 1000;
+  if (!on && relay.on) relay.offMs = sim_now_us() / 1000;
+  relay.on = on;
+}
+
+/**
+ * @brief Runs the firmware until a virtual time, one loop() per millisecond.
+ */
+static void run_until(double seconds) {
+  while (sim_now_us() < (uint64_t)(seconds * 1e6)) {
+    sim_scenario_step();
+    loop();
+    watch(relayA);
+    watch(relayB);
+    sim_advance_us(1000);
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sequence_waits_for_the_settle_delay() {
+  sim_scenario_add("10s ~/pompa/antrian/kontrol nutrisi_a:5:60,nutrisi_b:5");
+  run_until(100);
+  TEST_ASSERT_GREATER_THAN(0, relayA.offMs);
+  TEST_ASSERT_GREATER_OR_EQUAL(relayA.offMs + 60000, relayB.onMs);
+  TEST_ASSERT_LESS_THAN(relayA.offMs + 61000, relayB.onMs);
+}
+
+void test_overlapping_run_keeps_the_settle_delay() {
+  // The irrigation started first and ends, without a settle of its own, while
+  // nutrient A settles; B must still wait the full 60 s after A.
+  sim_scenario_add("110s ~/pompa/penyiraman/kontrol 30");
+  sim_scenario_add("111s ~/pompa/antrian/kontrol nutrisi_a:5:60,nutrisi_b:5");
+  run_until(200);
+  TEST_ASSERT_GREATER_OR_EQUAL(111000, relayA.onMs);
+  TEST_ASSERT_LESS_THAN(140000, relayA.offMs);
+  TEST_ASSERT_GREATER_OR_EQUAL(relayA.offMs + 60000, relayB.onMs);
+}
+
+void test_only_an_exact_cancel_drops_waiting_jobs() {
+  // Neither may be read as a bare "CANCEL", which would drop every waiting job.
+  sim_scenario_add("210s ~/pompa/antrian/kontrol nutrisi_a:5:60,nutrisi_b:5");
+  sim_scenario_add("220s ~/pompa/antrian/kontrol CANCELLED");
+  sim_scenario_add("221s ~/pompa/antrian/kontrol CANCEL job7");
+  run_until(300);
+  TEST_ASSERT_GREATER_OR_EQUAL(210000, relayA.onMs);
+  TEST_ASSERT_GREATER_OR_EQUAL(relayA.offMs + 60000, relayB.onMs);
+
+  uint64_t lastB = relayB.onMs;
+  sim_scenario_add("310s ~/pompa/antrian/kontrol nutrisi_a:5:60,nutrisi_b:5");
+  sim_scenario_add("320s ~/pompa/antrian/kontrol CANCEL");
+  run_until(400);
+  TEST_ASSERT_GREATER_OR_EQUAL(310000, relayA.onMs);
+  TEST_ASSERT_TRUE(relayB.onMs == lastB);
+}
+
+int main(int argc, char** argv) {
+  sim_plant_init(sim_plant_default_params(), 1);
+  randomSeed(1);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sequence_waits_for_the_settle_delay);
+  RUN_TEST(test_overlapping_run_keeps_the_settle_delay);
+  RUN_TEST(test_only_an_exact_cancel_drops_waiting_jobs);
+  return UNITY_END();
+}
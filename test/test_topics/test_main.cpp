@@ -0,0 +1,79 @@
+/**
+ * @file test_main.cpp
+ * @brief Topic layout test: the client ID, base topic and every MQTT topic
+ * resolved at boot for a provisioned greenhouse must match, byte for byte and
+ * in order, lib/hidroiot_sim/topics_greenhouse_a.txt.
+ *
+ * That file holds the layout the one-build-per-greenhouse firmware compiled
+ * in, plus the topics added since. A new topic is a new line there, so that
+ * a change to an existing one shows up here first.
+ *   pio test -e native -f test_topics
+ */
+
+#include <unity.h>
+#include "config.h"
+#include "identity.h"
+#include "sim_board.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// --- Static (Private) Function Implementations ---
+
+static std::string repo_path(const char* relative) {
+  // This file is test/test_topics/test_main.cpp below the project directory.
+  std::string file = __FILE__;
+  size_t at = file.rfind("test/test_topics/");
+  return file.substr(0, at == std::string::npos ? 0 : at) + relative;
+}
+
+/**
+ * @brief Reads a text file into lines, without the line breaks.
+ */
+static std::vector<std::string> read_lines(const std::string& path) {
+  std::vector<std::string> lines;
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == nullptr) return lines;
+  char line[256];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    std::string text = line;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    lines.push_back(text);
+  }
+  fclose(file);
+  return lines;
+}
+
+// --- Tests ---
+
+void setUp() {}
+void tearDown() {}
+
+void test_resolved_layout_matches_the_reference() {
+  std::vector<std::string> expected = read_lines(repo_path("lib/hidroiot_sim/topics_greenhouse_a.txt"));
+  TEST_ASSERT_GREATER_THAN_MESSAGE(2, expected.size(), "topics_greenhouse_a.txt is missing or empty");
+
+  std::vector<std::string> actual;
+  actual.push_back(MQTT_CLIENT_ID);
+  actual.push_back(BASE_TOPIC);
+  for (const MqttTopic* topic = MqttTopic::first(); topic != nullptr; topic = topic->next()) {
+    actual.push_back(topic->c_str());
+  }
+
+  for (size_t i = 0; i < expected.size() && i < actual.size(); i++) {
+    char message[32];
+    snprintf(message, sizeof(message), "line %u", (unsigned)(i + 1));
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected[i].c_str(), actual[i].c_str(), message);
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(expected.size(), actual.size(), "number of lines");
+}
+
+int main(int argc, char** argv) {
+  // As `program --provision instance=greenhouse_a --topics` does.
+  sim_board_provision(IDENTITY_NAMESPACE, "instance", "greenhouse_a");
+  identity_init();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_resolved_layout_matches_the_reference);
+  return UNITY_END();
+}